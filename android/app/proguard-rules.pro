@@ -27,6 +27,9 @@
 # Keep VPN service classes
 -keep class com.tunnelmax.vpnclient.vpn.** { *; }
 
+# Keep the listener interface the native notifier resolves in JNI_OnLoad
+-keep interface com.tunnelmax.vpnclient.NativeEventListener { *; }
+
 # Keep platform channel classes
 -keep class com.tunnelmax.vpnclient.platform.** { *; }
 
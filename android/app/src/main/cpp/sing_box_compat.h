@@ -0,0 +1,56 @@
+#ifndef SING_BOX_COMPAT_H
+#define SING_BOX_COMPAT_H
+
+/*
+ * Platform shim for the native layer.
+ *
+ * On Android this simply pulls in the logcat API. On other hosts (Linux
+ * builds used for tests, benchmarks and the offline tools) logcat calls are
+ * routed to stderr so the same sources compile unchanged.
+ */
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#else
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+};
+
+/* Host builds stay quiet below WARN unless SING_BOX_HOST_VERBOSE is defined */
+static inline int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+#ifndef SING_BOX_HOST_VERBOSE
+    if (prio < ANDROID_LOG_WARN) {
+        return 0;
+    }
+#endif
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: ", tag);
+    int written = vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    return written;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ANDROID__
+
+#endif // SING_BOX_COMPAT_H
@@ -0,0 +1,358 @@
+#include "sing_box_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sing_box_simd.h"
+
+typedef struct {
+    const unsigned char* data;
+    size_t length;
+    size_t pos;
+    int flags;
+    const char* message;
+} validator_t;
+
+static int fail(validator_t* v, const char* message) {
+    v->message = message;
+    return 0;
+}
+
+static void skip_whitespace(validator_t* v) {
+    while (v->pos < v->length) {
+        unsigned char c = v->data[v->pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            return;
+        }
+        v->pos++;
+    }
+}
+
+static int hex_value(unsigned char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Validate one multi-byte UTF-8 sequence at v->pos and step over it
+ */
+static int utf8_sequence(validator_t* v) {
+    const unsigned char* p = v->data + v->pos;
+    size_t left = v->length - v->pos;
+    unsigned char c = p[0];
+    size_t need;
+    unsigned char low = 0x80, high = 0xBF; // Range of the second byte
+    
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 1;
+    } else if (c == 0xC0 && (v->flags & SINGBOX_CONFIG_MODIFIED_UTF8)) {
+        need = 1;
+        low = high = 0x80; // Only the encoded NUL
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 2;
+        if (c == 0xE0) {
+            low = 0xA0; // Overlong
+        } else if (c == 0xED && !(v->flags & SINGBOX_CONFIG_MODIFIED_UTF8)) {
+            high = 0x9F; // Surrogates
+        }
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 3;
+        if (c == 0xF0) {
+            low = 0x90; // Overlong
+        } else if (c == 0xF4) {
+            high = 0x8F; // Above U+10FFFF
+        }
+    } else {
+        return fail(v, "invalid UTF-8 lead byte");
+    }
+    
+    if (left <= need) {
+        return fail(v, "truncated UTF-8 sequence");
+    }
+    if (p[1] < low || p[1] > high) {
+        return fail(v, "invalid UTF-8 sequence");
+    }
+    for (size_t i = 2; i <= need; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return fail(v, "invalid UTF-8 sequence");
+        }
+    }
+    v->pos += need + 1;
+    return 1;
+}
+
+/**
+ * Validate a string starting at its opening quote
+ */
+static int string(validator_t* v) {
+    v->pos++; // Opening quote
+    for (;;) {
+        v->pos += singbox_json_plain_span((const char*)v->data + v->pos, v->length - v->pos);
+        if (v->pos >= v->length) {
+            return fail(v, "unterminated string");
+        }
+        
+        unsigned char c = v->data[v->pos];
+        if (c == '"') {
+            v->pos++;
+            return 1;
+        }
+        if (c >= 0x80) {
+            if (!utf8_sequence(v)) {
+                return 0;
+            }
+            continue;
+        }
+        if (c < 0x20) {
+            return fail(v, "control character in string");
+        }
+        
+        // Escape
+        if (v->pos + 1 >= v->length) {
+            return fail(v, "unterminated string");
+        }
+        switch (v->data[v->pos + 1]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                v->pos += 2;
+                break;
+            case 'u':
+                if (v->length - v->pos < 6) {
+                    return fail(v, "truncated \\u escape");
+                }
+                for (size_t i = 2; i < 6; i++) {
+                    if (hex_value(v->data[v->pos + i]) < 0) {
+                        v->pos += i;
+                        return fail(v, "invalid \\u escape");
+                    }
+                }
+                v->pos += 6;
+                break;
+            default:
+                v->pos++;
+                return fail(v, "invalid escape");
+        }
+    }
+}
+
+static int digits(validator_t* v) {
+    size_t start = v->pos;
+    while (v->pos < v->length && v->data[v->pos] >= '0' && v->data[v->pos] <= '9') {
+        v->pos++;
+    }
+    return v->pos > start;
+}
+
+static int number(validator_t* v) {
+    if (v->data[v->pos] == '-') {
+        v->pos++;
+    }
+    if (v->pos < v->length && v->data[v->pos] == '0') {
+        v->pos++;
+    } else if (!digits(v)) {
+        return fail(v, "invalid number");
+    }
+    if (v->pos < v->length && v->data[v->pos] == '.') {
+        v->pos++;
+        if (!digits(v)) {
+            return fail(v, "invalid number");
+        }
+    }
+    if (v->pos < v->length && (v->data[v->pos] == 'e' || v->data[v->pos] == 'E')) {
+        v->pos++;
+        if (v->pos < v->length && (v->data[v->pos] == '+' || v->data[v->pos] == '-')) {
+            v->pos++;
+        }
+        if (!digits(v)) {
+            return fail(v, "invalid number");
+        }
+    }
+    return 1;
+}
+
+static int literal(validator_t* v, const char* word, size_t length) {
+    if (v->length - v->pos < length || memcmp(v->data + v->pos, word, length) != 0) {
+        return fail(v, "invalid literal");
+    }
+    v->pos += length;
+    return 1;
+}
+
+/*
+ * Iterative so that nesting depth costs one bit of stack per level, not a
+ * call frame: containers[] holds 1 for objects and 0 for arrays.
+ */
+static int document(validator_t* v) {
+    uint8_t containers[SINGBOX_CONFIG_MAX_DEPTH / 8];
+    int depth = 0;
+    
+    skip_whitespace(v);
+    if (v->pos >= v->length || v->data[v->pos] != '{') {
+        return fail(v, "config must be a JSON object");
+    }
+    
+    for (;;) {
+        // A value is expected at v->pos
+        skip_whitespace(v);
+        if (v->pos >= v->length) {
+            return fail(v, "unexpected end of input");
+        }
+        unsigned char c = v->data[v->pos];
+        if (c == '{' || c == '[') {
+            if (depth == SINGBOX_CONFIG_MAX_DEPTH) {
+                return fail(v, "nesting too deep");
+            }
+            int object = c == '{';
+            if (object) {
+                containers[depth / 8] |= (uint8_t)(1u << (depth % 8));
+            } else {
+                containers[depth / 8] &= (uint8_t)~(1u << (depth % 8));
+            }
+            depth++;
+            v->pos++;
+            skip_whitespace(v);
+            if (v->pos < v->length && v->data[v->pos] == (object ? '}' : ']')) {
+                v->pos++;
+                depth--;
+            } else if (object) {
+                goto member;
+            } else {
+                continue;
+            }
+        } else if (c == '"') {
+            if (!string(v)) {
+                return 0;
+            }
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!number(v)) {
+                return 0;
+            }
+        } else if (c == 't') {
+            if (!literal(v, "true", 4)) {
+                return 0;
+            }
+        } else if (c == 'f') {
+            if (!literal(v, "false", 5)) {
+                return 0;
+            }
+        } else if (c == 'n') {
+            if (!literal(v, "null", 4)) {
+                return 0;
+            }
+        } else {
+            return fail(v, "unexpected character");
+        }
+        
+        // After a value: close containers or move to the next element
+        for (;;) {
+            if (depth == 0) {
+                skip_whitespace(v);
+                return v->pos == v->length ? 1 : fail(v, "trailing data after config");
+            }
+            int object = (containers[(depth - 1) / 8] >> ((depth - 1) % 8)) & 1;
+            skip_whitespace(v);
+            if (v->pos >= v->length) {
+                return fail(v, "unexpected end of input");
+            }
+            c = v->data[v->pos];
+            if (c == (object ? '}' : ']')) {
+                v->pos++;
+                depth--;
+                continue;
+            }
+            if (c != ',') {
+                return fail(v, object ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+            v->pos++;
+            if (!object) {
+                break; // Next array element
+            }
+            skip_whitespace(v);
+            goto member;
+        }
+        continue;
+        
+    member:
+        // Object member: "key" ':' then its value
+        if (v->pos >= v->length || v->data[v->pos] != '"') {
+            return fail(v, "expected member name");
+        }
+        if (!string(v)) {
+            return 0;
+        }
+        skip_whitespace(v);
+        if (v->pos >= v->length || v->data[v->pos] != ':') {
+            return fail(v, "expected ':'");
+        }
+        v->pos++;
+    }
+}
+
+int singbox_config_validate(const char* data, size_t length, int flags, singbox_config_error_t* error) {
+    validator_t v = { (const unsigned char*)data, data ? length : 0, 0, flags, NULL };
+    // A leading byte order mark is tolerated
+    if (v.length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        v.pos = 3;
+    }
+    if (document(&v)) {
+        return 1;
+    }
+    
+    if (error) {
+        size_t offset = v.pos < v.length ? v.pos : v.length;
+        error->offset = offset;
+        error->message = v.message;
+        error->line = 1;
+        error->column = 1;
+        // Only paid on failure
+        for (size_t i = 0; i < offset; i++) {
+            if (v.data[i] == '\n') {
+                error->line++;
+                error->column = 1;
+            } else {
+                error->column++;
+            }
+        }
+    }
+    return 0;
+}
+
+int singbox_config_write_file(const char* path, const char* data, size_t length) {
+    char temp_path[PATH_MAX];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) {
+        return ENAMETOOLONG;
+    }
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return errno;
+    }
+    
+    int error = 0;
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, data + written, length - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error = n < 0 ? errno : EIO;
+            break;
+        }
+        written += (size_t)n;
+    }
+    if (close(fd) != 0 && error == 0) {
+        error = errno;
+    }
+    if (error == 0 && rename(temp_path, path) != 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        unlink(temp_path);
+    }
+    return error;
+}
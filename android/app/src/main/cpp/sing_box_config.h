@@ -0,0 +1,52 @@
+#ifndef SING_BOX_CONFIG_H
+#define SING_BOX_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-place checks and persistence for sing-box configurations.
+ *
+ * Configurations arrive as UTF-8 JSON, either in a direct ByteBuffer or as
+ * a JNI string. They are validated where they lie, without a parse tree or
+ * a copy, and written to the config file straight from the caller's memory.
+ */
+
+#define SINGBOX_CONFIG_MAX_DEPTH 512
+
+/**
+ * Also accept the modified UTF-8 produced by GetStringUTFChars: surrogates
+ * encoded one by one, and NUL as C0 80
+ */
+#define SINGBOX_CONFIG_MODIFIED_UTF8 0x1
+
+typedef struct {
+    size_t offset;          // Byte offset of the problem
+    uint32_t line;          // 1-based
+    uint32_t column;        // 1-based, in bytes
+    const char* message;    // Static string
+} singbox_config_error_t;
+
+/**
+ * Check that `data` is a single well-formed JSON object in valid UTF-8
+ * @param error Filled on failure; may be NULL
+ * @return 1 if valid
+ */
+int singbox_config_validate(const char* data, size_t length, int flags, singbox_config_error_t* error);
+
+/**
+ * Replace the file at `path` with `data`: written to a temporary file next
+ * to it and renamed over it, so a reader never sees a partial config
+ * @return 0 on success or an errno value
+ */
+int singbox_config_write_file(const char* path, const char* data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_CONFIG_H
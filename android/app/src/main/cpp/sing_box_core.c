@@ -0,0 +1,1244 @@
+#include "sing_box_core.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sing_box_compat.h"
+#include "sing_box_config.h"
+#include "sing_box_errcat.h"
+#include "sing_box_libbox.h"
+#include "sing_box_linkstats.h"
+#include "sing_box_logging.h"
+#include "sing_box_logparse.h"
+#include "sing_box_notify.h"
+#include "sing_box_procstat.h"
+#include "sing_box_spawn.h"
+#include "sing_box_statsmem.h"
+#include "sing_box_uidstats.h"
+
+#define TAG "SingBoxCore"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+
+#define STOP_POLL_MS 50
+#define APP_USAGE_MAX_APPS 64
+
+// Lifecycle: written under lifecycle_mutex, read anywhere through atomics
+static pthread_mutex_t lifecycle_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int core_initialized = 0;
+static int core_state = SINGBOX_CORE_STOPPED;
+static pid_t singbox_pid = 0;
+
+// Only touched under lifecycle_mutex
+static singbox_core_options_t core_options;
+static singbox_libbox_t* embedded_lib = NULL;
+
+// Set while an embedded instance runs; read anywhere
+static int embedded_active = 0;
+
+// Latest library counters and the values they count from after a reset
+static pthread_mutex_t embedded_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static singbox_libbox_stats_t embedded_stats_last;
+static singbox_libbox_stats_t embedded_stats_base;
+
+// sing-box stdout/stderr capture, parsed into typed events
+static pthread_t output_thread;
+static int output_thread_started = 0;
+static singbox_log_event_counters_t event_counters;
+
+// Error lines classified by the signature automaton
+static uint64_t error_category_counts[SINGBOX_ERRCAT_COUNT];
+static int last_error_category = SINGBOX_ERRCAT_UNKNOWN;
+static int last_error_severity = SINGBOX_ERRSEV_INFO;
+static int last_error_recoverable = 1;
+
+// Traffic counters: TUN interface counters when the descriptor is a TUN
+// device, otherwise simulated; updated with atomics only
+static int64_t stats_total_upload = 0;
+static int64_t stats_total_download = 0;
+static int64_t stats_last_update = 0;
+static int64_t stats_started_at = 0;
+static uint32_t stats_random_state = 0x2545f491u;
+static int64_t stats_upload_speed = 0;
+static int64_t stats_download_speed = 0;
+static int64_t stats_packets_sent = -1;      // -1: approximated from the byte counts
+static int64_t stats_packets_received = -1;
+
+// Published copy of the counters, read by Kotlin through a direct ByteBuffer.
+// Readers never lock; stats_publish_mutex only orders concurrent publishers.
+static singbox_stats_shared_t stats_region;
+static pthread_once_t stats_region_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t stats_publish_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Keeps stats_region current while sing-box runs
+static pthread_t publisher_thread;
+static int publisher_started = 0;
+static int publisher_stop = 0;
+static pthread_mutex_t publisher_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t publisher_cond = PTHREAD_COND_INITIALIZER;
+
+// Kernel counters of the TUN interface, counted from tun_counters_base
+static pthread_mutex_t tun_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static singbox_linkstats_t* tun_stats = NULL;
+static singbox_link_counters_t tun_counters_base;
+static singbox_link_counters_t tun_counters_last;
+// The named tun_interface has not appeared yet; looked up on every refresh
+static int tun_stats_pending = 0;
+
+// /proc accounting of the sing-box process (this process when embedded);
+// sampled on every publisher tick and on demand
+static pthread_mutex_t procstat_mutex = PTHREAD_MUTEX_INITIALIZER;
+static singbox_procstat_t* process_sampler = NULL;
+
+// Tunnel traffic per application UID, refreshed on every publisher tick;
+// the core's inbound connection events are credited to their owners
+static pthread_mutex_t app_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static singbox_uidstats_t* app_stats = NULL;
+
+void singbox_core_default_options(singbox_core_options_t* options) {
+    memset(options, 0, sizeof(*options));
+    options->config_path = "/data/data/com.tunnelmax.vpnclient/cache/singbox_config.json";
+    options->log_file_path = "/data/data/com.tunnelmax.vpnclient/files/singbox_native.slog";
+    // The sing-box binary should be extracted from the .so file or available in the app
+    options->binaries[0] = "/system/bin/sing-box";
+    options->binaries[1] = "/data/data/com.tunnelmax.vpnclient/files/sing-box";
+    options->start_grace_ms = 500;
+    options->stop_timeout_ms = 5000;
+    options->stats_interval_ms = 1000;
+}
+
+const char* singbox_core_state_name(singbox_core_state_t state) {
+    switch (state) {
+        case SINGBOX_CORE_STOPPED: return "stopped";
+        case SINGBOX_CORE_STARTING: return "starting";
+        case SINGBOX_CORE_RUNNING: return "running";
+        case SINGBOX_CORE_STOPPING: return "stopping";
+    }
+    return "unknown";
+}
+
+static void publish_stats(void);
+
+static void set_state(singbox_core_state_t state) {
+    __atomic_store_n(&core_state, (int)state, __ATOMIC_RELEASE);
+    publish_stats();
+    singbox_notify_post_state((int)state);
+}
+
+singbox_core_state_t singbox_core_state(void) {
+    return (singbox_core_state_t)__atomic_load_n(&core_state, __ATOMIC_ACQUIRE);
+}
+
+int singbox_core_is_initialized(void) {
+    return __atomic_load_n(&core_initialized, __ATOMIC_ACQUIRE);
+}
+
+static void sleep_ms(uint32_t ms) {
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static void classify_core_error(const char* message, size_t length) {
+    singbox_error_class_t result;
+    singbox_errcat_classify(singbox_errcat_default(), message, length, &result);
+    __atomic_fetch_add(&error_category_counts[result.category], 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&last_error_severity, (int)result.severity, __ATOMIC_RELAXED);
+    __atomic_store_n(&last_error_recoverable, result.recoverable, __ATOMIC_RELAXED);
+    __atomic_store_n(&last_error_category, (int)result.category, __ATOMIC_RELEASE);
+}
+
+static void on_core_event(const singbox_log_event_t* event, const char* line, void* ctx) {
+    (void)ctx;
+    singbox_log_event_account(&event_counters, event);
+    if (event->level >= SINGBOX_LOG_ERROR) {
+        classify_core_error(line + event->message.offset, event->message.length);
+    }
+    if (event->type == SINGBOX_EVENT_INBOUND_CONNECTION && event->address.length) {
+        pthread_mutex_lock(&app_stats_mutex);
+        if (app_stats) {
+            singbox_uidstats_note_connection(app_stats, event->network, line + event->address.offset,
+                                             event->address.length);
+        }
+        pthread_mutex_unlock(&app_stats_mutex);
+    }
+    
+    char module[SINGBOX_LOGFILE_MAX_MODULE + 1];
+    size_t module_len = event->module.length < SINGBOX_LOGFILE_MAX_MODULE
+        ? event->module.length : SINGBOX_LOGFILE_MAX_MODULE;
+    memcpy(module, line + event->module.offset, module_len);
+    module[module_len] = '\0';
+    
+    singbox_log_write(event->level, module, line + event->message.offset, event->message.length);
+}
+
+static void* output_reader_thread(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    singbox_logparse_stream_t* stream = calloc(1, sizeof(*stream));
+    char buffer[16384];
+    
+    while (stream) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break; // EOF once sing-box exits
+        }
+        singbox_logparse_feed(stream, buffer, (size_t)n, on_core_event, NULL);
+    }
+    
+    if (stream) {
+        singbox_logparse_flush(stream, on_core_event, NULL);
+        LOGI("sing-box output closed after %llu lines", (unsigned long long)stream->lines);
+        free(stream);
+    }
+    close(fd);
+    return NULL;
+}
+
+static void join_output_reader(void) {
+    if (output_thread_started) {
+        pthread_join(output_thread, NULL);
+        output_thread_started = 0;
+        // Summarise bursts cut short by the exit
+        singbox_logging_flush_throttle(1);
+    }
+}
+
+static void stop_publisher(void);
+static void release_monitors(void);
+
+/**
+ * Whether the child is alive, without reaping it (safe from any thread)
+ */
+static int child_alive(pid_t pid) {
+    if (pid <= 0) {
+        return 0;
+    }
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    if (waitid(P_PID, (id_t)pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0) {
+        return errno == EINTR; // ECHILD: already reaped
+    }
+    return info.si_pid == 0;
+}
+
+/**
+ * Reap a child that exited on its own; lifecycle lock held
+ */
+static void reap_exited_locked(void) {
+    pid_t pid = __atomic_load_n(&singbox_pid, __ATOMIC_ACQUIRE);
+    if (pid <= 0) {
+        return;
+    }
+    int status;
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result == pid || (result < 0 && errno == ECHILD)) {
+        LOGI("Sing-box process has exited");
+        __atomic_store_n(&singbox_pid, 0, __ATOMIC_RELEASE);
+        set_state(SINGBOX_CORE_STOPPED);
+        stop_publisher();
+        release_monitors();
+        join_output_reader();
+    }
+}
+
+static char* copy_string(const char* text) {
+    return text ? strdup(text) : NULL;
+}
+
+static void free_options(singbox_core_options_t* options) {
+    free((char*)options->config_path);
+    free((char*)options->log_file_path);
+    free((char*)options->embedded_library);
+    free((char*)options->tun_interface);
+    for (int i = 0; i < SINGBOX_CORE_MAX_BINARIES; i++) {
+        free((char*)options->binaries[i]);
+    }
+    memset(options, 0, sizeof(*options));
+}
+
+int singbox_core_init(const singbox_core_options_t* options) {
+    pthread_mutex_lock(&lifecycle_mutex);
+    
+    if (singbox_core_is_initialized()) {
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 1;
+    }
+    
+    singbox_core_options_t defaults;
+    if (!options) {
+        singbox_core_default_options(&defaults);
+        options = &defaults;
+    }
+    core_options.config_path = copy_string(options->config_path);
+    core_options.log_file_path = copy_string(options->log_file_path);
+    for (int i = 0; i < SINGBOX_CORE_MAX_BINARIES && options->binaries[i]; i++) {
+        core_options.binaries[i] = copy_string(options->binaries[i]);
+    }
+    core_options.start_grace_ms = options->start_grace_ms;
+    core_options.stop_timeout_ms = options->stop_timeout_ms;
+    core_options.stats_interval_ms = options->stats_interval_ms;
+    core_options.embedded_library = copy_string(options->embedded_library);
+    core_options.tun_interface = copy_string(options->tun_interface);
+    
+    singbox_logging_init();
+    if (core_options.log_file_path) {
+        singbox_logging_open_file(core_options.log_file_path);
+    }
+    SINGBOX_LOG_I("Sing-box logging system initialized");
+    
+    int result = core_options.config_path != NULL;
+    if (result) {
+        __atomic_store_n(&core_initialized, 1, __ATOMIC_RELEASE);
+        LOGI("Sing-box initialized with config path: %s", core_options.config_path);
+        SINGBOX_LOG_I("Sing-box core initialized successfully");
+    } else {
+        LOGE("Failed to initialize sing-box");
+        SINGBOX_LOG_E("Failed to initialize sing-box core");
+        free_options(&core_options);
+    }
+    
+    pthread_mutex_unlock(&lifecycle_mutex);
+    return result;
+}
+
+static int64_t now_seconds(void) {
+    return (int64_t)time(NULL);
+}
+
+static int64_t now_millis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void init_stats_region(void) {
+    singbox_stats_shared_init(&stats_region);
+}
+
+const singbox_stats_shared_t* singbox_core_stats_region(void) {
+    pthread_once(&stats_region_once, init_stats_region);
+    return &stats_region;
+}
+
+/**
+ * Copy the counters into the shared region
+ */
+static void publish_stats(void) {
+    pthread_once(&stats_region_once, init_stats_region);
+    
+    pthread_mutex_lock(&stats_publish_mutex);
+    singbox_stats_values_t values;
+    values.state = (uint32_t)singbox_core_state();
+    values.upload_bytes = __atomic_load_n(&stats_total_upload, __ATOMIC_RELAXED);
+    values.download_bytes = __atomic_load_n(&stats_total_download, __ATOMIC_RELAXED);
+    values.packets_sent = __atomic_load_n(&stats_packets_sent, __ATOMIC_RELAXED);
+    values.packets_received = __atomic_load_n(&stats_packets_received, __ATOMIC_RELAXED);
+    if (values.packets_sent < 0) {
+        values.packets_sent = values.upload_bytes / 64;  // Approximate packets
+        values.packets_received = values.download_bytes / 64;
+    }
+    values.upload_speed = (double)__atomic_load_n(&stats_upload_speed, __ATOMIC_RELAXED);
+    values.download_speed = (double)__atomic_load_n(&stats_download_speed, __ATOMIC_RELAXED);
+    values.started_at_ms = __atomic_load_n(&stats_started_at, __ATOMIC_ACQUIRE) * 1000;
+    values.updated_at_ms = now_millis();
+    values.updates = 0;
+    singbox_stats_shared_write(&stats_region, &values);
+    pthread_mutex_unlock(&stats_publish_mutex);
+    singbox_notify_post_stats(&values);
+}
+
+static void reset_traffic(void) {
+    __atomic_store_n(&stats_total_upload, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_total_download, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_upload_speed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_download_speed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_sent, -1, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_received, -1, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_last_update, now_seconds(), __ATOMIC_RELEASE);
+    
+    // Interface counters are cumulative too
+    pthread_mutex_lock(&tun_stats_mutex);
+    if (tun_stats && singbox_linkstats_read(tun_stats, &tun_counters_last)) {
+        tun_counters_base = tun_counters_last;
+    }
+    pthread_mutex_unlock(&tun_stats_mutex);
+    
+    pthread_mutex_lock(&app_stats_mutex);
+    if (app_stats) {
+        singbox_uidstats_reset(app_stats);
+    }
+    pthread_mutex_unlock(&app_stats_mutex);
+    
+    // Embedded counters are cumulative in the library; count from here on
+    pthread_mutex_lock(&embedded_stats_mutex);
+    embedded_stats_base = embedded_stats_last;
+    pthread_mutex_unlock(&embedded_stats_mutex);
+}
+
+static uint32_t mock_random(void) {
+    uint32_t x = __atomic_add_fetch(&stats_random_state, 0x9e3779b9u, __ATOMIC_RELAXED);
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    return x;
+}
+
+/**
+ * Start accounting the sockets applications hold on the TUN interface's
+ * addresses; lifecycle lock held
+ */
+static void open_app_stats_locked(const char* ifname) {
+    singbox_uidstats_t* stats = singbox_uidstats_open(0);
+    if (!stats) {
+        LOGW("Socket owners are not readable; no per-app traffic");
+        return;
+    }
+    // Without a prefix every socket on the device would count
+    if (singbox_uidstats_add_interface(stats, ifname) == 0) {
+        LOGW("%s has no addresses; no per-app traffic", ifname);
+        singbox_uidstats_close(stats);
+        return;
+    }
+    LOGI("Accounting per-app traffic on %s through %s", ifname,
+         singbox_uidstats_source_name(singbox_uidstats_source(stats)));
+    
+    pthread_mutex_lock(&app_stats_mutex);
+    app_stats = stats;
+    pthread_mutex_unlock(&app_stats_mutex);
+}
+
+/**
+ * Start counting the TUN interface behind `tun_fd`; lifecycle lock held
+ */
+static void open_tun_stats_locked(int tun_fd) {
+    char ifname[IF_NAMESIZE];
+    int ifindex;
+    if (tun_fd >= 0) {
+        ifindex = singbox_linkstats_tun_ifindex(tun_fd, ifname, sizeof(ifname));
+    } else {
+        // sing-box creates the device itself; it may still be coming up
+        snprintf(ifname, sizeof(ifname), "%s", core_options.tun_interface);
+        ifindex = (int)if_nametoindex(ifname);
+    }
+    if (ifindex > 0) {
+        open_app_stats_locked(ifname);
+    }
+    singbox_linkstats_t* stats = ifindex > 0 ? singbox_linkstats_open(ifindex, 0) : NULL;
+    if (!stats && tun_fd < 0) {
+        LOGI("Waiting for %s to count traffic", ifname);
+        pthread_mutex_lock(&tun_stats_mutex);
+        memset(&tun_counters_base, 0, sizeof(tun_counters_base));
+        tun_stats_pending = 1;
+        pthread_mutex_unlock(&tun_stats_mutex);
+        return;
+    }
+    if (!stats) {
+        LOGW("No interface counters for tun fd %d; traffic figures are simulated", tun_fd);
+        return;
+    }
+    LOGI("Counting traffic on %s through %s", ifname,
+         singbox_linkstats_source_name(singbox_linkstats_source(stats)));
+    
+    pthread_mutex_lock(&tun_stats_mutex);
+    tun_stats = stats;
+    memset(&tun_counters_base, 0, sizeof(tun_counters_base));
+    if (singbox_linkstats_read(stats, &tun_counters_last)) {
+        tun_counters_base = tun_counters_last;
+    }
+    pthread_mutex_unlock(&tun_stats_mutex);
+}
+
+/**
+ * Take the totals from the interface counters
+ * @return 0 if there are none, and the simulation applies
+ */
+static int refresh_tun_traffic(int64_t elapsed) {
+    singbox_link_counters_t counters, base;
+    pthread_mutex_lock(&tun_stats_mutex);
+    if (tun_stats_pending) {
+        unsigned int ifindex = if_nametoindex(core_options.tun_interface);
+        tun_stats = ifindex > 0 ? singbox_linkstats_open((int)ifindex, 0) : NULL;
+        if (tun_stats) {
+            // Counted from when the device appeared, which is when the tunnel did
+            tun_stats_pending = 0;
+            memset(&tun_counters_base, 0, sizeof(tun_counters_base));
+        }
+    }
+    int ok = tun_stats && singbox_linkstats_read(tun_stats, &counters);
+    if (ok) {
+        tun_counters_last = counters;
+        base = tun_counters_base;
+    }
+    int available = tun_stats != NULL || tun_stats_pending;
+    pthread_mutex_unlock(&tun_stats_mutex);
+    if (!ok) {
+        return available; // Interface gone with the tunnel: keep the last totals
+    }
+    
+    // Applications send into the tunnel through the device's transmit side
+    int64_t upload = (int64_t)(counters.tx_bytes - base.tx_bytes);
+    int64_t download = (int64_t)(counters.rx_bytes - base.rx_bytes);
+    int64_t previous_upload = __atomic_exchange_n(&stats_total_upload, upload, __ATOMIC_RELAXED);
+    int64_t previous_download = __atomic_exchange_n(&stats_total_download, download, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_upload_speed, upload > previous_upload ? (upload - previous_upload) / elapsed : 0,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_download_speed,
+                     download > previous_download ? (download - previous_download) / elapsed : 0,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_sent, (int64_t)(counters.tx_packets - base.tx_packets), __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_received, (int64_t)(counters.rx_packets - base.rx_packets),
+                     __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * Advance the traffic counters and publish them if a second has passed
+ */
+static void refresh_traffic(void) {
+    if (__atomic_load_n(&embedded_active, __ATOMIC_ACQUIRE)) {
+        return; // Pushed by the library
+    }
+    
+    int64_t now = now_seconds();
+    int64_t last = __atomic_load_n(&stats_last_update, __ATOMIC_ACQUIRE);
+    int64_t elapsed = now - last;
+    
+    // Whoever moves the update time forward refreshes the totals
+    if (elapsed > 0 && __atomic_compare_exchange_n(&stats_last_update, &last, now, 0,
+                                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        if (refresh_tun_traffic(elapsed)) {
+            publish_stats();
+            return;
+        }
+        
+        // Without a TUN device (host tests) the transfer is simulated
+        int64_t upload_speed = mock_random() % 1000 + 100;
+        int64_t download_speed = mock_random() % 2000 + 200;
+        __atomic_fetch_add(&stats_total_upload, upload_speed * elapsed, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats_total_download, download_speed * elapsed, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats_upload_speed, upload_speed, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats_download_speed, download_speed, __ATOMIC_RELAXED);
+        publish_stats();
+    }
+}
+
+/**
+ * Sample the running sing-box process, (re)opening the sampler when it changed
+ * @return 0 if nothing runs or the process is gone
+ */
+static int sample_process(singbox_proc_snapshot_t* snapshot) {
+    pid_t pid = __atomic_load_n(&embedded_active, __ATOMIC_ACQUIRE)
+        ? getpid() : __atomic_load_n(&singbox_pid, __ATOMIC_ACQUIRE);
+    
+    pthread_mutex_lock(&procstat_mutex);
+    if (process_sampler && singbox_procstat_pid(process_sampler) != pid) {
+        singbox_procstat_close(process_sampler);
+        process_sampler = NULL;
+    }
+    if (!process_sampler && pid > 0) {
+        process_sampler = singbox_procstat_open(pid, 0);
+    }
+    int result = process_sampler && singbox_procstat_sample(process_sampler, snapshot);
+    pthread_mutex_unlock(&procstat_mutex);
+    return result;
+}
+
+/**
+ * Drop the per-run samplers once sing-box has stopped
+ */
+static void release_monitors(void) {
+    pthread_mutex_lock(&procstat_mutex);
+    singbox_procstat_close(process_sampler);
+    process_sampler = NULL;
+    pthread_mutex_unlock(&procstat_mutex);
+    
+    pthread_mutex_lock(&tun_stats_mutex);
+    singbox_linkstats_close(tun_stats);
+    tun_stats = NULL;
+    tun_stats_pending = 0;
+    pthread_mutex_unlock(&tun_stats_mutex);
+    
+    pthread_mutex_lock(&app_stats_mutex);
+    singbox_uidstats_close(app_stats);
+    app_stats = NULL;
+    pthread_mutex_unlock(&app_stats_mutex);
+}
+
+/**
+ * Pick up new application sockets and their byte counts
+ */
+static void refresh_app_stats(void) {
+    pthread_mutex_lock(&app_stats_mutex);
+    if (app_stats) {
+        singbox_uidstats_refresh(app_stats);
+    }
+    pthread_mutex_unlock(&app_stats_mutex);
+}
+
+static void* stats_publisher_thread(void* arg) {
+    (void)arg;
+    uint32_t interval_ms = core_options.stats_interval_ms;
+    
+    pthread_mutex_lock(&publisher_mutex);
+    while (!publisher_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval_ms / 1000;
+        deadline.tv_nsec += (long)(interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&publisher_cond, &publisher_mutex, &deadline);
+        if (publisher_stop) {
+            break;
+        }
+        
+        pthread_mutex_unlock(&publisher_mutex);
+        refresh_traffic();
+        // Keeps the process time series going between callers
+        singbox_proc_snapshot_t snapshot;
+        sample_process(&snapshot);
+        refresh_app_stats();
+        pthread_mutex_lock(&publisher_mutex);
+    }
+    pthread_mutex_unlock(&publisher_mutex);
+    return NULL;
+}
+
+/**
+ * Start the stats publisher; lifecycle lock held
+ */
+static void start_publisher(void) {
+    if (publisher_started || core_options.stats_interval_ms == 0) {
+        return;
+    }
+    publisher_stop = 0;
+    publisher_started = pthread_create(&publisher_thread, NULL, stats_publisher_thread, NULL) == 0;
+    if (!publisher_started) {
+        LOGW("Failed to start stats publisher thread");
+    }
+}
+
+/**
+ * Stop the stats publisher; lifecycle lock held
+ */
+static void stop_publisher(void) {
+    if (!publisher_started) {
+        return;
+    }
+    pthread_mutex_lock(&publisher_mutex);
+    publisher_stop = 1;
+    pthread_cond_signal(&publisher_cond);
+    pthread_mutex_unlock(&publisher_mutex);
+    pthread_join(publisher_thread, NULL);
+    publisher_started = 0;
+}
+
+/**
+ * Start sing-box through singbox_spawn (posix_spawn or vfork, never a
+ * fork of this process's address space); lifecycle lock held
+ */
+static int spawn_locked(const char* config, size_t config_length, int tun_fd) {
+    // Written straight from the caller's buffer
+    int write_error = singbox_config_write_file(core_options.config_path, config, config_length);
+    if (write_error != 0) {
+        LOGE("Failed to write config file %s: %s", core_options.config_path, strerror(write_error));
+        return 0;
+    }
+    
+    // Capture sing-box output; without a pipe it simply goes to /dev/null as before
+    int output_pipe[2] = {-1, -1};
+    if (pipe2(output_pipe, O_CLOEXEC) != 0) {
+        LOGW("Failed to create output pipe: %s", strerror(errno));
+        output_pipe[0] = output_pipe[1] = -1;
+    }
+    
+    // The TUN descriptor keeps its number in the child unless it would land on stdio
+    char tun_fd_env[48];
+    int tun_target = tun_fd > STDERR_FILENO ? tun_fd : STDERR_FILENO + 1;
+    snprintf(tun_fd_env, sizeof(tun_fd_env), "SING_BOX_TUN_FD=%d", tun_target);
+    const char* env[] = { tun_fd >= 0 ? tun_fd_env : NULL, NULL };
+    char* argv[] = { "sing-box", "run", "-c", (char*)core_options.config_path, NULL };
+    
+    singbox_spawn_request_t request = {
+        .paths = core_options.binaries,
+        .argv = argv,
+        .env = env,
+        .stdout_fd = output_pipe[1],
+        .stderr_fd = output_pipe[1],
+        .pass_fd = tun_fd,
+        .pass_fd_target = tun_target,
+    };
+    pid_t pid = -1;
+    int error = singbox_spawn(&request, &pid);
+    if (error != 0) {
+        LOGE("Failed to spawn sing-box (%s): %s", singbox_spawn_backend(), strerror(error));
+        if (output_pipe[0] >= 0) {
+            close(output_pipe[0]);
+            close(output_pipe[1]);
+        }
+        return 0;
+    }
+    
+    LOGI("Sing-box started with PID: %d", pid);
+    __atomic_store_n(&singbox_pid, pid, __ATOMIC_RELEASE);
+    if (output_pipe[0] >= 0) {
+        close(output_pipe[1]);
+        output_thread_started = pthread_create(&output_thread, NULL, output_reader_thread,
+                                               (void*)(intptr_t)output_pipe[0]) == 0;
+        if (!output_thread_started) {
+            close(output_pipe[0]);
+        }
+    }
+    
+    // Give it a moment to start; readers keep seeing STARTING meanwhile
+    sleep_ms(core_options.start_grace_ms);
+    
+    int status;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+        LOGE("Sing-box process exited immediately with status: %d", status);
+        __atomic_store_n(&singbox_pid, 0, __ATOMIC_RELEASE);
+        join_output_reader();
+        return 0;
+    }
+    return 1;
+}
+
+static void on_embedded_log(void* ctx, const char* line, size_t length) {
+    (void)ctx;
+    char buffer[SINGBOX_LOGRING_MAX_MESSAGE + 1];
+    if (length > SINGBOX_LOGRING_MAX_MESSAGE) {
+        length = SINGBOX_LOGRING_MAX_MESSAGE;
+    }
+    memcpy(buffer, line, length);
+    buffer[length] = '\0';
+    
+    singbox_log_event_t event;
+    singbox_logparse_line(buffer, length, &event);
+    on_core_event(&event, buffer, NULL);
+}
+
+static void on_embedded_stats(void* ctx, const singbox_libbox_stats_t* stats) {
+    (void)ctx;
+    // Real counters: they replace the simulated ones
+    pthread_mutex_lock(&embedded_stats_mutex);
+    embedded_stats_last = *stats;
+    const singbox_libbox_stats_t* base = &embedded_stats_base;
+    __atomic_store_n(&stats_total_upload, stats->upload_bytes - base->upload_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_total_download, stats->download_bytes - base->download_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_sent, stats->packets_sent - base->packets_sent, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_packets_received, stats->packets_received - base->packets_received, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_upload_speed, stats->upload_speed, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats_download_speed, stats->download_speed, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&embedded_stats_mutex);
+    publish_stats();
+}
+
+/**
+ * Start sing-box inside the process through the embedding library; lifecycle lock held
+ */
+static int start_embedded_locked(const char* config, size_t config_length, int tun_fd) {
+    char error[256];
+    if (!embedded_lib) {
+        embedded_lib = singbox_libbox_open(core_options.embedded_library, error, sizeof(error));
+        if (!embedded_lib) {
+            LOGE("Failed to load embedded sing-box: %s", error);
+            SINGBOX_LOG_E("Failed to load embedded sing-box: %s", error);
+            return 0;
+        }
+        LOGI("Loaded embedded sing-box %s", singbox_libbox_version(embedded_lib));
+    }
+    
+    // A new instance counts from zero
+    pthread_mutex_lock(&embedded_stats_mutex);
+    memset(&embedded_stats_last, 0, sizeof(embedded_stats_last));
+    memset(&embedded_stats_base, 0, sizeof(embedded_stats_base));
+    pthread_mutex_unlock(&embedded_stats_mutex);
+    
+    static const singbox_libbox_callbacks_t callbacks = {
+        NULL, on_embedded_log, on_embedded_stats, 1000
+    };
+    if (!singbox_libbox_start(embedded_lib, config, config_length, tun_fd, &callbacks, error, sizeof(error))) {
+        LOGE("Embedded sing-box failed to start: %s", error);
+        SINGBOX_LOG_E("Embedded sing-box failed to start: %s", error);
+        return 0;
+    }
+    __atomic_store_n(&embedded_active, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void stop_embedded_locked(void) {
+    set_state(SINGBOX_CORE_STOPPING);
+    if (!singbox_libbox_stop(embedded_lib)) {
+        LOGW("Embedded sing-box reported an error while stopping");
+    }
+    __atomic_store_n(&embedded_active, 0, __ATOMIC_RELEASE);
+    stop_publisher();
+    release_monitors();
+    set_state(SINGBOX_CORE_STOPPED);
+}
+
+/**
+ * Validate a configuration where it lies; no lock held
+ */
+static int check_config(const char* config, size_t length, int flags) {
+    if (!config || length == 0) {
+        LOGE("Invalid configuration provided");
+        return 0;
+    }
+    singbox_config_error_t error;
+    if (!singbox_config_validate(config, length, flags, &error)) {
+        LOGE("Invalid configuration at line %u, column %u: %s", error.line, error.column, error.message);
+        SINGBOX_LOG_E("Invalid configuration at line %u, column %u: %s", error.line, error.column, error.message);
+        return 0;
+    }
+    return 1;
+}
+
+static int start_config(const char* config, size_t config_length, int tun_fd, int flags) {
+    // Large configs are checked before the lifecycle lock is taken
+    if (!check_config(config, config_length, flags)) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&lifecycle_mutex);
+    
+    if (!singbox_core_is_initialized()) {
+        LOGE("Sing-box not initialized");
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 0;
+    }
+    
+    reap_exited_locked();
+    if (singbox_core_state() == SINGBOX_CORE_RUNNING) {
+        LOGI("Sing-box already running");
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 1;
+    }
+    
+    if (tun_fd < 0 && !core_options.tun_interface) {
+        LOGE("Invalid TUN file descriptor: %d", tun_fd);
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 0;
+    }
+    
+    LOGI("Starting sing-box with config length: %zu, tun_fd: %d", config_length, tun_fd);
+    set_state(SINGBOX_CORE_STARTING);
+    reset_traffic();
+    __atomic_store_n(&stats_started_at, now_seconds(), __ATOMIC_RELEASE);
+    int embedded = core_options.embedded_library != NULL;
+    int result = embedded ? start_embedded_locked(config, config_length, tun_fd)
+                          : spawn_locked(config, config_length, tun_fd);
+    if (result) {
+        open_tun_stats_locked(tun_fd);
+        set_state(SINGBOX_CORE_RUNNING);
+        // Embedded traffic is pushed by the library; the process and
+        // per-app samples still come from the publisher
+        start_publisher();
+        LOGI("Sing-box started successfully");
+    } else {
+        set_state(SINGBOX_CORE_STOPPED);
+        LOGE("Failed to start sing-box");
+    }
+    
+    pthread_mutex_unlock(&lifecycle_mutex);
+    return result;
+}
+
+int singbox_core_start(const char* config, int tun_fd) {
+    // JNI strings arrive as modified UTF-8
+    return start_config(config, config ? strlen(config) : 0, tun_fd, SINGBOX_CONFIG_MODIFIED_UTF8);
+}
+
+int singbox_core_start_buffer(const char* config, size_t length, int tun_fd) {
+    return start_config(config, length, tun_fd, 0);
+}
+
+/**
+ * Terminate the child and wait for it; lifecycle lock held
+ */
+static void stop_locked(void) {
+    if (__atomic_load_n(&embedded_active, __ATOMIC_ACQUIRE)) {
+        stop_embedded_locked();
+        return;
+    }
+    
+    pid_t pid = __atomic_load_n(&singbox_pid, __ATOMIC_ACQUIRE);
+    if (pid <= 0) {
+        set_state(SINGBOX_CORE_STOPPED);
+        return;
+    }
+    
+    set_state(SINGBOX_CORE_STOPPING);
+    int status;
+    if (kill(pid, SIGTERM) == 0) {
+        LOGI("Sent SIGTERM to sing-box process: %d", pid);
+        
+        int exited = 0;
+        for (uint32_t waited = 0; waited < core_options.stop_timeout_ms; waited += STOP_POLL_MS) {
+            if (waitpid(pid, &status, WNOHANG) == pid) {
+                LOGI("Sing-box process exited with status: %d", status);
+                exited = 1;
+                break;
+            }
+            sleep_ms(STOP_POLL_MS);
+        }
+        
+        if (!exited) {
+            LOGW("Sing-box didn't exit gracefully, sending SIGKILL");
+            if (kill(pid, SIGKILL) == 0) {
+                waitpid(pid, &status, 0);
+                LOGI("Sing-box process force killed");
+            }
+        }
+    } else {
+        LOGE("Failed to send signal to sing-box process: %d", pid);
+        waitpid(pid, &status, WNOHANG);
+    }
+    
+    __atomic_store_n(&singbox_pid, 0, __ATOMIC_RELEASE);
+    stop_publisher();
+    release_monitors();
+    join_output_reader();
+    set_state(SINGBOX_CORE_STOPPED);
+}
+
+int singbox_core_stop(void) {
+    pthread_mutex_lock(&lifecycle_mutex);
+    
+    reap_exited_locked();
+    if (singbox_core_state() == SINGBOX_CORE_STOPPED) {
+        LOGI("Sing-box not running");
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 1;
+    }
+    
+    LOGI("Stopping sing-box");
+    stop_locked();
+    LOGI("Sing-box stopped");
+    
+    pthread_mutex_unlock(&lifecycle_mutex);
+    return 1;
+}
+
+void singbox_core_cleanup(void) {
+    pthread_mutex_lock(&lifecycle_mutex);
+    
+    LOGI("Cleaning up sing-box core");
+    if (singbox_core_state() != SINGBOX_CORE_STOPPED) {
+        stop_locked();
+    }
+    
+    if (core_options.config_path) {
+        unlink(core_options.config_path);
+    }
+    singbox_libbox_close(embedded_lib);
+    embedded_lib = NULL;
+    release_monitors();
+    
+    // Nothing classifies or logs from the core any more; free the shared
+    // state so an unloaded library (dart:ffi) leaves nothing behind. The
+    // log file is flushed and closed; both are set up again on the next init
+    singbox_errcat_release_default();
+    singbox_logging_cleanup();
+    
+    free_options(&core_options);
+    __atomic_store_n(&core_initialized, 0, __ATOMIC_RELEASE);
+    
+    pthread_mutex_unlock(&lifecycle_mutex);
+}
+
+static int update_config(const char* config, size_t config_length, int flags) {
+    if (!check_config(config, config_length, flags)) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&lifecycle_mutex);
+    
+    if (singbox_core_state() != SINGBOX_CORE_RUNNING) {
+        LOGE("Cannot update configuration - not running");
+        pthread_mutex_unlock(&lifecycle_mutex);
+        return 0;
+    }
+    
+    LOGI("Updating configuration (%zu bytes)", config_length);
+    // Replaced atomically; in a real implementation sing-box would then be
+    // told to reload it
+    int error = singbox_config_write_file(core_options.config_path, config, config_length);
+    if (error != 0) {
+        LOGE("Failed to write config file %s: %s", core_options.config_path, strerror(error));
+    }
+    
+    pthread_mutex_unlock(&lifecycle_mutex);
+    return error == 0;
+}
+
+int singbox_core_update_config(const char* config) {
+    return update_config(config, config ? strlen(config) : 0, SINGBOX_CONFIG_MODIFIED_UTF8);
+}
+
+int singbox_core_update_config_buffer(const char* config, size_t length) {
+    return update_config(config, length, 0);
+}
+
+int32_t singbox_core_pid(void) {
+    return (int32_t)__atomic_load_n(&singbox_pid, __ATOMIC_ACQUIRE);
+}
+
+int singbox_core_is_running(void) {
+    if (singbox_core_state() != SINGBOX_CORE_RUNNING) {
+        return 0;
+    }
+    if (__atomic_load_n(&embedded_active, __ATOMIC_ACQUIRE) ||
+        child_alive(__atomic_load_n(&singbox_pid, __ATOMIC_ACQUIRE))) {
+        return 1;
+    }
+    
+    // Exited on its own: settle the state unless a lifecycle operation is
+    // already doing so; never wait for it
+    if (pthread_mutex_trylock(&lifecycle_mutex) == 0) {
+        reap_exited_locked();
+        pthread_mutex_unlock(&lifecycle_mutex);
+    }
+    return 0;
+}
+
+int singbox_core_format_stats(char* out, size_t size) {
+    if (!singbox_core_is_running()) {
+        return -1;
+    }
+    
+    refresh_traffic();
+    singbox_stats_values_t values;
+    singbox_stats_shared_read(singbox_core_stats_region(), &values);
+    
+    int length = snprintf(out, size,
+        "{"
+        "\"upload_bytes\": %lld,"
+        "\"download_bytes\": %lld,"
+        "\"upload_speed\": %.2f,"
+        "\"download_speed\": %.2f,"
+        "\"connection_time\": %lld,"
+        "\"packets_sent\": %lld,"
+        "\"packets_received\": %lld"
+        "}",
+        (long long)values.upload_bytes,
+        (long long)values.download_bytes,
+        values.upload_speed,
+        values.download_speed,
+        (long long)(now_seconds() - values.started_at_ms / 1000),
+        (long long)values.packets_sent,
+        (long long)values.packets_received);
+    return length >= 0 && (size_t)length < size ? length : -1;
+}
+
+int singbox_core_format_process_stats(char* out, size_t size) {
+    if (!singbox_core_is_running()) {
+        return -1;
+    }
+    singbox_proc_snapshot_t snapshot;
+    if (!sample_process(&snapshot)) {
+        return -1;
+    }
+    
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    long long total_mb = pages > 0 && page_size > 0 ? (long long)pages * page_size / (1024 * 1024) : 0;
+    uint64_t used_kb = snapshot.has_pss ? snapshot.pss_kb : snapshot.rss_kb;
+    
+    // Legacy keys first, then the full sample
+    int length = snprintf(out, size,
+        "{\"total_memory_mb\": %lld,"
+        "\"used_memory_mb\": %llu,"
+        "\"cpu_usage_percent\": %.1f,"
+        "\"open_file_descriptors\": %u,"
+        "\"process\": ",
+        total_mb, (unsigned long long)(used_kb / 1024), snapshot.cpu_percent, snapshot.fd_count);
+    if (length < 0 || (size_t)length >= size) {
+        return -1;
+    }
+    int process_length = singbox_procstat_format_json(&snapshot, 8, out + length, size - (size_t)length);
+    if (process_length < 0 || (size_t)(length + process_length) + 1 >= size) {
+        return -1;
+    }
+    length += process_length;
+    out[length++] = '}';
+    out[length] = '\0';
+    return length;
+}
+
+int singbox_core_format_process_history(char* out, size_t size) {
+    pthread_mutex_lock(&procstat_mutex);
+    int length = process_sampler ? singbox_procstat_format_history_json(process_sampler, out, size) : -1;
+    pthread_mutex_unlock(&procstat_mutex);
+    return length;
+}
+
+int singbox_core_format_app_usage(char* out, size_t size) {
+    pthread_mutex_lock(&app_stats_mutex);
+    int length = app_stats ? singbox_uidstats_format_json(app_stats, APP_USAGE_MAX_APPS, out, size)
+                           : snprintf(out, size, "{\"source\":null,\"apps\":[]}");
+    pthread_mutex_unlock(&app_stats_mutex);
+    return length >= 0 && (size_t)length < size ? length : -1;
+}
+
+int singbox_core_reset_stats(void) {
+    if (!singbox_core_is_running()) {
+        return 0;
+    }
+    LOGI("Resetting statistics");
+    reset_traffic();
+    publish_stats();
+    return 1;
+}
+
+int singbox_core_format_detailed_stats(char* out, size_t size) {
+    if (!singbox_core_is_running()) {
+        return -1;
+    }
+    
+    // Traffic comes from the published counters (TUN interface or library);
+    // latency figures are still mocked
+    refresh_traffic();
+    singbox_stats_values_t traffic;
+    singbox_stats_shared_read(singbox_core_stats_region(), &traffic);
+    
+    char tun[384] = "null";
+    pthread_mutex_lock(&tun_stats_mutex);
+    if (tun_stats) {
+        const singbox_link_counters_t* last = &tun_counters_last;
+        const singbox_link_counters_t* base = &tun_counters_base;
+        snprintf(tun, sizeof(tun),
+                 "{\"interface\": \"%s\", \"source\": \"%s\", "
+                 "\"rxBytes\": %llu, \"txBytes\": %llu, \"rxPackets\": %llu, \"txPackets\": %llu, "
+                 "\"rxErrors\": %llu, \"txErrors\": %llu, \"rxDropped\": %llu, \"txDropped\": %llu}",
+                 singbox_linkstats_ifname(tun_stats),
+                 singbox_linkstats_source_name(singbox_linkstats_source(tun_stats)),
+                 (unsigned long long)(last->rx_bytes - base->rx_bytes),
+                 (unsigned long long)(last->tx_bytes - base->tx_bytes),
+                 (unsigned long long)(last->rx_packets - base->rx_packets),
+                 (unsigned long long)(last->tx_packets - base->tx_packets),
+                 (unsigned long long)(last->rx_errors - base->rx_errors),
+                 (unsigned long long)(last->tx_errors - base->tx_errors),
+                 (unsigned long long)(last->rx_dropped - base->rx_dropped),
+                 (unsigned long long)(last->tx_dropped - base->tx_dropped));
+    }
+    pthread_mutex_unlock(&tun_stats_mutex);
+    
+    // Event counts come from parsed sing-box output
+    singbox_log_event_counters_t events;
+    singbox_log_event_snapshot(&event_counters, &events);
+    
+    char categories[512];
+    size_t categories_len = 0;
+    for (int i = 0; i < SINGBOX_ERRCAT_COUNT && categories_len < sizeof(categories); i++) {
+        categories_len += snprintf(categories + categories_len, sizeof(categories) - categories_len,
+                                   "%s\"%s\": %llu", i ? "," : "", singbox_error_category_name(i),
+                                   (unsigned long long)__atomic_load_n(&error_category_counts[i], __ATOMIC_RELAXED));
+    }
+    int error_category = __atomic_load_n(&last_error_category, __ATOMIC_ACQUIRE);
+    singbox_logthrottle_stats_t throttle;
+    singbox_logging_get_throttle_stats(&throttle);
+    singbox_logring_stats_t log_buffer;
+    singbox_logging_get_buffer_stats(&log_buffer);
+    
+    int length = snprintf(out, size, "{"
+        "\"bytesReceived\": %lld,"
+        "\"bytesSent\": %lld,"
+        "\"downloadSpeed\": %.1f,"
+        "\"uploadSpeed\": %.1f,"
+        "\"packetsReceived\": %lld,"
+        "\"packetsSent\": %lld,"
+        "\"connectionDuration\": %lld,"
+        "\"tun\": %s,"
+        "\"latency\": 45,"
+        "\"jitter\": 5,"
+        "\"packetLoss\": 0.1,"
+        "\"events\": {"
+        "\"lines\": %llu,"
+        "\"inbound_connections\": %llu,"
+        "\"outbound_connections\": %llu,"
+        "\"udp_connections\": %llu,"
+        "\"closed_connections\": %llu,"
+        "\"dns_queries\": %llu,"
+        "\"dns_answers\": %llu,"
+        "\"router_matches\": %llu,"
+        "\"errors\": %llu,"
+        "\"warnings\": %llu"
+        "},"
+        "\"errorCategories\": {%s},"
+        "\"lastError\": {"
+        "\"category\": \"%s\","
+        "\"code\": \"%s\","
+        "\"severity\": \"%s\","
+        "\"isRecoverable\": %s"
+        "},"
+        "\"logThrottle\": {"
+        "\"submitted\": %llu,"
+        "\"passed\": %llu,"
+        "\"collapsed\": %llu,"
+        "\"rateLimited\": %llu,"
+        "\"suppressedBytes\": %llu,"
+        "\"summaries\": %llu"
+        "},"
+        "\"logBuffer\": {"
+        "\"entries\": %llu,"
+        "\"blocks\": %llu,"
+        "\"rawBytes\": %llu,"
+        "\"storedBytes\": %llu,"
+        "\"capacity\": %u,"
+        "\"evictedEntries\": %llu"
+        "}"
+        "}",
+        (long long)traffic.download_bytes,
+        (long long)traffic.upload_bytes,
+        traffic.download_speed,
+        traffic.upload_speed,
+        (long long)traffic.packets_received,
+        (long long)traffic.packets_sent,
+        (long long)(now_seconds() - traffic.started_at_ms / 1000),
+        tun,
+        (unsigned long long)events.lines,
+        (unsigned long long)events.by_type[SINGBOX_EVENT_INBOUND_CONNECTION],
+        (unsigned long long)events.by_type[SINGBOX_EVENT_OUTBOUND_CONNECTION],
+        (unsigned long long)events.udp_connections,
+        (unsigned long long)events.by_type[SINGBOX_EVENT_CONNECTION_CLOSED],
+        (unsigned long long)events.by_type[SINGBOX_EVENT_DNS_QUERY],
+        (unsigned long long)events.by_type[SINGBOX_EVENT_DNS_ANSWER],
+        (unsigned long long)events.by_type[SINGBOX_EVENT_ROUTER_MATCH],
+        (unsigned long long)events.by_type[SINGBOX_EVENT_ERROR],
+        (unsigned long long)events.by_level[SINGBOX_LOG_WARN],
+        categories,
+        singbox_error_category_name(error_category),
+        singbox_error_category_code(error_category),
+        singbox_error_severity_name(__atomic_load_n(&last_error_severity, __ATOMIC_RELAXED)),
+        __atomic_load_n(&last_error_recoverable, __ATOMIC_RELAXED) ? "true" : "false",
+        (unsigned long long)throttle.submitted,
+        (unsigned long long)throttle.passed,
+        (unsigned long long)throttle.collapsed,
+        (unsigned long long)throttle.rate_limited,
+        (unsigned long long)throttle.suppressed_bytes,
+        (unsigned long long)throttle.summaries,
+        (unsigned long long)log_buffer.records,
+        (unsigned long long)log_buffer.blocks,
+        (unsigned long long)log_buffer.raw_bytes,
+        (unsigned long long)log_buffer.stored_bytes,
+        log_buffer.capacity,
+        (unsigned long long)log_buffer.evicted_records);
+    
+    return length >= 0 && (size_t)length < size ? length : -1;
+}
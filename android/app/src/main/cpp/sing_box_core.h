@@ -0,0 +1,177 @@
+#ifndef SING_BOX_CORE_H
+#define SING_BOX_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sing_box_statsmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * JNI-free core of the sing-box bridge: process lifecycle, output capture
+ * and statistics. sing_box_jni.c only converts arguments and results.
+ *
+ * Lifecycle operations (init, start, stop, update, cleanup) are serialised
+ * by a dedicated lifecycle lock and may block for seconds while sing-box
+ * starts or shuts down. The lifecycle state is published through atomics,
+ * so the read side (state, is_running, stats) never takes that lock and
+ * never waits behind a start or stop in progress.
+ */
+
+typedef enum {
+    SINGBOX_CORE_STOPPED = 0,
+    SINGBOX_CORE_STARTING,
+    SINGBOX_CORE_RUNNING,
+    SINGBOX_CORE_STOPPING
+} singbox_core_state_t;
+
+#define SINGBOX_CORE_MAX_BINARIES 4
+
+typedef struct {
+    const char* config_path;        // Where the configuration is written for sing-box
+    const char* log_file_path;      // Persistent native log, NULL for none
+    const char* binaries[SINGBOX_CORE_MAX_BINARIES + 1]; // Executables tried in order, NULL terminated
+    uint32_t start_grace_ms;        // sing-box must survive this long to count as started
+    uint32_t stop_timeout_ms;       // Wait after SIGTERM before SIGKILL
+    uint32_t stats_interval_ms;     // Shared stats region refresh period, 0 to refresh on reads only
+    const char* embedded_library;   // libbox-style library to run sing-box in-process, NULL to spawn `binaries`
+    const char* tun_interface;      // Device sing-box creates itself (desktop), counted when start gets no descriptor
+} singbox_core_options_t;
+
+/**
+ * Fill in the Android defaults (app cache/files paths, 500 ms start grace,
+ * 5 s stop timeout, 1 s stats refresh)
+ */
+void singbox_core_default_options(singbox_core_options_t* options);
+
+/**
+ * Initialize logging and the core; a no-op when already initialized
+ * @param options Options (copied), NULL for the defaults
+ * @return 1 on success
+ */
+int singbox_core_init(const singbox_core_options_t* options);
+
+/**
+ * Start sing-box with the given configuration and TUN descriptor. On the
+ * desktop, where sing-box opens the device itself, `tun_fd` is -1 and the
+ * traffic is counted on the `tun_interface` of the options once it appears.
+ * @param config NUL-terminated JSON; modified UTF-8 (as from GetStringUTFChars) is accepted
+ * @return 1 if running (or already running), 0 on failure or if the config is not valid JSON
+ */
+int singbox_core_start(const char* config, int tun_fd);
+
+/**
+ * Start sing-box from `length` bytes of strict UTF-8 JSON (no terminator
+ * needed). The config is validated and written out where it lies, never
+ * copied, so it may live in a direct ByteBuffer.
+ * @return As singbox_core_start
+ */
+int singbox_core_start_buffer(const char* config, size_t length, int tun_fd);
+
+/**
+ * Stop sing-box: SIGTERM, then SIGKILL after the stop timeout
+ * @return 1 once stopped
+ */
+int singbox_core_stop(void);
+
+/**
+ * Stop sing-box if needed and release everything init acquired
+ */
+void singbox_core_cleanup(void);
+
+/**
+ * Replace the stored configuration of a running instance
+ * @return 0 if sing-box is not running or the config is not valid JSON
+ */
+int singbox_core_update_config(const char* config);
+
+/**
+ * singbox_core_update_config for `length` bytes of strict UTF-8 JSON
+ */
+int singbox_core_update_config_buffer(const char* config, size_t length);
+
+int singbox_core_is_initialized(void);
+
+/**
+ * Current lifecycle state; never blocks
+ */
+singbox_core_state_t singbox_core_state(void);
+
+/**
+ * Whether sing-box is running and its process is alive. Never blocks; an
+ * exited process is reaped when no lifecycle operation is in progress.
+ */
+int singbox_core_is_running(void);
+
+/**
+ * Process id of the sing-box child, for an exit watch (pidfd); never blocks
+ * @return 0 when no child runs, including an embedded sing-box
+ */
+int32_t singbox_core_pid(void);
+
+/**
+ * Format the traffic statistics as JSON from the shared stats region.
+ * Never waits for a lifecycle operation.
+ * @return Length written, or -1 if sing-box is not running or `size` is too small
+ */
+int singbox_core_format_stats(char* out, size_t size);
+
+/**
+ * Format the detailed statistics (traffic, parsed events, error categories,
+ * log pipeline counters) as JSON. Takes no lifecycle lock.
+ * @return Length written, or -1 if sing-box is not running or `size` is too small
+ */
+int singbox_core_format_detailed_stats(char* out, size_t size);
+
+/**
+ * The shared statistics region. Its address is stable for the lifetime of
+ * the process and it is kept current while sing-box runs, so callers may
+ * hand it out once (as a direct ByteBuffer) and poll it without calls.
+ */
+const singbox_stats_shared_t* singbox_core_stats_region(void);
+
+/**
+ * Sample memory (RSS/PSS/swap), CPU and descriptor usage of the sing-box
+ * process from /proc and format it as JSON. The top-level keys
+ * total_memory_mb, used_memory_mb, cpu_usage_percent and
+ * open_file_descriptors are kept for older readers; "process" holds the
+ * full sample. In embedded mode the figures are those of this process.
+ * @return Length written, or -1 if sing-box is not running or `size` is too small
+ */
+int singbox_core_format_process_stats(char* out, size_t size);
+
+/**
+ * Format the process samples of the current run (one per publisher tick,
+ * oldest first) as a JSON array
+ * @return Length written, or -1 if nothing was sampled or `size` is too small
+ */
+int singbox_core_format_process_history(char* out, size_t size);
+
+/**
+ * Format the tunnel traffic of each application UID, busiest first, as
+ * {"source":"sock_diag"|"proc_net"|null, ..., "apps":[{"uid":...}]}.
+ * "source" is null while nothing is accounted (not running, or socket
+ * owners are not readable on this device).
+ * @return Length written, or -1 if `size` is too small
+ */
+int singbox_core_format_app_usage(char* out, size_t size);
+
+/**
+ * Zero the traffic counters
+ * @return 0 if sing-box is not running
+ */
+int singbox_core_reset_stats(void);
+
+/**
+ * Name of a lifecycle state ("stopped", "starting", "running", "stopping")
+ */
+const char* singbox_core_state_name(singbox_core_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_CORE_H
@@ -0,0 +1,317 @@
+#include "sing_box_errcat.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SINGBOX_ERROR_SIGNATURE(pattern, category, severity, recoverable, priority, scope) \
+    { pattern, SINGBOX_ERRCAT_##category, SINGBOX_ERRSEV_##severity, recoverable, priority, SINGBOX_ERRSCOPE_##scope },
+
+static const singbox_error_signature_t builtin_signatures[] = {
+#include "sing_box_errcat_signatures.inc"
+};
+
+#undef SINGBOX_ERROR_SIGNATURE
+
+// State ids are 16 bit, which bounds the total pattern length
+#define MAX_STATES 65535
+
+struct singbox_errcat {
+    const singbox_error_signature_t* signatures;
+    size_t signature_count;
+    uint32_t* rank;             // Priority, then pattern length, per signature
+    uint8_t byte_class[256];    // Input byte -> alphabet index (0 = not in any pattern)
+    size_t alphabet;
+    size_t states;
+    uint16_t* next;             // states * alphabet, failure links folded in
+    int16_t* output;            // Best signature ending in each state, -1 if none
+    int16_t* local_output;      // Same, leaving out GLOBAL signatures
+    uint8_t* context;           // CONTEXT_* bits of the signatures ending in each state
+};
+
+#define CONTEXT_CONNECTION 1u
+#define CONTEXT_STARTUP 2u
+
+static uint8_t scope_context(uint8_t scope) {
+    return scope == SINGBOX_ERRSCOPE_CONNECTION ? CONTEXT_CONNECTION
+         : scope == SINGBOX_ERRSCOPE_STARTUP ? CONTEXT_STARTUP : 0;
+}
+
+static int better(const singbox_errcat_t* cat, int candidate, int current) {
+    return current < 0 || cat->rank[candidate] > cat->rank[current];
+}
+
+static int build_alphabet(singbox_errcat_t* cat) {
+    size_t classes = 1;
+    for (size_t i = 0; i < cat->signature_count; i++) {
+        for (const char* p = cat->signatures[i].pattern; *p; p++) {
+            unsigned char c = (unsigned char)*p;
+            if (c >= 'A' && c <= 'Z') {
+                return 0; // Table must be lowercase
+            }
+            if (!cat->byte_class[c]) {
+                if (classes == 256) {
+                    return 0;
+                }
+                cat->byte_class[c] = (uint8_t)classes++;
+            }
+        }
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+        cat->byte_class[c - 'a' + 'A'] = cat->byte_class[c];
+    }
+    cat->alphabet = classes;
+    return 1;
+}
+
+static int build_trie(singbox_errcat_t* cat, size_t max_states) {
+    cat->states = 1;
+    for (size_t i = 0; i < cat->signature_count; i++) {
+        const char* pattern = cat->signatures[i].pattern;
+        if (!*pattern) {
+            continue;
+        }
+        size_t state = 0;
+        for (const char* p = pattern; *p; p++) {
+            size_t slot = state * cat->alphabet + cat->byte_class[(unsigned char)*p];
+            if (!cat->next[slot]) {
+                if (cat->states >= max_states) {
+                    return 0;
+                }
+                cat->next[slot] = (uint16_t)cat->states++;
+            }
+            state = cat->next[slot];
+        }
+        if (better(cat, (int)i, cat->output[state])) {
+            cat->output[state] = (int16_t)i;
+        }
+        if (cat->signatures[i].scope != SINGBOX_ERRSCOPE_GLOBAL && better(cat, (int)i, cat->local_output[state])) {
+            cat->local_output[state] = (int16_t)i;
+        }
+        cat->context[state] |= scope_context(cat->signatures[i].scope);
+    }
+    return 1;
+}
+
+// Breadth-first pass that turns the trie into a complete DFA
+static int build_failure_links(singbox_errcat_t* cat) {
+    uint16_t* fail = calloc(cat->states, sizeof(uint16_t));
+    uint16_t* queue = malloc(cat->states * sizeof(uint16_t));
+    if (!fail || !queue) {
+        free(fail);
+        free(queue);
+        return 0;
+    }
+
+    size_t head = 0, tail = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+        size_t state = queue[head++];
+        uint16_t* row = cat->next + state * cat->alphabet;
+        const uint16_t* fail_row = cat->next + (size_t)fail[state] * cat->alphabet;
+
+        for (size_t c = 0; c < cat->alphabet; c++) {
+            if (row[c]) {
+                uint16_t child = row[c];
+                fail[child] = state == 0 ? 0 : fail_row[c];
+                int inherited = cat->output[fail[child]];
+                if (inherited >= 0 && better(cat, inherited, cat->output[child])) {
+                    cat->output[child] = (int16_t)inherited;
+                }
+                inherited = cat->local_output[fail[child]];
+                if (inherited >= 0 && better(cat, inherited, cat->local_output[child])) {
+                    cat->local_output[child] = (int16_t)inherited;
+                }
+                cat->context[child] |= cat->context[fail[child]];
+                queue[tail++] = child;
+            } else {
+                row[c] = state == 0 ? 0 : fail_row[c];
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return 1;
+}
+
+singbox_errcat_t* singbox_errcat_build(const singbox_error_signature_t* signatures, size_t count) {
+    if (!signatures || count == 0 || count > INT16_MAX) {
+        return NULL;
+    }
+
+    singbox_errcat_t* cat = calloc(1, sizeof(*cat));
+    if (!cat) {
+        return NULL;
+    }
+    cat->signatures = signatures;
+    cat->signature_count = count;
+
+    size_t max_states = 1;
+    cat->rank = malloc(count * sizeof(uint32_t));
+    if (!cat->rank) {
+        free(cat);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t length = strlen(signatures[i].pattern);
+        max_states += length;
+        cat->rank[i] = ((uint32_t)signatures[i].priority << 16) | (uint32_t)(length > 0xffff ? 0xffff : length);
+    }
+    if (max_states > MAX_STATES || !build_alphabet(cat)) {
+        singbox_errcat_free(cat);
+        return NULL;
+    }
+
+    cat->next = calloc(max_states * cat->alphabet, sizeof(uint16_t));
+    cat->output = malloc(max_states * sizeof(int16_t));
+    cat->local_output = malloc(max_states * sizeof(int16_t));
+    cat->context = calloc(max_states, sizeof(uint8_t));
+    if (!cat->next || !cat->output || !cat->local_output || !cat->context) {
+        singbox_errcat_free(cat);
+        return NULL;
+    }
+    for (size_t i = 0; i < max_states; i++) {
+        cat->output[i] = -1;
+        cat->local_output[i] = -1;
+    }
+
+    if (!build_trie(cat, max_states) || !build_failure_links(cat)) {
+        singbox_errcat_free(cat);
+        return NULL;
+    }
+    return cat;
+}
+
+void singbox_errcat_free(singbox_errcat_t* categorizer) {
+    if (!categorizer) {
+        return;
+    }
+    free(categorizer->rank);
+    free(categorizer->next);
+    free(categorizer->output);
+    free(categorizer->local_output);
+    free(categorizer->context);
+    free(categorizer);
+}
+
+static singbox_errcat_t* default_categorizer = NULL;
+static pthread_mutex_t default_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+const singbox_errcat_t* singbox_errcat_default(void) {
+    singbox_errcat_t* categorizer = __atomic_load_n(&default_categorizer, __ATOMIC_ACQUIRE);
+    if (categorizer) {
+        return categorizer;
+    }
+    pthread_mutex_lock(&default_mutex);
+    categorizer = default_categorizer;
+    if (!categorizer) {
+        categorizer = singbox_errcat_build(builtin_signatures,
+                                           sizeof(builtin_signatures) / sizeof(builtin_signatures[0]));
+        __atomic_store_n(&default_categorizer, categorizer, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&default_mutex);
+    return categorizer;
+}
+
+void singbox_errcat_release_default(void) {
+    pthread_mutex_lock(&default_mutex);
+    singbox_errcat_t* categorizer = __atomic_exchange_n(&default_categorizer, NULL, __ATOMIC_ACQ_REL);
+    pthread_mutex_unlock(&default_mutex);
+    singbox_errcat_free(categorizer);
+}
+
+int singbox_errcat_classify(const singbox_errcat_t* categorizer, const char* text, size_t length,
+                            singbox_error_class_t* result) {
+    int best = -1;
+    uint32_t matches = 0;
+
+    if (categorizer && text) {
+        const uint16_t* next = categorizer->next;
+        const int16_t* output = categorizer->output;
+        const uint8_t* byte_class = categorizer->byte_class;
+        size_t alphabet = categorizer->alphabet;
+        size_t state = 0;
+        int best_local = -1;
+        unsigned context = 0;
+
+        for (size_t i = 0; i < length; i++) {
+            state = next[state * alphabet + byte_class[(unsigned char)text[i]]];
+            int found = output[state];
+            if (found >= 0) {
+                matches++;
+                if (better(categorizer, found, best)) {
+                    best = found;
+                }
+                int local = categorizer->local_output[state];
+                if (local >= 0 && better(categorizer, local, best_local)) {
+                    best_local = local;
+                }
+                context |= categorizer->context[state];
+            }
+        }
+        if (context == CONTEXT_CONNECTION) {
+            // About one connection, not the tunnel: GLOBAL signatures do not apply
+            best = best_local;
+        }
+    }
+
+    if (result) {
+        if (best >= 0) {
+            const singbox_error_signature_t* signature = &categorizer->signatures[best];
+            result->category = (singbox_error_category_t)signature->category;
+            result->severity = (singbox_error_severity_t)signature->severity;
+            result->recoverable = signature->recoverable;
+        } else {
+            result->category = SINGBOX_ERRCAT_UNKNOWN;
+            result->severity = SINGBOX_ERRSEV_ERROR;
+            result->recoverable = 0;
+        }
+        result->signature = best;
+        result->matches = matches;
+    }
+    return best >= 0;
+}
+
+const char* singbox_errcat_pattern(const singbox_errcat_t* categorizer, int signature) {
+    if (!categorizer || signature < 0 || (size_t)signature >= categorizer->signature_count) {
+        return NULL;
+    }
+    return categorizer->signatures[signature].pattern;
+}
+
+size_t singbox_errcat_state_count(const singbox_errcat_t* categorizer) {
+    return categorizer ? categorizer->states : 0;
+}
+
+const singbox_error_signature_t* singbox_errcat_builtin_signatures(size_t* count) {
+    if (count) {
+        *count = sizeof(builtin_signatures) / sizeof(builtin_signatures[0]);
+    }
+    return builtin_signatures;
+}
+
+static const char* category_names[SINGBOX_ERRCAT_COUNT] = {
+    "unknown", "initialization", "configuration", "network", "timeout", "authentication",
+    "protocol", "tun", "permission", "library", "resource", "crash"
+};
+
+static const char* category_codes[SINGBOX_ERRCAT_COUNT] = {
+    "UNKNOWN", "INIT_FAILED", "CONFIG_INVALID", "CONNECTION_FAILED", "TIMEOUT", "AUTH_FAILED",
+    "PROTOCOL_ERROR", "TUN_SETUP_FAILED", "PERMISSION_DENIED", "LIBRARY_NOT_FOUND",
+    "RESOURCE_EXHAUSTED", "PROCESS_CRASHED"
+};
+
+static const char* severity_names[] = { "info", "warning", "error", "critical" };
+
+const char* singbox_error_category_name(int category) {
+    return (category >= 0 && category < SINGBOX_ERRCAT_COUNT) ? category_names[category] : "unknown";
+}
+
+const char* singbox_error_category_code(int category) {
+    return (category >= 0 && category < SINGBOX_ERRCAT_COUNT) ? category_codes[category] : "UNKNOWN";
+}
+
+const char* singbox_error_severity_name(int severity) {
+    return (severity >= 0 && severity <= SINGBOX_ERRSEV_CRITICAL) ? severity_names[severity] : "error";
+}
@@ -0,0 +1,151 @@
+#ifndef SING_BOX_ERRCAT_H
+#define SING_BOX_ERRCAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Error line categorizer.
+ *
+ * All known sing-box error signatures are compiled into a single
+ * Aho-Corasick automaton with precomputed failure transitions, so a line is
+ * classified in one left-to-right pass with one table lookup per byte no
+ * matter how many signatures exist. Matching is ASCII case-insensitive.
+ *
+ * When several signatures occur in the same line the one with the highest
+ * priority wins (longer pattern on ties), which lets specific signatures such
+ * as "tls handshake timeout" override generic ones such as "tls handshake".
+ *
+ * Lines about a single connection ("dial tcp", "process connection from",
+ * "outbound/...") only consider signatures that are not GLOBAL, so a refused
+ * connection never reads as a tun or privilege failure of the whole tunnel.
+ *
+ * The category codes match the native error codes understood by
+ * SingboxErrorFactory.fromNativeError on the Dart side.
+ */
+
+typedef enum {
+    SINGBOX_ERRCAT_UNKNOWN = 0,
+    SINGBOX_ERRCAT_INITIALIZATION,
+    SINGBOX_ERRCAT_CONFIGURATION,
+    SINGBOX_ERRCAT_NETWORK,
+    SINGBOX_ERRCAT_TIMEOUT,
+    SINGBOX_ERRCAT_AUTHENTICATION,
+    SINGBOX_ERRCAT_PROTOCOL,
+    SINGBOX_ERRCAT_TUN,
+    SINGBOX_ERRCAT_PERMISSION,
+    SINGBOX_ERRCAT_LIBRARY,
+    SINGBOX_ERRCAT_RESOURCE,
+    SINGBOX_ERRCAT_CRASH,
+    SINGBOX_ERRCAT_COUNT
+} singbox_error_category_t;
+
+typedef enum {
+    SINGBOX_ERRSEV_INFO = 0,
+    SINGBOX_ERRSEV_WARNING,
+    SINGBOX_ERRSEV_ERROR,
+    SINGBOX_ERRSEV_CRITICAL
+} singbox_error_severity_t;
+
+// Where a signature applies
+typedef enum {
+    SINGBOX_ERRSCOPE_ANY = 0,
+    SINGBOX_ERRSCOPE_GLOBAL,        // Ignored on per-connection lines
+    SINGBOX_ERRSCOPE_CONNECTION,    // Marks the line as per-connection
+    SINGBOX_ERRSCOPE_STARTUP        // Marks the line as startup, which wins over CONNECTION
+} singbox_error_scope_t;
+
+// One entry of a signature table; `pattern` must be lowercase
+typedef struct {
+    const char* pattern;
+    uint8_t category;           // singbox_error_category_t
+    uint8_t severity;           // singbox_error_severity_t
+    uint8_t recoverable;
+    uint8_t priority;           // Higher wins when several signatures match
+    uint8_t scope;              // singbox_error_scope_t
+} singbox_error_signature_t;
+
+typedef struct {
+    singbox_error_category_t category;
+    singbox_error_severity_t severity;
+    int recoverable;
+    int signature;              // Index of the winning signature, -1 if none
+    uint32_t matches;           // Positions where at least one signature ended
+} singbox_error_class_t;
+
+typedef struct singbox_errcat singbox_errcat_t;
+
+/**
+ * Compile a signature table into an automaton
+ * @param signatures Signature table (must outlive the automaton)
+ * @param count Number of entries
+ * @return Automaton or NULL on allocation failure or an oversized table
+ */
+singbox_errcat_t* singbox_errcat_build(const singbox_error_signature_t* signatures, size_t count);
+
+/**
+ * Release an automaton created with singbox_errcat_build()
+ */
+void singbox_errcat_free(singbox_errcat_t* categorizer);
+
+/**
+ * Shared automaton for the built-in sing-box signature table, built on first use
+ */
+const singbox_errcat_t* singbox_errcat_default(void);
+
+/**
+ * Free the shared automaton; the next singbox_errcat_default() builds it
+ * again. No classification may be running (core cleanup)
+ */
+void singbox_errcat_release_default(void);
+
+/**
+ * Classify one line in a single pass
+ * @param categorizer Compiled automaton
+ * @param text Line text (need not be NUL terminated)
+ * @param length Line length
+ * @param result Classification; UNKNOWN/ERROR/not recoverable when nothing matched
+ * @return 1 if a signature matched, 0 otherwise
+ */
+int singbox_errcat_classify(const singbox_errcat_t* categorizer, const char* text, size_t length,
+                            singbox_error_class_t* result);
+
+/**
+ * Pattern of a signature index reported in singbox_error_class_t, or NULL
+ */
+const char* singbox_errcat_pattern(const singbox_errcat_t* categorizer, int signature);
+
+/**
+ * Number of automaton states (for diagnostics and benchmarks)
+ */
+size_t singbox_errcat_state_count(const singbox_errcat_t* categorizer);
+
+/**
+ * Built-in signature table
+ */
+const singbox_error_signature_t* singbox_errcat_builtin_signatures(size_t* count);
+
+/**
+ * Stable lowercase category name ("network", "tun", ...)
+ */
+const char* singbox_error_category_name(int category);
+
+/**
+ * Native error code for a category ("CONNECTION_FAILED", "TIMEOUT", ...)
+ */
+const char* singbox_error_category_code(int category);
+
+/**
+ * Severity name ("info", "warning", "error", "critical")
+ */
+const char* singbox_error_severity_name(int severity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_ERRCAT_H
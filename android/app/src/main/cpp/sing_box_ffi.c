@@ -0,0 +1,122 @@
+#include <stdio.h>
+
+#include "sing_box_config.h"
+#include "sing_box_core.h"
+#include "sing_box_ffi.h"
+#include "sing_box_logging.h"
+
+/*
+ * dart:ffi entry points over sing_box_core.c; like sing_box_jni.c this
+ * layer only adapts arguments and results.
+ */
+
+uint32_t tunnelmax_core_abi_version(void) {
+    return TUNNELMAX_CORE_ABI_VERSION;
+}
+
+int32_t tunnelmax_core_init(const char* work_dir, const char* binary) {
+    return tunnelmax_core_init_desktop(work_dir, binary, NULL);
+}
+
+int32_t tunnelmax_core_init_desktop(const char* work_dir, const char* binary, const char* tun_interface) {
+    if (singbox_core_is_initialized()) {
+        return 1;
+    }
+
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    // The core copies the paths, so these only need to outlive the call
+    char config_path[512];
+    char log_file_path[512];
+    if (work_dir) {
+        int config_length = snprintf(config_path, sizeof(config_path), "%s/singbox_config.json", work_dir);
+        int log_length = snprintf(log_file_path, sizeof(log_file_path), "%s/singbox_native.slog", work_dir);
+        if (config_length < 0 || (size_t)config_length >= sizeof(config_path) ||
+            log_length < 0 || (size_t)log_length >= sizeof(log_file_path)) {
+            return 0;
+        }
+        options.config_path = config_path;
+        options.log_file_path = log_file_path;
+    }
+    if (binary) {
+        options.binaries[0] = binary;
+        options.binaries[1] = NULL;
+    }
+    options.tun_interface = tun_interface;
+    return singbox_core_init(&options) ? 1 : 0;
+}
+
+int32_t tunnelmax_core_start(const char* config, size_t length, int32_t tun_fd) {
+    if (!config) {
+        return 0;
+    }
+    return singbox_core_start_buffer(config, length, tun_fd) ? 1 : 0;
+}
+
+int32_t tunnelmax_core_stop(void) {
+    return singbox_core_stop() ? 1 : 0;
+}
+
+int32_t tunnelmax_core_update_config(const char* config, size_t length) {
+    if (!config) {
+        return 0;
+    }
+    return singbox_core_update_config_buffer(config, length) ? 1 : 0;
+}
+
+int32_t tunnelmax_core_validate_config(const char* config, size_t length) {
+    if (!config) {
+        return 0;
+    }
+    return singbox_config_validate(config, length, 0, NULL) ? 1 : 0;
+}
+
+void tunnelmax_core_cleanup(void) {
+    singbox_core_cleanup();
+}
+
+int32_t tunnelmax_core_state(void) {
+    return (int32_t)singbox_core_state();
+}
+
+int32_t tunnelmax_core_is_running(void) {
+    return singbox_core_is_running() ? 1 : 0;
+}
+
+int32_t tunnelmax_core_pid(void) {
+    return singbox_core_pid();
+}
+
+const singbox_stats_shared_t* tunnelmax_core_stats_region(void) {
+    return singbox_core_stats_region();
+}
+
+int32_t tunnelmax_core_read_stats(singbox_stats_values_t* out) {
+    if (!out) {
+        return 0;
+    }
+    return singbox_stats_shared_read(singbox_core_stats_region(), out);
+}
+
+const singbox_logtail_t* tunnelmax_core_log_tail(uint64_t* size) {
+    size_t region_size = 0;
+    const singbox_logtail_t* region = singbox_logging_tail_region(&region_size);
+    if (size) {
+        *size = region_size;
+    }
+    return region;
+}
+
+int32_t tunnelmax_core_format_detailed_stats(char* out, size_t size) {
+    if (!out) {
+        return -1;
+    }
+    return singbox_core_format_detailed_stats(out, size);
+}
+
+int32_t tunnelmax_core_format_process_stats(char* out, size_t size) {
+    if (!out) {
+        return -1;
+    }
+    return singbox_core_format_process_stats(out, size);
+}
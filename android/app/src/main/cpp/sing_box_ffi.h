@@ -0,0 +1,142 @@
+#ifndef SING_BOX_FFI_H
+#define SING_BOX_FFI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sing_box_logtail.h"
+#include "sing_box_statsmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * C ABI of the native core for dart:ffi (libtunnelmax_core).
+ *
+ * The method channel path encodes every stats, status and log query as a
+ * map, hops to the platform thread and decodes it again in Dart. Through
+ * this ABI Dart reads the same data straight from the shared regions the
+ * core already publishes (sing_box_statsmem.h, sing_box_logtail.h): the
+ * region pointers are looked up once and every later read is a handful of
+ * loads, with no call into native code at all.
+ *
+ * On Linux desktop the core is built as libtunnelmax_core.so
+ * (linux/core/CMakeLists.txt). On Android the same symbols are exported by
+ * libsing_box_jni.so, so Dart reads the very core the VPN service drives
+ * instead of a second, idle copy.
+ *
+ * Only fixed-width types cross the boundary. Bump TUNNELMAX_CORE_ABI_VERSION
+ * when a signature or the meaning of a result changes; region layouts carry
+ * versions of their own.
+ */
+
+#define TUNNELMAX_CORE_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define TUNNELMAX_EXPORT __declspec(dllexport)
+#else
+#define TUNNELMAX_EXPORT __attribute__((visibility("default")))
+#endif
+
+/**
+ * TUNNELMAX_CORE_ABI_VERSION of the loaded library; check before any other call
+ */
+TUNNELMAX_EXPORT uint32_t tunnelmax_core_abi_version(void);
+
+/**
+ * Initialize the core for a desktop host: the configuration and the native
+ * log are kept in `work_dir` and sing-box is spawned from `binary`. Either
+ * may be NULL for the Android defaults. A no-op when already initialized
+ * (always the case on Android, where the service does it).
+ * @return 1 on success
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_init(const char* work_dir, const char* binary);
+
+/**
+ * tunnelmax_core_init for a host where sing-box opens the TUN device itself:
+ * start is then called with tun_fd -1 and the traffic is counted on
+ * `tun_interface` (the tun inbound's interface_name) once it comes up
+ * @return 1 on success
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_init_desktop(const char* work_dir, const char* binary,
+                                                     const char* tun_interface);
+
+/**
+ * Start sing-box from `length` bytes of UTF-8 JSON
+ * @return 1 if running, 0 on failure
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_start(const char* config, size_t length, int32_t tun_fd);
+
+/**
+ * @return 1 once stopped
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_stop(void);
+
+/**
+ * Replace the configuration of the running instance
+ * @return 0 if sing-box is not running or the config is not valid JSON
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_update_config(const char* config, size_t length);
+
+/**
+ * Check that `length` bytes are one well-formed JSON object in UTF-8, as
+ * start does before anything is spawned
+ * @return 1 if valid
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_validate_config(const char* config, size_t length);
+
+TUNNELMAX_EXPORT void tunnelmax_core_cleanup(void);
+
+/**
+ * singbox_core_state_t of the core; never blocks
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_state(void);
+
+/**
+ * Whether sing-box runs and its process is alive; never blocks
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_is_running(void);
+
+/**
+ * Process id of the sing-box child, 0 when none runs; the host watches it
+ * (pidfd) to notice a crash without polling
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_pid(void);
+
+/**
+ * The shared statistics region (SINGBOX_STATS_REGION_SIZE bytes). Stable for
+ * the life of the process; read it with the seqlock protocol of
+ * sing_box_statsmem.h.
+ */
+TUNNELMAX_EXPORT const singbox_stats_shared_t* tunnelmax_core_stats_region(void);
+
+/**
+ * Copy a consistent snapshot of the statistics region, for callers that
+ * would rather not implement the seqlock
+ * @return 1 on success, 0 if a writer kept the region busy
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_read_stats(singbox_stats_values_t* out);
+
+/**
+ * The log tail ring; its size in bytes (header included) is stored in `size`
+ */
+TUNNELMAX_EXPORT const singbox_logtail_t* tunnelmax_core_log_tail(uint64_t* size);
+
+/**
+ * The detailed statistics as JSON, for the rare query that needs them
+ * @return Length written, or -1 if sing-box is not running or `size` is too small
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_format_detailed_stats(char* out, size_t size);
+
+/**
+ * Memory, CPU and descriptor usage of the sing-box process from /proc as JSON
+ * @return Length written, or -1 if sing-box is not running or `size` is too small
+ */
+TUNNELMAX_EXPORT int32_t tunnelmax_core_format_process_stats(char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_FFI_H
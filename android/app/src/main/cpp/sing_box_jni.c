@@ -2,11 +2,11 @@
 #include <android/log.h>
 #include <string.h>
 #include <stdlib.h>
-#include <dlfcn.h>
-#include <unistd.h>
-#include <pthread.h>
-#include <stdarg.h>
+#include "sing_box_config.h"
+#include "sing_box_core.h"
 #include "sing_box_logging.h"
+#include "sing_box_notify_jni.h"
+#include "sing_box_procstat.h"
 
 #define TAG "SingBoxJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
@@ -14,333 +14,84 @@
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
 
-// Global state
-static void* singbox_handle = NULL;
-static pthread_mutex_t singbox_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int is_initialized = 0;
-static int is_running = 0;
-static char* current_config = NULL;
+/*
+ * Thin JNI layer over sing_box_core.c.
+ *
+ * Lifecycle calls serialise on the core's lifecycle lock; every read-side
+ * call (running state, stats, logs) is answered without it, so a UI poll
+ * never waits behind a start or a stop that is sleeping on sing-box.
+ */
 
-// Real sing-box integration
-// The sing-box binary doesn't export C functions, so we need to interface with it properly
-// We'll use process management to run sing-box as a subprocess
-
-#include <sys/wait.h>
-#include <signal.h>
-
-static pid_t singbox_pid = 0;
-static char* config_file_path = NULL;
-
-// Real sing-box implementation functions
-static int real_singbox_init() {
-    LOGI("Initializing real sing-box");
-    
-    // Create a temporary directory for config files
-    config_file_path = malloc(256);
-    if (!config_file_path) {
-        LOGE("Failed to allocate memory for config path");
-        return 0;
-    }
-    
-    // Use Android's cache directory for config files
-    strcpy(config_file_path, "/data/data/com.tunnelmax.vpnclient/cache/singbox_config.json");
-    
-    LOGI("Sing-box initialized with config path: %s", config_file_path);
-    return 1;
-}
-
-static int real_singbox_start(const char* config, int tun_fd) {
-    LOGI("Starting real sing-box with config length: %zu, tun_fd: %d", 
-         config ? strlen(config) : 0, tun_fd);
-    
-    if (!config || strlen(config) == 0) {
-        LOGE("Invalid configuration provided");
-        return 0;
-    }
-    
-    if (tun_fd < 0) {
-        LOGE("Invalid TUN file descriptor: %d", tun_fd);
-        return 0;
-    }
-    
-    if (singbox_pid > 0) {
-        LOGI("Sing-box already running with PID: %d", singbox_pid);
-        return 1;
-    }
-    
-    // Write config to file
-    FILE* config_file = fopen(config_file_path, "w");
-    if (!config_file) {
-        LOGE("Failed to create config file: %s", config_file_path);
-        return 0;
-    }
-    
-    fprintf(config_file, "%s", config);
-    fclose(config_file);
-    
-    LOGI("Config written to: %s", config_file_path);
-    
-    // Fork and exec sing-box process
-    singbox_pid = fork();
-    if (singbox_pid == 0) {
-        // Child process - exec sing-box
-        char tun_fd_str[32];
-        snprintf(tun_fd_str, sizeof(tun_fd_str), "%d", tun_fd);
-        
-        // Set environment variable for TUN fd
-        setenv("SING_BOX_TUN_FD", tun_fd_str, 1);
-        
-        // Execute sing-box binary
-        // Note: The sing-box binary should be extracted from the .so file or available in the app
-        execl("/system/bin/sing-box", "sing-box", "run", "-c", config_file_path, NULL);
-        
-        // If execl fails, try alternative paths
-        execl("/data/data/com.tunnelmax.vpnclient/files/sing-box", "sing-box", "run", "-c", config_file_path, NULL);
-        
-        // If we get here, exec failed
-        LOGE("Failed to exec sing-box binary");
-        exit(1);
-    } else if (singbox_pid > 0) {
-        // Parent process
-        LOGI("Sing-box started with PID: %d", singbox_pid);
-        
-        // Give it a moment to start
-        usleep(500000); // 500ms
-        
-        // Check if process is still running
-        int status;
-        pid_t result = waitpid(singbox_pid, &status, WNOHANG);
-        if (result == singbox_pid) {
-            // Process has exited
-            LOGE("Sing-box process exited immediately with status: %d", status);
-            singbox_pid = 0;
-            return 0;
-        }
-        
-        is_running = 1;
-        LOGI("Sing-box started successfully");
-        return 1;
-    } else {
-        LOGE("Failed to fork sing-box process");
-        return 0;
-    }
-}
-
-static int real_singbox_stop() {
-    LOGI("Stopping real sing-box");
-    
-    if (singbox_pid <= 0) {
-        LOGI("Sing-box is not running");
-        return 1;
-    }
-    
-    // Send SIGTERM to sing-box process
-    if (kill(singbox_pid, SIGTERM) == 0) {
-        LOGI("Sent SIGTERM to sing-box process: %d", singbox_pid);
-        
-        // Wait for process to exit
-        int status;
-        int wait_count = 0;
-        while (wait_count < 10) { // Wait up to 5 seconds
-            pid_t result = waitpid(singbox_pid, &status, WNOHANG);
-            if (result == singbox_pid) {
-                LOGI("Sing-box process exited with status: %d", status);
-                singbox_pid = 0;
-                is_running = 0;
-                return 1;
-            }
-            usleep(500000); // 500ms
-            wait_count++;
-        }
-        
-        // If still running, force kill
-        LOGW("Sing-box didn't exit gracefully, sending SIGKILL");
-        if (kill(singbox_pid, SIGKILL) == 0) {
-            waitpid(singbox_pid, &status, 0);
-            LOGI("Sing-box process force killed");
-        }
-    } else {
-        LOGE("Failed to send signal to sing-box process: %d", singbox_pid);
-    }
-    
-    singbox_pid = 0;
-    is_running = 0;
-    LOGI("Sing-box stopped");
-    return 1;
-}
-
-static int real_singbox_is_running() {
-    if (singbox_pid <= 0) {
-        return 0;
+// JNI function implementations
+JNIEXPORT jboolean JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeInit(JNIEnv *env, jobject thiz) {
+    if (singbox_core_is_initialized()) {
+        return JNI_TRUE;
     }
     
-    // Check if process is still alive
-    int status;
-    pid_t result = waitpid(singbox_pid, &status, WNOHANG);
-    if (result == singbox_pid) {
-        // Process has exited
-        LOGI("Sing-box process has exited");
-        singbox_pid = 0;
-        is_running = 0;
-        return 0;
-    } else if (result == 0) {
-        // Process is still running
-        return 1;
+    LOGI("Initializing sing-box native layer");
+    int result = singbox_core_init(NULL);
+    if (result) {
+        LOGI("Sing-box initialized successfully");
     } else {
-        // Error occurred
-        LOGE("Error checking sing-box process status");
-        return 0;
-    }
-}
-
-static char* real_singbox_get_stats() {
-    if (!real_singbox_is_running()) {
-        return NULL;
-    }
-    
-    // For now, return mock statistics
-    // In a real implementation, you would query sing-box via its API
-    static long long total_upload = 0;
-    static long long total_download = 0;
-    static time_t last_update = 0;
-    
-    time_t current_time = time(NULL);
-    if (last_update == 0) {
-        last_update = current_time;
-    }
-    
-    // Simulate data transfer
-    long time_diff = current_time - last_update;
-    if (time_diff > 0) {
-        total_upload += (rand() % 1000 + 100) * time_diff;
-        total_download += (rand() % 2000 + 200) * time_diff;
-        last_update = current_time;
-    }
-    
-    // Calculate speeds (bytes per second)
-    double upload_speed = time_diff > 0 ? (double)(rand() % 1000 + 100) : 0;
-    double download_speed = time_diff > 0 ? (double)(rand() % 2000 + 200) : 0;
-    
-    // Create JSON response
-    char* stats_json = malloc(512);
-    if (stats_json) {
-        snprintf(stats_json, 512,
-            "{"
-            "\"upload_bytes\": %lld,"
-            "\"download_bytes\": %lld,"
-            "\"upload_speed\": %.2f,"
-            "\"download_speed\": %.2f,"
-            "\"connection_time\": %ld,"
-            "\"packets_sent\": %lld,"
-            "\"packets_received\": %lld"
-            "}",
-            total_upload,
-            total_download,
-            upload_speed,
-            download_speed,
-            current_time - (last_update - time_diff),
-            total_upload / 64,  // Approximate packets
-            total_download / 64
-        );
-    }
-    
-    return stats_json;
-}
-
-static void real_singbox_cleanup() {
-    LOGI("Cleaning up real sing-box");
-    
-    if (real_singbox_is_running()) {
-        real_singbox_stop();
-    }
-    
-    // Clean up config file
-    if (config_file_path) {
-        unlink(config_file_path);
-        free(config_file_path);
-        config_file_path = NULL;
-    }
-    
-    if (current_config) {
-        free(current_config);
-        current_config = NULL;
+        LOGE("Failed to initialize sing-box");
     }
+    return result ? JNI_TRUE : JNI_FALSE;
 }
 
-// JNI function implementations
 JNIEXPORT jboolean JNICALL
-Java_com_tunnelmax_vpnclient_SingboxManager_nativeInit(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (is_initialized) {
-        pthread_mutex_unlock(&singbox_mutex);
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeInitEmbedded(JNIEnv *env, jobject thiz, jstring library_path) {
+    if (singbox_core_is_initialized()) {
         return JNI_TRUE;
     }
+    if (!library_path) {
+        return JNI_FALSE;
+    }
     
-    LOGI("Initializing sing-box native layer");
-    
-    // Initialize logging system
-    singbox_logging_init();
-    SINGBOX_LOG_I("Sing-box logging system initialized");
+    const char* path = (*env)->GetStringUTFChars(env, library_path, NULL);
+    if (!path) {
+        return JNI_FALSE;
+    }
+    LOGI("Initializing sing-box native layer with embedded library: %s", path);
     
-    // Initialize sing-box directly
-    int result = real_singbox_init();
+    // sing-box runs in-process; the library is loaded on the first start
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    options.embedded_library = path;
+    int result = singbox_core_init(&options);
+    (*env)->ReleaseStringUTFChars(env, library_path, path);
     
-    if (result) {
-        is_initialized = 1;
-        LOGI("Sing-box initialized successfully");
-        SINGBOX_LOG_I("Sing-box core initialized successfully");
-    } else {
+    if (!result) {
         LOGE("Failed to initialize sing-box");
-        SINGBOX_LOG_E("Failed to initialize sing-box core");
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return result ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeStart(JNIEnv *env, jobject thiz, 
                                                         jstring config, jint tun_fd) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_initialized) {
+    if (!singbox_core_is_initialized()) {
         LOGE("Sing-box not initialized");
-        pthread_mutex_unlock(&singbox_mutex);
         return JNI_FALSE;
     }
     
-    if (is_running) {
+    if (singbox_core_state() == SINGBOX_CORE_RUNNING) {
         LOGI("Sing-box already running");
-        pthread_mutex_unlock(&singbox_mutex);
         return JNI_TRUE;
     }
     
     // Convert Java string to C string
-    const char* config_str = (*env)->GetStringUTFChars(env, config, NULL);
+    const char* config_str = config ? (*env)->GetStringUTFChars(env, config, NULL) : NULL;
     if (!config_str) {
         LOGE("Failed to get config string");
-        pthread_mutex_unlock(&singbox_mutex);
         return JNI_FALSE;
     }
     
     LOGI("Starting sing-box with tun_fd: %d", tun_fd);
     LOGD("Config: %s", config_str);
     
-    // Store current config
-    if (current_config) {
-        free(current_config);
-    }
-    current_config = malloc(strlen(config_str) + 1);
-    if (current_config) {
-        strcpy(current_config, config_str);
-    }
-    
-    // Start sing-box directly
-    int result = real_singbox_start(config_str, tun_fd);
-    
+    int result = singbox_core_start(config_str, tun_fd);
     if (result) {
-        is_running = 1;
         LOGI("Sing-box started successfully");
     } else {
         LOGE("Failed to start sing-box");
@@ -348,106 +99,95 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeStart(JNIEnv *env, jobject thi
     
     // Release the string
     (*env)->ReleaseStringUTFChars(env, config, config_str);
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return result ? JNI_TRUE : JNI_FALSE;
 }
 
+/**
+ * Address of the first `length` bytes of a direct ByteBuffer, or NULL
+ */
+static const char* direct_config(JNIEnv *env, jobject buffer, jint length) {
+    if (!buffer || length <= 0) {
+        return NULL;
+    }
+    const char* data = (*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (!data || capacity < length) {
+        LOGE("Config buffer is not direct or shorter than %d bytes", (int)length);
+        return NULL;
+    }
+    return data;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeStartBuffer(JNIEnv *env, jobject thiz,
+                                                              jobject config, jint length, jint tun_fd) {
+    // The UTF-8 bytes are validated and written out in place: no string
+    // conversion, no copy into native memory
+    const char* data = direct_config(env, config, length);
+    if (!data) {
+        return JNI_FALSE;
+    }
+    LOGI("Starting sing-box with tun_fd: %d", tun_fd);
+    return singbox_core_start_buffer(data, (size_t)length, tun_fd) ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeStop(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
+    if (singbox_core_state() == SINGBOX_CORE_STOPPED) {
         LOGI("Sing-box not running");
-        pthread_mutex_unlock(&singbox_mutex);
         return JNI_TRUE;
     }
     
     LOGI("Stopping sing-box");
-    
-    // Stop sing-box directly
-    int result = real_singbox_stop();
-    
+    int result = singbox_core_stop();
     if (result) {
-        is_running = 0;
         LOGI("Sing-box stopped successfully");
     } else {
         LOGE("Failed to stop sing-box");
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return result ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetStats(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
-        pthread_mutex_unlock(&singbox_mutex);
+    char stats[512];
+    if (singbox_core_format_stats(stats, sizeof(stats)) < 0) {
         return NULL;
     }
-    
-    // Get statistics from sing-box directly
-    char* stats_str = real_singbox_get_stats();
-    
-    jstring result = NULL;
-    if (stats_str) {
-        result = (*env)->NewStringUTF(env, stats_str);
-        free(stats_str);
-    }
-    
-    pthread_mutex_unlock(&singbox_mutex);
-    return result;
+    return (*env)->NewStringUTF(env, stats);
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetStatsBuffer(JNIEnv *env, jobject thiz) {
+    // Wraps static memory: fetched once, then polled without JNI calls
+    const singbox_stats_shared_t* region = singbox_core_stats_region();
+    return (*env)->NewDirectByteBuffer(env, (void*)region, (jlong)sizeof(*region));
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeIsRunning(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    // Check if running using real sing-box function
-    int running = real_singbox_is_running();
-    
-    pthread_mutex_unlock(&singbox_mutex);
-    return running ? JNI_TRUE : JNI_FALSE;
+    return singbox_core_is_running() ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT void JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeCleanup(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
     LOGI("Cleaning up sing-box native layer");
     
-    // Stop if running
-    if (is_running) {
-        real_singbox_stop();
-        is_running = 0;
-    }
-    
-    // Cleanup sing-box
-    real_singbox_cleanup();
+    singbox_core_cleanup();
+    singbox_notify_jni_set_listener(env, NULL, 0);
     
-    // Free resources
-    if (current_config) {
-        free(current_config);
-        current_config = NULL;
-    }
-    
-    // Close library handle
-    if (singbox_handle) {
-        dlclose(singbox_handle);
-        singbox_handle = NULL;
-    }
-    
-    is_initialized = 0;
-    
-    pthread_mutex_unlock(&singbox_mutex);
     LOGI("Sing-box native cleanup completed");
 }
 
 // JNI_OnLoad - called when the library is loaded
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
     LOGI("Sing-box JNI library loaded");
+    
+    JNIEnv* env = NULL;
+    if ((*vm)->GetEnv(vm, (void**)&env, JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    singbox_notify_jni_on_load(vm, env);
     return JNI_VERSION_1_6;
 }
 
@@ -455,20 +195,10 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
 JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved) {
     LOGI("Sing-box JNI library unloaded");
     
-    // Cleanup resources
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (current_config) {
-        free(current_config);
-        current_config = NULL;
-    }
-    
-    if (singbox_handle) {
-        dlclose(singbox_handle);
-        singbox_handle = NULL;
+    JNIEnv* env = NULL;
+    if ((*vm)->GetEnv(vm, (void**)&env, JNI_VERSION_1_6) == JNI_OK) {
+        singbox_notify_jni_on_unload(env);
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
 }
 
 // Additional JNI methods that were missing
@@ -484,12 +214,13 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeValidateConfig(JNIEnv *env, jo
         return JNI_FALSE;
     }
     
-    // Basic validation - check if it's valid JSON-like structure
-    jboolean result = JNI_TRUE;
-    if (strlen(config_str) < 10 || 
-        (strstr(config_str, "{") == NULL) || 
-        (strstr(config_str, "}") == NULL)) {
-        result = JNI_FALSE;
+    // Full JSON and encoding check, in place
+    singbox_config_error_t error;
+    jsize length = (*env)->GetStringUTFLength(env, config);
+    jboolean result = singbox_config_validate(config_str, (size_t)length, SINGBOX_CONFIG_MODIFIED_UTF8, &error)
+        ? JNI_TRUE : JNI_FALSE;
+    if (!result) {
+        LOGW("Invalid configuration at line %u, column %u: %s", error.line, error.column, error.message);
     }
     
     (*env)->ReleaseStringUTFChars(env, config, config_str);
@@ -504,53 +235,22 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetVersion(JNIEnv *env, jobjec
 
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetDetailedStats(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
-        pthread_mutex_unlock(&singbox_mutex);
+    char detailed_stats[3072];
+    if (singbox_core_format_detailed_stats(detailed_stats, sizeof(detailed_stats)) < 0) {
         return NULL;
     }
-    
-    // Return detailed mock statistics
-    const char* detailed_stats = "{"
-        "\"bytesReceived\": 2048,"
-        "\"bytesSent\": 1024,"
-        "\"downloadSpeed\": 256.5,"
-        "\"uploadSpeed\": 128.2,"
-        "\"packetsReceived\": 150,"
-        "\"packetsSent\": 100,"
-        "\"connectionDuration\": 30,"
-        "\"latency\": 45,"
-        "\"jitter\": 5,"
-        "\"packetLoss\": 0.1"
-        "}";
-    
-    jstring result = (*env)->NewStringUTF(env, detailed_stats);
-    pthread_mutex_unlock(&singbox_mutex);
-    return result;
+    return (*env)->NewStringUTF(env, detailed_stats);
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeResetStats(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
-        pthread_mutex_unlock(&singbox_mutex);
-        return JNI_FALSE;
-    }
-    
-    LOGI("Resetting statistics");
-    // In a real implementation, this would reset the statistics counters
-    
-    pthread_mutex_unlock(&singbox_mutex);
-    return JNI_TRUE;
+    return singbox_core_reset_stats() ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jboolean JNICALL
-Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetStatsCallback(JNIEnv *env, jobject thiz, jlong callback) {
-    LOGI("Setting stats callback: %ld", callback);
-    // In a real implementation, this would set up a callback for real-time stats
-    return JNI_TRUE;
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetStatsCallback(JNIEnv *env, jobject thiz, jobject listener, jint interval_ms) {
+    LOGI("Setting stats callback: %s", listener ? "listener" : "none");
+    return singbox_notify_jni_set_listener(env, listener, interval_ms) ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jstring JNICALL
@@ -573,9 +273,7 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetLogLevel(JNIEnv *env, jobje
 
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetLogs(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    // Get logs from the logging system
+    // Formatting only takes the log buffer lock, never the lifecycle lock
     char* logs_json = singbox_get_logs_json();
     
     jstring result = NULL;
@@ -587,36 +285,84 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetLogs(JNIEnv *env, jobject t
         const char* empty_logs = "{\"logs\":[]}";
         result = (*env)->NewStringUTF(env, empty_logs);
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return result;
 }
 
+JNIEXPORT jobject JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetLogTailBuffer(JNIEnv *env, jobject thiz) {
+    // Static memory like the stats region: fetched once, then tailed without JNI calls
+    size_t size = 0;
+    const singbox_logtail_t* region = singbox_logging_tail_region(&size);
+    if (!region) {
+        return NULL;
+    }
+    return (*env)->NewDirectByteBuffer(env, (void*)region, (jlong)size);
+}
+
 JNIEXPORT jstring JNICALL
-Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetMemoryUsage(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeQueryLogs(JNIEnv *env, jobject thiz, jstring query, jint offset, jint limit) {
+    const char* query_str = query ? (*env)->GetStringUTFChars(env, query, NULL) : NULL;
     
-    // Return mock memory usage statistics
-    const char* memory_json = "{"
-        "\"total_memory_mb\": 512,"
-        "\"used_memory_mb\": 64,"
-        "\"cpu_usage_percent\": 5.2,"
-        "\"open_file_descriptors\": 15"
-        "}";
+    // Filtering runs under the log buffer lock only, not the lifecycle lock
+    char* result_json = singbox_query_logs_json(query_str, offset, limit);
+    
+    if (query_str) {
+        (*env)->ReleaseStringUTFChars(env, query, query_str);
+    }
     
-    jstring result = (*env)->NewStringUTF(env, memory_json);
-    pthread_mutex_unlock(&singbox_mutex);
+    jstring result = NULL;
+    if (result_json) {
+        result = (*env)->NewStringUTF(env, result_json);
+        free(result_json);
+    }
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetMemoryUsage(JNIEnv *env, jobject thiz) {
+    char memory_json[1536];
+    if (singbox_core_format_process_stats(memory_json, sizeof(memory_json)) < 0) {
+        return NULL;
+    }
+    return (*env)->NewStringUTF(env, memory_json);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetProcessHistory(JNIEnv *env, jobject thiz) {
+    // Up to SINGBOX_PROCSTAT_DEFAULT_HISTORY points of ~110 bytes
+    size_t size = 128 * SINGBOX_PROCSTAT_DEFAULT_HISTORY + 16;
+    char* history_json = malloc(size);
+    if (!history_json) {
+        return NULL;
+    }
+    jstring result = NULL;
+    if (singbox_core_format_process_history(history_json, size) >= 0) {
+        result = (*env)->NewStringUTF(env, history_json);
+    }
+    free(history_json);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetAppUsage(JNIEnv *env, jobject thiz) {
+    // Header plus up to 64 UIDs of ~160 bytes
+    size_t size = 256 + 64 * 176;
+    char* usage_json = malloc(size);
+    if (!usage_json) {
+        return NULL;
+    }
+    jstring result = NULL;
+    if (singbox_core_format_app_usage(usage_json, size) >= 0) {
+        result = (*env)->NewStringUTF(env, usage_json);
+    }
+    free(usage_json);
     return result;
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeOptimizePerformance(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
     LOGI("Optimizing performance");
     // In a real implementation, this would optimize sing-box performance settings
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return JNI_TRUE;
 }
 
@@ -626,16 +372,12 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeHandleNetworkChange(JNIEnv *en
         return JNI_FALSE;
     }
     
-    pthread_mutex_lock(&singbox_mutex);
-    
     const char* network_str = (*env)->GetStringUTFChars(env, networkInfo, NULL);
     if (network_str) {
         LOGI("Handling network change: %s", network_str);
         // In a real implementation, this would adapt sing-box to network changes
         (*env)->ReleaseStringUTFChars(env, networkInfo, network_str);
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
     return JNI_TRUE;
 }
 
@@ -645,41 +387,33 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeUpdateConfiguration(JNIEnv *en
         return JNI_FALSE;
     }
     
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
+    if (singbox_core_state() != SINGBOX_CORE_RUNNING) {
         LOGE("Cannot update configuration - not running");
-        pthread_mutex_unlock(&singbox_mutex);
         return JNI_FALSE;
     }
     
     const char* config_str = (*env)->GetStringUTFChars(env, config, NULL);
-    if (config_str) {
-        LOGI("Updating configuration");
-        // In a real implementation, this would hot-reload the configuration
-        
-        // Update stored config
-        if (current_config) {
-            free(current_config);
-        }
-        current_config = malloc(strlen(config_str) + 1);
-        if (current_config) {
-            strcpy(current_config, config_str);
-        }
-        
-        (*env)->ReleaseStringUTFChars(env, config, config_str);
+    if (!config_str) {
+        return JNI_FALSE;
     }
-    
-    pthread_mutex_unlock(&singbox_mutex);
-    return JNI_TRUE;
+    int result = singbox_core_update_config(config_str);
+    (*env)->ReleaseStringUTFChars(env, config, config_str);
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeUpdateConfigurationBuffer(JNIEnv *env, jobject thiz,
+                                                                            jobject config, jint length) {
+    const char* data = direct_config(env, config, length);
+    if (!data) {
+        return JNI_FALSE;
+    }
+    return singbox_core_update_config_buffer(data, (size_t)length) ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetConnectionInfo(JNIEnv *env, jobject thiz) {
-    pthread_mutex_lock(&singbox_mutex);
-    
-    if (!is_running) {
-        pthread_mutex_unlock(&singbox_mutex);
+    if (singbox_core_state() != SINGBOX_CORE_RUNNING) {
         return NULL;
     }
     
@@ -694,7 +428,5 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetConnectionInfo(JNIEnv *env,
         "\"last_ping_ms\": 45"
         "}";
     
-    jstring result = (*env)->NewStringUTF(env, connection_json);
-    pthread_mutex_unlock(&singbox_mutex);
-    return result;
-}
\ No newline at end of file
+    return (*env)->NewStringUTF(env, connection_json);
+}
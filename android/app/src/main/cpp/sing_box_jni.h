@@ -11,6 +11,9 @@ extern "C" {
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeInit(JNIEnv *env, jobject thiz);
 
+JNIEXPORT jboolean JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeInitEmbedded(JNIEnv *env, jobject thiz, jstring library_path);
+
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeStart(JNIEnv *env, jobject thiz, 
                                                         jstring config, jint tun_fd);
@@ -21,6 +24,9 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeStop(JNIEnv *env, jobject thiz
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetStats(JNIEnv *env, jobject thiz);
 
+JNIEXPORT jobject JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetStatsBuffer(JNIEnv *env, jobject thiz);
+
 JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeIsRunning(JNIEnv *env, jobject thiz);
 
@@ -42,6 +48,9 @@ Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetLogLevel(JNIEnv *env, jobje
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetLogs(JNIEnv *env, jobject thiz);
 
+JNIEXPORT jstring JNICALL
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeQueryLogs(JNIEnv *env, jobject thiz, jstring query, jint offset, jint limit);
+
 JNIEXPORT jstring JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeGetMemoryUsage(JNIEnv *env, jobject thiz);
 
@@ -64,7 +73,7 @@ JNIEXPORT jboolean JNICALL
 Java_com_tunnelmax_vpnclient_SingboxManager_nativeResetStats(JNIEnv *env, jobject thiz);
 
 JNIEXPORT jboolean JNICALL
-Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetStatsCallback(JNIEnv *env, jobject thiz, jlong callback);
+Java_com_tunnelmax_vpnclient_SingboxManager_nativeSetStatsCallback(JNIEnv *env, jobject thiz, jobject listener, jint interval_ms);
 
 #ifdef __cplusplus
 }
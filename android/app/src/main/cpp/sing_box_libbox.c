@@ -0,0 +1,97 @@
+#include "sing_box_libbox.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int (*abi_version_fn)(void);
+typedef const char* (*version_fn)(void);
+typedef int (*start_fn)(const char*, size_t, int, const singbox_libbox_callbacks_t*, char*, size_t);
+typedef int (*stop_fn)(void);
+
+struct singbox_libbox {
+    void* handle;
+    version_fn version;
+    start_fn start;
+    stop_fn stop;
+};
+
+static void set_error(char* error, size_t size, const char* format, const char* detail) {
+    if (error && size > 0) {
+        snprintf(error, size, format, detail ? detail : "unknown error");
+    }
+}
+
+singbox_libbox_t* singbox_libbox_open(const char* path, char* error, size_t error_size) {
+    if (!path) {
+        set_error(error, error_size, "%s", "no library path");
+        return NULL;
+    }
+    
+    // RTLD_LOCAL: the Go runtime inside must not interpose on our symbols
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        set_error(error, error_size, "dlopen failed: %s", dlerror());
+        return NULL;
+    }
+    
+    abi_version_fn abi_version = (abi_version_fn)dlsym(handle, "libbox_abi_version");
+    singbox_libbox_t lib = {
+        handle,
+        (version_fn)dlsym(handle, "libbox_version"),
+        (start_fn)dlsym(handle, "libbox_start"),
+        (stop_fn)dlsym(handle, "libbox_stop"),
+    };
+    if (!abi_version || !lib.version || !lib.start || !lib.stop) {
+        set_error(error, error_size, "%s does not export the libbox ABI", path);
+        dlclose(handle);
+        return NULL;
+    }
+    int version = abi_version();
+    if (version != SINGBOX_LIBBOX_ABI_VERSION) {
+        char detail[32];
+        snprintf(detail, sizeof(detail), "%d", version);
+        set_error(error, error_size, "unsupported libbox ABI version %s", detail);
+        dlclose(handle);
+        return NULL;
+    }
+    
+    singbox_libbox_t* result = malloc(sizeof(*result));
+    if (!result) {
+        set_error(error, error_size, "%s", "out of memory");
+        dlclose(handle);
+        return NULL;
+    }
+    *result = lib;
+    return result;
+}
+
+void singbox_libbox_close(singbox_libbox_t* lib) {
+    if (!lib) {
+        return;
+    }
+    dlclose(lib->handle);
+    free(lib);
+}
+
+const char* singbox_libbox_version(const singbox_libbox_t* lib) {
+    const char* version = lib ? lib->version() : NULL;
+    return version ? version : "unknown";
+}
+
+int singbox_libbox_start(singbox_libbox_t* lib, const char* config, size_t config_length, int tun_fd,
+                         const singbox_libbox_callbacks_t* callbacks, char* error, size_t error_size) {
+    if (error && error_size > 0) {
+        error[0] = '\0';
+    }
+    int result = lib->start(config, config_length, tun_fd, callbacks, error, error_size);
+    if (result != 0 && error && error_size > 0 && !error[0]) {
+        snprintf(error, error_size, "libbox_start returned %d", result);
+    }
+    return result == 0;
+}
+
+int singbox_libbox_stop(singbox_libbox_t* lib) {
+    return lib->stop() == 0;
+}
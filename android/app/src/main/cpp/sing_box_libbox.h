@@ -0,0 +1,87 @@
+#ifndef SING_BOX_LIBBOX_H
+#define SING_BOX_LIBBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-process embedding of sing-box through a libbox-style shared library.
+ *
+ * Instead of spawning the sing-box executable, the core can dlopen a
+ * library that links sing-box and exports the small C ABI below. sing-box
+ * then runs on the library's own threads inside the app process: no second
+ * process start, and stats and log lines arrive through callbacks instead
+ * of a pipe and polling.
+ *
+ * Symbols the library exports:
+ *
+ *   int libbox_abi_version(void);
+ *       Must return SINGBOX_LIBBOX_ABI_VERSION.
+ *   const char* libbox_version(void);
+ *       sing-box version string, static storage.
+ *   int libbox_start(const char* config, size_t config_len, int tun_fd,
+ *                    const singbox_libbox_callbacks_t* callbacks,
+ *                    char* error, size_t error_size);
+ *       Start one instance; returns 0, or non-zero with a message in `error`.
+ *       `callbacks` stays valid until libbox_stop returns.
+ *   int libbox_stop(void);
+ *       Stop the instance; no callback runs after it returns. Returns 0.
+ *
+ * Callbacks may run on any library thread, concurrently with each other.
+ */
+
+#define SINGBOX_LIBBOX_ABI_VERSION 1
+
+typedef struct {
+    int64_t upload_bytes;
+    int64_t download_bytes;
+    int64_t upload_speed;       // Bytes per second
+    int64_t download_speed;
+    int64_t packets_sent;
+    int64_t packets_received;
+} singbox_libbox_stats_t;
+
+typedef struct {
+    void* ctx;
+    void (*on_log)(void* ctx, const char* line, size_t length);   // One sing-box log line, no newline
+    void (*on_stats)(void* ctx, const singbox_libbox_stats_t* stats);
+    uint32_t stats_interval_ms;     // Requested spacing of on_stats
+} singbox_libbox_callbacks_t;
+
+typedef struct singbox_libbox singbox_libbox_t;
+
+/**
+ * Load a library and resolve the ABI
+ * @return NULL with a message in `error` if it cannot be loaded, lacks a
+ *         symbol or speaks another ABI version
+ */
+singbox_libbox_t* singbox_libbox_open(const char* path, char* error, size_t error_size);
+
+/**
+ * Unload; the instance must be stopped
+ */
+void singbox_libbox_close(singbox_libbox_t* lib);
+
+const char* singbox_libbox_version(const singbox_libbox_t* lib);
+
+/**
+ * @param config UTF-8 JSON, `config_length` bytes; not copied by the loader
+ * @return 1 on success, 0 with a message in `error`
+ */
+int singbox_libbox_start(singbox_libbox_t* lib, const char* config, size_t config_length, int tun_fd,
+                         const singbox_libbox_callbacks_t* callbacks, char* error, size_t error_size);
+
+/**
+ * @return 1 on success
+ */
+int singbox_libbox_stop(singbox_libbox_t* lib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LIBBOX_H
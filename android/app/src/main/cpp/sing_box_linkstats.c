@@ -0,0 +1,252 @@
+#include "sing_box_linkstats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if_link.h>
+#include <linux/if_tun.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define REPLY_BUFFER_SIZE 16384
+#define SYSFS_COUNTERS 8
+
+// Same order as the fields of singbox_link_counters_t
+static const char* const sysfs_counter_names[SYSFS_COUNTERS] = {
+    "rx_bytes", "tx_bytes", "rx_packets", "tx_packets",
+    "rx_errors", "tx_errors", "rx_dropped", "tx_dropped",
+};
+
+struct singbox_linkstats {
+    singbox_linkstats_source_t source;
+    int ifindex;
+    char ifname[IF_NAMESIZE];
+    int netlink_fd;
+    uint32_t seq;
+    int sysfs_fd[SYSFS_COUNTERS];
+    char* reply;                        // REPLY_BUFFER_SIZE bytes
+};
+
+int singbox_linkstats_tun_ifindex(int fd, char* name, size_t name_size) {
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    if (ioctl(fd, TUNGETIFF, &ifr) != 0) {
+        return 0;
+    }
+    ifr.ifr_name[IF_NAMESIZE - 1] = '\0';
+    if (name && name_size > 0) {
+        snprintf(name, name_size, "%s", ifr.ifr_name);
+    }
+    return (int)if_nametoindex(ifr.ifr_name);
+}
+
+/**
+ * One RTM_GETLINK round trip
+ * @return 1 with `counters` filled, 0 if the interface is gone, -1 on socket errors
+ */
+static int netlink_query(singbox_linkstats_t* stats, singbox_link_counters_t* counters) {
+    struct {
+        struct nlmsghdr header;
+        struct ifinfomsg info;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++stats->seq;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = stats->ifindex;
+    
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    ssize_t sent;
+    do {
+        sent = sendto(stats->netlink_fd, &request, sizeof(request), 0,
+                      (struct sockaddr*)&kernel, sizeof(kernel));
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)sizeof(request)) {
+        return -1;
+    }
+    
+    for (;;) {
+        ssize_t length = recv(stats->netlink_fd, stats->reply, REPLY_BUFFER_SIZE, 0);
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            return -1;
+        }
+        
+        for (struct nlmsghdr* header = (struct nlmsghdr*)stats->reply; NLMSG_OK(header, (size_t)length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_seq != stats->seq) {
+                continue; // Reply to an earlier, abandoned request
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr* error = NLMSG_DATA(header);
+                return error->error == -ENODEV ? 0 : -1;
+            }
+            if (header->nlmsg_type != RTM_NEWLINK) {
+                continue;
+            }
+            
+            const struct ifinfomsg* info = NLMSG_DATA(header);
+            int attributes_length = (int)IFLA_PAYLOAD(header);
+            const struct rtnl_link_stats* stats32 = NULL;
+            for (const struct rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, attributes_length);
+                 attribute = RTA_NEXT(attribute, attributes_length)) {
+                if (attribute->rta_type == IFLA_STATS64 &&
+                    RTA_PAYLOAD(attribute) >= sizeof(struct rtnl_link_stats64)) {
+                    // May be only 4-byte aligned inside the message
+                    struct rtnl_link_stats64 link;
+                    memcpy(&link, RTA_DATA(attribute), sizeof(link));
+                    counters->rx_bytes = link.rx_bytes;
+                    counters->tx_bytes = link.tx_bytes;
+                    counters->rx_packets = link.rx_packets;
+                    counters->tx_packets = link.tx_packets;
+                    counters->rx_errors = link.rx_errors;
+                    counters->tx_errors = link.tx_errors;
+                    counters->rx_dropped = link.rx_dropped;
+                    counters->tx_dropped = link.tx_dropped;
+                    return 1;
+                }
+                if (attribute->rta_type == IFLA_STATS &&
+                    RTA_PAYLOAD(attribute) >= sizeof(struct rtnl_link_stats)) {
+                    stats32 = RTA_DATA(attribute);
+                }
+            }
+            if (stats32) {
+                // Kernels older than 2.6.35 only have the 32-bit block
+                counters->rx_bytes = stats32->rx_bytes;
+                counters->tx_bytes = stats32->tx_bytes;
+                counters->rx_packets = stats32->rx_packets;
+                counters->tx_packets = stats32->tx_packets;
+                counters->rx_errors = stats32->rx_errors;
+                counters->tx_errors = stats32->tx_errors;
+                counters->rx_dropped = stats32->rx_dropped;
+                counters->tx_dropped = stats32->tx_dropped;
+                return 1;
+            }
+            return -1;
+        }
+    }
+}
+
+static int open_netlink(singbox_linkstats_t* stats) {
+    stats->netlink_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (stats->netlink_fd < 0) {
+        return 0;
+    }
+    // A reply is synchronous; the timeout only guards against a wedged socket
+    struct timeval timeout = { 1, 0 };
+    setsockopt(stats->netlink_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    singbox_link_counters_t counters;
+    if (netlink_query(stats, &counters) == 1) {
+        return 1;
+    }
+    close(stats->netlink_fd);
+    stats->netlink_fd = -1;
+    return 0;
+}
+
+static int open_sysfs(singbox_linkstats_t* stats) {
+    for (int i = 0; i < SYSFS_COUNTERS; i++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/%s", stats->ifname, sysfs_counter_names[i]);
+        stats->sysfs_fd[i] = open(path, O_RDONLY | O_CLOEXEC);
+        if (stats->sysfs_fd[i] < 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int sysfs_read(singbox_linkstats_t* stats, singbox_link_counters_t* counters) {
+    uint64_t* fields = &counters->rx_bytes;
+    for (int i = 0; i < SYSFS_COUNTERS; i++) {
+        char text[32];
+        ssize_t n = pread(stats->sysfs_fd[i], text, sizeof(text) - 1, 0);
+        if (n <= 0) {
+            return 0; // ENODEV once the interface is unregistered
+        }
+        text[n] = '\0';
+        fields[i] = strtoull(text, NULL, 10);
+    }
+    return 1;
+}
+
+singbox_linkstats_t* singbox_linkstats_open(int ifindex, int force_sysfs) {
+    if (ifindex <= 0) {
+        return NULL;
+    }
+    singbox_linkstats_t* stats = calloc(1, sizeof(*stats));
+    if (!stats) {
+        return NULL;
+    }
+    stats->ifindex = ifindex;
+    stats->netlink_fd = -1;
+    for (int i = 0; i < SYSFS_COUNTERS; i++) {
+        stats->sysfs_fd[i] = -1;
+    }
+    if (!if_indextoname((unsigned)ifindex, stats->ifname)) {
+        free(stats);
+        return NULL;
+    }
+    
+    stats->reply = force_sysfs ? NULL : malloc(REPLY_BUFFER_SIZE);
+    if (stats->reply && open_netlink(stats)) {
+        stats->source = SINGBOX_LINKSTATS_NETLINK;
+        return stats;
+    }
+    free(stats->reply);
+    stats->reply = NULL;
+    
+    stats->source = SINGBOX_LINKSTATS_SYSFS;
+    if (open_sysfs(stats)) {
+        return stats;
+    }
+    singbox_linkstats_close(stats);
+    return NULL;
+}
+
+void singbox_linkstats_close(singbox_linkstats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    if (stats->netlink_fd >= 0) {
+        close(stats->netlink_fd);
+    }
+    for (int i = 0; i < SYSFS_COUNTERS; i++) {
+        if (stats->sysfs_fd[i] >= 0) {
+            close(stats->sysfs_fd[i]);
+        }
+    }
+    free(stats->reply);
+    free(stats);
+}
+
+int singbox_linkstats_read(singbox_linkstats_t* stats, singbox_link_counters_t* counters) {
+    if (stats->source == SINGBOX_LINKSTATS_SYSFS) {
+        return sysfs_read(stats, counters);
+    }
+    return netlink_query(stats, counters) == 1;
+}
+
+singbox_linkstats_source_t singbox_linkstats_source(const singbox_linkstats_t* stats) {
+    return stats->source;
+}
+
+const char* singbox_linkstats_source_name(singbox_linkstats_source_t source) {
+    return source == SINGBOX_LINKSTATS_SYSFS ? "sysfs" : "netlink";
+}
+
+const char* singbox_linkstats_ifname(const singbox_linkstats_t* stats) {
+    return stats->ifname;
+}
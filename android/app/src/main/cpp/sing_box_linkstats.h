@@ -0,0 +1,77 @@
+#ifndef SING_BOX_LINKSTATS_H
+#define SING_BOX_LINKSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kernel counters of one network interface, normally the TUN device.
+ *
+ * Counters come from the interface's IFLA_STATS64 attribute through a
+ * NETLINK_ROUTE socket opened once: one RTM_GETLINK request and one reply
+ * per read. Where rtnetlink is refused (Android 11+ restricts RTM_GETLINK
+ * for apps targeting API 30), the per-counter files under
+ * /sys/class/net/<name>/statistics are kept open and re-read instead.
+ *
+ * On a TUN device the kernel's transmit side is what applications send into
+ * the tunnel: tx counts upload, rx counts download.
+ */
+
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t rx_packets;
+    uint64_t tx_packets;
+    uint64_t rx_errors;
+    uint64_t tx_errors;
+    uint64_t rx_dropped;
+    uint64_t tx_dropped;
+} singbox_link_counters_t;
+
+typedef enum {
+    SINGBOX_LINKSTATS_NETLINK = 0,
+    SINGBOX_LINKSTATS_SYSFS = 1,
+} singbox_linkstats_source_t;
+
+typedef struct singbox_linkstats singbox_linkstats_t;
+
+/**
+ * Interface behind a TUN descriptor (TUNGETIFF)
+ * @param name Receives the interface name; may be NULL
+ * @return Interface index, or 0 if `fd` is not a TUN/TAP descriptor
+ */
+int singbox_linkstats_tun_ifindex(int fd, char* name, size_t name_size);
+
+/**
+ * Open counters for an interface
+ * @param force_sysfs Skip rtnetlink (used by tests)
+ * @return NULL if neither source can read the interface
+ */
+singbox_linkstats_t* singbox_linkstats_open(int ifindex, int force_sysfs);
+
+void singbox_linkstats_close(singbox_linkstats_t* stats);
+
+/**
+ * Read the current counters
+ * @return 1 on success, 0 if the interface is gone
+ */
+int singbox_linkstats_read(singbox_linkstats_t* stats, singbox_link_counters_t* counters);
+
+singbox_linkstats_source_t singbox_linkstats_source(const singbox_linkstats_t* stats);
+
+/**
+ * Name of a source ("netlink" or "sysfs")
+ */
+const char* singbox_linkstats_source_name(singbox_linkstats_source_t source);
+
+const char* singbox_linkstats_ifname(const singbox_linkstats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LINKSTATS_H
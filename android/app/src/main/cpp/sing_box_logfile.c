@@ -0,0 +1,500 @@
+#include "sing_box_logfile.h"
+#include "sing_box_compat.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TAG "SingBoxLogFile"
+
+#define SEGMENT_HEADER_SIZE ((uint32_t)sizeof(singbox_logfile_segment_t))
+#define RECORD_HEADER_SIZE ((uint32_t)sizeof(singbox_log_record_t))
+#define RECORD_CRC_OFFSET 8u
+
+/*
+ * The write cursor packs the active generation (upper 32 bits) and the next
+ * free offset inside that generation's segment (lower 32 bits), so a single
+ * compare-and-swap both reserves space and detects a concurrent rotation.
+ */
+#define CURSOR_MAKE(gen, off) (((uint64_t)(gen) << 32) | (uint32_t)(off))
+#define CURSOR_GEN(cursor) ((uint32_t)((cursor) >> 32))
+#define CURSOR_OFF(cursor) ((uint32_t)(cursor))
+
+struct singbox_logfile {
+    int fd;
+    uint8_t* base;
+    size_t map_size;
+    uint32_t segment_size;
+    uint32_t segment_count;
+    _Atomic uint64_t cursor;
+    _Atomic uint64_t next_seq;
+    _Atomic uint64_t records_written;
+    _Atomic uint64_t bytes_written;
+    _Atomic uint64_t records_dropped;
+    _Atomic uint64_t rotations;
+    pthread_mutex_t rotate_mutex;
+    _Atomic uint32_t writers[];  // Appends still copying into each segment
+};
+
+_Static_assert(sizeof(singbox_logfile_segment_t) == 64, "segment header must be 64 bytes");
+_Static_assert(sizeof(singbox_log_record_t) == 32, "record header must be 32 bytes");
+
+// CRC-32 lookup table, built once
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void build_crc_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        }
+        crc_table[i] = c;
+    }
+}
+
+uint32_t singbox_crc32(uint32_t crc, const void* data, size_t length) {
+    pthread_once(&crc_once, build_crc_table);
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (length--) {
+        crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static int64_t now_ms(void) {
+    // CLOCK_REALTIME is served from the vDSO, no system call involved
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline singbox_logfile_segment_t* segment_at(const singbox_logfile_t* file, uint64_t generation) {
+    size_t index = (size_t)(generation % file->segment_count);
+    return (singbox_logfile_segment_t*)(file->base + index * file->segment_size);
+}
+
+static inline uint32_t record_size(size_t module_len, size_t message_len) {
+    return (uint32_t)((RECORD_HEADER_SIZE + module_len + message_len + 7) & ~(size_t)7);
+}
+
+static uint32_t record_crc(const singbox_log_record_t* record) {
+    size_t covered = RECORD_HEADER_SIZE - RECORD_CRC_OFFSET + record->module_len + record->message_len;
+    return singbox_crc32(0, (const uint8_t*)record + RECORD_CRC_OFFSET, covered);
+}
+
+/**
+ * Move the writer to the next generation if nobody beat us to it
+ */
+static void rotate(singbox_logfile_t* file, uint32_t seen_generation) {
+    pthread_mutex_lock(&file->rotate_mutex);
+
+    uint64_t cursor = atomic_load_explicit(&file->cursor, memory_order_acquire);
+    if (CURSOR_GEN(cursor) == seen_generation) {
+        uint32_t next_generation = seen_generation + 1;
+        singbox_logfile_segment_t* segment = segment_at(file, next_generation);
+
+        // Writers that reserved space here one lap ago may still be copying
+        _Atomic uint32_t* writers = &file->writers[next_generation % file->segment_count];
+        while (atomic_load_explicit(writers, memory_order_acquire) != 0) {
+            sched_yield();
+        }
+
+        // Invalidate first so a crash mid-reset never mixes old records into the new generation
+        __atomic_store_n(&segment->magic, 0, __ATOMIC_RELEASE);
+        memset((uint8_t*)segment + SEGMENT_HEADER_SIZE, 0, file->segment_size - SEGMENT_HEADER_SIZE);
+        segment->version = SINGBOX_LOGFILE_VERSION;
+        segment->generation = next_generation;
+        segment->segment_size = file->segment_size;
+        segment->segment_count = file->segment_count;
+        segment->created_ms = now_ms();
+        segment->write_end = SEGMENT_HEADER_SIZE;
+        __atomic_store_n(&segment->magic, SINGBOX_LOGFILE_MAGIC, __ATOMIC_RELEASE);
+
+        atomic_store_explicit(&file->cursor, CURSOR_MAKE(next_generation, SEGMENT_HEADER_SIZE),
+                              memory_order_release);
+        atomic_fetch_add_explicit(&file->rotations, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&file->rotate_mutex);
+}
+
+static void format_segments(singbox_logfile_t* file) {
+    memset(file->base, 0, file->map_size);
+    for (uint32_t i = 0; i < file->segment_count; i++) {
+        singbox_logfile_segment_t* segment =
+            (singbox_logfile_segment_t*)(file->base + (size_t)i * file->segment_size);
+        segment->magic = SINGBOX_LOGFILE_MAGIC;
+        segment->version = SINGBOX_LOGFILE_VERSION;
+        segment->generation = 0;
+        segment->segment_size = file->segment_size;
+        segment->segment_count = file->segment_count;
+    }
+}
+
+static int find_max_seq(const singbox_log_view_t* record, void* ctx) {
+    uint64_t* max_seq = (uint64_t*)ctx;
+    if (record->seq > *max_seq) {
+        *max_seq = record->seq;
+    }
+    return 0;
+}
+
+singbox_logfile_t* singbox_logfile_open(const char* path, uint32_t segment_size, uint32_t segment_count) {
+    if (!path) {
+        return NULL;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) {
+        page = 4096;
+    }
+    if (segment_size == 0) {
+        segment_size = SINGBOX_LOGFILE_DEFAULT_SEGMENT_SIZE;
+    }
+    if (segment_size < SINGBOX_LOGFILE_MIN_SEGMENT_SIZE) {
+        segment_size = SINGBOX_LOGFILE_MIN_SEGMENT_SIZE;
+    }
+    segment_size = (uint32_t)((segment_size + page - 1) & ~(page - 1));
+    if (segment_count == 0) {
+        segment_count = SINGBOX_LOGFILE_DEFAULT_SEGMENTS;
+    }
+    if (segment_count < 2) {
+        segment_count = 2;
+    }
+
+    singbox_logfile_t* file = calloc(1, sizeof(*file) + segment_count * sizeof(file->writers[0]));
+    if (!file) {
+        return NULL;
+    }
+    file->segment_size = segment_size;
+    file->segment_count = segment_count;
+    file->map_size = (size_t)segment_size * segment_count;
+    pthread_mutex_init(&file->rotate_mutex, NULL);
+
+    file->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (file->fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "Failed to open log file %s: %s", path, strerror(errno));
+        goto fail;
+    }
+
+    struct stat st;
+    if (fstat(file->fd, &st) != 0) {
+        goto fail;
+    }
+    int reuse = (size_t)st.st_size == file->map_size;
+    if (!reuse && ftruncate(file->fd, (off_t)file->map_size) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "Failed to size log file %s: %s", path, strerror(errno));
+        goto fail;
+    }
+
+    file->base = mmap(NULL, file->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (file->base == MAP_FAILED) {
+        file->base = NULL;
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "Failed to map log file %s: %s", path, strerror(errno));
+        goto fail;
+    }
+
+    // Keep the previous session's records if the geometry matches
+    uint64_t max_generation = 0;
+    if (reuse) {
+        for (uint32_t i = 0; i < segment_count; i++) {
+            const singbox_logfile_segment_t* segment =
+                (const singbox_logfile_segment_t*)(file->base + (size_t)i * segment_size);
+            if (segment->magic != SINGBOX_LOGFILE_MAGIC || segment->version != SINGBOX_LOGFILE_VERSION ||
+                segment->segment_size != segment_size || segment->segment_count != segment_count) {
+                reuse = 0;
+                break;
+            }
+            if (segment->generation > max_generation) {
+                max_generation = segment->generation;
+            }
+        }
+    }
+
+    uint64_t max_seq = 0;
+    if (reuse) {
+        singbox_logfile_decode(file->base, file->map_size, find_max_seq, &max_seq, NULL);
+    } else {
+        format_segments(file);
+        max_generation = 0;
+    }
+
+    atomic_init(&file->next_seq, max_seq + 1);
+    atomic_init(&file->cursor, CURSOR_MAKE(max_generation, segment_size));
+    rotate(file, (uint32_t)max_generation);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG, "Log file %s opened (%u x %u bytes, generation %llu)",
+                        path, segment_count, segment_size, (unsigned long long)(max_generation + 1));
+    return file;
+
+fail:
+    if (file->base) {
+        munmap(file->base, file->map_size);
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+    }
+    pthread_mutex_destroy(&file->rotate_mutex);
+    free(file);
+    return NULL;
+}
+
+void singbox_logfile_close(singbox_logfile_t* file) {
+    if (!file) {
+        return;
+    }
+    msync(file->base, file->map_size, MS_ASYNC);
+    munmap(file->base, file->map_size);
+    close(file->fd);
+    pthread_mutex_destroy(&file->rotate_mutex);
+    free(file);
+}
+
+int singbox_logfile_append(singbox_logfile_t* file, int level, const char* module,
+                           const char* message, size_t message_len) {
+    if (!file) {
+        return 0;
+    }
+
+    size_t module_len = module ? strnlen(module, SINGBOX_LOGFILE_MAX_MODULE) : 0;
+    if (!message) {
+        message_len = 0;
+    }
+    if (message_len > SINGBOX_LOGFILE_MAX_MESSAGE) {
+        message_len = SINGBOX_LOGFILE_MAX_MESSAGE;
+    }
+
+    uint32_t size = record_size(module_len, message_len);
+    if (size > file->segment_size - SEGMENT_HEADER_SIZE) {
+        atomic_fetch_add_explicit(&file->records_dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    // Reserve space in the active segment. The segment is pinned before the
+    // reservation is published, so a rotation that laps back to it waits for
+    // the copy below instead of wiping it halfway.
+    uint64_t cursor = atomic_load_explicit(&file->cursor, memory_order_acquire);
+    _Atomic uint32_t* pin = NULL;
+    for (;;) {
+        uint32_t offset = CURSOR_OFF(cursor);
+        if (offset + size <= file->segment_size) {
+            _Atomic uint32_t* writers = &file->writers[CURSOR_GEN(cursor) % file->segment_count];
+            if (pin != writers) {
+                if (pin) {
+                    atomic_fetch_sub_explicit(pin, 1, memory_order_release);
+                }
+                pin = writers;
+                atomic_fetch_add_explicit(pin, 1, memory_order_relaxed);
+            }
+            if (atomic_compare_exchange_weak_explicit(&file->cursor, &cursor, cursor + size,
+                                                      memory_order_acq_rel, memory_order_acquire)) {
+                break;
+            }
+            continue;
+        }
+        if (pin) {
+            atomic_fetch_sub_explicit(pin, 1, memory_order_release);
+            pin = NULL;
+        }
+        rotate(file, CURSOR_GEN(cursor));
+        cursor = atomic_load_explicit(&file->cursor, memory_order_acquire);
+    }
+
+    singbox_logfile_segment_t* segment = segment_at(file, CURSOR_GEN(cursor));
+    singbox_log_record_t* record = (singbox_log_record_t*)((uint8_t*)segment + CURSOR_OFF(cursor));
+
+    // Let the decoder look past this slot should the size below never land
+    uint32_t end = CURSOR_OFF(cursor) + size;
+    uint32_t write_end = __atomic_load_n(&segment->write_end, __ATOMIC_RELAXED);
+    while (write_end < end && !__atomic_compare_exchange_n(&segment->write_end, &write_end, end, 1,
+                                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    // Size goes in first so the decoder can skip a record torn by a crash
+    __atomic_store_n(&record->size, size, __ATOMIC_RELAXED);
+    record->seq = atomic_fetch_add_explicit(&file->next_seq, 1, memory_order_relaxed);
+    record->timestamp_ms = now_ms();
+    record->level = (uint8_t)level;
+    record->module_len = (uint8_t)module_len;
+    record->message_len = (uint16_t)message_len;
+    record->reserved = 0;
+
+    uint8_t* payload = (uint8_t*)record + RECORD_HEADER_SIZE;
+    if (module_len) {
+        memcpy(payload, module, module_len);
+    }
+    if (message_len) {
+        memcpy(payload + module_len, message, message_len);
+    }
+
+    // Publishing the CRC commits the record
+    __atomic_store_n(&record->crc, record_crc(record), __ATOMIC_RELEASE);
+    atomic_fetch_sub_explicit(pin, 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&file->records_written, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&file->bytes_written, size, memory_order_relaxed);
+    return 1;
+}
+
+void singbox_logfile_flush(singbox_logfile_t* file, int synchronous) {
+    if (!file) {
+        return;
+    }
+    msync(file->base, file->map_size, synchronous ? MS_SYNC : MS_ASYNC);
+}
+
+void singbox_logfile_get_stats(singbox_logfile_t* file, singbox_logfile_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!file) {
+        return;
+    }
+    stats->records_written = atomic_load_explicit(&file->records_written, memory_order_relaxed);
+    stats->bytes_written = atomic_load_explicit(&file->bytes_written, memory_order_relaxed);
+    stats->records_dropped = atomic_load_explicit(&file->records_dropped, memory_order_relaxed);
+    stats->rotations = atomic_load_explicit(&file->rotations, memory_order_relaxed);
+    stats->generation = CURSOR_GEN(atomic_load_explicit(&file->cursor, memory_order_relaxed));
+    stats->segment_size = file->segment_size;
+    stats->segment_count = file->segment_count;
+}
+
+/**
+ * Find the next committed record after a slot whose writer never stored its size
+ */
+static uint32_t resync(const uint8_t* segment, uint32_t offset, uint32_t end) {
+    for (offset += 8; offset + RECORD_HEADER_SIZE <= end; offset += 8) {
+        const singbox_log_record_t* record = (const singbox_log_record_t*)(segment + offset);
+        uint32_t size = __atomic_load_n(&record->size, __ATOMIC_ACQUIRE);
+        if (size < RECORD_HEADER_SIZE || (size & 7) != 0 || size > end - offset ||
+            RECORD_HEADER_SIZE + (uint32_t)record->module_len + record->message_len > size) {
+            continue;
+        }
+        if (__atomic_load_n(&record->crc, __ATOMIC_ACQUIRE) == record_crc(record)) {
+            return offset;
+        }
+    }
+    return end;
+}
+
+static int compare_generation(const void* a, const void* b) {
+    const singbox_logfile_segment_t* sa = *(const singbox_logfile_segment_t* const*)a;
+    const singbox_logfile_segment_t* sb = *(const singbox_logfile_segment_t* const*)b;
+    return (sa->generation > sb->generation) - (sa->generation < sb->generation);
+}
+
+long singbox_logfile_decode(const void* data, size_t length,
+                            int (*callback)(const singbox_log_view_t* record, void* ctx),
+                            void* ctx, singbox_logfile_decode_stats_t* stats) {
+    singbox_logfile_decode_stats_t local_stats = {0};
+    const uint8_t* base = (const uint8_t*)data;
+
+    if (!base || length < SEGMENT_HEADER_SIZE) {
+        return -1;
+    }
+
+    const singbox_logfile_segment_t* first = (const singbox_logfile_segment_t*)base;
+    if (first->magic != SINGBOX_LOGFILE_MAGIC || first->version != SINGBOX_LOGFILE_VERSION ||
+        first->segment_size < SINGBOX_LOGFILE_MIN_SEGMENT_SIZE || first->segment_count == 0) {
+        return -1;
+    }
+
+    uint32_t segment_size = first->segment_size;
+    uint32_t segment_count = first->segment_count;
+    if ((size_t)segment_size * segment_count > length) {
+        // Truncated copy: decode whatever whole segments are present
+        segment_count = (uint32_t)(length / segment_size);
+    }
+
+    const singbox_logfile_segment_t** order = calloc(segment_count ? segment_count : 1, sizeof(*order));
+    if (!order) {
+        return -1;
+    }
+
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < segment_count; i++) {
+        const singbox_logfile_segment_t* segment =
+            (const singbox_logfile_segment_t*)(base + (size_t)i * segment_size);
+        if (segment->magic == SINGBOX_LOGFILE_MAGIC && segment->generation != 0 &&
+            segment->segment_size == segment_size) {
+            order[used++] = segment;
+        }
+    }
+    qsort(order, used, sizeof(*order), compare_generation);
+
+    long visited = 0;
+    int stop = 0;
+    for (uint32_t i = 0; i < used && !stop; i++) {
+        const uint8_t* segment = (const uint8_t*)order[i];
+        uint32_t offset = SEGMENT_HEADER_SIZE;
+        local_stats.segments++;
+
+        while (offset + RECORD_HEADER_SIZE <= segment_size) {
+            const singbox_log_record_t* record = (const singbox_log_record_t*)(segment + offset);
+            uint32_t size = __atomic_load_n(&record->size, __ATOMIC_ACQUIRE);
+            if (size == 0) {
+                // Either the end of written data, or a slot whose writer
+                // crashed or is still copying with records reserved after it
+                uint32_t end = __atomic_load_n(&order[i]->write_end, __ATOMIC_ACQUIRE);
+                if (end > segment_size) {
+                    end = segment_size;
+                }
+                if (offset >= end) {
+                    break;
+                }
+                local_stats.torn_records++;
+                offset = resync(segment, offset, end);
+                continue;
+            }
+            if (size < RECORD_HEADER_SIZE || (size & 7) != 0 || size > segment_size - offset) {
+                local_stats.torn_records++;
+                break; // Corrupt size field, nothing after it can be trusted
+            }
+
+            uint32_t crc = __atomic_load_n(&record->crc, __ATOMIC_ACQUIRE);
+            if (RECORD_HEADER_SIZE + (uint32_t)record->module_len + record->message_len > size ||
+                crc != record_crc(record)) {
+                local_stats.torn_records++;
+                offset += size;
+                continue;
+            }
+
+            local_stats.records++;
+            visited++;
+            if (callback) {
+                const char* payload = (const char*)record + RECORD_HEADER_SIZE;
+                singbox_log_view_t view = {
+                    .seq = record->seq,
+                    .timestamp_ms = record->timestamp_ms,
+                    .level = record->level,
+                    .module = payload,
+                    .module_len = record->module_len,
+                    .message = payload + record->module_len,
+                    .message_len = record->message_len,
+                };
+                if (callback(&view, ctx)) {
+                    stop = 1;
+                    break;
+                }
+            }
+            offset += size;
+        }
+    }
+
+    free(order);
+    if (stats) {
+        *stats = local_stats;
+    }
+    return visited;
+}
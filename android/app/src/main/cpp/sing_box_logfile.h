@@ -0,0 +1,150 @@
+#ifndef SING_BOX_LOGFILE_H
+#define SING_BOX_LOGFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Crash-safe persistent log file.
+ *
+ * The file is split into a fixed number of equally sized segments that are
+ * all mapped into memory once at open time. Producers reserve space with a
+ * single atomic operation and copy their record straight into the mapping,
+ * so appending a line never performs a system call. When the active segment
+ * fills up the writer rotates to the oldest segment, keeping the file size
+ * bounded at segment_size * segment_count.
+ *
+ * Because the mapping is MAP_SHARED the kernel owns the dirty pages, so every
+ * committed record survives a crash or force-kill of the app process and can
+ * be read back with singbox_logfile_decode() or the sing_box_logdump tool.
+ */
+
+#define SINGBOX_LOGFILE_MAGIC 0x31474c53u /* "SLG1" */
+#define SINGBOX_LOGFILE_VERSION 1
+#define SINGBOX_LOGFILE_DEFAULT_SEGMENT_SIZE (256 * 1024)
+#define SINGBOX_LOGFILE_DEFAULT_SEGMENTS 8
+#define SINGBOX_LOGFILE_MIN_SEGMENT_SIZE 4096
+#define SINGBOX_LOGFILE_MAX_MODULE 31
+#define SINGBOX_LOGFILE_MAX_MESSAGE 4096
+
+// Header at the start of every segment (64 bytes)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t generation;     // Monotonic rotation counter, 0 = never used
+    uint32_t segment_size;
+    uint32_t segment_count;
+    int64_t created_ms;      // Wall clock time the segment was (re)started
+    uint32_t write_end;      // End of the space reserved by writers, 0 = not tracked
+    uint8_t reserved[28];
+} singbox_logfile_segment_t;
+
+/*
+ * On-disk record layout (32 byte header, 8 byte aligned total size).
+ * The header is followed by module_len bytes of module name and
+ * message_len bytes of message text, neither NUL terminated.
+ *
+ * `crc` covers everything after itself and is written last with release
+ * semantics; a record whose CRC does not match was torn by a crash.
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t crc;
+    uint64_t seq;
+    int64_t timestamp_ms;
+    uint8_t level;
+    uint8_t module_len;
+    uint16_t message_len;
+    uint32_t reserved;
+} singbox_log_record_t;
+
+// Decoded view of a record handed to decode callbacks
+typedef struct {
+    uint64_t seq;
+    int64_t timestamp_ms;
+    int level;
+    const char* module;
+    size_t module_len;
+    const char* message;
+    size_t message_len;
+} singbox_log_view_t;
+
+typedef struct {
+    uint64_t records_written;
+    uint64_t bytes_written;
+    uint64_t records_dropped;   // Oversized or written while closed
+    uint64_t rotations;
+    uint64_t generation;
+    uint32_t segment_size;
+    uint32_t segment_count;
+} singbox_logfile_stats_t;
+
+typedef struct {
+    uint64_t records;
+    uint64_t torn_records;      // CRC mismatch or unwritten slot (crash mid-write)
+    uint64_t segments;
+} singbox_logfile_decode_stats_t;
+
+typedef struct singbox_logfile singbox_logfile_t;
+
+/**
+ * Open (or create) a log file and map it.
+ * Existing content is preserved: writing resumes in the oldest segment so the
+ * records from a previous, possibly crashed, session stay readable.
+ * @param path File path
+ * @param segment_size Segment size in bytes (0 = default, rounded to pages)
+ * @param segment_count Number of segments (0 = default, minimum 2)
+ * @return Handle or NULL on failure
+ */
+singbox_logfile_t* singbox_logfile_open(const char* path, uint32_t segment_size, uint32_t segment_count);
+
+/**
+ * Flush (asynchronously) and unmap the file
+ */
+void singbox_logfile_close(singbox_logfile_t* file);
+
+/**
+ * Append a record. Lock-free and syscall-free except when rotating.
+ * @return 1 on success, 0 if the record was dropped
+ */
+int singbox_logfile_append(singbox_logfile_t* file, int level, const char* module,
+                           const char* message, size_t message_len);
+
+/**
+ * Ask the kernel to write dirty pages back to storage
+ * @param synchronous Non-zero to block until written (MS_SYNC)
+ */
+void singbox_logfile_flush(singbox_logfile_t* file, int synchronous);
+
+/**
+ * Get writer statistics
+ */
+void singbox_logfile_get_stats(singbox_logfile_t* file, singbox_logfile_stats_t* stats);
+
+/**
+ * Decode a log image (mapped or read into memory) in chronological order.
+ * @param data Pointer to the start of the file contents
+ * @param length Length of the file contents
+ * @param callback Invoked for every valid record; return non-zero to stop
+ * @param ctx Passed through to the callback
+ * @param stats Optional decode statistics
+ * @return Number of valid records visited, or -1 if the image is not a log file
+ */
+long singbox_logfile_decode(const void* data, size_t length,
+                            int (*callback)(const singbox_log_view_t* record, void* ctx),
+                            void* ctx, singbox_logfile_decode_stats_t* stats);
+
+/**
+ * CRC-32 (IEEE) helper shared with other record based stores
+ */
+uint32_t singbox_crc32(uint32_t crc, const void* data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGFILE_H
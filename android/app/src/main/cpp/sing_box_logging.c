@@ -1,26 +1,56 @@
-#include <android/log.h>
+#include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "sing_box_compat.h"
+#include "sing_box_logging.h"
+#include "sing_box_logfile.h"
+#include "sing_box_logquery.h"
+#include "sing_box_logring.h"
+#include "sing_box_logtail.h"
+#include "sing_box_logthrottle.h"
 
 #define TAG "SingBoxLogging"
-#define MAX_LOG_ENTRIES 1000
-#define MAX_LOG_LENGTH 512
+#define MAX_LOG_LENGTH (SINGBOX_LOGRING_MAX_MESSAGE + 1)
 
-// Log entry structure
-typedef struct {
-    time_t timestamp;
-    int level;
-    char message[MAX_LOG_LENGTH];
-} log_entry_t;
-
-// Global log buffer
-static log_entry_t log_buffer[MAX_LOG_ENTRIES];
-static int log_head = 0;
-static int log_count = 0;
+// Global log buffer: block-compressed ring, allocated on first use
+static singbox_logring_t* log_ring = NULL;
+static uint64_t log_next_seq = 1;
 static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Uncompressed copy of the most recent records, tailed in place by Kotlin;
+// static so the direct ByteBuffer wrapping it never dangles
+static uint8_t log_tail_memory[SINGBOX_LOGTAIL_DEFAULT_SIZE] __attribute__((aligned(64)));
+static singbox_logtail_t* log_tail = NULL;
+
+// Suppression stage in front of every sink; its own lock is taken before log_mutex
+static singbox_logthrottle_t log_throttle;
+static int log_throttle_enabled = 0;
+static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Persistent log file. Producers append without the buffer lock; they
+// register in log_file_users first, so cleanup can unmap it once the
+// pointer is gone and the last of them has left
+static _Atomic(singbox_logfile_t*) log_file = NULL;
+static atomic_int log_file_users = 0;
+
+static singbox_logfile_t* acquire_log_file(void) {
+    atomic_fetch_add(&log_file_users, 1);
+    singbox_logfile_t* file = atomic_load(&log_file);
+    if (!file) {
+        atomic_fetch_sub_explicit(&log_file_users, 1, memory_order_release);
+    }
+    return file;
+}
+
+static void release_log_file(void) {
+    atomic_fetch_sub_explicit(&log_file_users, 1, memory_order_release);
+}
+
 // Log level definitions
 typedef enum {
     LOG_LEVEL_TRACE = 0,
@@ -60,10 +90,16 @@ int singbox_get_log_level() {
     return level;
 }
 
+static int64_t wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 /**
- * Add a log entry to the circular buffer
+ * Add a log entry to the ring buffer
  */
-static void add_log_entry(int level, const char* message) {
+static void add_log_entry(int level, const char* module, const char* message, size_t length) {
     pthread_mutex_lock(&log_mutex);
     
     // Don't log if level is below current threshold
@@ -72,20 +108,86 @@ static void add_log_entry(int level, const char* message) {
         return;
     }
     
-    // Add to circular buffer
-    log_buffer[log_head].timestamp = time(NULL);
-    log_buffer[log_head].level = level;
-    strncpy(log_buffer[log_head].message, message, MAX_LOG_LENGTH - 1);
-    log_buffer[log_head].message[MAX_LOG_LENGTH - 1] = '\0';
-    
-    log_head = (log_head + 1) % MAX_LOG_ENTRIES;
-    if (log_count < MAX_LOG_ENTRIES) {
-        log_count++;
+    if (!log_ring) {
+        log_ring = singbox_logring_create(0, 0);
+        if (!log_ring) {
+            pthread_mutex_unlock(&log_mutex);
+            return;
+        }
     }
+    if (!log_tail) {
+        log_tail = singbox_logtail_init(log_tail_memory, sizeof(log_tail_memory));
+    }
+    uint64_t seq = log_next_seq++;
+    int64_t timestamp_ms = wall_clock_ms();
+    size_t module_len = strlen(module);
+    singbox_logring_append(log_ring, seq, timestamp_ms, level, module, module_len, message, length);
+    singbox_logtail_append(log_tail, seq, timestamp_ms, level, module, module_len, message, length);
     
     pthread_mutex_unlock(&log_mutex);
 }
 
+static int android_priority(int level) {
+    switch (level) {
+        case LOG_LEVEL_TRACE:
+        case LOG_LEVEL_DEBUG:
+            return ANDROID_LOG_DEBUG;
+        case LOG_LEVEL_INFO:
+            return ANDROID_LOG_INFO;
+        case LOG_LEVEL_WARN:
+            return ANDROID_LOG_WARN;
+        case LOG_LEVEL_ERROR:
+            return ANDROID_LOG_ERROR;
+        case LOG_LEVEL_FATAL:
+            return ANDROID_LOG_FATAL;
+        default:
+            return ANDROID_LOG_INFO;
+    }
+}
+
+/**
+ * Record an already formatted message in the buffer and the log file
+ */
+static void dispatch_message(int level, const char* module, const char* message, size_t length) {
+    // Add to internal buffer
+    add_log_entry(level, module, message, length);
+    
+    // Persist without taking the buffer lock
+    singbox_logfile_t* file = acquire_log_file();
+    if (file) {
+        singbox_logfile_append(file, level, module, message, length);
+        release_log_file();
+    }
+}
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Burst and rate-limit summaries bypass the throttle and go to every sink
+ */
+static void emit_throttle_summary(int level, const char* module, const char* message, size_t length, void* ctx) {
+    (void)ctx;
+    __android_log_print(android_priority(level), TAG, "[%s] %s", module, message);
+    dispatch_message(level, module, message, length);
+}
+
+/**
+ * Run a message through the suppression stage
+ * @return Non-zero if the message should be logged
+ */
+static int throttle_admit(int level, const char* module, const char* message, size_t length) {
+    pthread_mutex_lock(&throttle_mutex);
+    int admit = !log_throttle_enabled ||
+                singbox_logthrottle_submit(&log_throttle, monotonic_ms(), level, module, message, length,
+                                           emit_throttle_summary, NULL);
+    pthread_mutex_unlock(&throttle_mutex);
+    return admit;
+}
+
 /**
  * Log a message with specified level
  */
@@ -100,98 +202,40 @@ void singbox_log(int level, const char* format, ...) {
     vsnprintf(message, sizeof(message), format, args);
     va_end(args);
     
-    // Log to Android logcat
-    int android_level;
-    switch (level) {
-        case LOG_LEVEL_TRACE:
-        case LOG_LEVEL_DEBUG:
-            android_level = ANDROID_LOG_DEBUG;
-            break;
-        case LOG_LEVEL_INFO:
-            android_level = ANDROID_LOG_INFO;
-            break;
-        case LOG_LEVEL_WARN:
-            android_level = ANDROID_LOG_WARN;
-            break;
-        case LOG_LEVEL_ERROR:
-            android_level = ANDROID_LOG_ERROR;
-            break;
-        case LOG_LEVEL_FATAL:
-            android_level = ANDROID_LOG_FATAL;
-            break;
-        default:
-            android_level = ANDROID_LOG_INFO;
+    size_t length = strlen(message);
+    if (!throttle_admit(level, "native", message, length)) {
+        return;
     }
     
-    __android_log_print(android_level, TAG, "[%s] %s", log_level_names[level], message);
+    // Log to Android logcat
+    __android_log_print(android_priority(level), TAG, "[%s] %s", log_level_names[level], message);
     
-    // Add to internal buffer
-    add_log_entry(level, message);
+    dispatch_message(level, "native", message, length);
 }
 
 /**
- * Get logs as JSON string
- * Caller is responsible for freeing the returned string
+ * Log a line produced by the sing-box core
  */
-char* singbox_get_logs_json() {
-    pthread_mutex_lock(&log_mutex);
-    
-    // Calculate required buffer size
-    size_t buffer_size = 1024; // Base size for JSON structure
-    for (int i = 0; i < log_count; i++) {
-        buffer_size += strlen(log_buffer[i].message) + 100; // Extra space for JSON formatting
+void singbox_log_write(int level, const char* module, const char* message, size_t length) {
+    if (level < current_log_level || level < LOG_LEVEL_TRACE || level > LOG_LEVEL_FATAL) {
+        return;
     }
     
-    char* json_buffer = malloc(buffer_size);
-    if (!json_buffer) {
-        pthread_mutex_unlock(&log_mutex);
-        return NULL;
+    char buffer[MAX_LOG_LENGTH];
+    if (length >= sizeof(buffer)) {
+        length = sizeof(buffer) - 1;
     }
+    memcpy(buffer, message, length);
+    buffer[length] = '\0';
     
-    strcpy(json_buffer, "{\"logs\":[");
+    module = module && module[0] ? module : "core";
+    if (!throttle_admit(level, module, buffer, length)) {
+        return;
+    }
     
-    int start_index = (log_count == MAX_LOG_ENTRIES) ? log_head : 0;
-    for (int i = 0; i < log_count; i++) {
-        int index = (start_index + i) % MAX_LOG_ENTRIES;
-        
-        if (i > 0) {
-            strcat(json_buffer, ",");
-        }
-        
-        // Format timestamp
-        struct tm* tm_info = localtime(&log_buffer[index].timestamp);
-        char timestamp_str[32];
-        strftime(timestamp_str, sizeof(timestamp_str), "%Y-%m-%d %H:%M:%S", tm_info);
-        
-        // Escape message for JSON
-        char escaped_message[MAX_LOG_LENGTH * 2];
-        const char* src = log_buffer[index].message;
-        char* dst = escaped_message;
-        
-        while (*src && (size_t)(dst - escaped_message) < sizeof(escaped_message) - 2) {
-            if (*src == '"' || *src == '\\') {
-                *dst++ = '\\';
-            }
-            *dst++ = *src++;
-        }
-        *dst = '\0';
-        
-        // Add log entry to JSON
-        char entry[MAX_LOG_LENGTH * 3];
-        snprintf(entry, sizeof(entry),
-            "{\"timestamp\":\"%s\",\"level\":\"%s\",\"message\":\"%s\"}",
-            timestamp_str,
-            log_level_names[log_buffer[index].level],
-            escaped_message
-        );
-        
-        strcat(json_buffer, entry);
-    }
-    
-    strcat(json_buffer, "]}");
+    __android_log_print(android_priority(level), "sing-box", "[%s] %s", module, buffer);
     
-    pthread_mutex_unlock(&log_mutex);
-    return json_buffer;
+    dispatch_message(level, module, buffer, length);
 }
 
 /**
@@ -199,8 +243,12 @@ char* singbox_get_logs_json() {
  */
 void singbox_clear_logs() {
     pthread_mutex_lock(&log_mutex);
-    log_head = 0;
-    log_count = 0;
+    if (log_ring) {
+        singbox_logring_clear(log_ring);
+    }
+    if (log_tail) {
+        singbox_logtail_clear(log_tail);
+    }
     __android_log_print(ANDROID_LOG_INFO, TAG, "Log buffer cleared");
     pthread_mutex_unlock(&log_mutex);
 }
@@ -211,7 +259,7 @@ void singbox_clear_logs() {
 void singbox_get_log_stats(int* total_entries, int* current_level) {
     pthread_mutex_lock(&log_mutex);
     if (total_entries) {
-        *total_entries = log_count;
+        *total_entries = log_ring ? (int)singbox_logring_count(log_ring) : 0;
     }
     if (current_level) {
         *current_level = current_log_level;
@@ -223,9 +271,18 @@ void singbox_get_log_stats(int* total_entries, int* current_level) {
  * Initialize logging system
  */
 void singbox_logging_init() {
+    pthread_mutex_lock(&throttle_mutex);
+    singbox_logthrottle_init(&log_throttle, NULL);
+    log_throttle_enabled = 1;
+    pthread_mutex_unlock(&throttle_mutex);
+    
     pthread_mutex_lock(&log_mutex);
-    log_head = 0;
-    log_count = 0;
+    if (log_ring) {
+        singbox_logring_clear(log_ring);
+    }
+    if (log_tail) {
+        singbox_logtail_clear(log_tail);
+    }
     current_log_level = LOG_LEVEL_INFO;
     __android_log_print(ANDROID_LOG_INFO, TAG, "Sing-box logging system initialized");
     pthread_mutex_unlock(&log_mutex);
@@ -235,9 +292,282 @@ void singbox_logging_init() {
  * Cleanup logging system
  */
 void singbox_logging_cleanup() {
+    // Pending burst summaries still reach the persistent file
+    singbox_logging_flush_throttle(1);
+    
     pthread_mutex_lock(&log_mutex);
-    log_head = 0;
-    log_count = 0;
+    singbox_logring_destroy(log_ring);
+    log_ring = NULL;
     __android_log_print(ANDROID_LOG_INFO, TAG, "Sing-box logging system cleaned up");
+    
+    // Detach the file, wait out producers still appending, then unmap it
+    singbox_logfile_t* file = atomic_exchange(&log_file, NULL);
+    while (atomic_load_explicit(&log_file_users, memory_order_acquire) > 0) {
+        sched_yield();
+    }
+    singbox_logfile_close(file);
+    pthread_mutex_unlock(&log_mutex);
+}
+
+/**
+ * Attach the persistent log file
+ */
+int singbox_logging_open_file(const char* path) {
+    pthread_mutex_lock(&log_mutex);
+    
+    if (atomic_load_explicit(&log_file, memory_order_acquire)) {
+        pthread_mutex_unlock(&log_mutex);
+        return 1;
+    }
+    
+    singbox_logfile_t* file = singbox_logfile_open(path, 0, 0);
+    if (file) {
+        atomic_store_explicit(&log_file, file, memory_order_release);
+        __android_log_print(ANDROID_LOG_INFO, TAG, "Persistent log file attached: %s", path);
+    } else {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "Persistent log file unavailable: %s", path);
+    }
+    
     pthread_mutex_unlock(&log_mutex);
-}
\ No newline at end of file
+    return file != NULL;
+}
+
+/**
+ * Flush the persistent log file
+ */
+void singbox_logging_flush_file(int synchronous) {
+    singbox_logfile_t* file = acquire_log_file();
+    if (file) {
+        singbox_logfile_flush(file, synchronous);
+        release_log_file();
+    }
+}
+/**
+ * Replace the suppression configuration; NULL disables suppression
+ */
+void singbox_logging_set_throttle(const singbox_logthrottle_config_t* config) {
+    pthread_mutex_lock(&throttle_mutex);
+    if (log_throttle_enabled) {
+        singbox_logthrottle_flush(&log_throttle, monotonic_ms(), 1, emit_throttle_summary, NULL);
+    }
+    log_throttle_enabled = config != NULL;
+    if (config) {
+        singbox_logthrottle_init(&log_throttle, config);
+    }
+    pthread_mutex_unlock(&throttle_mutex);
+}
+
+/**
+ * Emit summaries for bursts that went quiet (or all of them when forced)
+ */
+void singbox_logging_flush_throttle(int force) {
+    pthread_mutex_lock(&throttle_mutex);
+    if (log_throttle_enabled) {
+        singbox_logthrottle_flush(&log_throttle, monotonic_ms(), force, emit_throttle_summary, NULL);
+    }
+    pthread_mutex_unlock(&throttle_mutex);
+}
+
+/**
+ * Copy the suppression counters
+ */
+void singbox_logging_get_throttle_stats(singbox_logthrottle_stats_t* stats) {
+    pthread_mutex_lock(&throttle_mutex);
+    *stats = log_throttle.stats;
+    pthread_mutex_unlock(&throttle_mutex);
+}
+
+/**
+ * Visit the buffered entries in order while holding the buffer lock
+ */
+void singbox_logging_visit(int newest_first,
+                           int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx) {
+    pthread_mutex_lock(&log_mutex);
+    if (log_ring && singbox_logring_visit(log_ring, newest_first, callback, ctx) < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "Log buffer block failed to decode");
+    }
+    pthread_mutex_unlock(&log_mutex);
+}
+
+// Growable output buffer for query results
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} json_buffer_t;
+
+static void json_reserve(json_buffer_t* buffer, size_t extra) {
+    if (buffer->failed || buffer->length + extra + 1 <= buffer->capacity) {
+        return;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+    while (capacity < buffer->length + extra + 1) {
+        capacity *= 2;
+    }
+    char* data = realloc(buffer->data, capacity);
+    if (!data) {
+        buffer->failed = 1;
+        return;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+static void json_append(json_buffer_t* buffer, const char* text, size_t length) {
+    json_reserve(buffer, length);
+    if (buffer->failed) {
+        return;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+static void json_append_string(json_buffer_t* buffer, const char* text, size_t length) {
+    // Worst case every byte becomes a \u00XX escape
+    json_reserve(buffer, length * 6 + 2);
+    if (buffer->failed) {
+        return;
+    }
+    char* out = buffer->data + buffer->length;
+    *out++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c < 0x20) {
+            out += sprintf(out, "\\u%04x", c);
+        } else {
+            *out++ = (char)c;
+        }
+    }
+    *out++ = '"';
+    *out = '\0';
+    buffer->length = (size_t)(out - buffer->data);
+}
+
+static int emit_json_entry(const singbox_log_view_t* record, void* ctx) {
+    json_buffer_t* buffer = (json_buffer_t*)ctx;
+    if (buffer->failed) {
+        return 0;
+    }
+    char header[160];
+    int length = snprintf(header, sizeof(header),
+        "%s{\"seq\":%llu,\"timestamp\":%lld,\"level\":\"%s\",\"module\":",
+        buffer->data[buffer->length - 1] == '[' ? "" : ",",
+        (unsigned long long)record->seq, (long long)record->timestamp_ms,
+        log_level_names[record->level]);
+    json_append(buffer, header, (size_t)length);
+    json_append_string(buffer, record->module, record->module_len);
+    json_append(buffer, ",\"message\":", 11);
+    json_append_string(buffer, record->message, record->message_len);
+    json_append(buffer, "}", 1);
+    return 0;
+}
+
+static int emit_legacy_json_entry(const singbox_log_view_t* record, void* ctx) {
+    json_buffer_t* buffer = (json_buffer_t*)ctx;
+    if (buffer->failed) {
+        return 0;
+    }
+    time_t seconds = (time_t)(record->timestamp_ms / 1000);
+    struct tm tm_info;
+    char timestamp[32];
+    localtime_r(&seconds, &tm_info);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+    
+    char header[96];
+    int length = snprintf(header, sizeof(header), "%s{\"timestamp\":\"%s\",\"level\":\"%s\",\"message\":",
+                          buffer->data[buffer->length - 1] == '[' ? "" : ",", timestamp,
+                          log_level_names[record->level]);
+    json_append(buffer, header, (size_t)length);
+    json_append_string(buffer, record->message, record->message_len);
+    json_append(buffer, "}", 1);
+    return 0;
+}
+
+/**
+ * Get the shared tail ring of recent records
+ */
+const singbox_logtail_t* singbox_logging_tail_region(size_t* size) {
+    pthread_mutex_lock(&log_mutex);
+    if (!log_tail) {
+        log_tail = singbox_logtail_init(log_tail_memory, sizeof(log_tail_memory));
+    }
+    pthread_mutex_unlock(&log_mutex);
+    if (size) {
+        *size = sizeof(log_tail_memory);
+    }
+    return log_tail;
+}
+
+/**
+ * Get logs as JSON string, oldest first
+ * Caller is responsible for freeing the returned string
+ */
+char* singbox_get_logs_json() {
+    json_buffer_t buffer = {0};
+    json_append(&buffer, "{\"logs\":[", 9);
+    singbox_logging_visit(0, emit_legacy_json_entry, &buffer);
+    json_append(&buffer, "]}", 2);
+    
+    if (buffer.failed) {
+        free(buffer.data);
+        return NULL;
+    }
+    return buffer.data;
+}
+
+/**
+ * Copy the log buffer counters (zeroed before the first entry)
+ */
+void singbox_logging_get_buffer_stats(singbox_logring_stats_t* stats) {
+    pthread_mutex_lock(&log_mutex);
+    if (log_ring) {
+        singbox_logring_get_stats(log_ring, stats);
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+    pthread_mutex_unlock(&log_mutex);
+}
+
+/**
+ * Run a query over the log buffer and return one page of matches as JSON
+ * Caller is responsible for freeing the returned string
+ */
+char* singbox_query_logs_json(const char* query_text, int offset, int limit) {
+    singbox_log_query_t query;
+    char error[160];
+    json_buffer_t buffer = {0};
+    
+    if (singbox_log_query_parse(&query, query_text, wall_clock_ms(), error, sizeof(error)) != 0) {
+        json_append(&buffer, "{\"error\":", 9);
+        json_append_string(&buffer, error, strlen(error));
+        json_append(&buffer, "}", 1);
+        return buffer.failed ? NULL : buffer.data;
+    }
+    
+    json_append(&buffer, "{\"logs\":[", 9);
+    
+    // Bursts that already ended show up as their summary record
+    singbox_logging_flush_throttle(0);
+    
+    singbox_log_pager_t pager;
+    singbox_log_pager_init(&pager, &query, offset > 0 ? (size_t)offset : 0,
+                           limit > 0 ? (size_t)limit : 0, emit_json_entry, &buffer);
+    singbox_logging_visit(query.newest_first, singbox_log_pager_visit, &pager);
+    singbox_log_query_free(&query);
+    
+    char footer[128];
+    int length = snprintf(footer, sizeof(footer), "],\"total\":%zu,\"offset\":%d,\"scanned\":%zu}",
+                          pager.matched, offset > 0 ? offset : 0, pager.scanned);
+    json_append(&buffer, footer, (size_t)length);
+    
+    if (buffer.failed) {
+        free(buffer.data);
+        return NULL;
+    }
+    return buffer.data;
+}
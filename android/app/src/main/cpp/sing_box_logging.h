@@ -1,6 +1,11 @@
 #ifndef SING_BOX_LOGGING_H
 #define SING_BOX_LOGGING_H
 
+#include "sing_box_logfile.h"
+#include "sing_box_logring.h"
+#include "sing_box_logtail.h"
+#include "sing_box_logthrottle.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,12 +48,29 @@ int singbox_get_log_level(void);
  */
 void singbox_log(int level, const char* format, ...);
 
+/**
+ * Log an already formatted line from the sing-box core
+ * @param level Log level
+ * @param module Originating module, e.g. "outbound/vless[proxy]"
+ * @param message Message text (need not be NUL terminated)
+ * @param length Message length
+ */
+void singbox_log_write(int level, const char* module, const char* message, size_t length);
+
 /**
  * Get logs as JSON string
  * @return JSON string containing log entries (caller must free)
  */
 char* singbox_get_logs_json(void);
 
+/**
+ * Get the shared tail ring holding the most recent records uncompressed
+ * (see sing_box_logtail.h). The region is static and lives for the life
+ * of the process; clearing the logs empties it as well.
+ * @param size Optional, receives the size of the whole region in bytes
+ */
+const singbox_logtail_t* singbox_logging_tail_region(size_t* size);
+
 /**
  * Clear all log entries
  */
@@ -61,6 +83,65 @@ void singbox_clear_logs(void);
  */
 void singbox_get_log_stats(int* total_entries, int* current_level);
 
+/**
+ * Query the log buffer (see sing_box_logquery.h for the query syntax)
+ * @param query Query text, NULL or empty for all entries
+ * @param offset Number of matches to skip
+ * @param limit Maximum number of entries to return (0 = all)
+ * @return JSON with "logs", "total" and "offset", or {"error":...} for a
+ *         malformed query (caller must free)
+ */
+char* singbox_query_logs_json(const char* query, int offset, int limit);
+
+/**
+ * Visit buffered log entries in order while holding the buffer lock
+ * @param newest_first Non-zero to start from the most recent entry
+ * @param callback Invoked per entry; return non-zero to stop
+ * @param ctx Passed through to the callback
+ */
+void singbox_logging_visit(int newest_first,
+                           int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx);
+
+/**
+ * Attach a crash-safe persistent log file (see sing_box_logfile.h).
+ * Every message accepted by singbox_log() is also appended to it.
+ * Calling again after a successful open is a no-op.
+ * @param path Log file path
+ * @return 1 if the file is attached, 0 on failure
+ */
+int singbox_logging_open_file(const char* path);
+
+/**
+ * Ask the kernel to write the persistent log file back to storage
+ * @param synchronous Non-zero to block until written
+ */
+void singbox_logging_flush_file(int synchronous);
+
+/**
+ * Configure the suppression stage (duplicate-burst collapsing and per-module
+ * rate limits, see sing_box_logthrottle.h) applied to singbox_log() and
+ * singbox_log_write(). singbox_logging_init() enables it with the defaults.
+ * @param config New configuration, NULL to disable suppression
+ */
+void singbox_logging_set_throttle(const singbox_logthrottle_config_t* config);
+
+/**
+ * Emit summary records for suppressed bursts
+ * @param force Non-zero to summarise bursts that are still active
+ */
+void singbox_logging_flush_throttle(int force);
+
+/**
+ * Get the suppression counters
+ */
+void singbox_logging_get_throttle_stats(singbox_logthrottle_stats_t* stats);
+
+/**
+ * Get the in-memory log buffer counters (records held, compression ratio,
+ * evictions; see sing_box_logring.h)
+ */
+void singbox_logging_get_buffer_stats(singbox_logring_stats_t* stats);
+
 // Convenience macros for logging
 #define SINGBOX_LOG_T(fmt, ...) singbox_log(SINGBOX_LOG_TRACE, fmt, ##__VA_ARGS__)
 #define SINGBOX_LOG_D(fmt, ...) singbox_log(SINGBOX_LOG_DEBUG, fmt, ##__VA_ARGS__)
@@ -0,0 +1,443 @@
+#include "sing_box_logparse.h"
+#include "sing_box_logging.h"
+#include "sing_box_simd.h"
+
+#include <string.h>
+
+#define LIT(s) (s), (sizeof(s) - 1)
+
+static const char* event_type_names[SINGBOX_EVENT_TYPE_COUNT] = {
+    "none",
+    "inbound_connection",
+    "outbound_connection",
+    "connection_closed",
+    "dns_query",
+    "dns_answer",
+    "router_match",
+    "error"
+};
+
+const char* singbox_event_type_name(int type) {
+    return (type >= 0 && type < SINGBOX_EVENT_TYPE_COUNT) ? event_type_names[type] : "unknown";
+}
+
+static inline int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline int starts_with(const char* text, size_t length, const char* prefix, size_t prefix_len) {
+    return length >= prefix_len && memcmp(text, prefix, prefix_len) == 0;
+}
+
+static inline singbox_span_t make_span(const char* line, const char* start, size_t length) {
+    singbox_span_t span = { (uint16_t)(start - line), (uint16_t)length };
+    return span;
+}
+
+/**
+ * Remove "ESC [ ... final" color sequences in place
+ */
+static size_t strip_ansi(char* line, size_t length) {
+    char* escape = (char*)singbox_find_byte(line, length, 0x1b);
+    if (!escape) {
+        return length;
+    }
+
+    char* out = escape;
+    const char* in = escape;
+    const char* end = line + length;
+    while (in < end) {
+        if (*in == 0x1b) {
+            in++;
+            if (in < end && *in == '[') {
+                in++;
+                while (in < end && !((unsigned char)*in >= 0x40 && (unsigned char)*in <= 0x7e)) {
+                    in++;
+                }
+                if (in < end) {
+                    in++; // Final byte
+                }
+            }
+            continue;
+        }
+        const char* next = singbox_find_byte(in, (size_t)(end - in), 0x1b);
+        size_t run = next ? (size_t)(next - in) : (size_t)(end - in);
+        memmove(out, in, run);
+        out += run;
+        in += run;
+    }
+    return (size_t)(out - line);
+}
+
+static int parse_digits(const char* p, int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        if (!is_digit(p[i])) {
+            return -1;
+        }
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * Parse an optional "+0800 " zone followed by "2024-05-01 12:00:00 "
+ * @return Characters consumed, 0 if the line has no timestamp
+ */
+static size_t parse_timestamp(const char* p, size_t length, int64_t* timestamp) {
+    size_t used = 0;
+    int zone_seconds = 0;
+
+    if (length >= 6 && (p[0] == '+' || p[0] == '-') && p[5] == ' ') {
+        int hours = parse_digits(p + 1, 2);
+        int minutes = parse_digits(p + 3, 2);
+        if (hours < 0 || minutes < 0) {
+            return 0;
+        }
+        zone_seconds = (hours * 3600 + minutes * 60) * (p[0] == '-' ? -1 : 1);
+        used = 6;
+    }
+
+    const char* d = p + used;
+    if (length - used < 20 || d[4] != '-' || d[7] != '-' || d[10] != ' ' ||
+        d[13] != ':' || d[16] != ':' || d[19] != ' ') {
+        return 0;
+    }
+    int year = parse_digits(d, 4);
+    int month = parse_digits(d + 5, 2);
+    int day = parse_digits(d + 8, 2);
+    int hour = parse_digits(d + 11, 2);
+    int minute = parse_digits(d + 14, 2);
+    int second = parse_digits(d + 17, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || hour < 0 || minute < 0 || second < 0) {
+        return 0;
+    }
+
+    *timestamp = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - zone_seconds;
+    return used + 20;
+}
+
+/**
+ * Parse a level word followed by a space
+ * @return Characters consumed, 0 if there is no level
+ */
+static size_t parse_level(const char* p, size_t length, uint8_t* level) {
+    if (length >= 5 && p[4] == ' ') {
+        if (memcmp(p, "INFO", 4) == 0) { *level = SINGBOX_LOG_INFO; return 5; }
+        if (memcmp(p, "WARN", 4) == 0) { *level = SINGBOX_LOG_WARN; return 5; }
+    }
+    if (length >= 6 && p[5] == ' ') {
+        if (memcmp(p, "DEBUG", 5) == 0) { *level = SINGBOX_LOG_DEBUG; return 6; }
+        if (memcmp(p, "ERROR", 5) == 0) { *level = SINGBOX_LOG_ERROR; return 6; }
+        if (memcmp(p, "TRACE", 5) == 0) { *level = SINGBOX_LOG_TRACE; return 6; }
+        if (memcmp(p, "FATAL", 5) == 0 || memcmp(p, "PANIC", 5) == 0) { *level = SINGBOX_LOG_FATAL; return 6; }
+    }
+    return 0;
+}
+
+/**
+ * Parse a Go style duration such as "5ms", "1.5s" or "2m3s" into milliseconds
+ */
+static uint32_t parse_duration(const char* p, size_t length) {
+    double total = 0;
+    size_t i = 0;
+    while (i < length) {
+        double value = 0;
+        double scale = 0;
+        if (!is_digit(p[i])) {
+            return 0;
+        }
+        while (i < length && (is_digit(p[i]) || p[i] == '.')) {
+            if (p[i] == '.') {
+                scale = 0.1;
+            } else if (scale > 0) {
+                value += (p[i] - '0') * scale;
+                scale /= 10;
+            } else {
+                value = value * 10 + (p[i] - '0');
+            }
+            i++;
+        }
+        double unit = 0;
+        if (i + 1 < length && p[i] == 'm' && p[i + 1] == 's') {
+            unit = 1; i += 2;
+        } else if (i + 1 < length && (p[i] == 'u' || p[i] == 'n') && p[i + 1] == 's') {
+            unit = 0; i += 2;
+        } else if (i + 2 < length && (unsigned char)p[i] == 0xc2 && (unsigned char)p[i + 1] == 0xb5 && p[i + 2] == 's') {
+            unit = 0; i += 3; // "µs"
+        } else if (i < length && p[i] == 'h') {
+            unit = 3600000; i++;
+        } else if (i < length && p[i] == 'm') {
+            unit = 60000; i++;
+        } else if (i < length && p[i] == 's') {
+            unit = 1000; i++;
+        } else {
+            return 0;
+        }
+        total += value * unit;
+    }
+    return total > 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)total;
+}
+
+/**
+ * Parse "[3145278281 5ms] "
+ * @return Characters consumed, 0 if absent
+ */
+static size_t parse_connection(const char* p, size_t length, singbox_log_event_t* event) {
+    if (length < 5 || p[0] != '[' || !is_digit(p[1])) {
+        return 0;
+    }
+    const char* close = singbox_find_byte(p, length < 64 ? length : 64, ']');
+    if (!close || (size_t)(close - p) + 1 >= length || close[1] != ' ') {
+        return 0;
+    }
+    uint64_t id = 0;
+    const char* q = p + 1;
+    while (q < close && is_digit(*q)) {
+        id = id * 10 + (uint64_t)(*q - '0');
+        q++;
+    }
+    if (q < close && *q == ' ') {
+        event->duration_ms = parse_duration(q + 1, (size_t)(close - q - 1));
+    } else if (q != close) {
+        return 0;
+    }
+    event->connection_id = (uint32_t)id;
+    event->flags |= SINGBOX_EVENT_HAS_CONNECTION;
+    return (size_t)(close - p) + 2;
+}
+
+// Span of the text following `prefix` up to the next space
+static singbox_span_t address_after(const char* line, const char* text, size_t length, size_t prefix_len) {
+    const char* start = text + prefix_len;
+    const char* space = singbox_find_byte(start, length - prefix_len, ' ');
+    size_t address_len = space ? (size_t)(space - start) : length - prefix_len;
+    // Drop punctuation that sing-box appends to addresses in error chains
+    while (address_len && (start[address_len - 1] == ':' || start[address_len - 1] == ',')) {
+        address_len--;
+    }
+    return make_span(line, start, address_len);
+}
+
+static void classify_connection(const char* line, const char* message, size_t length,
+                                const char* direction, size_t direction_len, singbox_log_event_t* event,
+                                uint8_t type) {
+    // "<direction> connection to|from X" or "<direction> packet connection to|from X"
+    if (!starts_with(message, length, direction, direction_len)) {
+        return;
+    }
+    const char* rest = message + direction_len;
+    size_t rest_len = length - direction_len;
+    uint8_t network = SINGBOX_NETWORK_TCP;
+    if (starts_with(rest, rest_len, LIT("packet "))) {
+        network = SINGBOX_NETWORK_UDP;
+        rest += 7;
+        rest_len -= 7;
+    }
+    if (starts_with(rest, rest_len, LIT("connection to ")) || starts_with(rest, rest_len, LIT("connection from "))) {
+        size_t prefix = rest[11] == 't' ? 14 : 16;
+        event->type = type;
+        event->network = network;
+        event->address = address_after(line, rest, rest_len, prefix);
+    }
+}
+
+static void classify(const char* line, singbox_log_event_t* event) {
+    const char* module = line + event->module.offset;
+    size_t module_len = event->module.length;
+    const char* message = line + event->message.offset;
+    size_t length = event->message.length;
+
+    if (starts_with(module, module_len, LIT("inbound/"))) {
+        classify_connection(line, message, length, LIT("inbound "), event, SINGBOX_EVENT_INBOUND_CONNECTION);
+    } else if (starts_with(module, module_len, LIT("outbound/"))) {
+        classify_connection(line, message, length, LIT("outbound "), event, SINGBOX_EVENT_OUTBOUND_CONNECTION);
+    } else if (module_len == 3 && memcmp(module, "dns", 3) == 0) {
+        if (starts_with(message, length, LIT("exchange "))) {
+            event->type = SINGBOX_EVENT_DNS_QUERY;
+            event->address = address_after(line, message, length, 9);
+        } else if (starts_with(message, length, LIT("lookup domain "))) {
+            event->type = SINGBOX_EVENT_DNS_QUERY;
+            event->address = address_after(line, message, length, 14);
+        } else if (starts_with(message, length, LIT("exchanged ")) ||
+                   starts_with(message, length, LIT("cached "))) {
+            size_t prefix = message[7] == ' ' ? 7 : 10;
+            event->type = SINGBOX_EVENT_DNS_ANSWER;
+            event->address = address_after(line, message, length, prefix);
+        } else if (starts_with(message, length, LIT("lookup succeed for "))) {
+            event->type = SINGBOX_EVENT_DNS_ANSWER;
+            event->address = address_after(line, message, length, 19);
+        }
+    } else if (module_len == 6 && memcmp(module, "router", 6) == 0) {
+        const char* arrow = singbox_memmem_ci(message, length, "=> ", 3);
+        if (starts_with(message, length, LIT("match[")) && arrow) {
+            const char* tag = arrow + 3;
+            size_t tag_len = length - (size_t)(tag - message);
+            if (starts_with(tag, tag_len, LIT("route(")) && tag[tag_len - 1] == ')') {
+                tag += 6;
+                tag_len -= 7;
+            }
+            event->type = SINGBOX_EVENT_ROUTER_MATCH;
+            event->tag = make_span(line, tag, tag_len);
+        }
+    }
+
+    if (event->type == SINGBOX_EVENT_NONE && event->level < SINGBOX_LOG_ERROR &&
+        (singbox_memmem_ci(message, length, "closed", 6) || singbox_memmem_ci(message, length, "finished", 8)) &&
+        (starts_with(module, module_len, LIT("inbound/")) || starts_with(module, module_len, LIT("outbound/")) ||
+         (module_len == 10 && memcmp(module, "connection", 10) == 0))) {
+        event->type = SINGBOX_EVENT_CONNECTION_CLOSED;
+    }
+
+    if (event->level >= SINGBOX_LOG_ERROR) {
+        // Errors win: they feed error reporting regardless of the subsystem
+        event->type = SINGBOX_EVENT_ERROR;
+        if (event->address.length == 0) {
+            const char* to = singbox_memmem_ci(message, length, "connection to ", 14);
+            const char* from = to ? NULL : singbox_memmem_ci(message, length, "connection from ", 16);
+            const char* at = to ? to : from;
+            if (at) {
+                event->address = address_after(line, at, length - (size_t)(at - message), to ? 14 : 16);
+            }
+        }
+    }
+}
+
+size_t singbox_logparse_line(char* line, size_t length, singbox_log_event_t* event) {
+    memset(event, 0, sizeof(*event));
+    event->level = SINGBOX_LOG_INFO;
+
+    if (length > 0xFFFF) {
+        length = 0xFFFF; // Spans are 16 bit
+    }
+    length = strip_ansi(line, length);
+
+    const char* p = line;
+    size_t rest = length;
+    size_t used = parse_timestamp(p, rest, &event->timestamp);
+    if (used) {
+        event->flags |= SINGBOX_EVENT_HAS_TIMESTAMP;
+        p += used;
+        rest -= used;
+    }
+    used = parse_level(p, rest, &event->level);
+    p += used;
+    rest -= used;
+    used = parse_connection(p, rest, event);
+    p += used;
+    rest -= used;
+
+    // "module: message" where the module is a single word
+    const char* split = singbox_find_byte2(p, rest, ':', ' ');
+    if (split && *split == ':' && split != p && (size_t)(split - p) + 1 < rest && split[1] == ' ') {
+        event->module = make_span(line, p, (size_t)(split - p));
+        const char* open = singbox_find_byte(p, (size_t)(split - p), '[');
+        if (open && split[-1] == ']') {
+            event->tag = make_span(line, open + 1, (size_t)(split - open - 2));
+        }
+        p = split + 2;
+        rest = length - (size_t)(p - line);
+    }
+    event->message = make_span(line, p, rest);
+
+    classify(line, event);
+    return length;
+}
+
+static void deliver(singbox_logparse_stream_t* stream, char* line, size_t length,
+                    singbox_log_event_cb callback, void* ctx) {
+    if (length && line[length - 1] == '\r') {
+        length--;
+    }
+    singbox_log_event_t event;
+    length = singbox_logparse_line(line, length, &event);
+    line[length] = '\0';
+    stream->lines++;
+    if (callback) {
+        callback(&event, line, ctx);
+    }
+}
+
+size_t singbox_logparse_feed(singbox_logparse_stream_t* stream, char* data, size_t length,
+                             singbox_log_event_cb callback, void* ctx) {
+    size_t delivered = 0;
+    char* p = data;
+    char* end = data + length;
+
+    while (p < end) {
+        char* newline = (char*)singbox_find_byte(p, (size_t)(end - p), '\n');
+        size_t chunk = newline ? (size_t)(newline - p) : (size_t)(end - p);
+
+        if (stream->pending_len == 0 && !stream->discarding && newline && chunk < SINGBOX_LOGPARSE_MAX_LINE) {
+            // Fast path: the whole line is in the caller's buffer
+            deliver(stream, p, chunk, callback, ctx);
+            delivered++;
+        } else if (!stream->discarding) {
+            size_t room = SINGBOX_LOGPARSE_MAX_LINE - 1 - stream->pending_len;
+            size_t take = chunk < room ? chunk : room;
+            memcpy(stream->pending + stream->pending_len, p, take);
+            stream->pending_len += take;
+            if (take < chunk) {
+                // Over-long line: keep the head, drop the rest
+                stream->truncated_lines++;
+                stream->discarding = 1;
+            }
+            if (newline || stream->discarding) {
+                deliver(stream, stream->pending, stream->pending_len, callback, ctx);
+                stream->pending_len = 0;
+                delivered++;
+            }
+        }
+        if (newline) {
+            stream->discarding = 0;
+            p = newline + 1;
+        } else {
+            break;
+        }
+    }
+    return delivered;
+}
+
+size_t singbox_logparse_flush(singbox_logparse_stream_t* stream, singbox_log_event_cb callback, void* ctx) {
+    if (stream->pending_len == 0) {
+        return 0;
+    }
+    deliver(stream, stream->pending, stream->pending_len, callback, ctx);
+    stream->pending_len = 0;
+    return 1;
+}
+
+void singbox_log_event_account(singbox_log_event_counters_t* counters, const singbox_log_event_t* event) {
+    __atomic_fetch_add(&counters->lines, 1, __ATOMIC_RELAXED);
+    if (event->type < SINGBOX_EVENT_TYPE_COUNT) {
+        __atomic_fetch_add(&counters->by_type[event->type], 1, __ATOMIC_RELAXED);
+    }
+    if (event->level < 6) {
+        __atomic_fetch_add(&counters->by_level[event->level], 1, __ATOMIC_RELAXED);
+    }
+    if ((event->type == SINGBOX_EVENT_INBOUND_CONNECTION || event->type == SINGBOX_EVENT_OUTBOUND_CONNECTION) &&
+        event->network == SINGBOX_NETWORK_UDP) {
+        __atomic_fetch_add(&counters->udp_connections, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void singbox_log_event_snapshot(const singbox_log_event_counters_t* counters, singbox_log_event_counters_t* out) {
+    out->lines = __atomic_load_n(&counters->lines, __ATOMIC_RELAXED);
+    for (int i = 0; i < SINGBOX_EVENT_TYPE_COUNT; i++) {
+        out->by_type[i] = __atomic_load_n(&counters->by_type[i], __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < 6; i++) {
+        out->by_level[i] = __atomic_load_n(&counters->by_level[i], __ATOMIC_RELAXED);
+    }
+    out->udp_connections = __atomic_load_n(&counters->udp_connections, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,129 @@
+#ifndef SING_BOX_LOGPARSE_H
+#define SING_BOX_LOGPARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parser for sing-box log output.
+ *
+ * Understands both the plain and the ANSI colored console formats:
+ *
+ *   +0800 2024-05-01 12:00:00 INFO [3145278281 5ms] outbound/vless[proxy]: outbound connection to www.google.com:443
+ *   \x1b[36mINFO\x1b[0m [\x1b[38;5;45m3145278281\x1b[0m 0ms] dns: exchange www.google.com. IN A
+ *
+ * Lines are classified into compact typed events that refer back into the
+ * line buffer, so parsing performs no allocation. Color escapes are removed
+ * in place, which is why the parser takes a mutable buffer.
+ */
+
+#define SINGBOX_LOGPARSE_MAX_LINE 4096
+
+typedef enum {
+    SINGBOX_EVENT_NONE = 0,             // Line without a recognised structure
+    SINGBOX_EVENT_INBOUND_CONNECTION,
+    SINGBOX_EVENT_OUTBOUND_CONNECTION,
+    SINGBOX_EVENT_CONNECTION_CLOSED,
+    SINGBOX_EVENT_DNS_QUERY,
+    SINGBOX_EVENT_DNS_ANSWER,
+    SINGBOX_EVENT_ROUTER_MATCH,
+    SINGBOX_EVENT_ERROR,
+    SINGBOX_EVENT_TYPE_COUNT
+} singbox_event_type_t;
+
+typedef enum {
+    SINGBOX_NETWORK_UNKNOWN = 0,
+    SINGBOX_NETWORK_TCP,
+    SINGBOX_NETWORK_UDP
+} singbox_network_t;
+
+#define SINGBOX_EVENT_HAS_TIMESTAMP 0x01
+#define SINGBOX_EVENT_HAS_CONNECTION 0x02
+
+// Position of a field inside the (ANSI stripped) line
+typedef struct {
+    uint16_t offset;
+    uint16_t length;
+} singbox_span_t;
+
+typedef struct {
+    uint8_t type;               // singbox_event_type_t
+    uint8_t level;              // SINGBOX_LOG_* (INFO when the line has no level)
+    uint8_t network;            // singbox_network_t
+    uint8_t flags;              // SINGBOX_EVENT_HAS_*
+    uint32_t connection_id;     // From "[id duration]"
+    uint32_t duration_ms;
+    int64_t timestamp;          // Unix seconds (UTC) when HAS_TIMESTAMP
+    singbox_span_t module;      // "outbound/vless[proxy]", "dns", "router"
+    singbox_span_t tag;         // "proxy" or the outbound chosen by a router match
+    singbox_span_t address;     // Peer host:port or queried domain
+    singbox_span_t message;     // Text after "module: "
+} singbox_log_event_t;
+
+// Streaming state for singbox_logparse_feed(); zero initialise before use
+typedef struct {
+    char pending[SINGBOX_LOGPARSE_MAX_LINE];
+    size_t pending_len;
+    int discarding;             // Inside an over-long line
+    uint64_t lines;
+    uint64_t truncated_lines;
+} singbox_logparse_stream_t;
+
+// Event totals for stats and diagnostics; updated with relaxed atomics
+typedef struct {
+    uint64_t lines;
+    uint64_t by_type[SINGBOX_EVENT_TYPE_COUNT];
+    uint64_t by_level[6];
+    uint64_t udp_connections;
+} singbox_log_event_counters_t;
+
+typedef void (*singbox_log_event_cb)(const singbox_log_event_t* event, const char* line, void* ctx);
+
+/**
+ * Parse one line (without its newline)
+ * @param line Line buffer, modified in place when it contains color escapes
+ * @param length Line length
+ * @param event Output event; spans index into `line`
+ * @return Length of the line after escape removal
+ */
+size_t singbox_logparse_line(char* line, size_t length, singbox_log_event_t* event);
+
+/**
+ * Split a chunk of process output into lines and parse each complete one.
+ * A trailing partial line is kept in the stream and completed by the next
+ * call. Lines longer than SINGBOX_LOGPARSE_MAX_LINE are truncated.
+ * @param data Chunk buffer, modified in place
+ * @return Number of lines delivered to the callback
+ */
+size_t singbox_logparse_feed(singbox_logparse_stream_t* stream, char* data, size_t length,
+                             singbox_log_event_cb callback, void* ctx);
+
+/**
+ * Deliver a buffered partial line, e.g. when the process exits
+ */
+size_t singbox_logparse_flush(singbox_logparse_stream_t* stream, singbox_log_event_cb callback, void* ctx);
+
+/**
+ * Add an event to the totals
+ */
+void singbox_log_event_account(singbox_log_event_counters_t* counters, const singbox_log_event_t* event);
+
+/**
+ * Take a consistent-enough copy of the totals for reporting
+ */
+void singbox_log_event_snapshot(const singbox_log_event_counters_t* counters, singbox_log_event_counters_t* out);
+
+/**
+ * Stable lowercase name of an event type ("inbound_connection", ...)
+ */
+const char* singbox_event_type_name(int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGPARSE_H
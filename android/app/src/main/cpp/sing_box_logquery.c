@@ -0,0 +1,278 @@
+#include "sing_box_logquery.h"
+#include "sing_box_simd.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_TOKEN 512
+
+static const char* level_names[] = {
+    "trace", "debug", "info", "warn", "error", "fatal"
+};
+
+static void set_error(char* error, size_t error_size, const char* format, const char* detail) {
+    if (error && error_size) {
+        snprintf(error, error_size, format, detail);
+    }
+}
+
+int singbox_log_level_from_name(const char* name, size_t length) {
+    if (!name || length == 0) {
+        return -1;
+    }
+    if (length == 1 && name[0] >= '0' && name[0] <= '5') {
+        return name[0] - '0';
+    }
+    for (int i = 0; i < 6; i++) {
+        if (strlen(level_names[i]) == length && strncasecmp(name, level_names[i], length) == 0) {
+            return i;
+        }
+    }
+    // Accept sing-box's own spellings
+    if (length == 7 && strncasecmp(name, "warning", 7) == 0) {
+        return 3;
+    }
+    if (length == 5 && strncasecmp(name, "panic", 5) == 0) {
+        return 5;
+    }
+    return -1;
+}
+
+/**
+ * Parse "15m", "2h", "30s", "1d" (relative to now) or an absolute epoch ms value
+ */
+static int parse_time(const char* value, int64_t now_ms, int64_t* out) {
+    char* end = NULL;
+    long long number = strtoll(value, &end, 10);
+    if (end == value || number < 0) {
+        return -1;
+    }
+    int64_t unit = 0;
+    switch (*end) {
+        case '\0': *out = number; return 0;
+        case 's': unit = 1000; break;
+        case 'm': unit = 60 * 1000; break;
+        case 'h': unit = 60 * 60 * 1000; break;
+        case 'd': unit = 24 * 60 * 60 * 1000; break;
+        default: return -1;
+    }
+    if (end[1] != '\0') {
+        return -1;
+    }
+    *out = now_ms - (int64_t)number * unit;
+    return 0;
+}
+
+/**
+ * Copy the next token into `token`, removing quotes.
+ * Returns the position after the token, or NULL at the end of input.
+ * `quoted` is set when the whole token was a quoted phrase.
+ */
+static const char* next_token(const char* p, char* token, size_t token_size, int* quoted) {
+    while (*p && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (!*p) {
+        return NULL;
+    }
+
+    size_t length = 0;
+    *quoted = (*p == '"');
+    int in_quotes = 0;
+    while (*p && (in_quotes || !isspace((unsigned char)*p))) {
+        if (*p == '"') {
+            in_quotes = !in_quotes;
+        } else if (length + 1 < token_size) {
+            token[length++] = *p;
+        }
+        p++;
+    }
+    token[length] = '\0';
+    return p;
+}
+
+static int append_text(singbox_log_query_t* query, const char* word) {
+    size_t word_len = strlen(word);
+    size_t needed = query->text_len + (query->text_len ? 1 : 0) + word_len;
+    if (needed >= sizeof(query->text)) {
+        return -1;
+    }
+    if (query->text_len) {
+        query->text[query->text_len++] = ' ';
+    }
+    memcpy(query->text + query->text_len, word, word_len);
+    query->text_len += word_len;
+    query->text[query->text_len] = '\0';
+    return 0;
+}
+
+static int compile_regex(singbox_log_query_t* query, const char* pattern, char* error, size_t error_size) {
+    if (query->has_regex) {
+        set_error(error, error_size, "only one regex allowed: %s", pattern);
+        return -1;
+    }
+    int rc = regcomp(&query->regex, pattern, REG_EXTENDED | REG_ICASE | REG_NOSUB);
+    if (rc != 0) {
+        char message[128];
+        regerror(rc, &query->regex, message, sizeof(message));
+        set_error(error, error_size, "invalid regex: %s", message);
+        return -1;
+    }
+    query->has_regex = 1;
+    return 0;
+}
+
+int singbox_log_query_parse(singbox_log_query_t* query, const char* text, int64_t now_ms,
+                            char* error, size_t error_size) {
+    memset(query, 0, sizeof(*query));
+    query->min_level = -1;
+    query->newest_first = 1;
+    if (error && error_size) {
+        error[0] = '\0';
+    }
+    if (!text) {
+        return 0;
+    }
+
+    char token[MAX_TOKEN];
+    int quoted = 0;
+    const char* p = text;
+    while ((p = next_token(p, token, sizeof(token), &quoted)) != NULL) {
+        if (quoted || token[0] == '\0') {
+            if (token[0] && append_text(query, token) != 0) {
+                set_error(error, error_size, "search text too long: %s", token);
+                goto fail;
+            }
+            continue;
+        }
+
+        const char* value = NULL;
+        if (strncasecmp(token, "level>=", 7) == 0) {
+            value = token + 7;
+        } else if (strncasecmp(token, "level:", 6) == 0) {
+            value = token + 6;
+        }
+        if (value) {
+            query->min_level = singbox_log_level_from_name(value, strlen(value));
+            if (query->min_level < 0) {
+                set_error(error, error_size, "unknown level: %s", value);
+                goto fail;
+            }
+            continue;
+        }
+
+        if (strncasecmp(token, "module:", 7) == 0) {
+            size_t length = strlen(token + 7);
+            if (length > SINGBOX_LOGFILE_MAX_MODULE) {
+                length = SINGBOX_LOGFILE_MAX_MODULE;
+            }
+            memcpy(query->module, token + 7, length);
+            query->module[length] = '\0';
+            query->module_len = length;
+        } else if (strncasecmp(token, "since:", 6) == 0) {
+            if (parse_time(token + 6, now_ms, &query->since_ms) != 0) {
+                set_error(error, error_size, "invalid time: %s", token + 6);
+                goto fail;
+            }
+        } else if (strncasecmp(token, "until:", 6) == 0) {
+            if (parse_time(token + 6, now_ms, &query->until_ms) != 0) {
+                set_error(error, error_size, "invalid time: %s", token + 6);
+                goto fail;
+            }
+        } else if (strncasecmp(token, "order:", 6) == 0) {
+            if (strcasecmp(token + 6, "oldest") == 0) {
+                query->newest_first = 0;
+            } else if (strcasecmp(token + 6, "newest") == 0) {
+                query->newest_first = 1;
+            } else {
+                set_error(error, error_size, "unknown order: %s", token + 6);
+                goto fail;
+            }
+        } else if (strncasecmp(token, "re:", 3) == 0) {
+            if (compile_regex(query, token + 3, error, error_size) != 0) {
+                goto fail;
+            }
+        } else if (token[0] == '/' && strlen(token) > 2 && token[strlen(token) - 1] == '/') {
+            token[strlen(token) - 1] = '\0';
+            if (compile_regex(query, token + 1, error, error_size) != 0) {
+                goto fail;
+            }
+        } else if (append_text(query, token) != 0) {
+            set_error(error, error_size, "search text too long: %s", token);
+            goto fail;
+        }
+    }
+    return 0;
+
+fail:
+    singbox_log_query_free(query);
+    return -1;
+}
+
+void singbox_log_query_free(singbox_log_query_t* query) {
+    if (query && query->has_regex) {
+        regfree(&query->regex);
+        query->has_regex = 0;
+    }
+}
+
+int singbox_log_query_match(const singbox_log_query_t* query, const singbox_log_view_t* record) {
+    // Cheapest tests first; the substring and regex scans only see survivors
+    if (record->level < query->min_level) {
+        return 0;
+    }
+    if (query->since_ms && record->timestamp_ms < query->since_ms) {
+        return 0;
+    }
+    if (query->until_ms && record->timestamp_ms > query->until_ms) {
+        return 0;
+    }
+    if (query->module_len &&
+        (record->module_len < query->module_len ||
+         strncasecmp(record->module, query->module, query->module_len) != 0)) {
+        return 0;
+    }
+    if (query->text_len &&
+        !singbox_memmem_ci(record->message, record->message_len, query->text, query->text_len)) {
+        return 0;
+    }
+    if (query->has_regex) {
+        // regexec() needs a terminated string
+        char buffer[SINGBOX_LOGFILE_MAX_MESSAGE + 1];
+        size_t length = record->message_len < SINGBOX_LOGFILE_MAX_MESSAGE
+            ? record->message_len : SINGBOX_LOGFILE_MAX_MESSAGE;
+        memcpy(buffer, record->message, length);
+        buffer[length] = '\0';
+        if (regexec(&query->regex, buffer, 0, NULL, 0) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void singbox_log_pager_init(singbox_log_pager_t* pager, const singbox_log_query_t* query,
+                            size_t offset, size_t limit,
+                            int (*emit)(const singbox_log_view_t* record, void* ctx), void* emit_ctx) {
+    memset(pager, 0, sizeof(*pager));
+    pager->query = query;
+    pager->offset = offset;
+    pager->limit = limit;
+    pager->emit = emit;
+    pager->emit_ctx = emit_ctx;
+}
+
+int singbox_log_pager_visit(const singbox_log_view_t* record, void* ctx) {
+    singbox_log_pager_t* pager = (singbox_log_pager_t*)ctx;
+    pager->scanned++;
+    if (!singbox_log_query_match(pager->query, record)) {
+        return 0;
+    }
+    size_t index = pager->matched++;
+    if (index >= pager->offset && (pager->limit == 0 || index - pager->offset < pager->limit) && pager->emit) {
+        pager->emit(record, pager->emit_ctx);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef SING_BOX_LOGQUERY_H
+#define SING_BOX_LOGQUERY_H
+
+#include <regex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sing_box_logfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Native log query engine.
+ *
+ * A query is a whitespace separated list of terms, all of which must match:
+ *
+ *   level>=warn        minimum level (also level:warn, level>=3)
+ *   module:dns         module name prefix, case-insensitive
+ *   since:15m          newer than 15 minutes ago (s, m, h, d) or epoch ms
+ *   until:1700000000000
+ *   re:timeout|refused POSIX extended regex, case-insensitive (or /.../)
+ *   order:oldest       oldest entries first (default newest first)
+ *   anything else      case-insensitive substring; several words or a
+ *                      "quoted phrase" are matched as one phrase
+ *
+ * Records are passed in as singbox_log_view_t, so the same query runs over
+ * the in-memory ring and over decoded persistent log files.
+ */
+
+#define SINGBOX_LOG_QUERY_MAX_TEXT 256
+
+typedef struct {
+    int min_level;                  // -1 = any level
+    int64_t since_ms;               // 0 = unbounded
+    int64_t until_ms;               // 0 = unbounded
+    char module[SINGBOX_LOGFILE_MAX_MODULE + 1];
+    size_t module_len;
+    char text[SINGBOX_LOG_QUERY_MAX_TEXT];
+    size_t text_len;
+    int has_regex;
+    regex_t regex;
+    int newest_first;
+} singbox_log_query_t;
+
+/*
+ * Applies a query to a stream of records and keeps one page of the matches.
+ * Use singbox_log_pager_visit() as the visit callback of any record source.
+ */
+typedef struct {
+    const singbox_log_query_t* query;
+    size_t offset;                  // Matches to skip
+    size_t limit;                   // Page size (0 = unlimited)
+    size_t matched;                 // Total matches seen so far
+    size_t scanned;                 // Records examined
+    int (*emit)(const singbox_log_view_t* record, void* ctx);
+    void* emit_ctx;
+} singbox_log_pager_t;
+
+/**
+ * Parse a query string
+ * @param query Output, release with singbox_log_query_free()
+ * @param text Query text (NULL or empty matches everything)
+ * @param now_ms Current wall clock time, used for relative since/until
+ * @param error Optional buffer for a human readable parse error
+ * @param error_size Size of the error buffer
+ * @return 0 on success, -1 on a malformed query
+ */
+int singbox_log_query_parse(singbox_log_query_t* query, const char* text, int64_t now_ms,
+                            char* error, size_t error_size);
+
+/**
+ * Release resources held by a parsed query
+ */
+void singbox_log_query_free(singbox_log_query_t* query);
+
+/**
+ * Test a single record against a query
+ * @return 1 if the record matches
+ */
+int singbox_log_query_match(const singbox_log_query_t* query, const singbox_log_view_t* record);
+
+/**
+ * Prepare a pager for one page of results
+ */
+void singbox_log_pager_init(singbox_log_pager_t* pager, const singbox_log_query_t* query,
+                            size_t offset, size_t limit,
+                            int (*emit)(const singbox_log_view_t* record, void* ctx), void* emit_ctx);
+
+/**
+ * Visit callback: counts matches and forwards those on the requested page
+ * @return Always 0 so the source keeps going and `matched` ends up as the total
+ */
+int singbox_log_pager_visit(const singbox_log_view_t* record, void* pager);
+
+/**
+ * Parse a level name ("warn", "ERROR", ...) or number
+ * @return Level or -1 if unknown
+ */
+int singbox_log_level_from_name(const char* name, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGQUERY_H
@@ -0,0 +1,365 @@
+#include "sing_box_logring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_lz.h"
+
+/*
+ * Record layout inside a block: varint sequence delta, zigzag varint
+ * timestamp delta (both against the previous record of the block, absolute
+ * for the first one), level byte, module length byte, varint message length,
+ * then the module and message bytes. Small deltas keep the headers both
+ * short and repetitive, which the LZ stage turns into a few bytes.
+ */
+#define MAX_RECORD_HEADER (10 + 10 + 2 + 3)
+
+// Records per block are capped so the reverse-walk index stays small
+#define MIN_AVERAGE_RECORD 16
+
+// Smallest sealed block worth a descriptor; LZ output for a full block of
+// repeated text is still larger than this
+#define MIN_STORED_BLOCK 64
+
+typedef struct {
+    uint32_t offset;            // Position in the arena
+    uint32_t stored_len;
+    uint32_t raw_len;
+    uint32_t records;
+    uint8_t compressed;
+} block_desc_t;
+
+struct singbox_logring {
+    uint8_t* arena;
+    uint32_t capacity;
+    uint32_t block_size;
+    uint32_t write_pos;
+
+    block_desc_t* blocks;       // Circular, oldest at first_block
+    uint32_t max_blocks;
+    uint32_t first_block;
+    uint32_t block_count;
+
+    uint8_t* open;              // Records not sealed yet
+    uint32_t open_len;
+    uint32_t open_records;
+    uint64_t open_last_seq;
+    int64_t open_last_ms;
+    uint32_t max_records;       // Per block
+
+    uint8_t* scratch;           // Compression output and decode buffer
+    singbox_log_view_t* index;  // Decoded records of one block, for reverse walks
+
+    uint64_t sealed_records;
+    uint64_t sealed_raw;
+    uint64_t sealed_stored;
+    singbox_logring_stats_t counters;
+};
+
+singbox_logring_t* singbox_logring_create(size_t capacity, size_t block_size) {
+    if (block_size == 0) {
+        block_size = SINGBOX_LOGRING_DEFAULT_BLOCK_SIZE;
+    }
+    if (block_size < SINGBOX_LOGRING_MIN_BLOCK_SIZE) {
+        block_size = SINGBOX_LOGRING_MIN_BLOCK_SIZE;
+    }
+    if (block_size > SINGBOX_LOGRING_MAX_BLOCK_SIZE) {
+        block_size = SINGBOX_LOGRING_MAX_BLOCK_SIZE;
+    }
+    if (capacity == 0) {
+        capacity = SINGBOX_LOGRING_DEFAULT_CAPACITY;
+    }
+    if (capacity < block_size * 4) {
+        capacity = block_size * 4;
+    }
+    if (capacity > UINT32_MAX / 2) {
+        return NULL;
+    }
+
+    singbox_logring_t* ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    ring->capacity = (uint32_t)capacity;
+    ring->block_size = (uint32_t)block_size;
+    ring->max_blocks = (uint32_t)(capacity / MIN_STORED_BLOCK) + 1;
+    ring->arena = malloc(capacity);
+    ring->blocks = malloc(ring->max_blocks * sizeof(block_desc_t));
+    ring->open = malloc(block_size);
+    ring->scratch = malloc(block_size);
+    ring->max_records = (uint32_t)(block_size / MIN_AVERAGE_RECORD);
+    ring->index = malloc(ring->max_records * sizeof(singbox_log_view_t));
+    if (!ring->arena || !ring->blocks || !ring->open || !ring->scratch || !ring->index) {
+        singbox_logring_destroy(ring);
+        return NULL;
+    }
+    ring->counters.capacity = ring->capacity;
+    ring->counters.block_size = ring->block_size;
+    return ring;
+}
+
+void singbox_logring_destroy(singbox_logring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    free(ring->arena);
+    free(ring->blocks);
+    free(ring->open);
+    free(ring->scratch);
+    free(ring->index);
+    free(ring);
+}
+
+void singbox_logring_clear(singbox_logring_t* ring) {
+    ring->write_pos = 0;
+    ring->first_block = 0;
+    ring->block_count = 0;
+    ring->open_len = 0;
+    ring->open_records = 0;
+    ring->sealed_records = 0;
+    ring->sealed_raw = 0;
+    ring->sealed_stored = 0;
+}
+
+size_t singbox_logring_count(const singbox_logring_t* ring) {
+    return (size_t)(ring->sealed_records + ring->open_records);
+}
+
+static block_desc_t* block_at(const singbox_logring_t* ring, uint32_t index) {
+    return &ring->blocks[(ring->first_block + index) % ring->max_blocks];
+}
+
+static void evict_oldest(singbox_logring_t* ring) {
+    block_desc_t* oldest = block_at(ring, 0);
+    ring->sealed_records -= oldest->records;
+    ring->sealed_raw -= oldest->raw_len;
+    ring->sealed_stored -= oldest->stored_len;
+    ring->counters.evicted_records += oldest->records;
+    ring->counters.evicted_blocks++;
+    ring->first_block = (ring->first_block + 1) % ring->max_blocks;
+    ring->block_count--;
+}
+
+/**
+ * Find a contiguous arena range of `length` bytes, evicting the oldest
+ * blocks it overlaps. Blocks are laid out in allocation order; once the
+ * newest block wraps to the start, the free space is the gap up to the
+ * oldest one.
+ */
+static uint32_t allocate(singbox_logring_t* ring, uint32_t length) {
+    if (ring->block_count == ring->max_blocks) {
+        evict_oldest(ring);
+    }
+    for (;;) {
+        if (ring->block_count == 0) {
+            ring->write_pos = 0;
+            return 0;
+        }
+        const block_desc_t* oldest = block_at(ring, 0);
+        const block_desc_t* newest = block_at(ring, ring->block_count - 1);
+        if (newest->offset >= oldest->offset) {
+            // Used space is [oldest, write_pos): free at the end and at the start
+            if (ring->write_pos + length <= ring->capacity) {
+                return ring->write_pos;
+            }
+            if (length <= oldest->offset) {
+                ring->write_pos = 0;
+                return 0;
+            }
+        } else if (ring->write_pos + length <= oldest->offset) {
+            // Wrapped: free space is the gap in front of the oldest block
+            return ring->write_pos;
+        }
+        evict_oldest(ring);
+    }
+}
+
+static void seal_open_block(singbox_logring_t* ring) {
+    if (ring->open_records == 0) {
+        return;
+    }
+    // Only keep the compressed form when it actually saves space
+    size_t compressed = singbox_lz_compress(ring->open, ring->open_len, ring->scratch, ring->open_len - 1);
+    const uint8_t* data = compressed ? ring->scratch : ring->open;
+    uint32_t stored_len = compressed ? (uint32_t)compressed : ring->open_len;
+
+    uint32_t offset = allocate(ring, stored_len);
+    memcpy(ring->arena + offset, data, stored_len);
+    ring->write_pos = offset + stored_len;
+
+    block_desc_t* block = &ring->blocks[(ring->first_block + ring->block_count) % ring->max_blocks];
+    block->offset = offset;
+    block->stored_len = stored_len;
+    block->raw_len = ring->open_len;
+    block->records = ring->open_records;
+    block->compressed = compressed != 0;
+    ring->block_count++;
+
+    ring->sealed_records += block->records;
+    ring->sealed_raw += block->raw_len;
+    ring->sealed_stored += stored_len;
+    if (!compressed) {
+        ring->counters.raw_blocks++;
+    }
+    ring->open_len = 0;
+    ring->open_records = 0;
+}
+
+static uint8_t* put_varint(uint8_t* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+void singbox_logring_append(singbox_logring_t* ring, uint64_t seq, int64_t timestamp_ms, int level,
+                            const char* module, size_t module_len, const char* message, size_t message_len) {
+    if (module_len > SINGBOX_LOGFILE_MAX_MODULE) {
+        module_len = SINGBOX_LOGFILE_MAX_MODULE;
+    }
+    if (message_len > SINGBOX_LOGRING_MAX_MESSAGE) {
+        message_len = SINGBOX_LOGRING_MAX_MESSAGE;
+        ring->counters.truncated++;
+    }
+    if (ring->open_len + MAX_RECORD_HEADER + module_len + message_len > ring->block_size ||
+        ring->open_records == ring->max_records) {
+        seal_open_block(ring);
+    }
+
+    uint64_t seq_delta = seq;
+    int64_t time_delta = timestamp_ms;
+    if (ring->open_records) {
+        seq_delta = seq - ring->open_last_seq;
+        time_delta = timestamp_ms - ring->open_last_ms;
+    }
+    uint8_t* start = ring->open + ring->open_len;
+    uint8_t* p = put_varint(start, seq_delta);
+    p = put_varint(p, ((uint64_t)time_delta << 1) ^ (uint64_t)(time_delta >> 63));
+    *p++ = (uint8_t)level;
+    *p++ = (uint8_t)module_len;
+    p = put_varint(p, message_len);
+    memcpy(p, module, module_len);
+    memcpy(p + module_len, message, message_len);
+    p += module_len + message_len;
+
+    ring->open_len += (uint32_t)(p - start);
+    ring->open_records++;
+    ring->open_last_seq = seq;
+    ring->open_last_ms = timestamp_ms;
+    ring->counters.appended++;
+}
+
+/**
+ * Decode the record at `p`; `view` carries the previous record's sequence
+ * and timestamp in and this record's out
+ * @return Position after the record, NULL if the block is malformed
+ */
+static const uint8_t* decode_record(const uint8_t* p, const uint8_t* end, int first, singbox_log_view_t* view) {
+    uint64_t seq_delta, time_delta, message_len;
+    if (!(p = get_varint(p, end, &seq_delta)) || !(p = get_varint(p, end, &time_delta)) || end - p < 2) {
+        return NULL;
+    }
+    int64_t time_value = (int64_t)(time_delta >> 1) ^ -(int64_t)(time_delta & 1);
+    view->seq = first ? seq_delta : view->seq + seq_delta;
+    view->timestamp_ms = first ? time_value : view->timestamp_ms + time_value;
+    view->level = p[0];
+    view->module_len = p[1];
+    if (!(p = get_varint(p + 2, end, &message_len)) ||
+        (uint64_t)(end - p) < view->module_len + message_len) {
+        return NULL;
+    }
+    view->module = (const char*)p;
+    view->message = view->module + view->module_len;
+    view->message_len = (size_t)message_len;
+    return p + view->module_len + message_len;
+}
+
+/**
+ * Visit the records of one uncompressed block
+ * @return 1 if the callback asked to stop, 0 to continue, -1 if the block is malformed
+ */
+static int visit_block(singbox_logring_t* ring, const uint8_t* data, uint32_t length,
+                       int newest_first, int (*callback)(const singbox_log_view_t* record, void* ctx),
+                       void* ctx, long* visited) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + length;
+    singbox_log_view_t view = {0};
+    uint32_t count = 0;
+
+    while (p < end) {
+        if (!(p = decode_record(p, end, p == data, &view))) {
+            return -1;
+        }
+        if (newest_first) {
+            if (count == ring->max_records) {
+                return -1;
+            }
+            ring->index[count++] = view;
+            continue;
+        }
+        (*visited)++;
+        if (callback(&view, ctx)) {
+            return 1;
+        }
+    }
+
+    while (count > 0) {
+        (*visited)++;
+        if (callback(&ring->index[--count], ctx)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static const uint8_t* load_block(singbox_logring_t* ring, const block_desc_t* block) {
+    const uint8_t* stored = ring->arena + block->offset;
+    if (!block->compressed) {
+        return stored;
+    }
+    long length = singbox_lz_decompress(stored, block->stored_len, ring->scratch, ring->block_size);
+    return length == (long)block->raw_len ? ring->scratch : NULL;
+}
+
+long singbox_logring_visit(singbox_logring_t* ring, int newest_first,
+                           int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx) {
+    long visited = 0;
+    int result = 0;
+    if (newest_first) {
+        result = visit_block(ring, ring->open, ring->open_len, 1, callback, ctx, &visited);
+    }
+
+    for (uint32_t i = 0; i < ring->block_count && result == 0; i++) {
+        const block_desc_t* block = block_at(ring, newest_first ? ring->block_count - 1 - i : i);
+        const uint8_t* data = load_block(ring, block);
+        result = data ? visit_block(ring, data, block->raw_len, newest_first, callback, ctx, &visited) : -1;
+    }
+
+    if (!newest_first && result == 0) {
+        result = visit_block(ring, ring->open, ring->open_len, 0, callback, ctx, &visited);
+    }
+    return result < 0 ? -1 : visited;
+}
+
+void singbox_logring_get_stats(const singbox_logring_t* ring, singbox_logring_stats_t* stats) {
+    *stats = ring->counters;
+    stats->records = ring->sealed_records + ring->open_records;
+    stats->blocks = ring->block_count;
+    stats->raw_bytes = ring->sealed_raw + ring->open_len;
+    stats->stored_bytes = ring->sealed_stored + ring->open_len;
+}
@@ -0,0 +1,96 @@
+#ifndef SING_BOX_LOGRING_H
+#define SING_BOX_LOGRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sing_box_logfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Block-compressed in-memory log ring.
+ *
+ * Records are packed back to back, with their real length, into an open
+ * block of block_size bytes. When the open block is full it is sealed:
+ * compressed with the in-tree LZ codec (sing_box_lz.h), or kept raw if that
+ * does not save space, and copied into a fixed arena that is used as a
+ * circular buffer. When the arena is full, the oldest sealed blocks are
+ * evicted. Only readers pay for decompression, one block at a time.
+ *
+ * Memory is allocated once at creation. It is the arena (`capacity` bytes)
+ * plus the open block, one decode buffer of block_size, and the block
+ * descriptors.
+ *
+ * Not thread safe: callers serialise access (sing_box_logging.c holds the
+ * buffer mutex). Record views passed to visitors point into internal
+ * buffers and are only valid during the callback.
+ */
+
+#define SINGBOX_LOGRING_DEFAULT_CAPACITY (448 * 1024)
+#define SINGBOX_LOGRING_DEFAULT_BLOCK_SIZE (16 * 1024)
+#define SINGBOX_LOGRING_MIN_BLOCK_SIZE (8 * 1024)     // Holds the largest record
+#define SINGBOX_LOGRING_MAX_BLOCK_SIZE (64 * 1024)
+#define SINGBOX_LOGRING_MAX_MESSAGE SINGBOX_LOGFILE_MAX_MESSAGE
+
+typedef struct {
+    uint64_t records;           // Records currently held
+    uint64_t blocks;            // Sealed blocks currently held
+    uint64_t raw_bytes;         // Uncompressed size of the records held
+    uint64_t stored_bytes;      // Bytes they occupy (sealed blocks + open block fill)
+    uint64_t appended;          // Records appended since creation
+    uint64_t evicted_records;
+    uint64_t evicted_blocks;
+    uint64_t truncated;         // Messages cut to SINGBOX_LOGRING_MAX_MESSAGE
+    uint64_t raw_blocks;        // Blocks stored uncompressed (incompressible)
+    uint32_t capacity;
+    uint32_t block_size;
+} singbox_logring_stats_t;
+
+typedef struct singbox_logring singbox_logring_t;
+
+/**
+ * Allocate a ring
+ * @param capacity Arena size for sealed blocks (0 = default, at least 4 blocks)
+ * @param block_size Uncompressed block size (0 = default, clamped to the limits above)
+ * @return Ring or NULL on allocation failure
+ */
+singbox_logring_t* singbox_logring_create(size_t capacity, size_t block_size);
+
+void singbox_logring_destroy(singbox_logring_t* ring);
+
+/**
+ * Append a record; the module is cut to SINGBOX_LOGFILE_MAX_MODULE bytes and
+ * the message to SINGBOX_LOGRING_MAX_MESSAGE bytes
+ */
+void singbox_logring_append(singbox_logring_t* ring, uint64_t seq, int64_t timestamp_ms, int level,
+                            const char* module, size_t module_len, const char* message, size_t message_len);
+
+/**
+ * Drop every record (the arena stays allocated)
+ */
+void singbox_logring_clear(singbox_logring_t* ring);
+
+/**
+ * Number of records currently held
+ */
+size_t singbox_logring_count(const singbox_logring_t* ring);
+
+/**
+ * Visit the records in order, decompressing one sealed block at a time
+ * @param newest_first Non-zero to start from the most recent record
+ * @param callback Invoked per record; return non-zero to stop
+ * @return Number of records visited, or -1 if a block failed to decode
+ */
+long singbox_logring_visit(singbox_logring_t* ring, int newest_first,
+                           int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx);
+
+void singbox_logring_get_stats(const singbox_logring_t* ring, singbox_logring_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGRING_H
@@ -0,0 +1,199 @@
+#include "sing_box_logtail.h"
+
+#include <string.h>
+
+#define ALIGN8(n) (((n) + 7u) & ~(size_t)7u)
+#define MAX_RECORD ALIGN8(SINGBOX_LOGTAIL_RECORD_HEADER + SINGBOX_LOGFILE_MAX_MODULE + SINGBOX_LOGFILE_MAX_MESSAGE)
+
+_Static_assert(sizeof(singbox_logtail_t) == SINGBOX_LOGTAIL_HEADER_SIZE, "log tail layout");
+_Static_assert(offsetof(singbox_logtail_t, capacity) == 8, "log tail layout");
+_Static_assert(offsetof(singbox_logtail_t, head) == 16, "log tail layout");
+_Static_assert(offsetof(singbox_logtail_t, tail) == 24, "log tail layout");
+_Static_assert(offsetof(singbox_logtail_t, records) == 32, "log tail layout");
+_Static_assert(SINGBOX_LOGFILE_MAX_MODULE <= UINT8_MAX, "module length field");
+_Static_assert(SINGBOX_LOGFILE_MAX_MESSAGE <= UINT16_MAX, "message length field");
+_Static_assert(2 * MAX_RECORD <= SINGBOX_LOGTAIL_MIN_SIZE - SINGBOX_LOGTAIL_HEADER_SIZE, "minimum size");
+
+/*
+ * Record bytes are moved as whole 64-bit words with relaxed atomics (records
+ * are 8-byte aligned and sized), so a reader racing with the writer performs
+ * well-defined loads; the fences around `tail` decide whether a copy is kept.
+ */
+static uint64_t* word_at(const singbox_logtail_t* region, uint64_t offset) {
+    return (uint64_t*)(region->data + offset % region->capacity);
+}
+
+static void store_words(singbox_logtail_t* region, uint64_t offset, const uint64_t* words, size_t count) {
+    uint64_t* target = word_at(region, offset);
+    for (size_t i = 0; i < count; i++) {
+        __atomic_store_n(&target[i], words[i], __ATOMIC_RELAXED);
+    }
+}
+
+static void load_words(const singbox_logtail_t* region, uint64_t offset, uint64_t* words, size_t count) {
+    const uint64_t* source = word_at(region, offset);
+    for (size_t i = 0; i < count; i++) {
+        words[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+    }
+}
+
+static uint32_t record_size(uint64_t first_word) {
+    uint32_t size;
+    memcpy(&size, &first_word, sizeof(size));
+    return size;
+}
+
+singbox_logtail_t* singbox_logtail_init(void* memory, size_t size) {
+    if (!memory || size < SINGBOX_LOGTAIL_MIN_SIZE || ((uintptr_t)memory & 63) != 0) {
+        return NULL;
+    }
+    size_t capacity = (size - SINGBOX_LOGTAIL_HEADER_SIZE) & ~(size_t)7u;
+    if (capacity > UINT32_MAX) {
+        capacity = UINT32_MAX & ~(size_t)7u;
+    }
+
+    singbox_logtail_t* region = memory;
+    memset(region, 0, SINGBOX_LOGTAIL_HEADER_SIZE);
+    region->version = SINGBOX_LOGTAIL_VERSION;
+    region->header_size = SINGBOX_LOGTAIL_HEADER_SIZE;
+    region->capacity = (uint32_t)capacity;
+    __atomic_store_n(&region->magic, SINGBOX_LOGTAIL_MAGIC, __ATOMIC_RELEASE);
+    return region;
+}
+
+void singbox_logtail_append(singbox_logtail_t* region, uint64_t seq, int64_t timestamp_ms, int level,
+                            const char* module, size_t module_len,
+                            const char* message, size_t message_len) {
+    if (module_len > SINGBOX_LOGFILE_MAX_MODULE) {
+        module_len = SINGBOX_LOGFILE_MAX_MODULE;
+    }
+    if (message_len > SINGBOX_LOGFILE_MAX_MESSAGE) {
+        message_len = SINGBOX_LOGFILE_MAX_MESSAGE;
+    }
+
+    uint64_t record[MAX_RECORD / 8];
+    uint8_t* bytes = (uint8_t*)record;
+    uint32_t size = (uint32_t)ALIGN8(SINGBOX_LOGTAIL_RECORD_HEADER + module_len + message_len);
+    uint16_t message_length = (uint16_t)message_len;
+    memcpy(bytes, &size, 4);
+    bytes[4] = (uint8_t)level;
+    bytes[5] = (uint8_t)module_len;
+    memcpy(bytes + 6, &message_length, 2);
+    memcpy(bytes + 8, &seq, 8);
+    memcpy(bytes + 16, &timestamp_ms, 8);
+    memcpy(bytes + SINGBOX_LOGTAIL_RECORD_HEADER, module, module_len);
+    memcpy(bytes + SINGBOX_LOGTAIL_RECORD_HEADER + module_len, message, message_len);
+    memset(bytes + SINGBOX_LOGTAIL_RECORD_HEADER + module_len + message_len, 0,
+           size - (SINGBOX_LOGTAIL_RECORD_HEADER + module_len + message_len));
+
+    uint32_t capacity = region->capacity;
+    uint64_t head = __atomic_load_n(&region->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&region->tail, __ATOMIC_RELAXED);
+    uint32_t position = (uint32_t)(head % capacity);
+    uint32_t padding = position + size > capacity ? capacity - position : 0;
+    uint64_t end = head + padding + size;
+
+    // Retire the records about to be overwritten before touching their bytes
+    if (end - tail > capacity) {
+        while (end - tail > capacity) {
+            tail += record_size(__atomic_load_n(word_at(region, tail), __ATOMIC_RELAXED));
+        }
+        __atomic_store_n(&region->tail, tail, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    if (padding) {
+        uint64_t marker = 0;
+        uint8_t* marker_bytes = (uint8_t*)&marker;
+        memcpy(marker_bytes, &padding, 4);
+        marker_bytes[4] = SINGBOX_LOGTAIL_PADDING;
+        store_words(region, head, &marker, 1);
+    }
+    store_words(region, head + padding, record, size / 8);
+
+    __atomic_store_n(&region->records, __atomic_load_n(&region->records, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&region->head, end, __ATOMIC_RELEASE);
+}
+
+void singbox_logtail_clear(singbox_logtail_t* region) {
+    __atomic_store_n(&region->tail, __atomic_load_n(&region->head, __ATOMIC_RELAXED), __ATOMIC_RELEASE);
+}
+
+void singbox_logtail_cursor_init(const singbox_logtail_t* region, singbox_logtail_cursor_t* cursor, int newest) {
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->offset = newest ? __atomic_load_n(&region->head, __ATOMIC_ACQUIRE)
+                            : __atomic_load_n(&region->tail, __ATOMIC_ACQUIRE);
+}
+
+static int overwritten(const singbox_logtail_t* region, uint64_t offset) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&region->tail, __ATOMIC_RELAXED) > offset;
+}
+
+int singbox_logtail_read(const singbox_logtail_t* region, singbox_logtail_cursor_t* cursor, int max_records,
+                         int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx) {
+    uint64_t record[MAX_RECORD / 8];
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint32_t capacity = region->capacity;
+    int delivered = 0;
+
+    uint64_t head = __atomic_load_n(&region->head, __ATOMIC_ACQUIRE);
+    if (cursor->offset > head) {
+        // The cursor belongs to an earlier incarnation of the region
+        singbox_logtail_cursor_init(region, cursor, 0);
+    }
+
+    while (cursor->offset < head && (max_records <= 0 || delivered < max_records)) {
+        uint64_t tail = __atomic_load_n(&region->tail, __ATOMIC_ACQUIRE);
+        if (cursor->offset < tail) {
+            cursor->offset = tail;
+            continue;
+        }
+
+        uint64_t offset = cursor->offset;
+        uint32_t position = (uint32_t)(offset % capacity);
+        load_words(region, offset, record, 1);
+        uint32_t size = record_size(record[0]);
+        if (size < 8 || (size & 7) != 0 || size > MAX_RECORD || position + size > capacity) {
+            if (overwritten(region, offset)) {
+                continue;
+            }
+            return -1;
+        }
+        load_words(region, offset + 8, record + 1, size / 8 - 1);
+        if (overwritten(region, offset)) {
+            continue;
+        }
+
+        // The copy is intact from here on
+        if (bytes[4] == SINGBOX_LOGTAIL_PADDING) {
+            cursor->offset += size;
+            continue;
+        }
+        uint16_t message_len;
+        memcpy(&message_len, bytes + 6, 2);
+        if (size < SINGBOX_LOGTAIL_RECORD_HEADER + bytes[5] + (size_t)message_len) {
+            return -1;
+        }
+
+        singbox_log_view_t view;
+        memcpy(&view.seq, bytes + 8, 8);
+        memcpy(&view.timestamp_ms, bytes + 16, 8);
+        view.level = bytes[4];
+        view.module = (const char*)bytes + SINGBOX_LOGTAIL_RECORD_HEADER;
+        view.module_len = bytes[5];
+        view.message = view.module + view.module_len;
+        view.message_len = message_len;
+
+        if (cursor->next_seq && view.seq > cursor->next_seq) {
+            cursor->lost += view.seq - cursor->next_seq;
+        }
+        cursor->next_seq = view.seq + 1;
+        cursor->offset += size;
+        delivered++;
+        if (callback && callback(&view, ctx)) {
+            break;
+        }
+    }
+    return delivered;
+}
@@ -0,0 +1,122 @@
+#ifndef SING_BOX_LOGTAIL_H
+#define SING_BOX_LOGTAIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sing_box_logfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Uncompressed tail ring of recent log records shared with the managed side.
+ *
+ * The compressed log buffer (sing_box_logring.h) is the searchable history;
+ * this ring exists so the UI can follow new records without a JNI call per
+ * refresh. The region is plain process memory handed to Kotlin once as a
+ * read-only direct ByteBuffer (SingboxManager.nativeGetLogTailBuffer) and
+ * decoded in place by NativeLogTail.kt.
+ *
+ * `head` and `tail` are monotonically increasing byte offsets into an
+ * infinite stream; the byte at offset `o` lives at data[o % capacity].
+ * The single writer (serialised by the caller) first advances `tail` past
+ * every record it is about to overwrite, then writes the new record, then
+ * publishes `head`. A reader copies a record and afterwards re-reads `tail`:
+ * if the record's offset fell behind it, the copy may be torn and is
+ * discarded, and the reader resumes at `tail`. Records never straddle the
+ * end of the data area; a padding record fills the gap instead.
+ *
+ * Layout (little endian; offsets are part of the ABI and are mirrored by
+ * NativeLogTail.kt, bump SINGBOX_LOGTAIL_VERSION when they change):
+ *
+ *    0 u32 magic             4 u16 version          6 u16 header_size
+ *    8 u32 capacity         12 u32 reserved
+ *   16 u64 head             24 u64 tail             32 u64 records
+ *   64 data[capacity]
+ *
+ * Record, 8-byte aligned, `size` includes header and padding:
+ *
+ *    0 u32 size              4 u8 level             5 u8 module_len
+ *    6 u16 message_len       8 u64 seq             16 i64 timestamp_ms
+ *   24 module bytes, then message bytes (UTF-8, not NUL terminated)
+ *
+ * A padding record has level SINGBOX_LOGTAIL_PADDING and only its first
+ * eight bytes are meaningful.
+ */
+
+#define SINGBOX_LOGTAIL_MAGIC 0x544C4253u /* "SBLT" */
+#define SINGBOX_LOGTAIL_VERSION 1
+#define SINGBOX_LOGTAIL_HEADER_SIZE 64
+#define SINGBOX_LOGTAIL_RECORD_HEADER 24
+#define SINGBOX_LOGTAIL_PADDING 0xFF
+
+// Smallest region that always holds the largest record twice over
+#define SINGBOX_LOGTAIL_MIN_SIZE 16384
+#define SINGBOX_LOGTAIL_DEFAULT_SIZE (256 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t capacity;
+    uint32_t reserved0;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t records;
+    uint8_t reserved[SINGBOX_LOGTAIL_HEADER_SIZE - 40];
+    uint8_t data[];
+} __attribute__((aligned(64))) singbox_logtail_t;
+
+/**
+ * Reader position; zero-initialised or set by singbox_logtail_cursor_init
+ */
+typedef struct {
+    uint64_t offset;    // Next byte to decode
+    uint64_t next_seq;  // Sequence number expected next, 0 before the first record
+    uint64_t lost;      // Records overwritten or cleared before they were read
+} singbox_logtail_cursor_t;
+
+/**
+ * Format `size` bytes of 64-byte aligned memory as an empty ring
+ * @return The region, or NULL if the memory is too small or misaligned
+ */
+singbox_logtail_t* singbox_logtail_init(void* memory, size_t size);
+
+/**
+ * Append a record; the module is cut to SINGBOX_LOGFILE_MAX_MODULE bytes and
+ * the message to SINGBOX_LOGFILE_MAX_MESSAGE bytes. Writers must be
+ * serialised by the caller; readers never block them.
+ */
+void singbox_logtail_append(singbox_logtail_t* region, uint64_t seq, int64_t timestamp_ms, int level,
+                            const char* module, size_t module_len,
+                            const char* message, size_t message_len);
+
+/**
+ * Drop every record; readers see them as lost. Same locking as append.
+ */
+void singbox_logtail_clear(singbox_logtail_t* region);
+
+/**
+ * Position a cursor at the oldest record still held, or at the next record
+ * to be written when `newest` is non-zero
+ */
+void singbox_logtail_cursor_init(const singbox_logtail_t* region, singbox_logtail_cursor_t* cursor, int newest);
+
+/**
+ * Decode records published since the cursor, oldest first. Safe to call
+ * concurrently with the writer; each record handed to the callback is an
+ * intact private copy.
+ * @param max_records Stop after this many records, 0 for no limit
+ * @param callback Invoked per record; return non-zero to stop
+ * @return Number of records delivered, or -1 if the region is corrupt
+ */
+int singbox_logtail_read(const singbox_logtail_t* region, singbox_logtail_cursor_t* cursor, int max_records,
+                         int (*callback)(const singbox_log_view_t* record, void* ctx), void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGTAIL_H
@@ -0,0 +1,314 @@
+#include "sing_box_logthrottle.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SWEEP_INTERVAL_MS 1000
+#define RATE_SUMMARY_QUIET_MS 1000
+
+void singbox_logthrottle_default_config(singbox_logthrottle_config_t* config) {
+    config->burst_window_ms = 5000;
+    config->max_burst_ms = 60000;
+    config->duplicate_pass = 1;
+    config->rate_per_sec = 50;
+    config->rate_burst = 200;
+    config->exempt_level = 5; // FATAL
+}
+
+void singbox_logthrottle_init(singbox_logthrottle_t* throttle, const singbox_logthrottle_config_t* config) {
+    memset(throttle, 0, sizeof(*throttle));
+    if (config) {
+        throttle->config = *config;
+    } else {
+        singbox_logthrottle_default_config(&throttle->config);
+    }
+    if (throttle->config.duplicate_pass == 0) {
+        throttle->config.duplicate_pass = 1;
+    }
+}
+
+static int is_alnum(unsigned char c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static uint64_t fnv_byte(uint64_t hash, unsigned char c) {
+    return (hash ^ c) * FNV_PRIME;
+}
+
+uint64_t singbox_log_template_hash(int level, const char* module, const char* message, size_t length) {
+    uint64_t hash = fnv_byte(FNV_OFFSET, (unsigned char)level);
+    for (const char* p = module; p && *p; p++) {
+        hash = fnv_byte(hash, (unsigned char)*p);
+    }
+    hash = fnv_byte(hash, 0);
+
+    size_t i = 0;
+    while (i < length) {
+        unsigned char c = (unsigned char)message[i];
+        if (!is_alnum(c)) {
+            hash = fnv_byte(hash, c);
+            i++;
+            continue;
+        }
+        // Hash a word as-is unless it carries a digit (number, address, id)
+        size_t start = i;
+        int has_digit = 0;
+        while (i < length && is_alnum((unsigned char)message[i])) {
+            has_digit |= message[i] >= '0' && message[i] <= '9';
+            i++;
+        }
+        if (has_digit) {
+            hash = fnv_byte(hash, '#');
+        } else {
+            for (size_t j = start; j < i; j++) {
+                hash = fnv_byte(hash, (unsigned char)message[j]);
+            }
+        }
+    }
+    return hash ? hash : 1;
+}
+
+size_t singbox_format_duration(int64_t duration_ms, char* out, size_t size) {
+    int written;
+    if (duration_ms < 0) {
+        duration_ms = 0;
+    }
+    if (duration_ms < 1000) {
+        written = snprintf(out, size, "%lldms", (long long)duration_ms);
+    } else if (duration_ms < 60000) {
+        written = snprintf(out, size, "%.1fs", (double)duration_ms / 1000.0);
+    } else {
+        long long seconds = (long long)(duration_ms / 1000);
+        written = snprintf(out, size, "%lldm%02llds", seconds / 60, seconds % 60);
+    }
+    if (written < 0) {
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+static void emit_text(singbox_logthrottle_t* throttle, int level, const char* module,
+                      const char* text, int length, singbox_logthrottle_emit_cb emit, void* ctx) {
+    if (length < 0) {
+        return;
+    }
+    throttle->stats.summaries++;
+    if (emit) {
+        emit(level, module, text, (size_t)length, ctx);
+    }
+}
+
+static void summarize_slot(singbox_logthrottle_t* throttle, singbox_throttle_slot_t* slot,
+                           singbox_logthrottle_emit_cb emit, void* ctx) {
+    if (slot->suppressed == 0) {
+        return;
+    }
+    char duration[32];
+    char text[SINGBOX_THROTTLE_SAMPLE_LEN + 64];
+    singbox_format_duration(slot->last_ms - slot->first_ms, duration, sizeof(duration));
+    int length = snprintf(text, sizeof(text), "%.*s (\xc3\x97%u over %s)",
+                          (int)slot->sample_len, slot->sample, slot->count, duration);
+    if (length >= (int)sizeof(text)) {
+        length = (int)sizeof(text) - 1;
+    }
+    emit_text(throttle, slot->level, slot->module, text, length, emit, ctx);
+    slot->suppressed = 0;
+}
+
+static void summarize_bucket(singbox_logthrottle_t* throttle, singbox_throttle_bucket_t* bucket,
+                             singbox_logthrottle_emit_cb emit, void* ctx) {
+    if (bucket->dropped == 0) {
+        return;
+    }
+    char duration[32];
+    char text[128];
+    singbox_format_duration(bucket->last_drop_ms - bucket->first_drop_ms, duration, sizeof(duration));
+    int length = snprintf(text, sizeof(text), "rate limited: %llu messages suppressed over %s",
+                          (unsigned long long)bucket->dropped, duration);
+    emit_text(throttle, 3 /* WARN */, bucket->module, text, length, emit, ctx);
+    bucket->dropped = 0;
+}
+
+static void sweep(singbox_logthrottle_t* throttle, int64_t now_ms, int force,
+                  singbox_logthrottle_emit_cb emit, void* ctx) {
+    throttle->last_sweep_ms = now_ms;
+
+    for (size_t i = 0; i < SINGBOX_THROTTLE_SLOTS; i++) {
+        singbox_throttle_slot_t* slot = &throttle->slots[i];
+        if (!slot->key) {
+            continue;
+        }
+        if (force || now_ms - slot->last_ms > (int64_t)throttle->config.burst_window_ms) {
+            summarize_slot(throttle, slot, emit, ctx);
+            slot->key = 0; // Burst over; free the slot
+        }
+    }
+
+    for (size_t i = 0; i < SINGBOX_THROTTLE_MODULES; i++) {
+        singbox_throttle_bucket_t* bucket = &throttle->buckets[i];
+        if (bucket->dropped && (force || now_ms - bucket->last_drop_ms >= RATE_SUMMARY_QUIET_MS)) {
+            summarize_bucket(throttle, bucket, emit, ctx);
+        }
+    }
+}
+
+static void start_burst(singbox_throttle_slot_t* slot, uint64_t key, int64_t now_ms, int level,
+                        const char* module, const char* message, size_t length) {
+    slot->key = key;
+    slot->first_ms = now_ms;
+    slot->last_ms = now_ms;
+    slot->count = 1;
+    slot->suppressed = 0;
+    slot->level = (uint8_t)level;
+    snprintf(slot->module, sizeof(slot->module), "%s", module ? module : "");
+    size_t sample_len = length < SINGBOX_THROTTLE_SAMPLE_LEN - 1 ? length : SINGBOX_THROTTLE_SAMPLE_LEN - 1;
+    memcpy(slot->sample, message, sample_len);
+    slot->sample[sample_len] = '\0';
+    slot->sample_len = (uint16_t)sample_len;
+}
+
+/**
+ * Deduplication step; returns 1 when the message continues to the rate limiter
+ */
+static int dedupe(singbox_logthrottle_t* throttle, int64_t now_ms, int level, const char* module,
+                  const char* message, size_t length, singbox_logthrottle_emit_cb emit, void* ctx) {
+    uint64_t key = singbox_log_template_hash(level, module, message, length);
+    size_t base = (size_t)key & (SINGBOX_THROTTLE_SLOTS - 1);
+    singbox_throttle_slot_t* found = NULL;
+    singbox_throttle_slot_t* free_slot = NULL;
+    singbox_throttle_slot_t* oldest = NULL;
+
+    // Scan the whole probe window; freed slots may sit between entries
+    for (size_t i = 0; i < SINGBOX_THROTTLE_PROBE; i++) {
+        singbox_throttle_slot_t* slot = &throttle->slots[(base + i) & (SINGBOX_THROTTLE_SLOTS - 1)];
+        if (slot->key == key) {
+            found = slot;
+            break;
+        }
+        if (!slot->key) {
+            if (!free_slot) {
+                free_slot = slot;
+            }
+        } else if (!oldest || slot->last_ms < oldest->last_ms) {
+            oldest = slot;
+        }
+    }
+
+    if (!found) {
+        singbox_throttle_slot_t* slot = free_slot;
+        if (!slot) {
+            slot = oldest;
+            summarize_slot(throttle, slot, emit, ctx);
+            throttle->stats.evictions++;
+        }
+        start_burst(slot, key, now_ms, level, module, message, length);
+        return 1;
+    }
+
+    if (now_ms - found->last_ms > (int64_t)throttle->config.burst_window_ms) {
+        summarize_slot(throttle, found, emit, ctx);
+        start_burst(found, key, now_ms, level, module, message, length);
+        return 1;
+    }
+
+    found->count++;
+    found->last_ms = now_ms;
+    if (found->count <= throttle->config.duplicate_pass) {
+        return 1;
+    }
+
+    found->suppressed++;
+    throttle->stats.collapsed++;
+    throttle->stats.suppressed_bytes += length;
+
+    if (now_ms - found->first_ms >= (int64_t)throttle->config.max_burst_ms) {
+        // Long-running flood: report what we have and keep collapsing
+        summarize_slot(throttle, found, emit, ctx);
+        found->first_ms = now_ms;
+        found->count = throttle->config.duplicate_pass;
+    }
+    return 0;
+}
+
+static singbox_throttle_bucket_t* find_bucket(singbox_logthrottle_t* throttle, const char* module,
+                                              int64_t now_ms) {
+    const char* name = module && module[0] ? module : "-";
+    // The last bucket is shared by every module that did not get its own
+    for (size_t i = 0; i < SINGBOX_THROTTLE_MODULES - 1; i++) {
+        singbox_throttle_bucket_t* bucket = &throttle->buckets[i];
+        if (!bucket->module[0]) {
+            snprintf(bucket->module, sizeof(bucket->module), "%s", name);
+            bucket->tokens_milli = (int64_t)throttle->config.rate_burst * 1000;
+            bucket->refilled_ms = now_ms;
+            return bucket;
+        }
+        if (strncmp(bucket->module, name, sizeof(bucket->module) - 1) == 0) {
+            return bucket;
+        }
+    }
+
+    singbox_throttle_bucket_t* shared = &throttle->buckets[SINGBOX_THROTTLE_MODULES - 1];
+    if (!shared->module[0]) {
+        snprintf(shared->module, sizeof(shared->module), "*");
+        shared->tokens_milli = (int64_t)throttle->config.rate_burst * 1000;
+        shared->refilled_ms = now_ms;
+    }
+    return shared;
+}
+
+static int take_token(singbox_logthrottle_t* throttle, singbox_throttle_bucket_t* bucket, int64_t now_ms) {
+    int64_t capacity = (int64_t)throttle->config.rate_burst * 1000;
+    int64_t elapsed = now_ms - bucket->refilled_ms;
+    if (elapsed > 0) {
+        // rate_per_sec tokens per second is rate_per_sec milli-tokens per millisecond
+        bucket->tokens_milli += elapsed * (int64_t)throttle->config.rate_per_sec;
+        if (bucket->tokens_milli > capacity) {
+            bucket->tokens_milli = capacity;
+        }
+        bucket->refilled_ms = now_ms;
+    }
+    if (bucket->tokens_milli < 1000) {
+        return 0;
+    }
+    bucket->tokens_milli -= 1000;
+    return 1;
+}
+
+int singbox_logthrottle_submit(singbox_logthrottle_t* throttle, int64_t now_ms, int level,
+                               const char* module, const char* message, size_t length,
+                               singbox_logthrottle_emit_cb emit, void* ctx) {
+    throttle->stats.submitted++;
+    if (now_ms - throttle->last_sweep_ms >= SWEEP_INTERVAL_MS) {
+        sweep(throttle, now_ms, 0, emit, ctx);
+    }
+
+    if (!dedupe(throttle, now_ms, level, module, message, length, emit, ctx)) {
+        return 0;
+    }
+
+    if (throttle->config.rate_per_sec > 0) {
+        singbox_throttle_bucket_t* bucket = find_bucket(throttle, module, now_ms);
+        if (!take_token(throttle, bucket, now_ms) && level < throttle->config.exempt_level) {
+            if (bucket->dropped == 0) {
+                bucket->first_drop_ms = now_ms;
+            }
+            bucket->dropped++;
+            bucket->total_dropped++;
+            bucket->last_drop_ms = now_ms;
+            throttle->stats.rate_limited++;
+            throttle->stats.suppressed_bytes += length;
+            return 0;
+        }
+    }
+
+    throttle->stats.passed++;
+    return 1;
+}
+
+void singbox_logthrottle_flush(singbox_logthrottle_t* throttle, int64_t now_ms, int force,
+                               singbox_logthrottle_emit_cb emit, void* ctx) {
+    sweep(throttle, now_ms, force, emit, ctx);
+}
@@ -0,0 +1,133 @@
+#ifndef SING_BOX_LOGTHROTTLE_H
+#define SING_BOX_LOGTHROTTLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Log suppression stage: duplicate-burst collapsing plus per-module rate limits.
+ *
+ * Messages are keyed by template: module, level and the text with every
+ * token that contains a digit (ports, addresses, ids, counters) replaced by
+ * a placeholder, so "dial tcp 1.2.3.4:443: i/o timeout" and
+ * "dial tcp 5.6.7.8:443: i/o timeout" are the same template.
+ *
+ * The first occurrences of a template pass through; further repeats within
+ * the burst window are counted instead of logged. Once the burst goes quiet
+ * (or has lasted max_burst_ms) a single summary record
+ * "message (×N over T)" is emitted in place of the repeats.
+ *
+ * Messages that survive deduplication draw from a token bucket per module;
+ * when the bucket is empty they are dropped and reported later as one
+ * "rate limit" summary per module.
+ *
+ * Not thread safe: callers serialise access (sing_box_logging.c holds a
+ * dedicated mutex). Summaries are delivered through the emit callback.
+ */
+
+#define SINGBOX_THROTTLE_SLOTS 128          // Templates tracked at once (power of two)
+#define SINGBOX_THROTTLE_PROBE 8            // Slots probed before evicting
+#define SINGBOX_THROTTLE_MODULES 32         // Modules with their own bucket
+#define SINGBOX_THROTTLE_MODULE_LEN 32
+#define SINGBOX_THROTTLE_SAMPLE_LEN 192     // Message text kept for the summary
+
+typedef struct {
+    uint32_t burst_window_ms;   // Repeats closer than this extend the burst
+    uint32_t max_burst_ms;      // Emit an interim summary for longer bursts
+    uint32_t duplicate_pass;    // Occurrences logged before collapsing starts
+    uint32_t rate_per_sec;      // Per-module refill rate, 0 = no rate limit
+    uint32_t rate_burst;        // Per-module bucket capacity
+    int exempt_level;           // Levels at or above this are never rate limited
+} singbox_logthrottle_config_t;
+
+typedef struct {
+    uint64_t submitted;
+    uint64_t passed;
+    uint64_t collapsed;         // Repeats folded into burst summaries
+    uint64_t rate_limited;      // Dropped by a module's token bucket
+    uint64_t suppressed_bytes;  // Message bytes not logged (collapsed + rate limited)
+    uint64_t summaries;         // Summary records emitted
+    uint64_t evictions;         // Templates evicted while still tracked
+} singbox_logthrottle_stats_t;
+
+typedef struct {
+    uint64_t key;               // Template hash, 0 = free
+    int64_t first_ms;
+    int64_t last_ms;
+    uint32_t count;             // Occurrences in the current burst
+    uint32_t suppressed;        // Occurrences not passed through
+    uint8_t level;
+    uint16_t sample_len;
+    char module[SINGBOX_THROTTLE_MODULE_LEN];
+    char sample[SINGBOX_THROTTLE_SAMPLE_LEN];
+} singbox_throttle_slot_t;
+
+typedef struct {
+    char module[SINGBOX_THROTTLE_MODULE_LEN];  // Empty = free
+    int64_t tokens_milli;       // Thousandths of a token
+    int64_t refilled_ms;
+    int64_t first_drop_ms;
+    int64_t last_drop_ms;
+    uint64_t dropped;           // Since the last summary
+    uint64_t total_dropped;
+} singbox_throttle_bucket_t;
+
+typedef struct {
+    singbox_logthrottle_config_t config;
+    singbox_logthrottle_stats_t stats;
+    int64_t last_sweep_ms;
+    singbox_throttle_slot_t slots[SINGBOX_THROTTLE_SLOTS];
+    singbox_throttle_bucket_t buckets[SINGBOX_THROTTLE_MODULES];
+} singbox_logthrottle_t;
+
+typedef void (*singbox_logthrottle_emit_cb)(int level, const char* module, const char* message,
+                                            size_t length, void* ctx);
+
+/**
+ * Defaults: 5 s burst window, 60 s max burst, 1 duplicate passed,
+ * 50 lines/s per module with a burst of 200, FATAL exempt
+ */
+void singbox_logthrottle_default_config(singbox_logthrottle_config_t* config);
+
+/**
+ * Reset all state
+ * @param config Configuration, NULL for the defaults
+ */
+void singbox_logthrottle_init(singbox_logthrottle_t* throttle, const singbox_logthrottle_config_t* config);
+
+/**
+ * Decide whether a message is logged. Expired bursts found along the way are
+ * summarised through `emit` before this returns.
+ * @param now_ms Monotonic time in milliseconds
+ * @return 1 if the caller should log the message, 0 if it was suppressed
+ */
+int singbox_logthrottle_submit(singbox_logthrottle_t* throttle, int64_t now_ms, int level,
+                               const char* module, const char* message, size_t length,
+                               singbox_logthrottle_emit_cb emit, void* ctx);
+
+/**
+ * Emit summaries for bursts and rate-limited modules that went quiet
+ * @param force Non-zero to summarise everything pending (shutdown, export)
+ */
+void singbox_logthrottle_flush(singbox_logthrottle_t* throttle, int64_t now_ms, int force,
+                               singbox_logthrottle_emit_cb emit, void* ctx);
+
+/**
+ * Template hash used as the deduplication key (never 0)
+ */
+uint64_t singbox_log_template_hash(int level, const char* module, const char* message, size_t length);
+
+/**
+ * Format a duration as "850ms", "12.3s" or "2m05s"
+ */
+size_t singbox_format_duration(int64_t duration_ms, char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LOGTHROTTLE_H
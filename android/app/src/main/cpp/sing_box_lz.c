@@ -0,0 +1,195 @@
+#include "sing_box_lz.h"
+
+#include <string.h>
+
+#define MIN_MATCH 4
+#define HASH_BITS 12
+#define MAX_OFFSET 65535
+// The last match must start this far from the end, and the tail is always
+// emitted as literals, so the decoder never reads past the input
+#define LAST_LITERALS 5
+#define MATCH_SAFE_DISTANCE 12
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+size_t singbox_lz_compress_bound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+static uint8_t* put_length(uint8_t* out, const uint8_t* end, size_t length) {
+    while (length >= 255) {
+        if (out >= end) {
+            return NULL;
+        }
+        *out++ = 255;
+        length -= 255;
+    }
+    if (out >= end) {
+        return NULL;
+    }
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+/**
+ * Write one sequence: literals followed by an optional match
+ * @return Next output position, NULL if it does not fit
+ */
+static uint8_t* put_sequence(uint8_t* out, const uint8_t* end, const uint8_t* literals, size_t literal_len,
+                             size_t offset, size_t match_len) {
+    if (out >= end) {
+        return NULL;
+    }
+    uint8_t* token = out++;
+    *token = (uint8_t)((literal_len >= 15 ? 15 : literal_len) << 4);
+    if (literal_len >= 15 && !(out = put_length(out, end, literal_len - 15))) {
+        return NULL;
+    }
+    if ((size_t)(end - out) < literal_len) {
+        return NULL;
+    }
+    memcpy(out, literals, literal_len);
+    out += literal_len;
+
+    if (match_len == 0) {
+        return out;
+    }
+    if (end - out < 2) {
+        return NULL;
+    }
+    *out++ = (uint8_t)offset;
+    *out++ = (uint8_t)(offset >> 8);
+    size_t code = match_len - MIN_MATCH;
+    *token |= (uint8_t)(code >= 15 ? 15 : code);
+    if (code >= 15 && !(out = put_length(out, end, code - 15))) {
+        return NULL;
+    }
+    return out;
+}
+
+size_t singbox_lz_compress(const void* src, size_t length, void* dst, size_t capacity) {
+    const uint8_t* input = (const uint8_t*)src;
+    uint8_t* out = (uint8_t*)dst;
+    const uint8_t* out_end = out + capacity;
+    if (length > SINGBOX_LZ_MAX_INPUT) {
+        return 0;
+    }
+
+    uint32_t table[1 << HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const uint8_t* anchor = input;
+    const uint8_t* end = input + length;
+    const uint8_t* match_limit = length > MATCH_SAFE_DISTANCE ? end - MATCH_SAFE_DISTANCE : input;
+    const uint8_t* p = input;
+
+    // Positions are stored +1 so a zeroed table means "empty"
+    while (p < match_limit) {
+        uint32_t sequence = read32(p);
+        uint32_t h = hash4(sequence);
+        const uint8_t* candidate = table[h] ? input + table[h] - 1 : NULL;
+        table[h] = (uint32_t)(p - input) + 1;
+
+        if (!candidate || p - candidate > MAX_OFFSET || read32(candidate) != sequence) {
+            p++;
+            continue;
+        }
+
+        // Extend backwards over pending literals, then forwards
+        while (p > anchor && candidate > input && p[-1] == candidate[-1]) {
+            p--;
+            candidate--;
+        }
+        const uint8_t* match_end = p + MIN_MATCH;
+        const uint8_t* ref = candidate + MIN_MATCH;
+        const uint8_t* extend_limit = end - LAST_LITERALS;
+        while (match_end < extend_limit && *match_end == *ref) {
+            match_end++;
+            ref++;
+        }
+
+        out = put_sequence(out, out_end, anchor, (size_t)(p - anchor), (size_t)(p - candidate),
+                           (size_t)(match_end - p));
+        if (!out) {
+            return 0;
+        }
+        p = match_end;
+        anchor = p;
+        if (p - 2 >= input && p < match_limit) {
+            table[hash4(read32(p - 2))] = (uint32_t)(p - 2 - input) + 1;
+        }
+    }
+
+    out = put_sequence(out, out_end, anchor, (size_t)(end - anchor), 0, 0);
+    return out ? (size_t)(out - (uint8_t*)dst) : 0;
+}
+
+static int get_length(const uint8_t** in, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*in >= end) {
+            return -1;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+long singbox_lz_decompress(const void* src, size_t length, void* dst, size_t capacity) {
+    const uint8_t* in = (const uint8_t*)src;
+    const uint8_t* in_end = in + length;
+    uint8_t* out = (uint8_t*)dst;
+    uint8_t* out_end = out + capacity;
+
+    while (in < in_end) {
+        uint8_t token = *in++;
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && get_length(&in, in_end, &literal_len) != 0) {
+            return -1;
+        }
+        if ((size_t)(in_end - in) < literal_len || (size_t)(out_end - out) < literal_len) {
+            return -1;
+        }
+        memcpy(out, in, literal_len);
+        in += literal_len;
+        out += literal_len;
+
+        if (in == in_end) {
+            break; // Final literal-only sequence
+        }
+        if (in_end - in < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && get_length(&in, in_end, &match_len) != 0) {
+            return -1;
+        }
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - (uint8_t*)dst) || (size_t)(out_end - out) < match_len) {
+            return -1;
+        }
+
+        // Overlapping copies repeat the last `offset` bytes, so copy forwards
+        const uint8_t* ref = out - offset;
+        if (offset >= match_len) {
+            memcpy(out, ref, match_len);
+            out += match_len;
+        } else {
+            for (size_t i = 0; i < match_len; i++) {
+                *out++ = *ref++;
+            }
+        }
+    }
+    return (long)(out - (uint8_t*)dst);
+}
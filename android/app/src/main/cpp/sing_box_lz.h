@@ -0,0 +1,49 @@
+#ifndef SING_BOX_LZ_H
+#define SING_BOX_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Small LZ77 block codec for in-memory log blocks.
+ *
+ * The format follows the LZ4 block layout: a sequence is a token byte
+ * (literal length in the high nibble, match length - 4 in the low nibble),
+ * optional length extension bytes (255 = continue), the literals, and a
+ * 16-bit little-endian match offset. The last sequence has literals only.
+ * The compressor is a single greedy pass over a 4096-entry hash table kept
+ * on the stack, which suits the short, highly repetitive text of log lines;
+ * decompression is a bounds-checked copy loop.
+ *
+ * Blocks are self-contained and limited to SINGBOX_LZ_MAX_INPUT bytes.
+ */
+
+#define SINGBOX_LZ_MAX_INPUT (1u << 20)
+
+/**
+ * Worst-case compressed size for `length` input bytes
+ */
+size_t singbox_lz_compress_bound(size_t length);
+
+/**
+ * Compress one block
+ * @param capacity Size of `dst`; pass less than `length` to only accept output that saves space
+ * @return Compressed size, or 0 if the output did not fit (store the block raw instead)
+ */
+size_t singbox_lz_compress(const void* src, size_t length, void* dst, size_t capacity);
+
+/**
+ * Decompress one block
+ * @return Decompressed size, or -1 if the input is corrupt or does not fit
+ */
+long singbox_lz_decompress(const void* src, size_t length, void* dst, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_LZ_H
@@ -0,0 +1,191 @@
+#include "sing_box_notify.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "sing_box_compat.h"
+
+#define TAG "SingBoxNotify"
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+
+// Everything below is guarded by notify_mutex; `active` is also read
+// without it so posts are free while nobody listens
+static pthread_mutex_t notify_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notify_cond;
+static pthread_once_t notify_cond_once = PTHREAD_ONCE_INIT;
+static pthread_t notify_thread;
+static int active = 0;
+static int stopping = 0;
+static singbox_notify_sink_t sink;
+static uint32_t interval_ms = 0;
+
+static int stats_pending = 0;
+static singbox_stats_values_t pending_stats;
+static int state_pending = 0;
+static int pending_state = 0;
+static int64_t next_stats_ms = 0;
+
+static singbox_notify_stats_t counters;
+
+static void init_cond(void) {
+    // Deadlines are computed on the monotonic clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&notify_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void wait_until(int64_t deadline_ms) {
+    struct timespec ts = { (time_t)(deadline_ms / 1000), (long)(deadline_ms % 1000) * 1000000L };
+    pthread_cond_timedwait(&notify_cond, &notify_mutex, &ts);
+}
+
+static void* notifier_thread(void* arg) {
+    (void)arg;
+    singbox_notify_sink_t target = sink;
+    if (target.attach) {
+        target.attach(target.ctx);
+    }
+    
+    pthread_mutex_lock(&notify_mutex);
+    while (!stopping) {
+        int64_t now = monotonic_ms();
+        int deliver_state = state_pending;
+        int deliver_stats = stats_pending && now >= next_stats_ms;
+        
+        if (!deliver_state && !deliver_stats) {
+            if (stats_pending) {
+                wait_until(next_stats_ms);
+            } else {
+                pthread_cond_wait(&notify_cond, &notify_mutex);
+            }
+            counters.wakeups++;
+            continue;
+        }
+        
+        int state = pending_state;
+        singbox_stats_values_t values = pending_stats;
+        state_pending = 0;
+        if (deliver_stats) {
+            stats_pending = 0;
+            next_stats_ms = now + interval_ms;
+        }
+        pthread_mutex_unlock(&notify_mutex);
+        
+        // The sink may take its time (a JVM upcall); posts keep coalescing meanwhile
+        if (deliver_state && target.on_state) {
+            target.on_state(target.ctx, state);
+        }
+        if (deliver_stats && target.on_stats) {
+            target.on_stats(target.ctx, &values);
+        }
+        
+        pthread_mutex_lock(&notify_mutex);
+        counters.states_delivered += deliver_state;
+        counters.stats_delivered += deliver_stats;
+    }
+    pthread_mutex_unlock(&notify_mutex);
+    
+    if (target.detach) {
+        target.detach(target.ctx);
+    }
+    return NULL;
+}
+
+void singbox_notify_stop(void) {
+    pthread_once(&notify_cond_once, init_cond);
+    pthread_mutex_lock(&notify_mutex);
+    if (!active) {
+        pthread_mutex_unlock(&notify_mutex);
+        return;
+    }
+    stopping = 1;
+    pthread_cond_signal(&notify_cond);
+    pthread_mutex_unlock(&notify_mutex);
+    
+    pthread_join(notify_thread, NULL);
+    
+    pthread_mutex_lock(&notify_mutex);
+    __atomic_store_n(&active, 0, __ATOMIC_RELEASE);
+    stopping = 0;
+    stats_pending = 0;
+    state_pending = 0;
+    memset(&sink, 0, sizeof(sink));
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+int singbox_notify_start(const singbox_notify_sink_t* new_sink, uint32_t new_interval_ms) {
+    singbox_notify_stop();
+    
+    pthread_mutex_lock(&notify_mutex);
+    sink = *new_sink;
+    interval_ms = new_interval_ms;
+    next_stats_ms = 0;
+    int result = pthread_create(&notify_thread, NULL, notifier_thread, NULL) == 0;
+    if (result) {
+        __atomic_store_n(&active, 1, __ATOMIC_RELEASE);
+    } else {
+        LOGW("Failed to start notifier thread");
+        memset(&sink, 0, sizeof(sink));
+    }
+    pthread_mutex_unlock(&notify_mutex);
+    return result;
+}
+
+void singbox_notify_set_interval(uint32_t new_interval_ms) {
+    pthread_once(&notify_cond_once, init_cond);
+    pthread_mutex_lock(&notify_mutex);
+    // A shorter interval applies to the stats already waiting
+    if (new_interval_ms < interval_ms) {
+        next_stats_ms -= (int64_t)(interval_ms - new_interval_ms);
+        if (stats_pending) {
+            pthread_cond_signal(&notify_cond);
+        }
+    }
+    interval_ms = new_interval_ms;
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+void singbox_notify_post_stats(const singbox_stats_values_t* values) {
+    if (!__atomic_load_n(&active, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    pthread_mutex_lock(&notify_mutex);
+    counters.stats_posted++;
+    pending_stats = *values;
+    if (!stats_pending) {
+        stats_pending = 1;
+        pthread_cond_signal(&notify_cond);
+    }
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+void singbox_notify_post_state(int state) {
+    if (!__atomic_load_n(&active, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    pthread_mutex_lock(&notify_mutex);
+    counters.states_posted++;
+    pending_state = state;
+    if (!state_pending) {
+        state_pending = 1;
+        pthread_cond_signal(&notify_cond);
+    }
+    pthread_mutex_unlock(&notify_mutex);
+}
+
+void singbox_notify_get_stats(singbox_notify_stats_t* stats) {
+    pthread_mutex_lock(&notify_mutex);
+    *stats = counters;
+    stats->interval_ms = interval_ms;
+    stats->active = active;
+    pthread_mutex_unlock(&notify_mutex);
+}
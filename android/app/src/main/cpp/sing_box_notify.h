@@ -0,0 +1,75 @@
+#ifndef SING_BOX_NOTIFY_H
+#define SING_BOX_NOTIFY_H
+
+#include <stdint.h>
+
+#include "sing_box_statsmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Push notifications from the core to the managed side.
+ *
+ * The core posts every stats publish and lifecycle transition; a single
+ * notifier thread delivers them to a sink (the JNI listener on Android, a
+ * recorder in the host tests). Posting never blocks on the sink: it only
+ * replaces the pending value, so bursts coalesce into the latest stats and
+ * the latest state. State changes are delivered as soon as the notifier
+ * wakes; stats at most once per interval. With nothing pending the thread
+ * sleeps without a timeout.
+ */
+
+typedef struct {
+    void (*attach)(void* ctx);  // On the notifier thread before the first delivery
+    void (*detach)(void* ctx);  // On the notifier thread as it exits
+    void (*on_stats)(void* ctx, const singbox_stats_values_t* values);
+    void (*on_state)(void* ctx, int state);
+    void* ctx;
+} singbox_notify_sink_t;
+
+typedef struct {
+    uint64_t stats_posted;
+    uint64_t stats_delivered;
+    uint64_t states_posted;
+    uint64_t states_delivered;
+    uint64_t wakeups;
+    uint32_t interval_ms;
+    int active;
+} singbox_notify_stats_t;
+
+/**
+ * Start delivering to `sink`, replacing (and stopping) any previous sink
+ * @param interval_ms Minimum spacing of stats deliveries, 0 for every post
+ * @return 1 on success, 0 if the thread could not be created
+ */
+int singbox_notify_start(const singbox_notify_sink_t* sink, uint32_t interval_ms);
+
+/**
+ * Stop the notifier; pending events are dropped. Must not be called from a sink.
+ */
+void singbox_notify_stop(void);
+
+/**
+ * Change the stats delivery interval of the running notifier
+ */
+void singbox_notify_set_interval(uint32_t interval_ms);
+
+/**
+ * Post the latest statistics; cheap and non-blocking when no sink is set
+ */
+void singbox_notify_post_stats(const singbox_stats_values_t* values);
+
+/**
+ * Post a lifecycle state (singbox_core_state_t)
+ */
+void singbox_notify_post_state(int state);
+
+void singbox_notify_get_stats(singbox_notify_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_NOTIFY_H
@@ -0,0 +1,140 @@
+#include "sing_box_notify_jni.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "sing_box_compat.h"
+#include "sing_box_notify.h"
+
+#define TAG "SingBoxNotifyJNI"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+// Resolved once in JNI_OnLoad, where the app class loader is available
+static JavaVM* cached_vm = NULL;
+static jclass listener_class = NULL;     // Global ref
+static jmethodID on_stats_method = NULL; // (JJDDJJJ)V
+static jmethodID on_state_method = NULL; // (I)V
+
+// Serialises listener changes; the notifier thread only sees the sink ctx
+static pthread_mutex_t listener_mutex = PTHREAD_MUTEX_INITIALIZER;
+static jobject listener_ref = NULL;      // Global ref
+
+// Owned by the notifier thread, attached once for its whole life
+static JNIEnv* notifier_env = NULL;
+
+static void clear_exception(JNIEnv* env, const char* method) {
+    if ((*env)->ExceptionCheck(env)) {
+        LOGE("Listener %s threw", method);
+        (*env)->ExceptionDescribe(env);
+        (*env)->ExceptionClear(env);
+    }
+}
+
+static void sink_attach(void* ctx) {
+    (void)ctx;
+    JNIEnv* env = NULL;
+    if ((*cached_vm)->AttachCurrentThread(cached_vm, &env, NULL) != JNI_OK) {
+        LOGE("Failed to attach notifier thread");
+        env = NULL;
+    }
+    notifier_env = env;
+}
+
+static void sink_detach(void* ctx) {
+    (void)ctx;
+    if (notifier_env) {
+        (*cached_vm)->DetachCurrentThread(cached_vm);
+        notifier_env = NULL;
+    }
+}
+
+static void sink_on_stats(void* ctx, const singbox_stats_values_t* values) {
+    JNIEnv* env = notifier_env;
+    if (!env) {
+        return;
+    }
+    (*env)->CallVoidMethod(env, (jobject)ctx, on_stats_method,
+                           (jlong)values->upload_bytes, (jlong)values->download_bytes,
+                           (jdouble)values->upload_speed, (jdouble)values->download_speed,
+                           (jlong)values->packets_sent, (jlong)values->packets_received,
+                           (jlong)values->started_at_ms);
+    clear_exception(env, "onNativeStats");
+}
+
+static void sink_on_state(void* ctx, int state) {
+    JNIEnv* env = notifier_env;
+    if (!env) {
+        return;
+    }
+    (*env)->CallVoidMethod(env, (jobject)ctx, on_state_method, (jint)state);
+    clear_exception(env, "onNativeStateChanged");
+}
+
+int singbox_notify_jni_on_load(JavaVM* vm, JNIEnv* env) {
+    cached_vm = vm;
+    
+    jclass local = (*env)->FindClass(env, SINGBOX_LISTENER_CLASS);
+    if (!local) {
+        (*env)->ExceptionClear(env);
+        LOGE("Listener interface %s not found, push notifications disabled", SINGBOX_LISTENER_CLASS);
+        return 0;
+    }
+    listener_class = (jclass)(*env)->NewGlobalRef(env, local);
+    (*env)->DeleteLocalRef(env, local);
+    
+    on_stats_method = (*env)->GetMethodID(env, listener_class, "onNativeStats", "(JJDDJJJ)V");
+    on_state_method = (*env)->GetMethodID(env, listener_class, "onNativeStateChanged", "(I)V");
+    if (!on_stats_method || !on_state_method) {
+        (*env)->ExceptionClear(env);
+        LOGE("Listener interface methods not found, push notifications disabled");
+        (*env)->DeleteGlobalRef(env, listener_class);
+        listener_class = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+int singbox_notify_jni_set_listener(JNIEnv* env, jobject listener, jint interval_ms) {
+    if (listener && !listener_class) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&listener_mutex);
+    
+    // Joins the notifier, so the old reference is no longer in use
+    singbox_notify_stop();
+    if (listener_ref) {
+        (*env)->DeleteGlobalRef(env, listener_ref);
+        listener_ref = NULL;
+    }
+    
+    int result = 1;
+    if (listener) {
+        listener_ref = (*env)->NewGlobalRef(env, listener);
+        singbox_notify_sink_t sink = {
+            sink_attach, sink_detach, sink_on_stats, sink_on_state, listener_ref
+        };
+        result = singbox_notify_start(&sink, interval_ms > 0 ? (uint32_t)interval_ms : 0);
+        if (!result) {
+            (*env)->DeleteGlobalRef(env, listener_ref);
+            listener_ref = NULL;
+        } else {
+            LOGI("Push notifications enabled, stats interval %d ms", (int)interval_ms);
+        }
+    }
+    
+    pthread_mutex_unlock(&listener_mutex);
+    return result;
+}
+
+void singbox_notify_jni_on_unload(JNIEnv* env) {
+    singbox_notify_jni_set_listener(env, NULL, 0);
+    if (listener_class) {
+        (*env)->DeleteGlobalRef(env, listener_class);
+        listener_class = NULL;
+    }
+    on_stats_method = NULL;
+    on_state_method = NULL;
+    cached_vm = NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef SING_BOX_NOTIFY_JNI_H
+#define SING_BOX_NOTIFY_JNI_H
+
+#include <jni.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * JNI sink for sing_box_notify: delivers stats and state pushes to a
+ * com.tunnelmax.vpnclient.NativeEventListener from the notifier thread.
+ */
+
+#define SINGBOX_LISTENER_CLASS "com/tunnelmax/vpnclient/NativeEventListener"
+
+/**
+ * Cache the VM and the listener class/method IDs; called from JNI_OnLoad
+ * @return 1 if the listener interface was found
+ */
+int singbox_notify_jni_on_load(JavaVM* vm, JNIEnv* env);
+
+/**
+ * Stop the notifier and drop the cached references; called from JNI_OnUnload
+ */
+void singbox_notify_jni_on_unload(JNIEnv* env);
+
+/**
+ * Deliver pushes to `listener` (a global ref is taken), or stop them when NULL
+ * @param interval_ms Minimum spacing of stats pushes
+ * @return 1 on success
+ */
+int singbox_notify_jni_set_listener(JNIEnv* env, jobject listener, jint interval_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_NOTIFY_JNI_H
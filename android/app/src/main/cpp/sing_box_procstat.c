@@ -0,0 +1,422 @@
+#include "sing_box_procstat.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define READ_BUFFER_SIZE 4096
+
+typedef struct {
+    int32_t tid;
+    int fd;                     // /proc/<pid>/task/<tid>/stat
+    uint64_t last_ticks;
+    int seen;                   // Marked during a sample
+} thread_slot_t;
+
+struct singbox_procstat {
+    pid_t pid;
+    int rollup_fd;              // -1 without smaps_rollup
+    int status_fd;
+    int stat_fd;
+    int fd_dir;
+    int task_dir;
+    
+    int64_t last_sample_ms;
+    uint64_t last_ticks;
+    long ticks_per_second;
+    
+    thread_slot_t threads[SINGBOX_PROCSTAT_MAX_THREADS];
+    uint32_t thread_count;
+    
+    singbox_proc_point_t* history;
+    uint32_t history_capacity;
+    uint32_t history_count;
+    uint32_t history_next;
+};
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int open_proc(pid_t pid, const char* name, int flags) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, name);
+    return open(path, flags | O_RDONLY | O_CLOEXEC);
+}
+
+static void close_fd(int* fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+singbox_procstat_t* singbox_procstat_open(pid_t pid, uint32_t history) {
+    singbox_procstat_t* sampler = calloc(1, sizeof(*sampler));
+    if (!sampler) {
+        return NULL;
+    }
+    sampler->pid = pid;
+    sampler->rollup_fd = open_proc(pid, "smaps_rollup", 0);
+    sampler->status_fd = open_proc(pid, "status", 0);
+    sampler->stat_fd = open_proc(pid, "stat", 0);
+    sampler->fd_dir = open_proc(pid, "fd", O_DIRECTORY);
+    sampler->task_dir = open_proc(pid, "task", O_DIRECTORY);
+    sampler->ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (sampler->ticks_per_second <= 0) {
+        sampler->ticks_per_second = 100;
+    }
+    sampler->history_capacity = history ? history : SINGBOX_PROCSTAT_DEFAULT_HISTORY;
+    sampler->history = calloc(sampler->history_capacity, sizeof(singbox_proc_point_t));
+    
+    if (sampler->status_fd < 0 || sampler->stat_fd < 0 || !sampler->history) {
+        singbox_procstat_close(sampler);
+        return NULL;
+    }
+    return sampler;
+}
+
+void singbox_procstat_close(singbox_procstat_t* sampler) {
+    if (!sampler) {
+        return;
+    }
+    close_fd(&sampler->rollup_fd);
+    close_fd(&sampler->status_fd);
+    close_fd(&sampler->stat_fd);
+    close_fd(&sampler->fd_dir);
+    close_fd(&sampler->task_dir);
+    for (uint32_t i = 0; i < sampler->thread_count; i++) {
+        close_fd(&sampler->threads[i].fd);
+    }
+    free(sampler->history);
+    free(sampler);
+}
+
+pid_t singbox_procstat_pid(const singbox_procstat_t* sampler) {
+    return sampler->pid;
+}
+
+/**
+ * Re-read a /proc file from the start; NUL terminated
+ */
+static ssize_t read_file(int fd, char* buffer, size_t size) {
+    size_t used = 0;
+    while (used + 1 < size) {
+        ssize_t n = pread(fd, buffer + used, size - 1 - used, (off_t)used);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        used += (size_t)n;
+    }
+    buffer[used] = '\0';
+    return (ssize_t)used;
+}
+
+/**
+ * Value of a "Key:   123 kB" line, or 0
+ */
+static uint64_t field_kb(const char* text, const char* key) {
+    size_t key_len = strlen(key);
+    for (const char* line = text; line && *line; ) {
+        if (strncmp(line, key, key_len) == 0) {
+            return strtoull(line + key_len, NULL, 10);
+        }
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Parse utime + stime and the comm of a (task) stat line
+ * @return 1 on success
+ */
+static int parse_stat(char* text, uint64_t* ticks, char* name, size_t name_size, uint32_t* threads) {
+    // comm may contain spaces and parentheses; fields resume after the last ')'
+    char* open_paren = strchr(text, '(');
+    char* close_paren = strrchr(text, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) {
+        return 0;
+    }
+    if (name) {
+        size_t length = (size_t)(close_paren - open_paren - 1);
+        if (length >= name_size) {
+            length = name_size - 1;
+        }
+        memcpy(name, open_paren + 1, length);
+        name[length] = '\0';
+    }
+    
+    // Field 3 (state) follows; utime and stime are fields 14 and 15,
+    // num_threads field 20
+    char* cursor = close_paren + 2;
+    uint64_t utime = 0, stime = 0;
+    for (int field = 3; field <= 20 && *cursor; field++) {
+        char* end;
+        unsigned long long value = strtoull(cursor, &end, 10);
+        if (field == 14) {
+            utime = value;
+        } else if (field == 15) {
+            stime = value;
+        } else if (field == 20 && threads) {
+            *threads = (uint32_t)value;
+        }
+        cursor = strchr(cursor, ' ');
+        if (!cursor) {
+            break;
+        }
+        cursor++;
+    }
+    *ticks = utime + stime;
+    return 1;
+}
+
+/**
+ * Call `fn` for every numeric entry of a directory fd; returns the entry count
+ */
+static int for_each_numeric_entry(int dir_fd, void (*fn)(void* ctx, int32_t value), void* ctx) {
+    if (lseek(dir_fd, 0, SEEK_SET) < 0) {
+        return -1;
+    }
+    char buffer[READ_BUFFER_SIZE] __attribute__((aligned(8)));
+    int count = 0;
+    for (;;) {
+        long n = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? -1 : count;
+        }
+        for (long offset = 0; offset < n; ) {
+            // struct linux_dirent64: ino, off, reclen, type, name
+            unsigned short reclen;
+            memcpy(&reclen, buffer + offset + 16, sizeof(reclen));
+            const char* name = buffer + offset + 19;
+            if (name[0] >= '0' && name[0] <= '9') {
+                count++;
+                if (fn) {
+                    fn(ctx, (int32_t)strtol(name, NULL, 10));
+                }
+            }
+            offset += reclen;
+        }
+    }
+}
+
+static void mark_thread(void* ctx, int32_t tid) {
+    singbox_procstat_t* sampler = ctx;
+    for (uint32_t i = 0; i < sampler->thread_count; i++) {
+        if (sampler->threads[i].tid == tid) {
+            sampler->threads[i].seen = 1;
+            return;
+        }
+    }
+    if (sampler->thread_count == SINGBOX_PROCSTAT_MAX_THREADS) {
+        return;
+    }
+    
+    char name[48];
+    snprintf(name, sizeof(name), "task/%d/stat", (int)tid);
+    int fd = open_proc(sampler->pid, name, 0);
+    if (fd < 0) {
+        return; // Exited meanwhile
+    }
+    thread_slot_t* slot = &sampler->threads[sampler->thread_count++];
+    slot->tid = tid;
+    slot->fd = fd;
+    slot->last_ticks = UINT64_MAX; // No baseline yet
+    slot->seen = 1;
+}
+
+static double cpu_percent(uint64_t ticks, uint64_t last_ticks, int64_t elapsed_ms, long ticks_per_second) {
+    if (last_ticks == UINT64_MAX || elapsed_ms <= 0 || ticks < last_ticks) {
+        return 0;
+    }
+    return (double)(ticks - last_ticks) * 100000.0 / ((double)ticks_per_second * (double)elapsed_ms);
+}
+
+static void sample_threads(singbox_procstat_t* sampler, int64_t elapsed_ms, singbox_proc_snapshot_t* snapshot) {
+    for (uint32_t i = 0; i < sampler->thread_count; i++) {
+        sampler->threads[i].seen = 0;
+    }
+    for_each_numeric_entry(sampler->task_dir, mark_thread, sampler);
+    
+    char buffer[1024];
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < sampler->thread_count; i++) {
+        thread_slot_t slot = sampler->threads[i];
+        uint64_t ticks;
+        char name[16];
+        if (!slot.seen || read_file(slot.fd, buffer, sizeof(buffer)) <= 0 ||
+            !parse_stat(buffer, &ticks, name, sizeof(name), NULL)) {
+            close(slot.fd); // Thread is gone
+            continue;
+        }
+        
+        singbox_thread_sample_t* out = &snapshot->thread[snapshot->thread_samples++];
+        out->tid = slot.tid;
+        memcpy(out->name, name, sizeof(out->name));
+        out->cpu_ticks = ticks;
+        out->cpu_percent = cpu_percent(ticks, slot.last_ticks, elapsed_ms, sampler->ticks_per_second);
+        
+        slot.last_ticks = ticks;
+        sampler->threads[kept++] = slot;
+    }
+    sampler->thread_count = kept;
+}
+
+int singbox_procstat_sample(singbox_procstat_t* sampler, singbox_proc_snapshot_t* snapshot) {
+    char buffer[READ_BUFFER_SIZE];
+    memset(snapshot, 0, offsetof(singbox_proc_snapshot_t, thread));
+    snapshot->pid = sampler->pid;
+    snapshot->timestamp_ms = monotonic_ms();
+    int64_t elapsed_ms = sampler->last_sample_ms ? snapshot->timestamp_ms - sampler->last_sample_ms : 0;
+    
+    if (read_file(sampler->stat_fd, buffer, sizeof(buffer)) <= 0 ||
+        !parse_stat(buffer, &snapshot->cpu_ticks, NULL, 0, &snapshot->threads)) {
+        return 0; // Reads fail with ESRCH once the process is reaped
+    }
+    snapshot->cpu_percent = sampler->last_sample_ms
+        ? cpu_percent(snapshot->cpu_ticks, sampler->last_ticks, elapsed_ms, sampler->ticks_per_second) : 0;
+    
+    if (read_file(sampler->status_fd, buffer, sizeof(buffer)) > 0) {
+        snapshot->vm_size_kb = field_kb(buffer, "VmSize:");
+        snapshot->vm_hwm_kb = field_kb(buffer, "VmHWM:");
+        snapshot->rss_kb = field_kb(buffer, "VmRSS:");
+        snapshot->swap_kb = field_kb(buffer, "VmSwap:");
+    }
+    if (sampler->rollup_fd >= 0 && read_file(sampler->rollup_fd, buffer, sizeof(buffer)) > 0) {
+        snapshot->has_pss = 1;
+        snapshot->rss_kb = field_kb(buffer, "Rss:");
+        snapshot->pss_kb = field_kb(buffer, "Pss:");
+        snapshot->pss_anon_kb = field_kb(buffer, "Pss_Anon:");
+        snapshot->pss_file_kb = field_kb(buffer, "Pss_File:");
+        snapshot->swap_kb = field_kb(buffer, "Swap:");
+        snapshot->swap_pss_kb = field_kb(buffer, "SwapPss:");
+    }
+    if (sampler->fd_dir >= 0) {
+        int count = for_each_numeric_entry(sampler->fd_dir, NULL, NULL);
+        snapshot->fd_count = count > 0 ? (uint32_t)count : 0;
+    }
+    if (sampler->task_dir >= 0) {
+        sample_threads(sampler, elapsed_ms, snapshot);
+    }
+    
+    sampler->last_sample_ms = snapshot->timestamp_ms;
+    sampler->last_ticks = snapshot->cpu_ticks;
+    
+    singbox_proc_point_t* point = &sampler->history[sampler->history_next];
+    point->timestamp_ms = snapshot->timestamp_ms;
+    point->rss_kb = (uint32_t)snapshot->rss_kb;
+    point->pss_kb = (uint32_t)snapshot->pss_kb;
+    point->swap_kb = (uint32_t)snapshot->swap_kb;
+    point->fd_count = snapshot->fd_count;
+    point->threads = snapshot->threads;
+    point->cpu_percent = (float)snapshot->cpu_percent;
+    sampler->history_next = (sampler->history_next + 1) % sampler->history_capacity;
+    if (sampler->history_count < sampler->history_capacity) {
+        sampler->history_count++;
+    }
+    return 1;
+}
+
+size_t singbox_procstat_history(const singbox_procstat_t* sampler, singbox_proc_point_t* points, size_t max_points) {
+    size_t count = sampler->history_count < max_points ? sampler->history_count : max_points;
+    // The newest `count` points, oldest first
+    size_t start = (sampler->history_next + sampler->history_capacity - count) % sampler->history_capacity;
+    for (size_t i = 0; i < count; i++) {
+        points[i] = sampler->history[(start + i) % sampler->history_capacity];
+    }
+    return count;
+}
+
+static int compare_thread_cpu(const void* a, const void* b) {
+    const singbox_thread_sample_t* x = a;
+    const singbox_thread_sample_t* y = b;
+    if (x->cpu_percent != y->cpu_percent) {
+        return x->cpu_percent < y->cpu_percent ? 1 : -1;
+    }
+    return (x->tid > y->tid) - (x->tid < y->tid);
+}
+
+/**
+ * Append to `out`; the running length goes past `size` when truncated
+ */
+static size_t append(char* out, size_t size, size_t length, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(length < size ? out + length : NULL, length < size ? size - length : 0, format, args);
+    va_end(args);
+    return n < 0 ? size : length + (size_t)n;
+}
+
+int singbox_procstat_format_json(const singbox_proc_snapshot_t* snapshot, uint32_t max_threads,
+                                 char* out, size_t size) {
+    size_t length = append(out, size, 0,
+        "{\"pid\":%d,\"rss_kb\":%llu,\"pss_kb\":%llu,\"pss_anon_kb\":%llu,\"pss_file_kb\":%llu,"
+        "\"swap_kb\":%llu,\"swap_pss_kb\":%llu,\"vm_size_kb\":%llu,\"vm_hwm_kb\":%llu,"
+        "\"has_pss\":%s,\"open_fds\":%u,\"threads\":%u,\"cpu_percent\":%.1f,\"thread_cpu\":[",
+        (int)snapshot->pid,
+        (unsigned long long)snapshot->rss_kb, (unsigned long long)snapshot->pss_kb,
+        (unsigned long long)snapshot->pss_anon_kb, (unsigned long long)snapshot->pss_file_kb,
+        (unsigned long long)snapshot->swap_kb, (unsigned long long)snapshot->swap_pss_kb,
+        (unsigned long long)snapshot->vm_size_kb, (unsigned long long)snapshot->vm_hwm_kb,
+        snapshot->has_pss ? "true" : "false", snapshot->fd_count, snapshot->threads,
+        snapshot->cpu_percent);
+    
+    singbox_thread_sample_t sorted[SINGBOX_PROCSTAT_MAX_THREADS];
+    uint32_t count = snapshot->thread_samples;
+    memcpy(sorted, snapshot->thread, count * sizeof(sorted[0]));
+    qsort(sorted, count, sizeof(sorted[0]), compare_thread_cpu);
+    if (count > max_threads) {
+        count = max_threads;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        // Thread names are set by the runtime; keep them JSON safe
+        char name[16];
+        size_t j = 0;
+        for (; sorted[i].name[j] && j < sizeof(name) - 1; j++) {
+            char c = sorted[i].name[j];
+            name[j] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+        }
+        name[j] = '\0';
+        length = append(out, size, length, "%s{\"tid\":%d,\"name\":\"%s\",\"cpu_percent\":%.1f}",
+                        i ? "," : "", (int)sorted[i].tid, name, sorted[i].cpu_percent);
+    }
+    length = append(out, size, length, "]}");
+    return length < size ? (int)length : -1;
+}
+
+int singbox_procstat_format_history_json(const singbox_procstat_t* sampler, char* out, size_t size) {
+    size_t length = append(out, size, 0, "[");
+    uint32_t start = (sampler->history_next + sampler->history_capacity - sampler->history_count) %
+                     sampler->history_capacity;
+    for (uint32_t i = 0; i < sampler->history_count; i++) {
+        const singbox_proc_point_t* point = &sampler->history[(start + i) % sampler->history_capacity];
+        length = append(out, size, length,
+                        "%s{\"t\":%lld,\"rss_kb\":%u,\"pss_kb\":%u,\"swap_kb\":%u,\"fds\":%u,"
+                        "\"threads\":%u,\"cpu\":%.1f}",
+                        i ? "," : "", (long long)point->timestamp_ms, point->rss_kb, point->pss_kb,
+                        point->swap_kb, point->fd_count, point->threads, (double)point->cpu_percent);
+    }
+    length = append(out, size, length, "]");
+    return length < size ? (int)length : -1;
+}
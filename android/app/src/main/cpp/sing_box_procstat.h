@@ -0,0 +1,110 @@
+#ifndef SING_BOX_PROCSTAT_H
+#define SING_BOX_PROCSTAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Memory and CPU accounting of one process from /proc.
+ *
+ * A sampler keeps /proc/<pid>/{smaps_rollup,status,stat} and the fd/ and
+ * task/ directories open and re-reads them with pread/getdents, so a
+ * sample costs a handful of syscalls and no path lookups. Per-thread stat
+ * files stay open across samples while the thread lives. CPU percentages
+ * are deltas against the previous sample (100 = one core busy).
+ *
+ * Kernels without smaps_rollup (< 4.14) report RSS and swap from status
+ * and leave PSS at zero with has_pss unset.
+ */
+
+#define SINGBOX_PROCSTAT_MAX_THREADS 64
+#define SINGBOX_PROCSTAT_DEFAULT_HISTORY 300
+
+typedef struct {
+    int32_t tid;
+    char name[16];
+    uint64_t cpu_ticks;         // utime + stime
+    double cpu_percent;
+} singbox_thread_sample_t;
+
+typedef struct {
+    int64_t timestamp_ms;       // CLOCK_MONOTONIC
+    int32_t pid;
+    int has_pss;
+    uint64_t rss_kb;
+    uint64_t pss_kb;
+    uint64_t pss_anon_kb;
+    uint64_t pss_file_kb;
+    uint64_t swap_kb;
+    uint64_t swap_pss_kb;
+    uint64_t vm_size_kb;
+    uint64_t vm_hwm_kb;
+    uint32_t fd_count;
+    uint32_t threads;           // As reported by the kernel
+    uint64_t cpu_ticks;         // Process utime + stime
+    double cpu_percent;
+    uint32_t thread_samples;    // Entries filled in `thread` (at most MAX_THREADS)
+    singbox_thread_sample_t thread[SINGBOX_PROCSTAT_MAX_THREADS];
+} singbox_proc_snapshot_t;
+
+/**
+ * One entry of the time series
+ */
+typedef struct {
+    int64_t timestamp_ms;
+    uint32_t rss_kb;
+    uint32_t pss_kb;
+    uint32_t swap_kb;
+    uint32_t fd_count;
+    uint32_t threads;
+    float cpu_percent;
+} singbox_proc_point_t;
+
+typedef struct singbox_procstat singbox_procstat_t;
+
+/**
+ * Open a sampler for `pid`
+ * @param history Time series capacity, 0 for SINGBOX_PROCSTAT_DEFAULT_HISTORY
+ * @return NULL if the process cannot be opened
+ */
+singbox_procstat_t* singbox_procstat_open(pid_t pid, uint32_t history);
+
+void singbox_procstat_close(singbox_procstat_t* sampler);
+
+pid_t singbox_procstat_pid(const singbox_procstat_t* sampler);
+
+/**
+ * Take a sample and append it to the time series
+ * @return 1 on success, 0 once the process is gone
+ */
+int singbox_procstat_sample(singbox_procstat_t* sampler, singbox_proc_snapshot_t* snapshot);
+
+/**
+ * Copy the time series, oldest first
+ * @return Number of points copied
+ */
+size_t singbox_procstat_history(const singbox_procstat_t* sampler, singbox_proc_point_t* points, size_t max_points);
+
+/**
+ * Format a snapshot as JSON (per-thread entries sorted by CPU, at most `max_threads`)
+ * @return Length written, or -1 if `size` is too small
+ */
+int singbox_procstat_format_json(const singbox_proc_snapshot_t* snapshot, uint32_t max_threads,
+                                 char* out, size_t size);
+
+/**
+ * Format the time series as a JSON array
+ * @return Length written, or -1 if `size` is too small
+ */
+int singbox_procstat_format_history_json(const singbox_procstat_t* sampler, char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_PROCSTAT_H
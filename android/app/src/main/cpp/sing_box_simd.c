@@ -0,0 +1,205 @@
+#include "sing_box_simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SINGBOX_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SINGBOX_SIMD_NEON 1
+#endif
+
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static int equals_ci(const char* a, const char* b, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (fold((unsigned char)a[i]) != fold((unsigned char)b[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const char* singbox_simd_backend(void) {
+#if defined(SINGBOX_SIMD_SSE2)
+    return "sse2";
+#elif defined(SINGBOX_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+const char* singbox_find_byte(const char* data, size_t length, char byte) {
+    size_t i = 0;
+#if defined(SINGBOX_SIMD_SSE2)
+    const __m128i needle = _mm_set1_epi8(byte);
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask) {
+            return data + i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(SINGBOX_SIMD_NEON)
+    const uint8x16_t needle = vdupq_n_u8((uint8_t)byte);
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8((const uint8_t*)data + i), needle);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask) {
+            return data + i + __builtin_ctzll(mask) / 4;
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        if (data[i] == byte) {
+            return data + i;
+        }
+    }
+    return NULL;
+}
+
+const char* singbox_find_byte2(const char* data, size_t length, char a, char b) {
+    size_t i = 0;
+#if defined(SINGBOX_SIMD_SSE2)
+    const __m128i first = _mm_set1_epi8(a);
+    const __m128i second = _mm_set1_epi8(b);
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)));
+        if (mask) {
+            return data + i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(SINGBOX_SIMD_NEON)
+    const uint8x16_t first = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t second = vdupq_n_u8((uint8_t)b);
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t block = vld1q_u8((const uint8_t*)data + i);
+        uint8x16_t eq = vorrq_u8(vceqq_u8(block, first), vceqq_u8(block, second));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask) {
+            return data + i + __builtin_ctzll(mask) / 4;
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        if (data[i] == a || data[i] == b) {
+            return data + i;
+        }
+    }
+    return NULL;
+}
+
+size_t singbox_json_plain_span(const char* data, size_t length) {
+    size_t i = 0;
+#if defined(SINGBOX_SIMD_SSE2)
+    // Signed compare: bytes >= 0x80 are negative and fall below 0x20 too
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i special = _mm_or_si128(_mm_cmplt_epi8(block, space),
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#elif defined(SINGBOX_SIMD_NEON)
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t block = vld1q_u8((const uint8_t*)data + i);
+        uint8x16_t special = vorrq_u8(vorrq_u8(vcltq_u8(block, space), vcgeq_u8(block, high)),
+                                      vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backslash)));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+        if (mask) {
+            return i + (size_t)__builtin_ctzll(mask) / 4;
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\') {
+            return i;
+        }
+    }
+    return length;
+}
+
+/*
+ * Candidate filter: a position can only start a match if both its first and
+ * its last byte agree with the needle's after OR-ing 0x20. That is a superset
+ * of ASCII case folding (it also merges a few punctuation pairs), so every
+ * candidate is confirmed with an exact case-insensitive compare.
+ */
+const char* singbox_memmem_ci(const char* haystack, size_t haystack_len,
+                              const char* needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    if (!haystack || haystack_len < needle_len) {
+        return NULL;
+    }
+
+    const uint8_t first = (uint8_t)(needle[0] | 0x20);
+    const uint8_t last = (uint8_t)(needle[needle_len - 1] | 0x20);
+    const size_t end = haystack_len - needle_len + 1; // Candidate start positions
+    size_t i = 0;
+
+#if defined(SINGBOX_SIMD_SSE2)
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i first_v = _mm_set1_epi8((char)first);
+    const __m128i last_v = _mm_set1_epi8((char)last);
+    for (; i + 16 <= end; i += 16) {
+        __m128i head = _mm_or_si128(_mm_loadu_si128((const __m128i*)(haystack + i)), case_bit);
+        __m128i tail = _mm_or_si128(_mm_loadu_si128((const __m128i*)(haystack + i + needle_len - 1)), case_bit);
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first_v), _mm_cmpeq_epi8(tail, last_v)));
+        while (mask) {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (equals_ci(haystack + at, needle, needle_len)) {
+                return haystack + at;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(SINGBOX_SIMD_NEON)
+    const uint8x16_t case_bit = vdupq_n_u8(0x20);
+    const uint8x16_t first_v = vdupq_n_u8(first);
+    const uint8x16_t last_v = vdupq_n_u8(last);
+    for (; i + 16 <= end; i += 16) {
+        uint8x16_t head = vorrq_u8(vld1q_u8((const uint8_t*)haystack + i), case_bit);
+        uint8x16_t tail = vorrq_u8(vld1q_u8((const uint8_t*)haystack + i + needle_len - 1), case_bit);
+        uint8x16_t eq = vandq_u8(vceqq_u8(head, first_v), vceqq_u8(tail, last_v));
+        // Narrow to a 64-bit mask holding one nibble per byte
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctzll(mask);
+            size_t at = i + bit / 4;
+            if (equals_ci(haystack + at, needle, needle_len)) {
+                return haystack + at;
+            }
+            mask &= ~(0xFull << (bit & ~3u));
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        if (((uint8_t)haystack[i] | 0x20) == first &&
+            ((uint8_t)haystack[i + needle_len - 1] | 0x20) == last &&
+            equals_ci(haystack + i, needle, needle_len)) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,56 @@
+#ifndef SING_BOX_SIMD_H
+#define SING_BOX_SIMD_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Vectorised text scanning primitives used by the log query engine and the
+ * log line parser. SSE2 is used on x86, NEON on arm64; other targets fall
+ * back to portable scalar code with identical results.
+ */
+
+/**
+ * ASCII case-insensitive substring search
+ * @param haystack Text to search (need not be NUL terminated)
+ * @param haystack_len Length of the text
+ * @param needle Substring to find
+ * @param needle_len Length of the substring (0 matches at offset 0)
+ * @return Pointer to the first match or NULL
+ */
+const char* singbox_memmem_ci(const char* haystack, size_t haystack_len,
+                              const char* needle, size_t needle_len);
+
+/**
+ * Find the first occurrence of a byte
+ * @return Pointer to the byte or NULL
+ */
+const char* singbox_find_byte(const char* data, size_t length, char byte);
+
+/**
+ * Find the first byte that is either `a` or `b`
+ * @return Pointer to the byte or NULL
+ */
+const char* singbox_find_byte2(const char* data, size_t length, char a, char b);
+
+/**
+ * Length of the leading run of bytes that need no attention inside a JSON
+ * string: printable ASCII other than '"' and '\\'
+ * @return Offset of the first control, quote, backslash or non-ASCII byte,
+ *         or `length` if there is none
+ */
+size_t singbox_json_plain_span(const char* data, size_t length);
+
+/**
+ * Name of the instruction set selected at compile time ("sse2", "neon" or "scalar")
+ */
+const char* singbox_simd_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_SIMD_H
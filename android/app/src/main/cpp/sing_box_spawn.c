@@ -0,0 +1,222 @@
+#include "sing_box_spawn.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// posix_spawn appeared in bionic with API 28; older targets use vfork().
+// Host tests define SINGBOX_SPAWN_VFORK to exercise that path on Linux.
+#if defined(SINGBOX_SPAWN_VFORK) || (defined(__ANDROID__) && __ANDROID_API__ < 28)
+#define SPAWN_USE_VFORK 1
+#else
+#define SPAWN_USE_VFORK 0
+#include <spawn.h>
+#endif
+
+extern char** environ;
+
+const char* singbox_spawn_backend(void) {
+    return SPAWN_USE_VFORK ? "vfork" : "posix_spawn";
+}
+
+/**
+ * environ plus the extra entries; the strings are shared, only the array is allocated
+ */
+static char** build_environment(const char* const* extra) {
+    size_t base = 0, added = 0;
+    while (environ && environ[base]) {
+        base++;
+    }
+    while (extra && extra[added]) {
+        added++;
+    }
+    
+    char** envp = malloc((base + added + 1) * sizeof(char*));
+    if (!envp) {
+        return NULL;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < base; i++) {
+        // Drop inherited entries the extra list overrides
+        int overridden = 0;
+        for (size_t j = 0; j < added && !overridden; j++) {
+            const char* eq = strchr(extra[j], '=');
+            size_t name_len = eq ? (size_t)(eq - extra[j]) : strlen(extra[j]);
+            overridden = strncmp(environ[i], extra[j], name_len) == 0 && environ[i][name_len] == '=';
+        }
+        if (!overridden) {
+            envp[count++] = environ[i];
+        }
+    }
+    for (size_t j = 0; j < added; j++) {
+        envp[count++] = (char*)extra[j];
+    }
+    envp[count] = NULL;
+    return envp;
+}
+
+#if SPAWN_USE_VFORK
+
+/*
+ * Runs in the vfork child on the parent's stack: only async-signal-safe
+ * calls, no writes to memory other than locals and `*error`.
+ */
+__attribute__((noreturn))
+static void child_exec(const singbox_spawn_request_t* request, int null_fd, int pass_fd,
+                       char** envp, const sigset_t* parent_mask, volatile int* error) {
+    // Handlers installed by the app must not run in the child
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    for (int sig = 1; sig < NSIG; sig++) {
+        struct sigaction current;
+        if (sigaction(sig, NULL, &current) == 0 && current.sa_handler != SIG_IGN &&
+            current.sa_handler != SIG_DFL) {
+            action.sa_handler = SIG_DFL;
+            sigaction(sig, &action, NULL);
+        }
+    }
+    sigprocmask(SIG_SETMASK, parent_mask, NULL);
+    
+    int out = request->stdout_fd >= 0 ? request->stdout_fd : null_fd;
+    int err = request->stderr_fd >= 0 ? request->stderr_fd : null_fd;
+    if (dup2(null_fd, STDIN_FILENO) < 0 || dup2(out, STDOUT_FILENO) < 0 || dup2(err, STDERR_FILENO) < 0) {
+        *error = errno;
+        _exit(127);
+    }
+    if (pass_fd >= 0 && dup2(pass_fd, request->pass_fd_target) < 0) {
+        *error = errno;
+        _exit(127);
+    }
+    
+    // Only a failure of every candidate is reported; after a successful
+    // exec the parent must find `*error` untouched
+    int last_error = ENOENT;
+    for (int i = 0; request->paths[i]; i++) {
+        execve(request->paths[i], request->argv, envp);
+        last_error = errno;
+    }
+    *error = last_error;
+    _exit(127);
+}
+
+static int spawn_child(const singbox_spawn_request_t* request, int null_fd, int pass_fd,
+                       char** envp, pid_t* pid) {
+    sigset_t all, parent_mask;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &parent_mask);
+    
+    // The child writes here before exiting; the parent resumes only after
+    // the child has exec'd or exited, so a plain read is enough
+    volatile int error = 0;
+    pid_t child = vfork();
+    if (child == 0) {
+        child_exec(request, null_fd, pass_fd, envp, &parent_mask, &error);
+    }
+    int saved_errno = errno;
+    pthread_sigmask(SIG_SETMASK, &parent_mask, NULL);
+    
+    if (child < 0) {
+        return saved_errno;
+    }
+    if (error != 0) {
+        // Every exec failed; the child has already exited
+        int status;
+        waitpid(child, &status, 0);
+        return error;
+    }
+    *pid = child;
+    return 0;
+}
+
+#else
+
+static int spawn_child(const singbox_spawn_request_t* request, int null_fd, int pass_fd,
+                       char** envp, pid_t* pid) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int error = posix_spawn_file_actions_init(&actions);
+    if (error != 0) {
+        return error;
+    }
+    error = posix_spawnattr_init(&attr);
+    if (error != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return error;
+    }
+    
+    int out = request->stdout_fd >= 0 ? request->stdout_fd : null_fd;
+    int err = request->stderr_fd >= 0 ? request->stderr_fd : null_fd;
+    posix_spawn_file_actions_adddup2(&actions, null_fd, STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err, STDERR_FILENO);
+    if (pass_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, pass_fd, request->pass_fd_target);
+    }
+    
+    // Reset every caught signal and start with an empty mask
+    sigset_t all, none;
+    sigfillset(&all);
+    sigemptyset(&none);
+    posix_spawnattr_setsigdefault(&attr, &all);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+    
+    error = ENOENT;
+    for (int i = 0; request->paths[i]; i++) {
+        error = posix_spawn(pid, request->paths[i], &actions, &attr, request->argv, envp);
+        if (error == 0) {
+            break;
+        }
+    }
+    
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return error;
+}
+
+#endif
+
+int singbox_spawn(const singbox_spawn_request_t* request, pid_t* pid) {
+    if (!request || !request->paths || !request->paths[0] || !request->argv || !pid) {
+        return EINVAL;
+    }
+    if (request->pass_fd >= 0 && request->pass_fd_target <= STDERR_FILENO) {
+        return EINVAL;
+    }
+    
+    int null_fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (null_fd < 0) {
+        return errno;
+    }
+    
+    // dup2 onto the same number would keep the descriptor close-on-exec;
+    // hand the child a copy instead
+    int pass_fd = request->pass_fd;
+    int pass_copy = -1;
+    if (pass_fd >= 0 && pass_fd == request->pass_fd_target) {
+        pass_copy = fcntl(pass_fd, F_DUPFD_CLOEXEC, request->pass_fd_target + 1);
+        if (pass_copy < 0) {
+            int error = errno;
+            close(null_fd);
+            return error;
+        }
+        pass_fd = pass_copy;
+    }
+    
+    int error = ENOMEM;
+    char** envp = build_environment(request->env);
+    if (envp) {
+        error = spawn_child(request, null_fd, pass_fd, envp, pid);
+        free(envp);
+    }
+    
+    if (pass_copy >= 0) {
+        close(pass_copy);
+    }
+    close(null_fd);
+    return error;
+}
@@ -0,0 +1,58 @@
+#ifndef SING_BOX_SPAWN_H
+#define SING_BOX_SPAWN_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Child process creation without fork().
+ *
+ * fork() from the app process copies the page tables of the whole ART heap
+ * and leaves a child that may only call async-signal-safe functions until
+ * it execs. singbox_spawn instead starts the child with posix_spawn where
+ * the platform has it (glibc, Android API 28+) and with vfork() otherwise;
+ * both share the parent's memory until exec, so the cost does not grow
+ * with the heap. Everything the child needs (argv, environment, descriptor
+ * layout) is prepared in the parent; the child only rearranges descriptors
+ * and execs.
+ *
+ * Close-on-exec policy: the child receives exactly
+ *   0  /dev/null
+ *   1  stdout_fd (or /dev/null)
+ *   2  stderr_fd (or /dev/null)
+ *   pass_fd_target  pass_fd, if any (the TUN device)
+ * Every other descriptor the native layer opens must be O_CLOEXEC; the
+ * spawn path does not sweep descriptors.
+ */
+
+typedef struct {
+    const char* const* paths;       // Executables tried in order, NULL terminated
+    char* const* argv;              // NULL terminated; argv[0] is used as given
+    const char* const* env;         // Extra "NAME=value" entries, NULL terminated, or NULL
+    int stdout_fd;                  // -1 for /dev/null
+    int stderr_fd;                  // -1 for /dev/null
+    int pass_fd;                    // Descriptor handed to the child, -1 for none
+    int pass_fd_target;             // Its number in the child (> 2)
+} singbox_spawn_request_t;
+
+/**
+ * Start a child process
+ * @param pid Receives the child's pid
+ * @return 0 on success, otherwise the errno of the last exec attempt or of
+ *         the spawn itself (ENOENT when no candidate path exists)
+ */
+int singbox_spawn(const singbox_spawn_request_t* request, pid_t* pid);
+
+/**
+ * Name of the compiled-in mechanism: "posix_spawn" or "vfork"
+ */
+const char* singbox_spawn_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_SPAWN_H
@@ -0,0 +1,83 @@
+#include "sing_box_statsmem.h"
+
+#include <string.h>
+
+#define READ_RETRIES 64
+
+_Static_assert(sizeof(singbox_stats_shared_t) == SINGBOX_STATS_REGION_SIZE, "stats region layout");
+_Static_assert(offsetof(singbox_stats_shared_t, seq) == 8, "stats region layout");
+_Static_assert(offsetof(singbox_stats_shared_t, upload_bytes) == 16, "stats region layout");
+_Static_assert(offsetof(singbox_stats_shared_t, upload_speed) == 48, "stats region layout");
+_Static_assert(offsetof(singbox_stats_shared_t, updates) == 80, "stats region layout");
+
+void singbox_stats_shared_init(singbox_stats_shared_t* region) {
+    memset(region, 0, sizeof(*region));
+    region->version = SINGBOX_STATS_VERSION;
+    region->size = (uint16_t)sizeof(*region);
+    __atomic_store_n(&region->magic, SINGBOX_STATS_MAGIC, __ATOMIC_RELEASE);
+}
+
+/*
+ * The fields are accessed with relaxed atomics so that concurrent reads are
+ * well defined in C; the fences provide the seqlock ordering.
+ */
+#define STORE(field, value) __atomic_store_n(&region->field, (value), __ATOMIC_RELAXED)
+#define LOAD(field) __atomic_load_n(&region->field, __ATOMIC_RELAXED)
+
+static void store_double(double* target, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    __atomic_store_n((uint64_t*)target, bits, __ATOMIC_RELAXED);
+}
+
+static double load_double(const double* source) {
+    uint64_t bits = __atomic_load_n((const uint64_t*)source, __ATOMIC_RELAXED);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void singbox_stats_shared_write(singbox_stats_shared_t* region, const singbox_stats_values_t* values) {
+    uint32_t seq = __atomic_load_n(&region->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&region->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    STORE(state, values->state);
+    STORE(upload_bytes, values->upload_bytes);
+    STORE(download_bytes, values->download_bytes);
+    STORE(packets_sent, values->packets_sent);
+    STORE(packets_received, values->packets_received);
+    store_double(&region->upload_speed, values->upload_speed);
+    store_double(&region->download_speed, values->download_speed);
+    STORE(started_at_ms, values->started_at_ms);
+    STORE(updated_at_ms, values->updated_at_ms);
+    STORE(updates, LOAD(updates) + 1);
+    
+    __atomic_store_n(&region->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+int singbox_stats_shared_read(const singbox_stats_shared_t* region, singbox_stats_values_t* values) {
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+        uint32_t before = __atomic_load_n(&region->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+        
+        values->state = LOAD(state);
+        values->upload_bytes = LOAD(upload_bytes);
+        values->download_bytes = LOAD(download_bytes);
+        values->packets_sent = LOAD(packets_sent);
+        values->packets_received = LOAD(packets_received);
+        values->upload_speed = load_double(&region->upload_speed);
+        values->download_speed = load_double(&region->download_speed);
+        values->started_at_ms = LOAD(started_at_ms);
+        values->updated_at_ms = LOAD(updated_at_ms);
+        values->updates = LOAD(updates);
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&region->seq, __ATOMIC_RELAXED) == before) {
+            return 1;
+        }
+    }
+    return 0;
+}
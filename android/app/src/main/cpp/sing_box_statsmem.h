@@ -0,0 +1,90 @@
+#ifndef SING_BOX_STATSMEM_H
+#define SING_BOX_STATSMEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-layout traffic statistics shared with the managed side.
+ *
+ * The region is plain process memory handed to Kotlin once as a direct
+ * ByteBuffer (SingboxManager.nativeGetStatsBuffer), so a stats poll is a
+ * handful of loads instead of a JNI call, a malloc'd JSON string and a
+ * parse. Native code publishes with a seqlock: `seq` is odd while an update
+ * is in progress and advances by two per update. A reader copies the fields
+ * between two reads of `seq` and retries if they differ or are odd.
+ *
+ * Layout (little endian, 128 bytes, offsets are part of the ABI and are
+ * mirrored by NativeStatsBuffer.kt; bump SINGBOX_STATS_VERSION when they
+ * change, appending fields only grows `size`):
+ *
+ *    0 u32 magic             4 u16 version          6 u16 size
+ *    8 u32 seq              12 u32 state (singbox_core_state_t)
+ *   16 i64 upload_bytes     24 i64 download_bytes
+ *   32 i64 packets_sent     40 i64 packets_received
+ *   48 f64 upload_speed     56 f64 download_speed   (bytes per second)
+ *   64 i64 started_at_ms    72 i64 updated_at_ms    (wall clock)
+ *   80 u64 updates
+ */
+
+#define SINGBOX_STATS_MAGIC 0x54534253u /* "SBST" */
+#define SINGBOX_STATS_VERSION 1
+#define SINGBOX_STATS_REGION_SIZE 128
+
+typedef struct {
+    uint32_t state;
+    int64_t upload_bytes;
+    int64_t download_bytes;
+    int64_t packets_sent;
+    int64_t packets_received;
+    double upload_speed;
+    double download_speed;
+    int64_t started_at_ms;
+    int64_t updated_at_ms;
+    uint64_t updates;
+} singbox_stats_values_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t seq;
+    uint32_t state;
+    int64_t upload_bytes;
+    int64_t download_bytes;
+    int64_t packets_sent;
+    int64_t packets_received;
+    double upload_speed;
+    double download_speed;
+    int64_t started_at_ms;
+    int64_t updated_at_ms;
+    uint64_t updates;
+    uint8_t reserved[SINGBOX_STATS_REGION_SIZE - 88];
+} __attribute__((aligned(64))) singbox_stats_shared_t;
+
+/**
+ * Write the header and zero all values
+ */
+void singbox_stats_shared_init(singbox_stats_shared_t* region);
+
+/**
+ * Publish a new snapshot; `updates` is advanced by the region itself.
+ * Writers must be serialised by the caller; readers never block them.
+ */
+void singbox_stats_shared_write(singbox_stats_shared_t* region, const singbox_stats_values_t* values);
+
+/**
+ * Copy a consistent snapshot
+ * @return 1 on success, 0 if a writer kept the region busy for every retry
+ */
+int singbox_stats_shared_read(const singbox_stats_shared_t* region, singbox_stats_values_t* values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_STATSMEM_H
@@ -0,0 +1,872 @@
+#include "sing_box_uidstats.h"
+#include "sing_box_logparse.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define REPLY_BUFFER_SIZE 32768
+#define INITIAL_FLOWS 256
+#define INITIAL_UIDS 64
+#define MAX_BYTECODE (SINGBOX_UIDSTATS_MAX_PREFIXES * \
+    (2 * sizeof(struct inet_diag_bc_op) + sizeof(struct inet_diag_hostcond) + 16))
+
+// Kernel TCP states (net/tcp_states.h)
+#define TCP_STATE_FIN_WAIT2 5
+#define TCP_STATE_CLOSE_WAIT 8
+#define TCP_STATE_LAST_ACK 9
+#define TCP_STATE_CLOSING 11
+
+// Every state with traffic in flight, i.e. not LISTEN (10), TIME_WAIT (6) or CLOSE (7)
+#define TCP_ACTIVE_STATES ((1u << 1) | (1u << 2) | (1u << 3) | (1u << 4) | (1u << TCP_STATE_FIN_WAIT2) | \
+                           (1u << TCP_STATE_CLOSE_WAIT) | (1u << TCP_STATE_LAST_ACK) | (1u << TCP_STATE_CLOSING))
+
+// Index of a protocol in the per-protocol arrays
+#define TCP_INDEX 0
+#define UDP_INDEX 1
+
+// /proc/net files, same order as proc_fd
+static const char* const proc_net_files[4] = {
+    "/proc/net/tcp", "/proc/net/tcp6", "/proc/net/udp", "/proc/net/udp6"
+};
+
+typedef struct {
+    uint64_t cookie;            // sock_diag cookie or /proc inode; 0 marks a free slot
+    uint64_t upload;            // Counter values at the last refresh
+    uint64_t download;
+    uint32_t uid;
+    uint32_t generation;
+    uint16_t port;
+    uint8_t protocol;           // TCP_INDEX or UDP_INDEX
+} flow_t;
+
+typedef struct {
+    singbox_uid_usage_t usage;
+    int used;
+} uid_slot_t;
+
+typedef struct {
+    uint16_t port;
+    uint8_t network;
+    uint8_t age;
+} pending_t;
+
+typedef struct {
+    uint8_t family;
+    uint8_t prefix_len;
+    uint8_t address[16];
+} prefix_t;
+
+struct singbox_uidstats {
+    singbox_uidstats_source_t source;
+    int diag_fd;
+    uint32_t seq;
+    int proc_fd[4];
+    char* buffer;               // Netlink replies, /proc/net file contents
+    size_t buffer_size;
+
+    prefix_t prefixes[SINGBOX_UIDSTATS_MAX_PREFIXES];
+    int prefix_count;
+    uint8_t bytecode[MAX_BYTECODE];
+    size_t bytecode_len;
+
+    flow_t* flows;
+    size_t flow_capacity;       // Power of two
+    size_t flow_count;
+    uid_slot_t* uids;
+    size_t uid_capacity;        // Power of two
+    size_t uid_count;
+
+    pending_t pending[SINGBOX_UIDSTATS_MAX_PENDING];
+    size_t pending_count;
+
+    uint32_t generation[2];
+    int udp_dirty;
+    singbox_uidstats_stats_t counters;
+};
+
+static size_t hash64(uint64_t key) {
+    key *= 0x9E3779B97F4A7C15ull;
+    return (size_t)(key ^ (key >> 29));
+}
+
+/* Flow table: open addressing with linear probing and backward-shift deletion */
+
+static flow_t* flow_find(singbox_uidstats_t* stats, uint64_t cookie) {
+    size_t mask = stats->flow_capacity - 1;
+    for (size_t i = hash64(cookie) & mask;; i = (i + 1) & mask) {
+        if (stats->flows[i].cookie == cookie) {
+            return &stats->flows[i];
+        }
+        if (stats->flows[i].cookie == 0) {
+            return NULL;
+        }
+    }
+}
+
+static flow_t* flow_slot(flow_t* flows, size_t capacity, uint64_t cookie) {
+    size_t mask = capacity - 1;
+    size_t i = hash64(cookie) & mask;
+    while (flows[i].cookie != 0) {
+        i = (i + 1) & mask;
+    }
+    return &flows[i];
+}
+
+static flow_t* flow_insert(singbox_uidstats_t* stats, uint64_t cookie) {
+    if ((stats->flow_count + 1) * 10 > stats->flow_capacity * 7) {
+        size_t capacity = stats->flow_capacity * 2;
+        flow_t* flows = calloc(capacity, sizeof(*flows));
+        if (!flows) {
+            return NULL;
+        }
+        for (size_t i = 0; i < stats->flow_capacity; i++) {
+            if (stats->flows[i].cookie) {
+                *flow_slot(flows, capacity, stats->flows[i].cookie) = stats->flows[i];
+            }
+        }
+        free(stats->flows);
+        stats->flows = flows;
+        stats->flow_capacity = capacity;
+    }
+    flow_t* flow = flow_slot(stats->flows, stats->flow_capacity, cookie);
+    memset(flow, 0, sizeof(*flow));
+    flow->cookie = cookie;
+    stats->flow_count++;
+    return flow;
+}
+
+static void flow_remove_at(singbox_uidstats_t* stats, size_t hole) {
+    size_t mask = stats->flow_capacity - 1;
+    for (size_t j = (hole + 1) & mask; stats->flows[j].cookie; j = (j + 1) & mask) {
+        size_t home = hash64(stats->flows[j].cookie) & mask;
+        // Move back unless that would put the entry before its home slot
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            stats->flows[hole] = stats->flows[j];
+            hole = j;
+        }
+    }
+    stats->flows[hole].cookie = 0;
+    stats->flow_count--;
+}
+
+/* UID table: same scheme, entries are only dropped by a reset */
+
+static uid_slot_t* uid_slot(uid_slot_t* uids, size_t capacity, uint32_t uid) {
+    size_t mask = capacity - 1;
+    size_t i = hash64(uid) & mask;
+    while (uids[i].used && uids[i].usage.uid != uid) {
+        i = (i + 1) & mask;
+    }
+    return &uids[i];
+}
+
+static singbox_uid_usage_t* uid_usage(singbox_uidstats_t* stats, uint32_t uid) {
+    uid_slot_t* slot = uid_slot(stats->uids, stats->uid_capacity, uid);
+    if (slot->used) {
+        return &slot->usage;
+    }
+    if ((stats->uid_count + 1) * 10 > stats->uid_capacity * 7) {
+        size_t capacity = stats->uid_capacity * 2;
+        uid_slot_t* uids = calloc(capacity, sizeof(*uids));
+        if (!uids) {
+            return NULL;
+        }
+        for (size_t i = 0; i < stats->uid_capacity; i++) {
+            if (stats->uids[i].used) {
+                *uid_slot(uids, capacity, stats->uids[i].usage.uid) = stats->uids[i];
+            }
+        }
+        free(stats->uids);
+        stats->uids = uids;
+        stats->uid_capacity = capacity;
+        slot = uid_slot(uids, capacity, uid);
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->used = 1;
+    slot->usage.uid = uid;
+    stats->uid_count++;
+    return &slot->usage;
+}
+
+static const uid_slot_t* uid_find(const singbox_uidstats_t* stats, uint32_t uid) {
+    const uid_slot_t* slot = uid_slot(stats->uids, stats->uid_capacity, uid);
+    return slot->used ? slot : NULL;
+}
+
+static void count_open_flow(singbox_uid_usage_t* usage, int protocol, int delta) {
+    uint32_t* open = protocol == TCP_INDEX ? &usage->tcp_flows : &usage->udp_flows;
+    if (delta > 0 || *open > 0) {
+        *open += (uint32_t)delta;
+    }
+}
+
+/**
+ * Fold one socket from a dump into its flow and owner
+ */
+static void account_socket(singbox_uidstats_t* stats, int protocol, uint64_t cookie, uint32_t uid, uint16_t port,
+                           int has_bytes, uint64_t upload, uint64_t download) {
+    stats->counters.sockets_seen++;
+    if (cookie == 0) {
+        return;
+    }
+    flow_t* flow = flow_find(stats, cookie);
+    if (!flow) {
+        singbox_uid_usage_t* usage = uid_usage(stats, uid);
+        flow = usage ? flow_insert(stats, cookie) : NULL;
+        if (!flow) {
+            return;
+        }
+        flow->uid = uid;
+        flow->port = port;
+        flow->protocol = (uint8_t)protocol;
+        usage->flows++;
+        count_open_flow(usage, protocol, 1);
+    }
+    flow->generation = stats->generation[protocol];
+
+    if (has_bytes && (upload != flow->upload || download != flow->download)) {
+        singbox_uid_usage_t* usage = uid_usage(stats, flow->uid);
+        if (usage) {
+            usage->upload_bytes += upload > flow->upload ? upload - flow->upload : 0;
+            usage->download_bytes += download > flow->download ? download - flow->download : 0;
+        }
+        flow->upload = upload;
+        flow->download = download;
+    }
+}
+
+/**
+ * Retire the flows of `protocol` that the last complete dump did not return
+ */
+static void sweep(singbox_uidstats_t* stats, int protocol) {
+    uint32_t generation = stats->generation[protocol];
+    for (size_t i = 0; i < stats->flow_capacity;) {
+        flow_t* flow = &stats->flows[i];
+        if (flow->cookie && flow->protocol == protocol && flow->generation != generation) {
+            singbox_uid_usage_t* usage = uid_usage(stats, flow->uid);
+            if (usage) {
+                count_open_flow(usage, protocol, -1);
+            }
+            flow_remove_at(stats, i);
+            continue; // Another entry may have moved into this slot
+        }
+        i++;
+    }
+}
+
+/* Prefixes and the sock_diag filter compiled from them */
+
+static int prefix_bytes(int family) {
+    return family == AF_INET ? 4 : 16;
+}
+
+static int prefix_matches(const prefix_t* prefix, const uint8_t* address, int family) {
+    static const uint8_t v4_mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+    if (family == AF_INET6 && prefix->family == AF_INET) {
+        if (memcmp(address, v4_mapped, sizeof(v4_mapped)) != 0) {
+            return 0;
+        }
+        address += sizeof(v4_mapped);
+    } else if (family != prefix->family) {
+        return 0;
+    }
+    int full = prefix->prefix_len / 8, rest = prefix->prefix_len % 8;
+    if (memcmp(address, prefix->address, (size_t)full) != 0) {
+        return 0;
+    }
+    uint8_t mask = (uint8_t)(0xff << (8 - rest));
+    return rest == 0 || (address[full] & mask) == (prefix->address[full] & mask);
+}
+
+static int in_tunnel(const singbox_uidstats_t* stats, const uint8_t* address, int family) {
+    if (stats->prefix_count == 0) {
+        return 1;
+    }
+    for (int i = 0; i < stats->prefix_count; i++) {
+        if (prefix_matches(&stats->prefixes[i], address, family)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * One source-address condition per prefix, or'ed together. The kernel
+ * audits a program by following `yes`, so a match falls through to a jump
+ * to the end (accept) and a miss skips that jump to the next condition; the
+ * last miss jumps past the end (reject).
+ */
+static void build_bytecode(singbox_uidstats_t* stats) {
+    size_t total = 0;
+    for (int i = 0; i < stats->prefix_count; i++) {
+        total += sizeof(struct inet_diag_bc_op) + sizeof(struct inet_diag_hostcond) +
+                 (size_t)prefix_bytes(stats->prefixes[i].family);
+        if (i < stats->prefix_count - 1) {
+            total += sizeof(struct inet_diag_bc_op);
+        }
+    }
+    size_t offset = 0;
+    for (int i = 0; i < stats->prefix_count; i++) {
+        const prefix_t* prefix = &stats->prefixes[i];
+        int last = i == stats->prefix_count - 1;
+        size_t length = sizeof(struct inet_diag_bc_op) + sizeof(struct inet_diag_hostcond) +
+                        (size_t)prefix_bytes(prefix->family);
+        struct inet_diag_bc_op op = {
+            .code = INET_DIAG_BC_S_COND,
+            .yes = (unsigned char)length,
+            .no = (unsigned short)(length + sizeof(struct inet_diag_bc_op)),
+        };
+        struct inet_diag_hostcond cond = {
+            .family = prefix->family,
+            .prefix_len = prefix->prefix_len,
+            .port = -1,
+        };
+        memcpy(stats->bytecode + offset, &op, sizeof(op));
+        memcpy(stats->bytecode + offset + sizeof(op), &cond, sizeof(cond));
+        memcpy(stats->bytecode + offset + sizeof(op) + sizeof(cond), prefix->address,
+               (size_t)prefix_bytes(prefix->family));
+        offset += length;
+        if (!last) {
+            struct inet_diag_bc_op jump = {
+                .code = INET_DIAG_BC_JMP,
+                .yes = sizeof(struct inet_diag_bc_op),
+                .no = (unsigned short)(total - offset),
+            };
+            memcpy(stats->bytecode + offset, &jump, sizeof(jump));
+            offset += sizeof(jump);
+        }
+    }
+    stats->bytecode_len = total;
+}
+
+int singbox_uidstats_add_prefix(singbox_uidstats_t* stats, int family, const void* address, int prefix_len) {
+    if ((family != AF_INET && family != AF_INET6) || prefix_len < 0 || prefix_len > prefix_bytes(family) * 8 ||
+        stats->prefix_count == SINGBOX_UIDSTATS_MAX_PREFIXES) {
+        return 0;
+    }
+    prefix_t* prefix = &stats->prefixes[stats->prefix_count++];
+    memset(prefix, 0, sizeof(*prefix));
+    prefix->family = (uint8_t)family;
+    prefix->prefix_len = (uint8_t)prefix_len;
+    memcpy(prefix->address, address, (size_t)prefix_bytes(family));
+    build_bytecode(stats);
+    return 1;
+}
+
+int singbox_uidstats_add_interface(singbox_uidstats_t* stats, const char* ifname) {
+    struct ifaddrs* addresses;
+    if (!ifname || getifaddrs(&addresses) != 0) {
+        return 0;
+    }
+    int added = 0;
+    for (struct ifaddrs* entry = addresses; entry; entry = entry->ifa_next) {
+        if (!entry->ifa_addr || strcmp(entry->ifa_name, ifname) != 0) {
+            continue;
+        }
+        // Applications' sockets carry the interface's own address
+        if (entry->ifa_addr->sa_family == AF_INET) {
+            const struct sockaddr_in* in = (const struct sockaddr_in*)entry->ifa_addr;
+            added += singbox_uidstats_add_prefix(stats, AF_INET, &in->sin_addr, 32);
+        } else if (entry->ifa_addr->sa_family == AF_INET6) {
+            const struct sockaddr_in6* in6 = (const struct sockaddr_in6*)entry->ifa_addr;
+            if (!IN6_IS_ADDR_LINKLOCAL(&in6->sin6_addr)) {
+                added += singbox_uidstats_add_prefix(stats, AF_INET6, &in6->sin6_addr, 128);
+            }
+        }
+    }
+    freeifaddrs(addresses);
+    return added;
+}
+
+/* sock_diag source */
+
+/**
+ * Dump the sockets of one family and protocol
+ * @return 1 on success, 0 if the kernel refused the request, -1 on socket errors
+ */
+static int diag_dump(singbox_uidstats_t* stats, int family, int protocol, uint32_t states) {
+    struct {
+        struct nlmsghdr header;
+        struct inet_diag_req_v2 request;
+        struct rtattr attribute;
+        uint8_t bytecode[MAX_BYTECODE];
+    } message;
+    memset(&message, 0, sizeof(message));
+    size_t length = NLMSG_LENGTH(sizeof(message.request));
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = ++stats->seq;
+    message.request.sdiag_family = (uint8_t)family;
+    message.request.sdiag_protocol = protocol == TCP_INDEX ? IPPROTO_TCP : IPPROTO_UDP;
+    message.request.idiag_states = states;
+    if (protocol == TCP_INDEX) {
+        message.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    }
+    if (stats->bytecode_len) {
+        message.attribute.rta_type = INET_DIAG_REQ_BYTECODE;
+        message.attribute.rta_len = (unsigned short)RTA_LENGTH(stats->bytecode_len);
+        memcpy(message.bytecode, stats->bytecode, stats->bytecode_len);
+        length += RTA_SPACE(stats->bytecode_len);
+    }
+    message.header.nlmsg_len = (uint32_t)length;
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    ssize_t sent;
+    do {
+        sent = sendto(stats->diag_fd, &message, length, 0, (struct sockaddr*)&kernel, sizeof(kernel));
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)length) {
+        return -1;
+    }
+    stats->counters.dumps++;
+
+    for (;;) {
+        ssize_t received = recv(stats->diag_fd, stats->buffer, stats->buffer_size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return -1;
+        }
+
+        for (struct nlmsghdr* header = (struct nlmsghdr*)stats->buffer; NLMSG_OK(header, (size_t)received);
+             header = NLMSG_NEXT(header, received)) {
+            if (header->nlmsg_seq != stats->seq) {
+                continue; // Tail of an earlier, abandoned dump
+            }
+            if (header->nlmsg_type == NLMSG_DONE) {
+                return 1;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                return 0;
+            }
+            if (header->nlmsg_type != SOCK_DIAG_BY_FAMILY ||
+                header->nlmsg_len < NLMSG_LENGTH(sizeof(struct inet_diag_msg))) {
+                continue;
+            }
+
+            const struct inet_diag_msg* msg = NLMSG_DATA(header);
+            int has_bytes = 0;
+            uint64_t upload = 0, download = 0;
+            int attributes_length = (int)header->nlmsg_len - (int)NLMSG_SPACE(sizeof(*msg));
+            for (const struct rtattr* attribute = (const struct rtattr*)((const char*)msg + NLMSG_ALIGN(sizeof(*msg)));
+                 RTA_OK(attribute, attributes_length); attribute = RTA_NEXT(attribute, attributes_length)) {
+                // tcp_info grew over time; bytes_received arrived in 4.1
+                if (attribute->rta_type == INET_DIAG_INFO &&
+                    (size_t)RTA_PAYLOAD(attribute) >= offsetof(struct tcp_info, tcpi_bytes_received) + 8) {
+                    const char* info = RTA_DATA(attribute);
+                    memcpy(&upload, info + offsetof(struct tcp_info, tcpi_bytes_acked), 8);
+                    memcpy(&download, info + offsetof(struct tcp_info, tcpi_bytes_received), 8);
+                    has_bytes = 1;
+                    // Sequence space, not payload: the SYN of an application's
+                    // connect(), our FIN once acked, the peer's FIN once received
+                    upload -= upload > 0;
+                    upload -= upload > 0 && msg->idiag_state == TCP_STATE_FIN_WAIT2;
+                    download -= download > 0 && (msg->idiag_state == TCP_STATE_CLOSE_WAIT ||
+                                                 msg->idiag_state == TCP_STATE_LAST_ACK ||
+                                                 msg->idiag_state == TCP_STATE_CLOSING);
+                }
+            }
+            uint64_t cookie = ((uint64_t)msg->id.idiag_cookie[1] << 32) | msg->id.idiag_cookie[0];
+            account_socket(stats, protocol, cookie, msg->idiag_uid, ntohs(msg->id.idiag_sport),
+                           has_bytes, upload, download);
+        }
+    }
+}
+
+static int diag_refresh(singbox_uidstats_t* stats, int protocol) {
+    uint32_t states = protocol == TCP_INDEX ? TCP_ACTIVE_STATES : 0xffffffffu;
+    if (diag_dump(stats, AF_INET, protocol, states) != 1) {
+        return 0;
+    }
+    // Refused when IPv6 is compiled out; there are no such sockets then
+    return diag_dump(stats, AF_INET6, protocol, states) >= 0;
+}
+
+/* /proc/net source */
+
+static ssize_t read_whole(singbox_uidstats_t* stats, int fd) {
+    size_t length = 0;
+    for (;;) {
+        if (length + 1 >= stats->buffer_size) {
+            char* grown = realloc(stats->buffer, stats->buffer_size * 2);
+            if (!grown) {
+                return -1;
+            }
+            stats->buffer = grown;
+            stats->buffer_size *= 2;
+        }
+        ssize_t n = pread(fd, stats->buffer + length, stats->buffer_size - 1 - length, (off_t)length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        length += (size_t)n;
+    }
+    stats->buffer[length] = '\0';
+    return (ssize_t)length;
+}
+
+static int parse_hex_address(const char* text, size_t length, uint8_t* address) {
+    if (length != 8 && length != 32) {
+        return 0;
+    }
+    // Each 32-bit word is printed as the kernel holds it in memory
+    for (size_t word = 0; word < length / 8; word++) {
+        char digits[9];
+        memcpy(digits, text + word * 8, 8);
+        digits[8] = '\0';
+        uint32_t value = (uint32_t)strtoul(digits, NULL, 16);
+        memcpy(address + word * 4, &value, 4);
+    }
+    return 1;
+}
+
+static int proc_refresh(singbox_uidstats_t* stats, int protocol) {
+    for (int v6 = 0; v6 < 2; v6++) {
+        int fd = stats->proc_fd[protocol * 2 + v6];
+        if (fd < 0) {
+            continue; // No IPv6
+        }
+        ssize_t length = read_whole(stats, fd);
+        if (length < 0) {
+            return 0;
+        }
+        stats->counters.dumps++;
+
+        char* line = strchr(stats->buffer, '\n'); // Skip the column header
+        while (line && *++line) {
+            char* end = strchr(line, '\n');
+            if (end) {
+                *end = '\0';
+            }
+            char local[40];
+            unsigned int port, state, uid;
+            unsigned long long inode;
+            if (sscanf(line, " %*d: %39[0-9A-Fa-f]:%x %*s %x %*s %*s %*s %u %*d %llu",
+                       local, &port, &state, &uid, &inode) == 5) {
+                uint8_t address[16];
+                int family = v6 ? AF_INET6 : AF_INET;
+                int active = protocol == UDP_INDEX || (state < 32 && (TCP_ACTIVE_STATES & (1u << state)));
+                if (active && parse_hex_address(local, strlen(local), address) && in_tunnel(stats, address, family)) {
+                    account_socket(stats, protocol, inode, uid, (uint16_t)port, 0, 0, 0);
+                }
+            }
+            line = end;
+        }
+    }
+    return 1;
+}
+
+/* Connections reported by the core */
+
+void singbox_uidstats_note_connection(singbox_uidstats_t* stats, int network, const char* address, size_t length) {
+    const char* colon = NULL;
+    for (size_t i = length; i > 0; i--) {
+        if (address[i - 1] == ':') {
+            colon = address + i - 1;
+            break;
+        }
+    }
+    if (!colon) {
+        return;
+    }
+    unsigned long port = 0;
+    size_t digits = 0;
+    for (const char* p = colon + 1; p < address + length && *p >= '0' && *p <= '9' && digits < 6; p++, digits++) {
+        port = port * 10 + (unsigned long)(*p - '0');
+    }
+    if (digits == 0 || port == 0 || port > 65535) {
+        return;
+    }
+    if (stats->pending_count == SINGBOX_UIDSTATS_MAX_PENDING) {
+        stats->counters.connections_unattributed++;
+        return;
+    }
+    pending_t* pending = &stats->pending[stats->pending_count++];
+    pending->port = (uint16_t)port;
+    pending->network = (uint8_t)network;
+    pending->age = 0;
+    if (network != SINGBOX_NETWORK_TCP) {
+        stats->udp_dirty = 1;
+    }
+}
+
+static int compare_pending(const void* a, const void* b) {
+    const pending_t* x = a;
+    const pending_t* y = b;
+    return (int)x->port - (int)y->port;
+}
+
+static int network_matches(uint8_t network, int protocol) {
+    return network == SINGBOX_NETWORK_UNKNOWN ||
+           (network == SINGBOX_NETWORK_TCP) == (protocol == TCP_INDEX);
+}
+
+/**
+ * Credit reported connections to the owners of their sockets, in one pass
+ * over the flows with the reports sorted by port
+ */
+static void attribute_pending(singbox_uidstats_t* stats) {
+    if (stats->pending_count == 0) {
+        return;
+    }
+    qsort(stats->pending, stats->pending_count, sizeof(pending_t), compare_pending);
+    for (size_t i = 0; i < stats->flow_capacity; i++) {
+        const flow_t* flow = &stats->flows[i];
+        if (!flow->cookie) {
+            continue;
+        }
+        size_t low = 0, high = stats->pending_count;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (stats->pending[mid].port < flow->port) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        for (size_t j = low; j < stats->pending_count && stats->pending[j].port == flow->port; j++) {
+            pending_t* pending = &stats->pending[j];
+            if (pending->age != UINT8_MAX && network_matches(pending->network, flow->protocol)) {
+                singbox_uid_usage_t* usage = uid_usage(stats, flow->uid);
+                if (usage) {
+                    usage->connections++;
+                }
+                stats->counters.connections_attributed++;
+                pending->age = UINT8_MAX; // Resolved
+                break;
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < stats->pending_count; i++) {
+        pending_t pending = stats->pending[i];
+        if (pending.age == UINT8_MAX) {
+            continue;
+        }
+        if (++pending.age >= SINGBOX_UIDSTATS_PENDING_REFRESHES) {
+            stats->counters.connections_unattributed++;
+            continue;
+        }
+        stats->pending[kept++] = pending;
+    }
+    stats->pending_count = kept;
+}
+
+int singbox_uidstats_refresh(singbox_uidstats_t* stats) {
+    stats->counters.refreshes++;
+    int udp = stats->udp_dirty || stats->counters.refreshes % SINGBOX_UIDSTATS_UDP_SWEEP == 1;
+    int ok = 1;
+    for (int protocol = TCP_INDEX; protocol <= UDP_INDEX; protocol++) {
+        if (protocol == UDP_INDEX && !udp) {
+            continue;
+        }
+        stats->generation[protocol]++;
+        int dumped = stats->source == SINGBOX_UIDSTATS_SOCK_DIAG
+            ? diag_refresh(stats, protocol) : proc_refresh(stats, protocol);
+        if (dumped) {
+            // Only a complete dump proves that a flow is gone
+            sweep(stats, protocol);
+            if (protocol == UDP_INDEX) {
+                stats->udp_dirty = 0;
+            }
+        }
+        ok &= dumped;
+    }
+    attribute_pending(stats);
+    return ok;
+}
+
+void singbox_uidstats_reset(singbox_uidstats_t* stats) {
+    memset(stats->uids, 0, stats->uid_capacity * sizeof(*stats->uids));
+    stats->uid_count = 0;
+    for (size_t i = 0; i < stats->flow_capacity; i++) {
+        const flow_t* flow = &stats->flows[i];
+        singbox_uid_usage_t* usage = flow->cookie ? uid_usage(stats, flow->uid) : NULL;
+        if (usage) {
+            usage->flows++;
+            count_open_flow(usage, flow->protocol, 1);
+        }
+    }
+    stats->counters.connections_attributed = 0;
+    stats->counters.connections_unattributed = 0;
+}
+
+singbox_uidstats_t* singbox_uidstats_open(int force_proc) {
+    singbox_uidstats_t* stats = calloc(1, sizeof(*stats));
+    if (!stats) {
+        return NULL;
+    }
+    stats->diag_fd = -1;
+    for (int i = 0; i < 4; i++) {
+        stats->proc_fd[i] = -1;
+    }
+    stats->buffer_size = REPLY_BUFFER_SIZE;
+    stats->buffer = malloc(stats->buffer_size);
+    stats->flow_capacity = INITIAL_FLOWS;
+    stats->flows = calloc(stats->flow_capacity, sizeof(*stats->flows));
+    stats->uid_capacity = INITIAL_UIDS;
+    stats->uids = calloc(stats->uid_capacity, sizeof(*stats->uids));
+    if (!stats->buffer || !stats->flows || !stats->uids) {
+        singbox_uidstats_close(stats);
+        return NULL;
+    }
+
+    if (!force_proc) {
+        stats->diag_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+        if (stats->diag_fd >= 0) {
+            struct timeval timeout = { 1, 0 };
+            setsockopt(stats->diag_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            // An empty state mask dumps nothing but still needs permission
+            if (diag_dump(stats, AF_INET, TCP_INDEX, 0) == 1) {
+                stats->source = SINGBOX_UIDSTATS_SOCK_DIAG;
+                stats->counters.dumps = 0;
+                return stats;
+            }
+            close(stats->diag_fd);
+            stats->diag_fd = -1;
+        }
+    }
+
+    stats->source = SINGBOX_UIDSTATS_PROC_NET;
+    for (int i = 0; i < 4; i++) {
+        stats->proc_fd[i] = open(proc_net_files[i], O_RDONLY | O_CLOEXEC);
+    }
+    // Android 10+ hides /proc/net from apps; the IPv4 tables must be readable
+    if (stats->proc_fd[0] < 0 || stats->proc_fd[2] < 0) {
+        singbox_uidstats_close(stats);
+        return NULL;
+    }
+    return stats;
+}
+
+void singbox_uidstats_close(singbox_uidstats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    if (stats->diag_fd >= 0) {
+        close(stats->diag_fd);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (stats->proc_fd[i] >= 0) {
+            close(stats->proc_fd[i]);
+        }
+    }
+    free(stats->buffer);
+    free(stats->flows);
+    free(stats->uids);
+    free(stats);
+}
+
+singbox_uidstats_source_t singbox_uidstats_source(const singbox_uidstats_t* stats) {
+    return stats->source;
+}
+
+const char* singbox_uidstats_source_name(singbox_uidstats_source_t source) {
+    return source == SINGBOX_UIDSTATS_SOCK_DIAG ? "sock_diag" : "proc_net";
+}
+
+static int compare_usage(const void* a, const void* b) {
+    const singbox_uid_usage_t* x = a;
+    const singbox_uid_usage_t* y = b;
+    uint64_t x_bytes = x->upload_bytes + x->download_bytes;
+    uint64_t y_bytes = y->upload_bytes + y->download_bytes;
+    if (x_bytes != y_bytes) {
+        return x_bytes < y_bytes ? 1 : -1;
+    }
+    if (x->connections != y->connections) {
+        return x->connections < y->connections ? 1 : -1;
+    }
+    return (x->uid > y->uid) - (x->uid < y->uid);
+}
+
+size_t singbox_uidstats_list(const singbox_uidstats_t* stats, singbox_uid_usage_t* out, size_t max) {
+    singbox_uid_usage_t* all = malloc((stats->uid_count ? stats->uid_count : 1) * sizeof(*all));
+    if (!all) {
+        return 0;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < stats->uid_capacity; i++) {
+        if (stats->uids[i].used) {
+            all[count++] = stats->uids[i].usage;
+        }
+    }
+    qsort(all, count, sizeof(*all), compare_usage);
+    if (count > max) {
+        count = max;
+    }
+    memcpy(out, all, count * sizeof(*all));
+    free(all);
+    return count;
+}
+
+int singbox_uidstats_get(const singbox_uidstats_t* stats, uint32_t uid, singbox_uid_usage_t* usage) {
+    const uid_slot_t* slot = uid_find(stats, uid);
+    if (!slot) {
+        return 0;
+    }
+    *usage = slot->usage;
+    return 1;
+}
+
+void singbox_uidstats_get_stats(const singbox_uidstats_t* stats, singbox_uidstats_stats_t* out) {
+    *out = stats->counters;
+    out->flows_open = (uint32_t)stats->flow_count;
+    out->uids = (uint32_t)stats->uid_count;
+}
+
+static size_t append(char* out, size_t size, size_t length, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(length < size ? out + length : NULL, length < size ? size - length : 0, format, args);
+    va_end(args);
+    return n < 0 ? size : length + (size_t)n;
+}
+
+int singbox_uidstats_format_json(const singbox_uidstats_t* stats, size_t max_apps, char* out, size_t size) {
+    singbox_uidstats_stats_t counters;
+    singbox_uidstats_get_stats(stats, &counters);
+    size_t length = append(out, size, 0,
+        "{\"source\":\"%s\",\"prefixes\":%d,\"refreshes\":%llu,\"flows_open\":%u,"
+        "\"connections_attributed\":%llu,\"connections_unattributed\":%llu,\"apps\":[",
+        singbox_uidstats_source_name(stats->source), stats->prefix_count,
+        (unsigned long long)counters.refreshes, counters.flows_open,
+        (unsigned long long)counters.connections_attributed,
+        (unsigned long long)counters.connections_unattributed);
+
+    singbox_uid_usage_t* apps = malloc((max_apps ? max_apps : 1) * sizeof(*apps));
+    size_t count = apps ? singbox_uidstats_list(stats, apps, max_apps) : 0;
+    for (size_t i = 0; i < count; i++) {
+        length = append(out, size, length,
+            "%s{\"uid\":%u,\"upload_bytes\":%llu,\"download_bytes\":%llu,\"tcp_flows\":%u,"
+            "\"udp_flows\":%u,\"flows\":%llu,\"connections\":%llu}",
+            i ? "," : "", apps[i].uid,
+            (unsigned long long)apps[i].upload_bytes, (unsigned long long)apps[i].download_bytes,
+            apps[i].tcp_flows, apps[i].udp_flows,
+            (unsigned long long)apps[i].flows, (unsigned long long)apps[i].connections);
+    }
+    free(apps);
+    length = append(out, size, length, "]}");
+    return length < size ? (int)length : -1;
+}
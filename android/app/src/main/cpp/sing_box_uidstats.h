@@ -0,0 +1,144 @@
+#ifndef SING_BOX_UIDSTATS_H
+#define SING_BOX_UIDSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-application (UID) accounting of tunnel traffic.
+ *
+ * Only sockets whose local address lies in one of the tunnel's prefixes are
+ * considered: those are the applications' ends of the flows routed into the
+ * TUN device. Their owners come from NETLINK_SOCK_DIAG dumps, with the
+ * prefixes compiled into an INET_DIAG bytecode filter so the kernel skips
+ * every other socket. Where sock_diag is refused, /proc/net/{tcp,tcp6,udp,
+ * udp6} are kept open and re-read instead.
+ *
+ * Bytes come from the tcp_info of each TCP socket (bytes acked is upload,
+ * bytes received is download). The kernel keeps no per-socket UDP byte
+ * counters, so UDP flows are counted without bytes, and the /proc source
+ * has no byte counters at all.
+ *
+ * Connections the core reports ("inbound connection from 172.19.0.1:41234")
+ * are matched to the socket on that local port, which credits them to its
+ * UID as well.
+ *
+ * Refreshing is incremental. Flows are cached by socket cookie, so a known
+ * socket costs one hash probe and a counter delta, and its owner is looked
+ * up once. UDP is only dumped again when the core reported a new UDP
+ * connection, or every SINGBOX_UIDSTATS_UDP_SWEEP refreshes to retire
+ * closed flows.
+ *
+ * Not thread safe; callers serialise access.
+ */
+
+#define SINGBOX_UIDSTATS_MAX_PREFIXES 8
+#define SINGBOX_UIDSTATS_MAX_PENDING 256
+#define SINGBOX_UIDSTATS_UDP_SWEEP 10
+// Refreshes a reported connection may wait for its socket to show up
+#define SINGBOX_UIDSTATS_PENDING_REFRESHES 3
+
+typedef enum {
+    SINGBOX_UIDSTATS_SOCK_DIAG = 0,
+    SINGBOX_UIDSTATS_PROC_NET = 1,
+} singbox_uidstats_source_t;
+
+typedef struct {
+    uint32_t uid;
+    uint64_t upload_bytes;
+    uint64_t download_bytes;
+    uint32_t tcp_flows;         // Open at the last refresh
+    uint32_t udp_flows;
+    uint64_t flows;             // Every flow seen
+    uint64_t connections;       // Core connections attributed to this UID
+} singbox_uid_usage_t;
+
+typedef struct {
+    uint64_t refreshes;
+    uint64_t dumps;             // sock_diag dumps or /proc/net file reads
+    uint64_t sockets_seen;      // Sockets those returned
+    uint32_t flows_open;
+    uint32_t uids;
+    uint64_t connections_attributed;
+    uint64_t connections_unattributed;  // Socket gone or never seen in time
+} singbox_uidstats_stats_t;
+
+typedef struct singbox_uidstats singbox_uidstats_t;
+
+/**
+ * Open the accounting engine
+ * @param force_proc Skip sock_diag (used by tests)
+ * @return NULL if neither source is readable
+ */
+singbox_uidstats_t* singbox_uidstats_open(int force_proc);
+
+void singbox_uidstats_close(singbox_uidstats_t* stats);
+
+singbox_uidstats_source_t singbox_uidstats_source(const singbox_uidstats_t* stats);
+
+/**
+ * Name of a source ("sock_diag" or "proc_net")
+ */
+const char* singbox_uidstats_source_name(singbox_uidstats_source_t source);
+
+/**
+ * Restrict accounting to sockets with a local address in this prefix.
+ * Without any prefix every socket is accounted.
+ * @param address struct in_addr or struct in6_addr for `family`
+ * @return 1 on success, 0 if the table is full or the prefix is invalid
+ */
+int singbox_uidstats_add_prefix(singbox_uidstats_t* stats, int family, const void* address, int prefix_len);
+
+/**
+ * Add the addresses currently configured on an interface as prefixes
+ * @return Number of prefixes added
+ */
+int singbox_uidstats_add_interface(singbox_uidstats_t* stats, const char* ifname);
+
+/**
+ * Note a connection reported by the core; it is matched to its socket on
+ * the next refreshes
+ * @param network singbox_network_t, UNKNOWN matches either protocol
+ * @param address Source "host:port" or "[v6]:port" as logged
+ */
+void singbox_uidstats_note_connection(singbox_uidstats_t* stats, int network, const char* address, size_t length);
+
+/**
+ * Pick up new sockets and counter changes, retire closed flows
+ * @return 1 on success, 0 if the source failed
+ */
+int singbox_uidstats_refresh(singbox_uidstats_t* stats);
+
+/**
+ * Forget the per-UID totals; open flows keep counting from their current values
+ */
+void singbox_uidstats_reset(singbox_uidstats_t* stats);
+
+/**
+ * Copy the per-UID totals, busiest first
+ * @return Number of entries copied
+ */
+size_t singbox_uidstats_list(const singbox_uidstats_t* stats, singbox_uid_usage_t* out, size_t max);
+
+/**
+ * @return 1 with `usage` filled, 0 if the UID has not been seen
+ */
+int singbox_uidstats_get(const singbox_uidstats_t* stats, uint32_t uid, singbox_uid_usage_t* usage);
+
+void singbox_uidstats_get_stats(const singbox_uidstats_t* stats, singbox_uidstats_stats_t* out);
+
+/**
+ * Format the source, counters and the busiest `max_apps` UIDs as JSON
+ * @return Length written, or -1 if `size` is too small
+ */
+int singbox_uidstats_format_json(const singbox_uidstats_t* stats, size_t max_apps, char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SING_BOX_UIDSTATS_H
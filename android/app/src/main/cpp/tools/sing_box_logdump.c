@@ -0,0 +1,140 @@
+/*
+ * sing_box_logdump - offline decoder for the persistent native log file
+ *
+ * Pull the file from a device (for example after a crash) and decode it:
+ *
+ *   adb exec-out run-as com.tunnelmax.vpnclient cat files/singbox_native.slog > native.slog
+ *   sing_box_logdump native.slog
+ *   sing_box_logdump --json native.slog > native.json
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../sing_box_logfile.h"
+
+static const char* level_names[] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+};
+
+static const char* level_name(int level) {
+    return (level >= 0 && level <= 5) ? level_names[level] : "?";
+}
+
+static void print_json_string(const char* text, size_t length) {
+    putchar('"');
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        switch (c) {
+            case '"': fputs("\\\"", stdout); break;
+            case '\\': fputs("\\\\", stdout); break;
+            case '\n': fputs("\\n", stdout); break;
+            case '\r': fputs("\\r", stdout); break;
+            case '\t': fputs("\\t", stdout); break;
+            default:
+                if (c < 0x20) {
+                    printf("\\u%04x", c);
+                } else {
+                    putchar(c);
+                }
+        }
+    }
+    putchar('"');
+}
+
+static int print_text(const singbox_log_view_t* record, void* ctx) {
+    (void)ctx;
+    time_t seconds = (time_t)(record->timestamp_ms / 1000);
+    struct tm tm_info;
+    char timestamp[32];
+    localtime_r(&seconds, &tm_info);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+    printf("%s.%03d %-5s [%.*s] #%llu %.*s\n",
+           timestamp, (int)(record->timestamp_ms % 1000), level_name(record->level),
+           (int)record->module_len, record->module,
+           (unsigned long long)record->seq,
+           (int)record->message_len, record->message);
+    return 0;
+}
+
+static int print_json(const singbox_log_view_t* record, void* ctx) {
+    int* first = (int*)ctx;
+    printf("%s\n  {\"seq\":%llu,\"timestamp\":%lld,\"level\":\"%s\",\"module\":",
+           *first ? "" : ",", (unsigned long long)record->seq,
+           (long long)record->timestamp_ms, level_name(record->level));
+    print_json_string(record->module, record->module_len);
+    fputs(",\"message\":", stdout);
+    print_json_string(record->message, record->message_len);
+    putchar('}');
+    *first = 0;
+    return 0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--json] <log file>\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    int json = 0;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "%s: empty or unreadable\n", path);
+        close(fd);
+        return 1;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    singbox_logfile_decode_stats_t stats;
+    int first = 1;
+    if (json) {
+        fputs("{\"logs\":[", stdout);
+    }
+    long count = singbox_logfile_decode(data, (size_t)st.st_size,
+                                        json ? print_json : print_text, &first, &stats);
+    if (json && count >= 0) {
+        fputs("\n]}\n", stdout);
+    }
+    munmap(data, (size_t)st.st_size);
+
+    if (count < 0) {
+        fprintf(stderr, "%s: not a sing-box native log file\n", path);
+        return 1;
+    }
+    fprintf(stderr, "%llu records, %llu torn, %llu segments\n",
+            (unsigned long long)stats.records, (unsigned long long)stats.torn_records,
+            (unsigned long long)stats.segments);
+    return 0;
+}
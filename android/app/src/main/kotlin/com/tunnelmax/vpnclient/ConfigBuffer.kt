@@ -0,0 +1,75 @@
+package com.tunnelmax.vpnclient
+
+import java.nio.ByteBuffer
+import java.nio.CharBuffer
+import java.nio.charset.CodingErrorAction
+import java.nio.charset.StandardCharsets
+
+/**
+ * Reusable direct buffer for handing configurations to native code
+ *
+ * The JSON is encoded to UTF-8 straight into native memory, which the
+ * native side validates and writes out where it lies. That replaces the
+ * GetStringUTFChars conversion and the copies native code used to make.
+ * The buffer is kept and regrown only when a larger configuration arrives.
+ * Callers must hold the instance's lock from encode until the native call
+ * returns.
+ */
+class ConfigBuffer {
+
+    private var buffer: ByteBuffer? = null
+    private val encoder = StandardCharsets.UTF_8.newEncoder()
+        .onMalformedInput(CodingErrorAction.REPORT)
+        .onUnmappableCharacter(CodingErrorAction.REPORT)
+
+    /**
+     * Encode [config]; the result holds the bytes from position 0 to its limit
+     * @throws java.nio.charset.CharacterCodingException on unpaired surrogates
+     */
+    fun encode(config: String): ByteBuffer {
+        val length = utf8Length(config)
+        val target = buffer?.takeIf { it.capacity() >= length }
+            ?: ByteBuffer.allocateDirect(length).also { buffer = it }
+        target.clear()
+        encoder.reset()
+        val result = encoder.encode(CharBuffer.wrap(config), target, true)
+        if (result.isError) {
+            result.throwException()
+        }
+        encoder.flush(target)
+        target.flip()
+        return target
+    }
+
+    /**
+     * Drop the buffer, e.g. after a one-off very large configuration
+     */
+    fun release() {
+        buffer = null
+    }
+
+    companion object {
+        /**
+         * Exact UTF-8 size of [text] (unpaired surrogates count as 3 bytes)
+         */
+        fun utf8Length(text: CharSequence): Int {
+            var length = 0
+            var i = 0
+            while (i < text.length) {
+                val c = text[i]
+                length += when {
+                    c.code < 0x80 -> 1
+                    c.code < 0x800 -> 2
+                    Character.isHighSurrogate(c) && i + 1 < text.length &&
+                        Character.isLowSurrogate(text[i + 1]) -> {
+                        i++
+                        4
+                    }
+                    else -> 3
+                }
+                i++
+            }
+            return length
+        }
+    }
+}
@@ -0,0 +1,27 @@
+package com.tunnelmax.vpnclient
+
+/**
+ * Push notifications from the native layer (sing_box_notify_jni.c)
+ *
+ * Called on the native notifier thread, never concurrently. Stats pushes
+ * are coalesced to the latest values and spaced by the interval passed to
+ * SingboxManager.nativeSetStatsCallback; state changes are pushed as they
+ * happen. Method names and signatures are resolved in JNI_OnLoad and must
+ * not change without updating the native side.
+ */
+interface NativeEventListener {
+    fun onNativeStats(
+        uploadBytes: Long,
+        downloadBytes: Long,
+        uploadSpeed: Double,
+        downloadSpeed: Double,
+        packetsSent: Long,
+        packetsReceived: Long,
+        startedAtMs: Long
+    )
+
+    /**
+     * @param state One of the NativeStatsBuffer.STATE_* values
+     */
+    fun onNativeStateChanged(state: Int)
+}
@@ -0,0 +1,185 @@
+package com.tunnelmax.vpnclient
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reader for the native log tail ring (sing_box_logtail.h)
+ *
+ * The region is obtained once from SingboxManager.nativeGetLogTailBuffer and
+ * then decoded in place: a refresh walks only the records published since
+ * the cursor, with no JNI transition, native string or JSON parse. Native
+ * code retires records by advancing `tail` before reusing their bytes, so a
+ * record is copied out first and kept only if `tail` has not passed it.
+ */
+class NativeLogTail private constructor(private val buffer: ByteBuffer) {
+
+    /**
+     * Reader position; one per consumer
+     */
+    class Cursor {
+        var offset: Long = -1
+        var nextSeq: Long = 0
+
+        /** Records overwritten or cleared before they were read */
+        var lost: Long = 0
+    }
+
+    private val capacity = buffer.getInt(OFFSET_CAPACITY)
+    private val scratch = ByteArray(MAX_RECORD)
+    private val bulk = buffer.duplicate()
+
+    // Volatile write followed by a volatile read orders the plain buffer
+    // loads around it on every ART version (VarHandle fences need API 33)
+    @Volatile
+    private var fence = 0
+
+    private fun loadFence() {
+        fence = 0
+        @Suppress("UNUSED_VARIABLE")
+        val ignored = fence
+    }
+
+    // 64-bit loads may be split on 32-bit ARM; both counters only grow, so
+    // an unchanged high word brackets a consistent low word
+    private fun readCounter(offset: Int): Long {
+        while (true) {
+            val high = buffer.getInt(offset + 4)
+            loadFence()
+            val low = buffer.getInt(offset)
+            loadFence()
+            if (buffer.getInt(offset + 4) == high) {
+                return (high.toLong() shl 32) or (low.toLong() and 0xFFFFFFFFL)
+            }
+        }
+    }
+
+    /**
+     * Start a cursor at the oldest record held, or only at records written
+     * from now on when [newest] is true
+     */
+    fun cursor(newest: Boolean = false): Cursor {
+        val cursor = Cursor()
+        cursor.offset = readCounter(if (newest) OFFSET_HEAD else OFFSET_TAIL)
+        return cursor
+    }
+
+    /**
+     * Decode the records published since [cursor], oldest first
+     * @param maxRecords Stop after this many records, 0 for no limit
+     * @return The decoded records; empty when there is nothing new
+     */
+    @Synchronized
+    fun poll(cursor: Cursor, maxRecords: Int = 0): List<LogEntry> {
+        val entries = ArrayList<LogEntry>()
+        val head = readCounter(OFFSET_HEAD)
+        loadFence()
+        if (cursor.offset < 0 || cursor.offset > head) {
+            cursor.offset = readCounter(OFFSET_TAIL)
+        }
+
+        while (cursor.offset < head && (maxRecords <= 0 || entries.size < maxRecords)) {
+            val tail = readCounter(OFFSET_TAIL)
+            if (cursor.offset < tail) {
+                cursor.offset = tail
+                continue
+            }
+
+            val offset = cursor.offset
+            val position = (offset % capacity).toInt()
+            val size = buffer.getInt(DATA + position)
+            val valid = size >= 8 && (size and 7) == 0 && size <= MAX_RECORD && position + size <= capacity
+            if (valid) {
+                copyOut(position, size)
+            }
+            loadFence()
+            if (readCounter(OFFSET_TAIL) > offset) {
+                continue
+            }
+            if (!valid) {
+                // Not a record we can decode; resynchronise at the newest one
+                cursor.offset = head
+                break
+            }
+
+            val level = scratch[4].toInt() and 0xFF
+            cursor.offset += size
+            if (level == PADDING) {
+                continue
+            }
+            val moduleLength = scratch[5].toInt() and 0xFF
+            val messageLength = ((scratch[6].toInt() and 0xFF) or ((scratch[7].toInt() and 0xFF) shl 8))
+            if (RECORD_HEADER + moduleLength + messageLength > size) {
+                cursor.offset = head
+                break
+            }
+            val seq = readLong(8)
+            if (cursor.nextSeq != 0L && seq > cursor.nextSeq) {
+                cursor.lost += seq - cursor.nextSeq
+            }
+            cursor.nextSeq = seq + 1
+
+            entries.add(
+                LogEntry(
+                    seq = seq,
+                    timestampMs = readLong(16),
+                    level = LEVEL_NAMES.getOrElse(level) { "INFO" },
+                    module = String(scratch, RECORD_HEADER, moduleLength, Charsets.UTF_8),
+                    message = String(scratch, RECORD_HEADER + moduleLength, messageLength, Charsets.UTF_8)
+                )
+            )
+        }
+        return entries
+    }
+
+    private fun copyOut(position: Int, size: Int) {
+        bulk.position(DATA + position)
+        bulk.get(scratch, 0, size)
+    }
+
+    private fun readLong(index: Int): Long {
+        var value = 0L
+        for (i in 7 downTo 0) {
+            value = (value shl 8) or (scratch[index + i].toLong() and 0xFF)
+        }
+        return value
+    }
+
+    companion object {
+        // Layout of singbox_logtail_t, version 1
+        private const val MAGIC = 0x544C4253 // "SBLT"
+        private const val VERSION = 1
+        private const val OFFSET_MAGIC = 0
+        private const val OFFSET_VERSION = 4
+        private const val OFFSET_HEADER_SIZE = 6
+        private const val OFFSET_CAPACITY = 8
+        private const val OFFSET_HEAD = 16
+        private const val OFFSET_TAIL = 24
+        private const val DATA = 64
+        private const val RECORD_HEADER = 24
+        private const val PADDING = 0xFF
+        private const val MAX_RECORD = (RECORD_HEADER + 31 + 4096 + 7) and 7.inv()
+
+        private val LEVEL_NAMES = arrayOf("TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL")
+
+        /**
+         * Wrap the buffer returned by the native layer
+         * @return null if it is missing or its layout is not one we understand
+         */
+        fun wrap(buffer: ByteBuffer?): NativeLogTail? {
+            if (buffer == null || !buffer.isDirect || buffer.capacity() < DATA) {
+                return null
+            }
+            val view = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+            val capacity = view.getInt(OFFSET_CAPACITY)
+            if (view.getInt(OFFSET_MAGIC) != MAGIC ||
+                view.getShort(OFFSET_VERSION).toInt() != VERSION ||
+                view.getShort(OFFSET_HEADER_SIZE).toInt() != DATA ||
+                capacity <= 0 || (capacity and 7) != 0 ||
+                DATA.toLong() + capacity > buffer.capacity()) {
+                return null
+            }
+            return NativeLogTail(view)
+        }
+    }
+}
@@ -0,0 +1,122 @@
+package com.tunnelmax.vpnclient
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reader for the native shared statistics region (sing_box_statsmem.h)
+ *
+ * The region is obtained once from SingboxManager.nativeGetStatsBuffer and
+ * then polled directly: a read is a few loads from native memory, with no
+ * JNI transition, string or JSON parse. Native code publishes with a
+ * seqlock, so a read copies the fields between two reads of the sequence
+ * counter and retries when an update raced with it.
+ */
+class NativeStatsBuffer private constructor(private val buffer: ByteBuffer) {
+
+    /**
+     * One consistent copy of the region; reused between polls
+     */
+    class Snapshot {
+        var state: Int = 0
+        var uploadBytes: Long = 0
+        var downloadBytes: Long = 0
+        var packetsSent: Long = 0
+        var packetsReceived: Long = 0
+        var uploadSpeed: Double = 0.0
+        var downloadSpeed: Double = 0.0
+        var startedAtMs: Long = 0
+        var updatedAtMs: Long = 0
+        var updates: Long = 0
+
+        val isRunning: Boolean
+            get() = state == STATE_RUNNING
+    }
+
+    // Volatile write followed by a volatile read orders the plain buffer
+    // loads around it on every ART version (VarHandle fences need API 33)
+    @Volatile
+    private var fence = 0
+
+    private fun loadFence() {
+        fence = 0
+        @Suppress("UNUSED_VARIABLE")
+        val ignored = fence
+    }
+
+    /**
+     * Copy the current values into [snapshot]
+     * @return false if a writer kept the region busy for every retry
+     */
+    fun readInto(snapshot: Snapshot): Boolean {
+        repeat(READ_RETRIES) {
+            val before = buffer.getInt(OFFSET_SEQ)
+            if (before and 1 != 0) {
+                return@repeat
+            }
+            loadFence()
+
+            snapshot.state = buffer.getInt(OFFSET_STATE)
+            snapshot.uploadBytes = buffer.getLong(OFFSET_UPLOAD_BYTES)
+            snapshot.downloadBytes = buffer.getLong(OFFSET_DOWNLOAD_BYTES)
+            snapshot.packetsSent = buffer.getLong(OFFSET_PACKETS_SENT)
+            snapshot.packetsReceived = buffer.getLong(OFFSET_PACKETS_RECEIVED)
+            snapshot.uploadSpeed = buffer.getDouble(OFFSET_UPLOAD_SPEED)
+            snapshot.downloadSpeed = buffer.getDouble(OFFSET_DOWNLOAD_SPEED)
+            snapshot.startedAtMs = buffer.getLong(OFFSET_STARTED_AT)
+            snapshot.updatedAtMs = buffer.getLong(OFFSET_UPDATED_AT)
+            snapshot.updates = buffer.getLong(OFFSET_UPDATES)
+
+            loadFence()
+            if (buffer.getInt(OFFSET_SEQ) == before) {
+                return true
+            }
+        }
+        return false
+    }
+
+    companion object {
+        // Layout of singbox_stats_shared_t, version 1
+        private const val MAGIC = 0x54534253 // "SBST"
+        private const val VERSION = 1
+        private const val OFFSET_MAGIC = 0
+        private const val OFFSET_VERSION = 4
+        private const val OFFSET_SIZE = 6
+        private const val OFFSET_SEQ = 8
+        private const val OFFSET_STATE = 12
+        private const val OFFSET_UPLOAD_BYTES = 16
+        private const val OFFSET_DOWNLOAD_BYTES = 24
+        private const val OFFSET_PACKETS_SENT = 32
+        private const val OFFSET_PACKETS_RECEIVED = 40
+        private const val OFFSET_UPLOAD_SPEED = 48
+        private const val OFFSET_DOWNLOAD_SPEED = 56
+        private const val OFFSET_STARTED_AT = 64
+        private const val OFFSET_UPDATED_AT = 72
+        private const val OFFSET_UPDATES = 80
+        private const val MIN_SIZE = 88
+
+        private const val READ_RETRIES = 64
+
+        const val STATE_STOPPED = 0
+        const val STATE_STARTING = 1
+        const val STATE_RUNNING = 2
+        const val STATE_STOPPING = 3
+
+        /**
+         * Wrap the buffer returned by the native layer
+         * @return null if it is missing or its layout is not one we understand
+         */
+        fun wrap(buffer: ByteBuffer?): NativeStatsBuffer? {
+            if (buffer == null || !buffer.isDirect || buffer.capacity() < MIN_SIZE) {
+                return null
+            }
+            val view = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+            if (view.getInt(OFFSET_MAGIC) != MAGIC ||
+                view.getShort(OFFSET_VERSION).toInt() != VERSION ||
+                view.getShort(OFFSET_SIZE).toInt() < MIN_SIZE) {
+                return null
+            }
+            return NativeStatsBuffer(view)
+        }
+    }
+}
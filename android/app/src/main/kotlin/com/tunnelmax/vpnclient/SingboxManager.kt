@@ -3,6 +3,10 @@ package com.tunnelmax.vpnclient
 import android.content.Context
 import android.util.Log
 import kotlinx.coroutines.*
+import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.asSharedFlow
 import kotlinx.serialization.json.*
 import java.time.Duration
 import java.time.LocalDateTime
@@ -17,6 +21,7 @@ class SingboxManager(private val context: Context) {
     
     companion object {
         private const val TAG = "SingboxManager"
+        private const val STATS_PUSH_INTERVAL_MS = 1000
         var isLibraryLoaded = false
             private set
         
@@ -38,9 +43,12 @@ class SingboxManager(private val context: Context) {
     
     // Native method declarations
     external fun nativeInit(): Boolean
+    external fun nativeInitEmbedded(libraryPath: String): Boolean
     external fun nativeStart(configJson: String, tunFd: Int): Boolean
+    external fun nativeStartBuffer(config: java.nio.ByteBuffer, length: Int, tunFd: Int): Boolean
     external fun nativeStop(): Boolean
     external fun nativeGetStats(): String?
+    external fun nativeGetStatsBuffer(): java.nio.ByteBuffer?
     external fun nativeIsRunning(): Boolean
     external fun nativeCleanup(): Unit
     external fun nativeValidateConfig(configJson: String): Boolean
@@ -48,13 +56,18 @@ class SingboxManager(private val context: Context) {
     external fun nativeGetLastError(): String?
     external fun nativeGetDetailedStats(): String?
     external fun nativeResetStats(): Boolean
-    external fun nativeSetStatsCallback(callback: Long): Boolean
+    external fun nativeSetStatsCallback(listener: NativeEventListener?, intervalMs: Int): Boolean
     external fun nativeSetLogLevel(level: Int): Boolean
     external fun nativeGetLogs(): String?
+    external fun nativeQueryLogs(query: String, offset: Int, limit: Int): String?
+    external fun nativeGetLogTailBuffer(): java.nio.ByteBuffer?
     external fun nativeGetMemoryUsage(): String?
+    external fun nativeGetProcessHistory(): String?
+    external fun nativeGetAppUsage(): String?
     external fun nativeOptimizePerformance(): Boolean
     external fun nativeHandleNetworkChange(networkInfo: String): Boolean
     external fun nativeUpdateConfiguration(configJson: String): Boolean
+    external fun nativeUpdateConfigurationBuffer(config: java.nio.ByteBuffer, length: Int): Boolean
     external fun nativeGetConnectionInfo(): String?
     
     // State management
@@ -62,16 +75,97 @@ class SingboxManager(private val context: Context) {
     private val isRunning = AtomicBoolean(false)
     private val currentConfiguration = AtomicReference<String?>(null)
     private val lastError = AtomicReference<String?>(null)
+    private val configBuffer = ConfigBuffer()
     
     // Statistics tracking
     private var startTime: LocalDateTime? = null
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     
+    // Shared native stats region, fetched on first use; polled without JNI
+    private val statsBuffer: NativeStatsBuffer? by lazy {
+        try {
+            NativeStatsBuffer.wrap(nativeGetStatsBuffer())
+        } catch (e: Throwable) {
+            Log.w(TAG, "Shared stats region unavailable, using JSON stats: ${e.message}")
+            null
+        }
+    }
+    private val statsSnapshot = NativeStatsBuffer.Snapshot()
+    
+    // Shared native log tail ring; refreshes decode only records added since the last one
+    private val logTail: NativeLogTail? by lazy {
+        try {
+            NativeLogTail.wrap(nativeGetLogTailBuffer())
+        } catch (e: Throwable) {
+            Log.w(TAG, "Shared log tail unavailable: ${e.message}")
+            null
+        }
+    }
+    private var logTailCursor: NativeLogTail.Cursor? = null
+    
+    // Pushed by the native notifier thread once registered in initialize().
+    // No replay: a late collector would otherwise start from the last sample
+    // of a previous session; the next push arrives within one tick anyway.
+    private val pushEnabled = AtomicBoolean(false)
+    private val _statsUpdates = MutableSharedFlow<NetworkStats>(
+        replay = 0,
+        extraBufferCapacity = 1,
+        onBufferOverflow = BufferOverflow.DROP_OLDEST
+    )
+    val statsUpdates: SharedFlow<NetworkStats> = _statsUpdates.asSharedFlow()
+    
+    private val nativeEvents = object : NativeEventListener {
+        override fun onNativeStats(
+            uploadBytes: Long,
+            downloadBytes: Long,
+            uploadSpeed: Double,
+            downloadSpeed: Double,
+            packetsSent: Long,
+            packetsReceived: Long,
+            startedAtMs: Long
+        ) {
+            if (!isRunning.get()) {
+                return
+            }
+            _statsUpdates.tryEmit(
+                NetworkStats(
+                    bytesReceived = downloadBytes,
+                    bytesSent = uploadBytes,
+                    downloadSpeed = downloadSpeed,
+                    uploadSpeed = uploadSpeed,
+                    packetsReceived = packetsReceived.toInt(),
+                    packetsSent = packetsSent.toInt(),
+                    connectionDuration = startTime?.let { Duration.between(it, LocalDateTime.now()) }
+                        ?: Duration.ofMillis(System.currentTimeMillis() - startedAtMs),
+                    lastUpdated = LocalDateTime.now(),
+                    formattedDownloadSpeed = formatSpeed(downloadSpeed),
+                    formattedUploadSpeed = formatSpeed(uploadSpeed)
+                )
+            )
+        }
+        
+        override fun onNativeStateChanged(state: Int) {
+            Log.d(TAG, "Native state changed: $state")
+            if (state == NativeStatsBuffer.STATE_STOPPED && isRunning.getAndSet(false)) {
+                // sing-box exited on its own
+                currentConfiguration.set(null)
+                startTime = null
+            }
+        }
+    }
+    
+    /**
+     * Whether stats and state changes are pushed, so callers need not poll
+     */
+    fun isPushEnabled(): Boolean = pushEnabled.get()
+    
     /**
      * Initialize the sing-box manager
      * Must be called before any other operations
+     * @param embeddedLibrary Path of a libbox-style library to run sing-box
+     *        in-process instead of as a separate executable
      */
-    fun initialize(): Boolean {
+    fun initialize(embeddedLibrary: String? = null): Boolean {
         if (isInitialized.get()) {
             Log.d(TAG, "SingboxManager already initialized")
             return true
@@ -86,9 +180,10 @@ class SingboxManager(private val context: Context) {
         }
         
         return try {
-            val result = nativeInit()
+            val result = if (embeddedLibrary != null) nativeInitEmbedded(embeddedLibrary) else nativeInit()
             if (result) {
                 isInitialized.set(true)
+                pushEnabled.set(nativeSetStatsCallback(nativeEvents, STATS_PUSH_INTERVAL_MS))
                 Log.i(TAG, "SingboxManager initialized successfully")
             } else {
                 Log.e(TAG, "Failed to initialize SingboxManager")
@@ -134,15 +229,11 @@ class SingboxManager(private val context: Context) {
                 return false
             }
             
-            // Validate configuration
-            if (!nativeValidateConfig(configJson)) {
-                Log.e(TAG, "Configuration validation failed")
-                lastError.set("Invalid configuration")
-                return false
+            // Start native sing-box; the config is validated natively, in place
+            val result = synchronized(configBuffer) {
+                val encoded = configBuffer.encode(configJson)
+                nativeStartBuffer(encoded, encoded.limit(), tunFileDescriptor)
             }
-            
-            // Start native sing-box
-            val result = nativeStart(configJson, tunFileDescriptor)
             if (result) {
                 isRunning.set(true)
                 currentConfiguration.set(configJson)
@@ -239,6 +330,8 @@ class SingboxManager(private val context: Context) {
             return null
         }
         
+        readSharedStats()?.let { return it }
+        
         return try {
             val statsJson = nativeGetStats()
             if (statsJson != null) {
@@ -252,6 +345,31 @@ class SingboxManager(private val context: Context) {
         }
     }
     
+    /**
+     * Read statistics from the shared native region, null to fall back to JSON
+     */
+    private fun readSharedStats(): NetworkStats? {
+        val buffer = statsBuffer ?: return null
+        return synchronized(statsSnapshot) {
+            if (!buffer.readInto(statsSnapshot) || !statsSnapshot.isRunning) {
+                return null
+            }
+            NetworkStats(
+                bytesReceived = statsSnapshot.downloadBytes,
+                bytesSent = statsSnapshot.uploadBytes,
+                downloadSpeed = statsSnapshot.downloadSpeed,
+                uploadSpeed = statsSnapshot.uploadSpeed,
+                packetsReceived = statsSnapshot.packetsReceived.toInt(),
+                packetsSent = statsSnapshot.packetsSent.toInt(),
+                connectionDuration = startTime?.let { Duration.between(it, LocalDateTime.now()) }
+                    ?: Duration.ofMillis(System.currentTimeMillis() - statsSnapshot.startedAtMs),
+                lastUpdated = LocalDateTime.now(),
+                formattedDownloadSpeed = formatSpeed(statsSnapshot.downloadSpeed),
+                formattedUploadSpeed = formatSpeed(statsSnapshot.uploadSpeed)
+            )
+        }
+    }
+    
     /**
      * Get detailed network statistics
      */
@@ -281,7 +399,8 @@ class SingboxManager(private val context: Context) {
      * Check if sing-box is currently running
      */
     fun isRunning(): Boolean {
-        if (!isNativeLibraryAvailable()) {
+        // With pushes enabled the native side reports exits as they happen
+        if (!isNativeLibraryAvailable() || pushEnabled.get()) {
             return isRunning.get()
         }
         
@@ -421,6 +540,52 @@ class SingboxManager(private val context: Context) {
         }
     }
     
+    /**
+     * Get the log records added since the previous call, read straight from
+     * the shared native ring; the first call returns everything it holds
+     * @param maxRecords Stop after this many records, 0 for no limit
+     */
+    fun tailLogs(maxRecords: Int = 0): LogTailResult? {
+        if (!isNativeLibraryAvailable()) {
+            return null
+        }
+        val tail = logTail ?: return null
+        
+        return try {
+            synchronized(tail) {
+                val cursor = logTailCursor ?: tail.cursor().also { logTailCursor = it }
+                val lostBefore = cursor.lost
+                val entries = tail.poll(cursor, maxRecords)
+                LogTailResult(entries, cursor.lost - lostBefore)
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception tailing logs", e)
+            null
+        }
+    }
+    
+    /**
+     * Query logs natively, returning one page of matching entries
+     * @param query Filter expression, e.g. "level>=warn module:dns since:15m timeout"
+     */
+    fun queryLogs(query: String, offset: Int = 0, limit: Int = 100): LogQueryResult? {
+        if (!isNativeLibraryAvailable()) {
+            return null
+        }
+        
+        return try {
+            val resultJson = nativeQueryLogs(query, offset, limit)
+            if (resultJson != null) {
+                parseLogQueryResult(resultJson)
+            } else {
+                null
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception querying logs", e)
+            null
+        }
+    }
+    
     /**
      * Get connection information
      */
@@ -467,7 +632,10 @@ class SingboxManager(private val context: Context) {
                 return false
             }
             
-            val result = nativeUpdateConfiguration(configJson)
+            val result = synchronized(configBuffer) {
+                val encoded = configBuffer.encode(configJson)
+                nativeUpdateConfigurationBuffer(encoded, encoded.limit())
+            }
             if (result) {
                 currentConfiguration.set(configJson)
                 Log.i(TAG, "Configuration updated successfully")
@@ -502,6 +670,70 @@ class SingboxManager(private val context: Context) {
         }
     }
     
+    /**
+     * Get the per-tick memory and CPU samples of the current run, oldest first
+     */
+    fun getProcessHistory(): List<ProcessSample> {
+        if (!isNativeLibraryAvailable()) {
+            return emptyList()
+        }
+        
+        return try {
+            val historyJson = nativeGetProcessHistory() ?: return emptyList()
+            Json.parseToJsonElement(historyJson).jsonArray.map { element ->
+                val point = element.jsonObject
+                ProcessSample(
+                    timestampMs = point["t"]?.jsonPrimitive?.longOrNull ?: 0,
+                    rssKB = point["rss_kb"]?.jsonPrimitive?.longOrNull ?: 0,
+                    pssKB = point["pss_kb"]?.jsonPrimitive?.longOrNull ?: 0,
+                    swapKB = point["swap_kb"]?.jsonPrimitive?.longOrNull ?: 0,
+                    openFileDescriptors = point["fds"]?.jsonPrimitive?.intOrNull ?: 0,
+                    threads = point["threads"]?.jsonPrimitive?.intOrNull ?: 0,
+                    cpuUsagePercent = point["cpu"]?.jsonPrimitive?.doubleOrNull ?: 0.0
+                )
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception getting process history", e)
+            emptyList()
+        }
+    }
+    
+    /**
+     * Get the tunnel traffic of each application UID, busiest first
+     * @return null if per-app accounting is unavailable (not running, or
+     * socket owners are not readable on this device)
+     */
+    fun getAppUsage(): AppUsageReport? {
+        if (!isNativeLibraryAvailable()) {
+            return null
+        }
+        
+        return try {
+            val usageJson = nativeGetAppUsage() ?: return null
+            val report = Json.parseToJsonElement(usageJson).jsonObject
+            val source = report["source"]?.jsonPrimitive?.contentOrNull ?: return null
+            AppUsageReport(
+                source = source,
+                apps = report["apps"]?.jsonArray?.map { element ->
+                    val app = element.jsonObject
+                    AppTrafficUsage(
+                        uid = app["uid"]?.jsonPrimitive?.intOrNull ?: 0,
+                        uploadBytes = app["upload_bytes"]?.jsonPrimitive?.longOrNull ?: 0,
+                        downloadBytes = app["download_bytes"]?.jsonPrimitive?.longOrNull ?: 0,
+                        tcpFlows = app["tcp_flows"]?.jsonPrimitive?.intOrNull ?: 0,
+                        udpFlows = app["udp_flows"]?.jsonPrimitive?.intOrNull ?: 0,
+                        flows = app["flows"]?.jsonPrimitive?.longOrNull ?: 0,
+                        connections = app["connections"]?.jsonPrimitive?.longOrNull ?: 0
+                    )
+                } ?: emptyList(),
+                connectionsUnattributed = report["connections_unattributed"]?.jsonPrimitive?.longOrNull ?: 0
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception getting app usage", e)
+            null
+        }
+    }
+    
     /**
      * Optimize performance
      */
@@ -551,6 +783,7 @@ class SingboxManager(private val context: Context) {
             }
             
             isInitialized.set(false)
+            pushEnabled.set(false)
             isRunning.set(false)
             currentConfiguration.set(null)
             startTime = null
@@ -696,12 +929,28 @@ class SingboxManager(private val context: Context) {
             val latency = json["latency"]?.jsonPrimitive?.intOrNull ?: 0
             val jitter = json["jitter"]?.jsonPrimitive?.intOrNull ?: 0
             val packetLoss = json["packetLoss"]?.jsonPrimitive?.doubleOrNull ?: 0.0
+            val tun = (json["tun"] as? JsonObject)?.let { counters ->
+                fun counter(name: String) = counters[name]?.jsonPrimitive?.longOrNull ?: 0
+                TunCounters(
+                    interfaceName = counters["interface"]?.jsonPrimitive?.contentOrNull ?: "",
+                    source = counters["source"]?.jsonPrimitive?.contentOrNull ?: "",
+                    rxBytes = counter("rxBytes"),
+                    txBytes = counter("txBytes"),
+                    rxPackets = counter("rxPackets"),
+                    txPackets = counter("txPackets"),
+                    rxErrors = counter("rxErrors"),
+                    txErrors = counter("txErrors"),
+                    rxDropped = counter("rxDropped"),
+                    txDropped = counter("txDropped")
+                )
+            }
             
             DetailedNetworkStats(
                 basicStats = basicStats,
                 latency = Duration.ofMillis(latency.toLong()),
                 jitter = Duration.ofMillis(jitter.toLong()),
-                packetLossRate = packetLoss
+                packetLossRate = packetLoss,
+                tunCounters = tun
             )
         } catch (e: Exception) {
             Log.e(TAG, "Exception parsing detailed network stats", e)
@@ -723,6 +972,37 @@ class SingboxManager(private val context: Context) {
         }
     }
     
+    /**
+     * Parse a log query result from JSON
+     */
+    private fun parseLogQueryResult(resultJson: String): LogQueryResult? {
+        return try {
+            val json = Json.parseToJsonElement(resultJson).jsonObject
+            val error = json["error"]?.jsonPrimitive?.contentOrNull
+            
+            val entries = json["logs"]?.jsonArray?.map { element ->
+                val entry = element.jsonObject
+                LogEntry(
+                    seq = entry["seq"]?.jsonPrimitive?.longOrNull ?: 0L,
+                    timestampMs = entry["timestamp"]?.jsonPrimitive?.longOrNull ?: 0L,
+                    level = entry["level"]?.jsonPrimitive?.content ?: "INFO",
+                    module = entry["module"]?.jsonPrimitive?.content ?: "",
+                    message = entry["message"]?.jsonPrimitive?.content ?: ""
+                )
+            } ?: emptyList()
+            
+            LogQueryResult(
+                entries = entries,
+                total = json["total"]?.jsonPrimitive?.intOrNull ?: 0,
+                offset = json["offset"]?.jsonPrimitive?.intOrNull ?: 0,
+                error = error
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception parsing log query result", e)
+            null
+        }
+    }
+    
     /**
      * Parse connection info from JSON
      */
@@ -752,12 +1032,17 @@ class SingboxManager(private val context: Context) {
     private fun parseMemoryStats(memoryJson: String): MemoryStats? {
         return try {
             val json = Json.parseToJsonElement(memoryJson).jsonObject
+            val process = json["process"]?.jsonObject
             
             MemoryStats(
                 totalMemoryMB = json["total_memory_mb"]?.jsonPrimitive?.intOrNull ?: 0,
                 usedMemoryMB = json["used_memory_mb"]?.jsonPrimitive?.intOrNull ?: 0,
                 cpuUsagePercent = json["cpu_usage_percent"]?.jsonPrimitive?.doubleOrNull ?: 0.0,
-                openFileDescriptors = json["open_file_descriptors"]?.jsonPrimitive?.intOrNull ?: 0
+                openFileDescriptors = json["open_file_descriptors"]?.jsonPrimitive?.intOrNull ?: 0,
+                rssKB = process?.get("rss_kb")?.jsonPrimitive?.longOrNull ?: 0,
+                pssKB = process?.get("pss_kb")?.jsonPrimitive?.longOrNull ?: 0,
+                swapKB = process?.get("swap_kb")?.jsonPrimitive?.longOrNull ?: 0,
+                threads = process?.get("threads")?.jsonPrimitive?.intOrNull ?: 0
             )
         } catch (e: Exception) {
             Log.e(TAG, "Exception parsing memory stats", e)
@@ -829,7 +1114,25 @@ data class DetailedNetworkStats(
     val basicStats: NetworkStats,
     val latency: Duration,
     val jitter: Duration,
-    val packetLossRate: Double
+    val packetLossRate: Double,
+    val tunCounters: TunCounters? = null
+)
+
+/**
+ * Kernel counters of the TUN interface since the start (or last reset);
+ * tx is traffic entering the tunnel, rx traffic leaving it
+ */
+data class TunCounters(
+    val interfaceName: String,
+    val source: String,
+    val rxBytes: Long,
+    val txBytes: Long,
+    val rxPackets: Long,
+    val txPackets: Long,
+    val rxErrors: Long,
+    val txErrors: Long,
+    val rxDropped: Long,
+    val txDropped: Long
 )
 
 /**
@@ -860,6 +1163,44 @@ enum class LogLevel {
     FATAL
 }
 
+/**
+ * Single log entry returned by a native log query or the log tail
+ */
+data class LogEntry(
+    val seq: Long,
+    val timestampMs: Long,
+    val level: String,
+    val module: String,
+    val message: String
+) {
+    fun toMap(): Map<String, Any> = mapOf(
+        "seq" to seq,
+        "timestamp" to timestampMs,
+        "level" to level,
+        "module" to module,
+        "message" to message
+    )
+}
+
+/**
+ * Log records read from the shared tail ring since the previous read
+ * @param lost Records that were overwritten or cleared before they could be read
+ */
+data class LogTailResult(
+    val entries: List<LogEntry>,
+    val lost: Long
+)
+
+/**
+ * One page of native log query results
+ */
+data class LogQueryResult(
+    val entries: List<LogEntry>,
+    val total: Int,
+    val offset: Int,
+    val error: String?
+)
+
 /**
  * Connection information data class
  */
@@ -881,6 +1222,49 @@ data class MemoryStats(
     val totalMemoryMB: Int,
     val usedMemoryMB: Int,
     val cpuUsagePercent: Double,
-    val openFileDescriptors: Int
+    val openFileDescriptors: Int,
+    val rssKB: Long = 0,
+    val pssKB: Long = 0,
+    val swapKB: Long = 0,
+    val threads: Int = 0
+)
+
+/**
+ * One point of the sing-box process time series
+ */
+data class ProcessSample(
+    val timestampMs: Long,
+    val rssKB: Long,
+    val pssKB: Long,
+    val swapKB: Long,
+    val openFileDescriptors: Int,
+    val threads: Int,
+    val cpuUsagePercent: Double
+)
+
+/**
+ * Tunnel traffic of one application UID since the run started or was reset.
+ * Bytes are TCP payload only; UDP flows are counted without bytes, and the
+ * proc_net source has no byte counts at all.
+ */
+data class AppTrafficUsage(
+    val uid: Int,
+    val uploadBytes: Long,
+    val downloadBytes: Long,
+    val tcpFlows: Int,
+    val udpFlows: Int,
+    val flows: Long,
+    val connections: Long
+)
+
+/**
+ * Per-app accounting of the current run
+ * @param source "sock_diag" or "proc_net"
+ * @param connectionsUnattributed Core connections whose socket was gone before it was seen
+ */
+data class AppUsageReport(
+    val source: String,
+    val apps: List<AppTrafficUsage>,
+    val connectionsUnattributed: Long
 )
 
@@ -60,6 +60,13 @@ class StatsCollector(private val singboxManager: SingboxManager) {
         
         val job = CoroutineScope(Dispatchers.IO).launch {
             try {
+                if (singboxManager.isPushEnabled()) {
+                    // The native notifier pushes at its own rate; nothing to poll
+                    Log.i(TAG, "Using native stats pushes")
+                    singboxManager.statsUpdates.collect { stats ->
+                        publishStatistics(stats, System.currentTimeMillis())
+                    }
+                }
                 while (isCollecting.get() && isActive) {
                     try {
                         collectStatistics()
@@ -175,40 +182,47 @@ class StatsCollector(private val singboxManager: SingboxManager) {
         val stats = singboxManager.getStatistics()
         
         if (stats != null) {
-            // Calculate speeds if we have previous data
-            val enhancedStats = if (previousStats != null && previousUpdateTime > 0) {
-                val timeDiff = (currentTime - previousUpdateTime) / 1000.0 // Convert to seconds
-                if (timeDiff > 0) {
-                    val downloadSpeedCalculated = (stats.bytesReceived - previousStats!!.bytesReceived) / timeDiff
-                    val uploadSpeedCalculated = (stats.bytesSent - previousStats!!.bytesSent) / timeDiff
-                    
-                    stats.copy(
-                        downloadSpeed = downloadSpeedCalculated,
-                        uploadSpeed = uploadSpeedCalculated,
-                        formattedDownloadSpeed = formatSpeed(downloadSpeedCalculated),
-                        formattedUploadSpeed = formatSpeed(uploadSpeedCalculated)
-                    )
-                } else {
-                    stats
-                }
+            publishStatistics(stats, currentTime)
+        } else {
+            Log.w(TAG, "Failed to get statistics from SingboxManager")
+        }
+    }
+    
+    /**
+     * Derive speeds from the previous sample and emit
+     */
+    private fun publishStatistics(stats: NetworkStats, currentTime: Long) {
+        // Calculate speeds if we have previous data
+        val enhancedStats = if (previousStats != null && previousUpdateTime > 0) {
+            val timeDiff = (currentTime - previousUpdateTime) / 1000.0 // Convert to seconds
+            if (timeDiff > 0) {
+                val downloadSpeedCalculated = (stats.bytesReceived - previousStats!!.bytesReceived) / timeDiff
+                val uploadSpeedCalculated = (stats.bytesSent - previousStats!!.bytesSent) / timeDiff
+                
+                stats.copy(
+                    downloadSpeed = downloadSpeedCalculated,
+                    uploadSpeed = uploadSpeedCalculated,
+                    formattedDownloadSpeed = formatSpeed(downloadSpeedCalculated),
+                    formattedUploadSpeed = formatSpeed(uploadSpeedCalculated)
+                )
             } else {
                 stats
             }
-            
-            // Emit the statistics
-            _statsFlow.tryEmit(enhancedStats)
-            
-            // Store for next calculation
-            previousStats = enhancedStats
-            previousUpdateTime = currentTime
-            
-            // Reset error count on successful collection
-            errorCount.set(0)
-            
-            Log.v(TAG, "Collected stats: ${enhancedStats.formattedDownloadSpeed} ↓ ${enhancedStats.formattedUploadSpeed} ↑")
         } else {
-            Log.w(TAG, "Failed to get statistics from SingboxManager")
+            stats
         }
+        
+        // Emit the statistics
+        _statsFlow.tryEmit(enhancedStats)
+        
+        // Store for next calculation
+        previousStats = enhancedStats
+        previousUpdateTime = currentTime
+        
+        // Reset error count on successful collection
+        errorCount.set(0)
+        
+        Log.v(TAG, "Collected stats: ${enhancedStats.formattedDownloadSpeed} ↓ ${enhancedStats.formattedUploadSpeed} ↑")
     }
     
     /**
@@ -86,6 +86,19 @@ class VpnPlugin : FlutterPlugin, MethodCallHandler, ActivityAware, PluginRegistr
                 val level = call.argument<Int>("level") ?: 1
                 setSingboxLogLevel(level, result)
             }
+            "queryLogs" -> {
+                val query = call.argument<String>("query") ?: ""
+                val offset = call.argument<Int>("offset") ?: 0
+                val limit = call.argument<Int>("limit") ?: 100
+                queryLogs(query, offset, limit, result)
+            }
+            "tailLogs" -> {
+                val maxRecords = call.argument<Int>("maxRecords") ?: 500
+                tailLogs(maxRecords, result)
+            }
+            "getAppUsage" -> {
+                getAppUsage(result)
+            }
             else -> {
                 result.notImplemented()
             }
@@ -234,6 +247,90 @@ class VpnPlugin : FlutterPlugin, MethodCallHandler, ActivityAware, PluginRegistr
         }
     }
 
+    private fun queryLogs(query: String, offset: Int, limit: Int, result: Result) {
+        try {
+            val manager = singboxManager
+            if (manager == null) {
+                result.error("NATIVE_LIBRARY_ERROR", "Native libraries not loaded", null)
+                return
+            }
+            
+            val page = manager.queryLogs(query, offset, limit)
+            when {
+                page == null -> result.error("QUERY_LOGS_ERROR", "Failed to query logs", null)
+                page.error != null -> result.error("INVALID_QUERY", page.error, null)
+                else -> result.success(mapOf(
+                    "entries" to page.entries.map { it.toMap() },
+                    "total" to page.total,
+                    "offset" to page.offset
+                ))
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error querying logs", e)
+            result.error("QUERY_LOGS_ERROR", e.message, null)
+        }
+    }
+
+    private fun tailLogs(maxRecords: Int, result: Result) {
+        try {
+            val manager = singboxManager
+            if (manager == null) {
+                result.error("NATIVE_LIBRARY_ERROR", "Native libraries not loaded", null)
+                return
+            }
+            
+            val batch = manager.tailLogs(maxRecords)
+            if (batch == null) {
+                result.error("TAIL_LOGS_ERROR", "Log tail unavailable", null)
+            } else {
+                result.success(mapOf(
+                    "entries" to batch.entries.map { it.toMap() },
+                    "lost" to batch.lost
+                ))
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error tailing logs", e)
+            result.error("TAIL_LOGS_ERROR", e.message, null)
+        }
+    }
+
+    private fun getAppUsage(result: Result) {
+        try {
+            val manager = singboxManager
+            if (manager == null) {
+                result.error("NATIVE_LIBRARY_ERROR", "Native libraries not loaded", null)
+                return
+            }
+            
+            val report = manager.getAppUsage()
+            if (report == null) {
+                result.success(mapOf("available" to false, "apps" to emptyList<Map<String, Any?>>()))
+                return
+            }
+            val packageManager = context.packageManager
+            result.success(mapOf(
+                "available" to true,
+                "source" to report.source,
+                "connectionsUnattributed" to report.connectionsUnattributed,
+                "apps" to report.apps.map { app ->
+                    mapOf(
+                        "uid" to app.uid,
+                        "packageName" to packageManager.getPackagesForUid(app.uid)?.firstOrNull(),
+                        "uploadBytes" to app.uploadBytes,
+                        "downloadBytes" to app.downloadBytes,
+                        "tcpFlows" to app.tcpFlows,
+                        "udpFlows" to app.udpFlows,
+                        "flows" to app.flows,
+                        "connections" to app.connections
+                    )
+                }
+            ))
+        } catch (e: Exception) {
+            Log.e(TAG, "Error getting app usage", e)
+            result.error("APP_USAGE_ERROR", e.message, null)
+        }
+    }
+
     override fun onDetachedFromEngine(@NonNull binding: FlutterPlugin.FlutterPluginBinding) {
         channel.setMethodCallHandler(null)
     }
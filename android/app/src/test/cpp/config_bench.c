@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sing_box_config.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+/*
+ * Hand-off cost of a large configuration (10 MB of route rules by default):
+ * the string path (JNI modified-UTF-8 conversion into a fresh buffer, a
+ * strdup kept as the current config, stdio write) against the direct
+ * buffer path (in-place validation, write(2) from the caller's memory).
+ * Usage: config_bench [--quick] [megabytes]
+ */
+
+static char* build_config(size_t target, size_t* length) {
+    char* text = malloc(target + 4096);
+    if (!text) {
+        return NULL;
+    }
+    size_t n = (size_t)sprintf(text,
+        "{\"log\":{\"level\":\"info\"},\"outbounds\":[{\"type\":\"vless\",\"tag\":\"proxy \xF0\x9F\x87\xA9\xF0\x9F\x87\xAA\","
+        "\"server\":\"example.com\",\"server_port\":443}],\"route\":{\"rules\":[");
+    for (unsigned rule = 0; n < target; rule++) {
+        n += (size_t)sprintf(text + n, "%s{\"domain_suffix\":[", rule ? "," : "");
+        for (unsigned i = 0; i < 32; i++) {
+            n += (size_t)sprintf(text + n, "%s\"host-%u-%u.region-%u.example.net\"", i ? "," : "",
+                                 rule, i, rule % 97);
+        }
+        n += (size_t)sprintf(text + n, "],\"ip_cidr\":[\"10.%u.%u.0/24\"],\"outbound\":\"proxy\"}",
+                             rule % 256, rule / 256 % 256);
+    }
+    n += (size_t)sprintf(text + n, "]}}");
+    *length = n;
+    return text;
+}
+
+/**
+ * The string path as it was: each step copies the whole config
+ */
+static int legacy_handoff(const char* jstring_chars, size_t length, const char* path) {
+    char* utf_chars = malloc(length + 1);        // GetStringUTFChars
+    if (!utf_chars) {
+        return 0;
+    }
+    memcpy(utf_chars, jstring_chars, length + 1);
+    char* current_config = strdup(utf_chars);    // current_config = copy_string(config)
+    FILE* file = fopen(path, "we");
+    int ok = current_config && file && fputs(utf_chars, file) >= 0; // Copied into the stdio buffer
+    if (file) {
+        ok = fclose(file) == 0 && ok;
+    }
+    free(current_config);
+    free(utf_chars);                             // ReleaseStringUTFChars
+    return ok;
+}
+
+static int direct_handoff(const char* buffer, size_t length, const char* path) {
+    return singbox_config_validate(buffer, length, 0, NULL) &&
+           singbox_config_write_file(path, buffer, length) == 0;
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t megabytes = 10;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            megabytes = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+    int rounds = quick ? 5 : 30;
+    
+    size_t length;
+    char* config = build_config(megabytes << 20, &length);
+    if (!config) {
+        return 1;
+    }
+    char path[] = "/tmp/singbox-config-bench-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+    
+    uint64_t legacy_ns[64], direct_ns[64], validate_ns[64];
+    int ok = 1;
+    for (int r = 0; r < rounds; r++) {
+        uint64_t start = test_now_ns();
+        ok &= legacy_handoff(config, length, path);
+        legacy_ns[r] = test_now_ns() - start;
+        
+        start = test_now_ns();
+        ok &= direct_handoff(config, length, path);
+        direct_ns[r] = test_now_ns() - start;
+        
+        start = test_now_ns();
+        ok &= singbox_config_validate(config, length, 0, NULL);
+        validate_ns[r] = test_now_ns() - start;
+    }
+    
+    double mb = (double)length / (1024.0 * 1024.0);
+    double validate_ms = (double)test_percentile(validate_ns, (size_t)rounds, 50) / 1e6;
+    printf("config %.1f MB, %d rounds, scan backend %s\n", mb, rounds, singbox_simd_backend());
+    printf("string path: p50 %.2f ms, user-space copies 3 (UTF conversion, strdup, stdio), extra heap %.1f MB\n",
+           (double)test_percentile(legacy_ns, (size_t)rounds, 50) / 1e6, mb * 2);
+    printf("direct path: p50 %.2f ms (validation %.2f ms, %.0f MB/s), user-space copies 0, extra heap 0 MB\n",
+           (double)test_percentile(direct_ns, (size_t)rounds, 50) / 1e6, validate_ms, mb / (validate_ms / 1e3));
+    
+    unlink(path);
+    free(config);
+    if (!ok) {
+        fprintf(stderr, "hand-off failed\n");
+        return 1;
+    }
+    return 0;
+}
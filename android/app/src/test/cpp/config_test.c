@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sing_box_config.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+static int valid(const char* text) {
+    return singbox_config_validate(text, strlen(text), 0, NULL);
+}
+
+static void test_accepts_well_formed_configs(void) {
+    CHECK(valid("{}"));
+    CHECK(valid(" \n\t{ }\r\n"));
+    CHECK(valid("{\"log\":{\"level\":\"info\",\"timestamp\":true},\"dns\":null}"));
+    CHECK(valid("{\"a\":[],\"b\":[1,-2,3.5,-0.25e-3,1E+9,0],\"c\":[[{}],[\"x\"]]}"));
+    CHECK(valid("{\"escapes\":\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9 \\uD83D\\uDE00\"}"));
+    CHECK(valid("{\"flag\":\"\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA\",\"name\":\"\xC3\xA9t\xC3\xA9 \xE4\xB8\xAD\"}"));
+    CHECK(valid("\xEF\xBB\xBF{}")); // Byte order mark
+}
+
+static void test_rejects_malformed_configs(void) {
+    const char* cases[] = {
+        "",
+        "[]",                       // Not an object
+        "\"text\"",
+        "{",
+        "{\"a\"}",
+        "{\"a\":}",
+        "{\"a\":1,}",
+        "{\"a\":[1,]}",
+        "{\"a\":[1 2]}",
+        "{a:1}",
+        "{\"a\":01}",
+        "{\"a\":1.}",
+        "{\"a\":-}",
+        "{\"a\":1e}",
+        "{\"a\":tru}",
+        "{\"a\":nul}",
+        "{\"a\":\"\\x\"}",
+        "{\"a\":\"\\u12g4\"}",
+        "{\"a\":\"tab\there\"}",
+        "{\"a\":\"open}",
+        "{} {}",
+        "{}]",
+        "{\"a\":[}",
+        "{\"a\":{]}",
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (valid(cases[i])) {
+            fprintf(stderr, "accepted: %s\n", cases[i]);
+            test_failures++;
+        }
+    }
+    // Embedded NUL bytes never pass
+    CHECK(!singbox_config_validate("{\"a\":\"x\0y\"}", 11, 0, NULL));
+    CHECK(!singbox_config_validate("{}\0", 3, 0, NULL));
+    CHECK(!singbox_config_validate(NULL, 4, 0, NULL));
+}
+
+static void test_utf8_rules(void) {
+    CHECK(!valid("{\"a\":\"\xC3\"}"));                  // Truncated
+    CHECK(!valid("{\"a\":\"\xC1\xBF\"}"));              // Overlong
+    CHECK(!valid("{\"a\":\"\xE0\x80\xAF\"}"));          // Overlong
+    CHECK(!valid("{\"a\":\"\xF4\x90\x80\x80\"}"));      // Above U+10FFFF
+    CHECK(!valid("{\"a\":\"\xFF\"}"));
+    CHECK(!valid("{\"a\":\"\x80\"}"));                  // Stray continuation
+    CHECK(!valid("{\"a\xE2\x82\":1}"));
+    
+    // Surrogates and C0 80 only in modified UTF-8 (GetStringUTFChars output)
+    const char* surrogate_pair = "{\"a\":\"\xED\xA0\xBD\xED\xB8\x80\"}";
+    const char* encoded_nul = "{\"a\":\"\xC0\x80\"}";
+    CHECK(!valid(surrogate_pair));
+    CHECK(!valid(encoded_nul));
+    CHECK(singbox_config_validate(surrogate_pair, strlen(surrogate_pair), SINGBOX_CONFIG_MODIFIED_UTF8, NULL));
+    CHECK(singbox_config_validate(encoded_nul, strlen(encoded_nul), SINGBOX_CONFIG_MODIFIED_UTF8, NULL));
+    CHECK(!singbox_config_validate("{\"a\":\"\xC0\x81\"}", 9, SINGBOX_CONFIG_MODIFIED_UTF8, NULL));
+}
+
+static void test_error_position(void) {
+    const char* text = "{\n  \"log\": {\n    \"level\": \"info\",\n  }\n}";
+    singbox_config_error_t error;
+    CHECK(!singbox_config_validate(text, strlen(text), 0, &error));
+    CHECK_EQ_INT(error.line, 4);
+    CHECK_EQ_INT(error.column, 3);
+    CHECK_EQ_INT(error.offset, strchr(text, '}') - text);
+    CHECK(error.message && strstr(error.message, "member") != NULL);
+    
+    CHECK(!singbox_config_validate("{\"a\":1", 6, 0, &error));
+    CHECK_EQ_INT(error.offset, 6);
+    CHECK_EQ_INT(error.column, 7);
+}
+
+static void test_nesting_limit(void) {
+    size_t depth = SINGBOX_CONFIG_MAX_DEPTH;
+    char* text = malloc(depth * 2 + 16);
+    // Exactly at the limit: an object holding depth-1 nested arrays
+    size_t n = 0;
+    text[n++] = '{';
+    n += (size_t)sprintf(text + n, "\"a\":");
+    for (size_t i = 1; i < depth; i++) {
+        text[n++] = '[';
+    }
+    for (size_t i = 1; i < depth; i++) {
+        text[n++] = ']';
+    }
+    text[n++] = '}';
+    CHECK(singbox_config_validate(text, n, 0, NULL));
+    
+    // One more level fails cleanly instead of overflowing
+    n = 0;
+    text[n++] = '{';
+    n += (size_t)sprintf(text + n, "\"a\":");
+    for (size_t i = 0; i < depth; i++) {
+        text[n++] = '[';
+    }
+    for (size_t i = 0; i < depth; i++) {
+        text[n++] = ']';
+    }
+    text[n++] = '}';
+    singbox_config_error_t error;
+    CHECK(!singbox_config_validate(text, n, 0, &error));
+    CHECK(error.message && strstr(error.message, "deep") != NULL);
+    free(text);
+}
+
+static void test_plain_span_matches_scalar(void) {
+    // Every special byte at every position of a block, plus the tail
+    char text[80];
+    const unsigned char specials[] = { '"', '\\', 0x00, 0x1F, 0x80, 0xC3, 0xFF };
+    for (size_t s = 0; s < sizeof(specials); s++) {
+        for (size_t at = 0; at < sizeof(text); at++) {
+            memset(text, 'a', sizeof(text));
+            text[at] = (char)specials[s];
+            CHECK_EQ_INT(singbox_json_plain_span(text, sizeof(text)), at);
+        }
+    }
+    memset(text, ' ', sizeof(text));
+    CHECK_EQ_INT(singbox_json_plain_span(text, sizeof(text)), sizeof(text));
+    CHECK_EQ_INT(singbox_json_plain_span(text, 0), 0);
+}
+
+static void test_write_file_replaces_atomically(void) {
+    char dir[] = "/tmp/singbox-config-XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    char path[64];
+    char temp_path[72];
+    snprintf(path, sizeof(path), "%s/config.json", dir);
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    
+    const char first[] = "{\"first\":true}";
+    const char second[] = "{\"b\":2}";
+    CHECK_EQ_INT(singbox_config_write_file(path, first, sizeof(first) - 1), 0);
+    CHECK_EQ_INT(singbox_config_write_file(path, second, sizeof(second) - 1), 0);
+    
+    char buffer[64] = {0};
+    FILE* file = fopen(path, "r");
+    CHECK(file != NULL);
+    if (file) {
+        size_t n = fread(buffer, 1, sizeof(buffer) - 1, file);
+        fclose(file);
+        CHECK_EQ_INT(n, sizeof(second) - 1);
+        CHECK(strcmp(buffer, second) == 0);
+    }
+    struct stat st;
+    CHECK(stat(path, &st) == 0 && (st.st_mode & 0777) == 0600);
+    CHECK(access(temp_path, F_OK) != 0);
+    
+    CHECK_EQ_INT(singbox_config_write_file("/nonexistent/dir/config.json", first, 4), ENOENT);
+    
+    unlink(path);
+    rmdir(dir);
+}
+
+int main(void) {
+    RUN_TEST(test_accepts_well_formed_configs);
+    RUN_TEST(test_rejects_malformed_configs);
+    RUN_TEST(test_utf8_rules);
+    RUN_TEST(test_error_position);
+    RUN_TEST(test_nesting_limit);
+    RUN_TEST(test_plain_span_matches_scalar);
+    RUN_TEST(test_write_file_replaces_atomically);
+    return TEST_EXIT();
+}
@@ -0,0 +1,147 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sing_box_core.h"
+#include "test_util.h"
+
+/*
+ * Tail latency of the stats read path (nativeGetStats) while another thread
+ * keeps starting and stopping a fake sing-box that takes 300 ms to exit.
+ * "global lock" wraps every call in one mutex, as the JNI bridge used to;
+ * "lifecycle lock" is the core as shipped.
+ * Usage: core_bench [--quick] [cycles]
+ */
+
+static const char* fake_singbox =
+    "#!/bin/sh\n"
+    "trap 'sleep 0.3; exit 0' TERM\n"
+    "while :; do sleep 0.05; done\n";
+
+#define READERS 2
+#define MAX_SAMPLES 4000000
+
+typedef struct {
+    int global_lock;
+    volatile int stop;
+    uint64_t* samples;
+    size_t count;
+} reader_t;
+
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* stats_reader(void* arg) {
+    reader_t* reader = (reader_t*)arg;
+    char json[512];
+    while (!reader->stop && reader->count < MAX_SAMPLES / READERS) {
+        uint64_t start = test_now_ns();
+        if (reader->global_lock) {
+            pthread_mutex_lock(&legacy_mutex);
+        }
+        singbox_core_format_stats(json, sizeof(json));
+        if (reader->global_lock) {
+            pthread_mutex_unlock(&legacy_mutex);
+        }
+        reader->samples[reader->count++] = test_now_ns() - start;
+        usleep(200); // A busy UI poller, not a spin loop
+    }
+    return NULL;
+}
+
+static void run(const char* name, int global_lock, int cycles, int tun_fd) {
+    reader_t readers[READERS];
+    pthread_t threads[READERS];
+    for (int i = 0; i < READERS; i++) {
+        readers[i] = (reader_t){ .global_lock = global_lock, .samples = malloc(MAX_SAMPLES / READERS * sizeof(uint64_t)) };
+        pthread_create(&threads[i], NULL, stats_reader, &readers[i]);
+    }
+
+    uint64_t start = test_now_ns();
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        if (global_lock) {
+            pthread_mutex_lock(&legacy_mutex);
+        }
+        singbox_core_start("{}", tun_fd);
+        if (global_lock) {
+            pthread_mutex_unlock(&legacy_mutex);
+        }
+        usleep(100000);
+        if (global_lock) {
+            pthread_mutex_lock(&legacy_mutex);
+        }
+        singbox_core_stop();
+        if (global_lock) {
+            pthread_mutex_unlock(&legacy_mutex);
+        }
+    }
+    uint64_t elapsed = test_now_ns() - start;
+
+    size_t total = 0;
+    for (int i = 0; i < READERS; i++) {
+        readers[i].stop = 1;
+        pthread_join(threads[i], NULL);
+        total += readers[i].count;
+    }
+    uint64_t* all = malloc(total * sizeof(uint64_t));
+    size_t offset = 0;
+    for (int i = 0; i < READERS; i++) {
+        memcpy(all + offset, readers[i].samples, readers[i].count * sizeof(uint64_t));
+        offset += readers[i].count;
+        free(readers[i].samples);
+    }
+    printf("  %-15s %7zu calls over %.1f s  p50 %8.1f us  p99 %9.1f us  p99.9 %9.1f us  max %9.1f us\n",
+           name, total, (double)elapsed / 1e9,
+           (double)test_percentile(all, total, 50.0) / 1e3, (double)test_percentile(all, total, 99.0) / 1e3,
+           (double)test_percentile(all, total, 99.9) / 1e3, (double)test_percentile(all, total, 100.0) / 1e3);
+    free(all);
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    int cycles = quick ? 2 : 10;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            cycles = atoi(argv[i]);
+        }
+    }
+
+    char work_dir[] = "/tmp/singbox-bench-XXXXXX";
+    if (!mkdtemp(work_dir)) {
+        return 1;
+    }
+    char config_path[128], binary_path[128];
+    snprintf(config_path, sizeof(config_path), "%s/config.json", work_dir);
+    snprintf(binary_path, sizeof(binary_path), "%s/sing-box", work_dir);
+    FILE* script = fopen(binary_path, "w");
+    if (!script) {
+        return 1;
+    }
+    fputs(fake_singbox, script);
+    fclose(script);
+    chmod(binary_path, 0755);
+    int tun_fd = open("/dev/null", O_RDWR);
+
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    options.config_path = config_path;
+    options.log_file_path = NULL;
+    options.binaries[0] = binary_path;
+    options.binaries[1] = NULL;
+    options.start_grace_ms = 100;
+    if (!singbox_core_init(&options)) {
+        return 1;
+    }
+
+    printf("nativeGetStats latency during %d start/stop cycles, %d readers:\n", cycles, READERS);
+    run("global lock", 1, cycles, tun_fd);
+    run("lifecycle lock", 0, cycles, tun_fd);
+
+    singbox_core_cleanup();
+    close(tun_fd);
+    unlink(binary_path);
+    rmdir(work_dir);
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "sing_box_core.h"
+#include "sing_box_logging.h"
+#include "test_util.h"
+
+/*
+ * Drives the JNI-free bridge core against a fake sing-box: a shell script
+ * that logs a line, runs until SIGTERM and then takes 300 ms to shut down,
+ * or exits on its own when the config asks it to.
+ */
+
+static const char* fake_singbox =
+    "#!/bin/sh\n"
+    "if grep -q exit-soon \"$3\"; then sleep 0.2; exit 3; fi\n"
+    "trap 'sleep 0.3; exit 0' TERM\n"
+    "echo \"INFO [1 0ms] router: fake sing-box up on fd $SING_BOX_TUN_FD\"\n"
+    "while :; do sleep 0.05; done\n";
+
+static char work_dir[64];
+static char config_path[128];
+static char binary_path[128];
+static int tun_fd = -1;
+
+static void setup(void) {
+    snprintf(work_dir, sizeof(work_dir), "/tmp/singbox-core-XXXXXX");
+    CHECK(mkdtemp(work_dir) != NULL);
+    snprintf(config_path, sizeof(config_path), "%s/config.json", work_dir);
+    snprintf(binary_path, sizeof(binary_path), "%s/sing-box", work_dir);
+    FILE* script = fopen(binary_path, "w");
+    CHECK(script != NULL);
+    fputs(fake_singbox, script);
+    fclose(script);
+    chmod(binary_path, 0755);
+    tun_fd = open("/dev/null", O_RDWR);
+
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    options.config_path = config_path;
+    options.log_file_path = NULL;
+    options.binaries[0] = "/nonexistent/sing-box"; // Falls through to the next candidate
+    options.binaries[1] = binary_path;
+    options.start_grace_ms = 100;
+    options.stop_timeout_ms = 2000;
+    options.stats_interval_ms = 50;
+    CHECK(singbox_core_init(&options));
+    CHECK(singbox_core_init(&options)); // Idempotent
+}
+
+static void teardown(void) {
+    singbox_core_cleanup();
+    CHECK(!singbox_core_is_initialized());
+    close(tun_fd);
+    unlink(binary_path);
+    rmdir(work_dir);
+}
+
+static void test_start_stop(void) {
+    char json[2560];
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    CHECK_EQ_INT(singbox_core_format_stats(json, sizeof(json)), -1);
+
+    CHECK(singbox_core_start("{\"log\":{}}", tun_fd));
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_RUNNING);
+    CHECK(singbox_core_is_running());
+    CHECK(singbox_core_start("{\"log\":{}}", tun_fd)); // Already running
+    CHECK(singbox_core_format_stats(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"upload_bytes\"") != NULL);
+    CHECK(singbox_core_format_detailed_stats(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"logBuffer\"") != NULL);
+    CHECK_EQ_INT(singbox_core_format_stats(json, 16), -1);
+    // The test descriptor is no TUN device, so no per-app accounting
+    CHECK(singbox_core_format_app_usage(json, sizeof(json)) > 0);
+    CHECK(strcmp(json, "{\"source\":null,\"apps\":[]}") == 0);
+    CHECK_EQ_INT(singbox_core_format_app_usage(json, 8), -1);
+    CHECK(singbox_core_update_config("{\"log\":{\"level\":\"debug\"}}"));
+    CHECK(singbox_core_reset_stats());
+
+    CHECK(singbox_core_stop());
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    CHECK(!singbox_core_is_running());
+    CHECK_EQ_INT(singbox_core_format_detailed_stats(json, sizeof(json)), -1);
+    CHECK(!singbox_core_update_config("{}"));
+    CHECK(singbox_core_stop()); // Already stopped
+
+    // The fake's output went through the parser into the log buffer
+    char* logs = singbox_query_logs_json("fake sing-box up", 0, 0);
+    CHECK(logs && strstr(logs, "\"total\":1") != NULL);
+    free(logs);
+}
+
+static void test_rejects_bad_arguments(void) {
+    CHECK(!singbox_core_start(NULL, tun_fd));
+    CHECK(!singbox_core_start("", tun_fd));
+    CHECK(!singbox_core_start("{}", -1));
+    CHECK(!singbox_core_start("{\"log\":", tun_fd));
+    CHECK(!singbox_core_start_buffer("{\"a\":\"\xED\xA0\xBD\"}", 10, tun_fd)); // Surrogate
+    CHECK(!singbox_core_start_buffer(NULL, 2, tun_fd));
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+}
+
+static void test_buffer_config_is_written_as_given(void) {
+    // Not NUL terminated: only `length` bytes belong to the config
+    const char buffer[] = "{\"log\":{\"level\":\"warn\"}}GARBAGE";
+    size_t length = sizeof(buffer) - 1 - strlen("GARBAGE");
+    CHECK(singbox_core_start_buffer(buffer, length, tun_fd));
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_RUNNING);
+
+    char written[128] = {0};
+    FILE* file = fopen(config_path, "r");
+    CHECK(file != NULL);
+    if (file) {
+        CHECK_EQ_INT(fread(written, 1, sizeof(written) - 1, file), length);
+        fclose(file);
+    }
+    CHECK(memcmp(written, buffer, length) == 0);
+
+    // Updates replace the file; invalid ones leave it alone
+    const char update[] = "{\"log\":{\"level\":\"debug\"}}";
+    CHECK(singbox_core_update_config_buffer(update, sizeof(update) - 1));
+    CHECK(!singbox_core_update_config_buffer("{\"log\"", 6));
+    CHECK(!singbox_core_update_config("[]"));
+    file = fopen(config_path, "r");
+    if (file) {
+        memset(written, 0, sizeof(written));
+        CHECK_EQ_INT(fread(written, 1, sizeof(written) - 1, file), sizeof(update) - 1);
+        fclose(file);
+    }
+    CHECK(strcmp(written, update) == 0);
+
+    CHECK(singbox_core_stop());
+}
+
+static void test_process_exit_is_noticed(void) {
+    CHECK(singbox_core_start("{\"exit-soon\":true}", tun_fd));
+    uint64_t deadline = test_now_ns() + 3000000000ull;
+    while (singbox_core_is_running() && test_now_ns() < deadline) {
+        usleep(10000);
+    }
+    CHECK(!singbox_core_is_running());
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    // And it can be started again
+    CHECK(singbox_core_start("{}", tun_fd));
+    CHECK(singbox_core_stop());
+}
+
+typedef struct {
+    volatile int stop;
+    uint64_t calls;
+    uint64_t seen_running;
+    uint64_t done_while_stopping;
+} reader_t;
+
+static void* stats_reader(void* arg) {
+    reader_t* reader = (reader_t*)arg;
+    char json[512];
+    while (!reader->stop) {
+        // STOPPING is only visible while stop holds the lifecycle lock, so a
+        // call that starts and ends inside it did not wait for that lock
+        int stopping = singbox_core_state() == SINGBOX_CORE_STOPPING;
+        int length = singbox_core_format_stats(json, sizeof(json));
+        int running = singbox_core_is_running();
+        stopping = stopping && singbox_core_state() == SINGBOX_CORE_STOPPING;
+        reader->calls++;
+        reader->seen_running += length > 0 && running;
+        reader->done_while_stopping += stopping;
+    }
+    return NULL;
+}
+
+static void test_stats_region_is_published(void) {
+    const singbox_stats_shared_t* region = singbox_core_stats_region();
+    singbox_stats_values_t values;
+    CHECK(singbox_stats_shared_read(region, &values));
+    CHECK_EQ_INT(values.state, SINGBOX_CORE_STOPPED);
+
+    CHECK(singbox_core_start("{\"log\":{}}", tun_fd));
+    CHECK(singbox_stats_shared_read(region, &values));
+    CHECK_EQ_INT(values.state, SINGBOX_CORE_RUNNING);
+    CHECK(values.started_at_ms > 0);
+    uint64_t updates = values.updates;
+
+    // The publisher advances the counters without anyone asking for JSON
+    uint64_t deadline = test_now_ns() + 3000000000ull;
+    while (values.upload_bytes == 0 && test_now_ns() < deadline) {
+        usleep(20000);
+        CHECK(singbox_stats_shared_read(region, &values));
+    }
+    CHECK(values.upload_bytes > 0);
+    CHECK(values.download_speed > 0);
+    CHECK(values.updates > updates);
+    CHECK_EQ_INT(values.packets_sent, values.upload_bytes / 64);
+
+    CHECK(singbox_core_reset_stats());
+    CHECK(singbox_stats_shared_read(region, &values));
+    CHECK_EQ_INT(values.upload_bytes, 0);
+
+    CHECK(singbox_core_stop());
+    CHECK(singbox_stats_shared_read(region, &values));
+    CHECK_EQ_INT(values.state, SINGBOX_CORE_STOPPED);
+}
+
+static void test_process_stats_follow_the_child(void) {
+    char json[4096];
+    CHECK_EQ_INT(singbox_core_format_process_stats(json, sizeof(json)), -1);
+
+    CHECK(singbox_core_start("{\"log\":{}}", tun_fd));
+    int length = singbox_core_format_process_stats(json, sizeof(json));
+    CHECK(length > 0 && (size_t)length == strlen(json));
+    CHECK(strstr(json, "\"total_memory_mb\": ") != NULL);
+    CHECK(strstr(json, "\"open_file_descriptors\": ") != NULL);
+    CHECK(strstr(json, "\"process\": {\"pid\":") != NULL);
+    CHECK(json[length - 1] == '}' && json[length - 2] == '}');
+    CHECK_EQ_INT(singbox_core_format_process_stats(json, 64), -1);
+
+    // The publisher samples on each tick (50 ms here)
+    usleep(300000);
+    CHECK(singbox_core_format_process_history(json, sizeof(json)) > 0);
+    int points = 0;
+    for (const char* p = json; (p = strstr(p, "\"t\":")) != NULL; p++) {
+        points++;
+    }
+    CHECK(points >= 3);
+
+    CHECK(singbox_core_stop());
+    CHECK_EQ_INT(singbox_core_format_process_stats(json, sizeof(json)), -1);
+    CHECK_EQ_INT(singbox_core_format_process_history(json, sizeof(json)), -1);
+}
+
+static void test_readers_never_wait_for_lifecycle(void) {
+    reader_t readers[3];
+    pthread_t threads[3];
+    memset(readers, 0, sizeof(readers));
+    for (int i = 0; i < 3; i++) {
+        pthread_create(&threads[i], NULL, stats_reader, &readers[i]);
+    }
+
+    // Each stop blocks the lifecycle lock for ~300 ms, each start for 100 ms
+    for (int cycle = 0; cycle < 3; cycle++) {
+        CHECK(singbox_core_start("{}", tun_fd));
+        usleep(50000);
+        CHECK(singbox_core_stop());
+    }
+
+    for (int i = 0; i < 3; i++) {
+        readers[i].stop = 1;
+        pthread_join(threads[i], NULL);
+        CHECK(readers[i].calls > 100);
+        CHECK(readers[i].seen_running > 0);
+        // A reader blocked on the lock would finish only after STOPPED
+        CHECK(readers[i].done_while_stopping > 0);
+    }
+}
+
+int main(void) {
+    setup();
+    RUN_TEST(test_start_stop);
+    RUN_TEST(test_rejects_bad_arguments);
+    RUN_TEST(test_buffer_config_is_written_as_given);
+    RUN_TEST(test_process_exit_is_noticed);
+    RUN_TEST(test_stats_region_is_published);
+    RUN_TEST(test_process_stats_follow_the_child);
+    RUN_TEST(test_readers_never_wait_for_lifecycle);
+    teardown();
+    return TEST_EXIT();
+}
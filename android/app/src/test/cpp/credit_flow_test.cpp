@@ -0,0 +1,175 @@
+#include <deque>
+#include <vector>
+
+#include "CreditFlow.h"
+#include "test_util.h"
+
+/*
+ * Credit-based flow control of the Windows runner's "vpn_stats" event
+ * channel. Emitted events are recorded; acks stand in for the Dart
+ * listener's ackStats calls.
+ */
+
+using Flow = CreditFlow<int>;
+
+struct Event {
+    int sample;
+    uint64_t skipped;
+};
+
+static Flow make_flow(std::vector<Event>* events, uint32_t window, Flow::Policy policy) {
+    return Flow([events](const int& sample, uint64_t skipped) { events->push_back(Event{sample, skipped}); },
+                window, policy);
+}
+
+static void test_coalesce_keeps_newest(void) {
+    std::vector<Event> events;
+    Flow flow = make_flow(&events, 3, Flow::Policy::Coalesce);
+    for (int i = 0; i < 10; i++) {
+        flow.Offer(i);
+    }
+    // The window goes out, the rest collapse into one held sample
+    CHECK_EQ_INT(events.size(), 3);
+    Flow::Stats stats = flow.GetStats();
+    CHECK_EQ_INT(stats.in_flight, 3);
+    CHECK_EQ_INT(stats.credits, 0);
+    CHECK(stats.held);
+    CHECK_EQ_INT(stats.coalesced, 6);
+
+    // A returned credit sends the newest sample at once
+    flow.Ack(1);
+    CHECK_EQ_INT(events.size(), 4);
+    CHECK_EQ_INT(events[3].sample, 9);
+    CHECK_EQ_INT(events[3].skipped, 6);
+    stats = flow.GetStats();
+    CHECK(!stats.held);
+    CHECK_EQ_INT(stats.in_flight, 3);
+
+    flow.Ack(3);
+    CHECK_EQ_INT(events.size(), 4);
+    flow.Offer(10);
+    CHECK_EQ_INT(events.back().sample, 10);
+    CHECK_EQ_INT(events.back().skipped, 0);
+    stats = flow.GetStats();
+    CHECK_EQ_INT(stats.offered, stats.sent + stats.coalesced + stats.dropped);
+}
+
+static void test_drop_skips_until_ack(void) {
+    std::vector<Event> events;
+    Flow flow = make_flow(&events, 2, Flow::Policy::Drop);
+    for (int i = 0; i < 5; i++) {
+        flow.Offer(i);
+    }
+    CHECK_EQ_INT(events.size(), 2);
+    CHECK_EQ_INT(flow.GetStats().dropped, 3);
+    CHECK(!flow.GetStats().held);
+
+    // Nothing is waiting, so an ack alone sends nothing
+    flow.Ack(2);
+    CHECK_EQ_INT(events.size(), 2);
+    flow.Offer(5);
+    CHECK_EQ_INT(events.size(), 3);
+    CHECK_EQ_INT(events[2].sample, 5);
+    CHECK_EQ_INT(events[2].skipped, 3);
+}
+
+static void test_acks_and_windows_are_bounded(void) {
+    std::vector<Event> events;
+    Flow flow = make_flow(&events, 2, Flow::Policy::Coalesce);
+    flow.Offer(0);
+    // Only the one event in flight can be acknowledged
+    flow.Ack(5);
+    Flow::Stats stats = flow.GetStats();
+    CHECK_EQ_INT(stats.acked, 1);
+    CHECK_EQ_INT(stats.credits, 2);
+
+    flow.Reset(0, Flow::Policy::Drop);
+    CHECK_EQ_INT(flow.GetStats().window, 1);
+    CHECK(flow.policy() == Flow::Policy::Drop);
+    flow.Reset(1000, Flow::Policy::Coalesce);
+    CHECK_EQ_INT(flow.GetStats().window, Flow::kMaxWindow);
+    // A new listener starts with full credits; counters carry on
+    CHECK_EQ_INT(flow.GetStats().credits, Flow::kMaxWindow);
+    CHECK_EQ_INT(flow.GetStats().sent, 1);
+}
+
+/**
+ * A sample every millisecond against a listener that needs 25 ms per event,
+ * in virtual time. The backlog must stay within the window under both
+ * policies; with coalescing every event is the newest sample at the time
+ * it is sent.
+ */
+static void run_slow_listener(Flow::Policy policy) {
+    const int kDurationMs = 2000;
+    const int kHandleMs = 25;
+    const uint32_t kWindow = 4;
+    std::vector<Event> events;
+    Flow flow = make_flow(&events, kWindow, policy);
+
+    std::deque<size_t> inbox;   // Events the listener has yet to handle
+    size_t received = 0;
+    int busy_until = 0;
+    int newest = -1;
+    int stale = 0;
+    uint32_t max_depth = 0;
+    for (int now = 0; now < kDurationMs; now++) {
+        flow.Offer(now);
+        newest = now;
+        while (received < events.size()) {
+            stale += events[received].sample != newest;
+            inbox.push_back(received++);
+        }
+        if (!inbox.empty() && now >= busy_until) {
+            inbox.pop_front();
+            busy_until = now + kHandleMs;
+            flow.Ack(1);
+            while (received < events.size()) {
+                stale += events[received].sample != newest;
+                inbox.push_back(received++);
+            }
+        }
+        Flow::Stats stats = flow.GetStats();
+        uint32_t depth = stats.in_flight + (stats.held ? 1 : 0);
+        max_depth = depth > max_depth ? depth : max_depth;
+        CHECK(inbox.size() <= kWindow);
+    }
+
+    Flow::Stats stats = flow.GetStats();
+    CHECK_EQ_INT(stats.offered, kDurationMs);
+    CHECK_EQ_INT(stats.offered, stats.sent + stats.coalesced + stats.dropped + (stats.held ? 1 : 0));
+    CHECK(max_depth <= kWindow + 1);
+    // Roughly one event per handling slot, not one per sample
+    CHECK(stats.sent <= (uint64_t)(kDurationMs / kHandleMs) + kWindow + 1);
+    CHECK(stats.sent >= (uint64_t)(kDurationMs / kHandleMs) - 1);
+    uint64_t skipped = 0;
+    for (const auto& event : events) {
+        skipped += event.skipped;
+    }
+    // Every sample not sent is reported as skipped by the next event, bar the
+    // ones after the last event
+    CHECK(skipped + stats.sent <= stats.offered);
+    CHECK(skipped + stats.sent + (uint64_t)(kDurationMs - 1 - events.back().sample) >= stats.offered);
+    if (policy == Flow::Policy::Coalesce) {
+        CHECK_EQ_INT(stale, 0);
+        CHECK_EQ_INT(stats.dropped, 0);
+    } else {
+        CHECK_EQ_INT(stats.coalesced, 0);
+    }
+    printf("    %s: %llu samples -> %llu events, %llu coalesced, %llu dropped, max depth %u\n",
+           policy == Flow::Policy::Coalesce ? "coalesce" : "drop",
+           (unsigned long long)stats.offered, (unsigned long long)stats.sent,
+           (unsigned long long)stats.coalesced, (unsigned long long)stats.dropped, max_depth);
+}
+
+static void test_slow_listener(void) {
+    run_slow_listener(Flow::Policy::Coalesce);
+    run_slow_listener(Flow::Policy::Drop);
+}
+
+int main(void) {
+    RUN_TEST(test_coalesce_keeps_newest);
+    RUN_TEST(test_drop_skips_until_ack);
+    RUN_TEST(test_acks_and_windows_are_bounded);
+    RUN_TEST(test_slow_listener);
+    return TEST_EXIT();
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_errcat.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+/*
+ * Single-pass automaton versus the per-signature substring search it replaces
+ * (one case-insensitive scan per signature, as the Dart mapper does).
+ * Usage: errcat_bench [--quick] [lines]
+ */
+
+static const char* sample_lines[] = {
+    "ERROR [3145278282 3s] connection: open connection to api.example.com:443 using outbound/vless[proxy]: "
+    "dial tcp 1.2.3.4:443: i/o timeout",
+    "ERROR [3145278283 1s] outbound/vmess[proxy]: read tcp 10.0.0.2:50412->1.2.3.4:443: connection reset by peer",
+    "FATAL[0000] start service: start inbound/tun[tun-in]: configure tun interface: operation not permitted",
+    "ERROR [3145278284 0ms] dns: exchange failed for www.example.com. IN AAAA: lookup www.example.com: no such host",
+    "ERROR [3145278285 5s] outbound/trojan[proxy]: tls handshake: x509: certificate signed by unknown authority",
+    "FATAL[0000] decode config at ./config.json: outbounds[1].uuid: json: cannot unmarshal number into string",
+    "ERROR [3145278286 2s] inbound/mixed[mixed-in]: process connection from 127.0.0.1:52011: EOF",
+    "WARN [3145278287 0ms] router: rule-set geosite-cn not ready, waiting for download",
+};
+
+typedef struct {
+    uint64_t elapsed;
+    uint64_t matched;
+    uint64_t checksum;
+} run_result_t;
+
+static run_result_t run_automaton(const char** lines, const size_t* lengths, size_t count) {
+    const singbox_errcat_t* cat = singbox_errcat_default();
+    run_result_t run = {0, 0, 0};
+    uint64_t start = test_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        singbox_error_class_t result;
+        run.matched += (uint64_t)singbox_errcat_classify(cat, lines[i], lengths[i], &result);
+        run.checksum += (uint64_t)(result.signature + 1);
+    }
+    run.elapsed = test_now_ns() - start;
+    return run;
+}
+
+static run_result_t run_naive(const char** lines, const size_t* lengths, size_t count) {
+    size_t signature_count;
+    const singbox_error_signature_t* table = singbox_errcat_builtin_signatures(&signature_count);
+    size_t* pattern_lengths = malloc(signature_count * sizeof(size_t));
+    for (size_t s = 0; s < signature_count; s++) {
+        pattern_lengths[s] = strlen(table[s].pattern);
+    }
+
+    run_result_t run = {0, 0, 0};
+    uint64_t start = test_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        int best = -1;
+        for (size_t s = 0; s < signature_count; s++) {
+            if (!singbox_memmem_ci(lines[i], lengths[i], table[s].pattern, pattern_lengths[s])) {
+                continue;
+            }
+            if (best < 0 || table[s].priority > table[best].priority ||
+                (table[s].priority == table[best].priority && pattern_lengths[s] > pattern_lengths[best])) {
+                best = (int)s;
+            }
+        }
+        run.matched += best >= 0;
+        run.checksum += (uint64_t)(best + 1);
+    }
+    run.elapsed = test_now_ns() - start;
+    free(pattern_lengths);
+    return run;
+}
+
+static void report(const char* name, run_result_t run, size_t count, size_t bytes) {
+    double seconds = (double)run.elapsed / 1e9;
+    printf("  %-10s %8.2f M lines/s  %7.0f MB/s  %6.0f ns/line  matched=%llu\n", name,
+           (double)count / seconds / 1e6, (double)bytes / seconds / (1024.0 * 1024.0),
+           (double)run.elapsed / (double)count, (unsigned long long)run.matched);
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t count = quick ? 100000 : 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            count = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    size_t variants = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    const char** lines = malloc(count * sizeof(char*));
+    size_t* lengths = malloc(count * sizeof(size_t));
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        lines[i] = sample_lines[i % variants];
+        lengths[i] = strlen(lines[i]);
+        bytes += lengths[i];
+    }
+
+    size_t signature_count;
+    singbox_errcat_builtin_signatures(&signature_count);
+    uint64_t build_start = test_now_ns();
+    singbox_errcat_t* fresh = singbox_errcat_build(singbox_errcat_builtin_signatures(NULL), signature_count);
+    uint64_t build_ns = test_now_ns() - build_start;
+    printf("error categorizer: %zu signatures, %zu states, built in %.1f us (simd: %s)\n",
+           signature_count, singbox_errcat_state_count(fresh), (double)build_ns / 1e3, singbox_simd_backend());
+    singbox_errcat_free(fresh);
+
+    run_result_t best_automaton = {UINT64_MAX, 0, 0};
+    run_result_t best_naive = {UINT64_MAX, 0, 0};
+    int rounds = quick ? 2 : 5;
+    for (int round = 0; round < rounds; round++) {
+        run_result_t run = run_automaton(lines, lengths, count);
+        if (run.elapsed < best_automaton.elapsed) {
+            best_automaton = run;
+        }
+        run = run_naive(lines, lengths, quick ? count / 10 : count);
+        if (run.elapsed < best_naive.elapsed) {
+            best_naive = run;
+        }
+    }
+
+    printf("%zu lines, %.1f MB\n", count, (double)bytes / (1024.0 * 1024.0));
+    report("automaton", best_automaton, count, bytes);
+    size_t naive_count = quick ? count / 10 : count;
+    report("naive", best_naive, naive_count, bytes / count * naive_count);
+    printf("  speedup: %.1fx\n", ((double)best_naive.elapsed / (double)naive_count) /
+                                 ((double)best_automaton.elapsed / (double)count));
+
+    // Both strategies must pick the same signature for every sample
+    run_result_t check_automaton = run_automaton(sample_lines, lengths, variants);
+    run_result_t check_naive = run_naive(sample_lines, lengths, variants);
+
+    free(lines);
+    free(lengths);
+    return check_automaton.checksum == check_naive.checksum ? 0 : 1;
+}
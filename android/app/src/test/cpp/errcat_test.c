@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_errcat.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+static singbox_error_class_t classify(const char* line) {
+    singbox_error_class_t result;
+    singbox_errcat_classify(singbox_errcat_default(), line, strlen(line), &result);
+    return result;
+}
+
+static void test_common_sing_box_errors(void) {
+    singbox_error_class_t result = classify(
+        "ERROR [3145278282 3s] connection: open connection to api.example.com:443 "
+        "using outbound/vless[proxy]: dial tcp 1.2.3.4:443: i/o timeout");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_TIMEOUT);
+    CHECK_EQ_INT(result.severity, SINGBOX_ERRSEV_WARNING);
+    CHECK(result.recoverable);
+    CHECK(result.matches >= 3); // connection, dial tcp, i/o timeout
+
+    result = classify("FATAL[0000] start service: start inbound/tun[tun-in]: "
+                      "configure tun interface: operation not permitted");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_PERMISSION);
+    CHECK_EQ_INT(result.severity, SINGBOX_ERRSEV_CRITICAL);
+    CHECK(!result.recoverable);
+
+    result = classify("FATAL[0000] start service: start inbound/tun[tun-in]: configure tun interface: "
+                      "device or resource busy");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_TUN);
+
+    result = classify("FATAL[0000] decode config at ./config.json: outbounds[0].server_port: "
+                      "json: cannot unmarshal string into Go value of type uint16");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_CONFIGURATION);
+    CHECK(result.recoverable);
+
+    result = classify("ERROR dns: exchange failed for example.com. IN A: lookup example.com: no such host");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_NETWORK);
+
+    result = classify("panic: runtime error: invalid memory address or nil pointer dereference");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_CRASH);
+    CHECK_EQ_INT(result.severity, SINGBOX_ERRSEV_CRITICAL);
+}
+
+static void test_specific_signature_overrides_generic(void) {
+    singbox_error_class_t result = classify("outbound/trojan[proxy]: tls handshake timeout");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_TIMEOUT);
+    CHECK(strcmp(singbox_errcat_pattern(singbox_errcat_default(), result.signature),
+                 "tls handshake timeout") == 0);
+
+    result = classify("outbound/trojan[proxy]: tls handshake: remote error: bad certificate");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_PROTOCOL);
+
+    result = classify("start service: initialize outbound[0]: unknown outbound type: foo");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_CONFIGURATION);
+}
+
+static void test_connection_lines_stay_recoverable(void) {
+    // The tun inbound handing over one connection is not a tun failure
+    singbox_error_class_t result = classify(
+        "ERROR [10 5s] inbound/tun[tun-in]: process connection from 172.19.0.1:50000: i/o timeout");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_TIMEOUT);
+    CHECK(result.recoverable);
+
+    // Nor is one connection a local firewall refused a privilege problem
+    result = classify("ERROR [11 0ms] connection: open connection to 10.0.0.1:445 using outbound/direct[direct]: "
+                      "dial tcp 10.0.0.1:445: connect: permission denied");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_NETWORK);
+    CHECK_EQ_INT(result.severity, SINGBOX_ERRSEV_WARNING);
+    CHECK(result.recoverable);
+
+    result = classify("ERROR [12 0ms] outbound/vless[proxy]: administrator prohibited");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_NETWORK);
+
+    // Without a connection, or while starting up, the same words still count
+    result = classify("FATAL[0000] start service: start outbound/wireguard[wg]: operation not permitted");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_PERMISSION);
+    CHECK(!result.recoverable);
+
+    result = classify("ERROR open /dev/net/tun: permission denied");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_PERMISSION);
+
+    // Only a traceback header is a crash, not any mention of a goroutine
+    result = classify("goroutine 1 [running]:");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_CRASH);
+    result = classify("WARN router: goroutine pool exhausted");
+    CHECK(result.category != SINGBOX_ERRCAT_CRASH);
+}
+
+static void test_case_insensitive_and_unknown(void) {
+    singbox_error_class_t result = classify("Connection Refused BY PEER");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_NETWORK);
+
+    result = classify("The system cannot find the file specified.");
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_UNKNOWN);
+    CHECK_EQ_INT(result.signature, -1);
+    CHECK_EQ_INT(result.matches, 0);
+    CHECK_EQ_INT(result.severity, SINGBOX_ERRSEV_ERROR);
+    CHECK(!result.recoverable);
+
+    CHECK(!singbox_errcat_classify(singbox_errcat_default(), "", 0, &result));
+    CHECK(!singbox_errcat_classify(singbox_errcat_default(), NULL, 10, &result));
+}
+
+static void test_overlapping_patterns(void) {
+    // Suffix outputs must be inherited through failure links
+    static const singbox_error_signature_t table[] = {
+        { "she", SINGBOX_ERRCAT_NETWORK, SINGBOX_ERRSEV_WARNING, 1, 10, SINGBOX_ERRSCOPE_ANY },
+        { "he", SINGBOX_ERRCAT_CRASH, SINGBOX_ERRSEV_CRITICAL, 0, 20, SINGBOX_ERRSCOPE_ANY },
+        { "hers", SINGBOX_ERRCAT_TUN, SINGBOX_ERRSEV_ERROR, 0, 5, SINGBOX_ERRSCOPE_ANY },
+        { "his", SINGBOX_ERRCAT_LIBRARY, SINGBOX_ERRSEV_ERROR, 0, 30, SINGBOX_ERRSCOPE_ANY },
+    };
+    singbox_errcat_t* cat = singbox_errcat_build(table, 4);
+    CHECK(cat != NULL);
+    if (!cat) {
+        return;
+    }
+
+    singbox_error_class_t result;
+    CHECK(singbox_errcat_classify(cat, "ushers", 6, &result));
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_CRASH); // "he" found inside "she"
+    CHECK_EQ_INT(result.matches, 2);                     // after "she"/"he" and "hers"
+
+    CHECK(singbox_errcat_classify(cat, "ahishers", 8, &result));
+    CHECK_EQ_INT(result.category, SINGBOX_ERRCAT_LIBRARY);
+
+    CHECK(!singbox_errcat_classify(cat, "hxsx", 4, &result));
+    singbox_errcat_free(cat);
+
+    static const singbox_error_signature_t upper[] = {
+        { "Timeout", SINGBOX_ERRCAT_TIMEOUT, SINGBOX_ERRSEV_WARNING, 1, 10, SINGBOX_ERRSCOPE_ANY },
+    };
+    CHECK(singbox_errcat_build(upper, 1) == NULL);
+}
+
+// Brute force reference: every signature searched separately
+static int reference_classify(const char* line) {
+    size_t count;
+    const singbox_error_signature_t* table = singbox_errcat_builtin_signatures(&count);
+    int connection = 0, startup = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (singbox_memmem_ci(line, strlen(line), table[i].pattern, strlen(table[i].pattern))) {
+            connection |= table[i].scope == SINGBOX_ERRSCOPE_CONNECTION;
+            startup |= table[i].scope == SINGBOX_ERRSCOPE_STARTUP;
+        }
+    }
+
+    int best = -1;
+    size_t best_length = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t length = strlen(table[i].pattern);
+        if (!singbox_memmem_ci(line, strlen(line), table[i].pattern, length)) {
+            continue;
+        }
+        if (connection && !startup && table[i].scope == SINGBOX_ERRSCOPE_GLOBAL) {
+            continue;
+        }
+        if (best < 0 || table[i].priority > table[best].priority ||
+            (table[i].priority == table[best].priority && length > best_length)) {
+            best = (int)i;
+            best_length = length;
+        }
+    }
+    return best;
+}
+
+static void test_matches_reference(void) {
+    static const char* lines[] = {
+        "ERROR [1 2s] connection: open connection to 8.8.8.8:53 using outbound/direct[direct]: "
+        "dial udp 8.8.8.8:53: connect: network is unreachable",
+        "ERROR [2 0ms] inbound/mixed[mixed-in]: process connection from 127.0.0.1:5000: EOF",
+        "ERROR [3 1s] outbound/vmess[proxy]: read: connection reset by peer",
+        "ERROR [4 1s] outbound/vless[proxy]: reality verification failed",
+        "FATAL[0000] start service: initialize cache-file: open cache.db: access is denied",
+        "FATAL[0000] start service: start inbound/mixed[mixed-in]: listen tcp 127.0.0.1:2080: "
+        "bind: address already in use",
+        "ERROR [5 4s] outbound/hysteria2[proxy]: authentication failed, status code: 404",
+        "WARN [6 0ms] dns: exchange failed for x.com.: context deadline exceeded",
+        "FATAL[0000] create service: load wintun.dll: The specified module could not be found.",
+        "ERROR [7 1s] outbound/trojan[proxy]: x509: certificate signed by unknown authority",
+        "ERROR [8 1s] outbound/vmess[proxy]: grpc: transport is closing",
+        "INFO [9 0ms] nothing interesting here at all",
+        "ERROR [10 5s] inbound/tun[tun-in]: process connection from 172.19.0.1:50000: i/o timeout",
+        "ERROR [11 0ms] outbound/direct[direct]: dial tcp 10.0.0.1:445: connect: permission denied",
+        "FATAL[0000] start service: start outbound/wireguard[wg]: operation not permitted",
+        "goroutine 7 [running]:",
+    };
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        singbox_error_class_t result = classify(lines[i]);
+        int expected = reference_classify(lines[i]);
+        if (result.signature != expected) {
+            fprintf(stderr, "mismatch for \"%s\": got %d, expected %d\n", lines[i], result.signature, expected);
+        }
+        CHECK_EQ_INT(result.signature, expected);
+    }
+}
+
+static void test_names(void) {
+    CHECK(strcmp(singbox_error_category_name(SINGBOX_ERRCAT_TUN), "tun") == 0);
+    CHECK(strcmp(singbox_error_category_code(SINGBOX_ERRCAT_NETWORK), "CONNECTION_FAILED") == 0);
+    CHECK(strcmp(singbox_error_category_code(SINGBOX_ERRCAT_TIMEOUT), "TIMEOUT") == 0);
+    CHECK(strcmp(singbox_error_category_code(99), "UNKNOWN") == 0);
+    CHECK(strcmp(singbox_error_severity_name(SINGBOX_ERRSEV_CRITICAL), "critical") == 0);
+    CHECK(singbox_errcat_state_count(singbox_errcat_default()) > 100);
+}
+
+int main(void) {
+    RUN_TEST(test_common_sing_box_errors);
+    RUN_TEST(test_specific_signature_overrides_generic);
+    RUN_TEST(test_connection_lines_stay_recoverable);
+    RUN_TEST(test_case_insensitive_and_unknown);
+    RUN_TEST(test_overlapping_patterns);
+    RUN_TEST(test_matches_reference);
+    RUN_TEST(test_names);
+    return TEST_EXIT();
+}
@@ -0,0 +1,146 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ErrorCategorizer.h"
+#include "sing_box_errcat.h"
+#include "test_util.h"
+
+/*
+ * The Windows runner's ErrorCategorizer against sing_box_errcat.c. Both
+ * build their table from sing_box_errcat_signatures.inc; these tests hold
+ * the two automatons and their classifications identical.
+ */
+
+static const singbox_error_signature_t* c_table(size_t* count) {
+    return singbox_errcat_builtin_signatures(count);
+}
+
+static void test_tables_identical(void) {
+    size_t count = 0;
+    const singbox_error_signature_t* table = c_table(&count);
+    const std::vector<ErrorSignature>& signatures = ErrorCategorizer::BuiltinSignatures();
+    CHECK_EQ_INT(signatures.size(), count);
+    for (size_t i = 0; i < count && i < signatures.size(); i++) {
+        const ErrorSignature& signature = signatures[i];
+        if (std::strcmp(signature.pattern, table[i].pattern) != 0) {
+            fprintf(stderr, "signature %zu: \"%s\" here, \"%s\" in sing_box_errcat.c\n", i, signature.pattern,
+                    table[i].pattern);
+        }
+        CHECK(std::strcmp(signature.pattern, table[i].pattern) == 0);
+        CHECK_EQ_INT(static_cast<int>(signature.category), table[i].category);
+        CHECK_EQ_INT(static_cast<int>(signature.severity), table[i].severity);
+        CHECK_EQ_INT(signature.recoverable, table[i].recoverable);
+        CHECK_EQ_INT(signature.priority, table[i].priority);
+        CHECK_EQ_INT(static_cast<int>(signature.scope), table[i].scope);
+    }
+}
+
+static void test_names_identical(void) {
+    for (int category = 0; category < SINGBOX_ERRCAT_COUNT; category++) {
+        ErrorCategory value = static_cast<ErrorCategory>(category);
+        CHECK(std::strcmp(ErrorCategorizer::CategoryName(value), singbox_error_category_name(category)) == 0);
+        CHECK(std::strcmp(ErrorCategorizer::CategoryCode(value), singbox_error_category_code(category)) == 0);
+    }
+    for (int severity = SINGBOX_ERRSEV_INFO; severity <= SINGBOX_ERRSEV_CRITICAL; severity++) {
+        CHECK(std::strcmp(ErrorCategorizer::SeverityName(static_cast<ErrorSeverity>(severity)),
+                          singbox_error_severity_name(severity)) == 0);
+    }
+}
+
+static void check_same(const std::string& line) {
+    singbox_error_class_t expected;
+    singbox_errcat_classify(singbox_errcat_default(), line.data(), line.size(), &expected);
+    ErrorClassification result = ErrorCategorizer::Default().Classify(line);
+    if (result.signature != expected.signature || result.matches != expected.matches) {
+        fprintf(stderr, "mismatch for \"%s\": signature %d/%d, matches %u/%u\n", line.c_str(), result.signature,
+                expected.signature, result.matches, expected.matches);
+    }
+    CHECK_EQ_INT(result.signature, expected.signature);
+    CHECK_EQ_INT(result.matches, expected.matches);
+    CHECK_EQ_INT(static_cast<int>(result.category), expected.category);
+    CHECK_EQ_INT(static_cast<int>(result.severity), expected.severity);
+    CHECK_EQ_INT(result.recoverable, expected.recoverable);
+}
+
+static void test_corpus_classified_identically(void) {
+    static const char* lines[] = {
+        "ERROR [3145278282 3s] connection: open connection to api.example.com:443 "
+        "using outbound/vless[proxy]: dial tcp 1.2.3.4:443: i/o timeout",
+        "FATAL[0000] start service: start inbound/tun[tun-in]: configure tun interface: operation not permitted",
+        "FATAL[0000] decode config at ./config.json: outbounds[0].server_port: "
+        "json: cannot unmarshal string into Go value of type uint16",
+        "ERROR dns: exchange failed for example.com. IN A: lookup example.com: no such host",
+        "panic: runtime error: invalid memory address or nil pointer dereference",
+        "outbound/trojan[proxy]: tls handshake timeout",
+        "outbound/trojan[proxy]: tls handshake: remote error: bad certificate",
+        "start service: initialize outbound[0]: unknown outbound type: foo",
+        "Connection Refused BY PEER",
+        "FATAL[0000] create service: load wintun.dll: The specified module could not be found.",
+        "ERROR [7 1s] outbound/trojan[proxy]: x509: certificate signed by unknown authority",
+        "wsarecv: An existing connection was forcibly closed by the remote host.",
+        "The system cannot find the file specified.",
+        "INFO [9 0ms] nothing interesting here at all",
+        "ERROR [10 5s] inbound/tun[tun-in]: process connection from 172.19.0.1:50000: i/o timeout",
+        "ERROR [11 0ms] outbound/direct[direct]: dial tcp 10.0.0.1:445: connect: permission denied",
+        "ERROR [12 0ms] outbound/direct[direct]: administrator policy blocked the request",
+        "FATAL[0000] start service: start outbound/wireguard[wg]: operation not permitted",
+        "goroutine 1 [running]:",
+        "",
+    };
+    for (const char* line : lines) {
+        check_same(line);
+    }
+
+    // Every signature alone, in upper case, inside a line and next to each
+    // of its neighbours, so a drifted entry cannot hide behind another
+    size_t count = 0;
+    const singbox_error_signature_t* table = c_table(&count);
+    for (size_t i = 0; i < count; i++) {
+        std::string pattern = table[i].pattern;
+        std::string upper = pattern;
+        for (char& c : upper) {
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+        }
+        check_same(pattern);
+        check_same(upper);
+        check_same("ERROR [1 2s] outbound/direct: " + pattern + ": retrying");
+        if (i + 1 < count) {
+            check_same(pattern + ": " + table[i + 1].pattern);
+            check_same(std::string(table[i + 1].pattern) + " " + pattern);
+        }
+        // A prefix of the pattern must not match where the C table does not
+        check_same(pattern.substr(0, pattern.size() - 1));
+    }
+}
+
+static void test_rejects_bad_tables(void) {
+    bool threw = false;
+    try {
+        ErrorCategorizer categorizer({{"Timeout", ErrorCategory::Timeout, ErrorSeverity::Warning, true, 10}});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        ErrorCategorizer categorizer(std::vector<ErrorSignature>{});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    CHECK_EQ_INT(ErrorCategorizer::Default().StateCount(), singbox_errcat_state_count(singbox_errcat_default()));
+}
+
+int main(void) {
+    RUN_TEST(test_tables_identical);
+    RUN_TEST(test_names_identical);
+    RUN_TEST(test_corpus_classified_identically);
+    RUN_TEST(test_rejects_bad_tables);
+    return TEST_EXIT();
+}
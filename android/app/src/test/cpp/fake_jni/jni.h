@@ -0,0 +1,53 @@
+#ifndef SING_BOX_FAKE_JNI_H
+#define SING_BOX_FAKE_JNI_H
+
+/*
+ * Host stand-in for <jni.h>: the subset of the JNI types and function
+ * tables the native layer calls, laid out by name rather than by the real
+ * table order. Tests fill the tables with recording implementations so the
+ * JNI glue runs without a JVM.
+ */
+
+#include <stdint.h>
+
+typedef uint8_t jboolean;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef double jdouble;
+typedef void* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef struct _jmethodID* jmethodID;
+
+#define JNI_TRUE 1
+#define JNI_FALSE 0
+#define JNI_OK 0
+#define JNI_ERR (-1)
+#define JNI_VERSION_1_6 0x00010006
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+struct JNINativeInterface;
+struct JNIInvokeInterface;
+typedef const struct JNINativeInterface* JNIEnv;
+typedef const struct JNIInvokeInterface* JavaVM;
+
+struct JNINativeInterface {
+    jclass (*FindClass)(JNIEnv*, const char*);
+    jobject (*NewGlobalRef)(JNIEnv*, jobject);
+    void (*DeleteGlobalRef)(JNIEnv*, jobject);
+    void (*DeleteLocalRef)(JNIEnv*, jobject);
+    jmethodID (*GetMethodID)(JNIEnv*, jclass, const char*, const char*);
+    void (*CallVoidMethod)(JNIEnv*, jobject, jmethodID, ...);
+    jboolean (*ExceptionCheck)(JNIEnv*);
+    void (*ExceptionDescribe)(JNIEnv*);
+    void (*ExceptionClear)(JNIEnv*);
+};
+
+struct JNIInvokeInterface {
+    jint (*GetEnv)(JavaVM*, void**, jint);
+    jint (*AttachCurrentThread)(JavaVM*, JNIEnv**, void*);
+    jint (*DetachCurrentThread)(JavaVM*);
+};
+
+#endif // SING_BOX_FAKE_JNI_H
@@ -0,0 +1,308 @@
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_ffi.h"
+#include "test_util.h"
+
+/*
+ * Cost of one stats snapshot as Dart sees it, without Flutter:
+ *  - "method channel": stats formatted as JSON (nativeGetStats), parsed into
+ *    a map on the platform side, encoded with the StandardMessageCodec wire
+ *    format, handed across threads and decoded into a fresh map;
+ *  - "ffi call": tunnelmax_core_read_stats through a looked-up pointer;
+ *  - "ffi region": the seqlock read Dart does on the shared region itself.
+ * The library is loaded with dlopen, as dart:ffi does.
+ * Usage: ffi_bench [--quick] [reads]
+ */
+
+#define MAX_FIELDS 16
+
+typedef struct {
+    char* key;
+    int is_double;
+    int64_t i;
+    double d;
+} field_t;
+
+// --- StandardMessageCodec wire format (the subset a stats map needs) ---
+
+enum { CODEC_INT64 = 4, CODEC_FLOAT64 = 6, CODEC_STRING = 7, CODEC_MAP = 13 };
+
+static size_t put_size(uint8_t* out, size_t at, uint32_t size) {
+    if (size < 254) {
+        out[at++] = (uint8_t)size;
+    } else if (size <= 0xffff) {
+        out[at++] = 254;
+        memcpy(out + at, &size, 2);
+        at += 2;
+    } else {
+        out[at++] = 255;
+        memcpy(out + at, &size, 4);
+        at += 4;
+    }
+    return at;
+}
+
+static size_t get_size(const uint8_t* in, size_t* at) {
+    uint8_t first = in[(*at)++];
+    uint32_t size = first;
+    if (first == 254) {
+        uint16_t small;
+        memcpy(&small, in + *at, 2);
+        *at += 2;
+        size = small;
+    } else if (first == 255) {
+        memcpy(&size, in + *at, 4);
+        *at += 4;
+    }
+    return size;
+}
+
+static size_t encode_map(uint8_t* out, const field_t* fields, int count) {
+    size_t at = 0;
+    out[at++] = CODEC_MAP;
+    at = put_size(out, at, (uint32_t)count);
+    for (int i = 0; i < count; i++) {
+        size_t length = strlen(fields[i].key);
+        out[at++] = CODEC_STRING;
+        at = put_size(out, at, (uint32_t)length);
+        memcpy(out + at, fields[i].key, length);
+        at += length;
+        if (fields[i].is_double) {
+            out[at++] = CODEC_FLOAT64;
+            while (at % 8) {
+                out[at++] = 0;
+            }
+            memcpy(out + at, &fields[i].d, 8);
+        } else {
+            out[at++] = CODEC_INT64;
+            memcpy(out + at, &fields[i].i, 8);
+        }
+        at += 8;
+    }
+    return at;
+}
+
+// Decodes into freshly allocated keys, as the Dart side builds a new map
+static int decode_map(const uint8_t* in, field_t* fields) {
+    size_t at = 1;
+    int count = (int)get_size(in, &at);
+    for (int i = 0; i < count && i < MAX_FIELDS; i++) {
+        at++;
+        size_t length = get_size(in, &at);
+        fields[i].key = malloc(length + 1);
+        memcpy(fields[i].key, in + at, length);
+        fields[i].key[length] = '\0';
+        at += length;
+        fields[i].is_double = in[at++] == CODEC_FLOAT64;
+        if (fields[i].is_double) {
+            at = (at + 7) & ~(size_t)7;
+            memcpy(&fields[i].d, in + at, 8);
+        } else {
+            memcpy(&fields[i].i, in + at, 8);
+        }
+        at += 8;
+    }
+    return count;
+}
+
+// Flat {"key": number, ...} objects, as singbox_core_format_stats writes them
+static int parse_json(const char* json, field_t* fields) {
+    int count = 0;
+    const char* p = json;
+    while (count < MAX_FIELDS && (p = strchr(p, '"')) != NULL) {
+        const char* end = strchr(++p, '"');
+        if (!end) {
+            break;
+        }
+        fields[count].key = strndup(p, (size_t)(end - p));
+        p = end + 2;
+        char* number_end;
+        fields[count].i = strtoll(p, &number_end, 10);
+        fields[count].is_double = *number_end == '.';
+        if (fields[count].is_double) {
+            fields[count].d = strtod(p, &number_end);
+        }
+        p = number_end;
+        count++;
+    }
+    return count;
+}
+
+static void free_fields(field_t* fields, int count) {
+    for (int i = 0; i < count; i++) {
+        free(fields[i].key);
+    }
+}
+
+// --- Method channel round trip ---
+
+typedef struct {
+    int32_t (*read_stats)(singbox_stats_values_t*);
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int requested;
+    int replied;
+    int stop;
+    uint8_t reply[512];
+} platform_t;
+
+// The platform thread answers getNetworkStats: JSON from native, a map, the codec
+static void* platform_thread(void* arg) {
+    platform_t* platform = (platform_t*)arg;
+    pthread_mutex_lock(&platform->mutex);
+    for (;;) {
+        while (!platform->requested && !platform->stop) {
+            pthread_cond_wait(&platform->cond, &platform->mutex);
+        }
+        if (platform->stop) {
+            break;
+        }
+        platform->requested = 0;
+        pthread_mutex_unlock(&platform->mutex);
+
+        singbox_stats_values_t values;
+        platform->read_stats(&values);
+        char json[512];
+        snprintf(json, sizeof(json),
+                 "{\"upload_bytes\": %lld,\"download_bytes\": %lld,\"upload_speed\": %.2f,"
+                 "\"download_speed\": %.2f,\"connection_time\": %lld,\"packets_sent\": %lld,"
+                 "\"packets_received\": %lld}",
+                 (long long)values.upload_bytes, (long long)values.download_bytes,
+                 values.upload_speed, values.download_speed, (long long)values.started_at_ms / 1000,
+                 (long long)values.packets_sent, (long long)values.packets_received);
+        field_t fields[MAX_FIELDS];
+        int count = parse_json(json, fields);
+        encode_map(platform->reply, fields, count);
+        free_fields(fields, count);
+
+        pthread_mutex_lock(&platform->mutex);
+        platform->replied = 1;
+        pthread_cond_broadcast(&platform->cond);
+    }
+    pthread_mutex_unlock(&platform->mutex);
+    return NULL;
+}
+
+static int64_t channel_read(platform_t* platform) {
+    pthread_mutex_lock(&platform->mutex);
+    platform->requested = 1;
+    platform->replied = 0;
+    pthread_cond_broadcast(&platform->cond);
+    while (!platform->replied) {
+        pthread_cond_wait(&platform->cond, &platform->mutex);
+    }
+    pthread_mutex_unlock(&platform->mutex);
+
+    field_t fields[MAX_FIELDS];
+    int count = decode_map(platform->reply, fields);
+    int64_t upload = 0;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(fields[i].key, "upload_bytes") == 0) {
+            upload = fields[i].i;
+        }
+    }
+    free_fields(fields, count);
+    return upload;
+}
+
+// --- FFI ---
+
+// What the Dart reader does with the region: copy the fields between two
+// reads of the sequence counter
+static int64_t region_read(const singbox_stats_shared_t* region, singbox_stats_values_t* values) {
+    for (;;) {
+        uint32_t before = __atomic_load_n(&region->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+        values->state = region->state;
+        values->upload_bytes = region->upload_bytes;
+        values->download_bytes = region->download_bytes;
+        values->packets_sent = region->packets_sent;
+        values->packets_received = region->packets_received;
+        values->upload_speed = region->upload_speed;
+        values->download_speed = region->download_speed;
+        values->started_at_ms = region->started_at_ms;
+        values->updated_at_ms = region->updated_at_ms;
+        values->updates = region->updates;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&region->seq, __ATOMIC_RELAXED) == before) {
+            return values->upload_bytes;
+        }
+    }
+}
+
+static void report(const char* name, uint64_t* samples, size_t count, uint64_t elapsed) {
+    printf("  %-15s %8zu reads  %8.0f reads/s  p50 %8.0f ns  p99 %8.0f ns  max %9.0f ns\n",
+           name, count, (double)count * 1e9 / (double)elapsed,
+           (double)test_percentile(samples, count, 50.0), (double)test_percentile(samples, count, 99.0),
+           (double)test_percentile(samples, count, 100.0));
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t reads = quick ? 20000 : 500000;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            reads = (size_t)atol(argv[i]);
+        }
+    }
+
+    void* handle = dlopen(TUNNELMAX_CORE_PATH, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    platform_t platform = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+    const singbox_stats_shared_t* (*stats_region)(void);
+    *(void**)&platform.read_stats = dlsym(handle, "tunnelmax_core_read_stats");
+    *(void**)&stats_region = dlsym(handle, "tunnelmax_core_stats_region");
+    if (!platform.read_stats || !stats_region) {
+        return 1;
+    }
+    const singbox_stats_shared_t* region = stats_region();
+
+    uint64_t* samples = malloc(reads * sizeof(uint64_t));
+    int64_t sink = 0;
+    printf("One stats snapshot, %zu reads per path:\n", reads);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, platform_thread, &platform);
+    uint64_t start = test_now_ns();
+    for (size_t i = 0; i < reads; i++) {
+        uint64_t t0 = test_now_ns();
+        sink += channel_read(&platform);
+        samples[i] = test_now_ns() - t0;
+    }
+    report("method channel", samples, reads, test_now_ns() - start);
+    pthread_mutex_lock(&platform.mutex);
+    platform.stop = 1;
+    pthread_cond_broadcast(&platform.cond);
+    pthread_mutex_unlock(&platform.mutex);
+    pthread_join(thread, NULL);
+
+    singbox_stats_values_t values;
+    start = test_now_ns();
+    for (size_t i = 0; i < reads; i++) {
+        uint64_t t0 = test_now_ns();
+        platform.read_stats(&values);
+        sink += values.upload_bytes;
+        samples[i] = test_now_ns() - t0;
+    }
+    report("ffi call", samples, reads, test_now_ns() - start);
+
+    start = test_now_ns();
+    for (size_t i = 0; i < reads; i++) {
+        uint64_t t0 = test_now_ns();
+        sink += region_read(region, &values);
+        samples[i] = test_now_ns() - t0;
+    }
+    report("ffi region", samples, reads, test_now_ns() - start);
+
+    free(samples);
+    dlclose(handle);
+    return sink == -1 ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sing_box_core.h"
+#include "sing_box_ffi.h"
+#include "test_util.h"
+
+/*
+ * libtunnelmax_core loaded the way dart:ffi loads it: dlopen and symbol
+ * lookups only, against a fake sing-box. The test is not linked with the
+ * core, so everything it sees comes through the exported ABI.
+ */
+
+static const char* fake_singbox =
+    "#!/bin/sh\n"
+    "trap 'exit 0' TERM\n"
+    "while :; do sleep 0.05; done\n";
+
+typedef struct {
+    void* handle;
+    uint32_t (*abi_version)(void);
+    int32_t (*init)(const char*, const char*);
+    int32_t (*init_desktop)(const char*, const char*, const char*);
+    int32_t (*start)(const char*, size_t, int32_t);
+    int32_t (*stop)(void);
+    int32_t (*update_config)(const char*, size_t);
+    int32_t (*validate_config)(const char*, size_t);
+    int32_t (*is_running)(void);
+    int32_t (*pid)(void);
+    void (*cleanup)(void);
+    int32_t (*state)(void);
+    const singbox_stats_shared_t* (*stats_region)(void);
+    int32_t (*read_stats)(singbox_stats_values_t*);
+    const singbox_logtail_t* (*log_tail)(uint64_t*);
+    int32_t (*format_detailed_stats)(char*, size_t);
+    int32_t (*format_process_stats)(char*, size_t);
+} core_api_t;
+
+static core_api_t api;
+static char work_dir[] = "/tmp/tunnelmax-ffi-XXXXXX";
+static char binary_path[128];
+
+#define LOOKUP(field, name) do { \
+    *(void**)&api.field = dlsym(api.handle, name); \
+    CHECK(api.field != NULL); \
+} while (0)
+
+static void test_exports_only_the_abi(void) {
+    api.handle = dlopen(TUNNELMAX_CORE_PATH, RTLD_NOW | RTLD_LOCAL);
+    CHECK(api.handle != NULL);
+    if (!api.handle) {
+        fprintf(stderr, "%s\n", dlerror());
+        exit(1);
+    }
+    LOOKUP(abi_version, "tunnelmax_core_abi_version");
+    LOOKUP(init, "tunnelmax_core_init");
+    LOOKUP(init_desktop, "tunnelmax_core_init_desktop");
+    LOOKUP(start, "tunnelmax_core_start");
+    LOOKUP(stop, "tunnelmax_core_stop");
+    LOOKUP(update_config, "tunnelmax_core_update_config");
+    LOOKUP(validate_config, "tunnelmax_core_validate_config");
+    LOOKUP(is_running, "tunnelmax_core_is_running");
+    LOOKUP(pid, "tunnelmax_core_pid");
+    LOOKUP(cleanup, "tunnelmax_core_cleanup");
+    LOOKUP(state, "tunnelmax_core_state");
+    LOOKUP(stats_region, "tunnelmax_core_stats_region");
+    LOOKUP(read_stats, "tunnelmax_core_read_stats");
+    LOOKUP(log_tail, "tunnelmax_core_log_tail");
+    LOOKUP(format_detailed_stats, "tunnelmax_core_format_detailed_stats");
+    LOOKUP(format_process_stats, "tunnelmax_core_format_process_stats");
+    CHECK_EQ_INT(api.abi_version(), TUNNELMAX_CORE_ABI_VERSION);
+
+    // The core's own API stays internal
+    CHECK(dlsym(api.handle, "singbox_core_start") == NULL);
+    CHECK(dlsym(api.handle, "singbox_logging_init") == NULL);
+}
+
+static void test_regions_before_start(void) {
+    const singbox_stats_shared_t* region = api.stats_region();
+    CHECK(region != NULL);
+    CHECK(region == api.stats_region());
+    CHECK_EQ_INT(region->magic, SINGBOX_STATS_MAGIC);
+    CHECK_EQ_INT(region->version, SINGBOX_STATS_VERSION);
+    CHECK_EQ_INT(region->size, SINGBOX_STATS_REGION_SIZE);
+    CHECK_EQ_INT(api.state(), SINGBOX_CORE_STOPPED);
+
+    uint64_t size = 0;
+    const singbox_logtail_t* tail = api.log_tail(&size);
+    CHECK(tail != NULL);
+    CHECK_EQ_INT(tail->magic, SINGBOX_LOGTAIL_MAGIC);
+    CHECK_EQ_INT(tail->capacity + SINGBOX_LOGTAIL_HEADER_SIZE, size);
+
+    char json[64];
+    CHECK_EQ_INT(api.format_detailed_stats(json, sizeof(json)), -1);
+    CHECK_EQ_INT(api.format_detailed_stats(NULL, 0), -1);
+    CHECK_EQ_INT(api.read_stats(NULL), 0);
+    CHECK_EQ_INT(api.start(NULL, 0, -1), 0);
+    CHECK_EQ_INT(api.is_running(), 0);
+    CHECK_EQ_INT(api.format_process_stats(json, sizeof(json)), -1);
+
+    const char valid[] = "{\"log\":{}}";
+    const char invalid[] = "{\"log\":";
+    CHECK_EQ_INT(api.validate_config(valid, sizeof(valid) - 1), 1);
+    CHECK_EQ_INT(api.validate_config(invalid, sizeof(invalid) - 1), 0);
+    CHECK_EQ_INT(api.validate_config(NULL, 0), 0);
+}
+
+static void test_lifecycle_through_regions(void) {
+    CHECK_EQ_INT(api.init(work_dir, binary_path), 1);
+    int tun_fd = open("/dev/null", O_RDWR);
+    const char config[] = "{\"log\":{}}";
+    CHECK_EQ_INT(api.start(config, sizeof(config) - 1, tun_fd), 1);
+    CHECK_EQ_INT(api.state(), SINGBOX_CORE_RUNNING);
+    CHECK_EQ_INT(api.is_running(), 1);
+    CHECK(api.pid() > 0);
+    CHECK_EQ_INT(api.update_config(config, sizeof(config) - 1), 1);
+
+    // The region reflects the lifecycle without a call into the library
+    const singbox_stats_shared_t* region = api.stats_region();
+    singbox_stats_values_t values;
+    CHECK_EQ_INT(api.read_stats(&values), 1);
+    CHECK_EQ_INT(values.state, SINGBOX_CORE_RUNNING);
+    CHECK(values.started_at_ms > 0);
+    CHECK_EQ_INT(__atomic_load_n(&region->state, __ATOMIC_ACQUIRE), SINGBOX_CORE_RUNNING);
+
+    char json[4096];
+    CHECK(api.format_detailed_stats(json, sizeof(json)) > 0);
+    CHECK_EQ_INT(api.format_detailed_stats(json, 8), -1);
+    CHECK(api.format_process_stats(json, sizeof(json)) > 0);
+
+    // Starting logged something for the tail ring's readers
+    uint64_t size = 0;
+    const singbox_logtail_t* tail = api.log_tail(&size);
+    CHECK(__atomic_load_n(&tail->records, __ATOMIC_ACQUIRE) > 0);
+
+    CHECK_EQ_INT(api.stop(), 1);
+    CHECK_EQ_INT(api.state(), SINGBOX_CORE_STOPPED);
+    CHECK_EQ_INT(api.pid(), 0);
+    CHECK_EQ_INT(api.read_stats(&values), 1);
+    CHECK_EQ_INT(values.state, SINGBOX_CORE_STOPPED);
+    api.cleanup();
+    close(tun_fd);
+}
+
+/**
+ * The desktop mode: sing-box opens the device itself, so start gets no
+ * descriptor and the named interface is counted once it exists. Until then
+ * the totals stay at zero rather than being simulated.
+ */
+static void test_desktop_start_without_descriptor(void) {
+    CHECK_EQ_INT(api.init(work_dir, binary_path), 1);
+    const char config[] = "{\"log\":{}}";
+    CHECK_EQ_INT(api.start(config, sizeof(config) - 1, -1), 0);
+    api.cleanup();
+
+    CHECK_EQ_INT(api.init_desktop(work_dir, binary_path, "tmx-absent0"), 1);
+    CHECK_EQ_INT(api.start(config, sizeof(config) - 1, -1), 1);
+    CHECK_EQ_INT(api.state(), SINGBOX_CORE_RUNNING);
+    usleep(1200 * 1000);
+    singbox_stats_values_t values;
+    CHECK_EQ_INT(api.read_stats(&values), 1);
+    CHECK_EQ_INT(values.upload_bytes, 0);
+    CHECK_EQ_INT(values.download_bytes, 0);
+    CHECK_EQ_INT(api.stop(), 1);
+    api.cleanup();
+}
+
+int main(void) {
+    if (!mkdtemp(work_dir)) {
+        return 1;
+    }
+    char path[160];
+    snprintf(binary_path, sizeof(binary_path), "%s/sing-box", work_dir);
+    FILE* script = fopen(binary_path, "w");
+    if (!script) {
+        return 1;
+    }
+    fputs(fake_singbox, script);
+    fclose(script);
+    chmod(binary_path, 0755);
+
+    RUN_TEST(test_exports_only_the_abi);
+    RUN_TEST(test_regions_before_start);
+    RUN_TEST(test_lifecycle_through_regions);
+    RUN_TEST(test_desktop_start_without_descriptor);
+
+    dlclose(api.handle);
+    unlink(binary_path);
+    snprintf(path, sizeof(path), "%s/singbox_config.json", work_dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/singbox_native.slog", work_dir);
+    unlink(path);
+    rmdir(work_dir);
+    return TEST_EXIT();
+}
@@ -0,0 +1,120 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "sing_box_libbox.h"
+
+/*
+ * Stand-in for a libbox build: implements the embedding ABI with a thread
+ * that logs a line and reports steadily growing counters until stopped.
+ * A config containing "fail" is rejected. Built a second time with
+ * LIBBOX_STUB_ABI set to check version negotiation.
+ */
+
+#ifndef LIBBOX_STUB_ABI
+#define LIBBOX_STUB_ABI SINGBOX_LIBBOX_ABI_VERSION
+#endif
+
+#define EXPORT __attribute__((visibility("default")))
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static pthread_t worker;
+static int running = 0;
+static int stopping = 0;
+static singbox_libbox_callbacks_t callbacks;
+static int tun = -1;
+
+static void emit_log(const char* line) {
+    if (callbacks.on_log) {
+        callbacks.on_log(callbacks.ctx, line, strlen(line));
+    }
+}
+
+static void* worker_thread(void* arg) {
+    (void)arg;
+    char line[128];
+    snprintf(line, sizeof(line), "INFO [1 0ms] router: libbox stub up on fd %d", tun);
+    emit_log(line);
+    
+    singbox_libbox_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    uint32_t interval = callbacks.stats_interval_ms ? callbacks.stats_interval_ms : 1000;
+    if (interval > 20) {
+        interval = 20; // Keep tests quick
+    }
+    
+    pthread_mutex_lock(&mutex);
+    while (!stopping) {
+        stats.upload_bytes += 1000;
+        stats.download_bytes += 3000;
+        stats.upload_speed = 1000;
+        stats.download_speed = 3000;
+        stats.packets_sent += 10;
+        stats.packets_received += 20;
+        pthread_mutex_unlock(&mutex);
+        if (callbacks.on_stats) {
+            callbacks.on_stats(callbacks.ctx, &stats);
+        }
+        if (stats.packets_sent == 30) {
+            emit_log("ERROR [1 2s] outbound/vless[proxy]: dial tcp 1.2.3.4:443: i/o timeout");
+        }
+        pthread_mutex_lock(&mutex);
+        
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)interval * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        if (!stopping) {
+            pthread_cond_timedwait(&cond, &mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+EXPORT int libbox_abi_version(void) {
+    return LIBBOX_STUB_ABI;
+}
+
+EXPORT const char* libbox_version(void) {
+    return "stub-1.0";
+}
+
+EXPORT int libbox_start(const char* config, size_t config_len, int tun_fd,
+                        const singbox_libbox_callbacks_t* cb, char* error, size_t error_size) {
+    if (memmem(config, config_len, "fail", 4)) {
+        snprintf(error, error_size, "stub: bad config");
+        return 1;
+    }
+    pthread_mutex_lock(&mutex);
+    if (running) {
+        pthread_mutex_unlock(&mutex);
+        snprintf(error, error_size, "stub: already running");
+        return 2;
+    }
+    callbacks = *cb;
+    tun = tun_fd;
+    stopping = 0;
+    running = pthread_create(&worker, NULL, worker_thread, NULL) == 0;
+    pthread_mutex_unlock(&mutex);
+    return running ? 0 : 3;
+}
+
+EXPORT int libbox_stop(void) {
+    pthread_mutex_lock(&mutex);
+    if (!running) {
+        pthread_mutex_unlock(&mutex);
+        return 0;
+    }
+    stopping = 1;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(worker, NULL);
+    running = 0;
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sing_box_core.h"
+#include "sing_box_libbox.h"
+#include "sing_box_logging.h"
+#include "test_util.h"
+
+/*
+ * Embedding through the libbox ABI, against the stub library: the loader
+ * on its own, then the core running sing-box in-process.
+ * Paths of the stub builds come from CMake.
+ */
+
+static void wait_ms(int ms) {
+    usleep((useconds_t)ms * 1000);
+}
+
+typedef struct {
+    int lines;
+    int stats;
+    int64_t last_upload;
+} counts_t;
+
+static void count_log(void* ctx, const char* line, size_t length) {
+    (void)line;
+    (void)length;
+    __atomic_add_fetch(&((counts_t*)ctx)->lines, 1, __ATOMIC_RELAXED);
+}
+
+static void count_stats(void* ctx, const singbox_libbox_stats_t* stats) {
+    counts_t* counts = ctx;
+    __atomic_store_n(&counts->last_upload, stats->upload_bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&counts->stats, 1, __ATOMIC_RELAXED);
+}
+
+static void test_loader(void) {
+    char error[256];
+    CHECK(singbox_libbox_open("/nonexistent/libbox.so", error, sizeof(error)) == NULL);
+    CHECK(strstr(error, "dlopen failed") != NULL);
+    CHECK(singbox_libbox_open(LIBBOX_STUB_OLD_ABI_PATH, error, sizeof(error)) == NULL);
+    CHECK(strstr(error, "ABI version") != NULL);
+    
+    singbox_libbox_t* lib = singbox_libbox_open(LIBBOX_STUB_PATH, error, sizeof(error));
+    CHECK(lib != NULL);
+    if (!lib) {
+        return;
+    }
+    CHECK(strcmp(singbox_libbox_version(lib), "stub-1.0") == 0);
+    
+    counts_t counts = { 0, 0, 0 };
+    singbox_libbox_callbacks_t callbacks = { &counts, count_log, count_stats, 10 };
+    CHECK(!singbox_libbox_start(lib, "{\"fail\":1}", 10, 5, &callbacks, error, sizeof(error)));
+    CHECK(strcmp(error, "stub: bad config") == 0);
+    
+    CHECK(singbox_libbox_start(lib, "{}", 2, 5, &callbacks, error, sizeof(error)));
+    for (int i = 0; i < 200 && __atomic_load_n(&counts.stats, __ATOMIC_RELAXED) < 3; i++) {
+        wait_ms(5);
+    }
+    CHECK(singbox_libbox_stop(lib));
+    int stats = __atomic_load_n(&counts.stats, __ATOMIC_RELAXED);
+    CHECK(stats >= 3);
+    CHECK(counts.lines >= 1);
+    CHECK_EQ_INT(counts.last_upload, (int64_t)stats * 1000);
+    wait_ms(30);
+    CHECK_EQ_INT(__atomic_load_n(&counts.stats, __ATOMIC_RELAXED), stats); // Silent after stop
+    singbox_libbox_close(lib);
+}
+
+static void test_core_embedded(void) {
+    char config_path[] = "/tmp/singbox-libbox-XXXXXX";
+    int config_fd = mkstemp(config_path);
+    CHECK(config_fd >= 0);
+    close(config_fd);
+    
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    options.config_path = config_path;
+    options.log_file_path = NULL;
+    options.binaries[0] = "/nonexistent/sing-box"; // Never spawned
+    options.binaries[1] = NULL;
+    options.embedded_library = LIBBOX_STUB_PATH;
+    options.stats_interval_ms = 50;
+    CHECK(singbox_core_init(&options));
+    
+    int tun_fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    CHECK(!singbox_core_start("{\"fail\":true}", tun_fd));
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    
+    uint64_t start = test_now_ns();
+    CHECK(singbox_core_start("{}", tun_fd));
+    uint64_t start_us = (test_now_ns() - start) / 1000;
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_RUNNING);
+    CHECK(singbox_core_is_running());
+    printf("  embedded start took %llu us\n", (unsigned long long)start_us);
+    
+    // Stats arrive through the callback, not the simulation
+    singbox_stats_values_t values;
+    memset(&values, 0, sizeof(values));
+    for (int i = 0; i < 200 && values.packets_sent < 30; i++) {
+        wait_ms(5);
+        singbox_stats_shared_read(singbox_core_stats_region(), &values);
+    }
+    CHECK(values.packets_sent >= 30);
+    CHECK_EQ_INT(values.upload_bytes, values.packets_sent * 100);
+    CHECK_EQ_INT(values.download_bytes, values.packets_received * 150);
+    CHECK(values.download_speed == 3000.0);
+    
+    char json[2560];
+    CHECK(singbox_core_format_stats(json, sizeof(json)) > 0);
+    
+    // Resetting counts from the library's current totals
+    CHECK(singbox_core_reset_stats());
+    singbox_stats_shared_read(singbox_core_stats_region(), &values);
+    CHECK(values.upload_bytes < 10000);
+    
+    // Log lines went through the parser and the error classifier
+    char* logs = singbox_query_logs_json("libbox stub up", 0, 0);
+    CHECK(logs && strstr(logs, "\"total\":1") != NULL);
+    free(logs);
+    CHECK(singbox_core_format_detailed_stats(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"errors\": 1") != NULL);
+    
+    // The publisher runs for the embedded core too: it samples this process
+    int points = 0;
+    for (int i = 0; i < 200 && points < 3; i++) {
+        wait_ms(10);
+        points = 0;
+        if (singbox_core_format_process_history(json, sizeof(json)) > 0) {
+            for (const char* p = json; (p = strstr(p, "\"t\":")) != NULL; p++) {
+                points++;
+            }
+        }
+    }
+    CHECK(points >= 3);
+    CHECK(singbox_core_format_process_stats(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"process\": {\"pid\":") != NULL);
+    
+    CHECK(singbox_core_stop());
+    CHECK_EQ_INT(singbox_core_format_process_history(json, sizeof(json)), -1);
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    CHECK(!singbox_core_is_running());
+    
+    // Restart reuses the loaded library
+    CHECK(singbox_core_start("{}", tun_fd));
+    CHECK(singbox_core_is_running());
+    singbox_core_cleanup();
+    CHECK_EQ_INT(singbox_core_state(), SINGBOX_CORE_STOPPED);
+    
+    close(tun_fd);
+    unlink(config_path);
+}
+
+int main(void) {
+    RUN_TEST(test_loader);
+    RUN_TEST(test_core_embedded);
+    return TEST_EXIT();
+}
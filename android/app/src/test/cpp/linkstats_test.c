@@ -0,0 +1,382 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if_tun.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sing_box_core.h"
+#include "sing_box_linkstats.h"
+#include "test_util.h"
+
+/*
+ * TUN counters against a real tun device inside a private network
+ * namespace: traffic routed out of the device counts as tx, packets written
+ * into it as rx, an unread queue overflows into tx_dropped. Skipped when
+ * the host does not allow user/network namespaces or has no /dev/net/tun.
+ */
+
+#define TUN_NAME "sbtest0"
+#define LOCAL_ADDR "10.77.0.1"
+#define PEER_ADDR "10.77.0.2"
+#define PAYLOAD_SIZE 100
+#define PACKET_SIZE (20 + 8 + PAYLOAD_SIZE)
+
+static int tun_fd = -1;
+static int ifindex = 0;
+static int sysfs_remounted = 0;
+
+static int write_file(const char* path, const char* text) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t n = write(fd, text, strlen(text));
+    close(fd);
+    return n == (ssize_t)strlen(text);
+}
+
+/**
+ * Move into new network and mount namespaces, through a user namespace when
+ * not root, and remount /sys so that it shows the new network namespace
+ */
+static int enter_netns(void) {
+    if (getuid() != 0 || unshare(CLONE_NEWNET | CLONE_NEWNS) != 0) {
+        uid_t uid = getuid();
+        gid_t gid = getgid();
+        if (unshare(CLONE_NEWUSER | CLONE_NEWNET | CLONE_NEWNS) != 0) {
+            return 0;
+        }
+        char map[32];
+        write_file("/proc/self/setgroups", "deny");
+        snprintf(map, sizeof(map), "0 %u 1", (unsigned)uid);
+        if (!write_file("/proc/self/uid_map", map)) {
+            return 0;
+        }
+        snprintf(map, sizeof(map), "0 %u 1", (unsigned)gid);
+        if (!write_file("/proc/self/gid_map", map)) {
+            return 0;
+        }
+    }
+    sysfs_remounted = mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0 &&
+                      mount("sysfs", "/sys", "sysfs", 0, NULL) == 0;
+    return 1;
+}
+
+static int set_address(int sock, unsigned long request, const char* address) {
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", TUN_NAME);
+    struct sockaddr_in* sin = (struct sockaddr_in*)&ifr.ifr_addr;
+    sin->sin_family = AF_INET;
+    inet_pton(AF_INET, address, &sin->sin_addr);
+    return ioctl(sock, request, &ifr) == 0;
+}
+
+/**
+ * Create TUN_NAME with LOCAL_ADDR/24 and bring it up
+ */
+static int create_tun(void) {
+    tun_fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC | O_NONBLOCK);
+    if (tun_fd < 0) {
+        return 0;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", TUN_NAME);
+    if (ioctl(tun_fd, TUNSETIFF, &ifr) != 0) {
+        return 0;
+    }
+    // No IPv6 autoconfiguration traffic to disturb the counts
+    write_file("/proc/sys/net/ipv6/conf/" TUN_NAME "/disable_ipv6", "1");
+    
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    int ok = sock >= 0 && set_address(sock, SIOCSIFADDR, LOCAL_ADDR) &&
+             set_address(sock, SIOCSIFNETMASK, "255.255.255.0");
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", TUN_NAME);
+    ok = ok && ioctl(sock, SIOCGIFFLAGS, &ifr) == 0;
+    ifr.ifr_flags |= IFF_UP;
+    ok = ok && ioctl(sock, SIOCSIFFLAGS, &ifr) == 0;
+    if (sock >= 0) {
+        close(sock);
+    }
+    return ok;
+}
+
+static void drain_tun(void) {
+    char packet[2048];
+    while (read(tun_fd, packet, sizeof(packet)) > 0) {
+    }
+}
+
+static uint16_t ip_checksum(const uint8_t* data, size_t length) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        sum += (uint32_t)(data[i] << 8 | data[i + 1]);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+/**
+ * Inject a UDP datagram from PEER_ADDR to LOCAL_ADDR:port as if it came
+ * out of the tunnel
+ */
+static int inject_udp(uint16_t port) {
+    uint8_t packet[PACKET_SIZE];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0x45;
+    packet[2] = PACKET_SIZE >> 8;
+    packet[3] = PACKET_SIZE & 0xff;
+    packet[8] = 64;                 // TTL
+    packet[9] = IPPROTO_UDP;
+    inet_pton(AF_INET, PEER_ADDR, packet + 12);
+    inet_pton(AF_INET, LOCAL_ADDR, packet + 16);
+    uint16_t checksum = ip_checksum(packet, 20);
+    packet[10] = (uint8_t)(checksum >> 8);
+    packet[11] = (uint8_t)checksum;
+    packet[20] = 0x30;              // Source port 12345
+    packet[21] = 0x39;
+    packet[22] = (uint8_t)(port >> 8);
+    packet[23] = (uint8_t)port;
+    packet[24] = (8 + PAYLOAD_SIZE) >> 8;
+    packet[25] = (8 + PAYLOAD_SIZE) & 0xff;
+    // UDP checksum 0: none
+    return write(tun_fd, packet, sizeof(packet)) == (ssize_t)sizeof(packet);
+}
+
+static int send_udp_to_peer(int count) {
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in peer = { .sin_family = AF_INET, .sin_port = htons(9) };
+    inet_pton(AF_INET, PEER_ADDR, &peer.sin_addr);
+    char payload[PAYLOAD_SIZE];
+    memset(payload, 'p', sizeof(payload));
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        if (sendto(sock, payload, sizeof(payload), 0, (struct sockaddr*)&peer, sizeof(peer)) ==
+            (ssize_t)sizeof(payload)) {
+            sent++;
+        }
+    }
+    close(sock);
+    return sent;
+}
+
+static void test_tun_ifindex(void) {
+    char name[IF_NAMESIZE];
+    CHECK_EQ_INT(singbox_linkstats_tun_ifindex(tun_fd, name, sizeof(name)), ifindex);
+    CHECK(strcmp(name, TUN_NAME) == 0);
+    
+    int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    CHECK_EQ_INT(singbox_linkstats_tun_ifindex(null_fd, NULL, 0), 0);
+    close(null_fd);
+    CHECK(singbox_linkstats_open(0, 0) == NULL);
+}
+
+static void test_counts_traffic_both_ways(void) {
+    singbox_linkstats_t* stats = singbox_linkstats_open(ifindex, 0);
+    CHECK(stats != NULL);
+    if (!stats) {
+        return;
+    }
+    CHECK_EQ_INT(singbox_linkstats_source(stats), SINGBOX_LINKSTATS_NETLINK);
+    CHECK(strcmp(singbox_linkstats_ifname(stats), TUN_NAME) == 0);
+    
+    singbox_link_counters_t before, after;
+    drain_tun();
+    CHECK(singbox_linkstats_read(stats, &before));
+    
+    // Upload: routed into the tunnel, read by "sing-box"
+    CHECK_EQ_INT(send_udp_to_peer(10), 10);
+    drain_tun();
+    CHECK(singbox_linkstats_read(stats, &after));
+    CHECK_EQ_INT(after.tx_packets - before.tx_packets, 10);
+    CHECK_EQ_INT(after.tx_bytes - before.tx_bytes, 10 * PACKET_SIZE);
+    CHECK_EQ_INT(after.rx_packets - before.rx_packets, 0);
+    
+    // Download: written into the tunnel, delivered to a local socket
+    int receiver = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(5555) };
+    inet_pton(AF_INET, LOCAL_ADDR, &local.sin_addr);
+    CHECK(bind(receiver, (struct sockaddr*)&local, sizeof(local)) == 0);
+    before = after;
+    for (int i = 0; i < 5; i++) {
+        CHECK(inject_udp(5555));
+    }
+    CHECK(singbox_linkstats_read(stats, &after));
+    CHECK_EQ_INT(after.rx_packets - before.rx_packets, 5);
+    CHECK_EQ_INT(after.rx_bytes - before.rx_bytes, 5 * PACKET_SIZE);
+    CHECK_EQ_INT(after.tx_packets - before.tx_packets, 0);
+    char buffer[PAYLOAD_SIZE + 1];
+    CHECK_EQ_INT(recv(receiver, buffer, sizeof(buffer), MSG_DONTWAIT), PAYLOAD_SIZE);
+    close(receiver);
+    
+    singbox_linkstats_close(stats);
+}
+
+static void test_unread_queue_drops(void) {
+    singbox_linkstats_t* stats = singbox_linkstats_open(ifindex, 0);
+    CHECK(stats != NULL);
+    if (!stats) {
+        return;
+    }
+    singbox_link_counters_t before, after;
+    drain_tun();
+    CHECK(singbox_linkstats_read(stats, &before));
+    
+    // Nobody reads: beyond the 500-packet queue the device drops
+    send_udp_to_peer(1000);
+    CHECK(singbox_linkstats_read(stats, &after));
+    CHECK(after.tx_dropped > before.tx_dropped);
+    CHECK(after.tx_packets - before.tx_packets <= 500);
+    CHECK_EQ_INT(after.rx_errors, 0);
+    drain_tun();
+    
+    singbox_linkstats_close(stats);
+}
+
+static void test_sysfs_fallback_agrees(void) {
+    if (!sysfs_remounted) {
+        printf("(sysfs could not be remounted for the namespace; fallback not checked)\n");
+        return;
+    }
+    singbox_linkstats_t* netlink = singbox_linkstats_open(ifindex, 0);
+    singbox_linkstats_t* sysfs = singbox_linkstats_open(ifindex, 1);
+    CHECK(netlink && sysfs);
+    if (!netlink || !sysfs) {
+        singbox_linkstats_close(netlink);
+        singbox_linkstats_close(sysfs);
+        return;
+    }
+    CHECK_EQ_INT(singbox_linkstats_source(sysfs), SINGBOX_LINKSTATS_SYSFS);
+    CHECK(strcmp(singbox_linkstats_source_name(SINGBOX_LINKSTATS_SYSFS), "sysfs") == 0);
+    
+    singbox_link_counters_t a, b;
+    CHECK(singbox_linkstats_read(netlink, &a));
+    CHECK(singbox_linkstats_read(sysfs, &b));
+    CHECK(memcmp(&a, &b, sizeof(a)) == 0);
+    CHECK(a.tx_packets > 0 && a.rx_packets > 0 && a.tx_dropped > 0);
+    
+    singbox_linkstats_close(netlink);
+    singbox_linkstats_close(sysfs);
+}
+
+static void test_core_counts_the_tunnel(void) {
+    char dir[] = "/tmp/singbox-linkstats-XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    char config_path[64], binary_path[64];
+    snprintf(config_path, sizeof(config_path), "%s/config.json", dir);
+    snprintf(binary_path, sizeof(binary_path), "%s/sing-box", dir);
+    FILE* script = fopen(binary_path, "w");
+    CHECK(script != NULL);
+    if (!script) {
+        return;
+    }
+    // A single process, so the tun descriptor is gone once it is stopped
+    fputs("#!/bin/sh\nexec sleep 60\n", script);
+    fclose(script);
+    chmod(binary_path, 0755);
+    
+    singbox_core_options_t options;
+    singbox_core_default_options(&options);
+    options.config_path = config_path;
+    options.log_file_path = NULL;
+    options.binaries[0] = binary_path;
+    options.binaries[1] = NULL;
+    options.start_grace_ms = 50;
+    options.stats_interval_ms = 50;
+    CHECK(singbox_core_init(&options));
+    
+    drain_tun();
+    send_udp_to_peer(3); // Before the start: not counted
+    drain_tun();
+    CHECK(singbox_core_start("{}", tun_fd));
+    CHECK_EQ_INT(send_udp_to_peer(10), 10);
+    drain_tun();
+    // Bound, so that no port-unreachable errors go back out through the tunnel
+    int receiver = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(9999) };
+    inet_pton(AF_INET, LOCAL_ADDR, &local.sin_addr);
+    CHECK(bind(receiver, (struct sockaddr*)&local, sizeof(local)) == 0);
+    for (int i = 0; i < 4; i++) {
+        CHECK(inject_udp(9999));
+    }
+    
+    // The publisher takes the totals from the interface once per second
+    singbox_stats_values_t values;
+    memset(&values, 0, sizeof(values));
+    uint64_t deadline = test_now_ns() + 3000000000ull;
+    while ((values.packets_sent != 10 || values.packets_received != 4) && test_now_ns() < deadline) {
+        usleep(50000);
+        singbox_stats_shared_read(singbox_core_stats_region(), &values);
+    }
+    CHECK_EQ_INT(values.packets_sent, 10);
+    CHECK_EQ_INT(values.upload_bytes, 10 * PACKET_SIZE);
+    CHECK_EQ_INT(values.packets_received, 4);
+    CHECK_EQ_INT(values.download_bytes, 4 * PACKET_SIZE);
+    
+    char json[3072];
+    CHECK(singbox_core_format_detailed_stats(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"tun\": {\"interface\": \"" TUN_NAME "\", \"source\": \"netlink\"") != NULL);
+    CHECK(strstr(json, "\"txPackets\": 10,") != NULL);
+    
+    CHECK(singbox_core_reset_stats());
+    singbox_stats_shared_read(singbox_core_stats_region(), &values);
+    CHECK_EQ_INT(values.packets_sent, 0);
+    
+    close(receiver);
+    CHECK(singbox_core_stop());
+    singbox_core_cleanup();
+    unlink(binary_path);
+    rmdir(dir);
+}
+
+static void test_interface_removal(void) {
+    singbox_linkstats_t* netlink = singbox_linkstats_open(ifindex, 0);
+    singbox_linkstats_t* sysfs = sysfs_remounted ? singbox_linkstats_open(ifindex, 1) : NULL;
+    CHECK(netlink != NULL);
+    CHECK(sysfs != NULL || !sysfs_remounted);
+    
+    // Closing the last descriptor of a non-persistent tun removes it
+    close(tun_fd);
+    tun_fd = -1;
+    singbox_link_counters_t counters;
+    if (netlink) {
+        CHECK_EQ_INT(singbox_linkstats_read(netlink, &counters), 0);
+    }
+    if (sysfs) {
+        CHECK_EQ_INT(singbox_linkstats_read(sysfs, &counters), 0);
+    }
+    CHECK(singbox_linkstats_open(ifindex, 0) == NULL);
+    
+    singbox_linkstats_close(netlink);
+    singbox_linkstats_close(sysfs);
+}
+
+int main(void) {
+    if (!enter_netns() || !create_tun()) {
+        printf("[SKIP] network namespace with a tun device unavailable: %s\n", strerror(errno));
+        return 0;
+    }
+    ifindex = (int)if_nametoindex(TUN_NAME);
+    
+    RUN_TEST(test_tun_ifindex);
+    RUN_TEST(test_counts_traffic_both_ways);
+    RUN_TEST(test_unread_queue_drops);
+    RUN_TEST(test_sysfs_fallback_agrees);
+    RUN_TEST(test_core_counts_the_tunnel);
+    RUN_TEST(test_interface_removal);
+    return TEST_EXIT();
+}
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "LogThrottle.h"
+#include "sing_box_logging.h"
+#include "sing_box_logthrottle.h"
+#include "test_util.h"
+
+/*
+ * The Windows runner's LogThrottle, through the scenarios of
+ * logthrottle_test.c, and against the C stage it mirrors on a replayed
+ * mix of bursts and rate-limited modules.
+ */
+
+struct Sink {
+    int count = 0;
+    int level = 0;
+    std::string module;
+    std::string last;
+    std::vector<std::string> all;
+
+    LogThrottle::EmitFn Emit() {
+        return [this](int emitted_level, const std::string& emitted_module, const std::string& message) {
+            count++;
+            level = emitted_level;
+            module = emitted_module;
+            last = message;
+            all.push_back(std::to_string(emitted_level) + " " + emitted_module + " " + message);
+        };
+    }
+};
+
+static LogThrottle::Config config_with(uint32_t duplicate_pass, uint32_t rate_per_sec, uint32_t rate_burst) {
+    LogThrottle::Config config;
+    config.duplicate_pass = duplicate_pass;
+    config.rate_per_sec = rate_per_sec;
+    config.rate_burst = rate_burst;
+    return config;
+}
+
+static void test_template_hash(void) {
+    const std::string a = "dial tcp 1.2.3.4:443: i/o timeout";
+    const std::string b = "dial tcp 10.20.30.40:8443: i/o timeout";
+    const std::string c = "dial udp 1.2.3.4:443: i/o timeout";
+    CHECK(LogThrottle::TemplateHash(4, "dns", a) == LogThrottle::TemplateHash(4, "dns", b));
+    CHECK(LogThrottle::TemplateHash(4, "dns", a) != LogThrottle::TemplateHash(4, "dns", c));
+    CHECK(LogThrottle::TemplateHash(4, "dns", a) != LogThrottle::TemplateHash(3, "dns", a));
+    CHECK(LogThrottle::TemplateHash(4, "dns", a) != LogThrottle::TemplateHash(4, "router", a));
+    CHECK(LogThrottle::TemplateHash(2, "", "connection 3f2a9c10 closed") ==
+          LogThrottle::TemplateHash(2, "", "connection 77aa01bf closed"));
+
+    // Same keys as the C stage
+    for (const std::string& message : {a, b, c, std::string("connection 3f2a9c10 closed"), std::string()}) {
+        CHECK(LogThrottle::TemplateHash(4, "dns", message) ==
+              singbox_log_template_hash(4, "dns", message.data(), message.size()));
+    }
+}
+
+static void test_format_duration(void) {
+    CHECK(LogThrottle::FormatDuration(850) == "850ms");
+    CHECK(LogThrottle::FormatDuration(12345) == "12.3s");
+    CHECK(LogThrottle::FormatDuration(125000) == "2m05s");
+}
+
+static void test_burst_collapses_into_summary(void) {
+    Sink sink;
+    LogThrottle throttle;
+
+    // A flapping network: the same error 300 times in 3 seconds
+    int passed = 0;
+    for (int i = 0; i < 300; i++) {
+        std::string message = "network change " + std::to_string(i) + ": reconnect failed: connection refused";
+        passed += throttle.Submit(1000 + i * 10, SINGBOX_LOG_ERROR, "network", message, sink.Emit());
+    }
+    CHECK_EQ_INT(passed, 1);
+    CHECK_EQ_INT(throttle.GetStats().collapsed, 299);
+    CHECK_EQ_INT(sink.count, 0);
+
+    // Still inside the burst window: nothing to report yet
+    throttle.Flush(5000, false, sink.Emit());
+    CHECK_EQ_INT(sink.count, 0);
+
+    // Quiet for longer than the window: one summary replaces the repeats
+    throttle.Flush(9000, false, sink.Emit());
+    CHECK_EQ_INT(sink.count, 1);
+    CHECK_EQ_INT(sink.level, SINGBOX_LOG_ERROR);
+    CHECK(sink.module == "network");
+    CHECK(sink.last == "network change 0: reconnect failed: connection refused (\xc3\x97" "300 over 3.0s)");
+    CHECK_EQ_INT(throttle.GetStats().summaries, 1);
+
+    // A new burst of the same template starts over
+    CHECK(throttle.Submit(10000, SINGBOX_LOG_ERROR, "network",
+                          "network change 301: reconnect failed: connection refused", sink.Emit()));
+}
+
+static void test_interleaved_templates(void) {
+    Sink sink;
+    LogThrottle throttle(config_with(2, 50, 200));
+
+    int passed_a = 0, passed_b = 0;
+    for (int i = 0; i < 50; i++) {
+        passed_a += throttle.Submit(i * 20, SINGBOX_LOG_WARN, "stats", "stats retry 3 failed: timeout", sink.Emit());
+        passed_b += throttle.Submit(i * 20 + 1, SINGBOX_LOG_WARN, "stats", "stats socket closed", sink.Emit());
+    }
+    CHECK_EQ_INT(passed_a, 2);
+    CHECK_EQ_INT(passed_b, 2);
+
+    // Restarting a stale burst summarises the previous one inline
+    CHECK(throttle.Submit(20000, SINGBOX_LOG_WARN, "stats", "stats retry 4 failed: timeout", sink.Emit()));
+    CHECK(sink.count >= 1);
+    throttle.Flush(20000, true, sink.Emit());
+    CHECK_EQ_INT(throttle.GetStats().collapsed, 96);
+}
+
+static void test_long_flood_reports_periodically(void) {
+    Sink sink;
+    LogThrottle throttle;
+
+    // One line every 100 ms for 130 s never leaves the burst window
+    for (int i = 0; i <= 1300; i++) {
+        throttle.Submit(i * 100, SINGBOX_LOG_ERROR, "dns", "exchange failed: no such host", sink.Emit());
+    }
+    CHECK_EQ_INT(sink.count, 2);  // at 60 s and 120 s
+    CHECK(sink.last.find("over 1m00s)") != std::string::npos);
+
+    throttle.Flush(130000, true, sink.Emit());
+    CHECK_EQ_INT(sink.count, 3);
+    CHECK_EQ_INT(throttle.GetStats().passed, 1);
+}
+
+static void test_module_rate_limit(void) {
+    Sink sink;
+    LogThrottle throttle(config_with(1, 10, 20));
+
+    // 100 distinct messages at once from a chatty module
+    static const char* words[] = {"alpha", "bravo", "charlie", "delta", "echo",
+                                  "foxtrot", "golf", "hotel", "india", "juliet"};
+    int passed = 0;
+    for (int i = 0; i < 100; i++) {
+        std::string message = std::string("route ") + words[i % 10] + " " + words[i / 10];
+        passed += throttle.Submit(0, SINGBOX_LOG_INFO, "router", message, sink.Emit());
+    }
+    CHECK_EQ_INT(passed, 20);
+    CHECK_EQ_INT(throttle.GetStats().rate_limited, 80);
+
+    // Other modules keep their own budget, FATAL is never rate limited
+    CHECK(throttle.Submit(0, SINGBOX_LOG_INFO, "dns", "lookup example.com", sink.Emit()));
+    CHECK(throttle.Submit(0, SINGBOX_LOG_FATAL, "router", "router crashed", sink.Emit()));
+
+    // The bucket refills at 10 tokens per second: five in 500 ms
+    int refilled = 0;
+    for (const char* word : {"kilo", "lima", "mike", "november", "oscar", "papa"}) {
+        refilled += throttle.Submit(500, SINGBOX_LOG_INFO, "router", std::string("route ") + word, sink.Emit());
+    }
+    CHECK_EQ_INT(refilled, 5);
+
+    throttle.Flush(2000, false, sink.Emit());
+    CHECK_EQ_INT(sink.level, SINGBOX_LOG_WARN);
+    CHECK(sink.module == "router");
+    CHECK(sink.last.compare(0, 14, "rate limited: ") == 0);
+    CHECK(throttle.GetStats().suppressed_bytes > 0);
+}
+
+static void test_eviction_under_template_churn(void) {
+    Sink sink;
+    LogThrottle throttle(config_with(1, 0, 200));
+
+    for (int i = 0; i < 2000; i++) {
+        // Letters only, so every message is its own template
+        std::string message = "template ";
+        message += static_cast<char>('a' + i % 26);
+        message += static_cast<char>('a' + (i / 26) % 26);
+        message += static_cast<char>('a' + i / 676);
+        CHECK(throttle.Submit(i, SINGBOX_LOG_WARN, "core", message, sink.Emit()));
+    }
+    CHECK(throttle.GetStats().evictions > 0);
+    CHECK_EQ_INT(throttle.GetStats().passed, 2000);
+}
+
+static void collect(int level, const char* module, const char* message, size_t length, void* ctx) {
+    static_cast<std::vector<std::string>*>(ctx)->push_back(std::to_string(level) + " " + module + " " +
+                                                           std::string(message, length));
+}
+
+static singbox_logthrottle_t c_throttle;
+
+static void test_matches_c_stage(void) {
+    // Bursts, restarts and drained buckets on a few templates and modules.
+    // The stages evict differently (C probes a hash window, C++ drops the
+    // oldest), so the mix stays well inside both and neither evicts. With
+    // ten duplicates passed per burst the buckets run dry too.
+    singbox_logthrottle_config_t c_config;
+    singbox_logthrottle_default_config(&c_config);
+    c_config.rate_per_sec = 20;
+    c_config.rate_burst = 30;
+    c_config.duplicate_pass = 10;
+    singbox_logthrottle_init(&c_throttle, &c_config);
+    LogThrottle throttle(config_with(10, 20, 30));
+
+    static const int levels[] = {SINGBOX_LOG_WARN, SINGBOX_LOG_ERROR, SINGBOX_LOG_FATAL};
+    static const char* modules[] = {"dns", "router", ""};
+    static const char* texts[] = {"exchange failed for host%u: i/o timeout",
+                                  "dial tcp 10.0.0.%u:443: connection refused"};
+    Sink sink;
+    std::vector<std::string> c_summaries;
+    uint32_t seed = 12345;
+    int64_t now = 0;
+    int mismatches = 0;
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t r = seed >> 8;
+        // Mostly dense traffic with the occasional quiet gap
+        now += r % 97 == 0 ? 6000 + r % 4000 : r % 7;
+        int level = levels[r % 3];
+        const char* module = modules[(r >> 4) % 3];
+        char message[128];
+        std::snprintf(message, sizeof(message), texts[(r >> 7) % 2], (r >> 10) % 300);
+        int expected = singbox_logthrottle_submit(&c_throttle, now, level, module, message, std::strlen(message),
+                                                  collect, &c_summaries);
+        bool passed = throttle.Submit(now, level, module, message, sink.Emit());
+        mismatches += passed != (expected != 0);
+    }
+    singbox_logthrottle_flush(&c_throttle, now + 60000, 1, collect, &c_summaries);
+    throttle.Flush(now + 60000, true, sink.Emit());
+    CHECK_EQ_INT(mismatches, 0);
+
+    const LogThrottle::Stats& stats = throttle.GetStats();
+    CHECK_EQ_INT(stats.submitted, c_throttle.stats.submitted);
+    CHECK_EQ_INT(stats.passed, c_throttle.stats.passed);
+    CHECK_EQ_INT(stats.collapsed, c_throttle.stats.collapsed);
+    CHECK_EQ_INT(stats.rate_limited, c_throttle.stats.rate_limited);
+    CHECK_EQ_INT(stats.suppressed_bytes, c_throttle.stats.suppressed_bytes);
+    CHECK_EQ_INT(stats.summaries, c_throttle.stats.summaries);
+    CHECK_EQ_INT(stats.evictions, 0);
+    CHECK_EQ_INT(c_throttle.stats.evictions, 0);
+    CHECK(stats.collapsed > 0 && stats.rate_limited > 0);
+
+    // Sweeps visit bursts in a different order; the summaries are the same
+    std::sort(sink.all.begin(), sink.all.end());
+    std::sort(c_summaries.begin(), c_summaries.end());
+    CHECK(sink.all == c_summaries);
+}
+
+int main(void) {
+    RUN_TEST(test_template_hash);
+    RUN_TEST(test_format_duration);
+    RUN_TEST(test_burst_collapses_into_summary);
+    RUN_TEST(test_interleaved_templates);
+    RUN_TEST(test_long_flood_reports_periodically);
+    RUN_TEST(test_module_rate_limit);
+    RUN_TEST(test_eviction_under_template_churn);
+    RUN_TEST(test_matches_c_stage);
+    return TEST_EXIT();
+}
@@ -0,0 +1,107 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sing_box_logfile.h"
+#include "test_util.h"
+
+/*
+ * Append throughput and per-line latency of the persistent log file.
+ * Usage: logfile_bench [--quick] [lines] [threads]
+ */
+
+typedef struct {
+    singbox_logfile_t* file;
+    size_t lines;
+    uint64_t* latencies;
+} worker_t;
+
+static const char* sample_lines[] = {
+    "outbound/vless[proxy]: outbound connection to www.google.com:443",
+    "inbound/tun[tun-in]: inbound packet connection from 172.19.0.1:53211",
+    "dns: exchanged A www.example.com. 300 IN A 93.184.216.34",
+    "router: found process path: /system/bin/netd",
+    "outbound/direct[direct]: outbound connection to 10.0.0.1:8080 failed: connection refused",
+};
+
+static void* worker_main(void* arg) {
+    worker_t* worker = (worker_t*)arg;
+    size_t variants = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    for (size_t i = 0; i < worker->lines; i++) {
+        const char* line = sample_lines[i % variants];
+        uint64_t start = test_now_ns();
+        singbox_logfile_append(worker->file, 2, "sing-box", line, strlen(line));
+        worker->latencies[i] = test_now_ns() - start;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t lines = quick ? 100000 : 2000000;
+    int threads = 1;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            continue;
+        }
+        if (positional == 0) {
+            lines = (size_t)strtoull(argv[i], NULL, 10);
+        } else if (positional == 1) {
+            threads = atoi(argv[i]);
+        }
+        positional++;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), "/tmp/sing_box_logfile_bench_%d.slog", (int)getpid());
+    unlink(path);
+    singbox_logfile_t* file = singbox_logfile_open(path, 0, 0);
+    if (!file) {
+        fprintf(stderr, "failed to open %s\n", path);
+        return 1;
+    }
+
+    worker_t* workers = calloc((size_t)threads, sizeof(*workers));
+    pthread_t* handles = calloc((size_t)threads, sizeof(*handles));
+    uint64_t* latencies = calloc(lines * (size_t)threads, sizeof(*latencies));
+
+    uint64_t start = test_now_ns();
+    for (int t = 0; t < threads; t++) {
+        workers[t].file = file;
+        workers[t].lines = lines;
+        workers[t].latencies = latencies + (size_t)t * lines;
+        pthread_create(&handles[t], NULL, worker_main, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(handles[t], NULL);
+    }
+    double seconds = (double)(test_now_ns() - start) / 1e9;
+
+    singbox_logfile_stats_t stats;
+    singbox_logfile_get_stats(file, &stats);
+    size_t total = lines * (size_t)threads;
+
+    printf("logfile append: %zu lines, %d thread(s), %.3f s\n", total, threads, seconds);
+    printf("  throughput: %.0f lines/s, %.1f MB/s\n",
+           (double)total / seconds, (double)stats.bytes_written / seconds / (1024.0 * 1024.0));
+    printf("  latency ns: p50=%llu p99=%llu p99.9=%llu max=%llu\n",
+           (unsigned long long)test_percentile(latencies, total, 50.0),
+           (unsigned long long)test_percentile(latencies, total, 99.0),
+           (unsigned long long)test_percentile(latencies, total, 99.9),
+           (unsigned long long)test_percentile(latencies, total, 100.0));
+    printf("  rotations: %llu, dropped: %llu\n",
+           (unsigned long long)stats.rotations, (unsigned long long)stats.records_dropped);
+
+    singbox_logfile_close(file);
+    unlink(path);
+    free(latencies);
+    free(handles);
+    free(workers);
+    return stats.records_written == total ? 0 : 1;
+}
@@ -0,0 +1,347 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sing_box_logfile.h"
+#include "test_util.h"
+
+#define SEGMENT_SIZE 4096
+#define SEGMENTS 4
+
+typedef struct {
+    uint64_t seqs[4096];
+    char last_message[128];
+    size_t count;
+} collected_t;
+
+static int collect(const singbox_log_view_t* record, void* ctx) {
+    collected_t* out = (collected_t*)ctx;
+    if (out->count < sizeof(out->seqs) / sizeof(out->seqs[0])) {
+        out->seqs[out->count] = record->seq;
+    }
+    out->count++;
+    snprintf(out->last_message, sizeof(out->last_message), "%.*s",
+             (int)record->message_len, record->message);
+    return 0;
+}
+
+static void temp_path(char* path, size_t size) {
+    snprintf(path, size, "/tmp/sing_box_logfile_test_%d.slog", (int)getpid());
+    unlink(path);
+}
+
+// Maps the file read-only, the way the offline decoder does
+static long decode_file(const char* path, collected_t* out, singbox_logfile_decode_stats_t* stats) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    long count = singbox_logfile_decode(data, (size_t)st.st_size, collect, out, stats);
+    munmap(data, (size_t)st.st_size);
+    return count;
+}
+
+static void append_line(singbox_logfile_t* file, int index) {
+    char message[64];
+    int length = snprintf(message, sizeof(message), "line %d", index);
+    CHECK(singbox_logfile_append(file, 2, "test", message, (size_t)length));
+}
+
+static void test_append_and_decode(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    CHECK(file != NULL);
+    for (int i = 0; i < 10; i++) {
+        append_line(file, i);
+    }
+    singbox_logfile_close(file);
+
+    collected_t out;
+    singbox_logfile_decode_stats_t stats;
+    CHECK_EQ_INT(decode_file(path, &out, &stats), 10);
+    CHECK_EQ_INT(stats.torn_records, 0);
+    CHECK_EQ_INT(out.seqs[0], 1);
+    CHECK_EQ_INT(out.seqs[9], 10);
+    CHECK(strcmp(out.last_message, "line 9") == 0);
+    unlink(path);
+}
+
+static void test_survives_crash(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    pid_t child = fork();
+    if (child == 0) {
+        singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+        for (int i = 0; i < 50; i++) {
+            append_line(file, i);
+        }
+        // No close, no msync: the kernel still holds the dirty shared pages
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status));
+
+    collected_t out;
+    singbox_logfile_decode_stats_t stats;
+    CHECK_EQ_INT(decode_file(path, &out, &stats), 50);
+    CHECK(strcmp(out.last_message, "line 49") == 0);
+    unlink(path);
+}
+
+static void test_rotation_bounds_size(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    for (int i = 0; i < 2000; i++) {
+        append_line(file, i);
+    }
+    singbox_logfile_stats_t writer;
+    singbox_logfile_get_stats(file, &writer);
+    CHECK(writer.rotations > SEGMENTS);
+    CHECK_EQ_INT(writer.records_written, 2000);
+    singbox_logfile_close(file);
+
+    struct stat st;
+    stat(path, &st);
+    CHECK_EQ_INT(st.st_size, SEGMENT_SIZE * SEGMENTS);
+
+    collected_t out;
+    long count = decode_file(path, &out, NULL);
+    CHECK(count > 0 && count < 2000);
+    // Only the newest records are retained, in order and without gaps
+    CHECK_EQ_INT(out.seqs[count - 1], 2000);
+    for (long i = 1; i < count; i++) {
+        CHECK_EQ_INT(out.seqs[i], out.seqs[i - 1] + 1);
+    }
+    CHECK(strcmp(out.last_message, "line 1999") == 0);
+    unlink(path);
+}
+
+static void test_torn_record_detected(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    for (int i = 0; i < 3; i++) {
+        append_line(file, i);
+    }
+    singbox_logfile_close(file);
+
+    // Flip a payload byte of the second record in the active segment (generation 1, index 1)
+    int fd = open(path, O_RDWR);
+    uint8_t* data = mmap(NULL, SEGMENT_SIZE * SEGMENTS, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    uint8_t* segment = data + SEGMENT_SIZE;
+    singbox_log_record_t* first = (singbox_log_record_t*)(segment + sizeof(singbox_logfile_segment_t));
+    uint8_t* second = (uint8_t*)first + first->size;
+    second[sizeof(singbox_log_record_t) + 1] ^= 0xFF;
+    munmap(data, SEGMENT_SIZE * SEGMENTS);
+
+    collected_t out;
+    singbox_logfile_decode_stats_t stats;
+    CHECK_EQ_INT(decode_file(path, &out, &stats), 2);
+    CHECK_EQ_INT(stats.torn_records, 1);
+    CHECK_EQ_INT(out.seqs[1], 3);
+    unlink(path);
+}
+
+static void test_unwritten_slot_skipped(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    for (int i = 0; i < 4; i++) {
+        append_line(file, i);
+    }
+    singbox_logfile_close(file);
+
+    // Wipe the second record as if its writer died right after reserving it
+    int fd = open(path, O_RDWR);
+    uint8_t* data = mmap(NULL, SEGMENT_SIZE * SEGMENTS, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    singbox_logfile_segment_t* header = (singbox_logfile_segment_t*)(data + SEGMENT_SIZE);
+    singbox_log_record_t* first = (singbox_log_record_t*)(header + 1);
+    singbox_log_record_t* second = (singbox_log_record_t*)((uint8_t*)first + first->size);
+    singbox_log_record_t* fourth = (singbox_log_record_t*)((uint8_t*)second + 2 * second->size);
+    memset(second, 0, second->size);
+
+    collected_t out;
+    singbox_logfile_decode_stats_t stats;
+    CHECK_EQ_INT(decode_file(path, &out, &stats), 3);
+    CHECK_EQ_INT(stats.torn_records, 1);
+    CHECK_EQ_INT(out.seqs[0], 1);
+    CHECK_EQ_INT(out.seqs[1], 3);
+    CHECK_EQ_INT(out.seqs[2], 4);
+
+    // Nothing reserved past a trailing empty slot: that is just the end
+    header->write_end = (uint32_t)((uint8_t*)fourth - (uint8_t*)header);
+    memset(fourth, 0, fourth->size);
+    CHECK_EQ_INT(decode_file(path, &out, &stats), 2);
+    CHECK_EQ_INT(stats.torn_records, 1);
+    munmap(data, SEGMENT_SIZE * SEGMENTS);
+    unlink(path);
+}
+
+/*
+ * A writer is held in the middle of its copy by reading its message from a
+ * page without access; the SIGSEGV handler parks it until released.
+ */
+static uint8_t* stall_page;
+static long stall_page_size;
+static atomic_int stall_state;  // 1 = parked, 2 = released
+
+static void stall_handler(int sig, siginfo_t* info, void* context) {
+    (void)sig;
+    (void)context;
+    uint8_t* address = (uint8_t*)info->si_addr;
+    if (address < stall_page || address >= stall_page + stall_page_size) {
+        abort();
+    }
+    atomic_store(&stall_state, 1);
+    while (atomic_load(&stall_state) != 2) {
+        sched_yield();
+    }
+    mprotect(stall_page, (size_t)stall_page_size, PROT_READ);
+}
+
+static void* stalled_writer(void* arg) {
+    singbox_logfile_append((singbox_logfile_t*)arg, 2, "test", (const char*)stall_page, 16);
+    return NULL;
+}
+
+static void* lapping_writer(void* arg) {
+    singbox_logfile_t* file = (singbox_logfile_t*)arg;
+    for (int i = 0; i < 1000; i++) {
+        append_line(file, i);
+    }
+    return NULL;
+}
+
+static void test_rotation_waits_for_writer(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    stall_page_size = sysconf(_SC_PAGESIZE);
+    stall_page = mmap(NULL, (size_t)stall_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    memset(stall_page, 'x', (size_t)stall_page_size);
+    mprotect(stall_page, (size_t)stall_page_size, PROT_NONE);
+    atomic_store(&stall_state, 0);
+    struct sigaction action, previous;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = stall_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &action, &previous);
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    singbox_logfile_stats_t writer;
+    singbox_logfile_get_stats(file, &writer);
+    uint64_t generation = writer.generation;
+
+    pthread_t stalled, lapping;
+    pthread_create(&stalled, NULL, stalled_writer, file);
+    while (atomic_load(&stall_state) != 1) {
+        sched_yield();
+    }
+
+    // Another writer fills the ring and comes back around to the pinned segment
+    pthread_create(&lapping, NULL, lapping_writer, file);
+    for (int i = 0; i < 1000; i++) {
+        singbox_logfile_get_stats(file, &writer);
+        if (writer.generation == generation + SEGMENTS - 1) {
+            break;
+        }
+        usleep(1000);
+    }
+    usleep(100000);
+    singbox_logfile_get_stats(file, &writer);
+    CHECK_EQ_INT(writer.generation, generation + SEGMENTS - 1);
+
+    atomic_store(&stall_state, 2);
+    pthread_join(stalled, NULL);
+    pthread_join(lapping, NULL);
+    sigaction(SIGSEGV, &previous, NULL);
+    munmap(stall_page, (size_t)stall_page_size);
+
+    singbox_logfile_get_stats(file, &writer);
+    CHECK_EQ_INT(writer.records_written, 1001);
+    CHECK(writer.generation > generation + SEGMENTS);
+    singbox_logfile_close(file);
+
+    // The late copy landed before the reset, so the lap left nothing torn
+    collected_t out;
+    singbox_logfile_decode_stats_t stats;
+    CHECK(decode_file(path, &out, &stats) > 0);
+    CHECK_EQ_INT(stats.torn_records, 0);
+    CHECK(strcmp(out.last_message, "line 999") == 0);
+    for (size_t i = 1; i < out.count; i++) {
+        CHECK_EQ_INT(out.seqs[i], out.seqs[i - 1] + 1);
+    }
+    unlink(path);
+}
+
+static void test_reopen_preserves_history(void) {
+    char path[128];
+    temp_path(path, sizeof(path));
+
+    singbox_logfile_t* file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    for (int i = 0; i < 5; i++) {
+        append_line(file, i);
+    }
+    singbox_logfile_close(file);
+
+    file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS);
+    append_line(file, 100);
+    singbox_logfile_close(file);
+
+    collected_t out;
+    CHECK_EQ_INT(decode_file(path, &out, NULL), 6);
+    CHECK_EQ_INT(out.seqs[5], 6);
+    CHECK(strcmp(out.last_message, "line 100") == 0);
+
+    // A different geometry starts over
+    file = singbox_logfile_open(path, SEGMENT_SIZE, SEGMENTS + 1);
+    singbox_logfile_close(file);
+    CHECK_EQ_INT(decode_file(path, &out, NULL), 0);
+    unlink(path);
+}
+
+static void test_rejects_foreign_data(void) {
+    uint8_t junk[8192];
+    memset(junk, 0xAB, sizeof(junk));
+    CHECK_EQ_INT(singbox_logfile_decode(junk, sizeof(junk), NULL, NULL, NULL), -1);
+    CHECK_EQ_INT(singbox_logfile_decode(NULL, 0, NULL, NULL, NULL), -1);
+}
+
+int main(void) {
+    RUN_TEST(test_append_and_decode);
+    RUN_TEST(test_survives_crash);
+    RUN_TEST(test_rotation_bounds_size);
+    RUN_TEST(test_torn_record_detected);
+    RUN_TEST(test_unwritten_slot_skipped);
+    RUN_TEST(test_rotation_waits_for_writer);
+    RUN_TEST(test_reopen_preserves_history);
+    RUN_TEST(test_rejects_foreign_data);
+    return TEST_EXIT();
+}
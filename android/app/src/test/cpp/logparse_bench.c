@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_logparse.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+/*
+ * Single-core parse throughput over a mix of plain and ANSI colored lines.
+ * Usage: logparse_bench [--quick] [lines]
+ */
+
+static const char* sample_lines[] = {
+    "+0800 2024-05-01 12:00:00 INFO [3145278281 5ms] inbound/tun[tun-in]: inbound connection from 172.19.0.1:53211",
+    "+0800 2024-05-01 12:00:00 INFO [3145278281 6ms] outbound/vless[proxy]: outbound connection to www.google.com:443",
+    "+0800 2024-05-01 12:00:00 DEBUG [3145278281 1ms] dns: exchange www.google.com. IN A",
+    "+0800 2024-05-01 12:00:00 DEBUG [3145278281 1ms] router: match[3] geosite=cn => route(direct)",
+    "+0800 2024-05-01 12:00:01 ERROR [3145278282 3s] connection: open connection to api.example.com:443 using outbound/vless[proxy]: i/o timeout",
+    "\x1b[36mINFO\x1b[0m [\x1b[38;5;45m3145278283\x1b[0m 0ms] inbound/tun[tun-in]: inbound packet connection from 172.19.0.1:5353",
+    "\x1b[36mINFO\x1b[0m [\x1b[38;5;45m3145278283\x1b[0m 12ms] dns: lookup succeed for www.example.com: 93.184.216.34",
+    "+0800 2024-05-01 12:00:02 INFO [3145278284 10s] connection: connection upload closed",
+};
+
+static void count_event(const singbox_log_event_t* event, const char* line, void* ctx) {
+    (void)line;
+    singbox_log_event_account((singbox_log_event_counters_t*)ctx, event);
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t lines = quick ? 200000 : 5000000;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            lines = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    // One contiguous capture buffer, as read() would deliver it
+    size_t variants = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    size_t pattern_size = 0;
+    for (size_t i = 0; i < variants; i++) {
+        pattern_size += strlen(sample_lines[i]) + 1;
+    }
+    size_t repeats = (lines + variants - 1) / variants;
+    size_t total_size = pattern_size * repeats;
+    char* pristine = malloc(total_size);
+    char* work = malloc(total_size);
+    char* cursor = pristine;
+    for (size_t r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < variants; i++) {
+            size_t length = strlen(sample_lines[i]);
+            memcpy(cursor, sample_lines[i], length);
+            cursor[length] = '\n';
+            cursor += length + 1;
+        }
+    }
+
+    static singbox_logparse_stream_t stream;
+    static singbox_log_event_counters_t counters;
+    const size_t chunk = 64 * 1024;
+    uint64_t best = UINT64_MAX;
+    int rounds = quick ? 2 : 5;
+    for (int round = 0; round < rounds; round++) {
+        memcpy(work, pristine, total_size); // Parsing strips colors in place
+        memset(&stream, 0, sizeof(stream));
+        uint64_t start = test_now_ns();
+        for (size_t offset = 0; offset < total_size; offset += chunk) {
+            size_t length = total_size - offset < chunk ? total_size - offset : chunk;
+            singbox_logparse_feed(&stream, work + offset, length, count_event, &counters);
+        }
+        singbox_logparse_flush(&stream, count_event, &counters);
+        uint64_t elapsed = test_now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    double seconds = (double)best / 1e9;
+    printf("log parse (simd: %s): %llu lines, %.1f MB in %.3f s\n", singbox_simd_backend(),
+           (unsigned long long)stream.lines, (double)total_size / (1024.0 * 1024.0), seconds);
+    printf("  throughput: %.2f M lines/s, %.0f MB/s\n",
+           (double)stream.lines / seconds / 1e6, (double)total_size / seconds / (1024.0 * 1024.0));
+    printf("  events: inbound=%llu outbound=%llu dns=%llu router=%llu errors=%llu closed=%llu\n",
+           (unsigned long long)counters.by_type[SINGBOX_EVENT_INBOUND_CONNECTION] / (unsigned)rounds,
+           (unsigned long long)counters.by_type[SINGBOX_EVENT_OUTBOUND_CONNECTION] / (unsigned)rounds,
+           (unsigned long long)(counters.by_type[SINGBOX_EVENT_DNS_QUERY] +
+                                counters.by_type[SINGBOX_EVENT_DNS_ANSWER]) / (unsigned)rounds,
+           (unsigned long long)counters.by_type[SINGBOX_EVENT_ROUTER_MATCH] / (unsigned)rounds,
+           (unsigned long long)counters.by_type[SINGBOX_EVENT_ERROR] / (unsigned)rounds,
+           (unsigned long long)counters.by_type[SINGBOX_EVENT_CONNECTION_CLOSED] / (unsigned)rounds);
+
+    free(work);
+    free(pristine);
+    return counters.by_type[SINGBOX_EVENT_NONE] == 0 ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logparse.h"
+#include "test_util.h"
+
+static int span_equals(const char* line, singbox_span_t span, const char* expected) {
+    return span.length == strlen(expected) && memcmp(line + span.offset, expected, span.length) == 0;
+}
+
+static singbox_log_event_t parse(char* line) {
+    singbox_log_event_t event;
+    size_t length = singbox_logparse_line(line, strlen(line), &event);
+    line[length] = '\0';
+    return event;
+}
+
+static void test_plain_outbound(void) {
+    char line[] = "+0800 2024-05-01 12:00:00 INFO [3145278281 5ms] outbound/vless[proxy]: "
+                  "outbound connection to www.google.com:443";
+    singbox_log_event_t event = parse(line);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_OUTBOUND_CONNECTION);
+    CHECK_EQ_INT(event.level, SINGBOX_LOG_INFO);
+    CHECK_EQ_INT(event.network, SINGBOX_NETWORK_TCP);
+    CHECK(event.flags & SINGBOX_EVENT_HAS_TIMESTAMP);
+    CHECK(event.flags & SINGBOX_EVENT_HAS_CONNECTION);
+    CHECK_EQ_INT(event.timestamp, 1714536000); // 2024-05-01 04:00:00 UTC
+    CHECK_EQ_INT(event.connection_id, 3145278281u);
+    CHECK_EQ_INT(event.duration_ms, 5);
+    CHECK(span_equals(line, event.module, "outbound/vless[proxy]"));
+    CHECK(span_equals(line, event.tag, "proxy"));
+    CHECK(span_equals(line, event.address, "www.google.com:443"));
+    CHECK(span_equals(line, event.message, "outbound connection to www.google.com:443"));
+}
+
+static void test_ansi_inbound_udp(void) {
+    char line[] = "\x1b[36mINFO\x1b[0m [\x1b[38;5;45m42\x1b[0m 1.5s] inbound/tun[tun-in]: "
+                  "inbound packet connection from 172.19.0.1:53211";
+    singbox_log_event_t event = parse(line);
+    CHECK(strchr(line, 0x1b) == NULL);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_INBOUND_CONNECTION);
+    CHECK_EQ_INT(event.network, SINGBOX_NETWORK_UDP);
+    CHECK_EQ_INT(event.connection_id, 42);
+    CHECK_EQ_INT(event.duration_ms, 1500);
+    CHECK(!(event.flags & SINGBOX_EVENT_HAS_TIMESTAMP));
+    CHECK(span_equals(line, event.tag, "tun-in"));
+    CHECK(span_equals(line, event.address, "172.19.0.1:53211"));
+}
+
+static void test_dns(void) {
+    char query[] = "DEBUG [7 0ms] dns: exchange www.example.com. IN A";
+    singbox_log_event_t event = parse(query);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_DNS_QUERY);
+    CHECK_EQ_INT(event.level, SINGBOX_LOG_DEBUG);
+    CHECK(span_equals(query, event.address, "www.example.com."));
+
+    char answer[] = "INFO [7 12ms] dns: lookup succeed for www.example.com: 93.184.216.34";
+    event = parse(answer);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_DNS_ANSWER);
+    CHECK(span_equals(answer, event.address, "www.example.com"));
+}
+
+static void test_router_match(void) {
+    char line[] = "-0500 2024-05-01 12:00:00 DEBUG [9 2m3s] router: match[2] geosite=cn => route(direct)";
+    singbox_log_event_t event = parse(line);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_ROUTER_MATCH);
+    CHECK_EQ_INT(event.timestamp, 1714582800); // 17:00 UTC
+    CHECK_EQ_INT(event.duration_ms, 123000);
+    CHECK(span_equals(line, event.tag, "direct"));
+}
+
+static void test_error(void) {
+    char line[] = "ERROR [11 3s] connection: open connection to api.example.com:443 using "
+                  "outbound/vless[proxy]: dial tcp 1.2.3.4:443: i/o timeout";
+    singbox_log_event_t event = parse(line);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_ERROR);
+    CHECK_EQ_INT(event.level, SINGBOX_LOG_ERROR);
+    CHECK(span_equals(line, event.module, "connection"));
+    CHECK(span_equals(line, event.address, "api.example.com:443"));
+}
+
+static void test_closed_and_unstructured(void) {
+    char closed[] = "INFO [12 10s] connection: connection upload closed";
+    singbox_log_event_t event = parse(closed);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_CONNECTION_CLOSED);
+
+    char banner[] = "sing-box started (0.42s)";
+    event = parse(banner);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_NONE);
+    CHECK_EQ_INT(event.module.length, 0);
+    CHECK(span_equals(banner, event.message, "sing-box started (0.42s)"));
+
+    char empty[] = "";
+    event = parse(empty);
+    CHECK_EQ_INT(event.type, SINGBOX_EVENT_NONE);
+}
+
+typedef struct {
+    int count;
+    char last[128];
+    singbox_log_event_counters_t counters;
+} sink_t;
+
+static void collect(const singbox_log_event_t* event, const char* line, void* ctx) {
+    sink_t* sink = (sink_t*)ctx;
+    sink->count++;
+    snprintf(sink->last, sizeof(sink->last), "%s", line);
+    singbox_log_event_account(&sink->counters, event);
+}
+
+static void test_stream_split_lines(void) {
+    static singbox_logparse_stream_t stream;
+    sink_t sink;
+    memset(&stream, 0, sizeof(stream));
+    memset(&sink, 0, sizeof(sink));
+
+    char part1[] = "INFO dns: exchange a.com. IN A\r\nERROR router: fa";
+    char part2[] = "iled\nINFO inbound/tun[tun-in]: inbound connection from 1.1.1.1:1\nINFO tail";
+    CHECK_EQ_INT(singbox_logparse_feed(&stream, part1, strlen(part1), collect, &sink), 1);
+    CHECK(strcmp(sink.last, "INFO dns: exchange a.com. IN A") == 0);
+    CHECK_EQ_INT(singbox_logparse_feed(&stream, part2, strlen(part2), collect, &sink), 2);
+    CHECK(strcmp(sink.last, "INFO inbound/tun[tun-in]: inbound connection from 1.1.1.1:1") == 0);
+    CHECK_EQ_INT(singbox_logparse_flush(&stream, collect, &sink), 1);
+    CHECK(strcmp(sink.last, "INFO tail") == 0);
+
+    CHECK_EQ_INT(sink.counters.lines, 4);
+    CHECK_EQ_INT(sink.counters.by_type[SINGBOX_EVENT_DNS_QUERY], 1);
+    CHECK_EQ_INT(sink.counters.by_type[SINGBOX_EVENT_ERROR], 1);
+    CHECK_EQ_INT(sink.counters.by_type[SINGBOX_EVENT_INBOUND_CONNECTION], 1);
+    CHECK_EQ_INT(sink.counters.by_level[SINGBOX_LOG_ERROR], 1);
+}
+
+static void test_stream_long_line(void) {
+    static singbox_logparse_stream_t stream;
+    static char data[SINGBOX_LOGPARSE_MAX_LINE * 2 + 32];
+    sink_t sink;
+    memset(&stream, 0, sizeof(stream));
+    memset(&sink, 0, sizeof(sink));
+
+    memset(data, 'x', SINGBOX_LOGPARSE_MAX_LINE * 2);
+    memcpy(data + SINGBOX_LOGPARSE_MAX_LINE * 2, "\nINFO next\n", 11);
+    // Feed in two pieces so the over-long line spans calls
+    singbox_logparse_feed(&stream, data, 100, collect, &sink);
+    singbox_logparse_feed(&stream, data + 100, SINGBOX_LOGPARSE_MAX_LINE * 2 + 11 - 100, collect, &sink);
+    CHECK_EQ_INT(sink.count, 2);
+    CHECK_EQ_INT(stream.truncated_lines, 1);
+    CHECK(strcmp(sink.last, "INFO next") == 0);
+}
+
+int main(void) {
+    RUN_TEST(test_plain_outbound);
+    RUN_TEST(test_ansi_inbound_udp);
+    RUN_TEST(test_dns);
+    RUN_TEST(test_router_match);
+    RUN_TEST(test_error);
+    RUN_TEST(test_closed_and_unstructured);
+    RUN_TEST(test_stream_split_lines);
+    RUN_TEST(test_stream_long_line);
+    return TEST_EXIT();
+}
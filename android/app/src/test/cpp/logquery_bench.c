@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logquery.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+/*
+ * Query latency over a synthetic set of log entries (100k by default).
+ * Usage: logquery_bench [--quick] [entries]
+ */
+
+#define NOW_MS 1700000000000LL
+
+static const char* modules[] = {
+    "inbound/tun[tun-in]", "outbound/vless[proxy]", "outbound/direct[direct]", "dns", "router"
+};
+
+static const char* templates[] = {
+    "inbound connection from 172.19.0.1:%d",
+    "outbound connection to www.example%d.com:443",
+    "dial tcp 10.0.%d.1:8080: connect: connection refused",
+    "exchange failed for host%d.example.net: i/o timeout",
+    "match[%d] => rule_set=geosite-cn => direct",
+};
+
+typedef struct {
+    const char* name;
+    const char* query;
+} bench_query_t;
+
+static int count_emitted(const singbox_log_view_t* record, void* ctx) {
+    (void)record;
+    (*(size_t*)ctx)++;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t entries = 100000;
+    int rounds = quick ? 3 : 20;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            entries = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    // Build the entry set up front; messages live in one arena like the ring does
+    singbox_log_view_t* views = calloc(entries, sizeof(*views));
+    char* arena = malloc(entries * 96);
+    char* cursor = arena;
+    for (size_t i = 0; i < entries; i++) {
+        size_t kind = i % 5;
+        int length = snprintf(cursor, 96, templates[kind], (int)(i % 251));
+        views[i].seq = i + 1;
+        views[i].timestamp_ms = NOW_MS - (int64_t)(entries - i) * 10;
+        views[i].level = kind == 2 || kind == 3 ? SINGBOX_LOG_ERROR : SINGBOX_LOG_INFO;
+        views[i].module = modules[kind];
+        views[i].module_len = strlen(modules[kind]);
+        views[i].message = cursor;
+        views[i].message_len = (size_t)length;
+        cursor += length + 1;
+    }
+
+    const bench_query_t queries[] = {
+        {"match all", ""},
+        {"level", "level>=error"},
+        {"time window", "since:60s"},
+        {"module", "module:dns"},
+        {"substring", "CONNECTION REFUSED"},
+        {"substring miss", "certificate"},
+        {"combined", "level>=error module:outbound since:10m refused"},
+        {"regex", "re:host[0-9]+\\.example\\.net"},
+    };
+
+    printf("log query over %zu entries (simd: %s)\n", entries, singbox_simd_backend());
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        singbox_log_query_t query;
+        if (singbox_log_query_parse(&query, queries[q].query, NOW_MS, NULL, 0) != 0) {
+            fprintf(stderr, "bad query: %s\n", queries[q].query);
+            return 1;
+        }
+
+        uint64_t samples[32];
+        size_t matched = 0;
+        for (int round = 0; round < rounds; round++) {
+            size_t emitted = 0;
+            singbox_log_pager_t pager;
+            singbox_log_pager_init(&pager, &query, 0, 100, count_emitted, &emitted);
+            uint64_t start = test_now_ns();
+            for (size_t i = 0; i < entries; i++) {
+                singbox_log_pager_visit(&views[i], &pager);
+            }
+            samples[round] = test_now_ns() - start;
+            matched = pager.matched;
+        }
+        uint64_t median = test_percentile(samples, (size_t)rounds, 50.0);
+        printf("  %-15s %8zu matches  %7.2f ms  %6.1f M entries/s\n", queries[q].name, matched,
+               (double)median / 1e6, (double)entries / ((double)median / 1e9) / 1e6);
+        singbox_log_query_free(&query);
+    }
+
+    // End to end through the in-memory ring including JSON encoding of one page
+    singbox_logging_init();
+    singbox_logging_set_throttle(NULL);
+    for (int i = 0; i < 1000; i++) {
+        singbox_log(SINGBOX_LOG_INFO, templates[i % 5], i);
+    }
+    uint64_t start = test_now_ns();
+    char* json = singbox_query_logs_json("refused", 0, 50);
+    uint64_t elapsed = test_now_ns() - start;
+    printf("  ring query + json page (1000 entries): %.1f us, %zu bytes\n",
+           (double)elapsed / 1e3, json ? strlen(json) : 0);
+    free(json);
+    singbox_logging_cleanup();
+
+    free(arena);
+    free(views);
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logquery.h"
+#include "sing_box_simd.h"
+#include "test_util.h"
+
+#define NOW_MS 1700000000000LL
+
+static singbox_log_view_t make_view(uint64_t seq, int64_t timestamp_ms, int level,
+                                    const char* module, const char* message) {
+    singbox_log_view_t view = {
+        .seq = seq,
+        .timestamp_ms = timestamp_ms,
+        .level = level,
+        .module = module,
+        .module_len = strlen(module),
+        .message = message,
+        .message_len = strlen(message),
+    };
+    return view;
+}
+
+static const char* naive_memmem_ci(const char* haystack, size_t haystack_len,
+                                   const char* needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    for (size_t i = 0; i + needle_len <= haystack_len; i++) {
+        if (strncasecmp(haystack + i, needle, needle_len) == 0) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
+
+static void test_memmem_ci(void) {
+    const char* text = "outbound/vless[proxy]: Dial TCP 1.2.3.4:443: i/o TIMEOUT";
+    CHECK(singbox_memmem_ci(text, strlen(text), "timeout", 7) == strstr(text, "TIMEOUT"));
+    CHECK(singbox_memmem_ci(text, strlen(text), "dial tcp", 8) == strstr(text, "Dial"));
+    CHECK(singbox_memmem_ci(text, strlen(text), "[PROXY]", 7) == strstr(text, "[proxy]"));
+    CHECK(singbox_memmem_ci(text, strlen(text), "refused", 7) == NULL);
+    // OR-ing 0x20 merges '@' and '`'; the exact compare must reject it
+    CHECK(singbox_memmem_ci("a`b", 3, "a@b", 3) == NULL);
+    CHECK(singbox_memmem_ci(text, 4, "outbound", 8) == NULL);
+
+    // Randomised comparison against a naive search, covering SIMD block edges
+    srand(1234);
+    char haystack[300];
+    char needle[8];
+    for (int round = 0; round < 20000; round++) {
+        size_t haystack_len = (size_t)(rand() % (int)sizeof(haystack));
+        size_t needle_len = 1 + (size_t)(rand() % 4);
+        for (size_t i = 0; i < haystack_len; i++) {
+            haystack[i] = "abAB@`[{"[rand() % 8];
+        }
+        for (size_t i = 0; i < needle_len; i++) {
+            needle[i] = "abAB@`[{"[rand() % 8];
+        }
+        const char* expected = naive_memmem_ci(haystack, haystack_len, needle, needle_len);
+        const char* actual = singbox_memmem_ci(haystack, haystack_len, needle, needle_len);
+        if (expected != actual) {
+            CHECK(expected == actual);
+            break;
+        }
+    }
+}
+
+static void test_parse_terms(void) {
+    singbox_log_query_t query;
+    char error[128];
+
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "level>=warn module:dns since:15m until:1700000000000 "
+                                         "order:oldest \"no such host\"", NOW_MS, error, sizeof(error)), 0);
+    CHECK_EQ_INT(query.min_level, SINGBOX_LOG_WARN);
+    CHECK(strcmp(query.module, "dns") == 0);
+    CHECK_EQ_INT(query.since_ms, NOW_MS - 15 * 60 * 1000);
+    CHECK_EQ_INT(query.until_ms, NOW_MS);
+    CHECK_EQ_INT(query.newest_first, 0);
+    CHECK(strcmp(query.text, "no such host") == 0);
+    singbox_log_query_free(&query);
+
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "connection   refused", NOW_MS, NULL, 0), 0);
+    CHECK(strcmp(query.text, "connection refused") == 0);
+    CHECK_EQ_INT(query.min_level, -1);
+    CHECK_EQ_INT(query.newest_first, 1);
+    singbox_log_query_free(&query);
+
+    CHECK_EQ_INT(singbox_log_query_parse(&query, NULL, NOW_MS, NULL, 0), 0);
+    singbox_log_query_free(&query);
+}
+
+static void test_parse_errors(void) {
+    singbox_log_query_t query;
+    char error[128];
+
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "level>=loud", NOW_MS, error, sizeof(error)), -1);
+    CHECK(strstr(error, "loud") != NULL);
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "since:yesterday", NOW_MS, error, sizeof(error)), -1);
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "re:(unclosed", NOW_MS, error, sizeof(error)), -1);
+    CHECK(strstr(error, "regex") != NULL);
+    CHECK_EQ_INT(singbox_log_query_parse(&query, "re:a re:b", NOW_MS, error, sizeof(error)), -1);
+}
+
+static void test_match(void) {
+    singbox_log_query_t query;
+    singbox_log_view_t dns_error = make_view(1, NOW_MS - 1000, SINGBOX_LOG_ERROR, "dns",
+                                             "exchange failed for example.com: i/o timeout");
+    singbox_log_view_t proxy_info = make_view(2, NOW_MS - 60 * 60 * 1000, SINGBOX_LOG_INFO,
+                                              "outbound/vless[proxy]", "outbound connection to 1.1.1.1:443");
+
+    singbox_log_query_parse(&query, "level>=warn", NOW_MS, NULL, 0);
+    CHECK(singbox_log_query_match(&query, &dns_error));
+    CHECK(!singbox_log_query_match(&query, &proxy_info));
+    singbox_log_query_free(&query);
+
+    singbox_log_query_parse(&query, "since:10m", NOW_MS, NULL, 0);
+    CHECK(singbox_log_query_match(&query, &dns_error));
+    CHECK(!singbox_log_query_match(&query, &proxy_info));
+    singbox_log_query_free(&query);
+
+    singbox_log_query_parse(&query, "module:OUTBOUND", NOW_MS, NULL, 0);
+    CHECK(!singbox_log_query_match(&query, &dns_error));
+    CHECK(singbox_log_query_match(&query, &proxy_info));
+    singbox_log_query_free(&query);
+
+    singbox_log_query_parse(&query, "TIMEOUT", NOW_MS, NULL, 0);
+    CHECK(singbox_log_query_match(&query, &dns_error));
+    CHECK(!singbox_log_query_match(&query, &proxy_info));
+    singbox_log_query_free(&query);
+
+    singbox_log_query_parse(&query, "/[0-9]+\\.[0-9]+\\.[0-9]+\\.[0-9]+:443/", NOW_MS, NULL, 0);
+    CHECK(!singbox_log_query_match(&query, &dns_error));
+    CHECK(singbox_log_query_match(&query, &proxy_info));
+    singbox_log_query_free(&query);
+
+    singbox_log_query_parse(&query, "re:\"EXCHANGE (failed|ok)\"", NOW_MS, NULL, 0);
+    CHECK(singbox_log_query_match(&query, &dns_error));
+    singbox_log_query_free(&query);
+}
+
+typedef struct {
+    uint64_t seqs[16];
+    size_t count;
+} page_t;
+
+static int collect_seq(const singbox_log_view_t* record, void* ctx) {
+    page_t* page = (page_t*)ctx;
+    page->seqs[page->count++] = record->seq;
+    return 0;
+}
+
+static void test_pagination(void) {
+    singbox_log_query_t query;
+    singbox_log_query_parse(&query, "level>=error", NOW_MS, NULL, 0);
+
+    // Every third record is an error: seqs 3, 6, 9, ...
+    singbox_log_view_t views[30];
+    for (int i = 0; i < 30; i++) {
+        views[i] = make_view((uint64_t)i + 1, NOW_MS, (i + 1) % 3 == 0 ? SINGBOX_LOG_ERROR : SINGBOX_LOG_INFO,
+                             "test", "message");
+    }
+
+    page_t page = {0};
+    singbox_log_pager_t pager;
+    singbox_log_pager_init(&pager, &query, 2, 3, collect_seq, &page);
+    for (int i = 0; i < 30; i++) {
+        singbox_log_pager_visit(&views[i], &pager);
+    }
+    CHECK_EQ_INT(pager.matched, 10);
+    CHECK_EQ_INT(pager.scanned, 30);
+    CHECK_EQ_INT(page.count, 3);
+    CHECK_EQ_INT(page.seqs[0], 9);
+    CHECK_EQ_INT(page.seqs[2], 15);
+    singbox_log_query_free(&query);
+}
+
+static void test_query_log_buffer(void) {
+    singbox_logging_init();
+    singbox_set_log_level(SINGBOX_LOG_TRACE);
+    singbox_logging_set_throttle(NULL); // Same template on purpose
+    for (int i = 0; i < 20; i++) {
+        singbox_log(i % 2 ? SINGBOX_LOG_WARN : SINGBOX_LOG_INFO, "entry %d \"quoted\"", i);
+    }
+
+    char* json = singbox_query_logs_json("level>=warn", 0, 2);
+    CHECK(json != NULL);
+    CHECK(strstr(json, "\"total\":10") != NULL);
+    // Newest first by default
+    CHECK(strstr(json, "entry 19 \\\"quoted\\\"") != NULL);
+    CHECK(strstr(json, "entry 17") != NULL);
+    CHECK(strstr(json, "entry 15") == NULL);
+    CHECK(strstr(json, "\"module\":\"native\"") != NULL);
+    free(json);
+
+    json = singbox_query_logs_json("order:oldest entry 1", 0, 0);
+    CHECK(json != NULL);
+    CHECK(strstr(json, "\"total\":11") != NULL); // entry 1 and entry 10..19
+    free(json);
+
+    json = singbox_query_logs_json("level>=nope", 0, 10);
+    CHECK(json != NULL);
+    CHECK(strncmp(json, "{\"error\":", 9) == 0);
+    free(json);
+
+    singbox_logging_cleanup();
+}
+
+int main(void) {
+    printf("simd backend: %s\n", singbox_simd_backend());
+    RUN_TEST(test_memmem_ci);
+    RUN_TEST(test_parse_terms);
+    RUN_TEST(test_parse_errors);
+    RUN_TEST(test_match);
+    RUN_TEST(test_pagination);
+    RUN_TEST(test_query_log_buffer);
+    return TEST_EXIT();
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logring.h"
+#include "sing_box_lz.h"
+#include "test_util.h"
+
+/*
+ * History kept by the block-compressed ring in the memory the old fixed
+ * 1000 x 512 byte array used, plus codec and ring throughput.
+ * Usage: logring_bench [--quick] [records]
+ */
+
+#define LEGACY_ENTRIES 1000
+#define LEGACY_ENTRY_SIZE 512
+
+typedef struct {
+    int level;
+    const char* module;
+    const char* format;     // Takes an id, a port and an octet
+} record_template_t;
+
+// Shapes of the lines sing-box logs while a tunnel is busy
+static const record_template_t templates[] = {
+    { SINGBOX_LOG_INFO, "inbound/tun[tun-in]", "[%u 0ms] inbound connection from 172.19.0.1:%u to 142.250.%u.14:443" },
+    { SINGBOX_LOG_INFO, "outbound/vless[proxy]", "[%u 5ms] outbound connection to www.google.com:443 via port %u, hop %u" },
+    { SINGBOX_LOG_DEBUG, "dns", "[%u 1ms] exchange www.example.com. IN A from 172.19.0.1:%u, %u answers" },
+    { SINGBOX_LOG_DEBUG, "router", "[%u 0ms] match[3] geosite=cn => route(direct) for 172.19.0.1:%u, rule %u" },
+    { SINGBOX_LOG_INFO, "inbound/tun[tun-in]", "[%u 12ms] inbound packet connection from 172.19.0.1:%u to 8.8.%u.8:53" },
+    { SINGBOX_LOG_INFO, "connection", "[%u 10s] connection upload closed, %u bytes, %u packets" },
+    { SINGBOX_LOG_ERROR, "connection", "[%u 3s] open connection to api.example.com:%u using outbound/vless[proxy]: dial tcp 1.2.3.%u:443: i/o timeout" },
+    { SINGBOX_LOG_WARN, "router", "[%u 0ms] rule-set geosite-cn not ready, waiting for download (%u/%u)" },
+};
+
+static size_t format_record(size_t i, char* out, size_t size, const record_template_t** template) {
+    *template = &templates[(i * 7 + i / 3) % (sizeof(templates) / sizeof(templates[0]))];
+    int length = snprintf(out, size, (*template)->format, 3145278281u + (unsigned)(i / 4),
+                          40000u + (unsigned)(i * 37 % 20000), (unsigned)(i % 200));
+    return (size_t)length;
+}
+
+static int sum_lengths(const singbox_log_view_t* record, void* ctx) {
+    *(size_t*)ctx += record->message_len;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t records = quick ? 200000 : 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            records = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    // Same budget as the legacy array: arena plus open block and decode buffer
+    size_t budget = LEGACY_ENTRIES * LEGACY_ENTRY_SIZE;
+    size_t block_size = SINGBOX_LOGRING_DEFAULT_BLOCK_SIZE;
+    singbox_logring_t* ring = singbox_logring_create(budget - 2 * block_size, block_size);
+    if (!ring) {
+        return 1;
+    }
+
+    char message[512];
+    size_t message_bytes = 0;
+    uint64_t start = test_now_ns();
+    for (size_t i = 0; i < records; i++) {
+        const record_template_t* template;
+        size_t length = format_record(i, message, sizeof(message), &template);
+        message_bytes += length;
+        singbox_logring_append(ring, i + 1, 1714536000000ll + (int64_t)(i / 50), template->level,
+                               template->module, strlen(template->module), message, length);
+    }
+    uint64_t append_ns = test_now_ns() - start;
+
+    singbox_logring_stats_t stats;
+    singbox_logring_get_stats(ring, &stats);
+    printf("log ring: %zu KB budget, %u KB blocks, %zu records appended (avg message %.0f bytes)\n",
+           budget / 1024, stats.block_size / 1024, records, (double)message_bytes / (double)records);
+    printf("  retained     %8llu records vs %d in the fixed array (%.1fx history)\n",
+           (unsigned long long)stats.records, LEGACY_ENTRIES, (double)stats.records / LEGACY_ENTRIES);
+    printf("  compression  %8.2fx  (%llu KB raw in %llu KB, %llu raw blocks)\n",
+           (double)stats.raw_bytes / (double)stats.stored_bytes,
+           (unsigned long long)(stats.raw_bytes / 1024), (unsigned long long)(stats.stored_bytes / 1024),
+           (unsigned long long)stats.raw_blocks);
+    printf("  append       %8.2f M records/s (%.0f ns/record including block sealing)\n",
+           (double)records / ((double)append_ns / 1e9) / 1e6, (double)append_ns / (double)records);
+
+    // Reading decompresses every sealed block once
+    uint64_t best_visit = UINT64_MAX;
+    int rounds = quick ? 3 : 10;
+    size_t checksum = 0;
+    for (int round = 0; round < rounds; round++) {
+        start = test_now_ns();
+        singbox_logring_visit(ring, round & 1, sum_lengths, &checksum);
+        uint64_t elapsed = test_now_ns() - start;
+        if (elapsed < best_visit) {
+            best_visit = elapsed;
+        }
+    }
+    printf("  full scan    %8.2f ms (%.1f M records/s)\n", (double)best_visit / 1e6,
+           (double)stats.records / ((double)best_visit / 1e9) / 1e6);
+
+    // Raw codec speed on one block of the same text
+    uint8_t* block = malloc(block_size);
+    uint8_t* packed = malloc(singbox_lz_compress_bound(block_size));
+    uint8_t* unpacked = malloc(block_size);
+    size_t block_len = 0;
+    for (size_t i = 0; block_len + sizeof(message) < block_size; i++) {
+        const record_template_t* template;
+        block_len += format_record(i, (char*)block + block_len, block_size - block_len, &template);
+    }
+    size_t packed_len = 0;
+    uint64_t best_compress = UINT64_MAX, best_decompress = UINT64_MAX;
+    int codec_rounds = quick ? 200 : 2000;
+    for (int round = 0; round < codec_rounds; round++) {
+        start = test_now_ns();
+        packed_len = singbox_lz_compress(block, block_len, packed, singbox_lz_compress_bound(block_len));
+        uint64_t middle = test_now_ns();
+        long length = singbox_lz_decompress(packed, packed_len, unpacked, block_size);
+        uint64_t end = test_now_ns();
+        if (length != (long)block_len || memcmp(block, unpacked, block_len) != 0) {
+            fprintf(stderr, "codec round trip failed\n");
+            return 1;
+        }
+        if (middle - start < best_compress) {
+            best_compress = middle - start;
+        }
+        if (end - middle < best_decompress) {
+            best_decompress = end - middle;
+        }
+    }
+    printf("  lz codec     %8.0f MB/s compress, %.0f MB/s decompress, %.2fx on message text only\n",
+           (double)block_len / ((double)best_compress / 1e9) / (1024.0 * 1024.0),
+           (double)block_len / ((double)best_decompress / 1e9) / (1024.0 * 1024.0),
+           (double)block_len / (double)packed_len);
+    free(block);
+    free(packed);
+    free(unpacked);
+
+    singbox_logring_destroy(ring);
+    // The ring must at least hold what the fixed array did
+    return stats.records >= LEGACY_ENTRIES && checksum > 0 ? 0 : 1;
+}
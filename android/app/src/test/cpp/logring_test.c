@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logring.h"
+#include "sing_box_lz.h"
+#include "test_util.h"
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static int round_trip(const uint8_t* input, size_t length) {
+    size_t bound = singbox_lz_compress_bound(length);
+    uint8_t* packed = malloc(bound);
+    uint8_t* unpacked = malloc(length + 1);
+    size_t packed_len = singbox_lz_compress(input, length, packed, bound);
+    long unpacked_len = packed_len ? singbox_lz_decompress(packed, packed_len, unpacked, length) : -1;
+    int ok = packed_len > 0 && unpacked_len == (long)length && memcmp(input, unpacked, length) == 0;
+    free(packed);
+    free(unpacked);
+    return ok;
+}
+
+static void test_lz_round_trip(void) {
+    static uint8_t data[70000];
+    CHECK(round_trip(data, 0));
+    CHECK(round_trip((const uint8_t*)"a", 1));
+    CHECK(round_trip((const uint8_t*)"abcdabcdabcd", 12));
+
+    // Long runs exercise overlapping matches and length extension bytes
+    memset(data, 'x', sizeof(data));
+    CHECK(round_trip(data, sizeof(data)));
+
+    // Incompressible input still round trips within the bound
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)next_random();
+    }
+    CHECK(round_trip(data, sizeof(data)));
+
+    // Log-like text with repeats further back than the 64 KB window
+    size_t length = 0;
+    for (int i = 0; length + 100 < sizeof(data); i++) {
+        length += (size_t)snprintf((char*)data + length, sizeof(data) - length,
+                                   "outbound/vless[proxy]: dial tcp 10.0.%d.%d:443: i/o timeout\n",
+                                   i % 256, (i * 7) % 256);
+    }
+    CHECK(round_trip(data, length));
+    for (size_t cut = 1; cut < 200; cut += 13) {
+        CHECK(round_trip(data, cut));
+    }
+}
+
+static void test_lz_ratio_and_limits(void) {
+    char text[16384];
+    size_t length = 0;
+    for (int i = 0; length + 200 < sizeof(text); i++) {
+        length += (size_t)snprintf(text + length, sizeof(text) - length,
+                                   "INFO [%d 12ms] inbound/tun[tun-in]: inbound connection to 1.1.1.%d:53\n",
+                                   1000000 + i, i % 255);
+    }
+    uint8_t packed[16384];
+    size_t packed_len = singbox_lz_compress(text, length, packed, sizeof(packed));
+    CHECK(packed_len > 0);
+    CHECK(packed_len * 4 < length);
+
+    // Output that does not fit is rejected rather than truncated
+    CHECK_EQ_INT(singbox_lz_compress(text, length, packed, 16), 0);
+
+    char out[16384];
+    CHECK_EQ_INT(singbox_lz_decompress(packed, packed_len, out, length - 1), -1);
+}
+
+static void test_lz_rejects_corrupt_input(void) {
+    char out[256];
+    // Match before the start of the output
+    const uint8_t bad_offset[] = { 0x10, 'a', 0x05, 0x00 };
+    CHECK_EQ_INT(singbox_lz_decompress(bad_offset, sizeof(bad_offset), out, sizeof(out)), -1);
+    // Literal run longer than the input
+    const uint8_t short_literals[] = { 0x50, 'a', 'b' };
+    CHECK_EQ_INT(singbox_lz_decompress(short_literals, sizeof(short_literals), out, sizeof(out)), -1);
+    // Truncated length extension
+    const uint8_t truncated[] = { 0xf0, 0xff };
+    CHECK_EQ_INT(singbox_lz_decompress(truncated, sizeof(truncated), out, sizeof(out)), -1);
+
+    // Random garbage must never write past the output buffer or crash
+    uint8_t garbage[512];
+    for (int round = 0; round < 2000; round++) {
+        for (size_t i = 0; i < sizeof(garbage); i++) {
+            garbage[i] = (uint8_t)next_random();
+        }
+        long result = singbox_lz_decompress(garbage, 1 + next_random() % sizeof(garbage), out, sizeof(out));
+        CHECK(result >= -1 && result <= (long)sizeof(out));
+    }
+}
+
+typedef struct {
+    uint64_t seqs[64];
+    size_t count;
+    size_t limit;
+    int valid;
+    uint64_t expected_seq;
+    int step;
+} ring_sink_t;
+
+static int collect(const singbox_log_view_t* record, void* ctx) {
+    ring_sink_t* sink = (ring_sink_t*)ctx;
+    char expected[64];
+    snprintf(expected, sizeof(expected), "message %llu", (unsigned long long)record->seq);
+    if (strncmp(record->message, expected, record->message_len) != 0 || record->module_len != 6 ||
+        strncmp(record->module, "router", 6) != 0 || record->timestamp_ms != (int64_t)record->seq * 10 ||
+        record->level != (int)(record->seq % 6)) {
+        sink->valid = 0;
+    }
+    if (sink->expected_seq && record->seq != sink->expected_seq) {
+        sink->valid = 0;
+    }
+    sink->expected_seq = record->seq + (uint64_t)sink->step;
+    if (sink->count < sizeof(sink->seqs) / sizeof(sink->seqs[0])) {
+        sink->seqs[sink->count] = record->seq;
+    }
+    sink->count++;
+    return sink->limit && sink->count >= sink->limit;
+}
+
+static void append_numbered(singbox_logring_t* ring, uint64_t first, uint64_t last) {
+    char message[64];
+    for (uint64_t seq = first; seq <= last; seq++) {
+        int length = snprintf(message, sizeof(message), "message %llu", (unsigned long long)seq);
+        singbox_logring_append(ring, seq, (int64_t)seq * 10, (int)(seq % 6), "router", 6, message, (size_t)length);
+    }
+}
+
+static void test_ring_order_across_blocks(void) {
+    singbox_logring_t* ring = singbox_logring_create(64 * 1024, 8 * 1024);
+    CHECK(ring != NULL);
+    append_numbered(ring, 1, 2000);
+    CHECK_EQ_INT(singbox_logring_count(ring), 2000);
+
+    singbox_logring_stats_t stats;
+    singbox_logring_get_stats(ring, &stats);
+    CHECK(stats.blocks >= 3);
+    CHECK(stats.stored_bytes < stats.raw_bytes);
+
+    ring_sink_t sink = { .valid = 1, .step = 1 };
+    CHECK_EQ_INT(singbox_logring_visit(ring, 0, collect, &sink), 2000);
+    CHECK(sink.valid);
+    CHECK_EQ_INT(sink.seqs[0], 1);
+
+    sink = (ring_sink_t){ .valid = 1, .step = -1 };
+    CHECK_EQ_INT(singbox_logring_visit(ring, 1, collect, &sink), 2000);
+    CHECK(sink.valid);
+    CHECK_EQ_INT(sink.seqs[0], 2000);
+
+    // Early stop inside a sealed block
+    sink = (ring_sink_t){ .valid = 1, .step = -1, .limit = 1500 };
+    CHECK_EQ_INT(singbox_logring_visit(ring, 1, collect, &sink), 1500);
+    CHECK(sink.valid);
+
+    singbox_logring_clear(ring);
+    CHECK_EQ_INT(singbox_logring_count(ring), 0);
+    sink = (ring_sink_t){ .valid = 1, .step = 1 };
+    CHECK_EQ_INT(singbox_logring_visit(ring, 0, collect, &sink), 0);
+    singbox_logring_destroy(ring);
+}
+
+static void test_ring_evicts_oldest_blocks(void) {
+    singbox_logring_t* ring = singbox_logring_create(32 * 1024, 8 * 1024);
+    append_numbered(ring, 1, 200000);
+
+    singbox_logring_stats_t stats;
+    singbox_logring_get_stats(ring, &stats);
+    CHECK(stats.evicted_blocks > 0);
+    CHECK_EQ_INT(stats.records + stats.evicted_records, 200000);
+    CHECK(stats.stored_bytes - 8 * 1024 <= 32 * 1024);
+    // Holds well over twice its memory worth of raw records
+    CHECK(stats.raw_bytes > 2 * (32 + 8) * 1024);
+
+    // The newest records survive, contiguous up to the last one
+    ring_sink_t sink = { .valid = 1, .step = -1 };
+    CHECK_EQ_INT(singbox_logring_visit(ring, 1, collect, &sink), (long)stats.records);
+    CHECK(sink.valid);
+    CHECK_EQ_INT(sink.seqs[0], 200000);
+    CHECK_EQ_INT(sink.expected_seq, 200000 - stats.records);
+    singbox_logring_destroy(ring);
+}
+
+static void test_ring_incompressible_and_long_records(void) {
+    singbox_logring_t* ring = singbox_logring_create(0, 8 * 1024);
+    static char message[SINGBOX_LOGRING_MAX_MESSAGE + 100];
+    for (int i = 0; i < 50; i++) {
+        for (size_t j = 0; j < sizeof(message); j++) {
+            message[j] = (char)(33 + next_random() % 90);
+        }
+        singbox_logring_append(ring, (uint64_t)i + 1, i, SINGBOX_LOG_INFO, "core", 4,
+                               message, (size_t)(i % 2 ? 3000 : sizeof(message) - 100));
+    }
+    singbox_logring_stats_t stats;
+    singbox_logring_get_stats(ring, &stats);
+    CHECK(stats.raw_blocks > 0);
+    CHECK_EQ_INT(stats.truncated, 0);
+
+    singbox_logring_append(ring, 51, 51, SINGBOX_LOG_INFO, "a-very-long-module-name-beyond-thirty-one",
+                           41, message, sizeof(message));
+    singbox_logring_get_stats(ring, &stats);
+    CHECK_EQ_INT(stats.truncated, 1);
+    CHECK_EQ_INT(stats.records, 51);
+    singbox_logring_destroy(ring);
+}
+
+static int find_long_message(const singbox_log_view_t* record, void* ctx) {
+    size_t* length = (size_t*)ctx;
+    if (record->message_len > *length) {
+        *length = record->message_len;
+    }
+    return 0;
+}
+
+static void test_logging_keeps_long_messages(void) {
+    singbox_logging_init();
+    singbox_logging_set_throttle(NULL);
+    static char message[1200];
+    memset(message, 'm', sizeof(message));
+    singbox_log_write(SINGBOX_LOG_ERROR, "core", message, sizeof(message));
+
+    size_t longest = 0;
+    singbox_logging_visit(0, find_long_message, &longest);
+    CHECK_EQ_INT(longest, sizeof(message)); // Used to be cut at 511 bytes
+
+    for (int i = 0; i < 5000; i++) {
+        singbox_log(SINGBOX_LOG_INFO, "connection %d routed to proxy", i);
+    }
+    int entries = 0;
+    singbox_get_log_stats(&entries, NULL);
+    CHECK_EQ_INT(entries, 5001); // The fixed buffer kept 1000
+
+    singbox_logring_stats_t stats;
+    singbox_logging_get_buffer_stats(&stats);
+    CHECK(stats.stored_bytes < stats.raw_bytes);
+
+    char* json = singbox_get_logs_json();
+    CHECK(json && strncmp(json, "{\"logs\":[{\"timestamp\":", 22) == 0);
+    CHECK(json && strstr(json, "connection 4999 routed to proxy\"}]}") != NULL);
+    free(json);
+    singbox_logging_cleanup();
+}
+
+int main(void) {
+    RUN_TEST(test_lz_round_trip);
+    RUN_TEST(test_lz_ratio_and_limits);
+    RUN_TEST(test_lz_rejects_corrupt_input);
+    RUN_TEST(test_ring_order_across_blocks);
+    RUN_TEST(test_ring_evicts_oldest_blocks);
+    RUN_TEST(test_ring_incompressible_and_long_records);
+    RUN_TEST(test_logging_keeps_long_messages);
+    return TEST_EXIT();
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logtail.h"
+#include "test_util.h"
+
+/*
+ * Cost of a UI log refresh through the shared tail ring compared with the
+ * JSON snapshot it replaces. The snapshot path formats every buffered entry
+ * and copies the result into a fresh string as NewStringUTF does (the
+ * Kotlin parse is not counted); the tail path decodes only the records
+ * added since the last refresh and copies each module and message out, as
+ * building the Kotlin strings does.
+ * Usage: logtail_bench [--quick] [entries]
+ */
+
+static const char* templates[] = {
+    "inbound connection from 172.19.0.1:%d",
+    "outbound connection to www.example%d.com:443",
+    "dial tcp 10.0.%d.1:8080: connect: connection refused",
+    "exchange failed for host%d.example.net: i/o timeout",
+    "match[%d] => rule_set=geosite-cn => direct",
+};
+
+typedef struct {
+    size_t records;
+    size_t bytes;
+} copied_t;
+
+static int copy_record(const singbox_log_view_t* record, void* ctx) {
+    copied_t* copied = ctx;
+    char* module = malloc(record->module_len + 1);
+    char* message = malloc(record->message_len + 1);
+    if (module && message) {
+        memcpy(module, record->module, record->module_len);
+        module[record->module_len] = '\0';
+        memcpy(message, record->message, record->message_len);
+        message[record->message_len] = '\0';
+        copied->records++;
+        copied->bytes += record->module_len + record->message_len;
+    }
+    free(module);
+    free(message);
+    return 0;
+}
+
+static size_t json_snapshot(void) {
+    char* json = singbox_get_logs_json();
+    if (!json) {
+        return 0;
+    }
+    size_t length = strlen(json);
+    char* copy = malloc(length + 1);
+    if (copy) {
+        memcpy(copy, json, length + 1);
+    }
+    free(copy);
+    free(json);
+    return length;
+}
+
+static void log_batch(int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        singbox_log(SINGBOX_LOG_INFO, templates[i % 5], i % 251);
+    }
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    int entries = 5000;
+    int refreshes = quick ? 10 : 100;
+    int batch = 20;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            entries = atoi(argv[i]);
+        }
+    }
+
+    singbox_logging_init();
+    singbox_logging_set_throttle(NULL);
+    const singbox_logtail_t* region = singbox_logging_tail_region(NULL);
+    log_batch(0, entries);
+
+    int total = 0;
+    singbox_get_log_stats(&total, NULL);
+    printf("log refresh with %d buffered entries, %d new per refresh (tail ring %u KB)\n",
+           total, batch, region->capacity / 1024);
+
+    // Steady state: a refresh after every batch of new records
+    uint64_t* json_samples = calloc((size_t)refreshes, sizeof(uint64_t));
+    uint64_t* tail_samples = calloc((size_t)refreshes, sizeof(uint64_t));
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 1);
+    size_t json_bytes = 0;
+    copied_t copied = {0};
+    for (int round = 0; round < refreshes; round++) {
+        log_batch(entries + round * batch, batch);
+
+        uint64_t start = test_now_ns();
+        json_bytes = json_snapshot();
+        json_samples[round] = test_now_ns() - start;
+
+        start = test_now_ns();
+        singbox_logtail_read(region, &cursor, 0, copy_record, &copied);
+        tail_samples[round] = test_now_ns() - start;
+    }
+    uint64_t json_p50 = test_percentile(json_samples, (size_t)refreshes, 50.0);
+    uint64_t tail_p50 = test_percentile(tail_samples, (size_t)refreshes, 50.0);
+    printf("  json snapshot     %9.1f us p50  %8zu bytes per refresh\n", (double)json_p50 / 1e3, json_bytes);
+    printf("  tail new records  %9.1f us p50  %8zu records, %llu lost\n", (double)tail_p50 / 1e3,
+           copied.records / (size_t)refreshes, (unsigned long long)cursor.lost);
+    printf("  speedup           %9.0fx\n", (double)json_p50 / (double)(tail_p50 ? tail_p50 : 1));
+
+    // Raw decoder throughput: the whole ring from its oldest record
+    int rounds = quick ? 5 : 50;
+    uint64_t samples[64];
+    copied_t full = {0};
+    for (int round = 0; round < rounds; round++) {
+        singbox_logtail_cursor_init(region, &cursor, 0);
+        memset(&full, 0, sizeof(full));
+        uint64_t start = test_now_ns();
+        singbox_logtail_read(region, &cursor, 0, copy_record, &full);
+        samples[round] = test_now_ns() - start;
+    }
+    uint64_t median = test_percentile(samples, (size_t)rounds, 50.0);
+    printf("  full ring decode  %9.1f us p50  %8zu records, %.1f M records/s\n", (double)median / 1e3,
+           full.records, (double)full.records / ((double)median / 1e9) / 1e6);
+
+    free(json_samples);
+    free(tail_samples);
+    singbox_logging_cleanup();
+    return copied.records == (size_t)refreshes * (size_t)batch ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logtail.h"
+#include "test_util.h"
+
+#define SMALL_SIZE SINGBOX_LOGTAIL_MIN_SIZE
+
+static uint8_t small_memory[SMALL_SIZE] __attribute__((aligned(64)));
+
+typedef struct {
+    uint64_t first_seq;
+    uint64_t last_seq;
+    int count;
+    int out_of_order;
+    int corrupt;
+    char module[64];
+    char message[SINGBOX_LOGFILE_MAX_MESSAGE + 1];
+    int level;
+    int64_t timestamp_ms;
+} collected_t;
+
+// Message bodies are derived from the sequence number so torn copies show up
+static size_t make_message(uint64_t seq, char* out, size_t size) {
+    size_t length = 16 + (size_t)(seq * 37 % 300);
+    if (length > size) {
+        length = size;
+    }
+    for (size_t i = 0; i < length; i++) {
+        out[i] = (char)('a' + (seq + i) % 26);
+    }
+    return length;
+}
+
+static int message_matches(const singbox_log_view_t* record) {
+    char expected[512];
+    size_t length = make_message(record->seq, expected, sizeof(expected));
+    return record->message_len == length && memcmp(record->message, expected, length) == 0 &&
+           record->timestamp_ms == (int64_t)record->seq * 10;
+}
+
+static int collect(const singbox_log_view_t* record, void* ctx) {
+    collected_t* out = ctx;
+    if (out->count == 0) {
+        out->first_seq = record->seq;
+    } else if (record->seq <= out->last_seq) {
+        out->out_of_order++;
+    }
+    out->last_seq = record->seq;
+    out->count++;
+    out->level = record->level;
+    out->timestamp_ms = record->timestamp_ms;
+    snprintf(out->module, sizeof(out->module), "%.*s", (int)record->module_len, record->module);
+    snprintf(out->message, sizeof(out->message), "%.*s", (int)record->message_len, record->message);
+    return 0;
+}
+
+static int collect_checked(const singbox_log_view_t* record, void* ctx) {
+    collected_t* out = ctx;
+    if (!message_matches(record)) {
+        out->corrupt++;
+    }
+    return collect(record, ctx);
+}
+
+static void append_generated(singbox_logtail_t* region, uint64_t seq) {
+    char message[512];
+    size_t length = make_message(seq, message, sizeof(message));
+    singbox_logtail_append(region, seq, (int64_t)seq * 10, SINGBOX_LOG_INFO, "router", 6, message, length);
+}
+
+static void test_init_validates_memory(void) {
+    CHECK(singbox_logtail_init(NULL, SMALL_SIZE) == NULL);
+    CHECK(singbox_logtail_init(small_memory, SMALL_SIZE - 8) == NULL);
+    CHECK(singbox_logtail_init(small_memory + 8, SMALL_SIZE - 64) == NULL);
+
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    CHECK(region != NULL);
+    CHECK_EQ_INT(region->magic, SINGBOX_LOGTAIL_MAGIC);
+    CHECK_EQ_INT(region->version, SINGBOX_LOGTAIL_VERSION);
+    CHECK_EQ_INT(region->header_size, 64);
+    CHECK_EQ_INT(region->capacity, SMALL_SIZE - 64);
+    CHECK_EQ_INT(region->head, 0);
+    CHECK_EQ_INT(region->tail, 0);
+}
+
+static void test_round_trip_and_newest_cursor(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    singbox_logtail_append(region, 7, 1234567, SINGBOX_LOG_WARN, "dns", 3, "lookup example.com: timeout", 27);
+
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    collected_t out = {0};
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, &out), 1);
+    CHECK_EQ_INT(out.first_seq, 7);
+    CHECK_EQ_INT(out.level, SINGBOX_LOG_WARN);
+    CHECK_EQ_INT(out.timestamp_ms, 1234567);
+    CHECK(strcmp(out.module, "dns") == 0);
+    CHECK(strcmp(out.message, "lookup example.com: timeout") == 0);
+    CHECK_EQ_INT(cursor.offset, region->head);
+    CHECK_EQ_INT(region->head % 8, 0);
+
+    // Nothing new: no records, cursor unchanged
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, &out), 0);
+
+    // A cursor opened at the newest position skips what is already there
+    singbox_logtail_cursor_t fresh;
+    singbox_logtail_cursor_init(region, &fresh, 1);
+    singbox_logtail_append(region, 8, 1234568, SINGBOX_LOG_INFO, "dns", 3, "ok", 2);
+    memset(&out, 0, sizeof(out));
+    CHECK_EQ_INT(singbox_logtail_read(region, &fresh, 0, collect, &out), 1);
+    CHECK_EQ_INT(out.first_seq, 8);
+
+    // The record limit is honoured and the rest is picked up next time
+    for (uint64_t seq = 9; seq < 19; seq++) {
+        append_generated(region, seq);
+    }
+    memset(&out, 0, sizeof(out));
+    CHECK_EQ_INT(singbox_logtail_read(region, &fresh, 4, collect, &out), 4);
+    CHECK_EQ_INT(singbox_logtail_read(region, &fresh, 0, collect, &out), 6);
+    CHECK_EQ_INT(out.last_seq, 18);
+    CHECK_EQ_INT(fresh.lost, 0);
+}
+
+static void test_wraps_without_loss_when_kept_up(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    collected_t out = {0};
+
+    // Many laps of the 16 KB area with varying record sizes
+    for (uint64_t seq = 1; seq <= 5000; seq++) {
+        append_generated(region, seq);
+        if (seq % 7 == 0) {
+            CHECK(singbox_logtail_read(region, &cursor, 0, collect_checked, &out) > 0);
+        }
+    }
+    singbox_logtail_read(region, &cursor, 0, collect_checked, &out);
+    CHECK_EQ_INT(out.count, 5000);
+    CHECK_EQ_INT(out.first_seq, 1);
+    CHECK_EQ_INT(out.last_seq, 5000);
+    CHECK_EQ_INT(out.out_of_order, 0);
+    CHECK_EQ_INT(out.corrupt, 0);
+    CHECK_EQ_INT(cursor.lost, 0);
+    CHECK_EQ_INT(region->records, 5000);
+    CHECK(region->head > 20 * (uint64_t)region->capacity);
+    CHECK(region->head - region->tail <= region->capacity);
+}
+
+static void test_overrun_reader_counts_lost_records(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    collected_t out = {0};
+
+    append_generated(region, 1);
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect_checked, &out), 1);
+
+    // Far more than fits; the reader resumes at the oldest record still held
+    for (uint64_t seq = 2; seq <= 2000; seq++) {
+        append_generated(region, seq);
+    }
+    memset(&out, 0, sizeof(out));
+    int delivered = singbox_logtail_read(region, &cursor, 0, collect_checked, &out);
+    CHECK(delivered > 10 && delivered < 1999);
+    CHECK_EQ_INT(out.last_seq, 2000);
+    CHECK_EQ_INT(out.corrupt, 0);
+    CHECK_EQ_INT(cursor.lost + (uint64_t)delivered, 1999);
+    CHECK_EQ_INT(out.first_seq, cursor.lost + 2);
+
+    // Clearing drops the rest; the next record reports the gap
+    for (uint64_t seq = 2001; seq <= 2010; seq++) {
+        append_generated(region, seq);
+    }
+    singbox_logtail_clear(region);
+    append_generated(region, 2011);
+    uint64_t lost_before = cursor.lost;
+    memset(&out, 0, sizeof(out));
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect_checked, &out), 1);
+    CHECK_EQ_INT(out.first_seq, 2011);
+    CHECK_EQ_INT(cursor.lost - lost_before, 10);
+}
+
+static void test_long_fields_are_cut(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    static char message[SINGBOX_LOGFILE_MAX_MESSAGE + 500];
+    memset(message, 'm', sizeof(message));
+    singbox_logtail_append(region, 1, 1, SINGBOX_LOG_ERROR, "a-very-long-module-name-beyond-thirty-one", 41,
+                           message, sizeof(message));
+
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    static collected_t out;
+    memset(&out, 0, sizeof(out));
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, &out), 1);
+    CHECK_EQ_INT(strlen(out.module), SINGBOX_LOGFILE_MAX_MODULE);
+    CHECK_EQ_INT(strlen(out.message), SINGBOX_LOGFILE_MAX_MESSAGE);
+}
+
+static void test_corrupt_region_is_reported(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    append_generated(region, 1);
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    region->data[0] = 3; // Size no longer a multiple of eight
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, NULL), -1);
+}
+
+typedef struct {
+    singbox_logtail_t* region;
+    uint64_t total;
+    int done;
+} writer_ctx_t;
+
+typedef struct {
+    writer_ctx_t* writer;
+    collected_t out;
+    singbox_logtail_cursor_t cursor;
+    int errors;
+} reader_ctx_t;
+
+static void* writer_thread(void* arg) {
+    writer_ctx_t* ctx = arg;
+    for (uint64_t seq = 1; seq <= ctx->total; seq++) {
+        append_generated(ctx->region, seq);
+    }
+    __atomic_store_n(&ctx->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* reader_thread(void* arg) {
+    reader_ctx_t* ctx = arg;
+    singbox_logtail_cursor_init(ctx->writer->region, &ctx->cursor, 0);
+    for (;;) {
+        int done = __atomic_load_n(&ctx->writer->done, __ATOMIC_ACQUIRE);
+        if (singbox_logtail_read(ctx->writer->region, &ctx->cursor, 64, collect_checked, &ctx->out) < 0) {
+            ctx->errors++;
+        }
+        if (done && ctx->cursor.offset == __atomic_load_n(&ctx->writer->region->head, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers_never_see_torn_records(void) {
+    singbox_logtail_t* region = singbox_logtail_init(small_memory, SMALL_SIZE);
+    writer_ctx_t writer = { region, 200000, 0 };
+    reader_ctx_t readers[3];
+    memset(readers, 0, sizeof(readers));
+
+    pthread_t reader_threads[3], writer_tid;
+    for (int i = 0; i < 3; i++) {
+        readers[i].writer = &writer;
+        pthread_create(&reader_threads[i], NULL, reader_thread, &readers[i]);
+    }
+    pthread_create(&writer_tid, NULL, writer_thread, &writer);
+    pthread_join(writer_tid, NULL);
+
+    uint64_t lost = 0;
+    for (int i = 0; i < 3; i++) {
+        pthread_join(reader_threads[i], NULL);
+        reader_ctx_t* reader = &readers[i];
+        CHECK_EQ_INT(reader->errors, 0);
+        CHECK_EQ_INT(reader->out.corrupt, 0);
+        CHECK_EQ_INT(reader->out.out_of_order, 0);
+        CHECK_EQ_INT(reader->out.last_seq, writer.total);
+        // Every record is either delivered intact or accounted for as lost
+        CHECK_EQ_INT(reader->out.first_seq - 1 + reader->cursor.lost + (uint64_t)reader->out.count, writer.total);
+        lost += reader->cursor.lost;
+    }
+    printf("  readers delivered %d/%d/%d of %llu records, %llu lost in total\n",
+           readers[0].out.count, readers[1].out.count, readers[2].out.count,
+           (unsigned long long)writer.total, (unsigned long long)lost);
+}
+
+static void test_logging_feeds_the_tail(void) {
+    singbox_logging_init();
+    singbox_logging_set_throttle(NULL);
+    size_t size = 0;
+    const singbox_logtail_t* region = singbox_logging_tail_region(&size);
+    CHECK(region != NULL);
+    CHECK_EQ_INT(size, SINGBOX_LOGTAIL_DEFAULT_SIZE);
+    CHECK(singbox_logging_tail_region(NULL) == region);
+
+    singbox_logtail_cursor_t cursor;
+    singbox_logtail_cursor_init(region, &cursor, 1);
+    singbox_log_write(SINGBOX_LOG_WARN, "outbound/vless[proxy]", "dial tcp: i/o timeout", 21);
+    singbox_log(SINGBOX_LOG_DEBUG, "below the level, not recorded");
+
+    collected_t out = {0};
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, &out), 1);
+    CHECK(strcmp(out.module, "outbound/vless[proxy]") == 0);
+    CHECK(strcmp(out.message, "dial tcp: i/o timeout") == 0);
+    CHECK_EQ_INT(out.level, SINGBOX_LOG_WARN);
+
+    // Clearing the logs empties the tail as well
+    singbox_clear_logs();
+    singbox_log(SINGBOX_LOG_INFO, "after clear");
+    singbox_logtail_cursor_init(region, &cursor, 0);
+    memset(&out, 0, sizeof(out));
+    CHECK_EQ_INT(singbox_logtail_read(region, &cursor, 0, collect, &out), 1);
+    CHECK(strstr(out.message, "after clear") != NULL);
+    singbox_logging_cleanup();
+}
+
+int main(void) {
+    RUN_TEST(test_init_validates_memory);
+    RUN_TEST(test_round_trip_and_newest_cursor);
+    RUN_TEST(test_wraps_without_loss_when_kept_up);
+    RUN_TEST(test_overrun_reader_counts_lost_records);
+    RUN_TEST(test_long_fields_are_cut);
+    RUN_TEST(test_corrupt_region_is_reported);
+    RUN_TEST(test_concurrent_readers_never_see_torn_records);
+    RUN_TEST(test_logging_feeds_the_tail);
+    return TEST_EXIT();
+}
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_logging.h"
+#include "sing_box_logthrottle.h"
+#include "test_util.h"
+
+typedef struct {
+    int count;
+    int level;
+    char module[SINGBOX_THROTTLE_MODULE_LEN];
+    char last[512];
+} summary_sink_t;
+
+static void collect(int level, const char* module, const char* message, size_t length, void* ctx) {
+    summary_sink_t* sink = (summary_sink_t*)ctx;
+    sink->count++;
+    sink->level = level;
+    snprintf(sink->module, sizeof(sink->module), "%s", module);
+    snprintf(sink->last, sizeof(sink->last), "%.*s", (int)length, message);
+}
+
+static singbox_logthrottle_t throttle;
+
+static int submit(int64_t now_ms, int level, const char* module, const char* message, summary_sink_t* sink) {
+    return singbox_logthrottle_submit(&throttle, now_ms, level, module, message, strlen(message), collect, sink);
+}
+
+static void test_template_hash(void) {
+    const char* a = "dial tcp 1.2.3.4:443: i/o timeout";
+    const char* b = "dial tcp 10.20.30.40:8443: i/o timeout";
+    const char* c = "dial udp 1.2.3.4:443: i/o timeout";
+    CHECK(singbox_log_template_hash(4, "dns", a, strlen(a)) == singbox_log_template_hash(4, "dns", b, strlen(b)));
+    CHECK(singbox_log_template_hash(4, "dns", a, strlen(a)) != singbox_log_template_hash(4, "dns", c, strlen(c)));
+    CHECK(singbox_log_template_hash(4, "dns", a, strlen(a)) != singbox_log_template_hash(3, "dns", a, strlen(a)));
+    CHECK(singbox_log_template_hash(4, "dns", a, strlen(a)) != singbox_log_template_hash(4, "router", a, strlen(a)));
+    // Hex ids count as numbers
+    const char* d = "connection 3f2a9c10 closed";
+    const char* e = "connection 77aa01bf closed";
+    CHECK(singbox_log_template_hash(2, "", d, strlen(d)) == singbox_log_template_hash(2, "", e, strlen(e)));
+}
+
+static void test_format_duration(void) {
+    char text[32];
+    singbox_format_duration(850, text, sizeof(text));
+    CHECK(strcmp(text, "850ms") == 0);
+    singbox_format_duration(12345, text, sizeof(text));
+    CHECK(strcmp(text, "12.3s") == 0);
+    singbox_format_duration(125000, text, sizeof(text));
+    CHECK(strcmp(text, "2m05s") == 0);
+}
+
+static void test_burst_collapses_into_summary(void) {
+    summary_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    singbox_logthrottle_init(&throttle, NULL);
+
+    // A flapping network: the same error 300 times in 3 seconds
+    int passed = 0;
+    char message[128];
+    for (int i = 0; i < 300; i++) {
+        snprintf(message, sizeof(message), "network change %d: reconnect failed: connection refused", i);
+        passed += submit(1000 + i * 10, SINGBOX_LOG_ERROR, "network", message, &sink);
+    }
+    CHECK_EQ_INT(passed, 1);
+    CHECK_EQ_INT(throttle.stats.collapsed, 299);
+    CHECK_EQ_INT(sink.count, 0);
+
+    // Still inside the burst window: nothing to report yet
+    singbox_logthrottle_flush(&throttle, 5000, 0, collect, &sink);
+    CHECK_EQ_INT(sink.count, 0);
+
+    // Quiet for longer than the window: one summary replaces the repeats
+    singbox_logthrottle_flush(&throttle, 9000, 0, collect, &sink);
+    CHECK_EQ_INT(sink.count, 1);
+    CHECK_EQ_INT(sink.level, SINGBOX_LOG_ERROR);
+    CHECK(strcmp(sink.module, "network") == 0);
+    CHECK(strcmp(sink.last, "network change 0: reconnect failed: connection refused (\xc3\x97" "300 over 3.0s)") == 0);
+    CHECK_EQ_INT(throttle.stats.summaries, 1);
+
+    // A new burst of the same template starts over
+    CHECK(submit(10000, SINGBOX_LOG_ERROR, "network", "network change 301: reconnect failed: connection refused", &sink));
+}
+
+static void test_interleaved_templates(void) {
+    summary_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    singbox_logthrottle_config_t config;
+    singbox_logthrottle_default_config(&config);
+    config.duplicate_pass = 2;
+    singbox_logthrottle_init(&throttle, &config);
+
+    int passed_a = 0, passed_b = 0;
+    for (int i = 0; i < 50; i++) {
+        passed_a += submit(i * 20, SINGBOX_LOG_WARN, "stats", "stats retry 3 failed: timeout", &sink);
+        passed_b += submit(i * 20 + 1, SINGBOX_LOG_WARN, "stats", "stats socket closed", &sink);
+    }
+    CHECK_EQ_INT(passed_a, 2);
+    CHECK_EQ_INT(passed_b, 2);
+
+    // Restarting a stale burst summarises the previous one inline
+    CHECK(submit(20000, SINGBOX_LOG_WARN, "stats", "stats retry 4 failed: timeout", &sink));
+    CHECK(sink.count >= 1);
+    singbox_logthrottle_flush(&throttle, 20000, 1, collect, &sink);
+    CHECK_EQ_INT(throttle.stats.collapsed, 96);
+}
+
+static void test_long_flood_reports_periodically(void) {
+    summary_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    singbox_logthrottle_init(&throttle, NULL);
+
+    // One line every 100 ms for 130 s never leaves the burst window
+    for (int i = 0; i <= 1300; i++) {
+        submit(i * 100, SINGBOX_LOG_ERROR, "dns", "exchange failed: no such host", &sink);
+    }
+    CHECK_EQ_INT(sink.count, 2); // at 60 s and 120 s
+    CHECK(strstr(sink.last, "over 1m00s)") != NULL);
+
+    singbox_logthrottle_flush(&throttle, 130000, 1, collect, &sink);
+    CHECK_EQ_INT(sink.count, 3);
+    CHECK_EQ_INT(throttle.stats.passed, 1);
+}
+
+static void test_module_rate_limit(void) {
+    summary_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    singbox_logthrottle_config_t config;
+    singbox_logthrottle_default_config(&config);
+    config.rate_per_sec = 10;
+    config.rate_burst = 20;
+    singbox_logthrottle_init(&throttle, &config);
+
+    // 100 distinct messages at once from a chatty module
+    static const char* words[] = { "alpha", "bravo", "charlie", "delta", "echo",
+                                   "foxtrot", "golf", "hotel", "india", "juliet" };
+    char message[64];
+    int passed = 0;
+    for (int i = 0; i < 100; i++) {
+        snprintf(message, sizeof(message), "route %s %s", words[i % 10], words[i / 10]);
+        passed += submit(0, SINGBOX_LOG_INFO, "router", message, &sink);
+    }
+    CHECK_EQ_INT(passed, 20);
+    CHECK_EQ_INT(throttle.stats.rate_limited, 80);
+
+    // Other modules keep their own budget, FATAL is never rate limited
+    CHECK(submit(0, SINGBOX_LOG_INFO, "dns", "lookup example.com", &sink));
+    CHECK(submit(0, SINGBOX_LOG_FATAL, "router", "router crashed", &sink));
+
+    // The bucket refills at 10 tokens per second
+    CHECK(submit(500, SINGBOX_LOG_INFO, "router", "route kilo", &sink));
+    CHECK(!submit(500, SINGBOX_LOG_INFO, "router", "route lima", &sink) ||
+          !submit(500, SINGBOX_LOG_INFO, "router", "route mike", &sink) ||
+          !submit(500, SINGBOX_LOG_INFO, "router", "route november", &sink) ||
+          !submit(500, SINGBOX_LOG_INFO, "router", "route oscar", &sink) ||
+          !submit(500, SINGBOX_LOG_INFO, "router", "route papa", &sink));
+
+    singbox_logthrottle_flush(&throttle, 2000, 0, collect, &sink);
+    CHECK_EQ_INT(sink.level, SINGBOX_LOG_WARN);
+    CHECK(strcmp(sink.module, "router") == 0);
+    CHECK(strncmp(sink.last, "rate limited: ", 14) == 0);
+    CHECK(throttle.stats.suppressed_bytes > 0);
+}
+
+static void test_eviction_under_template_churn(void) {
+    summary_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    singbox_logthrottle_config_t config;
+    singbox_logthrottle_default_config(&config);
+    config.rate_per_sec = 0;
+    singbox_logthrottle_init(&throttle, &config);
+
+    char message[64];
+    for (int i = 0; i < 2000; i++) {
+        // Letters only, so every message is its own template
+        snprintf(message, sizeof(message), "template %c%c%c", 'a' + i % 26, 'a' + (i / 26) % 26, 'a' + i / 676);
+        CHECK(submit(i, SINGBOX_LOG_WARN, "core", message, &sink));
+    }
+    CHECK(throttle.stats.evictions > 0);
+    CHECK_EQ_INT(throttle.stats.passed, 2000);
+}
+
+static void test_logging_integration(void) {
+    singbox_logging_init();
+    singbox_set_log_level(SINGBOX_LOG_TRACE);
+
+    for (int i = 0; i < 500; i++) {
+        singbox_log(SINGBOX_LOG_ERROR, "stats fetch attempt %d failed: connection reset", i);
+    }
+    int entries = 0;
+    singbox_get_log_stats(&entries, NULL);
+    CHECK_EQ_INT(entries, 1); // The 1000-slot ring keeps its history
+
+    singbox_logging_flush_throttle(1);
+    char* json = singbox_query_logs_json("stats fetch", 0, 0);
+    CHECK(json != NULL);
+    CHECK(json && strstr(json, "\"total\":2") != NULL);
+    CHECK(json && strstr(json, "(\xc3\x97" "500 over") != NULL);
+    free(json);
+
+    singbox_logthrottle_stats_t stats;
+    singbox_logging_get_throttle_stats(&stats);
+    CHECK_EQ_INT(stats.collapsed, 499);
+    CHECK_EQ_INT(stats.summaries, 1);
+
+    // Disabled suppression passes everything
+    singbox_logging_set_throttle(NULL);
+    for (int i = 0; i < 10; i++) {
+        singbox_log(SINGBOX_LOG_ERROR, "stats fetch attempt %d failed: connection reset", i);
+    }
+    singbox_get_log_stats(&entries, NULL);
+    CHECK_EQ_INT(entries, 12);
+
+    singbox_logging_cleanup();
+}
+
+int main(void) {
+    RUN_TEST(test_template_hash);
+    RUN_TEST(test_format_duration);
+    RUN_TEST(test_burst_collapses_into_summary);
+    RUN_TEST(test_interleaved_templates);
+    RUN_TEST(test_long_flood_reports_periodically);
+    RUN_TEST(test_module_rate_limit);
+    RUN_TEST(test_eviction_under_template_churn);
+    RUN_TEST(test_logging_integration);
+    return TEST_EXIT();
+}
@@ -0,0 +1,230 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MessageCoalescer.h"
+#include "test_util.h"
+
+/*
+ * The coalescing queue of the Windows runner's PlatformDispatcher. A fake
+ * owner records the drain requests; the bursty test drains them on a
+ * thread of its own standing in for the platform thread.
+ */
+
+struct Payload {
+    int producer;
+    int seq;
+};
+
+using Coalescer = MessageCoalescer<Payload>;
+
+struct ScheduleLog {
+    std::vector<int64_t> delays;
+};
+
+static Coalescer make_coalescer(ScheduleLog* log) {
+    return Coalescer([log](int64_t delay_ms) { log->delays.push_back(delay_ms); });
+}
+
+static void test_latest_values_coalesce(void) {
+    ScheduleLog log;
+    Coalescer coalescer = make_coalescer(&log);
+    for (int i = 0; i < 1000; i++) {
+        coalescer.PostLatest(100, "onStatsUpdate", Payload{0, i});
+        coalescer.PostLatest(100, "onStatusUpdate", Payload{0, i});
+    }
+    // One wake-up for the whole burst, due at once since nothing was drained yet
+    CHECK_EQ_INT(log.delays.size(), 1);
+    CHECK_EQ_INT(log.delays[0], 0);
+
+    auto batch = coalescer.Drain(100);
+    CHECK_EQ_INT(batch.size(), 2);
+    CHECK(batch[0].method == "onStatsUpdate");
+    CHECK_EQ_INT(batch[0].payload.seq, 999);
+    CHECK(batch[1].method == "onStatusUpdate");
+    CHECK_EQ_INT(batch[1].payload.seq, 999);
+    CHECK_EQ_INT(coalescer.Drain(101).size(), 0);
+
+    Coalescer::Stats stats = coalescer.GetStats();
+    CHECK_EQ_INT(stats.posted, 2000);
+    CHECK_EQ_INT(stats.coalesced, 1998);
+    CHECK_EQ_INT(stats.delivered, 2);
+    CHECK_EQ_INT(stats.batches, 1);
+    CHECK_EQ_INT(stats.schedules, 1);
+}
+
+static void test_every_messages_keep_order(void) {
+    ScheduleLog log;
+    Coalescer coalescer = make_coalescer(&log);
+    coalescer.PostLatest(0, "onStatusUpdate", Payload{0, 1});
+    coalescer.PostEvery(0, "onError", Payload{0, 2});
+    coalescer.PostLatest(0, "onStatsUpdate", Payload{0, 3});
+    coalescer.PostEvery(0, "onError", Payload{0, 4});
+    coalescer.PostLatest(0, "onStatusUpdate", Payload{0, 5});
+
+    // A state keeps the slot of its first post but carries the newest value
+    auto batch = coalescer.Drain(0);
+    CHECK_EQ_INT(batch.size(), 4);
+    CHECK(batch[0].method == "onStatusUpdate");
+    CHECK_EQ_INT(batch[0].payload.seq, 5);
+    CHECK(batch[1].method == "onError");
+    CHECK_EQ_INT(batch[1].payload.seq, 2);
+    CHECK(batch[2].method == "onStatsUpdate");
+    CHECK(batch[3].method == "onError");
+    CHECK_EQ_INT(batch[3].payload.seq, 4);
+
+    // Past the cap further events are dropped, states still coalesce
+    for (int i = 0; i < (int)Coalescer::kMaxQueued + 44; i++) {
+        coalescer.PostEvery(10, "onError", Payload{0, i});
+    }
+    coalescer.PostLatest(10, "onStatusUpdate", Payload{0, 7});
+    batch = coalescer.Drain(30);
+    CHECK_EQ_INT(batch.size(), Coalescer::kMaxQueued + 1);
+    CHECK_EQ_INT(batch[Coalescer::kMaxQueued - 1].payload.seq, Coalescer::kMaxQueued - 1);
+    CHECK(batch.back().method == "onStatusUpdate");
+    CHECK_EQ_INT(coalescer.GetStats().dropped, 44);
+}
+
+static void test_drains_are_paced_by_frame(void) {
+    ScheduleLog log;
+    Coalescer coalescer = make_coalescer(&log);
+    coalescer.PostLatest(1000, "onStatsUpdate", Payload{0, 0});
+    coalescer.Drain(1000);
+
+    // Within the frame: wait out the rest of it
+    coalescer.PostLatest(1005, "onStatsUpdate", Payload{0, 1});
+    coalescer.PostLatest(1010, "onStatsUpdate", Payload{0, 2});
+    CHECK_EQ_INT(log.delays.size(), 2);
+    CHECK_EQ_INT(log.delays[1], Coalescer::kDefaultFrameMs - 5);
+    coalescer.Drain(1016);
+
+    // A frame or more later: right away
+    coalescer.PostLatest(1040, "onStatusUpdate", Payload{0, 3});
+    CHECK_EQ_INT(log.delays.size(), 3);
+    CHECK_EQ_INT(log.delays[2], 0);
+}
+
+/**
+ * Producers hammer stats and status from several threads while a platform
+ * thread drains on request, honouring the requested delays against a real
+ * clock. Every error must arrive once; states arrive far less often than
+ * they are posted, and never out of order per producer.
+ */
+static void test_bursty_producers(void) {
+    const int kProducers = 4;
+    const int kPosts = 20000;
+    const int kErrors = 50;
+    const auto start = std::chrono::steady_clock::now();
+    auto now_ms = [start]() {
+        return (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::vector<int64_t> due;   // Drain deadlines requested by the coalescer
+    Coalescer coalescer([&](int64_t delay_ms) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        due.push_back(now_ms() + delay_ms);
+        wake.notify_one();
+    });
+
+    std::atomic<bool> producing{true};
+    uint64_t batches = 0, delivered = 0, errors = 0;
+    int64_t first_batch_ms = -1, last_batch_ms = 0;
+    int last_seq[kProducers][2];
+    int out_of_order = 0;
+    for (int p = 0; p < kProducers; p++) {
+        last_seq[p][0] = last_seq[p][1] = -1;
+    }
+
+    std::thread platform([&]() {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(50), [&]() { return !due.empty(); });
+            if (due.empty()) {
+                if (!producing) {
+                    break;
+                }
+                continue;
+            }
+            int64_t deadline = due.front();
+            due.erase(due.begin());
+            lock.unlock();
+            int64_t wait = deadline - now_ms();
+            if (wait > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+            }
+
+            auto batch = coalescer.Drain(now_ms());
+            if (batch.empty()) {
+                continue;
+            }
+            batches++;
+            if (first_batch_ms < 0) {
+                first_batch_ms = now_ms();
+            }
+            last_batch_ms = now_ms();
+            for (const auto& message : batch) {
+                delivered++;
+                if (message.method == "onError") {
+                    errors++;
+                    continue;
+                }
+                int kind = message.method == "onStatsUpdate" ? 0 : 1;
+                // The newest value of one producer may be replaced by another's,
+                // but a producer's own values never go backwards
+                int* last = &last_seq[message.payload.producer][kind];
+                out_of_order += message.payload.seq <= *last;
+                *last = message.payload.seq;
+            }
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kPosts; i++) {
+                coalescer.PostLatest(now_ms(), i & 1 ? "onStatusUpdate" : "onStatsUpdate", Payload{p, i});
+                if (i % (kPosts / kErrors) == 0) {
+                    coalescer.PostEvery(now_ms(), "onError", Payload{p, i});
+                }
+                if (i % 200 == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Bursts
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    producing = false;
+    platform.join();
+
+    Coalescer::Stats stats = coalescer.GetStats();
+    CHECK_EQ_INT(stats.posted, kProducers * (kPosts + kErrors));
+    CHECK_EQ_INT(stats.dropped, 0);
+    CHECK_EQ_INT(errors, kProducers * kErrors);
+    CHECK_EQ_INT(stats.delivered, delivered);
+    CHECK_EQ_INT(out_of_order, 0);
+    // At most two states plus the errors per batch
+    CHECK(delivered <= batches * 2 + errors);
+    CHECK(delivered * 20 < stats.posted);
+    // One batch per frame at most
+    int64_t span = last_batch_ms - first_batch_ms;
+    CHECK(batches <= (uint64_t)(span / Coalescer::kDefaultFrameMs) + 2);
+    printf("    %llu posts -> %llu messages in %llu batches over %lld ms\n",
+           (unsigned long long)stats.posted, (unsigned long long)delivered,
+           (unsigned long long)batches, (long long)span);
+}
+
+int main(void) {
+    RUN_TEST(test_latest_values_coalesce);
+    RUN_TEST(test_every_messages_keep_order);
+    RUN_TEST(test_drains_are_paced_by_frame);
+    RUN_TEST(test_bursty_producers);
+    return TEST_EXIT();
+}
@@ -0,0 +1,221 @@
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network_change_detector.h"
+#include "test_util.h"
+
+/*
+ * The Linux runner's netlink NetworkChangeDetector. Link, address and
+ * route messages are built here the way the kernel lays them out and fed
+ * through ProcessMessages; the live test only subscribes and unsubscribes
+ * on a running Reactor, which needs no privileges.
+ */
+
+class MessageBuilder {
+public:
+    void Link(uint16_t type, int index, const char* name, unsigned flags) {
+        size_t start = Begin(type, sizeof(ifinfomsg));
+        ifinfomsg* info = reinterpret_cast<ifinfomsg*>(&buffer_[start + NLMSG_HDRLEN]);
+        info->ifi_family = AF_UNSPEC;
+        info->ifi_index = index;
+        info->ifi_flags = flags;
+        Attribute(start, IFLA_IFNAME, name, strlen(name) + 1);
+    }
+
+    void Address(uint16_t type, int index) {
+        size_t start = Begin(type, sizeof(ifaddrmsg));
+        ifaddrmsg* info = reinterpret_cast<ifaddrmsg*>(&buffer_[start + NLMSG_HDRLEN]);
+        info->ifa_family = AF_INET;
+        info->ifa_index = static_cast<uint32_t>(index);
+    }
+
+    void DefaultRoute(uint16_t type, uint32_t table, int output) {
+        size_t start = Begin(type, sizeof(rtmsg));
+        rtmsg* route = reinterpret_cast<rtmsg*>(&buffer_[start + NLMSG_HDRLEN]);
+        route->rtm_family = AF_INET;
+        route->rtm_table = static_cast<uint8_t>(table < 256 ? table : RT_TABLE_UNSPEC);
+        route->rtm_type = RTN_UNICAST;
+        Attribute(start, RTA_TABLE, &table, sizeof(table));
+        Attribute(start, RTA_OIF, &output, sizeof(output));
+    }
+
+    const void* data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    void Clear() { buffer_.clear(); }
+
+private:
+    size_t Begin(uint16_t type, size_t payload) {
+        size_t start = buffer_.size();
+        buffer_.resize(start + NLMSG_SPACE(payload));
+        nlmsghdr* header = reinterpret_cast<nlmsghdr*>(&buffer_[start]);
+        header->nlmsg_len = NLMSG_LENGTH(payload);
+        header->nlmsg_type = type;
+        return start;
+    }
+
+    void Attribute(size_t start, uint16_t type, const void* value, size_t length) {
+        size_t at = buffer_.size();
+        buffer_.resize(at + RTA_SPACE(length));
+        rtattr* attribute = reinterpret_cast<rtattr*>(&buffer_[at]);
+        attribute->rta_type = type;
+        attribute->rta_len = static_cast<unsigned short>(RTA_LENGTH(length));
+        memcpy(RTA_DATA(attribute), value, length);
+        reinterpret_cast<nlmsghdr*>(&buffer_[start])->nlmsg_len =
+            static_cast<uint32_t>(buffer_.size() - start);
+    }
+
+    std::vector<char> buffer_;
+};
+
+static const unsigned kUp = IFF_UP | IFF_RUNNING;
+
+struct Recorder {
+    std::vector<std::string> reasons;
+    NetworkState last = NetworkState::Unknown;
+
+    void Attach(NetworkChangeDetector& detector) {
+        detector.SetChangeCallback([this](NetworkState state, const std::string& reason) {
+            last = state;
+            reasons.push_back(reason);
+        });
+    }
+};
+
+static void test_links_decide_the_state(void) {
+    Reactor reactor;
+    NetworkChangeDetector detector("tun0", reactor);
+    Recorder recorder;
+    recorder.Attach(detector);
+    MessageBuilder messages;
+    messages.Link(RTM_NEWLINK, 1, "lo", kUp | IFF_LOOPBACK);
+    messages.Link(RTM_NEWLINK, 2, "eth0", IFF_UP);
+    CHECK(!detector.ProcessMessages(messages.data(), messages.size()));
+    detector.DeliverPending();
+    CHECK(recorder.reasons.empty());
+
+    messages.Clear();
+    messages.Link(RTM_NEWLINK, 2, "eth0", kUp);
+    CHECK(detector.ProcessMessages(messages.data(), messages.size()));
+    CHECK(detector.GetNetworkState() == NetworkState::Connected);
+    CHECK(detector.GetActiveInterfaces() == "eth0");
+    detector.DeliverPending();
+    CHECK_EQ_INT(recorder.reasons.size(), 1);
+    CHECK(recorder.reasons[0] == "link eth0 up");
+    CHECK(recorder.last == NetworkState::Connected);
+
+    // The same state again (a counter update) is not news
+    CHECK(!detector.ProcessMessages(messages.data(), messages.size()));
+
+    messages.Clear();
+    messages.Link(RTM_DELLINK, 2, "eth0", 0);
+    CHECK(detector.ProcessMessages(messages.data(), messages.size()));
+    detector.DeliverPending();
+    CHECK(recorder.last == NetworkState::Disconnected);
+    CHECK(recorder.reasons.back() == "link eth0 down");
+}
+
+/**
+ * sing-box bringing its device up, addressing it and routing through it
+ * is what connecting looks like; none of it may look like a network change
+ */
+static void test_tunnel_is_ignored(void) {
+    Reactor reactor;
+    NetworkChangeDetector detector("tun0", reactor);
+    Recorder recorder;
+    recorder.Attach(detector);
+    MessageBuilder messages;
+    messages.Link(RTM_NEWLINK, 2, "wlan0", kUp);
+    detector.ProcessMessages(messages.data(), messages.size());
+    detector.DeliverPending();
+    recorder.reasons.clear();
+
+    messages.Clear();
+    messages.Link(RTM_NEWLINK, 9, "tun0", kUp);
+    messages.Address(RTM_NEWADDR, 9);
+    messages.DefaultRoute(RTM_NEWROUTE, RT_TABLE_MAIN, 9);
+    messages.DefaultRoute(RTM_NEWROUTE, 2022, 9);
+    messages.Link(RTM_DELLINK, 9, "tun0", 0);
+    CHECK(!detector.ProcessMessages(messages.data(), messages.size()));
+    detector.DeliverPending();
+    CHECK(recorder.reasons.empty());
+    CHECK(detector.GetActiveInterfaces() == "wlan0");
+
+    // The same kinds of messages about the real interface count
+    messages.Clear();
+    messages.Address(RTM_NEWADDR, 2);
+    CHECK(detector.ProcessMessages(messages.data(), messages.size()));
+    messages.Clear();
+    messages.DefaultRoute(RTM_DELROUTE, RT_TABLE_MAIN, 2);
+    CHECK(detector.ProcessMessages(messages.data(), messages.size()));
+}
+
+static void test_burst_is_one_notification(void) {
+    Reactor reactor;
+    NetworkChangeDetector detector("tun0", reactor);
+    Recorder recorder;
+    recorder.Attach(detector);
+    MessageBuilder messages;
+    messages.Link(RTM_NEWLINK, 2, "wlan0", kUp);
+    messages.Address(RTM_NEWADDR, 2);
+    messages.Address(RTM_NEWADDR, 2);
+    messages.DefaultRoute(RTM_NEWROUTE, RT_TABLE_MAIN, 2);
+    CHECK(detector.ProcessMessages(messages.data(), messages.size()));
+    detector.DeliverPending();
+    detector.DeliverPending();
+    CHECK_EQ_INT(recorder.reasons.size(), 1);
+    // The latest event names the burst
+    CHECK(recorder.reasons[0] == "default route added");
+    NetworkChangeDetector::Stats stats = detector.GetStats();
+    CHECK_EQ_INT(stats.messages, 4);
+    CHECK_EQ_INT(stats.relevant, 4);
+    CHECK_EQ_INT(stats.notifications, 1);
+}
+
+/**
+ * Subscribing reads the current links without reporting them as a change,
+ * the idle monitor does not wake up, and stopping is prompt
+ */
+static void test_live_monitor_is_quiet(void) {
+    Reactor reactor;
+    CHECK(reactor.Start());
+    NetworkChangeDetector detector("tun0", reactor);
+    Recorder recorder;
+    recorder.Attach(detector);
+    if (!detector.StartMonitoring()) {
+        printf("    netlink unavailable here; skipped\n");
+        return;
+    }
+    CHECK(detector.IsMonitoring());
+    CHECK(detector.GetNetworkState() != NetworkState::Unknown);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    NetworkChangeDetector::Stats stats = detector.GetStats();
+    CHECK(stats.messages > 0);  // The loopback link at least
+    // Nothing changed, so nothing woke the reactor (barring real traffic on the host)
+    CHECK(stats.wakeups <= 2 * stats.notifications + 1);
+    CHECK_EQ_INT(reactor.GetStats().fds, 1);
+    CHECK(recorder.reasons.size() <= stats.notifications);
+
+    uint64_t begin = test_now_ns();
+    detector.StopMonitoring();
+    CHECK(test_now_ns() - begin < 100000000ull);
+    CHECK(!detector.IsMonitoring());
+    CHECK(detector.GetNetworkState() == NetworkState::Unknown);
+    Reactor::Stats reactor_stats = reactor.GetStats();
+    CHECK_EQ_INT(reactor_stats.fds, 0);
+    CHECK_EQ_INT(reactor_stats.timers, 0);
+}
+
+int main(void) {
+    RUN_TEST(test_links_decide_the_state);
+    RUN_TEST(test_tunnel_is_ignored);
+    RUN_TEST(test_burst_is_one_notification);
+    RUN_TEST(test_live_monitor_is_quiet);
+    return TEST_EXIT();
+}
@@ -0,0 +1,417 @@
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sing_box_notify.h"
+#include "sing_box_notify_jni.h"
+#include "test_util.h"
+
+/*
+ * The push notifier: coalescing, rate limiting and idle behaviour against a
+ * recording sink, then the JNI sink against a fake JVM (fake_jni/jni.h).
+ */
+
+static void wait_ms(int ms) {
+    usleep((useconds_t)ms * 1000);
+}
+
+// Polls `cond` for up to a second
+#define WAIT_FOR(cond) do { \
+    for (int _i = 0; _i < 200 && !(cond); _i++) { \
+        wait_ms(5); \
+    } \
+} while (0)
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int attaches;
+    int detaches;
+    int stats_calls;
+    int state_calls;
+    int64_t last_upload;
+    int last_state;
+    int states[16];
+    int on_notifier_thread;
+    int block_first_state_ms;
+} recorder_t;
+
+static recorder_t recorder;
+
+static void reset_recorder(void) {
+    memset(&recorder, 0, sizeof(recorder));
+    pthread_mutex_init(&recorder.mutex, NULL);
+}
+
+static pthread_t main_thread;
+
+static void rec_attach(void* ctx) {
+    recorder_t* r = ctx;
+    pthread_mutex_lock(&r->mutex);
+    r->attaches++;
+    r->on_notifier_thread = !pthread_equal(pthread_self(), main_thread);
+    pthread_mutex_unlock(&r->mutex);
+}
+
+static void rec_detach(void* ctx) {
+    recorder_t* r = ctx;
+    pthread_mutex_lock(&r->mutex);
+    r->detaches++;
+    pthread_mutex_unlock(&r->mutex);
+}
+
+static void rec_stats(void* ctx, const singbox_stats_values_t* values) {
+    recorder_t* r = ctx;
+    pthread_mutex_lock(&r->mutex);
+    r->stats_calls++;
+    r->last_upload = values->upload_bytes;
+    pthread_mutex_unlock(&r->mutex);
+}
+
+static void rec_state(void* ctx, int state) {
+    recorder_t* r = ctx;
+    pthread_mutex_lock(&r->mutex);
+    int block = r->state_calls == 0 ? r->block_first_state_ms : 0;
+    if (r->state_calls < 16) {
+        r->states[r->state_calls] = state;
+    }
+    r->state_calls++;
+    r->last_state = state;
+    pthread_mutex_unlock(&r->mutex);
+    if (block) {
+        wait_ms(block);
+    }
+}
+
+static int read_int(int* field) {
+    pthread_mutex_lock(&recorder.mutex);
+    int value = *field;
+    pthread_mutex_unlock(&recorder.mutex);
+    return value;
+}
+
+static const singbox_notify_sink_t recording_sink = {
+    rec_attach, rec_detach, rec_stats, rec_state, &recorder
+};
+
+static void post_upload(int64_t upload) {
+    singbox_stats_values_t values;
+    memset(&values, 0, sizeof(values));
+    values.upload_bytes = upload;
+    singbox_notify_post_stats(&values);
+}
+
+static void test_posts_without_sink_are_dropped(void) {
+    singbox_notify_stats_t before, after;
+    singbox_notify_get_stats(&before);
+    post_upload(1);
+    singbox_notify_post_state(2);
+    singbox_notify_get_stats(&after);
+    CHECK(!after.active);
+    CHECK_EQ_INT(after.stats_posted, before.stats_posted);
+    CHECK_EQ_INT(after.states_posted, before.states_posted);
+}
+
+static void test_stats_are_coalesced_and_rate_limited(void) {
+    reset_recorder();
+    CHECK(singbox_notify_start(&recording_sink, 100));
+    WAIT_FOR(read_int(&recorder.attaches) == 1);
+    CHECK_EQ_INT(read_int(&recorder.attaches), 1);
+    CHECK(recorder.on_notifier_thread);
+
+    // A burst well inside one interval: the first post goes out at once,
+    // everything after it collapses into one delivery of the latest values
+    uint64_t start = test_now_ns();
+    for (int i = 1; i <= 10000; i++) {
+        post_upload(i);
+    }
+    WAIT_FOR(read_int(&recorder.stats_calls) >= 2);
+    uint64_t elapsed_ms = (test_now_ns() - start) / 1000000;
+    wait_ms(150);
+    CHECK(read_int(&recorder.stats_calls) <= 3);
+    pthread_mutex_lock(&recorder.mutex);
+    CHECK_EQ_INT(recorder.last_upload, 10000);
+    pthread_mutex_unlock(&recorder.mutex);
+    CHECK(elapsed_ms >= 80); // The second delivery waited for the interval
+
+    singbox_notify_stats_t stats;
+    singbox_notify_get_stats(&stats);
+    CHECK(stats.active);
+    CHECK_EQ_INT(stats.interval_ms, 100);
+    CHECK_EQ_INT(stats.stats_posted, 10000);
+    CHECK_EQ_INT(stats.stats_delivered, read_int(&recorder.stats_calls));
+
+    singbox_notify_stop();
+    CHECK_EQ_INT(read_int(&recorder.detaches), 1);
+}
+
+static void test_state_changes_are_prompt_and_coalesced(void) {
+    reset_recorder();
+    recorder.block_first_state_ms = 100;
+    CHECK(singbox_notify_start(&recording_sink, 10000));
+
+    // Not held back by the (long) stats interval
+    uint64_t start = test_now_ns();
+    singbox_notify_post_state(1);
+    WAIT_FOR(read_int(&recorder.state_calls) == 1);
+    CHECK((test_now_ns() - start) / 1000000 < 500);
+
+    // Transitions posted while the sink is busy collapse to the latest
+    singbox_notify_post_state(2);
+    singbox_notify_post_state(3);
+    singbox_notify_post_state(0);
+    WAIT_FOR(read_int(&recorder.state_calls) == 2);
+    wait_ms(20);
+    CHECK_EQ_INT(read_int(&recorder.state_calls), 2);
+    CHECK_EQ_INT(recorder.states[0], 1);
+    CHECK_EQ_INT(recorder.states[1], 0);
+
+    // A shorter interval releases stats already waiting
+    post_upload(7);
+    WAIT_FOR(read_int(&recorder.stats_calls) == 1);
+    post_upload(8);
+    wait_ms(20);
+    CHECK_EQ_INT(read_int(&recorder.stats_calls), 1);
+    singbox_notify_set_interval(0);
+    WAIT_FOR(read_int(&recorder.stats_calls) == 2);
+    CHECK_EQ_INT(read_int(&recorder.stats_calls), 2);
+
+    singbox_notify_stop();
+}
+
+static void test_idle_notifier_does_not_wake(void) {
+    reset_recorder();
+    CHECK(singbox_notify_start(&recording_sink, 20));
+    post_upload(1);
+    WAIT_FOR(read_int(&recorder.stats_calls) == 1);
+    wait_ms(20);
+
+    singbox_notify_stats_t before, after;
+    singbox_notify_get_stats(&before);
+    wait_ms(200);
+    singbox_notify_get_stats(&after);
+    CHECK_EQ_INT(after.wakeups, before.wakeups);
+
+    // Replacing the sink stops the old thread first
+    recorder_t* old = &recorder;
+    CHECK(singbox_notify_start(&recording_sink, 20));
+    CHECK_EQ_INT(read_int(&old->detaches), 1);
+    singbox_notify_stop();
+    singbox_notify_stop(); // Idempotent
+    CHECK_EQ_INT(read_int(&recorder.detaches), 2);
+}
+
+/* ---- Fake JVM ---- */
+
+static struct {
+    pthread_mutex_t mutex;
+    int class_missing;
+    int global_refs;
+    int attaches;
+    int detaches;
+    int stats_calls;
+    int state_calls;
+    int throw_next;
+    int pending_exception;
+    int exceptions_cleared;
+    jlong stats_args[5];
+    jdouble speed_args[2];
+    jint last_state;
+    jobject last_target;
+} jvm;
+
+static int fake_class_token, fake_listener_token;
+static struct _jmethodID { int id; } stats_method_id = { 1 }, state_method_id = { 2 };
+
+static jclass fake_find_class(JNIEnv* env, const char* name) {
+    (void)env;
+    if (jvm.class_missing || strcmp(name, SINGBOX_LISTENER_CLASS) != 0) {
+        jvm.pending_exception = 1;
+        return NULL;
+    }
+    return &fake_class_token;
+}
+
+static jobject fake_new_global_ref(JNIEnv* env, jobject obj) {
+    (void)env;
+    __atomic_add_fetch(&jvm.global_refs, 1, __ATOMIC_RELAXED);
+    return obj;
+}
+
+static void fake_delete_global_ref(JNIEnv* env, jobject obj) {
+    (void)env;
+    (void)obj;
+    __atomic_sub_fetch(&jvm.global_refs, 1, __ATOMIC_RELAXED);
+}
+
+static void fake_delete_local_ref(JNIEnv* env, jobject obj) {
+    (void)env;
+    (void)obj;
+}
+
+static jmethodID fake_get_method_id(JNIEnv* env, jclass cls, const char* name, const char* sig) {
+    (void)env;
+    (void)cls;
+    if (strcmp(name, "onNativeStats") == 0 && strcmp(sig, "(JJDDJJJ)V") == 0) {
+        return &stats_method_id;
+    }
+    if (strcmp(name, "onNativeStateChanged") == 0 && strcmp(sig, "(I)V") == 0) {
+        return &state_method_id;
+    }
+    return NULL;
+}
+
+static void fake_call_void_method(JNIEnv* env, jobject obj, jmethodID method, ...) {
+    (void)env;
+    va_list args;
+    va_start(args, method);
+    pthread_mutex_lock(&jvm.mutex);
+    jvm.last_target = obj;
+    if (method == &stats_method_id) {
+        jvm.stats_args[0] = va_arg(args, jlong);
+        jvm.stats_args[1] = va_arg(args, jlong);
+        jvm.speed_args[0] = va_arg(args, jdouble);
+        jvm.speed_args[1] = va_arg(args, jdouble);
+        jvm.stats_args[2] = va_arg(args, jlong);
+        jvm.stats_args[3] = va_arg(args, jlong);
+        jvm.stats_args[4] = va_arg(args, jlong);
+        jvm.stats_calls++;
+    } else if (method == &state_method_id) {
+        jvm.last_state = va_arg(args, jint);
+        jvm.state_calls++;
+    }
+    if (jvm.throw_next) {
+        jvm.throw_next = 0;
+        jvm.pending_exception = 1;
+    }
+    pthread_mutex_unlock(&jvm.mutex);
+    va_end(args);
+}
+
+static jboolean fake_exception_check(JNIEnv* env) {
+    (void)env;
+    return jvm.pending_exception ? JNI_TRUE : JNI_FALSE;
+}
+
+static void fake_exception_describe(JNIEnv* env) {
+    (void)env;
+}
+
+static void fake_exception_clear(JNIEnv* env) {
+    (void)env;
+    if (jvm.pending_exception) {
+        jvm.exceptions_cleared++;
+    }
+    jvm.pending_exception = 0;
+}
+
+static const struct JNINativeInterface fake_env_table = {
+    fake_find_class, fake_new_global_ref, fake_delete_global_ref, fake_delete_local_ref,
+    fake_get_method_id, fake_call_void_method, fake_exception_check, fake_exception_describe,
+    fake_exception_clear
+};
+static JNIEnv fake_env = &fake_env_table;
+
+static jint fake_get_env(JavaVM* vm, void** env, jint version) {
+    (void)vm;
+    (void)version;
+    *env = &fake_env;
+    return JNI_OK;
+}
+
+static jint fake_attach(JavaVM* vm, JNIEnv** env, void* args) {
+    (void)vm;
+    (void)args;
+    __atomic_add_fetch(&jvm.attaches, 1, __ATOMIC_RELAXED);
+    *env = &fake_env;
+    return JNI_OK;
+}
+
+static jint fake_detach(JavaVM* vm) {
+    (void)vm;
+    __atomic_add_fetch(&jvm.detaches, 1, __ATOMIC_RELAXED);
+    return JNI_OK;
+}
+
+static const struct JNIInvokeInterface fake_vm_table = { fake_get_env, fake_attach, fake_detach };
+static JavaVM fake_vm = &fake_vm_table;
+
+static int jvm_int(int* field) {
+    pthread_mutex_lock(&jvm.mutex);
+    int value = *field;
+    pthread_mutex_unlock(&jvm.mutex);
+    return value;
+}
+
+static void reset_jvm(void) {
+    memset(&jvm, 0, sizeof(jvm));
+    pthread_mutex_init(&jvm.mutex, NULL);
+}
+
+static void test_jni_listener_receives_pushes(void) {
+    reset_jvm();
+    CHECK(singbox_notify_jni_on_load(&fake_vm, &fake_env));
+    CHECK_EQ_INT(jvm.global_refs, 1); // The listener class
+
+    CHECK(singbox_notify_jni_set_listener(&fake_env, &fake_listener_token, 0));
+    CHECK_EQ_INT(jvm.global_refs, 2);
+
+    singbox_stats_values_t values = { 2, 1000, 2000, 15, 31, 100.5, 200.25, 1700000000000LL, 0, 0 };
+    singbox_notify_post_state(2);
+    singbox_notify_post_stats(&values);
+    WAIT_FOR(jvm_int(&jvm.stats_calls) == 1 && jvm_int(&jvm.state_calls) == 1);
+    pthread_mutex_lock(&jvm.mutex);
+    CHECK_EQ_INT(jvm.state_calls, 1);
+    CHECK_EQ_INT(jvm.last_state, 2);
+    CHECK_EQ_INT(jvm.stats_calls, 1);
+    CHECK_EQ_INT(jvm.stats_args[0], 1000);
+    CHECK_EQ_INT(jvm.stats_args[1], 2000);
+    CHECK(jvm.speed_args[0] == 100.5 && jvm.speed_args[1] == 200.25);
+    CHECK_EQ_INT(jvm.stats_args[2], 15);
+    CHECK_EQ_INT(jvm.stats_args[3], 31);
+    CHECK_EQ_INT(jvm.stats_args[4], 1700000000000LL);
+    CHECK(jvm.last_target == &fake_listener_token);
+    jvm.throw_next = 1;
+    pthread_mutex_unlock(&jvm.mutex);
+
+    // A throwing listener is cleared and does not stop later pushes
+    singbox_notify_post_state(3);
+    WAIT_FOR(jvm_int(&jvm.exceptions_cleared) == 1);
+    CHECK_EQ_INT(jvm_int(&jvm.exceptions_cleared), 1);
+    singbox_notify_post_state(0);
+    WAIT_FOR(jvm_int(&jvm.state_calls) == 3);
+    CHECK_EQ_INT(jvm_int(&jvm.state_calls), 3);
+
+    // The notifier attached once for all deliveries
+    CHECK_EQ_INT(jvm.attaches, 1);
+    CHECK(singbox_notify_jni_set_listener(&fake_env, NULL, 0));
+    CHECK_EQ_INT(jvm.detaches, 1);
+    CHECK_EQ_INT(jvm.global_refs, 1);
+
+    singbox_notify_jni_on_unload(&fake_env);
+    CHECK_EQ_INT(jvm.global_refs, 0);
+}
+
+static void test_jni_missing_listener_class(void) {
+    reset_jvm();
+    jvm.class_missing = 1;
+    CHECK(!singbox_notify_jni_on_load(&fake_vm, &fake_env));
+    CHECK(!jvm.pending_exception);
+    CHECK(!singbox_notify_jni_set_listener(&fake_env, &fake_listener_token, 1000));
+    CHECK(singbox_notify_jni_set_listener(&fake_env, NULL, 0));
+    CHECK_EQ_INT(jvm.global_refs, 0);
+    CHECK_EQ_INT(jvm.attaches, 0);
+    singbox_notify_jni_on_unload(&fake_env);
+}
+
+int main(void) {
+    main_thread = pthread_self();
+    RUN_TEST(test_posts_without_sink_are_dropped);
+    RUN_TEST(test_stats_are_coalesced_and_rate_limited);
+    RUN_TEST(test_state_changes_are_prompt_and_coalesced);
+    RUN_TEST(test_idle_notifier_does_not_wake);
+    RUN_TEST(test_jni_listener_receives_pushes);
+    RUN_TEST(test_jni_missing_listener_class);
+    return TEST_EXIT();
+}
@@ -0,0 +1,300 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sing_box_procstat.h"
+#include "test_util.h"
+
+/*
+ * /proc sampling against a synthetic child with known memory, descriptor
+ * and thread usage
+ */
+
+#define CHILD_HEAP_MB 32
+#define CHILD_EXTRA_FDS 20
+
+// Keeps the child's heap observable so the fill is not optimised away
+static char* volatile child_heap;
+
+// Threads wait on `arg` after naming themselves, when it is given
+static void* busy_thread(void* arg) {
+    prctl(PR_SET_NAME, "busy", 0, 0, 0);
+    if (arg) {
+        pthread_barrier_wait(arg);
+    }
+    volatile uint64_t counter = 0;
+    for (;;) {
+        counter++;
+    }
+    return NULL;
+}
+
+static void* idle_thread(void* arg) {
+    prctl(PR_SET_NAME, "idle", 0, 0, 0);
+    if (arg) {
+        pthread_barrier_wait(arg);
+    }
+    for (;;) {
+        pause();
+    }
+    return NULL;
+}
+
+/**
+ * Fork a child that touches CHILD_HEAP_MB, opens CHILD_EXTRA_FDS descriptors
+ * and runs a spinning and a sleeping thread; returns once it is set up
+ */
+static pid_t start_child(void) {
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(ready[0]);
+        size_t size = (size_t)CHILD_HEAP_MB << 20;
+        child_heap = malloc(size);
+        memset(child_heap, 0x5a, size);
+        for (int i = 0; i < CHILD_EXTRA_FDS; i++) {
+            open("/dev/null", O_RDONLY);
+        }
+        // Ready once the threads are named, so samples find them
+        pthread_t thread;
+        pthread_barrier_t named;
+        pthread_barrier_init(&named, NULL, 3);
+        pthread_create(&thread, NULL, busy_thread, &named);
+        pthread_create(&thread, NULL, idle_thread, &named);
+        pthread_barrier_wait(&named);
+        write(ready[1], "x", 1);
+        for (;;) {
+            pause();
+        }
+    }
+    close(ready[1]);
+    char byte;
+    ssize_t n;
+    while ((n = read(ready[0], &byte, 1)) < 0 && errno == EINTR) {
+    }
+    close(ready[0]);
+    return n == 1 ? pid : -1;
+}
+
+static void stop_child(pid_t pid) {
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static const singbox_thread_sample_t* find_thread(const singbox_proc_snapshot_t* snapshot, const char* name) {
+    for (uint32_t i = 0; i < snapshot->thread_samples; i++) {
+        if (strcmp(snapshot->thread[i].name, name) == 0) {
+            return &snapshot->thread[i];
+        }
+    }
+    return NULL;
+}
+
+static singbox_proc_snapshot_t snapshot;
+
+static void test_memory_and_descriptors(void) {
+    pid_t pid = start_child();
+    CHECK(pid > 0);
+    singbox_procstat_t* sampler = singbox_procstat_open(pid, 0);
+    CHECK(sampler != NULL);
+    if (!sampler) {
+        stop_child(pid);
+        return;
+    }
+    
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    CHECK_EQ_INT(snapshot.pid, pid);
+    CHECK(snapshot.rss_kb >= CHILD_HEAP_MB * 1024);
+    CHECK(snapshot.vm_size_kb >= snapshot.rss_kb);
+    CHECK(snapshot.vm_hwm_kb >= CHILD_HEAP_MB * 1024);
+    if (snapshot.has_pss) {
+        // The heap is private, so it counts fully towards PSS
+        CHECK(snapshot.pss_kb >= CHILD_HEAP_MB * 1024);
+        CHECK(snapshot.pss_kb <= snapshot.rss_kb);
+        CHECK(snapshot.pss_anon_kb >= CHILD_HEAP_MB * 1024);
+    }
+    CHECK(snapshot.fd_count >= 3 + CHILD_EXTRA_FDS);
+    CHECK_EQ_INT(snapshot.threads, 3);
+    CHECK_EQ_INT(snapshot.thread_samples, 3);
+    CHECK(find_thread(&snapshot, "busy") != NULL);
+    CHECK(find_thread(&snapshot, "idle") != NULL);
+    
+    singbox_procstat_close(sampler);
+    stop_child(pid);
+}
+
+static void test_thread_cpu_deltas(void) {
+    pid_t pid = start_child();
+    singbox_procstat_t* sampler = singbox_procstat_open(pid, 0);
+    CHECK(sampler != NULL);
+    if (!sampler) {
+        stop_child(pid);
+        return;
+    }
+    
+    // The first sample has no baseline
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    CHECK(snapshot.cpu_percent == 0);
+    const singbox_thread_sample_t* busy = find_thread(&snapshot, "busy");
+    const singbox_thread_sample_t* idle = find_thread(&snapshot, "idle");
+    CHECK(busy && idle);
+    if (!busy || !idle) {
+        singbox_procstat_close(sampler);
+        stop_child(pid);
+        return;
+    }
+    uint64_t busy_start = busy->cpu_ticks;
+    uint64_t idle_start = idle->cpu_ticks;
+    uint64_t process_start = snapshot.cpu_ticks;
+    
+    // Shares of wall time depend on what else runs on the host, so the
+    // window lasts until the spinning thread got enough ticks to compare;
+    // a second sampler watches without moving the first one's baseline
+    singbox_procstat_t* probe = singbox_procstat_open(pid, 0);
+    CHECK(probe != NULL);
+    for (int i = 0; probe && i < 100; i++) {
+        sleep_ms(100);
+        CHECK_EQ_INT(singbox_procstat_sample(probe, &snapshot), 1);
+        const singbox_thread_sample_t* thread = find_thread(&snapshot, "busy");
+        if (i >= 4 && thread && thread->cpu_ticks - busy_start >= 20) {
+            break;
+        }
+    }
+    singbox_procstat_close(probe);
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    
+    busy = find_thread(&snapshot, "busy");
+    idle = find_thread(&snapshot, "idle");
+    CHECK(busy && idle);
+    if (busy && idle) {
+        uint64_t busy_ticks = busy->cpu_ticks - busy_start;
+        uint64_t idle_ticks = idle->cpu_ticks - idle_start;
+        uint64_t process_ticks = snapshot.cpu_ticks - process_start;
+        CHECK(busy_ticks >= 20);
+        // The spinning thread dominates both its sibling and the process
+        CHECK(idle_ticks * 10 <= busy_ticks);
+        CHECK(busy_ticks * 10 >= process_ticks * 8);
+        CHECK(process_ticks + 1 >= busy_ticks);
+        CHECK(busy->cpu_percent > idle->cpu_percent);
+        CHECK(snapshot.cpu_percent >= busy->cpu_percent * 0.8);
+    }
+    
+    char json[2048];
+    int length = singbox_procstat_format_json(&snapshot, 2, json, sizeof(json));
+    CHECK(length > 0 && (size_t)length == strlen(json));
+    // Sorted by CPU and limited to two entries
+    CHECK(strstr(json, "\"thread_cpu\":[{\"tid\":") != NULL);
+    char* first_name = strstr(json, "\"name\":\"");
+    CHECK(first_name && strncmp(first_name + 8, "busy\"", 5) == 0);
+    CHECK(strstr(json, "\"idle\"") == NULL);
+    CHECK(singbox_procstat_format_json(&snapshot, 2, json, 16) == -1);
+    
+    singbox_procstat_close(sampler);
+    stop_child(pid);
+}
+
+static void test_history_ring(void) {
+    pid_t pid = start_child();
+    singbox_procstat_t* sampler = singbox_procstat_open(pid, 4);
+    CHECK(sampler != NULL);
+    if (!sampler) {
+        stop_child(pid);
+        return;
+    }
+    
+    singbox_proc_point_t points[8];
+    CHECK_EQ_INT(singbox_procstat_history(sampler, points, 8), 0);
+    for (int i = 0; i < 6; i++) {
+        CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+        sleep_ms(5);
+    }
+    // Only the newest four are kept, oldest first
+    CHECK_EQ_INT(singbox_procstat_history(sampler, points, 8), 4);
+    for (int i = 1; i < 4; i++) {
+        CHECK(points[i].timestamp_ms >= points[i - 1].timestamp_ms + 5);
+    }
+    CHECK_EQ_INT(points[3].timestamp_ms, snapshot.timestamp_ms);
+    CHECK(points[3].rss_kb >= CHILD_HEAP_MB * 1024);
+    CHECK_EQ_INT(points[3].threads, 3);
+    
+    // A shorter buffer receives the newest points
+    CHECK_EQ_INT(singbox_procstat_history(sampler, points, 2), 2);
+    CHECK_EQ_INT(points[1].timestamp_ms, snapshot.timestamp_ms);
+    
+    char json[1024];
+    int length = singbox_procstat_format_history_json(sampler, json, sizeof(json));
+    CHECK(length > 0 && json[0] == '[' && json[length - 1] == ']');
+    int entries = 0;
+    for (const char* p = json; (p = strstr(p, "\"t\":")) != NULL; p++) {
+        entries++;
+    }
+    CHECK_EQ_INT(entries, 4);
+    
+    singbox_procstat_close(sampler);
+    stop_child(pid);
+}
+
+static void test_exited_process(void) {
+    pid_t pid = start_child();
+    singbox_procstat_t* sampler = singbox_procstat_open(pid, 0);
+    CHECK(sampler != NULL);
+    if (!sampler) {
+        stop_child(pid);
+        return;
+    }
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    stop_child(pid);
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 0);
+    singbox_procstat_close(sampler);
+    
+    // Nothing to open once it is gone
+    CHECK(singbox_procstat_open(pid, 0) == NULL);
+}
+
+static void test_thread_exit_releases_slot(void) {
+    // Sample this process while a thread comes and goes
+    singbox_procstat_t* sampler = singbox_procstat_open(getpid(), 0);
+    CHECK(sampler != NULL);
+    if (!sampler) {
+        return;
+    }
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    uint32_t baseline = snapshot.thread_samples;
+    
+    pthread_t thread;
+    CHECK_EQ_INT(pthread_create(&thread, NULL, idle_thread, NULL), 0);
+    sleep_ms(20);
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    CHECK_EQ_INT(snapshot.thread_samples, baseline + 1);
+    
+    pthread_cancel(thread);
+    pthread_join(thread, NULL);
+    CHECK_EQ_INT(singbox_procstat_sample(sampler, &snapshot), 1);
+    CHECK_EQ_INT(snapshot.thread_samples, baseline);
+    
+    singbox_procstat_close(sampler);
+}
+
+int main(void) {
+    RUN_TEST(test_memory_and_descriptors);
+    RUN_TEST(test_thread_cpu_deltas);
+    RUN_TEST(test_history_ring);
+    RUN_TEST(test_exited_process);
+    RUN_TEST(test_thread_exit_releases_slot);
+    return TEST_EXIT();
+}
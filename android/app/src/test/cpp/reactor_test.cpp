@@ -0,0 +1,226 @@
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "reactor.h"
+#include "test_util.h"
+
+/*
+ * The Linux runner's Reactor. Most tests drive RunOnce() themselves with a
+ * fake clock, so timers fire exactly when the test moves time; the rest
+ * start the thread on the real clock.
+ */
+
+using std::chrono::milliseconds;
+
+struct FakeClock {
+    std::atomic<uint64_t> now{1000};
+
+    Reactor::Clock clock() {
+        return [this]() { return now.load(); };
+    }
+};
+
+static bool wait_for(const std::atomic<int>& value, int expected) {
+    for (int i = 0; i < 2000 && value.load() < expected; i++) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return value.load() == expected;
+}
+
+static void test_timers_follow_the_fake_clock(void) {
+    FakeClock fake;
+    Reactor reactor(fake.clock());
+    std::vector<int> fired;
+    reactor.AddTimer(milliseconds(10), [&]() { fired.push_back(1); });
+    reactor.AddTimer(milliseconds(20), [&]() { fired.push_back(2); });
+    Reactor::TimerId cancelled = reactor.AddTimer(milliseconds(15), [&]() { fired.push_back(3); });
+    CHECK(reactor.CancelTimer(cancelled));
+
+    CHECK_EQ_INT(reactor.RunOnce(0), 0);
+    fake.now = 1009;
+    CHECK_EQ_INT(reactor.RunOnce(0), 0);
+    fake.now = 1010;
+    CHECK_EQ_INT(reactor.RunOnce(0), 1);
+    fake.now = 5000;
+    CHECK_EQ_INT(reactor.RunOnce(0), 1);
+    CHECK_EQ_INT(fired.size(), 2);
+    CHECK_EQ_INT(fired[1], 2);
+
+    Reactor::Stats stats = reactor.GetStats();
+    CHECK_EQ_INT(stats.timers_fired, 2);
+    CHECK_EQ_INT(stats.timers, 0);
+    CHECK_EQ_INT(stats.wheel.cancelled, 1);
+}
+
+/**
+ * The wait is cut to the next timer by the fake clock: a timer 30 ms away
+ * ends a 10 s wait after 30 real ms without firing, as fake time stood still
+ */
+static void test_wait_ends_at_the_next_timer(void) {
+    FakeClock fake;
+    Reactor reactor(fake.clock());
+    int fired = 0;
+    reactor.AddTimer(milliseconds(30), [&]() { fired++; });
+    reactor.RunOnce(0);  // The wakeup AddTimer() sends
+    uint64_t begin = test_now_ns();
+    CHECK_EQ_INT(reactor.RunOnce(10000), 0);
+    uint64_t elapsed_ms = (test_now_ns() - begin) / 1000000;
+    CHECK(elapsed_ms >= 25 && elapsed_ms < 2000);
+    fake.now += 30;
+    CHECK_EQ_INT(reactor.RunOnce(10000), 1);
+    CHECK_EQ_INT(fired, 1);
+}
+
+/**
+ * A handler re-arming its own timer: the debounce the netlink detector
+ * does, where each event pushes the deadline back
+ */
+static void test_rearmed_timer_fires_once(void) {
+    FakeClock fake;
+    Reactor reactor(fake.clock());
+    int fired = 0;
+    Reactor::TimerId timer = 0;
+    for (int event = 0; event < 5; event++) {
+        reactor.CancelTimer(timer);
+        timer = reactor.AddTimer(milliseconds(100), [&]() { fired++; });
+        fake.now += 50;
+        reactor.RunOnce(0);
+    }
+    CHECK_EQ_INT(fired, 0);
+    fake.now += 50;
+    reactor.RunOnce(0);
+    CHECK_EQ_INT(fired, 1);
+    CHECK_EQ_INT(reactor.GetStats().wheel.cancelled, 4);
+}
+
+static void test_fd_events(void) {
+    FakeClock fake;
+    Reactor reactor(fake.clock());
+    int pipe_fds[2];
+    CHECK(pipe2(pipe_fds, O_CLOEXEC | O_NONBLOCK) == 0);
+    int reads = 0;
+    CHECK(reactor.AddFd(pipe_fds[0], EPOLLIN, [&](uint32_t events) {
+        CHECK(events & EPOLLIN);
+        char buffer[16];
+        while (read(pipe_fds[0], buffer, sizeof(buffer)) > 0) {
+        }
+        reads++;
+    }, true));
+    CHECK(!reactor.AddFd(pipe_fds[0], EPOLLIN, [](uint32_t) {}));
+
+    CHECK_EQ_INT(reactor.RunOnce(0), 0);
+    CHECK(write(pipe_fds[1], "x", 1) == 1);
+    CHECK_EQ_INT(reactor.RunOnce(0), 1);
+    CHECK_EQ_INT(reads, 1);
+    CHECK_EQ_INT(reactor.GetStats().fds, 1);
+
+    // Removing an owned descriptor closes it; it reports nothing after
+    reactor.RemoveFd(pipe_fds[0]);
+    CHECK(fcntl(pipe_fds[0], F_GETFD) == -1);
+    CHECK_EQ_INT(reactor.RunOnce(0), 0);
+    CHECK_EQ_INT(reads, 1);
+    CHECK_EQ_INT(reactor.GetStats().fd_events, 1);
+    close(pipe_fds[1]);
+}
+
+static void test_post_and_call(void) {
+    Reactor reactor;
+    std::atomic<int> posted{0};
+    // Not running: Call() runs inline, Post() waits for a round
+    bool inline_ran = false;
+    reactor.Call([&]() { inline_ran = true; });
+    CHECK(inline_ran);
+    reactor.Post([&]() { posted++; });
+    CHECK_EQ_INT(posted.load(), 0);
+
+    CHECK(reactor.Start());
+    CHECK(wait_for(posted, 1));
+    bool on_reactor = false;
+    bool nested = false;
+    reactor.Call([&]() {
+        on_reactor = reactor.InReactorThread();
+        // From the reactor thread Call() does not wait on itself
+        reactor.Call([&]() { nested = true; });
+    });
+    CHECK(on_reactor);
+    CHECK(nested);
+    CHECK(!reactor.InReactorThread());
+
+    // Calls racing Stop() all return
+    std::atomic<int> calls{0};
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 8; i++) {
+        callers.emplace_back([&]() {
+            for (int j = 0; j < 100; j++) {
+                reactor.Call([&]() { calls++; });
+            }
+        });
+    }
+    std::this_thread::sleep_for(milliseconds(2));
+    reactor.Stop();
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    CHECK_EQ_INT(calls.load(), 800);
+    CHECK(!reactor.IsRunning());
+}
+
+static void test_idle_reactor_sleeps(void) {
+    Reactor reactor;
+    CHECK(reactor.Start());
+    std::this_thread::sleep_for(milliseconds(200));
+    CHECK_EQ_INT(reactor.GetStats().wakeups, 0);
+
+    // A timer wakes it once, when due
+    std::atomic<int> fired{0};
+    reactor.AddTimer(milliseconds(50), [&]() { fired++; });
+    CHECK(wait_for(fired, 1));
+    std::this_thread::sleep_for(milliseconds(100));
+    Reactor::Stats stats = reactor.GetStats();
+    // The wakeup AddTimer() sends, and the timer's
+    CHECK(stats.wakeups >= 1 && stats.wakeups <= 3);
+    reactor.Stop();
+}
+
+static void test_process_exit(void) {
+    Reactor reactor;
+    CHECK(reactor.Start());
+    pid_t child = fork();
+    if (child == 0) {
+        usleep(50000);
+        _exit(3);
+    }
+    std::atomic<int> exited{0};
+    int fd = reactor.WatchProcessExit(child, [&]() { exited++; });
+    if (fd < 0) {
+        printf("    pidfd_open unavailable here; skipped\n");
+        waitpid(child, nullptr, 0);
+        return;
+    }
+    CHECK_EQ_INT(reactor.GetStats().fds, 1);
+    CHECK(wait_for(exited, 1));
+    int status = 0;
+    CHECK(waitpid(child, &status, 0) == child);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 3);
+    // The watch ends with the process
+    CHECK_EQ_INT(reactor.GetStats().fds, 0);
+    reactor.Stop();
+}
+
+int main(void) {
+    RUN_TEST(test_timers_follow_the_fake_clock);
+    RUN_TEST(test_wait_ends_at_the_next_timer);
+    RUN_TEST(test_rearmed_timer_fires_once);
+    RUN_TEST(test_fd_events);
+    RUN_TEST(test_post_and_call);
+    RUN_TEST(test_idle_reactor_sleeps);
+    RUN_TEST(test_process_exit);
+    return TEST_EXIT();
+}
@@ -0,0 +1,161 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "reactor.h"
+#include "singbox_manager.h"
+#include "test_util.h"
+
+/*
+ * The Linux runner's SingboxManager over libtunnelmax_core, linked the way
+ * the runner links it, against a fake sing-box. The tunnel device never
+ * appears, so the counters stay at zero.
+ */
+
+static const char* fake_singbox =
+    "#!/bin/sh\n"
+    "trap 'exit 0' TERM\n"
+    "while :; do sleep 0.05; done\n";
+
+static char work_dir[] = "/tmp/singbox_manager_testXXXXXX";
+static std::string binary_path;
+
+static void test_requires_initialize(void) {
+    SingboxManager manager;
+    CHECK(!manager.Start("{}"));
+    CHECK(manager.GetLastErrorMessage() == "SingboxManager not initialized");
+    CHECK(!manager.IsRunning());
+}
+
+static void test_validation(void) {
+    SingboxManager manager;
+    CHECK(manager.ValidateConfiguration("{\"inbounds\":[]}"));
+    CHECK(!manager.ValidateConfiguration("{\"inbounds\":"));
+    CHECK(!manager.ValidateConfiguration("[]"));
+    CHECK(!manager.GetSupportedProtocols().empty());
+}
+
+static void test_lifecycle(void) {
+    SingboxManager manager;
+    std::string dir = std::string(work_dir) + "/state/nested";
+    CHECK(manager.Initialize(dir, binary_path, "tmx-absent0"));
+    struct stat st;
+    CHECK(stat(dir.c_str(), &st) == 0 && (st.st_mode & 0777) == 0700);
+
+    CHECK(!manager.Start("not json"));
+    CHECK(!manager.IsRunning());
+    CHECK(manager.Start("{\"log\":{}}"));
+    CHECK(manager.IsRunning());
+    CHECK(manager.GetLastErrorMessage().empty());
+    CHECK(manager.GetOperationTimings().count("start") == 1);
+    CHECK(manager.GetProcessStatsJson().find('{') == 0);
+    CHECK(manager.GetDetailedStatsJson().find('{') == 0);
+    CHECK(manager.UpdateConfiguration("{\"log\":{\"level\":\"debug\"}}"));
+
+    NetworkStats stats = manager.GetStatistics();
+    CHECK_EQ_INT(stats.bytes_sent, 0);
+    CHECK_EQ_INT(stats.bytes_received, 0);
+    CHECK(stats.timestamp > 0);
+
+    CHECK(manager.Stop());
+    CHECK(!manager.IsRunning());
+    CHECK(manager.GetOperationTimings().count("stop") == 1);
+    CHECK(!manager.UpdateConfiguration("{}"));
+    CHECK(manager.GetLastErrorMessage() == "sing-box is not running");
+    manager.Cleanup();
+
+    std::string file = dir + "/singbox_config.json";
+    unlink(file.c_str());
+    file = dir + "/singbox_native.slog";
+    unlink(file.c_str());
+    rmdir(dir.c_str());
+    rmdir((std::string(work_dir) + "/state").c_str());
+}
+
+// What the plugin does to notice a crash: watch the child through the
+// reactor, which runs the handler once the process is gone
+static void test_crash_is_noticed(void) {
+    SingboxManager manager;
+    std::string dir = std::string(work_dir) + "/crash";
+    CHECK(manager.Initialize(dir, binary_path, "tmx-absent0"));
+    CHECK_EQ_INT(manager.GetProcessId(), 0);
+    CHECK(manager.Start("{\"log\":{}}"));
+    pid_t pid = manager.GetProcessId();
+    CHECK(pid > 0);
+
+    Reactor reactor;
+    CHECK(reactor.Start());
+    std::atomic<int> exited{0};
+    if (reactor.WatchProcessExit(pid, [&]() { exited++; }) < 0) {
+        printf("    pidfd_open unavailable here; skipped\n");
+    } else {
+        kill(pid, SIGKILL);
+        for (int i = 0; i < 300 && exited.load() == 0; i++) {
+            usleep(10000);
+        }
+        CHECK_EQ_INT(exited.load(), 1);
+        CHECK(!manager.IsRunning());
+    }
+    reactor.Stop();
+
+    // Stopping reaps what is left of the crashed run
+    manager.Stop();
+    CHECK_EQ_INT(manager.GetProcessId(), 0);
+    manager.Cleanup();
+
+    std::string file = dir + "/singbox_config.json";
+    unlink(file.c_str());
+    file = dir + "/singbox_native.slog";
+    unlink(file.c_str());
+    rmdir(dir.c_str());
+}
+
+static void test_locations_from_environment(void) {
+    setenv("TUNNELMAX_SINGBOX", binary_path.c_str(), 1);
+    CHECK(SingboxManager::FindBinary() == binary_path);
+    unsetenv("TUNNELMAX_SINGBOX");
+
+    setenv("TUNNELMAX_WORK_DIR", "/srv/tmx", 1);
+    CHECK(SingboxManager::DefaultWorkDir() == "/srv/tmx");
+    unsetenv("TUNNELMAX_WORK_DIR");
+    setenv("XDG_STATE_HOME", "/home/u/.state", 1);
+    CHECK(SingboxManager::DefaultWorkDir() == "/home/u/.state/tunnel_max");
+    // Relative values are ignored, as the XDG specification asks
+    setenv("XDG_STATE_HOME", "state", 1);
+    setenv("HOME", "/home/u", 1);
+    CHECK(SingboxManager::DefaultWorkDir() == "/home/u/.local/state/tunnel_max");
+
+    std::string saved_path = getenv("PATH") ? getenv("PATH") : "";
+    setenv("PATH", (std::string("/nonexistent:") + work_dir).c_str(), 1);
+    CHECK(SingboxManager::FindBinary() == binary_path);
+    setenv("PATH", saved_path.c_str(), 1);
+}
+
+int main(void) {
+    if (!mkdtemp(work_dir)) {
+        return 1;
+    }
+    binary_path = std::string(work_dir) + "/sing-box";
+    FILE* script = fopen(binary_path.c_str(), "w");
+    if (!script) {
+        return 1;
+    }
+    fputs(fake_singbox, script);
+    fclose(script);
+    chmod(binary_path.c_str(), 0755);
+
+    RUN_TEST(test_requires_initialize);
+    RUN_TEST(test_validation);
+    RUN_TEST(test_lifecycle);
+    RUN_TEST(test_crash_is_noticed);
+    RUN_TEST(test_locations_from_environment);
+
+    unlink(binary_path.c_str());
+    rmdir(work_dir);
+    return TEST_EXIT();
+}
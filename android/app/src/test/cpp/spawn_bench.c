@@ -0,0 +1,96 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sing_box_spawn.h"
+#include "test_util.h"
+
+/*
+ * Spawn latency of singbox_spawn against fork()+exec from a process with a
+ * large resident heap, standing in for the ART process. Measures the time
+ * until the spawning call returns in the parent (what blocks the caller)
+ * and the full round trip to /bin/true exiting.
+ * Usage: spawn_bench [--quick] [heap_mb]
+ */
+
+static const char* const true_paths[] = { "/bin/true", "/usr/bin/true", NULL };
+
+static pid_t spawn_with_fork(void) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int i = 0; true_paths[i]; i++) {
+            execl(true_paths[i], "true", (char*)NULL);
+        }
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t spawn_with_singbox(void) {
+    char* argv[] = { "true", NULL };
+    singbox_spawn_request_t request = {
+        .paths = true_paths, .argv = argv, .env = NULL,
+        .stdout_fd = -1, .stderr_fd = -1, .pass_fd = -1, .pass_fd_target = 0,
+    };
+    pid_t pid = -1;
+    return singbox_spawn(&request, &pid) == 0 ? pid : -1;
+}
+
+static int measure(const char* name, pid_t (*spawn)(void), int rounds) {
+    uint64_t* call = malloc(sizeof(uint64_t) * (size_t)rounds);
+    uint64_t* total = malloc(sizeof(uint64_t) * (size_t)rounds);
+    if (!call || !total) {
+        return 1;
+    }
+    for (int i = 0; i < rounds; i++) {
+        uint64_t start = test_now_ns();
+        pid_t pid = spawn();
+        uint64_t returned = test_now_ns();
+        if (pid < 0) {
+            fprintf(stderr, "%s failed: %s\n", name, strerror(errno));
+            return 1;
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        call[i] = returned - start;
+        total[i] = test_now_ns() - start;
+    }
+    printf("%-12s call p50 %8.1f us  p99 %8.1f us | to exit p50 %8.1f us  p99 %8.1f us\n", name,
+           test_percentile(call, (size_t)rounds, 50) / 1e3, test_percentile(call, (size_t)rounds, 99) / 1e3,
+           test_percentile(total, (size_t)rounds, 50) / 1e3, test_percentile(total, (size_t)rounds, 99) / 1e3);
+    free(call);
+    free(total);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int quick = test_quick_mode(argc, argv);
+    size_t heap_mb = quick ? 64 : 512;
+    int rounds = quick ? 20 : 200;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            heap_mb = (size_t)strtoull(argv[i], NULL, 10);
+        }
+    }
+    
+    // Touch every page so the parent has the page tables fork() must copy
+    size_t heap_size = heap_mb << 20;
+    char* heap = malloc(heap_size);
+    if (!heap) {
+        fprintf(stderr, "cannot allocate %zu MB\n", heap_mb);
+        return 1;
+    }
+    for (size_t i = 0; i < heap_size; i += 4096) {
+        heap[i] = (char)i;
+    }
+    
+    printf("resident heap %zu MB, %d rounds, backend %s\n", heap_mb, rounds, singbox_spawn_backend());
+    int failed = measure("fork+exec", spawn_with_fork, rounds);
+    failed |= measure("singbox", spawn_with_singbox, rounds);
+    
+    free(heap);
+    return failed;
+}
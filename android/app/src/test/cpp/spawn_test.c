@@ -0,0 +1,133 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sing_box_spawn.h"
+#include "test_util.h"
+
+/*
+ * Descriptor layout, environment and path fallback of singbox_spawn. Built
+ * twice: against the platform backend and with SINGBOX_SPAWN_VFORK.
+ */
+
+// The child reports its view of the world on stdout
+static const char* probe_script =
+    "echo stdin=$(readlink /proc/self/fd/0); "
+    "echo tunenv=$SING_BOX_TUN_FD; "
+    "if [ -e /proc/self/fd/$SING_BOX_TUN_FD ]; then echo tun=open; fi; "
+    "if [ -e /proc/self/fd/$LEAK_FD ]; then echo leak=open; fi; "
+    "echo arg=$0";
+
+/**
+ * Spawn with stdout captured into `out`; returns the spawn error
+ */
+static int spawn_capture(singbox_spawn_request_t* request, char* out, size_t size, int* status) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        return errno;
+    }
+    request->stdout_fd = fds[1];
+    pid_t pid = -1;
+    int error = singbox_spawn(request, &pid);
+    close(fds[1]);
+    
+    size_t used = 0;
+    ssize_t n;
+    while (error == 0 && used + 1 < size && (n = read(fds[0], out + used, size - 1 - used)) > 0) {
+        used += (size_t)n;
+    }
+    out[used] = '\0';
+    close(fds[0]);
+    if (error == 0) {
+        waitpid(pid, status, 0);
+    }
+    return error;
+}
+
+static void test_descriptor_layout_and_environment(void) {
+    int tun = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    int leak = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    CHECK(tun > 2 && leak > 2);
+    
+    char leak_env[32];
+    snprintf(leak_env, sizeof(leak_env), "LEAK_FD=%d", leak);
+    char tun_env[32];
+    snprintf(tun_env, sizeof(tun_env), "SING_BOX_TUN_FD=%d", 40);
+    const char* paths[] = { "/nonexistent/sh", "/bin/sh", NULL };
+    const char* env[] = { tun_env, leak_env, NULL };
+    char* argv[] = { "sh", "-c", (char*)probe_script, "probe-arg", NULL };
+    
+    singbox_spawn_request_t request = {
+        .paths = paths, .argv = argv, .env = env,
+        .stdout_fd = -1, .stderr_fd = -1, .pass_fd = tun, .pass_fd_target = 40,
+    };
+    char out[512];
+    int status = -1;
+    CHECK_EQ_INT(spawn_capture(&request, out, sizeof(out), &status), 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(strstr(out, "stdin=/dev/null\n") != NULL);
+    CHECK(strstr(out, "tunenv=40\n") != NULL);
+    CHECK(strstr(out, "tun=open\n") != NULL);
+    CHECK(strstr(out, "leak=open") == NULL);  // CLOEXEC descriptors stay behind
+    CHECK(strstr(out, "arg=probe-arg\n") != NULL);
+    
+    close(tun);
+    close(leak);
+}
+
+static void test_pass_fd_keeps_its_number(void) {
+    int tun = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    char tun_env[32];
+    snprintf(tun_env, sizeof(tun_env), "SING_BOX_TUN_FD=%d", tun);
+    const char* paths[] = { "/bin/sh", NULL };
+    const char* env[] = { tun_env, "LEAK_FD=999", NULL };
+    char* argv[] = { "sh", "-c", (char*)probe_script, NULL };
+    
+    // Same source and target: must not stay close-on-exec
+    singbox_spawn_request_t request = {
+        .paths = paths, .argv = argv, .env = env,
+        .stdout_fd = -1, .stderr_fd = -1, .pass_fd = tun, .pass_fd_target = tun,
+    };
+    char out[512];
+    int status = -1;
+    CHECK_EQ_INT(spawn_capture(&request, out, sizeof(out), &status), 0);
+    CHECK(strstr(out, "tun=open\n") != NULL);
+    CHECK(fcntl(tun, F_GETFD) & FD_CLOEXEC); // Parent copy untouched
+    close(tun);
+}
+
+static void test_errors(void) {
+    const char* missing[] = { "/nonexistent/a", "/nonexistent/b", NULL };
+    char* argv[] = { "x", NULL };
+    singbox_spawn_request_t request = {
+        .paths = missing, .argv = argv, .env = NULL,
+        .stdout_fd = -1, .stderr_fd = -1, .pass_fd = -1, .pass_fd_target = 0,
+    };
+    pid_t pid = -1;
+    CHECK_EQ_INT(singbox_spawn(&request, &pid), ENOENT);
+    CHECK_EQ_INT(waitpid(-1, NULL, WNOHANG), -1); // No child left behind
+    
+    const char* paths[] = { "/bin/true", NULL };
+    request.paths = paths;
+    request.pass_fd = 0;
+    request.pass_fd_target = 1;
+    CHECK_EQ_INT(singbox_spawn(&request, &pid), EINVAL);
+    CHECK_EQ_INT(singbox_spawn(NULL, &pid), EINVAL);
+    
+    request.pass_fd = -1;
+    CHECK_EQ_INT(singbox_spawn(&request, &pid), 0);
+    int status = -1;
+    CHECK_EQ_INT(waitpid(pid, &status, 0), pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main(void) {
+    printf("backend: %s\n", singbox_spawn_backend());
+    RUN_TEST(test_descriptor_layout_and_environment);
+    RUN_TEST(test_pass_fd_keeps_its_number);
+    RUN_TEST(test_errors);
+    return TEST_EXIT();
+}
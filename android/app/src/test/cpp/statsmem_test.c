@@ -0,0 +1,150 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sing_box_statsmem.h"
+#include "test_util.h"
+
+/*
+ * Layout and seqlock consistency of the shared statistics region
+ */
+
+static void fill(singbox_stats_values_t* values, int64_t k) {
+    values->state = (uint32_t)(k & 3);
+    values->upload_bytes = k;
+    values->download_bytes = k * 2;
+    values->packets_sent = k * 3;
+    values->packets_received = k * 4;
+    values->upload_speed = (double)k * 0.5;
+    values->download_speed = (double)k * 0.25;
+    values->started_at_ms = k * 5;
+    values->updated_at_ms = k * 6;
+    values->updates = 0;
+}
+
+static int consistent(const singbox_stats_values_t* values) {
+    int64_t k = values->upload_bytes;
+    return values->state == (uint32_t)(k & 3) &&
+           values->download_bytes == k * 2 &&
+           values->packets_sent == k * 3 &&
+           values->packets_received == k * 4 &&
+           values->upload_speed == (double)k * 0.5 &&
+           values->download_speed == (double)k * 0.25 &&
+           values->started_at_ms == k * 5 &&
+           values->updated_at_ms == k * 6;
+}
+
+static void test_layout(void) {
+    singbox_stats_shared_t region;
+    memset(&region, 0xff, sizeof(region));
+    singbox_stats_shared_init(&region);
+
+    // The managed reader decodes fixed little-endian offsets
+    const uint8_t* bytes = (const uint8_t*)&region;
+    CHECK_EQ_INT(sizeof(region), 128);
+    CHECK_EQ_INT(bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24, SINGBOX_STATS_MAGIC);
+    CHECK_EQ_INT(bytes[4] | bytes[5] << 8, SINGBOX_STATS_VERSION);
+    CHECK_EQ_INT(bytes[6] | bytes[7] << 8, 128);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, state), 12);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, download_bytes), 24);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, packets_received), 40);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, download_speed), 56);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, started_at_ms), 64);
+    CHECK_EQ_INT(offsetof(singbox_stats_shared_t, updated_at_ms), 72);
+    CHECK_EQ_INT(region.seq, 0);
+    CHECK_EQ_INT(region.upload_bytes, 0);
+}
+
+static void test_write_read(void) {
+    singbox_stats_shared_t region;
+    singbox_stats_shared_init(&region);
+
+    singbox_stats_values_t in, out;
+    fill(&in, 1234);
+    singbox_stats_shared_write(&region, &in);
+    CHECK(singbox_stats_shared_read(&region, &out));
+    CHECK(consistent(&out));
+    CHECK_EQ_INT(out.upload_bytes, 1234);
+    CHECK_EQ_INT(out.updates, 1);
+    CHECK_EQ_INT(region.seq, 2);
+
+    fill(&in, 99);
+    in.updates = 500; // Owned by the region
+    singbox_stats_shared_write(&region, &in);
+    CHECK(singbox_stats_shared_read(&region, &out));
+    CHECK_EQ_INT(out.upload_bytes, 99);
+    CHECK_EQ_INT(out.updates, 2);
+
+    // A reader never accepts a region with an update in progress
+    region.seq++;
+    CHECK(!singbox_stats_shared_read(&region, &out));
+}
+
+typedef struct {
+    singbox_stats_shared_t* region;
+    int stop;
+    uint64_t reads;
+    uint64_t torn;
+    uint64_t busy;
+} reader_ctx_t;
+
+static void* reader_thread(void* arg) {
+    reader_ctx_t* ctx = arg;
+    singbox_stats_values_t values;
+    while (!__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE)) {
+        if (!singbox_stats_shared_read(ctx->region, &values)) {
+            ctx->busy++;
+            continue;
+        }
+        ctx->reads++;
+        if (!consistent(&values)) {
+            ctx->torn++;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers_never_see_torn_values(void) {
+    singbox_stats_shared_t region;
+    singbox_stats_shared_init(&region);
+    singbox_stats_values_t values;
+    fill(&values, 0);
+    singbox_stats_shared_write(&region, &values);
+
+    enum { READERS = 3 };
+    reader_ctx_t readers[READERS];
+    pthread_t threads[READERS];
+    for (int i = 0; i < READERS; i++) {
+        memset(&readers[i], 0, sizeof(readers[i]));
+        readers[i].region = &region;
+        pthread_create(&threads[i], NULL, reader_thread, &readers[i]);
+    }
+
+    int64_t writes = 2000000;
+    for (int64_t k = 1; k <= writes; k++) {
+        fill(&values, k);
+        singbox_stats_shared_write(&region, &values);
+    }
+
+    uint64_t reads = 0, torn = 0;
+    for (int i = 0; i < READERS; i++) {
+        __atomic_store_n(&readers[i].stop, 1, __ATOMIC_RELEASE);
+        pthread_join(threads[i], NULL);
+        reads += readers[i].reads;
+        torn += readers[i].torn;
+    }
+    printf("  %lld writes, %llu reads, %llu torn\n", (long long)writes,
+           (unsigned long long)reads, (unsigned long long)torn);
+    CHECK(reads > 0);
+    CHECK_EQ_INT(torn, 0);
+    CHECK(singbox_stats_shared_read(&region, &values));
+    CHECK_EQ_INT(values.upload_bytes, writes);
+    CHECK_EQ_INT(values.updates, writes + 1);
+}
+
+int main(void) {
+    RUN_TEST(test_layout);
+    RUN_TEST(test_write_read);
+    RUN_TEST(test_concurrent_readers_never_see_torn_values);
+    return TEST_EXIT();
+}
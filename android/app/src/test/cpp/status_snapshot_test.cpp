@@ -0,0 +1,193 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "StatusSnapshot.h"
+#include "test_util.h"
+
+/*
+ * Versioned sections of the runners' getDetailedStatus. The encoders count
+ * their calls and produce bytes of a chosen size in place of the codec.
+ */
+
+using Bytes = StatusSnapshot::Bytes;
+
+static StatusSnapshot::EncodeFn encoder(int* calls, size_t size, uint8_t fill) {
+    return [calls, size, fill]() {
+        (*calls)++;
+        return Bytes(size, fill);
+    };
+}
+
+static uint64_t fingerprint_of(const std::string& text, int number) {
+    StatusFingerprint fingerprint;
+    fingerprint.Add(text).Add(number);
+    return fingerprint.value();
+}
+
+static void test_fingerprint(void) {
+    CHECK(fingerprint_of("connected", 1) == fingerprint_of("connected", 1));
+    CHECK(fingerprint_of("connected", 1) != fingerprint_of("connected", 2));
+    CHECK(fingerprint_of("connected", 1) != fingerprint_of("connecting", 1));
+
+    // Length prefixes keep string boundaries apart
+    StatusFingerprint a, b;
+    a.Add("ab").Add("c");
+    b.Add("a").Add("bc");
+    CHECK(a.value() != b.value());
+
+    StatusFingerprint empty, null;
+    empty.Add("");
+    null.Add(static_cast<const char*>(nullptr));
+    CHECK(empty.value() == null.value());
+    CHECK(empty.value() != StatusFingerprint().value());
+}
+
+static void test_unchanged_inputs_reuse_bytes(void) {
+    StatusSnapshot snapshot;
+    int calls = 0;
+    snapshot.BeginPass();
+    uint64_t first = snapshot.Refresh("executor", 7, encoder(&calls, 32, 1));
+    auto sections = snapshot.EndPass(nullptr);
+    CHECK(first > 0);
+    CHECK_EQ_INT(calls, 1);
+    CHECK_EQ_INT(sections.size(), 1);
+    const Bytes* encoded = sections[0].second.encoded.get();
+
+    snapshot.BeginPass();
+    CHECK(snapshot.Refresh("executor", 7, encoder(&calls, 32, 2)) == first);
+    sections = snapshot.EndPass(nullptr);
+    CHECK_EQ_INT(calls, 1);
+    CHECK(sections[0].second.encoded.get() == encoded);
+    CHECK_EQ_INT((*sections[0].second.encoded)[0], 1);
+
+    snapshot.BeginPass();
+    uint64_t second = snapshot.Refresh("executor", 8, encoder(&calls, 32, 2));
+    sections = snapshot.EndPass(nullptr);
+    CHECK(second > first);
+    CHECK_EQ_INT(calls, 2);
+    CHECK_EQ_INT((*sections[0].second.encoded)[0], 2);
+
+    StatusSnapshot::Stats stats = snapshot.GetStats();
+    CHECK_EQ_INT(stats.refreshes, 3);
+    CHECK_EQ_INT(stats.encodes, 2);
+    CHECK_EQ_INT(stats.bytes_encoded, 64);
+    CHECK_EQ_INT(stats.passes, 3);
+    CHECK_EQ_INT(stats.full_passes, 3);
+}
+
+static void test_known_versions_skip_sections(void) {
+    StatusSnapshot snapshot;
+    int calls = 0;
+    snapshot.BeginPass();
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 100, 0));
+    snapshot.Refresh("statsDetails", 1, encoder(&calls, 50, 0));
+    snapshot.EndPass(nullptr);
+    StatusSnapshot::Versions known = snapshot.GetVersions();
+    CHECK_EQ_INT(known.size(), 2);
+    CHECK(known["networkDetails"] != known["statsDetails"]);
+
+    // Nothing moved: nothing to send
+    snapshot.BeginPass();
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 100, 0));
+    snapshot.Refresh("statsDetails", 1, encoder(&calls, 50, 0));
+    CHECK(snapshot.EndPass(&known).empty());
+    CHECK_EQ_INT(snapshot.GetStats().last_pass_bytes, 0);
+
+    // One section moved
+    snapshot.BeginPass();
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 100, 0));
+    snapshot.Refresh("statsDetails", 2, encoder(&calls, 60, 0));
+    auto sections = snapshot.EndPass(&known);
+    CHECK_EQ_INT(sections.size(), 1);
+    CHECK(sections[0].first == "statsDetails");
+    CHECK(sections[0].second.version == snapshot.GetVersions()["statsDetails"]);
+    CHECK_EQ_INT(snapshot.GetStats().last_pass_bytes, 60);
+
+    // A caller with nothing cached, or a stale version, gets the section
+    StatusSnapshot::Versions stale = {{"networkDetails", 0}, {"statsDetails", known["statsDetails"]}};
+    snapshot.BeginPass();
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 100, 0));
+    snapshot.Refresh("statsDetails", 2, encoder(&calls, 60, 0));
+    CHECK_EQ_INT(snapshot.EndPass(&stale).size(), 2);
+    CHECK_EQ_INT(calls, 3);
+
+    StatusSnapshot::Stats stats = snapshot.GetStats();
+    CHECK_EQ_INT(stats.full_passes, 1);
+    CHECK_EQ_INT(stats.sections_skipped, 3);
+    CHECK_EQ_INT(stats.bytes_skipped, 250);
+}
+
+static void test_absent_sections_are_dropped(void) {
+    StatusSnapshot snapshot;
+    int calls = 0;
+    snapshot.BeginPass();
+    snapshot.Refresh("singboxDetails", 1, encoder(&calls, 10, 0));
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 10, 0));
+    snapshot.EndPass(nullptr);
+
+    // The detector stopped monitoring, so the plugin leaves the section out
+    snapshot.BeginPass();
+    snapshot.Refresh("singboxDetails", 1, encoder(&calls, 10, 0));
+    CHECK_EQ_INT(snapshot.EndPass(nullptr).size(), 1);
+    StatusSnapshot::Versions versions = snapshot.GetVersions();
+    CHECK_EQ_INT(versions.size(), 1);
+    CHECK(versions.count("networkDetails") == 0);
+
+    // Coming back it is new to everyone
+    snapshot.BeginPass();
+    snapshot.Refresh("singboxDetails", 1, encoder(&calls, 10, 0));
+    snapshot.Refresh("networkDetails", 1, encoder(&calls, 10, 0));
+    CHECK_EQ_INT(snapshot.EndPass(&versions).size(), 1);
+    CHECK_EQ_INT(calls, 3);
+}
+
+// A status screen polling once a second: the executor counters move on
+// every poll, the stats section every fifth, the rest stay put
+static void test_refresh_loop_cost(void) {
+    const int polls = 200;
+    const size_t sizes[] = {1800, 900, 400, 300};
+    const char* names[] = {"singboxDetails", "networkDetails", "statsDetails", "executor"};
+    uint64_t bytes[2] = {0, 0};
+    uint64_t pass_us[2] = {0, 0};
+    int encodes[2] = {0, 0};
+
+    for (int mode = 0; mode < 2; mode++) {
+        StatusSnapshot snapshot;
+        StatusSnapshot::Versions known;
+        for (int poll = 0; poll < polls; poll++) {
+            int inputs[] = {0, 0, poll / 5, poll};
+            snapshot.BeginPass();
+            for (int i = 0; i < 4; i++) {
+                StatusFingerprint fingerprint;
+                fingerprint.Add(std::string(names[i])).Add(inputs[i]);
+                snapshot.Refresh(names[i], fingerprint.value(), encoder(&encodes[mode], sizes[i], 0));
+            }
+            snapshot.EndPass(mode ? &known : nullptr);
+            known = snapshot.GetVersions();
+        }
+        StatusSnapshot::Stats stats = snapshot.GetStats();
+        bytes[mode] = stats.bytes_sent;
+        pass_us[mode] = stats.pass_total_us;
+        CHECK_EQ_INT(stats.passes, polls);
+    }
+
+    // Both modes encode alike; the incremental one sends the first poll in
+    // full and then the executor and, every fifth poll, the stats
+    CHECK_EQ_INT(encodes[0], encodes[1]);
+    CHECK_EQ_INT(encodes[0], 2 + polls / 5 + polls);
+    CHECK_EQ_INT(bytes[0], 3400ull * polls);
+    CHECK_EQ_INT(bytes[1], 3400 + 300ull * (polls - 1) + 400ull * (polls / 5 - 1));
+    printf("  %d polls: full %llu bytes, incremental %llu bytes; %llu us and %llu us in passes\n", polls,
+           (unsigned long long)bytes[0], (unsigned long long)bytes[1], (unsigned long long)pass_us[0],
+           (unsigned long long)pass_us[1]);
+}
+
+int main(void) {
+    RUN_TEST(test_fingerprint);
+    RUN_TEST(test_unchanged_inputs_reuse_bytes);
+    RUN_TEST(test_known_versions_skip_sections);
+    RUN_TEST(test_absent_sections_are_dropped);
+    RUN_TEST(test_refresh_loop_cost);
+    return TEST_EXIT();
+}
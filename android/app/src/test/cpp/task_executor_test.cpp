@@ -0,0 +1,293 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TaskExecutor.h"
+#include "test_util.h"
+
+/*
+ * The Windows runner's TaskExecutor, driven the way VpnPlugin drives it:
+ * connect and disconnect go to the serial lane under one key, against a
+ * fake manager whose start and stop take a while and which records any
+ * overlap between them.
+ */
+
+using Lane = TaskExecutor::Lane;
+using Reason = TaskExecutor::CancelReason;
+
+static void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Holds a lane's workers until released
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    std::atomic<int> entered{0};
+
+    void Wait() {
+        entered++;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return open; });
+    }
+    void Open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        cv.notify_all();
+    }
+    void WaitEntered(int count) {
+        while (entered < count) {
+            sleep_ms(1);
+        }
+    }
+};
+
+struct FakeManager {
+    std::atomic<int> active{0};
+    std::atomic<int> overlaps{0};
+    std::atomic<bool> running{false};
+    std::atomic<int> starts{0};
+    std::atomic<int> stops{0};
+
+    void Op(int ms) {
+        if (active.fetch_add(1) != 0) {
+            overlaps++;
+        }
+        sleep_ms(ms);
+        active--;
+    }
+    bool Start() {
+        Op(8);
+        starts++;
+        running = true;
+        return true;
+    }
+    bool Stop() {
+        Op(5);
+        stops++;
+        running = false;
+        return true;
+    }
+};
+
+// VpnPlugin's Connect/Disconnect reduced to their use of the executor
+struct FakePlugin {
+    TaskExecutor executor;
+    FakeManager manager;
+    std::atomic<int> replies{0};
+    std::atomic<int> superseded{0};
+
+    void Connect() {
+        executor.Submit(Lane::Serial, "lifecycle",
+            [this](const CancellationToken& token) {
+                if (!token.IsCancelled() && !manager.running) {
+                    manager.Start();
+                }
+                replies++;
+            },
+            [this](Reason reason) {
+                superseded += reason == Reason::Superseded;
+                replies++;
+            });
+    }
+    void Disconnect() {
+        executor.Cancel("reconnect");
+        executor.Submit(Lane::Serial, "lifecycle",
+            [this](const CancellationToken&) {
+                if (manager.running) {
+                    manager.Stop();
+                }
+                replies++;
+            },
+            [this](Reason reason) {
+                superseded += reason == Reason::Superseded;
+                replies++;
+            });
+    }
+};
+
+static void test_serial_lane_keeps_order(void) {
+    TaskExecutor executor;
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> active{0}, overlaps{0};
+    for (int i = 0; i < 10; i++) {
+        executor.Submit(Lane::Serial, "", [&, i](const CancellationToken&) {
+            overlaps += active.fetch_add(1) != 0;
+            sleep_ms(1);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+            }
+            active--;
+        });
+    }
+    while (executor.GetStats(Lane::Serial).completed < 10) {
+        sleep_ms(1);
+    }
+    CHECK_EQ_INT(order.size(), 10);
+    for (size_t i = 0; i < order.size(); i++) {
+        CHECK_EQ_INT(order[i], i);
+    }
+    CHECK_EQ_INT(overlaps.load(), 0);
+}
+
+static void test_key_supersedes_queued(void) {
+    TaskExecutor executor;
+    Gate gate;
+    executor.Submit(Lane::Serial, "", [&](const CancellationToken&) { gate.Wait(); });
+    gate.WaitEntered(1);
+
+    std::vector<std::string> events;
+    std::mutex mutex;
+    auto record = [&](const std::string& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(event);
+    };
+    for (const char* name : {"connect", "disconnect", "connect2"}) {
+        std::string task = name;
+        executor.Submit(Lane::Serial, "lifecycle",
+                        [&, task](const CancellationToken&) { record("ran " + task); },
+                        [&, task](Reason reason) { record(task + " " + TaskExecutor::ReasonName(reason)); });
+    }
+    executor.Submit(Lane::Serial, "other", [&](const CancellationToken&) { record("ran other"); });
+    gate.Open();
+    while (executor.GetStats(Lane::Serial).completed < 3) {
+        sleep_ms(1);
+    }
+
+    CHECK_EQ_INT(events.size(), 4);
+    CHECK(events[0] == "connect superseded");
+    CHECK(events[1] == "disconnect superseded");
+    // The survivor keeps its own place in the queue
+    CHECK(events[2] == "ran connect2");
+    CHECK(events[3] == "ran other");
+    TaskExecutor::LaneStats stats = executor.GetStats(Lane::Serial);
+    CHECK_EQ_INT(stats.superseded, 2);
+    CHECK_EQ_INT(stats.submitted, 5);
+}
+
+static void test_running_task_is_cancelled(void) {
+    TaskExecutor executor;
+    std::atomic<bool> woke_early{false};
+    std::atomic<bool> started{false};
+    executor.Submit(Lane::Parallel, "reconnect", [&](const CancellationToken& token) {
+        started = true;
+        auto begin = std::chrono::steady_clock::now();
+        bool waited = token.WaitFor(std::chrono::milliseconds(5000));
+        woke_early = !waited && std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(2000);
+    });
+    while (!started) {
+        sleep_ms(1);
+    }
+    CHECK_EQ_INT(executor.Cancel("reconnect"), 1);
+    while (executor.GetStats(Lane::Parallel).completed < 1) {
+        sleep_ms(1);
+    }
+    CHECK(woke_early.load());
+    CHECK_EQ_INT(executor.Cancel("reconnect"), 0);
+}
+
+static void test_bounded_queue_and_shutdown(void) {
+    TaskExecutor::Options options;
+    options.parallel_workers = 3;
+    options.parallel_capacity = 4;
+    TaskExecutor executor(options);
+    Gate gate;
+    std::atomic<int> rejected{0}, shut_down{0};
+    auto on_cancel = [&](Reason reason) {
+        rejected += reason == Reason::Rejected;
+        shut_down += reason == Reason::Shutdown;
+    };
+    for (int i = 0; i < 3; i++) {
+        executor.Submit(Lane::Parallel, "", [&](const CancellationToken&) { gate.Wait(); }, on_cancel);
+    }
+    // All workers busy at once, then the queue fills
+    gate.WaitEntered(3);
+    CHECK_EQ_INT(executor.GetStats(Lane::Parallel).running, 3);
+    int accepted = 0;
+    for (int i = 0; i < 10; i++) {
+        accepted += executor.Submit(Lane::Parallel, "", [](const CancellationToken&) {}, on_cancel);
+    }
+    CHECK_EQ_INT(accepted, 4);
+    CHECK_EQ_INT(rejected.load(), 6);
+    CHECK_EQ_INT(executor.GetStats(Lane::Parallel).rejected, 6);
+    CHECK_EQ_INT(executor.GetStats(Lane::Parallel).max_queued, 4);
+
+    std::thread opener([&]() {
+        sleep_ms(20);
+        gate.Open();
+    });
+    executor.Shutdown();
+    opener.join();
+    CHECK_EQ_INT(shut_down.load(), 4);
+    CHECK(!executor.Submit(Lane::Serial, "", [](const CancellationToken&) {}, on_cancel));
+    CHECK_EQ_INT(shut_down.load(), 5);
+}
+
+static void test_queue_wait_is_measured(void) {
+    TaskExecutor executor;
+    executor.Submit(Lane::Serial, "", [](const CancellationToken&) { sleep_ms(50); });
+    executor.Submit(Lane::Serial, "", [](const CancellationToken&) {});
+    while (executor.GetStats(Lane::Serial).completed < 2) {
+        sleep_ms(1);
+    }
+    TaskExecutor::LaneStats stats = executor.GetStats(Lane::Serial);
+    CHECK(stats.wait_max_us >= 40000);
+    CHECK(stats.run_max_us >= 40000);
+    CHECK(stats.wait_total_us >= stats.wait_max_us);
+    CHECK_EQ_INT(stats.workers, 1);
+}
+
+/**
+ * A user hammering connect/disconnect: every tap gets exactly one reply,
+ * start and stop never overlap, the manager ends in the state of the last
+ * tap, and most intermediate taps are superseded instead of executed.
+ */
+static void test_rapid_taps(void) {
+    FakePlugin plugin;
+    const int kTaps = 200;
+    for (int i = 0; i < kTaps; i++) {
+        if (i % 2 == 0) {
+            plugin.Connect();
+        } else {
+            plugin.Disconnect();
+        }
+        if (i % 10 == 0) {
+            sleep_ms(1);
+        }
+    }
+    plugin.Connect();   // Last intent: connected
+    while (plugin.replies < kTaps + 1) {
+        sleep_ms(1);
+    }
+    CHECK_EQ_INT(plugin.replies.load(), kTaps + 1);
+    CHECK_EQ_INT(plugin.manager.overlaps.load(), 0);
+    CHECK(plugin.manager.running.load());
+
+    TaskExecutor::LaneStats stats = plugin.executor.GetStats(Lane::Serial);
+    CHECK_EQ_INT(stats.completed + stats.superseded, kTaps + 1);
+    CHECK((int)stats.superseded == plugin.superseded.load());
+    CHECK(plugin.manager.starts + plugin.manager.stops < kTaps / 4);
+    CHECK_EQ_INT(stats.max_queued, 1);
+    printf("    %d taps -> %d starts, %d stops, %llu superseded, max wait %.1f ms\n",
+           kTaps + 1, plugin.manager.starts.load(), plugin.manager.stops.load(),
+           (unsigned long long)stats.superseded, (double)stats.wait_max_us / 1000.0);
+}
+
+int main(void) {
+    RUN_TEST(test_serial_lane_keeps_order);
+    RUN_TEST(test_key_supersedes_queued);
+    RUN_TEST(test_running_task_is_cancelled);
+    RUN_TEST(test_bounded_queue_and_shutdown);
+    RUN_TEST(test_queue_wait_is_measured);
+    RUN_TEST(test_rapid_taps);
+    return TEST_EXIT();
+}
@@ -0,0 +1,70 @@
+#ifndef SING_BOX_TEST_UTIL_H
+#define SING_BOX_TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Minimal helpers shared by the native host tests and benchmarks
+ */
+
+static int test_failures __attribute__((unused)) = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ_INT(actual, expected) do { \
+    long long _a = (long long)(actual), _e = (long long)(expected); \
+    if (_a != _e) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s == %lld (got %lld)\n", \
+                __FILE__, __LINE__, #actual, _e, _a); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define RUN_TEST(fn) do { \
+    int _before = test_failures; \
+    fn(); \
+    printf("%s %s\n", _before == test_failures ? "[ OK ]" : "[FAIL]", #fn); \
+} while (0)
+
+#define TEST_EXIT() (test_failures == 0 ? 0 : 1)
+
+static inline uint64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts samples in place and returns the requested percentile (0-100)
+static inline uint64_t test_percentile(uint64_t* samples, size_t count, double pct) {
+    if (count == 0) {
+        return 0;
+    }
+    qsort(samples, count, sizeof(*samples), compare_u64);
+    size_t index = (size_t)(pct / 100.0 * (double)(count - 1));
+    return samples[index];
+}
+
+static inline int test_quick_mode(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif // SING_BOX_TEST_UTIL_H
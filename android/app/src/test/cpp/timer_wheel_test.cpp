@@ -0,0 +1,228 @@
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "test_util.h"
+#include "timer_wheel.h"
+
+/*
+ * The Linux runner's hierarchical timer wheel. Time is a plain tick count
+ * the tests move; callbacks record the tick they ran at.
+ */
+
+struct Recorder {
+    TimerWheel& wheel;
+    std::vector<std::pair<int, uint64_t>> fired;  // (tag, tick)
+
+    TimerWheel::TimerId At(uint64_t deadline, int tag) {
+        return wheel.Schedule(deadline, [this, tag]() { fired.emplace_back(tag, wheel.now()); });
+    }
+};
+
+static void test_fires_in_deadline_order(void) {
+    TimerWheel wheel;
+    Recorder recorder{wheel, {}};
+    recorder.At(5, 1);
+    recorder.At(3, 2);
+    recorder.At(3, 3);
+    recorder.At(70, 4);
+    recorder.At(0, 5);  // Already due: the next tick
+
+    CHECK_EQ_INT(wheel.Advance(2), 1);
+    CHECK_EQ_INT(wheel.Advance(4), 2);
+    CHECK_EQ_INT(recorder.fired.size(), 3);
+    CHECK_EQ_INT(recorder.fired[0].first, 5);
+    // Same tick: the order they were scheduled in
+    CHECK_EQ_INT(recorder.fired[1].first, 2);
+    CHECK_EQ_INT(recorder.fired[2].first, 3);
+
+    // Longer than a level-0 revolution: a jump, still in order
+    CHECK_EQ_INT(wheel.Advance(200), 2);
+    CHECK_EQ_INT(recorder.fired[3].first, 1);
+    CHECK_EQ_INT(recorder.fired[4].first, 4);
+    CHECK_EQ_INT(wheel.size(), 0);
+    CHECK_EQ_INT(wheel.GetStats().jumps, 1);
+}
+
+static void test_cancel(void) {
+    TimerWheel wheel(1000);
+    Recorder recorder{wheel, {}};
+    TimerWheel::TimerId near = recorder.At(1010, 1);
+    TimerWheel::TimerId far = recorder.At(1000 + 100000, 2);
+    TimerWheel::TimerId kept = recorder.At(1020, 3);
+    CHECK(near != 0 && far != 0 && kept != 0);
+    CHECK(wheel.Cancel(near));
+    CHECK(!wheel.Cancel(near));
+    CHECK(wheel.Cancel(far));
+    CHECK_EQ_INT(wheel.size(), 1);
+
+    wheel.Advance(1030);
+    CHECK_EQ_INT(recorder.fired.size(), 1);
+    CHECK(!wheel.Cancel(kept));
+
+    // A reused node does not answer to the old id
+    TimerWheel::TimerId reused = recorder.At(1040, 4);
+    CHECK(reused != near && reused != far && reused != kept);
+    CHECK(!wheel.Cancel(near));
+    CHECK(wheel.Cancel(reused));
+    CHECK(!wheel.Cancel(0));
+    CHECK_EQ_INT(wheel.GetStats().cancelled, 3);
+}
+
+/**
+ * Walking tick by tick, every timer fires exactly at its deadline whatever
+ * level it started on
+ */
+static void test_cascades_fire_on_time(void) {
+    TimerWheel wheel(7);
+    Recorder recorder{wheel, {}};
+    const uint64_t deadlines[] = {8, 71, 72, 4103, 4104, 5000, 262151, 300000};
+    for (int i = 0; i < 8; i++) {
+        recorder.At(deadlines[i], i);
+    }
+    for (uint64_t tick = 8; tick <= 300000; tick++) {
+        wheel.Advance(tick);
+    }
+    CHECK_EQ_INT(recorder.fired.size(), 8);
+    for (size_t i = 0; i < recorder.fired.size(); i++) {
+        CHECK_EQ_INT(recorder.fired[i].first, i);
+        CHECK_EQ_INT(recorder.fired[i].second, deadlines[i]);
+    }
+    TimerWheel::Stats stats = wheel.GetStats();
+    CHECK(stats.cascaded > 0);
+    CHECK_EQ_INT(stats.jumps, 0);
+    CHECK_EQ_INT(stats.fired, 8);
+}
+
+static void test_beyond_the_wheel(void) {
+    const uint64_t range = uint64_t{1} << (TimerWheel::kSlotBits * TimerWheel::kLevels);
+    TimerWheel wheel;
+    Recorder recorder{wheel, {}};
+    recorder.At(range + 10, 1);
+    recorder.At(3 * range, 2);
+    CHECK(wheel.NextDeadline() == range + 10);
+
+    // Stepping a level-0 revolution at a time goes through the far slot
+    for (uint64_t now = 64; now < range + 10; now += 64) {
+        wheel.Advance(now);
+    }
+    CHECK(recorder.fired.empty());
+    wheel.Advance(range + 10);
+    CHECK_EQ_INT(recorder.fired.size(), 1);
+    CHECK(recorder.fired[0].second == range + 10);
+
+    // Jumping lands on the deadline too
+    wheel.Advance(3 * range - 1);
+    CHECK_EQ_INT(recorder.fired.size(), 1);
+    wheel.Advance(3 * range + 5);
+    CHECK_EQ_INT(recorder.fired.size(), 2);
+}
+
+static void test_next_deadline(void) {
+    TimerWheel wheel(100);
+    Recorder recorder{wheel, {}};
+    CHECK(wheel.NextDeadline() == TimerWheel::kNever);
+    TimerWheel::TimerId soon = recorder.At(110, 1);
+    recorder.At(5000, 2);
+    recorder.At(90000, 3);
+    CHECK(wheel.NextDeadline() == 110);
+    wheel.Cancel(soon);
+    CHECK(wheel.NextDeadline() == 5000);
+    wheel.Advance(4100);
+    CHECK(wheel.NextDeadline() == 5000);
+    wheel.Advance(5000);
+    CHECK(wheel.NextDeadline() == 90000);
+    wheel.Advance(90000);
+    CHECK(wheel.NextDeadline() == TimerWheel::kNever);
+
+    // Idle time moves the wheel without work
+    uint64_t jumps = wheel.GetStats().jumps;
+    wheel.Advance(1000000);
+    CHECK(wheel.now() == 1000000);
+    CHECK_EQ_INT(wheel.GetStats().jumps, jumps);
+}
+
+static void test_callbacks_schedule_timers(void) {
+    TimerWheel wheel;
+    std::vector<uint64_t> ticks;
+    // A periodic timer re-arms itself from its callback
+    std::function<void()> periodic = [&]() {
+        ticks.push_back(wheel.now());
+        if (ticks.size() < 5) {
+            wheel.Schedule(wheel.now() + 10, periodic);
+        }
+    };
+    wheel.Schedule(10, periodic);
+    for (uint64_t tick = 1; tick <= 100; tick++) {
+        wheel.Advance(tick);
+    }
+    CHECK_EQ_INT(ticks.size(), 5);
+    CHECK_EQ_INT(ticks[4], 50);
+
+    // Scheduled in the past from a callback: waits for the next Advance
+    int late = 0;
+    wheel.Schedule(101, [&]() { wheel.Schedule(0, [&]() { late++; }); });
+    CHECK_EQ_INT(wheel.Advance(101), 1);
+    CHECK_EQ_INT(late, 0);
+    CHECK_EQ_INT(wheel.Advance(102), 1);
+    CHECK_EQ_INT(late, 1);
+}
+
+/**
+ * Random schedules, cancels and advances against a sorted map: the wheel
+ * fires the same timers in the same order
+ */
+static void test_matches_a_sorted_reference(void) {
+    TimerWheel wheel;
+    std::map<std::pair<uint64_t, int>, TimerWheel::TimerId> reference;  // (deadline, tag)
+    std::vector<int> fired;
+    std::vector<int> expected;
+    uint64_t seed = 42;
+    auto random = [&seed](uint64_t bound) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return (seed >> 33) % bound;
+    };
+    int tag = 0;
+    for (int round = 0; round < 20000; round++) {
+        uint64_t action = random(10);
+        if (action < 5) {
+            // Spans every level, sometimes beyond
+            uint64_t spans[] = {64, 4096, 262144, 1u << 25};
+            uint64_t deadline = wheel.now() + 1 + random(spans[random(4)]);
+            int id = tag++;
+            reference[{deadline, id}] = wheel.Schedule(deadline, [&fired, id]() { fired.push_back(id); });
+        } else if (action < 7 && !reference.empty()) {
+            auto it = reference.begin();
+            std::advance(it, static_cast<long>(random(reference.size())));
+            CHECK(wheel.Cancel(it->second));
+            reference.erase(it);
+        } else {
+            uint64_t steps[] = {1, 30, 1000, 100000};
+            uint64_t now = wheel.now() + 1 + random(steps[random(4)]);
+            while (!reference.empty() && reference.begin()->first.first <= now) {
+                expected.push_back(reference.begin()->first.second);
+                reference.erase(reference.begin());
+            }
+            wheel.Advance(now);
+            CHECK(wheel.NextDeadline() ==
+                  (reference.empty() ? TimerWheel::kNever : reference.begin()->first.first));
+        }
+    }
+    CHECK_EQ_INT(wheel.size(), reference.size());
+    CHECK_EQ_INT(fired.size(), expected.size());
+    CHECK(fired == expected);
+    TimerWheel::Stats stats = wheel.GetStats();
+    printf("  %llu scheduled, %llu fired, %llu cascaded, %llu jumps\n", (unsigned long long)stats.scheduled,
+           (unsigned long long)stats.fired, (unsigned long long)stats.cascaded, (unsigned long long)stats.jumps);
+}
+
+int main(void) {
+    RUN_TEST(test_fires_in_deadline_order);
+    RUN_TEST(test_cancel);
+    RUN_TEST(test_cascades_fire_on_time);
+    RUN_TEST(test_beyond_the_wheel);
+    RUN_TEST(test_next_deadline);
+    RUN_TEST(test_callbacks_schedule_timers);
+    RUN_TEST(test_matches_a_sorted_reference);
+    return TEST_EXIT();
+}
@@ -0,0 +1,549 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <grp.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sing_box_logparse.h"
+#include "sing_box_uidstats.h"
+#include "test_util.h"
+
+/*
+ * Clients run in forked children under their own UIDs and bind to
+ * 127.0.0.2, which stands in for the tunnel address; the server side
+ * lives on 127.0.0.1 and must never be counted.
+ */
+
+#define TUNNEL_ADDRESS "127.0.0.2"
+#define OTHER_ADDRESS "127.0.0.3"
+
+static uint16_t tcp_server_port;
+static uint16_t udp_server_port;
+static pid_t server_pid;
+
+typedef struct {
+    pid_t pid;
+    int control;                // Commands to the child: 'h' closes half its sockets, 'q' all and exits
+    int report;
+    uint16_t port;              // Local port of the child's first socket
+} client_t;
+
+static int read_full(int fd, void* data, size_t length) {
+    char* p = data;
+    while (length) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void* data, size_t length) {
+    const char* p = data;
+    while (length) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return 1;
+}
+
+static void* serve_connection(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    uint32_t header[2];
+    static char chunk[65536];
+    if (read_full(fd, header, sizeof(header))) {
+        char sink[65536];
+        for (uint32_t left = header[0]; left;) {
+            uint32_t take = left < sizeof(sink) ? left : (uint32_t)sizeof(sink);
+            if (!read_full(fd, sink, take)) {
+                break;
+            }
+            left -= take;
+        }
+        for (uint32_t left = header[1]; left;) {
+            uint32_t take = left < sizeof(chunk) ? left : (uint32_t)sizeof(chunk);
+            if (!write_full(fd, chunk, take)) {
+                break;
+            }
+            left -= take;
+        }
+        while (read(fd, sink, sizeof(sink)) > 0) {
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static void* tcp_server(void* arg) {
+    int listener = (int)(intptr_t)arg;
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        pthread_t thread;
+        pthread_create(&thread, NULL, serve_connection, (void*)(intptr_t)fd);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+static int start_servers(void) {
+    struct sockaddr_in address = { .sin_family = AF_INET };
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    socklen_t length = sizeof(address);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listener, 64) != 0 || getsockname(listener, (struct sockaddr*)&address, &length) != 0) {
+        return 0;
+    }
+    tcp_server_port = ntohs(address.sin_port);
+    // In a process of its own so clients forked later do not inherit the
+    // accepted sockets and hold them open past the server's close()
+    server_pid = fork();
+    if (server_pid == 0) {
+        tcp_server((void*)(intptr_t)listener);
+    }
+    close(listener);
+    if (server_pid < 0) {
+        return 0;
+    }
+
+    address.sin_port = 0;
+    int udp = socket(AF_INET, SOCK_DGRAM, 0);
+    length = sizeof(address);
+    if (udp < 0 || bind(udp, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        getsockname(udp, (struct sockaddr*)&address, &length) != 0) {
+        return 0;
+    }
+    udp_server_port = ntohs(address.sin_port);
+    return 1;
+}
+
+static int open_client_socket(const char* bind_to, int type, uint32_t upload, uint32_t reply) {
+    int fd = socket(AF_INET, type, 0);
+    struct sockaddr_in local = { .sin_family = AF_INET };
+    inet_pton(AF_INET, bind_to, &local.sin_addr);
+    struct sockaddr_in server = { .sin_family = AF_INET };
+    inet_pton(AF_INET, "127.0.0.1", &server.sin_addr);
+    server.sin_port = htons(type == SOCK_STREAM ? tcp_server_port : udp_server_port);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&local, sizeof(local)) != 0 ||
+        connect(fd, (struct sockaddr*)&server, sizeof(server)) != 0) {
+        return -1;
+    }
+    if (type == SOCK_DGRAM) {
+        return send(fd, "x", 1, 0) == 1 ? fd : -1;
+    }
+
+    uint32_t header[2] = { upload, reply };
+    static char chunk[65536];
+    if (!write_full(fd, header, sizeof(header))) {
+        return -1;
+    }
+    for (uint32_t left = upload; left;) {
+        uint32_t take = left < sizeof(chunk) ? left : (uint32_t)sizeof(chunk);
+        if (!write_full(fd, chunk, take)) {
+            return -1;
+        }
+        left -= take;
+    }
+    for (uint32_t left = reply; left;) {
+        uint32_t take = left < sizeof(chunk) ? left : (uint32_t)sizeof(chunk);
+        if (!read_full(fd, chunk, take)) {
+            return -1;
+        }
+        left -= take;
+    }
+    return fd;
+}
+
+/**
+ * Close a client socket and, for TCP, wait for the server's FIN so the
+ * socket is in TIME_WAIT (no longer accounted) once this returns
+ */
+static void close_client_socket(int fd, int type) {
+    if (type == SOCK_STREAM) {
+        char sink[256];
+        shutdown(fd, SHUT_WR);
+        while (read(fd, sink, sizeof(sink)) > 0) {
+        }
+    }
+    close(fd);
+}
+
+/**
+ * Fork a child that opens `sockets` sockets as `uid` and holds them until told
+ * otherwise; returns once their traffic has completed
+ */
+static int start_client(client_t* client, uid_t uid, const char* bind_to, int type,
+                        uint32_t upload, uint32_t reply, int sockets) {
+    int control[2], report[2];
+    if (pipe(control) != 0 || pipe(report) != 0) {
+        return 0;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(control[1]);
+        close(report[0]);
+        static int fds[1024];
+        uint16_t port = 0;
+        if (setgroups(0, NULL) != 0 || setgid(uid) != 0 || setuid(uid) != 0) {
+            _exit(1);
+        }
+        for (int i = 0; i < sockets; i++) {
+            fds[i] = open_client_socket(bind_to, type, upload, reply);
+            if (fds[i] < 0) {
+                _exit(1);
+            }
+        }
+        struct sockaddr_in local;
+        socklen_t length = sizeof(local);
+        getsockname(fds[0], (struct sockaddr*)&local, &length);
+        port = ntohs(local.sin_port);
+        write_full(report[1], &port, sizeof(port));
+
+        char command;
+        int open_count = sockets;
+        while (read_full(control[0], &command, 1) && command != 'q') {
+            if (command == 'h') {
+                for (int i = open_count / 2; i < open_count; i++) {
+                    close_client_socket(fds[i], type);
+                }
+                open_count /= 2;
+                write_full(report[1], &port, sizeof(port));
+            }
+        }
+        for (int i = 0; i < open_count; i++) {
+            close_client_socket(fds[i], type);
+        }
+        write_full(report[1], &port, sizeof(port));
+        _exit(0);
+    }
+    close(control[0]);
+    close(report[1]);
+    client->pid = pid;
+    client->control = control[1];
+    client->report = report[0];
+    return pid > 0 && read_full(client->report, &client->port, sizeof(client->port));
+}
+
+static void client_command(client_t* client, char command) {
+    write_full(client->control, &command, 1);
+    if (command == 'h' || command == 'q') {
+        uint16_t port;
+        read_full(client->report, &port, sizeof(port));
+    }
+}
+
+static void stop_client(client_t* client) {
+    client_command(client, 'q');
+    waitpid(client->pid, NULL, 0);
+    close(client->control);
+    close(client->report);
+}
+
+static singbox_uidstats_t* open_tunnel_stats(int force_proc) {
+    singbox_uidstats_t* stats = singbox_uidstats_open(force_proc);
+    struct in_addr tunnel;
+    inet_pton(AF_INET, TUNNEL_ADDRESS, &tunnel);
+    if (stats) {
+        singbox_uidstats_add_prefix(stats, AF_INET, &tunnel, 32);
+    }
+    return stats;
+}
+
+static void note_port(singbox_uidstats_t* stats, int network, uint16_t port) {
+    char address[32];
+    int length = snprintf(address, sizeof(address), "%s:%u", TUNNEL_ADDRESS, port);
+    singbox_uidstats_note_connection(stats, network, address, (size_t)length);
+}
+
+static void test_attributes_tcp_bytes_to_owners(void) {
+    singbox_uidstats_t* stats = open_tunnel_stats(0);
+    CHECK(stats != NULL);
+    if (!stats) {
+        return;
+    }
+    CHECK_EQ_INT(singbox_uidstats_source(stats), SINGBOX_UIDSTATS_SOCK_DIAG);
+
+    client_t heavy_upload, heavy_download, elsewhere;
+    CHECK(start_client(&heavy_upload, 2001, TUNNEL_ADDRESS, SOCK_STREAM, 200000, 3000, 1));
+    CHECK(start_client(&heavy_download, 2002, TUNNEL_ADDRESS, SOCK_STREAM, 50000, 70000, 1));
+    CHECK(start_client(&elsewhere, 2003, OTHER_ADDRESS, SOCK_STREAM, 1000, 1000, 1));
+    CHECK(singbox_uidstats_refresh(stats));
+
+    // The 8-byte request header counts as upload too
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 2001, &usage));
+    CHECK_EQ_INT(usage.upload_bytes, 200008);
+    CHECK_EQ_INT(usage.download_bytes, 3000);
+    CHECK_EQ_INT(usage.tcp_flows, 1);
+    CHECK_EQ_INT(usage.flows, 1);
+    CHECK(singbox_uidstats_get(stats, 2002, &usage));
+    CHECK_EQ_INT(usage.upload_bytes, 50008);
+    CHECK_EQ_INT(usage.download_bytes, 70000);
+
+    // Outside the tunnel prefix, and the server's ends on 127.0.0.1
+    CHECK(!singbox_uidstats_get(stats, 2003, &usage));
+    CHECK(!singbox_uidstats_get(stats, 0, &usage));
+
+    singbox_uid_usage_t list[4];
+    CHECK_EQ_INT(singbox_uidstats_list(stats, list, 4), 2);
+    CHECK_EQ_INT(list[0].uid, 2001);
+    CHECK_EQ_INT(list[1].uid, 2002);
+
+    // Another refresh without traffic adds nothing
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2001, &usage));
+    CHECK_EQ_INT(usage.upload_bytes, 200008);
+
+    // Closed flows leave the open counts but keep their bytes
+    stop_client(&heavy_upload);
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2001, &usage));
+    CHECK_EQ_INT(usage.tcp_flows, 0);
+    CHECK_EQ_INT(usage.upload_bytes, 200008);
+    singbox_uidstats_stats_t counters;
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.flows_open, 1);
+    CHECK_EQ_INT(counters.uids, 2);
+
+    stop_client(&heavy_download);
+    stop_client(&elsewhere);
+    singbox_uidstats_close(stats);
+}
+
+static void test_refresh_is_incremental(void) {
+    singbox_uidstats_t* stats = open_tunnel_stats(0);
+    if (!stats) {
+        CHECK(stats != NULL);
+        return;
+    }
+    client_t client;
+    CHECK(start_client(&client, 2004, TUNNEL_ADDRESS, SOCK_DGRAM, 0, 0, 1));
+
+    // The first refresh takes everything: TCP and UDP, both families
+    singbox_uidstats_stats_t counters;
+    CHECK(singbox_uidstats_refresh(stats));
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.dumps, 4);
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 2004, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 1);
+    CHECK_EQ_INT(usage.upload_bytes, 0);
+
+    // Later ones leave UDP alone until a UDP connection is reported
+    CHECK(singbox_uidstats_refresh(stats));
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.dumps, 6);
+    note_port(stats, SINGBOX_NETWORK_UDP, client.port);
+    CHECK(singbox_uidstats_refresh(stats));
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.dumps, 10);
+    CHECK(singbox_uidstats_get(stats, 2004, &usage));
+    CHECK_EQ_INT(usage.connections, 1);
+
+    // ...or the periodic sweep comes round
+    stop_client(&client);
+    for (int i = 3; i < SINGBOX_UIDSTATS_UDP_SWEEP; i++) {
+        CHECK(singbox_uidstats_refresh(stats));
+    }
+    CHECK(singbox_uidstats_get(stats, 2004, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 1);
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2004, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 0);
+    singbox_uidstats_close(stats);
+}
+
+static void test_connections_are_credited(void) {
+    singbox_uidstats_t* stats = open_tunnel_stats(0);
+    if (!stats) {
+        CHECK(stats != NULL);
+        return;
+    }
+    client_t first, second;
+    CHECK(start_client(&first, 2005, TUNNEL_ADDRESS, SOCK_STREAM, 100, 100, 1));
+    CHECK(start_client(&second, 2006, TUNNEL_ADDRESS, SOCK_STREAM, 100, 100, 1));
+
+    // Reported before and after the socket is first seen, as logged by sing-box
+    note_port(stats, SINGBOX_NETWORK_TCP, first.port);
+    CHECK(singbox_uidstats_refresh(stats));
+    note_port(stats, SINGBOX_NETWORK_TCP, second.port);
+    // A UDP report never matches a TCP socket on the same port
+    note_port(stats, SINGBOX_NETWORK_UDP, first.port);
+    singbox_uidstats_note_connection(stats, SINGBOX_NETWORK_TCP, "garbage", 7);
+    CHECK(singbox_uidstats_refresh(stats));
+
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 2005, &usage));
+    CHECK_EQ_INT(usage.connections, 1);
+    CHECK(singbox_uidstats_get(stats, 2006, &usage));
+    CHECK_EQ_INT(usage.connections, 1);
+
+    for (int i = 0; i < SINGBOX_UIDSTATS_PENDING_REFRESHES; i++) {
+        CHECK(singbox_uidstats_refresh(stats));
+    }
+    singbox_uidstats_stats_t counters;
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.connections_attributed, 2);
+    CHECK_EQ_INT(counters.connections_unattributed, 1);
+
+    char json[1024];
+    CHECK(singbox_uidstats_format_json(stats, 8, json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"source\":\"sock_diag\"") != NULL);
+    CHECK(strstr(json, "\"uid\":2005,\"upload_bytes\":108,\"download_bytes\":100,\"tcp_flows\":1") != NULL);
+    CHECK_EQ_INT(singbox_uidstats_format_json(stats, 8, json, 16), -1);
+
+    // A reset forgets totals but keeps counting the open flows from here
+    singbox_uidstats_reset(stats);
+    CHECK(singbox_uidstats_get(stats, 2005, &usage));
+    CHECK_EQ_INT(usage.upload_bytes, 0);
+    CHECK_EQ_INT(usage.connections, 0);
+    CHECK_EQ_INT(usage.tcp_flows, 1);
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2005, &usage));
+    CHECK_EQ_INT(usage.upload_bytes, 0);
+
+    stop_client(&first);
+    stop_client(&second);
+    singbox_uidstats_close(stats);
+}
+
+static void test_many_flows_grow_and_shrink(void) {
+    singbox_uidstats_t* stats = open_tunnel_stats(0);
+    if (!stats) {
+        CHECK(stats != NULL);
+        return;
+    }
+    client_t crowd;
+    CHECK(start_client(&crowd, 2007, TUNNEL_ADDRESS, SOCK_DGRAM, 0, 0, 600));
+    CHECK(singbox_uidstats_refresh(stats));
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 2007, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 600);
+
+    client_command(&crowd, 'h');
+    note_port(stats, SINGBOX_NETWORK_UDP, crowd.port);
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2007, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 300);
+    CHECK_EQ_INT(usage.flows, 600);
+    CHECK_EQ_INT(usage.connections, 1);
+
+    // Every remaining flow is still found after the deletions
+    client_command(&crowd, 'h');
+    note_port(stats, SINGBOX_NETWORK_UDP, crowd.port);
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2007, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 150);
+    CHECK_EQ_INT(usage.flows, 600);
+    singbox_uidstats_stats_t counters;
+    singbox_uidstats_get_stats(stats, &counters);
+    CHECK_EQ_INT(counters.flows_open, 150);
+
+    stop_client(&crowd);
+    singbox_uidstats_close(stats);
+}
+
+static void test_proc_fallback(void) {
+    singbox_uidstats_t* stats = open_tunnel_stats(1);
+    if (!stats) {
+        CHECK(stats != NULL);
+        return;
+    }
+    CHECK_EQ_INT(singbox_uidstats_source(stats), SINGBOX_UIDSTATS_PROC_NET);
+
+    client_t tcp, udp, elsewhere;
+    CHECK(start_client(&tcp, 2008, TUNNEL_ADDRESS, SOCK_STREAM, 1000, 1000, 3));
+    CHECK(start_client(&udp, 2009, TUNNEL_ADDRESS, SOCK_DGRAM, 0, 0, 2));
+    CHECK(start_client(&elsewhere, 2010, OTHER_ADDRESS, SOCK_STREAM, 1000, 1000, 1));
+    note_port(stats, SINGBOX_NETWORK_TCP, tcp.port);
+    CHECK(singbox_uidstats_refresh(stats));
+
+    // Owners and flows without byte counts
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 2008, &usage));
+    CHECK_EQ_INT(usage.tcp_flows, 3);
+    CHECK_EQ_INT(usage.upload_bytes, 0);
+    CHECK_EQ_INT(usage.connections, 1);
+    CHECK(singbox_uidstats_get(stats, 2009, &usage));
+    CHECK_EQ_INT(usage.udp_flows, 2);
+    CHECK(!singbox_uidstats_get(stats, 2010, &usage));
+
+    client_command(&tcp, 'h');
+    CHECK(singbox_uidstats_refresh(stats));
+    CHECK(singbox_uidstats_get(stats, 2008, &usage));
+    CHECK_EQ_INT(usage.tcp_flows, 1);
+
+    char json[1024];
+    CHECK(singbox_uidstats_format_json(stats, 8, json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"source\":\"proc_net\"") != NULL);
+
+    stop_client(&tcp);
+    stop_client(&udp);
+    stop_client(&elsewhere);
+    singbox_uidstats_close(stats);
+}
+
+static void test_interface_prefixes(void) {
+    singbox_uidstats_t* stats = singbox_uidstats_open(0);
+    if (!stats) {
+        CHECK(stats != NULL);
+        return;
+    }
+    CHECK(singbox_uidstats_add_interface(stats, "lo") >= 1);
+    CHECK_EQ_INT(singbox_uidstats_add_interface(stats, "no-such-if0"), 0);
+    struct in_addr any = { 0 };
+    CHECK(!singbox_uidstats_add_prefix(stats, AF_INET, &any, 33));
+    CHECK(!singbox_uidstats_add_prefix(stats, AF_UNIX, &any, 0));
+    // Loopback's own address is 127.0.0.1: the UDP server socket counts now
+    CHECK(singbox_uidstats_refresh(stats));
+    singbox_uid_usage_t usage;
+    CHECK(singbox_uidstats_get(stats, 0, &usage));
+    CHECK(usage.udp_flows >= 1);
+    singbox_uidstats_close(stats);
+}
+
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+    if (geteuid() != 0) {
+        printf("[SKIP] running sockets under other UIDs needs root\n");
+        return 0;
+    }
+    if (!start_servers()) {
+        printf("[SKIP] loopback servers unavailable: %s\n", strerror(errno));
+        return 0;
+    }
+
+    RUN_TEST(test_attributes_tcp_bytes_to_owners);
+    RUN_TEST(test_refresh_is_incremental);
+    RUN_TEST(test_connections_are_credited);
+    RUN_TEST(test_many_flows_grow_and_shrink);
+    RUN_TEST(test_proc_fallback);
+    RUN_TEST(test_interface_prefixes);
+    kill(server_pid, SIGKILL);
+    waitpid(server_pid, NULL, 0);
+    return TEST_EXIT();
+}
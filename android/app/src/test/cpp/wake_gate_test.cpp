@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "WakeGate.h"
+#include "test_util.h"
+
+/*
+ * The wait of the Windows runner's background loops. A loop thread counts
+ * its rounds the way the plugin's connection monitor runs them; the test
+ * plays the connection going up and down.
+ */
+
+using std::chrono::milliseconds;
+
+struct Loop {
+    WakeGate& gate;
+    std::atomic<int> rounds{0};
+    std::thread thread;
+
+    Loop(WakeGate& gate, milliseconds interval) : gate(gate) {
+        thread = std::thread([this, interval]() {
+            while (this->gate.Wait(interval)) {
+                rounds++;
+            }
+        });
+    }
+
+    ~Loop() {
+        gate.Stop();
+        thread.join();
+    }
+};
+
+static bool wait_until_parked(const WakeGate& gate) {
+    for (int i = 0; i < 1000; i++) {
+        if (gate.GetStats().parked) {
+            return true;
+        }
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return false;
+}
+
+static void test_idle_loop_never_wakes(void) {
+    WakeGate gate;
+    Loop loop(gate, milliseconds(1));
+    CHECK(wait_until_parked(gate));
+    std::this_thread::sleep_for(milliseconds(200));
+
+    WakeGate::Stats stats = gate.GetStats();
+    CHECK_EQ_INT(loop.rounds.load(), 0);
+    CHECK_EQ_INT(stats.wakeups, 0);
+    CHECK_EQ_INT(stats.idle_wakeups_last_minute, 0);
+    CHECK_EQ_INT(stats.parks, 1);
+}
+
+static void test_transitions_wake_and_park(void) {
+    WakeGate gate;
+    Loop loop(gate, milliseconds(5));
+    CHECK(wait_until_parked(gate));
+
+    // Connecting runs a round at once, then one per interval
+    gate.SetActive(true);
+    std::this_thread::sleep_for(milliseconds(100));
+    int active_rounds = loop.rounds.load();
+    CHECK(active_rounds >= 5);
+    CHECK(!gate.GetStats().parked);
+
+    // Disconnecting parks the loop without another round
+    gate.SetActive(false);
+    CHECK(wait_until_parked(gate));
+    int rounds = loop.rounds.load();
+    CHECK(rounds - active_rounds <= 1);
+    uint64_t wakeups = gate.GetStats().wakeups;
+    std::this_thread::sleep_for(milliseconds(100));
+    WakeGate::Stats stats = gate.GetStats();
+    CHECK_EQ_INT(loop.rounds.load(), rounds);
+    CHECK_EQ_INT(stats.wakeups, wakeups);
+    CHECK_EQ_INT(stats.idle_wakeups, 0);
+    CHECK_EQ_INT(stats.parks, 2);
+    CHECK(stats.wakeups_last_minute > 0);
+}
+
+static bool wait_for_rounds(const Loop& loop, int rounds) {
+    for (int i = 0; i < 1000 && loop.rounds.load() < rounds; i++) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return loop.rounds.load() == rounds;
+}
+
+static void test_notify_runs_one_round(void) {
+    WakeGate gate;
+    Loop loop(gate, std::chrono::hours(1));
+    CHECK(wait_until_parked(gate));
+    gate.Notify();
+    CHECK(wait_for_rounds(loop, 1));
+    CHECK(wait_until_parked(gate));
+    CHECK_EQ_INT(loop.rounds.load(), 1);
+
+    // Activation and notifications cut a long interval short
+    gate.SetActive(true);
+    CHECK(wait_for_rounds(loop, 2));
+    gate.Notify();
+    CHECK(wait_for_rounds(loop, 3));
+    CHECK_EQ_INT(gate.GetStats().idle_wakeups, 0);
+}
+
+static void test_stop_and_reset(void) {
+    WakeGate gate(true);
+    uint64_t begin = test_now_ns();
+    {
+        // Stopping does not wait out the interval
+        Loop loop(gate, std::chrono::hours(1));
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    CHECK(test_now_ns() - begin < 1000000000ull);
+    CHECK(!gate.Wait(milliseconds(1)));
+
+    gate.Reset();
+    CHECK(gate.Wait(milliseconds(1)));
+    CHECK(gate.GetStats().wakeups >= 1);
+}
+
+int main(void) {
+    RUN_TEST(test_idle_loop_never_wakes);
+    RUN_TEST(test_transitions_wake_and_park);
+    RUN_TEST(test_notify_runs_one_round);
+    RUN_TEST(test_stop_and_reset);
+    return TEST_EXIT();
+}
@@ -0,0 +1,75 @@
+import 'dart:async';
+import '../models/vpn_configuration.dart';
+import '../models/vpn_status.dart';
+import '../models/network_stats.dart';
+import 'tunnelmax_core_ffi.dart';
+import 'windows_vpn_control.dart';
+
+/// Linux implementation of VPN control interface
+///
+/// The Linux runner's plugin speaks the Windows plugin's channels, so
+/// commands and pushed events go through [WindowsVpnControl]. The runner
+/// links libtunnelmax_core into this process, though, so status and
+/// statistics are read straight from the core instead of a channel round
+/// trip. Without a usable core library every call falls back to the
+/// channels.
+class LinuxVpnControl extends WindowsVpnControl {
+  final TunnelmaxCore? _core = TunnelmaxCore.open();
+  StreamSubscription<VpnStatus>? _errorSubscription;
+
+  // The core knows nothing about servers or why the runner gave up, so
+  // those come from the calls and events that pass through here
+  String? _server;
+  String? _lastError;
+
+  LinuxVpnControl() {
+    _errorSubscription = statusStream().listen((status) {
+      _lastError = status.lastError;
+    });
+  }
+
+  @override
+  Future<bool> connect(VpnConfiguration config) async {
+    _server = config.serverAddress;
+    _lastError = null;
+    return super.connect(config);
+  }
+
+  @override
+  Future<VpnStatus> getStatus() async {
+    final core = _core;
+    if (core == null) {
+      return super.getStatus();
+    }
+    switch (core.state) {
+      case TunnelmaxCore.stateStarting:
+        return VpnStatus.connecting(server: _server ?? '');
+      case TunnelmaxCore.stateRunning:
+        final stats = core.readStats();
+        return VpnStatus.connected(
+          server: _server ?? '',
+          connectionStartTime: DateTime.now().subtract(stats?.connectionDuration ?? Duration.zero),
+          stats: stats,
+        );
+      case TunnelmaxCore.stateStopping:
+        return VpnStatus(state: VpnConnectionState.disconnecting, connectedServer: _server);
+      default:
+        return VpnStatus.disconnected(lastError: _lastError);
+    }
+  }
+
+  @override
+  Future<NetworkStats?> getNetworkStats() async {
+    final core = _core;
+    if (core == null) {
+      return super.getNetworkStats();
+    }
+    return core.isRunning ? core.readStats() : null;
+  }
+
+  @override
+  void dispose() {
+    _errorSubscription?.cancel();
+    super.dispose();
+  }
+}
@@ -2,6 +2,7 @@ import 'dart:io';
 import '../interfaces/vpn_control_interface.dart';
 import '../interfaces/configuration_interface.dart';
 import 'windows_vpn_control.dart';
+import 'linux_vpn_control.dart';
 import 'android_vpn_control.dart';
 import 'windows_configuration.dart';
 import 'android_configuration.dart';
@@ -30,6 +31,8 @@ class PlatformFactory {
   static VpnControlInterface _createVpnControl() {
     if (Platform.isWindows) {
       return WindowsVpnControl();
+    } else if (Platform.isLinux) {
+      return LinuxVpnControl();
     } else if (Platform.isAndroid) {
       return AndroidVpnControl();
     } else {
@@ -39,7 +42,7 @@ class PlatformFactory {
 
   /// Creates the appropriate configuration implementation for the current platform
   static ConfigurationInterface _createConfiguration() {
-    if (Platform.isWindows) {
+    if (Platform.isWindows || Platform.isLinux) {
       return WindowsConfiguration();
     } else if (Platform.isAndroid) {
       return AndroidConfiguration();
@@ -61,12 +64,13 @@ class PlatformFactory {
 
   /// Checks if the current platform is supported
   static bool get isSupported {
-    return Platform.isWindows || Platform.isAndroid;
+    return Platform.isWindows || Platform.isLinux || Platform.isAndroid;
   }
 
   /// Gets the current platform name
   static String get platformName {
     if (Platform.isWindows) return 'Windows';
+    if (Platform.isLinux) return 'Linux';
     if (Platform.isAndroid) return 'Android';
     return 'Unsupported';
   }
@@ -0,0 +1,277 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import '../models/network_stats.dart';
+
+typedef _AbiVersionNative = Uint32 Function();
+typedef _AbiVersion = int Function();
+typedef _StateNative = Int32 Function();
+typedef _State = int Function();
+typedef _StatsRegionNative = Pointer<Uint8> Function();
+typedef _StatsRegion = Pointer<Uint8> Function();
+typedef _LogTailNative = Pointer<Uint8> Function(Pointer<Uint64> size);
+typedef _LogTail = Pointer<Uint8> Function(Pointer<Uint64> size);
+
+/// A record decoded from the native log tail ring
+class NativeLogRecord {
+  final int seq;
+  final DateTime timestamp;
+  final String level;
+  final String module;
+  final String message;
+
+  const NativeLogRecord({
+    required this.seq,
+    required this.timestamp,
+    required this.level,
+    required this.module,
+    required this.message,
+  });
+}
+
+/// Reader position in the native log tail ring; one per consumer
+class NativeLogCursor {
+  int offset = -1;
+  int nextSeq = 0;
+
+  /// Records overwritten or cleared before they were read
+  int lost = 0;
+}
+
+/// Direct access to the native core through dart:ffi (libtunnelmax_core,
+/// see android/app/src/main/cpp/sing_box_ffi.h)
+///
+/// Stats and log reads skip the method channel entirely: the shared regions
+/// the core publishes are mapped once as typed data and read in place, with
+/// no codec, no platform thread hop and no map decoding. Lifecycle calls
+/// stay on the method channel.
+class TunnelmaxCore {
+  static const int abiVersion = 1;
+
+  // Layout of singbox_stats_shared_t, version 1 (sing_box_statsmem.h)
+  static const int _statsMagic = 0x54534253; // "SBST"
+  static const int _statsVersion = 1;
+  static const int _statsRegionSize = 128;
+  static const int _offsetSeq = 8;
+  static const int _offsetState = 12;
+  static const int _offsetUploadBytes = 16;
+  static const int _offsetDownloadBytes = 24;
+  static const int _offsetPacketsSent = 32;
+  static const int _offsetPacketsReceived = 40;
+  static const int _offsetUploadSpeed = 48;
+  static const int _offsetDownloadSpeed = 56;
+  static const int _offsetStartedAt = 64;
+  static const int _offsetUpdatedAt = 72;
+  static const int _readRetries = 64;
+
+  // Layout of singbox_logtail_t, version 1 (sing_box_logtail.h)
+  static const int _logTailMagic = 0x544C4253; // "SBLT"
+  static const int _logTailVersion = 1;
+  static const int _logOffsetCapacity = 8;
+  static const int _logOffsetHead = 16;
+  static const int _logOffsetTail = 24;
+  static const int _logData = 64;
+  static const int _logRecordHeader = 24;
+  static const int _logPadding = 0xFF;
+  static const List<String> _levelNames = ['TRACE', 'DEBUG', 'INFO', 'WARN', 'ERROR', 'FATAL'];
+
+  static const int stateStopped = 0;
+  static const int stateStarting = 1;
+  static const int stateRunning = 2;
+  static const int stateStopping = 3;
+
+  final _State _state;
+  final ByteData _stats;
+  final ByteData? _logTail;
+
+  TunnelmaxCore._(this._state, this._stats, this._logTail);
+
+  static TunnelmaxCore? _instance;
+
+  /// Load the core library of this platform
+  ///
+  /// On Android the symbols live in the JNI library the VPN service already
+  /// uses, so the readers see the running core.
+  ///
+  /// Returns null where there is no native core or its ABI does not match.
+  static TunnelmaxCore? open() {
+    if (_instance != null) {
+      return _instance;
+    }
+    final String name;
+    if (Platform.isLinux) {
+      name = 'libtunnelmax_core.so';
+    } else if (Platform.isAndroid) {
+      name = 'libsing_box_jni.so';
+    } else {
+      return null;
+    }
+    try {
+      final library = DynamicLibrary.open(name);
+      final version = library.lookupFunction<_AbiVersionNative, _AbiVersion>('tunnelmax_core_abi_version');
+      if (version() != abiVersion) {
+        return null;
+      }
+      final state = library.lookupFunction<_StateNative, _State>('tunnelmax_core_state');
+      final statsRegion = library.lookupFunction<_StatsRegionNative, _StatsRegion>('tunnelmax_core_stats_region');
+      final logTail = library.lookupFunction<_LogTailNative, _LogTail>('tunnelmax_core_log_tail');
+
+      final stats = statsRegion().asTypedList(_statsRegionSize).buffer.asByteData();
+      if (stats.getUint32(0, Endian.little) != _statsMagic ||
+          stats.getUint16(4, Endian.little) != _statsVersion) {
+        return null;
+      }
+      _instance = TunnelmaxCore._(state, stats, _mapLogTail(logTail));
+      return _instance;
+    } on ArgumentError {
+      return null;
+    } on UnsupportedError {
+      return null;
+    }
+  }
+
+  static ByteData? _mapLogTail(_LogTail logTail) {
+    // The size follows from the header, so no out parameter (and no
+    // allocator) is needed
+    final header = logTail(nullptr);
+    if (header == nullptr) {
+      return null;
+    }
+    final view = header.asTypedList(_logData).buffer.asByteData();
+    final capacity = view.getUint32(_logOffsetCapacity, Endian.little);
+    if (view.getUint32(0, Endian.little) != _logTailMagic ||
+        view.getUint16(4, Endian.little) != _logTailVersion ||
+        view.getUint16(6, Endian.little) != _logData ||
+        capacity == 0 || capacity % 8 != 0) {
+      return null;
+    }
+    return header.asTypedList(_logData + capacity).buffer.asByteData();
+  }
+
+  /// Lifecycle state of the core; one call, no channel
+  int get state => _state();
+
+  bool get isRunning => state == stateRunning;
+
+  /// One consistent snapshot of the traffic counters
+  ///
+  /// Returns null if a writer kept the region busy for every retry.
+  NetworkStats? readStats() {
+    for (var attempt = 0; attempt < _readRetries; attempt++) {
+      final before = _stats.getUint32(_offsetSeq, Endian.little);
+      if (before & 1 != 0) {
+        continue;
+      }
+      final state = _stats.getUint32(_offsetState, Endian.little);
+      final uploadBytes = _stats.getInt64(_offsetUploadBytes, Endian.little);
+      final downloadBytes = _stats.getInt64(_offsetDownloadBytes, Endian.little);
+      final packetsSent = _stats.getInt64(_offsetPacketsSent, Endian.little);
+      final packetsReceived = _stats.getInt64(_offsetPacketsReceived, Endian.little);
+      final uploadSpeed = _stats.getFloat64(_offsetUploadSpeed, Endian.little);
+      final downloadSpeed = _stats.getFloat64(_offsetDownloadSpeed, Endian.little);
+      final startedAtMs = _stats.getInt64(_offsetStartedAt, Endian.little);
+      final updatedAtMs = _stats.getInt64(_offsetUpdatedAt, Endian.little);
+      if (_stats.getUint32(_offsetSeq, Endian.little) != before) {
+        continue;
+      }
+
+      final now = DateTime.now();
+      final running = state == stateRunning && startedAtMs > 0;
+      return NetworkStats(
+        bytesReceived: downloadBytes,
+        bytesSent: uploadBytes,
+        connectionDuration: running
+            ? now.difference(DateTime.fromMillisecondsSinceEpoch(startedAtMs))
+            : Duration.zero,
+        downloadSpeed: downloadSpeed,
+        uploadSpeed: uploadSpeed,
+        packetsReceived: packetsReceived,
+        packetsSent: packetsSent,
+        lastUpdated: updatedAtMs > 0 ? DateTime.fromMillisecondsSinceEpoch(updatedAtMs) : now,
+      );
+    }
+    return null;
+  }
+
+  /// Start a log cursor at the oldest record held, or only at records
+  /// written from now on when [newest] is true
+  NativeLogCursor logCursor({bool newest = false}) {
+    final cursor = NativeLogCursor();
+    final tail = _logTail;
+    if (tail != null) {
+      cursor.offset = tail.getUint64(newest ? _logOffsetHead : _logOffsetTail, Endian.little);
+    }
+    return cursor;
+  }
+
+  /// Decode the log records published since [cursor], oldest first
+  ///
+  /// Native code retires records by advancing `tail` before reusing their
+  /// bytes, so a record is copied out first and kept only if `tail` has not
+  /// passed it.
+  List<NativeLogRecord> pollLogs(NativeLogCursor cursor, {int maxRecords = 0}) {
+    final tail = _logTail;
+    final records = <NativeLogRecord>[];
+    if (tail == null) {
+      return records;
+    }
+    final capacity = tail.getUint32(_logOffsetCapacity, Endian.little);
+    final head = tail.getUint64(_logOffsetHead, Endian.little);
+    if (cursor.offset < 0 || cursor.offset > head) {
+      cursor.offset = tail.getUint64(_logOffsetTail, Endian.little);
+    }
+
+    while (cursor.offset < head && (maxRecords <= 0 || records.length < maxRecords)) {
+      final oldest = tail.getUint64(_logOffsetTail, Endian.little);
+      if (cursor.offset < oldest) {
+        cursor.offset = oldest;
+        continue;
+      }
+
+      final offset = cursor.offset;
+      final position = _logData + offset % capacity;
+      final size = tail.getUint32(position, Endian.little);
+      final valid = size >= 8 && size % 8 == 0 && position + size <= _logData + capacity;
+      final copy = valid ? Uint8List.fromList(tail.buffer.asUint8List(tail.offsetInBytes + position, size)) : null;
+      if (tail.getUint64(_logOffsetTail, Endian.little) > offset) {
+        continue;
+      }
+      if (copy == null) {
+        // Not a record we can decode; resynchronise at the newest one
+        cursor.offset = head;
+        break;
+      }
+
+      final record = ByteData.sublistView(copy);
+      final level = copy[4];
+      cursor.offset += size;
+      if (level == _logPadding) {
+        continue;
+      }
+      final moduleLength = copy[5];
+      final messageLength = record.getUint16(6, Endian.little);
+      if (_logRecordHeader + moduleLength + messageLength > size) {
+        cursor.offset = head;
+        break;
+      }
+      final seq = record.getUint64(8, Endian.little);
+      if (cursor.nextSeq != 0 && seq > cursor.nextSeq) {
+        cursor.lost += seq - cursor.nextSeq;
+      }
+      cursor.nextSeq = seq + 1;
+
+      final moduleStart = _logRecordHeader;
+      final messageStart = moduleStart + moduleLength;
+      records.add(NativeLogRecord(
+        seq: seq,
+        timestamp: DateTime.fromMillisecondsSinceEpoch(record.getInt64(16, Endian.little)),
+        level: level < _levelNames.length ? _levelNames[level] : 'INFO',
+        module: utf8.decode(copy.sublist(moduleStart, messageStart), allowMalformed: true),
+        message: utf8.decode(copy.sublist(messageStart, messageStart + messageLength), allowMalformed: true),
+      ));
+    }
+    return records;
+  }
+}
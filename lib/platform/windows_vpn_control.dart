@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:typed_data';
 import 'package:flutter/services.dart';
 import '../interfaces/vpn_control_interface.dart';
 import '../models/vpn_configuration.dart';
@@ -12,10 +13,15 @@ import '../models/network_stats.dart';
 class WindowsVpnControl implements VpnControlInterface {
   static const MethodChannel _channel = MethodChannel('vpn_control');
   static const EventChannel _statusChannel = EventChannel('vpn_status');
+  static const EventChannel _statsChannel = EventChannel('vpn_stats');
   
   StreamController<VpnStatus>? _statusController;
   StreamSubscription? _statusSubscription;
 
+  // Sections of getDetailedStatus as last received, with their versions
+  final Map<String, int> _sectionVersions = {};
+  final Map<String, dynamic> _sections = {};
+
   WindowsVpnControl() {
     _initializeStatusStream();
   }
@@ -54,6 +60,10 @@ class WindowsVpnControl implements VpnControlInterface {
       });
       return result == true;
     } on PlatformException catch (e) {
+      if (e.code == 'SUPERSEDED') {
+        // A later connect or disconnect replaced this one before it ran
+        return false;
+      }
       throw VpnException(
         e.message ?? 'Connection failed',
         code: e.code,
@@ -70,6 +80,10 @@ class WindowsVpnControl implements VpnControlInterface {
       final result = await _channel.invokeMethod('disconnect');
       return result == true;
     } on PlatformException catch (e) {
+      if (e.code == 'SUPERSEDED') {
+        // A later connect or disconnect replaced this one before it ran
+        return false;
+      }
       throw VpnException(
         e.message ?? 'Disconnection failed',
         code: e.code,
@@ -123,6 +137,113 @@ class WindowsVpnControl implements VpnControlInterface {
     }
   }
 
+  /// Live statistics with credit-based flow control.
+  ///
+  /// Native keeps at most [window] samples in flight and each one is
+  /// acknowledged once the listeners have handled it, so a busy UI isolate
+  /// slows the stream down instead of letting samples pile up. When credits
+  /// run out native either coalesces to the newest sample (`'coalesce'`) or
+  /// skips samples until the next acknowledgement (`'drop'`).
+  ///
+  /// With [autoAck] false the listener acknowledges through [ackStats]
+  /// instead, once it has finished with a sample (or an error event), for
+  /// handling that continues past the synchronous listener call.
+  Stream<NetworkStats> statsStream({int window = 4, String policy = 'coalesce', bool autoAck = true}) {
+    late final StreamController<NetworkStats> controller;
+    StreamSubscription? subscription;
+    controller = StreamController<NetworkStats>(
+      // Synchronous delivery: the listener has run by the time add() returns
+      sync: true,
+      onListen: () {
+        subscription = _statsChannel
+            .receiveBroadcastStream({'window': window, 'policy': policy})
+            .listen(
+          (dynamic event) {
+            if (event is! Map) {
+              // Nothing reaches the listener, so nobody else would return it
+              ackStats();
+              return;
+            }
+            try {
+              controller.add(NetworkStats.fromJson(Map<String, dynamic>.from(event)));
+            } catch (e) {
+              controller.addError(VpnException('Stats parsing error: $e'));
+            }
+            if (autoAck) {
+              ackStats();
+            }
+          },
+          onError: controller.addError,
+        );
+      },
+      onCancel: () => subscription?.cancel(),
+    );
+    return controller.stream;
+  }
+
+  /// Return [count] credits to [statsStream]
+  Future<void> ackStats([int count = 1]) async {
+    await _channel.invokeMethod('ackStats', {'count': count}).catchError((_) => null);
+  }
+
+  /// Flow control counters of [statsStream]: credits, queue depth, sent,
+  /// acknowledged, coalesced and dropped samples
+  Future<Map<String, dynamic>> getStatsStreamInfo() async {
+    try {
+      final result = await _channel.invokeMethod('getStatsStreamInfo');
+      return result is Map ? Map<String, dynamic>.from(result) : {};
+    } on PlatformException catch (e) {
+      throw VpnException(
+        e.message ?? 'Failed to get stats stream info',
+        code: e.code,
+        details: e.details,
+      );
+    }
+  }
+
+  /// Status with the sing-box, network, stats and executor details
+  ///
+  /// The plugin versions each section and sends only those that changed
+  /// since the versions passed in, encoded; the rest come from the copies
+  /// kept here. `snapshot` reports the plugin's encode and pass costs.
+  Future<Map<String, dynamic>> getDetailedStatus() async {
+    try {
+      final result = await _channel.invokeMethod('getDetailedStatus', {
+        'versions': Map<String, int>.from(_sectionVersions),
+      });
+      if (result is! Map) {
+        return {};
+      }
+      final status = Map<String, dynamic>.from(result);
+      final sections = status.remove('sections');
+      final versions = status.remove('sectionVersions');
+      if (sections is Map) {
+        const codec = StandardMessageCodec();
+        sections.forEach((name, bytes) {
+          if (bytes is Uint8List) {
+            _sections[name as String] =
+                codec.decodeMessage(ByteData.sublistView(bytes));
+          }
+        });
+      }
+      if (versions is Map) {
+        // Sections the plugin no longer reports are dropped
+        _sections.removeWhere((name, _) => !versions.containsKey(name));
+        _sectionVersions
+          ..clear()
+          ..addAll(versions.map((name, version) =>
+              MapEntry(name as String, (version as num).toInt())));
+      }
+      return {...status, ..._sections};
+    } on PlatformException catch (e) {
+      throw VpnException(
+        e.message ?? 'Failed to get detailed status',
+        code: e.code,
+        details: e.details,
+      );
+    }
+  }
+
   @override
   Future<bool> hasVpnPermission() async {
     try {
@@ -1,11 +1,19 @@
+import 'dart:async';
+import 'dart:io';
+
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:logger/logger.dart';
 
+import '../interfaces/vpn_control_interface.dart';
 import '../models/connection_history.dart';
 import '../models/network_stats.dart';
+import '../platform/platform_factory.dart';
+import '../platform/windows_vpn_control.dart';
 import '../services/connection_history_service.dart';
 import '../services/connection_monitor.dart';
+import '../services/unified_singbox_manager.dart';
 import 'vpn_provider.dart';
+import 'vpn_service_provider.dart' show vpnControlInterfaceProvider;
 
 /// Provider for the connection history service
 final connectionHistoryServiceProvider = Provider<ConnectionHistoryService>((ref) {
@@ -27,8 +35,8 @@ final connectionHistoryServiceProvider = Provider<ConnectionHistoryService>((ref
 
 /// Provider for current network statistics
 final currentNetworkStatsProvider = StreamProvider<NetworkStats?>((ref) {
-  final connectionMonitor = ref.watch(connectionMonitorProvider);
-  return connectionMonitor.statsStream;
+  final statisticsMonitor = ref.watch(statisticsMonitorProvider);
+  return statisticsMonitor.statsStream;
 });
 
 /// Provider for connection history
@@ -71,6 +79,16 @@ final dailyUsageProvider = FutureProvider<List<DailyUsage>>((ref) async {
   return historyService.getDailyUsage(days: 30);
 });
 
+/// Provider for tunnel traffic per application, from the Android plugin;
+/// null on other platforms or when the plugin cannot report it
+final appUsageProvider = FutureProvider.autoDispose<Map<String, dynamic>?>((ref) async {
+  final vpnControl = ref.watch(vpnControlInterfaceProvider);
+  if (!Platform.isAndroid || vpnControl is! UnifiedSingboxManager) {
+    return null;
+  }
+  return vpnControl.getAppUsage();
+});
+
 /// Provider for real-time statistics monitoring
 final statisticsMonitorProvider = Provider<StatisticsMonitor>((ref) {
   final connectionMonitor = ref.watch(connectionMonitorProvider);
@@ -81,6 +99,7 @@ final statisticsMonitorProvider = Provider<StatisticsMonitor>((ref) {
     connectionMonitor: connectionMonitor,
     historyService: historyService,
     vpnService: vpnService,
+    vpnControl: PlatformFactory.getVpnControl(),
   );
   
   ref.onDispose(() {
@@ -94,20 +113,32 @@ final statisticsMonitorProvider = Provider<StatisticsMonitor>((ref) {
 class StatisticsMonitor {
   final ConnectionMonitor _connectionMonitor;
   final ConnectionHistoryService _historyService;
+  final VpnControlInterface _vpnControl;
   final Logger _logger = Logger();
   
   bool _isInitialized = false;
   String? _currentSessionId;
 
+  // Samples of the platform's flow-controlled stream, passed on to the UI
+  StreamController<NetworkStats>? _streamedStats;
+  StreamSubscription<NetworkStats>? _statsSubscription;
+  NetworkStats? _latestStats;
+
   StatisticsMonitor({
     required ConnectionMonitor connectionMonitor,
     required ConnectionHistoryService historyService,
     required dynamic vpnService,
+    required VpnControlInterface vpnControl,
   })  : _connectionMonitor = connectionMonitor,
-        _historyService = historyService {
+        _historyService = historyService,
+        _vpnControl = vpnControl {
     _initialize();
   }
 
+  /// Statistics as they arrive: from the platform's flow-controlled stream
+  /// where there is one, otherwise as polled by the connection monitor
+  Stream<NetworkStats> get statsStream => _streamedStats?.stream ?? _connectionMonitor.statsStream;
+
   void _initialize() {
     if (_isInitialized) return;
     
@@ -118,7 +149,20 @@ class StatisticsMonitor {
       _connectionMonitor.statusStream.listen(_handleStatusChange);
       
       // Listen to network stats to update current session
-      _connectionMonitor.statsStream.listen(_handleStatsUpdate);
+      final vpnControl = _vpnControl;
+      if (vpnControl is WindowsVpnControl && _connectionMonitor.pushesStats) {
+        // Synchronous, so the UI listeners have run by the time add() returns
+        _streamedStats = StreamController<NetworkStats>.broadcast(sync: true);
+        _statsSubscription = vpnControl.statsStream(autoAck: false).listen(
+          (stats) => _handleStreamedStats(vpnControl, stats),
+          onError: (error) {
+            _logger.w('Statistics stream error: $error');
+            vpnControl.ackStats();
+          },
+        );
+      } else {
+        _connectionMonitor.statsStream.listen(_handleStatsUpdate);
+      }
       
       _isInitialized = true;
       _logger.d('Statistics monitor initialized');
@@ -154,6 +198,7 @@ class StatisticsMonitor {
       final serverName = status.connectedServer ?? 'Unknown Server';
       
       _logger.d('Starting session tracking for server: $serverName');
+      _latestStats = null;
       
       _historyService.startSession(
         serverName: serverName,
@@ -203,7 +248,7 @@ class StatisticsMonitor {
       _historyService.endSession(
         disconnectionReason: disconnectionReason,
         wasSuccessful: wasSuccessful,
-        finalStats: _connectionMonitor.currentStats,
+        finalStats: _latestStats ?? _connectionMonitor.currentStats,
       ).then((_) {
         _currentSessionId = null;
         _logger.d('Session tracking ended');
@@ -227,9 +272,27 @@ class StatisticsMonitor {
     }
   }
 
+  // The credit goes back only once the UI and the session history are done
+  // with the sample, so native holds further samples while either lags
+  Future<void> _handleStreamedStats(WindowsVpnControl vpnControl, NetworkStats stats) async {
+    try {
+      _latestStats = stats;
+      _streamedStats?.add(stats);
+      if (_currentSessionId != null) {
+        await _historyService.updateSessionStats(stats);
+      }
+    } catch (e) {
+      _logger.w('Failed to update session stats: $e');
+    } finally {
+      vpnControl.ackStats();
+    }
+  }
+
   void dispose() {
     _logger.d('Disposing statistics monitor');
-    // Stream subscriptions are automatically cancelled when providers are disposed
+    _statsSubscription?.cancel();
+    _streamedStats?.close();
+    // The remaining subscriptions are cancelled when providers are disposed
   }
 }
 
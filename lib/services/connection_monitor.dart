@@ -6,6 +6,7 @@ import 'package:connectivity_plus/connectivity_plus.dart';
 import '../models/vpn_status.dart';
 import '../models/network_stats.dart';
 import '../interfaces/vpn_control_interface.dart';
+import '../platform/windows_vpn_control.dart';
 
 /// Connection monitoring service for real-time VPN status tracking
 /// 
@@ -62,8 +63,15 @@ class ConnectionMonitor {
   Stream<VpnStatus> get statusStream => _statusController!.stream;
 
   /// Stream of network statistics updates
+  ///
+  /// Stays silent where [pushesStats] is true.
   Stream<NetworkStats> get statsStream => _statsController!.stream;
 
+  /// Whether the platform pushes statistics over its flow-controlled stream
+  /// (Windows and Linux), which the statistics monitor consumes; there is no
+  /// polling then
+  bool get pushesStats => _vpnControl is WindowsVpnControl;
+
   /// Current VPN status
   VpnStatus get currentStatus => _currentStatus;
 
@@ -297,6 +305,9 @@ class ConnectionMonitor {
 
   void _startStatsMonitoring() {
     _stopStatsMonitoring();
+    if (pushesStats) {
+      return;
+    }
     
     _statsMonitorTimer = Timer.periodic(_statsMonitorInterval, (timer) async {
       await _updateStats();
@@ -338,6 +349,9 @@ class ConnectionMonitor {
   }
 
   Future<void> _updateStats() async {
+    if (pushesStats) {
+      return;
+    }
     try {
       if (!_currentStatus.isConnected) {
         // Clear stats if not connected
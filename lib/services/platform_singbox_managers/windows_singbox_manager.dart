@@ -10,6 +10,7 @@ import '../../models/vpn_configuration.dart';
 import '../../models/network_stats.dart';
 import '../../models/singbox_error.dart' as ErrorModels;
 import '../singbox_configuration_converter.dart';
+import '../singbox_error_mapper.dart';
 
 /// Windows-specific implementation of SingboxManager using process management
 /// 
@@ -722,7 +723,23 @@ class WindowsSingboxManager implements SingboxManagerInterface {
   Future<void> _handleNativeError(dynamic arguments) async {
     try {
       final errorMap = Map<String, dynamic>.from(arguments);
-      final error = ErrorModels.SingboxError.fromJson(errorMap);
+      final nativeCode = errorMap['nativeCode'] as String?;
+      // The runner classifies the native message itself; map by its code
+      // instead of re-scanning the text
+      final error = nativeCode != null
+          ? SingboxErrorMapper.mapNativeError(
+              nativeErrorMessage: errorMap['nativeMessage'] as String? ??
+                  errorMap['error'] as String? ?? '',
+              nativeErrorCode: nativeCode,
+              context: {
+                'category': errorMap['category'],
+                'severity': errorMap['severity'],
+                'isRecoverable': errorMap['isRecoverable'],
+                'matchedSignature': errorMap['matchedSignature'],
+                'connectionState': errorMap['connectionState'],
+              },
+            )
+          : ErrorModels.SingboxError.fromJson(errorMap);
       await _setError(error);
       _logger.e('Native error received: ${error.userMessage}');
     } catch (e) {
@@ -7,8 +7,10 @@ import '../models/singbox_error.dart';
 class SingboxErrorMapper {
   /// Maps a native error message to a structured SingboxError
   /// 
-  /// This method analyzes the native error message and attempts to categorize it
-  /// based on common error patterns and keywords.
+  /// When [nativeErrorCode] is given (the native categorizer classifies
+  /// sing-box output and reports its category code), the error is mapped by
+  /// code alone. Otherwise the message is categorized based
+  /// on common error patterns and keywords.
   static SingboxError mapNativeError({
     required String nativeErrorMessage,
     String? nativeErrorCode,
@@ -8,6 +8,7 @@ import '../interfaces/vpn_control_interface.dart';
 import '../models/vpn_configuration.dart';
 import '../models/vpn_status.dart';
 import '../models/network_stats.dart';
+import '../platform/tunnelmax_core_ffi.dart';
 import 'singbox_configuration_converter.dart';
 
 /// Unified SingBox manager that implements VPN control interface
@@ -185,6 +186,15 @@ class UnifiedSingboxManager implements VpnControlInterface {
         return null;
       }
       
+      // Read the shared stats region in place where the native core is loadable
+      final core = TunnelmaxCore.open();
+      if (core != null && core.isRunning) {
+        final stats = core.readStats();
+        if (stats != null) {
+          return stats;
+        }
+      }
+      
       final statsMap = await _channel.invokeMethod<Map<dynamic, dynamic>>('getNetworkStats');
       
       if (statsMap != null) {
@@ -208,6 +218,55 @@ class UnifiedSingboxManager implements VpnControlInterface {
     }
   }
 
+  /// Query native logs with a filter expression such as
+  /// `level>=warn module:dns since:15m timeout`; filtering and pagination
+  /// happen natively so only the requested page crosses the channel
+  Future<Map<String, dynamic>?> queryNativeLogs(
+    String query, {
+    int offset = 0,
+    int limit = 100,
+  }) async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('queryLogs', {
+        'query': query,
+        'offset': offset,
+        'limit': limit,
+      });
+      return result != null ? Map<String, dynamic>.from(result) : null;
+    } catch (e) {
+      _logger.w('Error querying native logs: $e');
+      return null;
+    }
+  }
+
+  /// Fetch only the native log records added since the previous call
+  /// (`entries` plus a `lost` count of records overwritten in between);
+  /// the first call returns everything the native tail ring holds
+  Future<Map<String, dynamic>?> tailNativeLogs({int maxRecords = 500}) async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('tailLogs', {
+        'maxRecords': maxRecords,
+      });
+      return result != null ? Map<String, dynamic>.from(result) : null;
+    } catch (e) {
+      _logger.w('Error tailing native logs: $e');
+      return null;
+    }
+  }
+
+  /// Tunnel traffic per application (`apps`, busiest first, each with
+  /// `uid`, `packageName`, byte and flow counts); `available` is false when
+  /// the device does not let the app read socket owners
+  Future<Map<String, dynamic>?> getAppUsage() async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getAppUsage');
+      return result != null ? Map<String, dynamic>.from(result) : null;
+    } catch (e) {
+      _logger.w('Error getting app usage: $e');
+      return null;
+    }
+  }
+
   @override
   Stream<VpnStatus> statusStream() {
     return _statusController.stream;
@@ -1,8 +1,13 @@
+import 'dart:async';
+import 'dart:io';
+
 import 'package:flutter/material.dart';
 import 'package:flutter/services.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:share_plus/share_plus.dart';
+import '../../providers/vpn_service_provider.dart';
 import '../../services/logs_service.dart';
+import '../../services/unified_singbox_manager.dart';
 
 /// Provider for logs service
 final logsServiceProvider = Provider<LogsService>((ref) {
@@ -15,6 +20,13 @@ final logEntriesProvider = FutureProvider<List<String>>((ref) async {
   return await logsService.getRecentLogs(count: 500);
 });
 
+/// Provider for the manager that reads sing-box's native log; null when the
+/// VPN control interface is not the unified manager
+final nativeLogsManagerProvider = Provider<UnifiedSingboxManager?>((ref) {
+  final vpnControl = ref.watch(vpnControlInterfaceProvider);
+  return vpnControl is UnifiedSingboxManager ? vpnControl : null;
+});
+
 /// Screen for viewing application logs
 class LogsScreen extends ConsumerStatefulWidget {
   const LogsScreen({super.key});
@@ -35,11 +47,30 @@ class _LogsScreenState extends ConsumerState<LogsScreen> {
 
   @override
   Widget build(BuildContext context) {
-    final logEntriesAsync = ref.watch(logEntriesProvider);
+    // The native log engine is reached through the Android plugin only
+    if (!Platform.isAndroid) {
+      return _buildAppLogsScaffold(context);
+    }
+    return DefaultTabController(
+      length: 2,
+      child: _buildAppLogsScaffold(
+        context,
+        tabs: const TabBar(
+          tabs: [
+            Tab(text: 'App'),
+            Tab(text: 'Core'),
+          ],
+        ),
+      ),
+    );
+  }
 
+  Widget _buildAppLogsScaffold(BuildContext context, {TabBar? tabs}) {
+    final appLogs = _buildAppLogs(context);
     return Scaffold(
       appBar: AppBar(
         title: const Text('Application Logs'),
+        bottom: tabs,
         actions: [
           IconButton(
             icon: const Icon(Icons.refresh),
@@ -91,133 +122,146 @@ class _LogsScreenState extends ConsumerState<LogsScreen> {
           ),
         ],
       ),
-      body: Column(
-        children: [
-          // Controls
-          Container(
-            padding: const EdgeInsets.all(8.0),
-            child: Row(
+      body: tabs == null
+          ? appLogs
+          : TabBarView(
               children: [
-                Expanded(
-                  child: Text(
-                    'Showing recent log entries',
-                    style: Theme.of(context).textTheme.bodySmall,
-                  ),
-                ),
-                Row(
-                  children: [
-                    Text(
-                      'Auto-scroll',
-                      style: Theme.of(context).textTheme.bodySmall,
-                    ),
-                    const SizedBox(width: 8),
-                    Switch(
-                      value: _autoScroll,
-                      onChanged: (value) {
-                        setState(() {
-                          _autoScroll = value;
-                        });
-                      },
-                    ),
-                  ],
-                ),
+                appLogs,
+                const _CoreLogsView(),
               ],
             ),
+    );
+  }
+
+  Widget _buildAppLogs(BuildContext context) {
+    final logEntriesAsync = ref.watch(logEntriesProvider);
+
+    return Column(
+      children: [
+        // Controls
+        Container(
+          padding: const EdgeInsets.all(8.0),
+          child: Row(
+            children: [
+              Expanded(
+                child: Text(
+                  'Showing recent log entries',
+                  style: Theme.of(context).textTheme.bodySmall,
+                ),
+              ),
+              Row(
+                children: [
+                  Text(
+                    'Auto-scroll',
+                    style: Theme.of(context).textTheme.bodySmall,
+                  ),
+                  const SizedBox(width: 8),
+                  Switch(
+                    value: _autoScroll,
+                    onChanged: (value) {
+                      setState(() {
+                        _autoScroll = value;
+                      });
+                    },
+                  ),
+                ],
+              ),
+            ],
           ),
-          const Divider(height: 1),
-          
-          // Log entries
-          Expanded(
-            child: logEntriesAsync.when(
-              data: (logEntries) {
-                if (logEntries.isEmpty) {
-                  return const Center(
-                    child: Column(
-                      mainAxisAlignment: MainAxisAlignment.center,
-                      children: [
-                        Icon(
-                          Icons.description_outlined,
-                          size: 64,
+        ),
+        const Divider(height: 1),
+        
+        // Log entries
+        Expanded(
+          child: logEntriesAsync.when(
+            data: (logEntries) {
+              if (logEntries.isEmpty) {
+                return const Center(
+                  child: Column(
+                    mainAxisAlignment: MainAxisAlignment.center,
+                    children: [
+                      Icon(
+                        Icons.description_outlined,
+                        size: 64,
+                        color: Colors.grey,
+                      ),
+                      SizedBox(height: 16),
+                      Text(
+                        'No logs available',
+                        style: TextStyle(
+                          fontSize: 18,
                           color: Colors.grey,
                         ),
-                        SizedBox(height: 16),
-                        Text(
-                          'No logs available',
-                          style: TextStyle(
-                            fontSize: 18,
-                            color: Colors.grey,
-                          ),
-                        ),
-                        SizedBox(height: 8),
-                        Text(
-                          'Application logs will appear here',
-                          style: TextStyle(
-                            color: Colors.grey,
-                          ),
+                      ),
+                      SizedBox(height: 8),
+                      Text(
+                        'Application logs will appear here',
+                        style: TextStyle(
+                          color: Colors.grey,
                         ),
-                      ],
-                    ),
+                      ),
+                    ],
+                  ),
+                );
+              }
+
+              // Auto-scroll to bottom when new logs are added
+              WidgetsBinding.instance.addPostFrameCallback((_) {
+                if (_autoScroll && _scrollController.hasClients) {
+                  _scrollController.animateTo(
+                    _scrollController.position.maxScrollExtent,
+                    duration: const Duration(milliseconds: 300),
+                    curve: Curves.easeOut,
                   );
                 }
+              });
 
-                // Auto-scroll to bottom when new logs are added
-                WidgetsBinding.instance.addPostFrameCallback((_) {
-                  if (_autoScroll && _scrollController.hasClients) {
-                    _scrollController.animateTo(
-                      _scrollController.position.maxScrollExtent,
-                      duration: const Duration(milliseconds: 300),
-                      curve: Curves.easeOut,
-                    );
-                  }
-                });
-
-                return ListView.builder(
-                  controller: _scrollController,
-                  padding: const EdgeInsets.all(8.0),
-                  itemCount: logEntries.length,
-                  itemBuilder: (context, index) {
-                    final logEntry = logEntries[index];
-                    return _buildLogEntry(logEntry, index);
-                  },
-                );
-              },
-              loading: () => const Center(
-                child: CircularProgressIndicator(),
-              ),
-              error: (error, stackTrace) => Center(
-                child: Column(
-                  mainAxisAlignment: MainAxisAlignment.center,
-                  children: [
-                    const Icon(
-                      Icons.error_outline,
-                      size: 64,
-                      color: Colors.red,
-                    ),
-                    const SizedBox(height: 16),
-                    Text(
-                      'Failed to load logs',
-                      style: Theme.of(context).textTheme.headlineSmall,
-                    ),
-                    const SizedBox(height: 8),
-                    Text(
-                      error.toString(),
-                      textAlign: TextAlign.center,
-                      style: const TextStyle(color: Colors.grey),
-                    ),
-                    const SizedBox(height: 16),
-                    ElevatedButton(
-                      onPressed: () {
-                        ref.invalidate(logEntriesProvider);
-                      },
-                      child: const Text('Retry'),
-                    ),
-                  ],
-                ),
+              return ListView.builder(
+                controller: _scrollController,
+                padding: const EdgeInsets.all(8.0),
+                itemCount: logEntries.length,
+                itemBuilder: (context, index) {
+                  final logEntry = logEntries[index];
+                  return _buildLogEntry(logEntry, index);
+                },
+              );
+            },
+            loading: () => const Center(
+              child: CircularProgressIndicator(),
+            ),
+            error: (error, stackTrace) => Center(
+              child: Column(
+                mainAxisAlignment: MainAxisAlignment.center,
+                children: [
+                  const Icon(
+                    Icons.error_outline,
+                    size: 64,
+                    color: Colors.red,
+                  ),
+                  const SizedBox(height: 16),
+                  Text(
+                    'Failed to load logs',
+                    style: Theme.of(context).textTheme.headlineSmall,
+                  ),
+                  const SizedBox(height: 8),
+                  Text(
+                    error.toString(),
+                    textAlign: TextAlign.center,
+                    style: const TextStyle(color: Colors.grey),
+                  ),
+                  const SizedBox(height: 16),
+                  ElevatedButton(
+                    onPressed: () {
+                      ref.invalidate(logEntriesProvider);
+                    },
+                    child: const Text('Retry'),
+                  ),
+                ],
               ),
             ),
           ),
-        ],
-      ),
+        ),
+      ],
     );
   }
 
@@ -477,4 +521,277 @@ class _LogsScreenState extends ConsumerState<LogsScreen> {
       }
     }
   }
-}
\ No newline at end of file
+}
+/// sing-box's own log, filtered and paged by the native query engine so only
+/// the page on screen crosses the platform channel. Unfiltered, it can follow
+/// the log live through the native tail ring, which hands over only the
+/// records added since the previous poll.
+class _CoreLogsView extends ConsumerStatefulWidget {
+  const _CoreLogsView();
+
+  @override
+  ConsumerState<_CoreLogsView> createState() => _CoreLogsViewState();
+}
+
+class _CoreLogsViewState extends ConsumerState<_CoreLogsView> {
+  static const int _pageSize = 100;
+  static const int _maxLiveEntries = 1000;
+  static const Duration _tailInterval = Duration(seconds: 1);
+  static const List<String> _levelNames = ['TRACE', 'DEBUG', 'INFO', 'WARN', 'ERROR', 'FATAL'];
+
+  final TextEditingController _queryController = TextEditingController();
+  final List<Map<String, dynamic>> _entries = [];
+  String _query = '';
+  int _total = 0;
+  bool _loading = false;
+  String? _error;
+  bool _live = false;
+  Timer? _tailTimer;
+  bool _tailing = false;
+  int _newestSeq = 0;
+  int _lost = 0;
+
+  @override
+  void initState() {
+    super.initState();
+    WidgetsBinding.instance.addPostFrameCallback((_) => _runQuery(''));
+  }
+
+  @override
+  void dispose() {
+    _tailTimer?.cancel();
+    _queryController.dispose();
+    super.dispose();
+  }
+
+  Future<void> _runQuery(String query) async {
+    _query = query.trim();
+    _entries.clear();
+    _total = 0;
+    _newestSeq = 0;
+    // The tail does not filter, so it only follows the unfiltered log
+    if (_query.isNotEmpty) {
+      _setLive(false);
+    }
+    await _loadPage();
+  }
+
+  void _setLive(bool live) {
+    _tailTimer?.cancel();
+    _tailTimer = live ? Timer.periodic(_tailInterval, (_) => _tail()) : null;
+    if (mounted) {
+      setState(() {
+        _live = live;
+        _lost = 0;
+      });
+    }
+  }
+
+  /// Put the records logged since the last poll on top
+  Future<void> _tail() async {
+    final manager = ref.read(nativeLogsManagerProvider);
+    if (manager == null || _tailing || _loading) {
+      return;
+    }
+    _tailing = true;
+    final batch = await manager.tailNativeLogs();
+    _tailing = false;
+    if (!mounted || batch == null || !_live) {
+      return;
+    }
+    final fresh = (batch['entries'] as List<dynamic>? ?? const [])
+        .map((entry) => Map<String, dynamic>.from(entry as Map))
+        .where((entry) => (entry['seq'] as int? ?? 0) > _newestSeq)
+        .toList();
+    final lost = batch['lost'] as int? ?? 0;
+    if (fresh.isEmpty && lost == 0) {
+      return;
+    }
+    setState(() {
+      // The first poll returns what the ring holds, the page may have it
+      if (_newestSeq > 0) {
+        _lost += lost;
+      }
+      for (final entry in fresh) {
+        _entries.insert(0, entry);
+        _newestSeq = entry['seq'] as int? ?? _newestSeq;
+      }
+      _total += fresh.length;
+      if (_entries.length > _maxLiveEntries) {
+        _total -= _entries.length - _maxLiveEntries;
+        _entries.removeRange(_maxLiveEntries, _entries.length);
+      }
+    });
+  }
+
+  /// Fetch the next page of matches, newest first
+  Future<void> _loadPage() async {
+    final manager = ref.read(nativeLogsManagerProvider);
+    if (manager == null || _loading) {
+      return;
+    }
+    setState(() {
+      _loading = true;
+      _error = null;
+    });
+    final page = await manager.queryNativeLogs(_query, offset: _entries.length, limit: _pageSize);
+    if (!mounted) {
+      return;
+    }
+    setState(() {
+      _loading = false;
+      if (page == null) {
+        _error = 'Could not query the core log; check the filter';
+        return;
+      }
+      final entries = page['entries'] as List<dynamic>? ?? const [];
+      _entries.addAll(entries.map((entry) => Map<String, dynamic>.from(entry as Map)));
+      _total = page['total'] as int? ?? _entries.length;
+      if (_entries.isNotEmpty) {
+        final newest = _entries.first['seq'] as int? ?? 0;
+        _newestSeq = newest > _newestSeq ? newest : _newestSeq;
+      }
+    });
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return Column(
+      children: [
+        Padding(
+          padding: const EdgeInsets.all(8.0),
+          child: TextField(
+            controller: _queryController,
+            textInputAction: TextInputAction.search,
+            decoration: InputDecoration(
+              hintText: 'level>=warn module:dns since:15m timeout',
+              prefixIcon: const Icon(Icons.search),
+              isDense: true,
+              border: const OutlineInputBorder(),
+              suffixIcon: IconButton(
+                icon: const Icon(Icons.clear),
+                tooltip: 'Clear filter',
+                onPressed: () {
+                  _queryController.clear();
+                  _runQuery('');
+                },
+              ),
+            ),
+            onSubmitted: _runQuery,
+          ),
+        ),
+        Padding(
+          padding: const EdgeInsets.symmetric(horizontal: 8.0),
+          child: Row(
+            children: [
+              Expanded(
+                child: Text(
+                  _error ??
+                      '${_entries.length} of $_total matching entries'
+                          '${_lost > 0 ? ', $_lost missed while following' : ''}',
+                  style: Theme.of(context).textTheme.bodySmall?.copyWith(
+                    color: _error != null ? Colors.red : null,
+                  ),
+                ),
+              ),
+              Text(
+                'Live',
+                style: Theme.of(context).textTheme.bodySmall,
+              ),
+              const SizedBox(width: 8),
+              Switch(
+                value: _live,
+                onChanged: _query.isEmpty ? _setLive : null,
+              ),
+            ],
+          ),
+        ),
+        const Divider(height: 1),
+        Expanded(
+          child: RefreshIndicator(
+            onRefresh: () => _runQuery(_query),
+            child: ListView.builder(
+              padding: const EdgeInsets.all(8.0),
+              itemCount: _entries.length + 1,
+              itemBuilder: (context, index) {
+                if (index < _entries.length) {
+                  return _buildEntry(_entries[index]);
+                }
+                if (_loading) {
+                  return const Padding(
+                    padding: EdgeInsets.all(16.0),
+                    child: Center(child: CircularProgressIndicator()),
+                  );
+                }
+                if (_entries.length < _total) {
+                  return TextButton(
+                    onPressed: _loadPage,
+                    child: const Text('Load older entries'),
+                  );
+                }
+                return const SizedBox.shrink();
+              },
+            ),
+          ),
+        ),
+      ],
+    );
+  }
+
+  Widget _buildEntry(Map<String, dynamic> entry) {
+    final level = entry['level'] as int? ?? 2;
+    final module = entry['module'] as String? ?? '';
+    final message = entry['message'] as String? ?? '';
+    final timestamp = DateTime.fromMillisecondsSinceEpoch(entry['timestamp'] as int? ?? 0);
+    final levelName = level >= 0 && level < _levelNames.length ? _levelNames[level] : '$level';
+    final levelColor = level >= 4
+        ? Colors.red
+        : level == 3
+            ? Colors.orange
+            : level == 2
+                ? Colors.blue
+                : Colors.green;
+
+    return Card(
+      margin: const EdgeInsets.symmetric(vertical: 2.0),
+      child: Padding(
+        padding: const EdgeInsets.all(12.0),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            Row(
+              children: [
+                Text(
+                  levelName,
+                  style: TextStyle(
+                    fontSize: 10,
+                    fontWeight: FontWeight.bold,
+                    color: levelColor,
+                  ),
+                ),
+                const SizedBox(width: 8),
+                Expanded(
+                  child: Text(
+                    '${timestamp.hour.toString().padLeft(2, '0')}:'
+                    '${timestamp.minute.toString().padLeft(2, '0')}:'
+                    '${timestamp.second.toString().padLeft(2, '0')}'
+                    '${module.isNotEmpty ? '  $module' : ''}',
+                    style: Theme.of(context).textTheme.bodySmall?.copyWith(
+                      color: Colors.grey,
+                    ),
+                  ),
+                ),
+              ],
+            ),
+            const SizedBox(height: 4),
+            SelectableText(
+              message,
+              style: const TextStyle(fontFamily: 'monospace'),
+              maxLines: 3,
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+}
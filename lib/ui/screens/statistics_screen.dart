@@ -148,10 +148,12 @@ class _StatisticsScreenState extends ConsumerState<StatisticsScreen>
 
   Widget _buildUsageTab() {
     final dailyUsageAsync = ref.watch(dailyUsageProvider);
+    final appUsageAsync = ref.watch(appUsageProvider);
 
     return RefreshIndicator(
       onRefresh: () async {
         ref.refresh(dailyUsageProvider);
+        ref.refresh(appUsageProvider);
       },
       child: SingleChildScrollView(
         physics: const AlwaysScrollableScrollPhysics(),
@@ -182,12 +184,69 @@ class _StatisticsScreenState extends ConsumerState<StatisticsScreen>
                 onRetry: () => ref.refresh(dailyUsageProvider),
               ),
             ),
+            
+            // Only the Android plugin attributes tunnel traffic to apps
+            if (!appUsageAsync.hasValue || appUsageAsync.value != null) ...[
+              const SizedBox(height: 24),
+              _buildSectionHeader('Apps - Current Session'),
+              const SizedBox(height: 12),
+              appUsageAsync.when(
+                data: (usage) => _buildAppUsageCard(usage!),
+                loading: () => const LoadingWidget(),
+                error: (error, stack) => ErrorDisplayWidget(
+                  error: error.toString(),
+                  onRetry: () => ref.refresh(appUsageProvider),
+                ),
+              ),
+            ],
           ],
         ),
       ),
     );
   }
 
+  Widget _buildAppUsageCard(Map<String, dynamic> usage) {
+    final apps = (usage['apps'] as List<dynamic>? ?? const [])
+        .map((app) => Map<String, dynamic>.from(app as Map))
+        .take(10)
+        .toList();
+    if (usage['available'] != true || apps.isEmpty) {
+      return Card(
+        child: Padding(
+          padding: const EdgeInsets.all(16),
+          child: Text(
+            usage['available'] == true
+                ? 'No app traffic through the tunnel yet'
+                : 'This device does not report which app owns a connection',
+            style: Theme.of(context).textTheme.bodyMedium?.copyWith(
+              color: Colors.grey[600],
+            ),
+          ),
+        ),
+      );
+    }
+
+    return Card(
+      child: Column(
+        children: apps.map((app) {
+          final upload = app['uploadBytes'] as int? ?? 0;
+          final download = app['downloadBytes'] as int? ?? 0;
+          final name = app['packageName'] as String? ?? 'UID ${app['uid']}';
+          return ListTile(
+            dense: true,
+            leading: const Icon(Icons.apps),
+            title: Text(name, overflow: TextOverflow.ellipsis),
+            subtitle: Text('${app['flows'] ?? 0} flows'),
+            trailing: Text(
+              '↓ ${NetworkStats.formatBytes(download)}  ↑ ${NetworkStats.formatBytes(upload)}',
+              style: Theme.of(context).textTheme.bodySmall,
+            ),
+          );
+        }).toList(),
+      ),
+    );
+  }
+
   Widget _buildHistoryTab() {
     final historyAsync = ref.watch(connectionHistoryProvider);
 
@@ -6,6 +6,7 @@
 #endif
 
 #include "flutter/generated_plugin_registrant.h"
+#include "vpn_plugin.h"
 
 struct _MyApplication {
   GtkApplication parent_instance;
@@ -58,6 +59,9 @@ static void my_application_activate(GApplication* application) {
   gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(view));
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
+  g_autoptr(FlPluginRegistrar) vpn_registrar =
+      fl_plugin_registry_get_registrar_for_plugin(FL_PLUGIN_REGISTRY(view), "VpnPlugin");
+  vpn_plugin_register_with_registrar(vpn_registrar);
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
@@ -0,0 +1,330 @@
+#include "network_change_detector.h"
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kReceiveBufferSize = 32768;
+constexpr int kDumpTimeoutMs = 1000;
+
+std::string AttributeString(const rtattr* attribute) {
+  const char* data = static_cast<const char*>(RTA_DATA(attribute));
+  size_t length = RTA_PAYLOAD(attribute);
+  return std::string(data, strnlen(data, length));
+}
+
+}  // namespace
+
+NetworkChangeDetector::NetworkChangeDetector(std::string tunnel_interface, Reactor& reactor)
+    : tunnel_interface_(std::move(tunnel_interface)), reactor_(reactor) {}
+
+NetworkChangeDetector::~NetworkChangeDetector() {
+  StopMonitoring();
+}
+
+const char* NetworkChangeDetector::StateName(NetworkState state) {
+  switch (state) {
+    case NetworkState::Unknown: return "unknown";
+    case NetworkState::Disconnected: return "disconnected";
+    case NetworkState::Connected: return "connected";
+  }
+  return "unknown";
+}
+
+bool NetworkChangeDetector::StartMonitoring() {
+  if (monitoring_) {
+    return true;
+  }
+  socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+  if (socket_ < 0) {
+    std::cerr << "NetworkChangeDetector: netlink socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+  sockaddr_nl address = {};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR |
+                      RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || !RequestLinkDump()) {
+    std::cerr << "NetworkChangeDetector: cannot subscribe: " << strerror(errno) << std::endl;
+    StopMonitoring();
+    return false;
+  }
+
+  // The initial dump describes the network as it is, not a change
+  std::vector<char> buffer(kReceiveBufferSize);
+  bool done = false;
+  while (!done) {
+    pollfd fd = {socket_, POLLIN, 0};
+    if (poll(&fd, 1, kDumpTimeoutMs) <= 0) {
+      break;
+    }
+    ssize_t length = recv(socket_, buffer.data(), buffer.size(), 0);
+    if (length <= 0) {
+      break;
+    }
+    ProcessMessages(buffer.data(), static_cast<size_t>(length));
+    int remaining = static_cast<int>(length);
+    for (const nlmsghdr* message = reinterpret_cast<const nlmsghdr*>(buffer.data());
+         NLMSG_OK(message, remaining); message = NLMSG_NEXT(message, remaining)) {
+      done |= message->nlmsg_type == NLMSG_DONE || message->nlmsg_type == NLMSG_ERROR;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = ComputeStateLocked();
+    pending_ = false;
+    pending_reason_.clear();
+  }
+
+  if (!reactor_.AddFd(socket_, EPOLLIN, [this](uint32_t) { OnReadable(); })) {
+    StopMonitoring();
+    return false;
+  }
+  monitoring_ = true;
+  return true;
+}
+
+void NetworkChangeDetector::StopMonitoring() {
+  // On the reactor thread, so no handler is left running on the socket
+  reactor_.Call([this]() {
+    if (socket_ >= 0) {
+      reactor_.RemoveFd(socket_);
+    }
+    reactor_.CancelTimer(debounce_timer_);
+    debounce_timer_ = 0;
+  });
+  monitoring_ = false;
+  if (socket_ >= 0) {
+    close(socket_);
+    socket_ = -1;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  links_.clear();
+  state_ = NetworkState::Unknown;
+  pending_ = false;
+}
+
+bool NetworkChangeDetector::IsMonitoring() const {
+  return monitoring_;
+}
+
+NetworkState NetworkChangeDetector::GetNetworkState() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return state_;
+}
+
+std::string NetworkChangeDetector::GetActiveInterfaces() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string names;
+  for (const auto& entry : links_) {
+    if (entry.second.usable) {
+      names += (names.empty() ? "" : ",") + entry.second.name;
+    }
+  }
+  return names;
+}
+
+NetworkChangeDetector::Stats NetworkChangeDetector::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void NetworkChangeDetector::SetChangeCallback(ChangeCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = std::move(callback);
+}
+
+void NetworkChangeDetector::SetDebounce(std::chrono::milliseconds debounce) {
+  debounce_ms_ = static_cast<int>(debounce.count());
+}
+
+bool NetworkChangeDetector::RequestLinkDump() {
+  struct {
+    nlmsghdr header;
+    ifinfomsg info;
+  } request = {};
+  request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+  request.header.nlmsg_type = RTM_GETLINK;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.info.ifi_family = AF_UNSPEC;
+  return send(socket_, &request, request.header.nlmsg_len, 0) >= 0;
+}
+
+void NetworkChangeDetector::OnReadable() {
+  std::vector<char> buffer(kReceiveBufferSize);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.wakeups++;
+  }
+  for (;;) {
+    ssize_t length = recv(socket_, buffer.data(), buffer.size(), 0);
+    if (length > 0) {
+      ProcessMessages(buffer.data(), static_cast<size_t>(length));
+      continue;
+    }
+    if (length < 0 && errno == ENOBUFS) {
+      // The kernel dropped messages: start over from a full dump
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = true;
+      pending_reason_ = "netlink overrun";
+      RequestLinkDump();
+      continue;
+    }
+    break;
+  }
+  bool pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending = pending_;
+  }
+  if (!pending) {
+    return;
+  }
+  // Each message restarts the quiet period
+  reactor_.CancelTimer(debounce_timer_);
+  debounce_timer_ = reactor_.AddTimer(std::chrono::milliseconds(debounce_ms_.load()), [this]() {
+    debounce_timer_ = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.wakeups++;
+    }
+    DeliverPending();
+  });
+}
+
+bool NetworkChangeDetector::ProcessMessages(const void* data, size_t length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool relevant = false;
+  int remaining = static_cast<int>(length);
+  for (const nlmsghdr* message = static_cast<const nlmsghdr*>(data); NLMSG_OK(message, remaining);
+       message = NLMSG_NEXT(message, remaining)) {
+    stats_.messages++;
+    if (ProcessMessageLocked(message)) {
+      stats_.relevant++;
+      relevant = true;
+    }
+  }
+  if (relevant) {
+    pending_ = true;
+    state_ = ComputeStateLocked();
+  }
+  return relevant;
+}
+
+bool NetworkChangeDetector::ProcessMessageLocked(const void* data) {
+  const nlmsghdr* message = static_cast<const nlmsghdr*>(data);
+  switch (message->nlmsg_type) {
+    case RTM_NEWLINK:
+    case RTM_DELLINK: {
+      const ifinfomsg* info = static_cast<const ifinfomsg*>(NLMSG_DATA(message));
+      Link link;
+      int remaining = static_cast<int>(IFLA_PAYLOAD(message));
+      for (const rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, remaining);
+           attribute = RTA_NEXT(attribute, remaining)) {
+        if (attribute->rta_type == IFLA_IFNAME) {
+          link.name = AttributeString(attribute);
+        }
+      }
+      auto known = links_.find(info->ifi_index);
+      if (link.name.empty() && known != links_.end()) {
+        link.name = known->second.name;
+      }
+      bool tunnel = link.name == tunnel_interface_;
+      link.usable = message->nlmsg_type == RTM_NEWLINK && !tunnel &&
+                    (info->ifi_flags & IFF_UP) && (info->ifi_flags & IFF_RUNNING) &&
+                    !(info->ifi_flags & IFF_LOOPBACK);
+      bool was_usable = known != links_.end() && known->second.usable;
+      if (message->nlmsg_type == RTM_DELLINK) {
+        links_.erase(info->ifi_index);
+      } else {
+        links_[info->ifi_index] = link;
+      }
+      // Counter and attribute updates repeat RTM_NEWLINK without news
+      if (link.usable == was_usable) {
+        return false;
+      }
+      pending_reason_ = "link " + link.name + (link.usable ? " up" : " down");
+      return true;
+    }
+    case RTM_NEWADDR:
+    case RTM_DELADDR: {
+      const ifaddrmsg* info = static_cast<const ifaddrmsg*>(NLMSG_DATA(message));
+      auto link = links_.find(static_cast<int>(info->ifa_index));
+      if (link == links_.end() || !link->second.usable) {
+        return false;  // Loopback, the tunnel, or a link that is down anyway
+      }
+      pending_reason_ = "address " + std::string(message->nlmsg_type == RTM_NEWADDR ? "added to " : "removed from ") +
+                        link->second.name;
+      return true;
+    }
+    case RTM_NEWROUTE:
+    case RTM_DELROUTE: {
+      const rtmsg* route = static_cast<const rtmsg*>(NLMSG_DATA(message));
+      if (route->rtm_dst_len != 0 || route->rtm_type != RTN_UNICAST) {
+        return false;
+      }
+      uint32_t table = route->rtm_table;
+      int output = 0;
+      int remaining = static_cast<int>(RTM_PAYLOAD(message));
+      for (const rtattr* attribute = RTM_RTA(route); RTA_OK(attribute, remaining);
+           attribute = RTA_NEXT(attribute, remaining)) {
+        if (attribute->rta_type == RTA_TABLE) {
+          table = *static_cast<const uint32_t*>(RTA_DATA(attribute));
+        } else if (attribute->rta_type == RTA_OIF) {
+          output = *static_cast<const int*>(RTA_DATA(attribute));
+        }
+      }
+      // sing-box's auto_route installs its defaults in a table of its own
+      auto link = links_.find(output);
+      if (table != RT_TABLE_MAIN || (link != links_.end() && link->second.name == tunnel_interface_)) {
+        return false;
+      }
+      pending_reason_ = message->nlmsg_type == RTM_NEWROUTE ? "default route added" : "default route removed";
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+NetworkState NetworkChangeDetector::ComputeStateLocked() const {
+  for (const auto& entry : links_) {
+    if (entry.second.usable) {
+      return NetworkState::Connected;
+    }
+  }
+  return NetworkState::Disconnected;
+}
+
+void NetworkChangeDetector::DeliverPending() {
+  ChangeCallback callback;
+  NetworkState state;
+  std::string reason;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_) {
+      return;
+    }
+    pending_ = false;
+    stats_.notifications++;
+    state = state_;
+    reason = std::move(pending_reason_);
+    pending_reason_.clear();
+    callback = callback_;
+  }
+  if (callback) {
+    callback(state, reason);
+  }
+}
@@ -0,0 +1,100 @@
+#ifndef RUNNER_NETWORK_CHANGE_DETECTOR_H_
+#define RUNNER_NETWORK_CHANGE_DETECTOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "reactor.h"
+
+enum class NetworkState {
+  Unknown,
+  Disconnected,  // No usable interface besides loopback and the tunnel
+  Connected
+};
+
+// Network changes on Linux from rtnetlink: links, addresses and default
+// routes, pushed by the kernel on a NETLINK_ROUTE socket.
+//
+// The socket is a source on the runner's Reactor, so nothing runs while
+// nothing changes and the detector needs no thread of its own. A burst of
+// messages (a Wi-Fi roam brings links, addresses and routes within
+// milliseconds) is folded into one notification by a reactor timer that
+// each message pushes back until `debounce` passes quietly.
+//
+// The tunnel's own interface is ignored: sing-box creating and removing it
+// must not read as a change of the underlying network.
+class NetworkChangeDetector {
+ public:
+  using ChangeCallback = std::function<void(NetworkState state, const std::string& reason)>;
+
+  struct Stats {
+    uint64_t messages = 0;       // Netlink messages read
+    uint64_t relevant = 0;       // Of those, about something other than the tunnel
+    uint64_t notifications = 0;  // Callbacks after debouncing
+    uint64_t wakeups = 0;        // Handler runs on the reactor
+  };
+
+  NetworkChangeDetector(std::string tunnel_interface, Reactor& reactor);
+  ~NetworkChangeDetector();
+
+  NetworkChangeDetector(const NetworkChangeDetector&) = delete;
+  NetworkChangeDetector& operator=(const NetworkChangeDetector&) = delete;
+
+  // Subscribe, read the current links and watch the socket on the reactor
+  bool StartMonitoring();
+  void StopMonitoring();
+  bool IsMonitoring() const;
+
+  NetworkState GetNetworkState() const;
+  // Names of the usable interfaces, comma separated
+  std::string GetActiveInterfaces() const;
+  Stats GetStats() const;
+
+  // Called on the reactor thread
+  void SetChangeCallback(ChangeCallback callback);
+  void SetDebounce(std::chrono::milliseconds debounce);
+
+  // Apply a buffer of netlink messages as the reactor handler does
+  // @return Whether any of them is relevant (exposed for tests)
+  bool ProcessMessages(const void* data, size_t length);
+  // Deliver what ProcessMessages collected, as the debounce timer does once
+  // the interval passed without messages
+  void DeliverPending();
+
+  static const char* StateName(NetworkState state);
+
+ private:
+  struct Link {
+    std::string name;
+    bool usable = false;  // Up, running and not loopback
+  };
+
+  bool RequestLinkDump();
+  // Reactor thread: drain the socket and push the debounce timer back
+  void OnReadable();
+  bool ProcessMessageLocked(const void* message);
+  NetworkState ComputeStateLocked() const;
+
+  const std::string tunnel_interface_;
+  Reactor& reactor_;
+  int socket_ = -1;
+  Reactor::TimerId debounce_timer_ = 0;  // Reactor thread only
+  std::atomic<bool> monitoring_{false};
+  std::atomic<int> debounce_ms_{500};
+
+  mutable std::mutex mutex_;
+  std::map<int, Link> links_;
+  NetworkState state_ = NetworkState::Unknown;
+  std::string pending_reason_;
+  bool pending_ = false;
+  Stats stats_;
+  ChangeCallback callback_;
+};
+
+#endif  // RUNNER_NETWORK_CHANGE_DETECTOR_H_
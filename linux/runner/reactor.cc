@@ -0,0 +1,308 @@
+#include "reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <utility>
+
+// Linux 5.3; the number is the same on every architecture
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+namespace {
+
+constexpr uint64_t kWakeKey = UINT64_MAX;
+constexpr int kMaxEvents = 16;
+
+uint64_t MonotonicMs() {
+  timespec now = {};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+
+}  // namespace
+
+Reactor::Reactor(Clock clock)
+    : clock_(clock ? std::move(clock) : Clock(MonotonicMs)), wheel_(clock_()) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = kWakeKey;
+  if (epoll_fd_ < 0 || wake_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+    std::cerr << "Reactor: cannot set up epoll: " << strerror(errno) << std::endl;
+  }
+}
+
+Reactor::~Reactor() {
+  Stop();
+  for (const auto& entry : fds_) {
+    if (entry.second.owned) {
+      close(entry.first);
+    }
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+bool Reactor::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return true;
+  }
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    return false;
+  }
+  running_ = true;
+  stopping_ = false;
+  stats_.running = true;
+  thread_ = std::thread(&Reactor::Loop, this);
+  return true;
+}
+
+void Reactor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    // From here Call() runs inline; what it posted before is drained below
+    running_ = false;
+    stopping_ = true;
+    stats_.running = false;
+  }
+  Wake();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool Reactor::IsRunning() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+bool Reactor::InReactorThread() const {
+  return dispatch_thread_.load() == std::this_thread::get_id();
+}
+
+void Reactor::Loop() {
+  dispatch_thread_ = std::this_thread::get_id();
+  for (;;) {
+    RunOnce(-1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      break;
+    }
+  }
+  // Posted before Stop(): a Call() may be waiting for it
+  std::vector<Task> posted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted.swap(posted_);
+    stats_.posted += posted.size();
+  }
+  for (Task& task : posted) {
+    task();
+  }
+  dispatch_thread_ = std::thread::id();
+}
+
+size_t Reactor::RunOnce(int max_wait_ms) {
+  std::thread::id previous = dispatch_thread_.exchange(std::this_thread::get_id());
+  int timeout = max_wait_ms;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t next = wheel_.NextDeadline();
+    if (!posted_.empty() || stopping_) {
+      timeout = 0;
+    } else if (next != TimerWheel::kNever) {
+      uint64_t now = clock_();
+      uint64_t until = next > now ? next - now : 0;
+      if (timeout < 0 || until < static_cast<uint64_t>(timeout)) {
+        timeout = static_cast<int>(std::min<uint64_t>(until, INT_MAX));
+      }
+    }
+  }
+
+  epoll_event events[kMaxEvents];
+  int ready = epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+  if (ready < 0 && errno != EINTR) {
+    std::cerr << "Reactor: epoll_wait: " << strerror(errno) << std::endl;
+  }
+
+  // Collect under the lock, run without it
+  std::vector<std::pair<std::shared_ptr<FdCallback>, uint32_t>> ready_fds;
+  std::vector<Task> due;
+  std::vector<Task> posted;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.wakeups++;
+    for (int i = 0; i < ready; i++) {
+      uint64_t key = events[i].data.u64;
+      if (key == kWakeKey) {
+        uint64_t count;
+        while (read(wake_fd_, &count, sizeof(count)) > 0) {
+        }
+        continue;
+      }
+      // Removed, or removed and the number reused, since epoll reported it
+      auto entry = fds_.find(static_cast<int>(key & 0xffffffffu));
+      if (entry != fds_.end() && entry->second.key == key) {
+        uint32_t mask = events[i].events;  // Packed on x86-64
+        ready_fds.emplace_back(entry->second.callback, mask);
+      }
+    }
+    wheel_.Advance(clock_());
+    due.swap(fired_);
+    posted.swap(posted_);
+    stats_.fd_events += ready_fds.size();
+    stats_.timers_fired += due.size();
+    stats_.posted += posted.size();
+  }
+
+  for (auto& entry : ready_fds) {
+    (*entry.first)(entry.second);
+  }
+  for (Task& task : due) {
+    task();
+  }
+  for (Task& task : posted) {
+    task();
+  }
+  dispatch_thread_ = previous;
+  return ready_fds.size() + due.size() + posted.size();
+}
+
+bool Reactor::AddFd(int fd, uint32_t events, FdCallback callback, bool owned) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd < 0 || fds_.count(fd)) {
+    return false;
+  }
+  Registration registration;
+  registration.key = (static_cast<uint64_t>(++next_key_) << 32) | static_cast<uint32_t>(fd);
+  registration.owned = owned;
+  registration.callback = std::make_shared<FdCallback>(std::move(callback));
+  epoll_event event = {};
+  event.events = events;
+  event.data.u64 = registration.key;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    std::cerr << "Reactor: cannot watch fd " << fd << ": " << strerror(errno) << std::endl;
+    return false;
+  }
+  fds_[fd] = std::move(registration);
+  return true;
+}
+
+void Reactor::RemoveFd(int fd) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = fds_.find(fd);
+  if (entry == fds_.end()) {
+    return;
+  }
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  if (entry->second.owned) {
+    close(fd);
+  }
+  fds_.erase(entry);
+}
+
+Reactor::TimerId Reactor::AddTimer(std::chrono::milliseconds delay, Task task) {
+  TimerId id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t deadline = clock_() + static_cast<uint64_t>(std::max<int64_t>(0, delay.count()));
+    // The wheel calls back under the lock; the task itself runs after
+    id = wheel_.Schedule(deadline, [this, task = std::move(task)]() mutable {
+      fired_.push_back(std::move(task));
+    });
+  }
+  // The thread may be sleeping towards a later deadline
+  Wake();
+  return id;
+}
+
+bool Reactor::CancelTimer(TimerId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return id != 0 && wheel_.Cancel(id);
+}
+
+void Reactor::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_.push_back(std::move(task));
+  }
+  Wake();
+}
+
+void Reactor::Call(Task task) {
+  std::promise<void> done;
+  std::future<void> finished = done.get_future();
+  bool posted = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ && !InReactorThread()) {
+      posted_.push_back([&task, &done]() {
+        task();
+        done.set_value();
+      });
+      posted = true;
+    }
+  }
+  if (!posted) {
+    task();
+    return;
+  }
+  Wake();
+  finished.wait();
+}
+
+int Reactor::WatchProcessExit(pid_t pid, Task on_exit) {
+  int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+  if (fd < 0) {
+    return -1;
+  }
+  // A pidfd reads ready once the process has exited
+  bool added = AddFd(fd, EPOLLIN, [this, fd, on_exit = std::move(on_exit)](uint32_t) {
+    RemoveFd(fd);
+    on_exit();
+  }, true);
+  if (!added) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+Reactor::Stats Reactor::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.fds = fds_.size();
+  stats.timers = wheel_.size();
+  stats.wheel = wheel_.GetStats();
+  return stats;
+}
+
+void Reactor::Wake() {
+  if (InReactorThread()) {
+    return;
+  }
+  uint64_t one = 1;
+  if (write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+    std::cerr << "Reactor: wake: " << strerror(errno) << std::endl;
+  }
+}
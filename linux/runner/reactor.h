@@ -0,0 +1,122 @@
+#ifndef RUNNER_REACTOR_H_
+#define RUNNER_REACTOR_H_
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "timer_wheel.h"
+
+// One thread for the runner's event sources: file descriptors (netlink and
+// other sockets, pipes, a pidfd for process exit), timers on a
+// TimerWheel ticking in milliseconds, and tasks posted from other threads.
+//
+// The thread sleeps in epoll_wait() until a descriptor is ready, the
+// earliest timer is due or a post writes the eventfd, so it costs nothing
+// while nothing happens. Handlers run on it one at a time and must not
+// block; work that does goes to the plugin's executor.
+//
+// The clock is injectable. Tests drive RunOnce() from their own thread with
+// a fake clock instead of starting the thread. Thread safe; handlers run
+// without the reactor's lock held and may add and remove sources.
+class Reactor {
+ public:
+  using Clock = std::function<uint64_t()>;  // Monotonic milliseconds
+  using Task = std::function<void()>;
+  using FdCallback = std::function<void(uint32_t events)>;
+  using TimerId = TimerWheel::TimerId;
+
+  struct Stats {
+    bool running = false;
+    uint64_t wakeups = 0;       // Returns from epoll_wait()
+    uint64_t fd_events = 0;     // Descriptor handlers run
+    uint64_t timers_fired = 0;
+    uint64_t posted = 0;        // Posted tasks run, Call() included
+    size_t fds = 0;
+    size_t timers = 0;
+    TimerWheel::Stats wheel;
+  };
+
+  // @param clock Defaults to CLOCK_MONOTONIC
+  explicit Reactor(Clock clock = nullptr);
+  // Stops the thread and closes the descriptors the reactor owns
+  ~Reactor();
+
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  bool Start();
+  // Runs what was posted before it, then joins the thread
+  void Stop();
+  bool IsRunning() const;
+  bool InReactorThread() const;
+
+  // Wait for events at most `max_wait_ms` (-1: until one comes), less when
+  // a timer is due sooner, and run the handlers of what happened. The
+  // thread loops on this; tests call it with a fake clock.
+  // @return Number of handlers run
+  size_t RunOnce(int max_wait_ms);
+
+  // Call `callback` with the epoll events whenever `fd` is ready. An owned
+  // descriptor is closed when it is removed or the reactor goes away.
+  bool AddFd(int fd, uint32_t events, FdCallback callback, bool owned = false);
+  // A handler already running for `fd` on the reactor thread may still
+  // finish; remove through Call() before closing the descriptor elsewhere
+  void RemoveFd(int fd);
+
+  // Run `task` on the reactor `delay` from now
+  // @return Never 0
+  TimerId AddTimer(std::chrono::milliseconds delay, Task task);
+  // @return Whether the timer was pending
+  bool CancelTimer(TimerId id);
+
+  void Post(Task task);
+  // Run `task` on the reactor thread and wait for it; inline when called
+  // there or when the thread is not running
+  void Call(Task task);
+
+  // Run `on_exit` once when process `pid` exits, through a pidfd
+  // @return The pidfd, for RemoveFd(); -1 when the kernel has no pidfd_open
+  int WatchProcessExit(pid_t pid, Task on_exit);
+
+  uint64_t Now() const { return clock_(); }
+  Stats GetStats() const;
+
+ private:
+  struct Registration {
+    uint64_t key = 0;  // Tells a reused descriptor number from the old one
+    bool owned = false;
+    std::shared_ptr<FdCallback> callback;
+  };
+
+  void Loop();
+  // Interrupt epoll_wait() unless called from the dispatching thread
+  void Wake();
+
+  Clock clock_;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::thread thread_;
+  std::atomic<std::thread::id> dispatch_thread_{};
+
+  mutable std::mutex mutex_;
+  bool running_ = false;
+  bool stopping_ = false;
+  std::map<int, Registration> fds_;
+  uint32_t next_key_ = 0;
+  TimerWheel wheel_;
+  std::vector<Task> fired_;  // Timers the wheel handed over, run unlocked
+  std::vector<Task> posted_;
+  Stats stats_;
+};
+
+#endif  // RUNNER_REACTOR_H_
@@ -0,0 +1,253 @@
+#include "singbox_manager.h"
+
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "sing_box_core.h"
+#include "sing_box_ffi.h"
+
+namespace {
+
+constexpr size_t kJsonBufferSize = 16384;
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+bool IsExecutable(const std::string& path) {
+  struct stat st;
+  return !path.empty() && stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+         access(path.c_str(), X_OK) == 0;
+}
+
+// mkdir -p with 0700 for what it creates; the work directory holds the
+// configuration, credentials included
+bool MakeDirectories(const std::string& path) {
+  for (size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1)) {
+    std::string prefix = path.substr(0, slash);
+    if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (slash == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+std::string FormatJson(int32_t (*format)(char*, size_t)) {
+  std::string json(kJsonBufferSize, '\0');
+  int32_t length = format(&json[0], json.size());
+  if (length < 0) {
+    return std::string();
+  }
+  json.resize(static_cast<size_t>(length));
+  return json;
+}
+
+}  // namespace
+
+SingboxManager::SingboxManager() = default;
+
+SingboxManager::~SingboxManager() {
+  Cleanup();
+}
+
+bool SingboxManager::Initialize(const std::string& work_dir, const std::string& binary,
+                                const std::string& tun_interface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (initialized_) {
+    return true;
+  }
+  if (!MakeDirectories(work_dir)) {
+    last_error_ = "Cannot create " + work_dir + ": " + strerror(errno);
+    return false;
+  }
+  if (tunnelmax_core_abi_version() != TUNNELMAX_CORE_ABI_VERSION) {
+    last_error_ = "libtunnelmax_core ABI mismatch";
+    return false;
+  }
+  initialized_ = tunnelmax_core_init_desktop(work_dir.c_str(),
+                                             binary.empty() ? nullptr : binary.c_str(),
+                                             tun_interface.c_str()) == 1;
+  if (!initialized_) {
+    last_error_ = "Failed to initialize the native core";
+  }
+  return initialized_;
+}
+
+bool SingboxManager::Start(const std::string& config_json) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_) {
+      last_error_ = "SingboxManager not initialized";
+      return false;
+    }
+  }
+  if (!ValidateConfiguration(config_json)) {
+    SetError("Configuration is not a valid JSON object");
+    return false;
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  // Blocks for the core's start grace period; callers run this off the UI thread
+  bool started = tunnelmax_core_start(config_json.data(), config_json.size(), -1) == 1;
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  timings_["start"] = elapsed;
+  if (!started) {
+    last_error_ = "sing-box failed to start; the native log in the work directory has its output";
+    return false;
+  }
+  last_error_.clear();
+  return true;
+}
+
+bool SingboxManager::Stop() {
+  auto begin = std::chrono::steady_clock::now();
+  bool stopped = tunnelmax_core_stop() == 1;
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  timings_["stop"] = elapsed;
+  if (!stopped) {
+    last_error_ = "Failed to stop sing-box";
+  }
+  return stopped;
+}
+
+void SingboxManager::Cleanup() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (initialized_) {
+    tunnelmax_core_cleanup();
+    initialized_ = false;
+  }
+}
+
+bool SingboxManager::IsRunning() const {
+  return tunnelmax_core_is_running() == 1;
+}
+
+pid_t SingboxManager::GetProcessId() const {
+  return static_cast<pid_t>(tunnelmax_core_pid());
+}
+
+NetworkStats SingboxManager::GetStatistics() const {
+  NetworkStats stats;
+  singbox_stats_values_t values;
+  if (tunnelmax_core_read_stats(&values) != 1) {
+    return stats;
+  }
+  // On the TUN device transmit is what applications send
+  stats.bytes_sent = values.upload_bytes;
+  stats.bytes_received = values.download_bytes;
+  stats.packets_sent = values.packets_sent;
+  stats.packets_received = values.packets_received;
+  stats.upload_speed = values.upload_speed;
+  stats.download_speed = values.download_speed;
+  stats.timestamp = values.updated_at_ms > 0 ? values.updated_at_ms : NowMs();
+  if (values.state == SINGBOX_CORE_RUNNING && values.started_at_ms > 0) {
+    stats.connection_duration = (NowMs() - values.started_at_ms) / 1000;
+  }
+  return stats;
+}
+
+std::string SingboxManager::GetProcessStatsJson() const {
+  return FormatJson(tunnelmax_core_format_process_stats);
+}
+
+std::string SingboxManager::GetDetailedStatsJson() const {
+  return FormatJson(tunnelmax_core_format_detailed_stats);
+}
+
+bool SingboxManager::ValidateConfiguration(const std::string& config_json) const {
+  return tunnelmax_core_validate_config(config_json.data(), config_json.size()) == 1;
+}
+
+bool SingboxManager::UpdateConfiguration(const std::string& config_json) {
+  if (tunnelmax_core_update_config(config_json.data(), config_json.size()) != 1) {
+    SetError(IsRunning() ? "Configuration is not a valid JSON object" : "sing-box is not running");
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> SingboxManager::GetSupportedProtocols() const {
+  return {"vless", "vmess", "trojan", "shadowsocks", "http", "socks"};
+}
+
+std::string SingboxManager::GetLastErrorMessage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_error_;
+}
+
+std::map<std::string, int64_t> SingboxManager::GetOperationTimings() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return timings_;
+}
+
+std::string SingboxManager::DefaultWorkDir() {
+  const char* work_dir = getenv("TUNNELMAX_WORK_DIR");
+  if (work_dir && *work_dir) {
+    return work_dir;
+  }
+  const char* state_home = getenv("XDG_STATE_HOME");
+  if (state_home && *state_home == '/') {
+    return std::string(state_home) + "/tunnel_max";
+  }
+  const char* home = getenv("HOME");
+  return std::string(home && *home ? home : "/tmp") + "/.local/state/tunnel_max";
+}
+
+std::string SingboxManager::FindBinary() {
+  const char* binary = getenv("TUNNELMAX_SINGBOX");
+  if (binary && *binary) {
+    return binary;
+  }
+
+  // Bundled with the application
+  char executable[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+  if (length > 0) {
+    executable[length] = '\0';
+    std::string dir(executable);
+    dir.resize(dir.rfind('/'));
+    for (const char* relative : {"/sing-box", "/lib/sing-box"}) {
+      if (IsExecutable(dir + relative)) {
+        return dir + relative;
+      }
+    }
+  }
+
+  const char* path = getenv("PATH");
+  std::string paths = path ? path : "/usr/local/bin:/usr/bin:/bin";
+  size_t begin = 0;
+  while (begin <= paths.size()) {
+    size_t end = paths.find(':', begin);
+    if (end == std::string::npos) {
+      end = paths.size();
+    }
+    std::string candidate = paths.substr(begin, end - begin) + "/sing-box";
+    if (end > begin && IsExecutable(candidate)) {
+      return candidate;
+    }
+    begin = end + 1;
+  }
+  return std::string();
+}
+
+void SingboxManager::SetError(const std::string& message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  last_error_ = message;
+}
@@ -0,0 +1,84 @@
+#ifndef RUNNER_SINGBOX_MANAGER_H_
+#define RUNNER_SINGBOX_MANAGER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+struct NetworkStats {
+  int64_t bytes_received = 0;
+  int64_t bytes_sent = 0;
+  int64_t connection_duration = 0;  // Seconds
+  int64_t timestamp = 0;            // Milliseconds since the epoch
+  double upload_speed = 0;
+  double download_speed = 0;
+  int64_t packets_received = 0;
+  int64_t packets_sent = 0;
+};
+
+// sing-box on the Linux desktop, driven through libtunnelmax_core: the same
+// core as Android, which spawns sing-box with posix_spawn, publishes the
+// traffic counters of the TUN device (rtnetlink, sysfs as fallback) and
+// samples the process from /proc.
+//
+// The runner links the shared library rather than its own copy of the
+// core, so the instance this class starts is the one Dart reads through
+// dart:ffi (lib/platform/tunnelmax_core_ffi.dart).
+//
+// Free of GTK and Flutter types so the host build can test it.
+class SingboxManager {
+ public:
+  SingboxManager();
+  ~SingboxManager();
+
+  SingboxManager(const SingboxManager&) = delete;
+  SingboxManager& operator=(const SingboxManager&) = delete;
+
+  // Keep the configuration and the native log in `work_dir`, run `binary`
+  // and count traffic on `tun_interface`, the device the configuration's
+  // tun inbound creates
+  bool Initialize(const std::string& work_dir, const std::string& binary,
+                  const std::string& tun_interface);
+  bool Start(const std::string& config_json);
+  bool Stop();
+  void Cleanup();
+
+  // Status and statistics; never wait for a start or stop in progress
+  bool IsRunning() const;
+  // The sing-box process, for Reactor::WatchProcessExit; 0 when none runs
+  pid_t GetProcessId() const;
+  NetworkStats GetStatistics() const;
+  // /proc figures of the sing-box process as JSON, empty when not running
+  std::string GetProcessStatsJson() const;
+  // Parsed events, error categories and log pipeline counters as JSON
+  std::string GetDetailedStatsJson() const;
+
+  // Configuration management
+  bool ValidateConfiguration(const std::string& config_json) const;
+  bool UpdateConfiguration(const std::string& config_json);
+  std::vector<std::string> GetSupportedProtocols() const;
+
+  std::string GetLastErrorMessage() const;
+  // Duration of the last start and stop, in milliseconds
+  std::map<std::string, int64_t> GetOperationTimings() const;
+
+  // $TUNNELMAX_WORK_DIR, else $XDG_STATE_HOME/tunnel_max (~/.local/state)
+  static std::string DefaultWorkDir();
+  // $TUNNELMAX_SINGBOX, else sing-box next to the executable, else on $PATH
+  static std::string FindBinary();
+
+ private:
+  void SetError(const std::string& message);
+
+  mutable std::mutex mutex_;
+  bool initialized_ = false;
+  std::string last_error_;
+  std::map<std::string, int64_t> timings_;
+};
+
+#endif  // RUNNER_SINGBOX_MANAGER_H_
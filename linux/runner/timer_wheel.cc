@@ -0,0 +1,224 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr uint64_t kSlotMask = TimerWheel::kSlots - 1;
+
+// Ticks covered by one revolution of `level`
+constexpr uint64_t LevelRange(int level) {
+  return uint64_t{1} << (TimerWheel::kSlotBits * (level + 1));
+}
+
+}  // namespace
+
+TimerWheel::TimerWheel(uint64_t now) : now_(now) {}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t deadline, Callback callback) {
+  int32_t index = Allocate();
+  Node& node = nodes_[index];
+  node.deadline = std::max(deadline, now_ + 1);
+  node.sequence = next_sequence_++;
+  node.callback = std::move(callback);
+  Place(index);
+  pending_++;
+  stats_.scheduled++;
+  return (static_cast<uint64_t>(node.generation) << 32) | static_cast<uint32_t>(index);
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+  int32_t index = static_cast<int32_t>(id & 0xffffffffu);
+  uint32_t generation = static_cast<uint32_t>(id >> 32);
+  if (index < 0 || static_cast<size_t>(index) >= nodes_.size()) {
+    return false;
+  }
+  Node& node = nodes_[index];
+  if (node.level < 0 || node.generation != generation) {
+    return false;
+  }
+  Unlink(index);
+  Release(index);
+  pending_--;
+  stats_.cancelled++;
+  return true;
+}
+
+size_t TimerWheel::Advance(uint64_t now) {
+  if (now <= now_) {
+    return 0;
+  }
+  if (pending_ == 0) {
+    now_ = now;
+    return 0;
+  }
+  std::vector<Callback> due;
+  if (now - now_ > static_cast<uint64_t>(kSlots)) {
+    Jump(now, &due);
+  } else {
+    while (now_ < now) {
+      Tick(&due);
+    }
+  }
+  stats_.fired += due.size();
+  for (Callback& callback : due) {
+    callback();
+  }
+  return due.size();
+}
+
+uint64_t TimerWheel::NextDeadline() const {
+  if (pending_ == 0) {
+    return kNever;
+  }
+  uint64_t next = kNever;
+  for (int level = 0; level < kLevels; level++) {
+    int shift = kSlotBits * level;
+    bool top = level == kLevels - 1;
+    // Slots in the order time reaches them; the top level also holds the
+    // far deadlines parked in its last slot, so it is searched whole
+    for (uint64_t ahead = 1; ahead <= static_cast<uint64_t>(kSlots); ahead++) {
+      const Slot& slot = slots_[level][((now_ >> shift) + ahead) & kSlotMask];
+      if (slot.head < 0) {
+        continue;
+      }
+      for (int32_t index = slot.head; index >= 0; index = nodes_[index].next) {
+        next = std::min(next, nodes_[index].deadline);
+      }
+      if (!top) {
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void TimerWheel::Place(int32_t index) {
+  uint64_t deadline = nodes_[index].deadline;
+  uint64_t distance = deadline - now_;
+  for (int level = 0; level < kLevels; level++) {
+    if (distance < LevelRange(level)) {
+      Link(index, level, static_cast<int>((deadline >> (kSlotBits * level)) & kSlotMask));
+      return;
+    }
+  }
+  // Beyond the wheel: wait in the farthest slot and be placed again
+  uint64_t farthest = now_ + LevelRange(kLevels - 1) - 1;
+  Link(index, kLevels - 1, static_cast<int>((farthest >> (kSlotBits * (kLevels - 1))) & kSlotMask));
+}
+
+void TimerWheel::Link(int32_t index, int level, int slot) {
+  Node& node = nodes_[index];
+  Slot& list = slots_[level][slot];
+  node.level = static_cast<int16_t>(level);
+  node.slot = static_cast<int16_t>(slot);
+  node.prev = list.tail;
+  node.next = -1;
+  if (list.tail >= 0) {
+    nodes_[list.tail].next = index;
+  } else {
+    list.head = index;
+  }
+  list.tail = index;
+}
+
+void TimerWheel::Unlink(int32_t index) {
+  Node& node = nodes_[index];
+  Slot& list = slots_[node.level][node.slot];
+  if (node.prev >= 0) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    list.head = node.next;
+  }
+  if (node.next >= 0) {
+    nodes_[node.next].prev = node.prev;
+  } else {
+    list.tail = node.prev;
+  }
+  node.prev = node.next = -1;
+}
+
+int32_t TimerWheel::Allocate() {
+  if (!free_.empty()) {
+    int32_t index = free_.back();
+    free_.pop_back();
+    return index;
+  }
+  nodes_.emplace_back();
+  return static_cast<int32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::Release(int32_t index) {
+  Node& node = nodes_[index];
+  node.level = -1;
+  node.generation++;
+  node.callback = nullptr;
+  free_.push_back(index);
+}
+
+void TimerWheel::Cascade(int level) {
+  Slot& list = slots_[level][(now_ >> (kSlotBits * level)) & kSlotMask];
+  int32_t index = list.head;
+  list.head = list.tail = -1;
+  while (index >= 0) {
+    int32_t next = nodes_[index].next;
+    Place(index);
+    stats_.cascaded++;
+    index = next;
+  }
+}
+
+void TimerWheel::Tick(std::vector<Callback>* due) {
+  now_++;
+  // Entering a new slot of a higher level brings its timers down
+  int aligned = 0;
+  while (aligned + 1 < kLevels && (now_ & (LevelRange(aligned) - 1)) == 0) {
+    aligned++;
+  }
+  for (int level = aligned; level >= 1; level--) {
+    Cascade(level);
+  }
+  // Cascades append, so a slot is in scheduling order only per level
+  Slot& list = slots_[0][now_ & kSlotMask];
+  std::vector<int32_t> expired;
+  for (int32_t index = list.head; index >= 0; index = nodes_[index].next) {
+    expired.push_back(index);
+  }
+  list.head = list.tail = -1;
+  Fire(&expired, due);
+}
+
+void TimerWheel::Fire(std::vector<int32_t>* indices, std::vector<Callback>* due) {
+  std::sort(indices->begin(), indices->end(), [this](int32_t a, int32_t b) {
+    const Node& x = nodes_[a];
+    const Node& y = nodes_[b];
+    return x.deadline != y.deadline ? x.deadline < y.deadline : x.sequence < y.sequence;
+  });
+  for (int32_t index : *indices) {
+    nodes_[index].prev = nodes_[index].next = -1;
+    due->push_back(std::move(nodes_[index].callback));
+    Release(index);
+    pending_--;
+  }
+}
+
+void TimerWheel::Jump(uint64_t now, std::vector<Callback>* due) {
+  stats_.jumps++;
+  std::vector<int32_t> expired;
+  std::vector<int32_t> later;
+  for (auto& level : slots_) {
+    for (Slot& list : level) {
+      for (int32_t index = list.head; index >= 0; index = nodes_[index].next) {
+        (nodes_[index].deadline <= now ? expired : later).push_back(index);
+      }
+      list.head = list.tail = -1;
+    }
+  }
+  now_ = now;
+  Fire(&expired, due);
+  for (int32_t index : later) {
+    nodes_[index].prev = nodes_[index].next = -1;
+    Place(index);
+  }
+}
@@ -0,0 +1,104 @@
+#ifndef RUNNER_TIMER_WHEEL_H_
+#define RUNNER_TIMER_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timer wheel: kLevels wheels of kSlots slots, each slot of
+// level L spanning kSlots^L ticks. A timer goes to the lowest level whose
+// range covers its distance from now; when time enters a slot of a higher
+// level, that slot's timers cascade down a level, so every timer is moved
+// at most kLevels - 1 times. Scheduling and cancelling are O(1), and
+// advancing by one tick looks at one slot.
+//
+// Level 0 slots hold timers of one exact tick, so timers fire in deadline
+// order and, within a tick, in the order they were scheduled. Deadlines
+// beyond the top level's range wait in its farthest slot and are placed
+// again when it cascades. A jump longer than a level-0 revolution does not
+// walk tick by tick: it fires what is due in order and re-places the rest.
+//
+// Time is whatever the owner counts in ticks (the Reactor uses
+// milliseconds); the wheel never reads a clock. Not thread safe.
+class TimerWheel {
+ public:
+  using TimerId = uint64_t;
+  using Callback = std::function<void()>;
+
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr uint64_t kNever = UINT64_MAX;
+
+  struct Stats {
+    uint64_t scheduled = 0;
+    uint64_t cancelled = 0;
+    uint64_t fired = 0;
+    uint64_t cascaded = 0;  // Timers moved down a level
+    uint64_t jumps = 0;     // Advances that re-placed every timer instead
+  };
+
+  explicit TimerWheel(uint64_t now = 0);
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Run `callback` from the Advance() that reaches `deadline`; a deadline
+  // not after now fires on the next tick
+  // @return Never 0
+  TimerId Schedule(uint64_t deadline, Callback callback);
+  // @return Whether the timer was pending; false once it fired
+  bool Cancel(TimerId id);
+
+  // Move time to `now` and fire every timer due by then. Callbacks run
+  // after the wheel is updated and may schedule and cancel timers; those
+  // they schedule at or before `now` wait for the next Advance().
+  // @return Number of timers fired
+  size_t Advance(uint64_t now);
+
+  // Earliest pending deadline, kNever when there is none
+  uint64_t NextDeadline() const;
+
+  uint64_t now() const { return now_; }
+  size_t size() const { return pending_; }
+  Stats GetStats() const { return stats_; }
+
+ private:
+  struct Node {
+    uint64_t deadline = 0;
+    uint64_t sequence = 0;  // Scheduling order, for ties
+    uint32_t generation = 1;  // Ids are never 0
+    int32_t prev = -1;
+    int32_t next = -1;
+    int16_t level = -1;  // -1 while free
+    int16_t slot = 0;
+    Callback callback;
+  };
+
+  struct Slot {
+    int32_t head = -1;
+    int32_t tail = -1;
+  };
+
+  void Place(int32_t index);
+  void Link(int32_t index, int level, int slot);
+  void Unlink(int32_t index);
+  int32_t Allocate();
+  void Release(int32_t index);
+  void Cascade(int level);
+  void Tick(std::vector<Callback>* due);
+  void Jump(uint64_t now, std::vector<Callback>* due);
+  // Hand the timers of `indices` to `due` in scheduling order
+  void Fire(std::vector<int32_t>* indices, std::vector<Callback>* due);
+
+  uint64_t now_;
+  uint64_t next_sequence_ = 0;
+  size_t pending_ = 0;
+  std::vector<Node> nodes_;
+  std::vector<int32_t> free_;
+  Slot slots_[kLevels][kSlots];
+  Stats stats_;
+};
+
+#endif  // RUNNER_TIMER_WHEEL_H_
@@ -0,0 +1,1412 @@
+#include "vpn_plugin.h"
+
+#include <dirent.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <linux/capability.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CreditFlow.h"
+#include "StatusSnapshot.h"
+#include "TaskExecutor.h"
+#include "network_change_detector.h"
+#include "reactor.h"
+#include "singbox_manager.h"
+
+namespace {
+
+// The device the tun inbound of the generated configuration creates
+constexpr char kTunInterface[] = "tun0";
+constexpr char kLifecycleKey[] = "lifecycle";
+constexpr char kReconnectKey[] = "reconnect";
+constexpr char kConfigPrefix[] = "vpn_config_";
+constexpr guint kStatsIntervalSeconds = 1;
+// sing-box's auto_route settles before a restart after a network change
+constexpr auto kReconnectSettle = std::chrono::milliseconds(1000);
+
+using StatsFlow = CreditFlow<NetworkStats>;
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Run `task` on the GTK main thread: at once when called there, otherwise
+// from the main loop
+void RunOnMainThread(std::function<void()> task) {
+  g_main_context_invoke_full(
+      nullptr, G_PRIORITY_DEFAULT,
+      [](gpointer data) -> gboolean {
+        (*static_cast<std::function<void()>*>(data))();
+        return G_SOURCE_REMOVE;
+      },
+      new std::function<void()>(std::move(task)),
+      [](gpointer data) { delete static_cast<std::function<void()>*>(data); });
+}
+
+// Answer `call` on the main thread; takes the response
+void Reply(FlMethodCall* call, FlMethodResponse* response) {
+  g_object_ref(call);
+  RunOnMainThread([call, response]() {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(call, response, &error)) {
+      g_warning("VpnPlugin: failed to respond to %s: %s", fl_method_call_get_name(call),
+                error->message);
+    }
+    g_object_unref(response);
+    g_object_unref(call);
+  });
+}
+
+// Takes `value`
+void ReplySuccess(FlMethodCall* call, FlValue* value) {
+  g_autoptr(FlValue) result = value;
+  Reply(call, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+}
+
+void ReplyError(FlMethodCall* call, const char* code, const std::string& message) {
+  Reply(call, FL_METHOD_RESPONSE(fl_method_error_response_new(code, message.c_str(), nullptr)));
+}
+
+FlValue* Lookup(FlValue* map, const char* key) {
+  if (map == nullptr || fl_value_get_type(map) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+  return fl_value_lookup_string(map, key);
+}
+
+std::string LookupString(FlValue* map, const char* key) {
+  FlValue* value = Lookup(map, key);
+  return value && fl_value_get_type(value) == FL_VALUE_TYPE_STRING ? fl_value_get_string(value)
+                                                                   : std::string();
+}
+
+int64_t LookupInt(FlValue* map, const char* key, int64_t fallback) {
+  FlValue* value = Lookup(map, key);
+  return value && fl_value_get_type(value) == FL_VALUE_TYPE_INT ? fl_value_get_int(value)
+                                                                : fallback;
+}
+
+void AppendJsonString(std::string& out, const char* value) {
+  out += '"';
+  for (const char* c = value; *c; ++c) {
+    switch (*c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+          out += escaped;
+        } else {
+          out += *c;
+        }
+    }
+  }
+  out += '"';
+}
+
+void AppendJsonNumber(std::string& out, double value) {
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  char number[32];
+  snprintf(number, sizeof(number), "%.17g", value);
+  out += number;
+}
+
+// The singboxConfig map Dart generated, as the JSON sing-box reads
+void AppendJson(std::string& out, FlValue* value) {
+  switch (fl_value_get_type(value)) {
+    case FL_VALUE_TYPE_BOOL:
+      out += fl_value_get_bool(value) ? "true" : "false";
+      break;
+    case FL_VALUE_TYPE_INT:
+      out += std::to_string(fl_value_get_int(value));
+      break;
+    case FL_VALUE_TYPE_FLOAT:
+      AppendJsonNumber(out, fl_value_get_float(value));
+      break;
+    case FL_VALUE_TYPE_STRING:
+      AppendJsonString(out, fl_value_get_string(value));
+      break;
+    case FL_VALUE_TYPE_UINT8_LIST:
+    case FL_VALUE_TYPE_INT32_LIST:
+    case FL_VALUE_TYPE_INT64_LIST:
+    case FL_VALUE_TYPE_FLOAT_LIST: {
+      out += '[';
+      FlValueType type = fl_value_get_type(value);
+      for (size_t i = 0; i < fl_value_get_length(value); ++i) {
+        out += i ? "," : "";
+        if (type == FL_VALUE_TYPE_UINT8_LIST) {
+          out += std::to_string(fl_value_get_uint8_list(value)[i]);
+        } else if (type == FL_VALUE_TYPE_INT32_LIST) {
+          out += std::to_string(fl_value_get_int32_list(value)[i]);
+        } else if (type == FL_VALUE_TYPE_INT64_LIST) {
+          out += std::to_string(fl_value_get_int64_list(value)[i]);
+        } else {
+          AppendJsonNumber(out, fl_value_get_float_list(value)[i]);
+        }
+      }
+      out += ']';
+      break;
+    }
+    case FL_VALUE_TYPE_LIST:
+      out += '[';
+      for (size_t i = 0; i < fl_value_get_length(value); ++i) {
+        out += i ? "," : "";
+        AppendJson(out, fl_value_get_list_value(value, i));
+      }
+      out += ']';
+      break;
+    case FL_VALUE_TYPE_MAP: {
+      out += '{';
+      bool first = true;
+      for (size_t i = 0; i < fl_value_get_length(value); ++i) {
+        FlValue* key = fl_value_get_map_key(value, i);
+        if (fl_value_get_type(key) != FL_VALUE_TYPE_STRING) {
+          continue;  // JSON has string keys only
+        }
+        out += first ? "" : ",";
+        first = false;
+        AppendJsonString(out, fl_value_get_string(key));
+        out += ':';
+        AppendJson(out, fl_value_get_map_value(value, i));
+      }
+      out += '}';
+      break;
+    }
+    default:
+      out += "null";
+  }
+}
+
+std::string HexEncode(const std::string& data) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::string hex;
+  for (unsigned char c : data) {
+    hex += kDigits[c >> 4];
+    hex += kDigits[c & 0xf];
+  }
+  return hex;
+}
+
+bool HexDecode(const std::string& hex, std::string* data) {
+  if (hex.size() % 2) {
+    return false;
+  }
+  data->clear();
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    int high = g_ascii_xdigit_value(hex[i]);
+    int low = g_ascii_xdigit_value(hex[i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    *data += static_cast<char>(high << 4 | low);
+  }
+  return true;
+}
+
+// The whole file or nothing: written next to `path` and renamed over it
+bool WriteFileAtomically(const std::string& path, const void* data, size_t length) {
+  std::string temporary = path + ".tmp";
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  const char* bytes = static_cast<const char*>(data);
+  size_t written = 0;
+  while (written < length) {
+    ssize_t n = write(fd, bytes + written, length - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    written += static_cast<size_t>(n);
+  }
+  bool complete = written == length && fsync(fd) == 0;
+  close(fd);
+  if (!complete || rename(temporary.c_str(), path.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+// sing-box needs CAP_NET_ADMIN for the TUN device and its routes: running
+// as root, or file capabilities on the binary (setcap ...+ep), which the
+// kernel grants at exec. The xattr is a vfs_cap_data of any revision; only
+// a permitted CAP_NET_ADMIN with the effective flag counts, since sing-box
+// does not raise capabilities itself
+bool HasNetAdmin(const std::string& binary) {
+  if (geteuid() == 0) {
+    return true;
+  }
+  if (binary.empty()) {
+    return false;
+  }
+  uint32_t words[XATTR_CAPS_SZ_3 / sizeof(uint32_t)] = {};
+  ssize_t size = getxattr(binary.c_str(), "security.capability", words, sizeof(words));
+  if (size < static_cast<ssize_t>(XATTR_CAPS_SZ_1)) {
+    return false;
+  }
+  uint32_t magic = le32toh(words[0]);
+  size_t expected = 0;
+  switch (magic & VFS_CAP_REVISION_MASK) {
+    case VFS_CAP_REVISION_1: expected = XATTR_CAPS_SZ_1; break;
+    case VFS_CAP_REVISION_2: expected = XATTR_CAPS_SZ_2; break;
+    case VFS_CAP_REVISION_3: expected = XATTR_CAPS_SZ_3; break;
+    default: return false;
+  }
+  if (static_cast<size_t>(size) != expected || !(magic & VFS_CAP_FLAGS_EFFECTIVE)) {
+    return false;
+  }
+  // data[0].permitted holds capabilities 0-31 in every revision
+  return (le32toh(words[1]) & (1u << CAP_NET_ADMIN)) != 0;
+}
+
+}  // namespace
+
+class VpnPlugin {
+ public:
+  explicit VpnPlugin(FlPluginRegistrar* registrar);
+  ~VpnPlugin();
+
+  VpnPlugin(const VpnPlugin&) = delete;
+  VpnPlugin& operator=(const VpnPlugin&) = delete;
+
+  void HandleMethodCall(FlMethodCall* call);
+
+ private:
+  using TaskFn = std::function<void(const CancellationToken& token, FlMethodCall* call)>;
+
+  // Run `task` on the executor; if it will not run, `call` gets the reason
+  void RunOnExecutor(TaskExecutor::Lane lane, const std::string& key, const std::string& operation,
+                     FlMethodCall* call, TaskFn task);
+
+  void Connect(FlMethodCall* call, FlValue* args);
+  void Disconnect(FlMethodCall* call);
+  void RequestVpnPermission(FlMethodCall* call);
+  void ValidateConfiguration(FlMethodCall* call, FlValue* config);
+  void SaveConfiguration(FlMethodCall* call, FlValue* config, bool must_exist);
+  void LoadConfigurations(FlMethodCall* call);
+  void DeleteAllConfigurations(FlMethodCall* call);
+  void IsSecureStorageAvailable(FlMethodCall* call);
+  void GetStorageInfo(FlMethodCall* call);
+
+  // Main thread: the connection state changed
+  void OnConnectionChanged();
+  void OnNetworkChanged(NetworkState state, const std::string& reason);
+  void ScheduleReconnection(const std::string& reason);
+
+  // The sing-box process of the connection is watched through a pidfd, so
+  // a crash flips the state and reaches Dart without polling. A deliberate
+  // stop unwatches first.
+  void WatchCore();
+  void UnwatchCore();
+  // Reactor thread: process `pid` is gone
+  void OnCoreExited(pid_t pid);
+
+  FlMethodErrorResponse* OnStatsListen(FlValue* args);
+  void OnStatsCancel();
+  void EmitStatsEvent(const NetworkStats& stats, uint64_t skipped);
+  // Sample only while someone listens to a connected tunnel
+  void UpdateStatsTimer();
+  static gboolean OnStatsTick(gpointer user_data);
+  void SendStatus();
+
+  FlValue* CreateStatusMap();
+  FlValue* CreateStatsMap(const NetworkStats& stats);
+  FlValue* CreateStatsStreamMap();
+  FlValue* CreateExecutorStatsMap();
+  FlValue* CreateDetailedStatus(FlValue* args);
+  // Sections of getDetailedStatus, re-encoded only when their inputs change
+  void RefreshStatusSections();
+  StatusSnapshot::Bytes EncodeStatusSection(FlValue* section);
+  FlValue* CreateStatusSnapshotMap();
+
+  std::string GenerateConfigJson(FlValue* config);
+
+  // Secure data: one 0600 file per key in a 0700 directory of the work dir
+  std::string SecurePath(const std::string& key) const;
+  bool SaveSecureData(const std::string& key, const void* data, size_t length);
+  bool LoadSecureData(const std::string& key, std::string* data) const;
+  bool DeleteSecureData(const std::string& key);
+  std::vector<std::string> ListSecureKeys() const;
+
+  std::unique_ptr<TaskExecutor> executor_;
+  // Main-thread callbacks queued by other threads hold a weak reference
+  std::shared_ptr<VpnPlugin*> self_;
+
+  FlMethodChannel* channel_ = nullptr;
+  FlEventChannel* status_channel_ = nullptr;
+  FlEventChannel* stats_channel_ = nullptr;
+
+  SingboxManager manager_;
+  // Timers and OS events of the plugin, on one thread; outlives the detector
+  Reactor reactor_;
+  NetworkChangeDetector detector_{kTunInterface, reactor_};
+  std::string work_dir_;
+  std::string binary_;
+  std::string secure_dir_;
+
+  std::atomic<bool> is_connected_{false};
+  std::atomic<bool> is_connecting_{false};
+  std::mutex mutex_;  // Guards the strings below and connection_start_ms_
+  std::string current_server_;
+  std::string last_error_;
+  std::string last_config_json_;
+  int64_t connection_start_ms_ = 0;
+  std::atomic<pid_t> watched_pid_{0};
+  int exit_watch_fd_ = -1;  // Reactor thread only
+  std::mutex storage_mutex_;
+
+  // Main thread only
+  bool status_listener_active_ = false;
+  bool stats_listener_active_ = false;
+  bool stats_streaming_active_ = false;
+  guint stats_timer_ = 0;
+  Reactor::TimerId reconnect_timer_ = 0;
+  uint64_t stats_event_seq_ = 0;
+  StatsFlow stats_flow_;
+  StatusSnapshot status_snapshot_;
+};
+
+VpnPlugin::VpnPlugin(FlPluginRegistrar* registrar)
+    : executor_(std::make_unique<TaskExecutor>()),
+      self_(std::make_shared<VpnPlugin*>(this)),
+      stats_flow_([this](const NetworkStats& stats, uint64_t skipped) {
+        EmitStatsEvent(stats, skipped);
+      }) {
+  FlBinaryMessenger* messenger = fl_plugin_registrar_get_messenger(registrar);
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  channel_ = fl_method_channel_new(messenger, "vpn_control", FL_METHOD_CODEC(codec));
+  status_channel_ = fl_event_channel_new(messenger, "vpn_status", FL_METHOD_CODEC(codec));
+  stats_channel_ = fl_event_channel_new(messenger, "vpn_stats", FL_METHOD_CODEC(codec));
+
+  fl_method_channel_set_method_call_handler(
+      channel_,
+      [](FlMethodChannel*, FlMethodCall* call, gpointer user_data) {
+        static_cast<VpnPlugin*>(user_data)->HandleMethodCall(call);
+      },
+      this, nullptr);
+  fl_event_channel_set_stream_handlers(
+      status_channel_,
+      [](FlEventChannel*, FlValue*, gpointer user_data) -> FlMethodErrorResponse* {
+        auto* plugin = static_cast<VpnPlugin*>(user_data);
+        plugin->status_listener_active_ = true;
+        plugin->SendStatus();
+        return nullptr;
+      },
+      [](FlEventChannel*, FlValue*, gpointer user_data) -> FlMethodErrorResponse* {
+        static_cast<VpnPlugin*>(user_data)->status_listener_active_ = false;
+        return nullptr;
+      },
+      this, nullptr);
+  fl_event_channel_set_stream_handlers(
+      stats_channel_,
+      [](FlEventChannel*, FlValue* args, gpointer user_data) -> FlMethodErrorResponse* {
+        return static_cast<VpnPlugin*>(user_data)->OnStatsListen(args);
+      },
+      [](FlEventChannel*, FlValue*, gpointer user_data) -> FlMethodErrorResponse* {
+        static_cast<VpnPlugin*>(user_data)->OnStatsCancel();
+        return nullptr;
+      },
+      this, nullptr);
+
+  work_dir_ = SingboxManager::DefaultWorkDir();
+  binary_ = SingboxManager::FindBinary();
+  secure_dir_ = work_dir_ + "/secure";
+  if (!manager_.Initialize(work_dir_, binary_, kTunInterface)) {
+    g_warning("VpnPlugin: %s", manager_.GetLastErrorMessage().c_str());
+  }
+  if (mkdir(secure_dir_.c_str(), 0700) != 0 && errno != EEXIST) {
+    g_warning("VpnPlugin: cannot create %s: %s", secure_dir_.c_str(), strerror(errno));
+  }
+  if (!reactor_.Start()) {
+    g_warning("VpnPlugin: event reactor unavailable");
+  }
+
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  detector_.SetChangeCallback([weak](NetworkState state, const std::string& reason) {
+    RunOnMainThread([weak, state, reason]() {
+      if (auto self = weak.lock()) {
+        (*self)->OnNetworkChanged(state, reason);
+      }
+    });
+  });
+}
+
+VpnPlugin::~VpnPlugin() {
+  // Nothing queued for the main thread reaches this object any more
+  self_.reset();
+  // No timer submits work once the executor winds down
+  reactor_.Stop();
+  // Queued calls are answered, running ones finish before anything they use goes away
+  executor_->Shutdown();
+  detector_.StopMonitoring();
+  if (stats_timer_ != 0) {
+    g_source_remove(stats_timer_);
+  }
+  if (is_connected_) {
+    manager_.Stop();
+  }
+  manager_.Cleanup();
+
+  fl_method_channel_set_method_call_handler(channel_, nullptr, nullptr, nullptr);
+  fl_event_channel_set_stream_handlers(status_channel_, nullptr, nullptr, nullptr, nullptr);
+  fl_event_channel_set_stream_handlers(stats_channel_, nullptr, nullptr, nullptr, nullptr);
+  g_object_unref(stats_channel_);
+  g_object_unref(status_channel_);
+  g_object_unref(channel_);
+}
+
+void VpnPlugin::HandleMethodCall(FlMethodCall* call) {
+  const std::string method = fl_method_call_get_name(call);
+  FlValue* args = fl_method_call_get_args(call);
+  bool map_args = args && fl_value_get_type(args) == FL_VALUE_TYPE_MAP;
+  bool string_args = args && fl_value_get_type(args) == FL_VALUE_TYPE_STRING;
+
+  if (method == "connect") {
+    if (!map_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration map required");
+      return;
+    }
+    Connect(call, args);
+  } else if (method == "disconnect") {
+    Disconnect(call);
+  } else if (method == "getStatus") {
+    ReplySuccess(call, CreateStatusMap());
+  } else if (method == "getNetworkStats") {
+    ReplySuccess(call, is_connected_ ? CreateStatsMap(manager_.GetStatistics()) : fl_value_new_null());
+  } else if (method == "getRealTimeStats") {
+    if (!is_connected_) {
+      ReplyError(call, "NOT_CONNECTED", "VPN is not connected");
+      return;
+    }
+    NetworkStats stats = manager_.GetStatistics();
+    g_autoptr(FlValue) smoothed = fl_value_new_map();
+    // The core's rates are already averaged over its sampling interval
+    fl_value_set_string_take(smoothed, "downloadSpeed", fl_value_new_float(stats.download_speed));
+    fl_value_set_string_take(smoothed, "uploadSpeed", fl_value_new_float(stats.upload_speed));
+    g_autoptr(FlValue) health = fl_value_new_map();
+    fl_value_set_string_take(health, "isCollecting", fl_value_new_bool(stats_timer_ != 0));
+    fl_value_set_string_take(health, "singboxRunning", fl_value_new_bool(manager_.IsRunning()));
+    FlValue* result = fl_value_new_map();
+    fl_value_set_string_take(result, "current", CreateStatsMap(stats));
+    fl_value_set_string(result, "smoothed", smoothed);
+    fl_value_set_string(result, "collectionHealth", health);
+    ReplySuccess(call, result);
+  } else if (method == "startStatsStream") {
+    if (!is_connected_) {
+      ReplyError(call, "NOT_CONNECTED", "VPN is not connected");
+      return;
+    }
+    stats_streaming_active_ = true;
+    UpdateStatsTimer();
+    ReplySuccess(call, fl_value_new_bool(true));
+  } else if (method == "stopStatsStream") {
+    stats_streaming_active_ = false;
+    UpdateStatsTimer();
+    ReplySuccess(call, fl_value_new_bool(true));
+  } else if (method == "ackStats") {
+    int64_t count = LookupInt(args, "count", 1);
+    if (count > 0) {
+      stats_flow_.Ack(static_cast<uint32_t>(std::min<int64_t>(count, UINT32_MAX)));
+    }
+    ReplySuccess(call, fl_value_new_int(stats_flow_.GetStats().credits));
+  } else if (method == "getStatsStreamInfo") {
+    ReplySuccess(call, CreateStatsStreamMap());
+  } else if (method == "getDetailedStatus") {
+    ReplySuccess(call, CreateDetailedStatus(args));
+  } else if (method == "hasVpnPermission") {
+    ReplySuccess(call, fl_value_new_bool(HasNetAdmin(binary_)));
+  } else if (method == "requestVpnPermission") {
+    RequestVpnPermission(call);
+  } else if (method == "validateConfiguration") {
+    if (!map_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration map required");
+      return;
+    }
+    ValidateConfiguration(call, args);
+  } else if (method == "saveConfiguration") {
+    if (!map_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration map required");
+      return;
+    }
+    SaveConfiguration(call, args, false);
+  } else if (method == "loadConfigurations") {
+    LoadConfigurations(call);
+  } else if (method == "deleteConfiguration") {
+    if (!string_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration ID string required");
+      return;
+    }
+    ReplySuccess(call, fl_value_new_bool(DeleteSecureData(kConfigPrefix + std::string(fl_value_get_string(args)))));
+  } else if (method == "loadConfiguration") {
+    if (!string_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration ID string required");
+      return;
+    }
+    std::string data;
+    if (!LoadSecureData(kConfigPrefix + std::string(fl_value_get_string(args)), &data)) {
+      ReplySuccess(call, fl_value_new_null());
+      return;
+    }
+    g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+    g_autoptr(GBytes) bytes = g_bytes_new(data.data(), data.size());
+    FlValue* config = fl_message_codec_decode_message(FL_MESSAGE_CODEC(codec), bytes, nullptr);
+    ReplySuccess(call, config ? config : fl_value_new_null());
+  } else if (method == "updateConfiguration") {
+    if (!map_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Configuration map required");
+      return;
+    }
+    // Only the newest update of a configuration matters
+    std::shared_ptr<FlValue> config(fl_value_ref(args), fl_value_unref);
+    RunOnExecutor(TaskExecutor::Lane::Serial, "config:" + LookupString(args, "id"),
+                  "updateConfiguration", call,
+                  [this, config](const CancellationToken&, FlMethodCall* call) {
+                    SaveConfiguration(call, config.get(), true);
+                  });
+  } else if (method == "deleteAllConfigurations") {
+    DeleteAllConfigurations(call);
+  } else if (method == "isSecureStorageAvailable") {
+    RunOnExecutor(TaskExecutor::Lane::Parallel, "", "isSecureStorageAvailable", call,
+                  [this](const CancellationToken&, FlMethodCall* call) {
+                    IsSecureStorageAvailable(call);
+                  });
+  } else if (method == "getStorageInfo") {
+    GetStorageInfo(call);
+  } else if (method == "saveSecureData") {
+    std::string key = LookupString(args, "key");
+    FlValue* data = Lookup(args, "data");
+    if (key.empty() || !data || fl_value_get_type(data) != FL_VALUE_TYPE_STRING) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Both key and data are required");
+      return;
+    }
+    const char* text = fl_value_get_string(data);
+    if (SaveSecureData(key, text, strlen(text))) {
+      ReplySuccess(call, fl_value_new_null());
+    } else {
+      ReplyError(call, "STORAGE_FAILED", "Failed to save data securely");
+    }
+  } else if (method == "loadSecureData") {
+    if (!string_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Key string required");
+      return;
+    }
+    std::string data;
+    bool found = LoadSecureData(fl_value_get_string(args), &data) && !data.empty();
+    ReplySuccess(call, found ? fl_value_new_string_sized(data.data(), data.size()) : fl_value_new_null());
+  } else if (method == "deleteSecureData") {
+    if (!string_args) {
+      ReplyError(call, "INVALID_ARGUMENTS", "Key string required");
+      return;
+    }
+    ReplySuccess(call, fl_value_new_bool(DeleteSecureData(fl_value_get_string(args))));
+  } else {
+    Reply(call, FL_METHOD_RESPONSE(fl_method_not_implemented_response_new()));
+  }
+}
+
+void VpnPlugin::RunOnExecutor(TaskExecutor::Lane lane, const std::string& key,
+                              const std::string& operation, FlMethodCall* call, TaskFn task) {
+  // Exactly one of the task and the cancel callback runs and answers the call
+  g_object_ref(call);
+  auto release = [](FlMethodCall* held) { g_object_unref(held); };
+  auto holder = std::shared_ptr<FlMethodCall>(call, release);
+  executor_->Submit(
+      lane, key,
+      [holder, task = std::move(task)](const CancellationToken& token) { task(token, holder.get()); },
+      [holder, operation](TaskExecutor::CancelReason reason) {
+        const char* code = "CANCELLED";
+        switch (reason) {
+          case TaskExecutor::CancelReason::Superseded: code = "SUPERSEDED"; break;
+          case TaskExecutor::CancelReason::Rejected: code = "BUSY"; break;
+          case TaskExecutor::CancelReason::Shutdown: code = "SHUTTING_DOWN"; break;
+          default: break;
+        }
+        ReplyError(holder.get(), code, operation + " request " + TaskExecutor::ReasonName(reason));
+      });
+}
+
+void VpnPlugin::Connect(FlMethodCall* call, FlValue* args) {
+  if (is_connected_ || is_connecting_) {
+    ReplyError(call, "ALREADY_CONNECTED", "VPN is already connected or connecting");
+    return;
+  }
+  if (binary_.empty()) {
+    ReplyError(call, "SINGBOX_NOT_FOUND",
+               "sing-box not found next to the application or on PATH; set TUNNELMAX_SINGBOX");
+    return;
+  }
+  if (!HasNetAdmin(binary_)) {
+    ReplyError(call, "INSUFFICIENT_PRIVILEGES",
+               "sing-box needs CAP_NET_ADMIN: setcap cap_net_admin,cap_net_raw+ep " + binary_);
+    return;
+  }
+
+  std::string config_json = GenerateConfigJson(args);
+  FlValue* config = Lookup(args, "config");
+  std::string server = LookupString(config ? config : args, "serverAddress");
+  // Connecting now wins over a pending automatic reconnection
+  reactor_.CancelTimer(reconnect_timer_);
+  executor_->Cancel(kReconnectKey);
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  RunOnExecutor(TaskExecutor::Lane::Serial, kLifecycleKey, "connect", call,
+                [this, weak, config_json, server](const CancellationToken& token, FlMethodCall* call) {
+    if (token.IsCancelled()) {
+      ReplyError(call, "SUPERSEDED", "connect request superseded");
+      return;
+    }
+    // An earlier connect may have completed while this one was queued
+    if (is_connected_) {
+      ReplyError(call, "ALREADY_CONNECTED", "VPN is already connected or connecting");
+      return;
+    }
+    is_connecting_ = true;
+    bool success = manager_.Start(config_json);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (success) {
+        current_server_ = server;
+        last_config_json_ = config_json;
+        connection_start_ms_ = NowMs();
+        last_error_.clear();
+      } else {
+        last_error_ = manager_.GetLastErrorMessage();
+      }
+    }
+    if (success) {
+      is_connected_ = true;
+      WatchCore();
+      if (!detector_.StartMonitoring()) {
+        g_warning("VpnPlugin: network change monitoring unavailable");
+      }
+    }
+    is_connecting_ = false;
+    RunOnMainThread([weak]() {
+      if (auto self = weak.lock()) {
+        (*self)->OnConnectionChanged();
+      }
+    });
+    if (success) {
+      ReplySuccess(call, fl_value_new_bool(true));
+    } else {
+      ReplyError(call, "CONNECTION_FAILED", manager_.GetLastErrorMessage());
+    }
+  });
+}
+
+void VpnPlugin::Disconnect(FlMethodCall* call) {
+  reactor_.CancelTimer(reconnect_timer_);
+  executor_->Cancel(kReconnectKey);
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  // Queued behind a connect in progress rather than racing it
+  RunOnExecutor(TaskExecutor::Lane::Serial, kLifecycleKey, "disconnect", call,
+                [this, weak](const CancellationToken&, FlMethodCall* call) {
+    if (!is_connected_) {
+      ReplySuccess(call, fl_value_new_bool(true));
+      return;
+    }
+    // Only a connected tunnel needs to hear about the network
+    UnwatchCore();
+    detector_.StopMonitoring();
+    bool success = manager_.Stop();
+    if (success) {
+      is_connected_ = false;
+      std::lock_guard<std::mutex> lock(mutex_);
+      current_server_.clear();
+      last_error_.clear();
+    }
+    RunOnMainThread([weak]() {
+      if (auto self = weak.lock()) {
+        (*self)->OnConnectionChanged();
+      }
+    });
+    if (success) {
+      ReplySuccess(call, fl_value_new_bool(true));
+    } else {
+      ReplyError(call, "DISCONNECTION_FAILED", manager_.GetLastErrorMessage());
+    }
+  });
+}
+
+void VpnPlugin::RequestVpnPermission(FlMethodCall* call) {
+  if (binary_.empty() || HasNetAdmin(binary_)) {
+    ReplySuccess(call, fl_value_new_bool(!binary_.empty()));
+    return;
+  }
+  // The polkit prompt is the desktop's counterpart of UAC; it blocks until
+  // the user answers, so it runs off the main thread
+  RunOnExecutor(TaskExecutor::Lane::Parallel, "permission", "requestVpnPermission", call,
+                [this](const CancellationToken&, FlMethodCall* call) {
+    const gchar* argv[] = {"pkexec", "setcap", "cap_net_admin,cap_net_raw+ep", binary_.c_str(),
+                           nullptr};
+    gint status = 0;
+    g_autoptr(GError) error = nullptr;
+    if (!g_spawn_sync(nullptr, const_cast<gchar**>(argv), nullptr, G_SPAWN_SEARCH_PATH, nullptr,
+                      nullptr, nullptr, nullptr, &status, &error)) {
+      g_warning("VpnPlugin: pkexec: %s", error->message);
+    }
+    ReplySuccess(call, fl_value_new_bool(HasNetAdmin(binary_)));
+  });
+}
+
+void VpnPlugin::ValidateConfiguration(FlMethodCall* call, FlValue* config) {
+  std::string server = LookupString(config, "serverAddress");
+  std::string protocol = LookupString(config, "protocol");
+  int64_t port = LookupInt(config, "serverPort", -1);
+  if (!Lookup(config, "serverAddress") || port < 0 || protocol.empty()) {
+    ReplyError(call, "INVALID_CONFIG", "Missing required configuration fields");
+    return;
+  }
+  if (server.empty()) {
+    ReplyError(call, "INVALID_CONFIG", "Server address cannot be empty");
+    return;
+  }
+  if (port < 1 || port > 65535) {
+    ReplyError(call, "INVALID_CONFIG", "Port must be between 1 and 65535");
+    return;
+  }
+  auto protocols = manager_.GetSupportedProtocols();
+  if (std::find(protocols.begin(), protocols.end(), protocol) == protocols.end()) {
+    ReplyError(call, "UNSUPPORTED_PROTOCOL", "Protocol '" + protocol + "' is not supported by sing-box");
+    return;
+  }
+  RunOnExecutor(TaskExecutor::Lane::Parallel, "", "validateConfiguration", call,
+                [this, config_json = GenerateConfigJson(config)](const CancellationToken&,
+                                                                 FlMethodCall* call) {
+    if (!manager_.ValidateConfiguration(config_json)) {
+      ReplyError(call, "INVALID_SINGBOX_CONFIG",
+                 "Configuration validation failed: not a valid sing-box JSON object");
+      return;
+    }
+    ReplySuccess(call, fl_value_new_bool(true));
+  });
+}
+
+void VpnPlugin::SaveConfiguration(FlMethodCall* call, FlValue* config, bool must_exist) {
+  std::string id = LookupString(config, "id");
+  if (id.empty()) {
+    ReplyError(call, "INVALID_CONFIG", "Configuration ID is required");
+    return;
+  }
+  std::string existing;
+  if (must_exist && !LoadSecureData(kConfigPrefix + id, &existing)) {
+    ReplyError(call, "CONFIG_NOT_FOUND", "Configuration not found for update");
+    return;
+  }
+  // Stored in the channel's own encoding, so loading returns the same map
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  g_autoptr(GError) error = nullptr;
+  g_autoptr(GBytes) bytes = fl_message_codec_encode_message(FL_MESSAGE_CODEC(codec), config, &error);
+  gsize size = 0;
+  const void* data = bytes ? g_bytes_get_data(bytes, &size) : nullptr;
+  if (!data || !SaveSecureData(kConfigPrefix + id, data, size)) {
+    ReplyError(call, "STORAGE_FAILED",
+               must_exist ? "Failed to update configuration securely" : "Failed to save configuration securely");
+    return;
+  }
+  ReplySuccess(call, must_exist ? fl_value_new_bool(true) : fl_value_new_null());
+}
+
+void VpnPlugin::LoadConfigurations(FlMethodCall* call) {
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  FlValue* list = fl_value_new_list();
+  for (const std::string& key : ListSecureKeys()) {
+    std::string data;
+    if (key.rfind(kConfigPrefix, 0) != 0 || !LoadSecureData(key, &data)) {
+      continue;
+    }
+    g_autoptr(GBytes) bytes = g_bytes_new(data.data(), data.size());
+    FlValue* config = fl_message_codec_decode_message(FL_MESSAGE_CODEC(codec), bytes, nullptr);
+    if (config) {
+      fl_value_append_take(list, config);
+    }
+  }
+  ReplySuccess(call, list);
+}
+
+void VpnPlugin::DeleteAllConfigurations(FlMethodCall* call) {
+  int64_t deleted = 0;
+  for (const std::string& key : ListSecureKeys()) {
+    if (key.rfind(kConfigPrefix, 0) == 0 && DeleteSecureData(key)) {
+      deleted++;
+    }
+  }
+  ReplySuccess(call, fl_value_new_int(deleted));
+}
+
+void VpnPlugin::IsSecureStorageAvailable(FlMethodCall* call) {
+  std::string key = "test_availability_" + std::to_string(NowMs());
+  static const char kProbe[] = "test";
+  std::string read;
+  bool available = SaveSecureData(key, kProbe, sizeof(kProbe) - 1) && LoadSecureData(key, &read) &&
+                   read == kProbe;
+  DeleteSecureData(key);
+  ReplySuccess(call, fl_value_new_bool(available));
+}
+
+void VpnPlugin::GetStorageInfo(FlMethodCall* call) {
+  int64_t configurations = 0;
+  int64_t used = 0;
+  for (const std::string& key : ListSecureKeys()) {
+    struct stat st;
+    if (stat(SecurePath(key).c_str(), &st) == 0) {
+      used += st.st_size;
+    }
+    configurations += key.rfind(kConfigPrefix, 0) == 0;
+  }
+  FlValue* info = fl_value_new_map();
+  fl_value_set_string_take(info, "configurationCount", fl_value_new_int(configurations));
+  fl_value_set_string_take(info, "storageUsedBytes", fl_value_new_int(used));
+  // Owner-only files, not a keyring
+  fl_value_set_string_take(info, "isEncrypted", fl_value_new_bool(false));
+  fl_value_set_string_take(info, "storageLocation", fl_value_new_string(secure_dir_.c_str()));
+  fl_value_set_string_take(info, "lastBackupTime", fl_value_new_null());
+  ReplySuccess(call, info);
+}
+
+void VpnPlugin::OnConnectionChanged() {
+  UpdateStatsTimer();
+  SendStatus();
+}
+
+void VpnPlugin::OnNetworkChanged(NetworkState state, const std::string& reason) {
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "networkState",
+                           fl_value_new_string(NetworkChangeDetector::StateName(state)));
+  fl_value_set_string_take(event, "reason", fl_value_new_string(reason.c_str()));
+  fl_method_channel_invoke_method(channel_, "onNetworkStateChanged", event, nullptr, nullptr, nullptr);
+
+  // sing-box follows interface changes itself (auto_detect_interface); it
+  // only needs help when the change took it down
+  if (is_connected_ && state == NetworkState::Connected && !manager_.IsRunning()) {
+    ScheduleReconnection(reason);
+  }
+}
+
+void VpnPlugin::ScheduleReconnection(const std::string& reason) {
+  std::string config_json;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_json = last_config_json_;
+  }
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  // The settle delay is a reactor timer rather than a serial task sleeping
+  // through it; a newer change pushes it back
+  reactor_.CancelTimer(reconnect_timer_);
+  reconnect_timer_ = reactor_.AddTimer(kReconnectSettle, [this, weak, config_json, reason]() {
+    executor_->Submit(TaskExecutor::Lane::Serial, kReconnectKey,
+                      [this, weak, config_json, reason](const CancellationToken& token) {
+      if (token.IsCancelled() || !is_connected_ || manager_.IsRunning()) {
+        return;
+      }
+      g_message("VpnPlugin: restarting sing-box after %s", reason.c_str());
+      if (manager_.Start(config_json)) {
+        WatchCore();
+      } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = manager_.GetLastErrorMessage();
+      }
+      RunOnMainThread([weak]() {
+        if (auto self = weak.lock()) {
+          (*self)->SendStatus();
+        }
+      });
+    });
+  });
+}
+
+void VpnPlugin::WatchCore() {
+  UnwatchCore();
+  pid_t pid = manager_.GetProcessId();
+  if (pid <= 0) {
+    return;
+  }
+  watched_pid_ = pid;
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  reactor_.Call([this, weak, pid]() {
+    exit_watch_fd_ = reactor_.WatchProcessExit(pid, [this, weak, pid]() {
+      if (weak.lock()) {
+        OnCoreExited(pid);
+      }
+    });
+    if (exit_watch_fd_ < 0) {
+      g_warning("VpnPlugin: cannot watch sing-box (pid %d); a crash will go unnoticed", pid);
+    }
+  });
+}
+
+void VpnPlugin::UnwatchCore() {
+  watched_pid_ = 0;
+  // On the reactor thread, so a watch that just fired is not removed twice
+  reactor_.Call([this]() {
+    if (exit_watch_fd_ >= 0) {
+      reactor_.RemoveFd(exit_watch_fd_);
+      exit_watch_fd_ = -1;
+    }
+  });
+}
+
+void VpnPlugin::OnCoreExited(pid_t pid) {
+  exit_watch_fd_ = -1;
+  pid_t expected = pid;
+  if (!watched_pid_.compare_exchange_strong(expected, 0) || !is_connected_) {
+    return;
+  }
+  g_warning("VpnPlugin: sing-box (pid %d) exited unexpectedly", pid);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_server_.clear();
+    last_error_ = "sing-box exited unexpectedly; the native log in the work directory has its output";
+  }
+  // A pending reconnection sees the flag and does nothing
+  is_connected_ = false;
+  std::weak_ptr<VpnPlugin*> weak = self_;
+  // Reap the child and stop following the network, in order with the
+  // lifecycle calls on the serial lane
+  executor_->Submit(TaskExecutor::Lane::Serial, "", [this](const CancellationToken&) {
+    detector_.StopMonitoring();
+    manager_.Stop();
+  });
+  RunOnMainThread([weak]() {
+    if (auto self = weak.lock()) {
+      (*self)->OnConnectionChanged();
+    }
+  });
+}
+
+FlMethodErrorResponse* VpnPlugin::OnStatsListen(FlValue* args) {
+  int64_t window = LookupInt(args, "window", StatsFlow::kDefaultWindow);
+  StatsFlow::Policy policy =
+      LookupString(args, "policy") == "drop" ? StatsFlow::Policy::Drop : StatsFlow::Policy::Coalesce;
+  stats_flow_.Reset(static_cast<uint32_t>(std::max<int64_t>(1, std::min<int64_t>(window, StatsFlow::kMaxWindow))),
+                    policy);
+  stats_listener_active_ = true;
+  UpdateStatsTimer();
+  return nullptr;
+}
+
+void VpnPlugin::OnStatsCancel() {
+  stats_listener_active_ = false;
+  UpdateStatsTimer();
+}
+
+void VpnPlugin::EmitStatsEvent(const NetworkStats& stats, uint64_t skipped) {
+  if (!stats_listener_active_) {
+    return;
+  }
+  g_autoptr(FlValue) event = CreateStatsMap(stats);
+  fl_value_set_string_take(event, "seq", fl_value_new_int(static_cast<int64_t>(++stats_event_seq_)));
+  fl_value_set_string_take(event, "skipped", fl_value_new_int(static_cast<int64_t>(skipped)));
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(stats_channel_, event, nullptr, &error)) {
+    g_warning("VpnPlugin: stats event: %s", error->message);
+  }
+}
+
+void VpnPlugin::UpdateStatsTimer() {
+  bool wanted = is_connected_ && (stats_listener_active_ || stats_streaming_active_);
+  if (wanted && stats_timer_ == 0) {
+    stats_timer_ = g_timeout_add_seconds(kStatsIntervalSeconds, OnStatsTick, this);
+  } else if (!wanted && stats_timer_ != 0) {
+    g_source_remove(stats_timer_);
+    stats_timer_ = 0;
+  }
+}
+
+gboolean VpnPlugin::OnStatsTick(gpointer user_data) {
+  auto* plugin = static_cast<VpnPlugin*>(user_data);
+  // A read of the core's shared region: cheap enough for the main thread
+  NetworkStats stats = plugin->manager_.GetStatistics();
+  if (plugin->stats_listener_active_) {
+    plugin->stats_flow_.Offer(stats);
+  }
+  if (plugin->stats_streaming_active_) {
+    g_autoptr(FlValue) sample = plugin->CreateStatsMap(stats);
+    fl_method_channel_invoke_method(plugin->channel_, "onStatsUpdate", sample, nullptr, nullptr, nullptr);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+void VpnPlugin::SendStatus() {
+  if (!status_listener_active_) {
+    return;
+  }
+  g_autoptr(FlValue) status = CreateStatusMap();
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(status_channel_, status, nullptr, &error)) {
+    g_warning("VpnPlugin: status event: %s", error->message);
+  }
+}
+
+FlValue* VpnPlugin::CreateStatusMap() {
+  FlValue* status = fl_value_new_map();
+  const char* state = is_connecting_ ? "connecting" : (is_connected_ ? "connected" : "disconnected");
+  fl_value_set_string_take(status, "state", fl_value_new_string(state));
+  fl_value_set_string_take(status, "isConnected", fl_value_new_bool(is_connected_));
+  fl_value_set_string_take(status, "isConnecting", fl_value_new_bool(is_connecting_));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!current_server_.empty()) {
+      fl_value_set_string_take(status, "connectedServer", fl_value_new_string(current_server_.c_str()));
+    }
+    if (is_connected_) {
+      fl_value_set_string_take(status, "connectionStartTime", fl_value_new_int(connection_start_ms_));
+      fl_value_set_string_take(status, "connectionDuration",
+                               fl_value_new_int((NowMs() - connection_start_ms_) / 1000));
+    } else {
+      fl_value_set_string_take(status, "connectionDuration", fl_value_new_int(0));
+    }
+    if (!last_error_.empty()) {
+      fl_value_set_string_take(status, "lastError", fl_value_new_string(last_error_.c_str()));
+    }
+  }
+  if (is_connected_) {
+    fl_value_set_string_take(status, "currentStats", CreateStatsMap(manager_.GetStatistics()));
+  }
+  fl_value_set_string_take(status, "singboxRunning", fl_value_new_bool(manager_.IsRunning()));
+  FlValue* protocols = fl_value_new_list();
+  for (const std::string& protocol : manager_.GetSupportedProtocols()) {
+    fl_value_append_take(protocols, fl_value_new_string(protocol.c_str()));
+  }
+  fl_value_set_string_take(status, "supportedProtocols", protocols);
+  fl_value_set_string_take(status, "timestamp", fl_value_new_int(NowMs()));
+  return status;
+}
+
+FlValue* VpnPlugin::CreateStatsMap(const NetworkStats& stats) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "bytesReceived", fl_value_new_int(stats.bytes_received));
+  fl_value_set_string_take(map, "bytesSent", fl_value_new_int(stats.bytes_sent));
+  fl_value_set_string_take(map, "downloadSpeed", fl_value_new_float(stats.download_speed));
+  fl_value_set_string_take(map, "uploadSpeed", fl_value_new_float(stats.upload_speed));
+  fl_value_set_string_take(map, "packetsReceived", fl_value_new_int(stats.packets_received));
+  fl_value_set_string_take(map, "packetsSent", fl_value_new_int(stats.packets_sent));
+  fl_value_set_string_take(map, "connectionDuration", fl_value_new_int(stats.connection_duration));
+  fl_value_set_string_take(map, "timestamp", fl_value_new_int(stats.timestamp));
+  return map;
+}
+
+FlValue* VpnPlugin::CreateStatsStreamMap() {
+  StatsFlow::Stats flow = stats_flow_.GetStats();
+  FlValue* info = fl_value_new_map();
+  fl_value_set_string_take(info, "listening", fl_value_new_bool(stats_listener_active_));
+  fl_value_set_string_take(info, "policy", fl_value_new_string(
+      stats_flow_.policy() == StatsFlow::Policy::Drop ? "drop" : "coalesce"));
+  fl_value_set_string_take(info, "window", fl_value_new_int(flow.window));
+  fl_value_set_string_take(info, "credits", fl_value_new_int(flow.credits));
+  // Sent and unacknowledged plus the sample held back for a credit
+  fl_value_set_string_take(info, "queueDepth", fl_value_new_int(flow.in_flight + (flow.held ? 1 : 0)));
+  fl_value_set_string_take(info, "offered", fl_value_new_int(static_cast<int64_t>(flow.offered)));
+  fl_value_set_string_take(info, "sent", fl_value_new_int(static_cast<int64_t>(flow.sent)));
+  fl_value_set_string_take(info, "acked", fl_value_new_int(static_cast<int64_t>(flow.acked)));
+  fl_value_set_string_take(info, "coalesced", fl_value_new_int(static_cast<int64_t>(flow.coalesced)));
+  fl_value_set_string_take(info, "dropped", fl_value_new_int(static_cast<int64_t>(flow.dropped)));
+  return info;
+}
+
+FlValue* VpnPlugin::CreateExecutorStatsMap() {
+  FlValue* executor = fl_value_new_map();
+  for (auto lane : {TaskExecutor::Lane::Serial, TaskExecutor::Lane::Parallel}) {
+    TaskExecutor::LaneStats stats = executor_->GetStats(lane);
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "workers", fl_value_new_int(static_cast<int64_t>(stats.workers)));
+    fl_value_set_string_take(map, "queued", fl_value_new_int(static_cast<int64_t>(stats.queued)));
+    fl_value_set_string_take(map, "maxQueued", fl_value_new_int(static_cast<int64_t>(stats.max_queued)));
+    fl_value_set_string_take(map, "running", fl_value_new_int(static_cast<int64_t>(stats.running)));
+    fl_value_set_string_take(map, "submitted", fl_value_new_int(static_cast<int64_t>(stats.submitted)));
+    fl_value_set_string_take(map, "completed", fl_value_new_int(static_cast<int64_t>(stats.completed)));
+    fl_value_set_string_take(map, "failed", fl_value_new_int(static_cast<int64_t>(stats.failed)));
+    fl_value_set_string_take(map, "superseded", fl_value_new_int(static_cast<int64_t>(stats.superseded)));
+    fl_value_set_string_take(map, "cancelled", fl_value_new_int(static_cast<int64_t>(stats.cancelled)));
+    fl_value_set_string_take(map, "rejected", fl_value_new_int(static_cast<int64_t>(stats.rejected)));
+    uint64_t started = stats.completed + stats.failed + stats.running;
+    fl_value_set_string_take(map, "queueWaitAvgMs", fl_value_new_float(
+        started ? static_cast<double>(stats.wait_total_us) / 1000.0 / static_cast<double>(started) : 0.0));
+    fl_value_set_string_take(map, "queueWaitMaxMs",
+                             fl_value_new_float(static_cast<double>(stats.wait_max_us) / 1000.0));
+    fl_value_set_string_take(map, "runMaxMs", fl_value_new_float(static_cast<double>(stats.run_max_us) / 1000.0));
+    fl_value_set_string_take(executor, lane == TaskExecutor::Lane::Serial ? "serial" : "parallel", map);
+  }
+  return executor;
+}
+
+StatusSnapshot::Bytes VpnPlugin::EncodeStatusSection(FlValue* section) {
+  g_autoptr(FlValue) value = section;
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  g_autoptr(GBytes) bytes = fl_message_codec_encode_message(FL_MESSAGE_CODEC(codec), value, nullptr);
+  gsize size = 0;
+  const uint8_t* data = bytes ? static_cast<const uint8_t*>(g_bytes_get_data(bytes, &size)) : nullptr;
+  return data ? StatusSnapshot::Bytes(data, data + size) : StatusSnapshot::Bytes();
+}
+
+void VpnPlugin::RefreshStatusSections() {
+  bool running = manager_.IsRunning();
+  std::string error_message = manager_.GetLastErrorMessage();
+  auto timings = manager_.GetOperationTimings();
+  std::string process = manager_.GetProcessStatsJson();
+  std::string core = manager_.GetDetailedStatsJson();
+  StatusFingerprint singbox_fingerprint;
+  singbox_fingerprint.Add(running).Add(error_message).Add(process).Add(core);
+  for (const auto& timing : timings) {
+    singbox_fingerprint.Add(timing.first).Add(timing.second);
+  }
+  status_snapshot_.Refresh("singboxDetails", singbox_fingerprint.value(), [&]() {
+    FlValue* singbox = fl_value_new_map();
+    fl_value_set_string_take(singbox, "isRunning", fl_value_new_bool(running));
+    fl_value_set_string_take(singbox, "lastErrorMessage", fl_value_new_string(error_message.c_str()));
+    fl_value_set_string_take(singbox, "binary", fl_value_new_string(binary_.c_str()));
+    fl_value_set_string_take(singbox, "workDir", fl_value_new_string(work_dir_.c_str()));
+    FlValue* timings_map = fl_value_new_map();
+    for (const auto& timing : timings) {
+      fl_value_set_string_take(timings_map, timing.first.c_str(), fl_value_new_int(timing.second));
+    }
+    fl_value_set_string_take(singbox, "operationTimings", timings_map);
+    // JSON documents of the core, decoded on the Dart side
+    fl_value_set_string_take(singbox, "process", fl_value_new_string(process.c_str()));
+    fl_value_set_string_take(singbox, "core", fl_value_new_string(core.c_str()));
+    return EncodeStatusSection(singbox);
+  });
+
+  NetworkChangeDetector::Stats network_stats = detector_.GetStats();
+  bool monitoring = detector_.IsMonitoring();
+  NetworkState state = detector_.GetNetworkState();
+  std::string interfaces = detector_.GetActiveInterfaces();
+  StatusFingerprint network_fingerprint;
+  network_fingerprint.Add(monitoring).Add(state).Add(interfaces).Add(network_stats.messages)
+      .Add(network_stats.relevant).Add(network_stats.notifications).Add(network_stats.wakeups);
+  status_snapshot_.Refresh("networkDetails", network_fingerprint.value(), [&]() {
+    FlValue* network = fl_value_new_map();
+    fl_value_set_string_take(network, "monitoring", fl_value_new_bool(monitoring));
+    fl_value_set_string_take(network, "networkState",
+                             fl_value_new_string(NetworkChangeDetector::StateName(state)));
+    fl_value_set_string_take(network, "activeInterfaces", fl_value_new_string(interfaces.c_str()));
+    fl_value_set_string_take(network, "messages", fl_value_new_int(static_cast<int64_t>(network_stats.messages)));
+    fl_value_set_string_take(network, "relevant", fl_value_new_int(static_cast<int64_t>(network_stats.relevant)));
+    fl_value_set_string_take(network, "notifications",
+                             fl_value_new_int(static_cast<int64_t>(network_stats.notifications)));
+    fl_value_set_string_take(network, "wakeups", fl_value_new_int(static_cast<int64_t>(network_stats.wakeups)));
+    return EncodeStatusSection(network);
+  });
+
+  StatsFlow::Stats flow = stats_flow_.GetStats();
+  StatusFingerprint stats_fingerprint;
+  stats_fingerprint.Add(stats_timer_ != 0).Add(stats_streaming_active_).Add(stats_listener_active_)
+      .Add(stats_flow_.policy()).Add(flow.window).Add(flow.credits).Add(flow.in_flight).Add(flow.held)
+      .Add(flow.offered).Add(flow.sent).Add(flow.acked).Add(flow.coalesced).Add(flow.dropped);
+  status_snapshot_.Refresh("statsDetails", stats_fingerprint.value(), [&]() {
+    FlValue* stats = fl_value_new_map();
+    fl_value_set_string_take(stats, "isCollecting", fl_value_new_bool(stats_timer_ != 0));
+    fl_value_set_string_take(stats, "interval", fl_value_new_int(kStatsIntervalSeconds * 1000));
+    fl_value_set_string_take(stats, "streamingActive", fl_value_new_bool(stats_streaming_active_));
+    fl_value_set_string_take(stats, "stream", CreateStatsStreamMap());
+    return EncodeStatusSection(stats);
+  });
+
+  StatusFingerprint executor_fingerprint;
+  for (auto lane : {TaskExecutor::Lane::Serial, TaskExecutor::Lane::Parallel}) {
+    TaskExecutor::LaneStats stats = executor_->GetStats(lane);
+    executor_fingerprint.Add(stats.workers).Add(stats.queued).Add(stats.max_queued).Add(stats.running)
+        .Add(stats.submitted).Add(stats.completed).Add(stats.failed).Add(stats.superseded)
+        .Add(stats.cancelled).Add(stats.rejected);
+  }
+  status_snapshot_.Refresh("executor", executor_fingerprint.value(),
+                           [&]() { return EncodeStatusSection(CreateExecutorStatsMap()); });
+
+  Reactor::Stats reactor_stats = reactor_.GetStats();
+  StatusFingerprint reactor_fingerprint;
+  reactor_fingerprint.Add(reactor_stats.running).Add(reactor_stats.wakeups).Add(reactor_stats.fd_events)
+      .Add(reactor_stats.timers_fired).Add(reactor_stats.posted).Add(reactor_stats.fds).Add(reactor_stats.timers)
+      .Add(reactor_stats.wheel.cascaded);
+  status_snapshot_.Refresh("reactor", reactor_fingerprint.value(), [&]() {
+    FlValue* reactor = fl_value_new_map();
+    fl_value_set_string_take(reactor, "running", fl_value_new_bool(reactor_stats.running));
+    fl_value_set_string_take(reactor, "wakeups", fl_value_new_int(static_cast<int64_t>(reactor_stats.wakeups)));
+    fl_value_set_string_take(reactor, "fdEvents", fl_value_new_int(static_cast<int64_t>(reactor_stats.fd_events)));
+    fl_value_set_string_take(reactor, "timersFired",
+                             fl_value_new_int(static_cast<int64_t>(reactor_stats.timers_fired)));
+    fl_value_set_string_take(reactor, "posted", fl_value_new_int(static_cast<int64_t>(reactor_stats.posted)));
+    fl_value_set_string_take(reactor, "fds", fl_value_new_int(static_cast<int64_t>(reactor_stats.fds)));
+    fl_value_set_string_take(reactor, "timers", fl_value_new_int(static_cast<int64_t>(reactor_stats.timers)));
+    fl_value_set_string_take(reactor, "cascaded",
+                             fl_value_new_int(static_cast<int64_t>(reactor_stats.wheel.cascaded)));
+    return EncodeStatusSection(reactor);
+  });
+}
+
+FlValue* VpnPlugin::CreateStatusSnapshotMap() {
+  StatusSnapshot::Stats stats = status_snapshot_.GetStats();
+  FlValue* snapshot = fl_value_new_map();
+  fl_value_set_string_take(snapshot, "passes", fl_value_new_int(static_cast<int64_t>(stats.passes)));
+  fl_value_set_string_take(snapshot, "fullPasses", fl_value_new_int(static_cast<int64_t>(stats.full_passes)));
+  fl_value_set_string_take(snapshot, "encodes", fl_value_new_int(static_cast<int64_t>(stats.encodes)));
+  fl_value_set_string_take(snapshot, "reused",
+                           fl_value_new_int(static_cast<int64_t>(stats.refreshes - stats.encodes)));
+  fl_value_set_string_take(snapshot, "sectionsSent", fl_value_new_int(static_cast<int64_t>(stats.sections_sent)));
+  fl_value_set_string_take(snapshot, "sectionsSkipped",
+                           fl_value_new_int(static_cast<int64_t>(stats.sections_skipped)));
+  fl_value_set_string_take(snapshot, "bytesEncoded", fl_value_new_int(static_cast<int64_t>(stats.bytes_encoded)));
+  fl_value_set_string_take(snapshot, "bytesSent", fl_value_new_int(static_cast<int64_t>(stats.bytes_sent)));
+  fl_value_set_string_take(snapshot, "bytesSkipped", fl_value_new_int(static_cast<int64_t>(stats.bytes_skipped)));
+  fl_value_set_string_take(snapshot, "lastPassBytes", fl_value_new_int(static_cast<int64_t>(stats.last_pass_bytes)));
+  fl_value_set_string_take(snapshot, "lastPassUs", fl_value_new_int(static_cast<int64_t>(stats.last_pass_us)));
+  fl_value_set_string_take(snapshot, "maxPassUs", fl_value_new_int(static_cast<int64_t>(stats.pass_max_us)));
+  fl_value_set_string_take(snapshot, "avgPassUs", fl_value_new_float(
+      stats.passes ? static_cast<double>(stats.pass_total_us) / static_cast<double>(stats.passes) : 0.0));
+  fl_value_set_string_take(snapshot, "encodeTotalUs",
+                           fl_value_new_int(static_cast<int64_t>(stats.encode_total_us)));
+  return snapshot;
+}
+
+FlValue* VpnPlugin::CreateDetailedStatus(FlValue* args) {
+  // With {"versions": {section: version}} only the sections that changed
+  // since are sent, as standard-codec bytes; without, everything decoded
+  FlValue* versions = Lookup(args, "versions");
+  bool incremental = versions && fl_value_get_type(versions) == FL_VALUE_TYPE_MAP;
+  StatusSnapshot::Versions known;
+  for (size_t i = 0; incremental && i < fl_value_get_length(versions); i++) {
+    FlValue* name = fl_value_get_map_key(versions, i);
+    FlValue* version = fl_value_get_map_value(versions, i);
+    if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING && fl_value_get_type(version) == FL_VALUE_TYPE_INT) {
+      known[fl_value_get_string(name)] = static_cast<uint64_t>(fl_value_get_int(version));
+    }
+  }
+
+  status_snapshot_.BeginPass();
+  FlValue* detailed = CreateStatusMap();
+  RefreshStatusSections();
+  auto changed = status_snapshot_.EndPass(incremental ? &known : nullptr);
+
+  if (incremental) {
+    FlValue* sections = fl_value_new_map();
+    for (const auto& entry : changed) {
+      const StatusSnapshot::Bytes& bytes = *entry.second.encoded;
+      fl_value_set_string_take(sections, entry.first.c_str(), fl_value_new_uint8_list(bytes.data(), bytes.size()));
+    }
+    FlValue* section_versions = fl_value_new_map();
+    for (const auto& version : status_snapshot_.GetVersions()) {
+      fl_value_set_string_take(section_versions, version.first.c_str(),
+                               fl_value_new_int(static_cast<int64_t>(version.second)));
+    }
+    fl_value_set_string_take(detailed, "sections", sections);
+    fl_value_set_string_take(detailed, "sectionVersions", section_versions);
+  } else {
+    g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+    for (const auto& entry : changed) {
+      const StatusSnapshot::Bytes& encoded = *entry.second.encoded;
+      g_autoptr(GBytes) bytes = g_bytes_new(encoded.data(), encoded.size());
+      FlValue* section = fl_message_codec_decode_message(FL_MESSAGE_CODEC(codec), bytes, nullptr);
+      if (section) {
+        fl_value_set_string_take(detailed, entry.first.c_str(), section);
+      }
+    }
+  }
+  fl_value_set_string_take(detailed, "snapshot", CreateStatusSnapshotMap());
+  return detailed;
+}
+
+std::string VpnPlugin::GenerateConfigJson(FlValue* config) {
+  std::string json;
+  FlValue* singbox = Lookup(config, "singboxConfig");
+  if (singbox && fl_value_get_type(singbox) == FL_VALUE_TYPE_MAP) {
+    AppendJson(json, singbox);
+    return json;
+  }
+
+  // Without one from Dart, the template of the Windows plugin
+  FlValue* fields = Lookup(config, "config");
+  fields = fields ? fields : config;
+  std::string protocol;
+  std::string server;
+  AppendJsonString(protocol, LookupString(fields, "protocol").c_str());
+  AppendJsonString(server, LookupString(fields, "serverAddress").c_str());
+  json = "{\"log\":{\"level\":\"info\"},"
+         "\"inbounds\":[{\"type\":\"tun\",\"tag\":\"tun-in\",\"interface_name\":\"" +
+         std::string(kTunInterface) +
+         "\",\"inet4_address\":\"172.19.0.1/30\",\"auto_route\":true,\"strict_route\":false,"
+         "\"sniff\":true}],"
+         "\"outbounds\":[{\"type\":" + protocol + ",\"tag\":\"proxy\",\"server\":" + server +
+         ",\"server_port\":" + std::to_string(LookupInt(fields, "serverPort", 0)) +
+         "},{\"type\":\"direct\",\"tag\":\"direct\"}],"
+         "\"route\":{\"auto_detect_interface\":true,"
+         "\"rules\":[{\"outbound\":\"direct\",\"domain\":[\"localhost\"]}],\"final\":\"proxy\"}}";
+  return json;
+}
+
+std::string VpnPlugin::SecurePath(const std::string& key) const {
+  return secure_dir_ + "/" + HexEncode(key);
+}
+
+bool VpnPlugin::SaveSecureData(const std::string& key, const void* data, size_t length) {
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  return WriteFileAtomically(SecurePath(key), data, length);
+}
+
+bool VpnPlugin::LoadSecureData(const std::string& key, std::string* data) const {
+  gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(SecurePath(key).c_str(), &contents, &length, nullptr)) {
+    return false;
+  }
+  data->assign(contents, length);
+  g_free(contents);
+  return true;
+}
+
+bool VpnPlugin::DeleteSecureData(const std::string& key) {
+  std::lock_guard<std::mutex> lock(storage_mutex_);
+  return unlink(SecurePath(key).c_str()) == 0;
+}
+
+std::vector<std::string> VpnPlugin::ListSecureKeys() const {
+  std::vector<std::string> keys;
+  DIR* dir = opendir(secure_dir_.c_str());
+  if (!dir) {
+    return keys;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    std::string key;
+    // Skips ".", ".." and leftover temporary files
+    if (HexDecode(entry->d_name, &key) && !key.empty()) {
+      keys.push_back(key);
+    }
+  }
+  closedir(dir);
+  return keys;
+}
+
+void vpn_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
+  auto* plugin = new VpnPlugin(registrar);
+  // Destroyed with the view, on the main thread
+  FlView* view = fl_plugin_registrar_get_view(registrar);
+  GObject* owner = view ? G_OBJECT(view) : G_OBJECT(fl_plugin_registrar_get_messenger(registrar));
+  g_object_set_data_full(owner, "tunnel_max-vpn-plugin", plugin,
+                         [](gpointer data) { delete static_cast<VpnPlugin*>(data); });
+}
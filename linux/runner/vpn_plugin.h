@@ -0,0 +1,12 @@
+#ifndef RUNNER_VPN_PLUGIN_H_
+#define RUNNER_VPN_PLUGIN_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+// Registers the VPN plugin with the Flutter engine: the "vpn_control"
+// method channel and the "vpn_status" and "vpn_stats" event channels, with
+// the method names of the Windows plugin so the same Dart classes drive
+// both. The plugin lives as long as the registrar's view.
+void vpn_plugin_register_with_registrar(FlPluginRegistrar* registrar);
+
+#endif  // RUNNER_VPN_PLUGIN_H_
@@ -0,0 +1,123 @@
+#ifndef CREDIT_FLOW_H_
+#define CREDIT_FLOW_H_
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// Credit-based flow control for an event stream to Dart.
+//
+// The listener starts with `window` credits. Every event sent takes one,
+// and the listener returns them with Ack() once it has processed events.
+// Samples offered without a credit are not queued:
+//  - Coalesce keeps only the newest one and sends it as soon as a credit
+//    comes back, so the listener catches up on the latest value at once;
+//  - Drop discards it, and the next sample offered after an ack goes out.
+// Either way at most `window` events are in flight and at most one is held,
+// however slow the listener is.
+//
+// Free of platform types so the host build can test it. Not thread safe;
+// the Windows plugin drives it from the platform thread only.
+template <typename Payload>
+class CreditFlow {
+public:
+    enum class Policy { Coalesce, Drop };
+
+    struct Stats {
+        uint32_t window = 0;
+        uint32_t credits = 0;
+        uint32_t in_flight = 0;     // Sent and not yet acknowledged
+        bool held = false;          // A coalesced sample waits for a credit
+        uint64_t offered = 0;
+        uint64_t sent = 0;
+        uint64_t acked = 0;
+        uint64_t coalesced = 0;     // Replaced while waiting for a credit
+        uint64_t dropped = 0;       // Discarded under Policy::Drop
+    };
+
+    // `skipped` is how many samples were coalesced or dropped since the
+    // previous event, so the listener can tell it fell behind
+    using EmitFn = std::function<void(const Payload& sample, uint64_t skipped)>;
+
+    static constexpr uint32_t kDefaultWindow = 4;
+    static constexpr uint32_t kMaxWindow = 64;
+
+    explicit CreditFlow(EmitFn emit, uint32_t window = kDefaultWindow, Policy policy = Policy::Coalesce)
+        : emit_(std::move(emit)) {
+        Reset(window, policy);
+    }
+
+    // Start over for a new listener: full credits, nothing held, counters kept
+    void Reset(uint32_t window, Policy policy) {
+        window_ = window == 0 ? 1 : (window > kMaxWindow ? kMaxWindow : window);
+        credits_ = window_;
+        policy_ = policy;
+        held_ = false;
+        skipped_ = 0;
+    }
+
+    void Offer(Payload sample) {
+        stats_.offered++;
+        if (credits_ > 0) {
+            Send(sample);
+            return;
+        }
+        skipped_++;
+        if (policy_ == Policy::Drop) {
+            stats_.dropped++;
+            return;
+        }
+        if (held_) {
+            stats_.coalesced++;
+        }
+        held_sample_ = std::move(sample);
+        held_ = true;
+    }
+
+    // The listener processed `count` events; acks beyond those in flight are ignored
+    void Ack(uint32_t count) {
+        uint32_t in_flight = window_ - credits_;
+        count = count < in_flight ? count : in_flight;
+        credits_ += count;
+        stats_.acked += count;
+        if (held_ && credits_ > 0) {
+            held_ = false;
+            // Counted as skipped when it came in, but it goes out after all
+            skipped_--;
+            Send(held_sample_);
+        }
+    }
+
+    Policy policy() const { return policy_; }
+
+    Stats GetStats() const {
+        Stats stats = stats_;
+        stats.window = window_;
+        stats.credits = credits_;
+        stats.in_flight = window_ - credits_;
+        stats.held = held_;
+        return stats;
+    }
+
+private:
+    void Send(const Payload& sample) {
+        credits_--;
+        stats_.sent++;
+        uint64_t skipped = skipped_;
+        skipped_ = 0;
+        if (emit_) {
+            emit_(sample, skipped);
+        }
+    }
+
+    EmitFn emit_;
+    uint32_t window_ = kDefaultWindow;
+    uint32_t credits_ = kDefaultWindow;
+    Policy policy_ = Policy::Coalesce;
+    bool held_ = false;
+    Payload held_sample_{};
+    uint64_t skipped_ = 0;
+    Stats stats_;
+};
+
+#endif // CREDIT_FLOW_H_
@@ -0,0 +1,249 @@
+#include "ErrorCategorizer.h"
+#include <cstring>
+#include <stdexcept>
+
+#include "sing_box_errcat.h"
+
+namespace {
+
+constexpr size_t kMaxStates = 65535;
+
+static_assert(static_cast<int>(ErrorCategory::Crash) == SINGBOX_ERRCAT_CRASH, "categories must match the C stage");
+static_assert(static_cast<int>(ErrorSeverity::Critical) == SINGBOX_ERRSEV_CRITICAL, "severities must match the C stage");
+static_assert(static_cast<int>(ErrorScope::Startup) == SINGBOX_ERRSCOPE_STARTUP, "scopes must match the C stage");
+
+constexpr uint8_t kContextConnection = 1;
+constexpr uint8_t kContextStartup = 2;
+
+uint8_t ScopeContext(ErrorScope scope) {
+    return scope == ErrorScope::Connection ? kContextConnection
+         : scope == ErrorScope::Startup ? kContextStartup : 0;
+}
+
+#define SINGBOX_ERROR_SIGNATURE(pattern, category, severity, recoverable, priority, scope) \
+    {pattern, static_cast<ErrorCategory>(SINGBOX_ERRCAT_##category),                     \
+     static_cast<ErrorSeverity>(SINGBOX_ERRSEV_##severity), (recoverable) != 0, priority, \
+     static_cast<ErrorScope>(SINGBOX_ERRSCOPE_##scope)},
+
+const std::vector<ErrorSignature> kBuiltinSignatures = {
+#include "sing_box_errcat_signatures.inc"
+};
+
+#undef SINGBOX_ERROR_SIGNATURE
+
+}  // namespace
+
+ErrorCategorizer::ErrorCategorizer(const std::vector<ErrorSignature>& signatures)
+    : signatures_(signatures)
+    , alphabet_(1)
+    , state_count_(1)
+{
+    if (signatures_.empty() || signatures_.size() > INT16_MAX) {
+        throw std::invalid_argument("Signature table must hold 1-32767 entries");
+    }
+
+    size_t max_states = 1;
+    rank_.reserve(signatures_.size());
+    for (const auto& signature : signatures_) {
+        size_t length = std::strlen(signature.pattern);
+        max_states += length;
+        rank_.push_back((static_cast<uint32_t>(signature.priority) << 16) |
+                        static_cast<uint32_t>(length > 0xffff ? 0xffff : length));
+
+        for (const char* p = signature.pattern; *p; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (c >= 'A' && c <= 'Z') {
+                throw std::invalid_argument(std::string("Signature is not lowercase: ") + signature.pattern);
+            }
+            if (!byte_class_[c]) {
+                if (alphabet_ == 256) {
+                    throw std::invalid_argument("Signature alphabet too large");
+                }
+                byte_class_[c] = static_cast<uint8_t>(alphabet_++);
+            }
+        }
+    }
+    if (max_states > kMaxStates) {
+        throw std::invalid_argument("Signature table too large");
+    }
+    for (int c = 'a'; c <= 'z'; ++c) {
+        byte_class_[c - 'a' + 'A'] = byte_class_[c];
+    }
+
+    next_.assign(max_states * alphabet_, 0);
+    output_.assign(max_states, -1);
+    local_output_.assign(max_states, -1);
+    context_.assign(max_states, 0);
+    BuildTrie();
+    BuildFailureLinks();
+    next_.resize(state_count_ * alphabet_);
+    output_.resize(state_count_);
+    local_output_.resize(state_count_);
+    context_.resize(state_count_);
+}
+
+const ErrorCategorizer& ErrorCategorizer::Default() {
+    static const ErrorCategorizer instance(kBuiltinSignatures);
+    return instance;
+}
+
+const std::vector<ErrorSignature>& ErrorCategorizer::BuiltinSignatures() {
+    return kBuiltinSignatures;
+}
+
+bool ErrorCategorizer::Better(int candidate, int current) const {
+    return current < 0 || rank_[candidate] > rank_[current];
+}
+
+void ErrorCategorizer::BuildTrie() {
+    for (size_t i = 0; i < signatures_.size(); ++i) {
+        size_t state = 0;
+        for (const char* p = signatures_[i].pattern; *p; ++p) {
+            size_t slot = state * alphabet_ + byte_class_[static_cast<unsigned char>(*p)];
+            if (!next_[slot]) {
+                next_[slot] = static_cast<uint16_t>(state_count_++);
+            }
+            state = next_[slot];
+        }
+        if (state == 0) {
+            continue;
+        }
+        if (Better(static_cast<int>(i), output_[state])) {
+            output_[state] = static_cast<int16_t>(i);
+        }
+        if (signatures_[i].scope != ErrorScope::Global && Better(static_cast<int>(i), local_output_[state])) {
+            local_output_[state] = static_cast<int16_t>(i);
+        }
+        context_[state] |= ScopeContext(signatures_[i].scope);
+    }
+}
+
+// Breadth-first pass that turns the trie into a complete DFA
+void ErrorCategorizer::BuildFailureLinks() {
+    std::vector<uint16_t> fail(state_count_, 0);
+    std::vector<uint16_t> queue;
+    queue.reserve(state_count_);
+    queue.push_back(0);
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        size_t state = queue[head];
+        uint16_t* row = &next_[state * alphabet_];
+        const uint16_t* fail_row = &next_[static_cast<size_t>(fail[state]) * alphabet_];
+
+        for (size_t c = 0; c < alphabet_; ++c) {
+            if (row[c]) {
+                uint16_t child = row[c];
+                fail[child] = state == 0 ? 0 : fail_row[c];
+                int inherited = output_[fail[child]];
+                if (inherited >= 0 && Better(inherited, output_[child])) {
+                    output_[child] = static_cast<int16_t>(inherited);
+                }
+                inherited = local_output_[fail[child]];
+                if (inherited >= 0 && Better(inherited, local_output_[child])) {
+                    local_output_[child] = static_cast<int16_t>(inherited);
+                }
+                context_[child] |= context_[fail[child]];
+                queue.push_back(child);
+            } else {
+                row[c] = state == 0 ? 0 : fail_row[c];
+            }
+        }
+    }
+}
+
+ErrorClassification ErrorCategorizer::Classify(const char* text, size_t length) const {
+    ErrorClassification result;
+    if (!text) {
+        return result;
+    }
+
+    int best = -1;
+    int best_local = -1;
+    uint8_t context = 0;
+    size_t state = 0;
+    for (size_t i = 0; i < length; ++i) {
+        state = next_[state * alphabet_ + byte_class_[static_cast<unsigned char>(text[i])]];
+        int found = output_[state];
+        if (found >= 0) {
+            ++result.matches;
+            if (Better(found, best)) {
+                best = found;
+            }
+            int local = local_output_[state];
+            if (local >= 0 && Better(local, best_local)) {
+                best_local = local;
+            }
+            context |= context_[state];
+        }
+    }
+    if (context == kContextConnection) {
+        // About one connection, not the tunnel: Global signatures do not apply
+        best = best_local;
+    }
+
+    if (best >= 0) {
+        const ErrorSignature& signature = signatures_[best];
+        result.category = signature.category;
+        result.severity = signature.severity;
+        result.recoverable = signature.recoverable;
+        result.signature = best;
+    }
+    return result;
+}
+
+ErrorClassification ErrorCategorizer::Classify(const std::string& text) const {
+    return Classify(text.data(), text.size());
+}
+
+const char* ErrorCategorizer::Pattern(int signature) const {
+    if (signature < 0 || static_cast<size_t>(signature) >= signatures_.size()) {
+        return nullptr;
+    }
+    return signatures_[signature].pattern;
+}
+
+const char* ErrorCategorizer::CategoryName(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::Initialization: return "initialization";
+        case ErrorCategory::Configuration: return "configuration";
+        case ErrorCategory::Network: return "network";
+        case ErrorCategory::Timeout: return "timeout";
+        case ErrorCategory::Authentication: return "authentication";
+        case ErrorCategory::Protocol: return "protocol";
+        case ErrorCategory::Tun: return "tun";
+        case ErrorCategory::Permission: return "permission";
+        case ErrorCategory::Library: return "library";
+        case ErrorCategory::Resource: return "resource";
+        case ErrorCategory::Crash: return "crash";
+        case ErrorCategory::Unknown:
+        default: return "unknown";
+    }
+}
+
+const char* ErrorCategorizer::CategoryCode(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::Initialization: return "INIT_FAILED";
+        case ErrorCategory::Configuration: return "CONFIG_INVALID";
+        case ErrorCategory::Network: return "CONNECTION_FAILED";
+        case ErrorCategory::Timeout: return "TIMEOUT";
+        case ErrorCategory::Authentication: return "AUTH_FAILED";
+        case ErrorCategory::Protocol: return "PROTOCOL_ERROR";
+        case ErrorCategory::Tun: return "TUN_SETUP_FAILED";
+        case ErrorCategory::Permission: return "PERMISSION_DENIED";
+        case ErrorCategory::Library: return "LIBRARY_NOT_FOUND";
+        case ErrorCategory::Resource: return "RESOURCE_EXHAUSTED";
+        case ErrorCategory::Crash: return "PROCESS_CRASHED";
+        case ErrorCategory::Unknown:
+        default: return "UNKNOWN";
+    }
+}
+
+const char* ErrorCategorizer::SeverityName(ErrorSeverity severity) {
+    switch (severity) {
+        case ErrorSeverity::Info: return "info";
+        case ErrorSeverity::Warning: return "warning";
+        case ErrorSeverity::Critical: return "critical";
+        case ErrorSeverity::Error:
+        default: return "error";
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef ERROR_CATEGORIZER_H_
+#define ERROR_CATEGORIZER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Error categories; CategoryCode() yields the native error codes understood by
+// SingboxErrorFactory.fromNativeError on the Dart side
+enum class ErrorCategory {
+    Unknown,
+    Initialization,
+    Configuration,
+    Network,
+    Timeout,
+    Authentication,
+    Protocol,
+    Tun,
+    Permission,
+    Library,
+    Resource,
+    Crash
+};
+
+enum class ErrorSeverity {
+    Info,
+    Warning,
+    Error,
+    Critical
+};
+
+// Where a signature applies; see singbox_error_scope_t
+enum class ErrorScope {
+    Any,
+    Global,         // Ignored on per-connection lines
+    Connection,     // Marks the line as per-connection
+    Startup         // Marks the line as startup, which wins over Connection
+};
+
+struct ErrorSignature {
+    const char* pattern;        // Lowercase
+    ErrorCategory category;
+    ErrorSeverity severity;
+    bool recoverable;
+    uint8_t priority;           // Higher wins when several signatures match
+    ErrorScope scope = ErrorScope::Any;
+};
+
+struct ErrorClassification {
+    ErrorCategory category = ErrorCategory::Unknown;
+    ErrorSeverity severity = ErrorSeverity::Error;
+    bool recoverable = false;
+    int signature = -1;         // Index of the winning signature, -1 if none
+    uint32_t matches = 0;       // Positions where at least one signature ended
+
+    bool IsMatched() const { return signature >= 0; }
+};
+
+// Classifies sing-box error lines against all known signatures in one pass.
+//
+// The signatures are compiled into a single Aho-Corasick automaton with the
+// failure links folded into a dense transition table, so classification costs
+// one table lookup per input byte regardless of the number of signatures.
+// Matching is ASCII case-insensitive; when several signatures occur in a line
+// the highest priority (then the longest pattern) wins. Lines about a single
+// connection leave out Global signatures, so they never read as a tun or
+// privilege failure of the whole tunnel.
+//
+// The built-in table is sing_box_errcat_signatures.inc, shared with
+// android/app/src/main/cpp/sing_box_errcat.c, which carries the throughput
+// benchmark; error_categorizer_test holds the two classifiers identical.
+class ErrorCategorizer {
+public:
+    // Throws std::invalid_argument for an empty, non-lowercase or oversized table
+    explicit ErrorCategorizer(const std::vector<ErrorSignature>& signatures);
+
+    // Shared instance built from the built-in signature table
+    static const ErrorCategorizer& Default();
+    static const std::vector<ErrorSignature>& BuiltinSignatures();
+
+    ErrorClassification Classify(const char* text, size_t length) const;
+    ErrorClassification Classify(const std::string& text) const;
+
+    const char* Pattern(int signature) const;
+    size_t StateCount() const { return state_count_; }
+
+    static const char* CategoryName(ErrorCategory category);
+    static const char* CategoryCode(ErrorCategory category);
+    static const char* SeverityName(ErrorSeverity severity);
+
+private:
+    bool Better(int candidate, int current) const;
+    void BuildTrie();
+    void BuildFailureLinks();
+
+    std::vector<ErrorSignature> signatures_;
+    std::vector<uint32_t> rank_;
+    std::array<uint8_t, 256> byte_class_{};
+    size_t alphabet_;
+    size_t state_count_;
+    std::vector<uint16_t> next_;    // state_count_ * alphabet_
+    std::vector<int16_t> output_;   // Best signature ending in each state
+    std::vector<int16_t> local_output_;  // Same, leaving out Global signatures
+    std::vector<uint8_t> context_;  // kContext* bits of the signatures ending in each state
+};
+
+#endif // ERROR_CATEGORIZER_H_
@@ -0,0 +1,358 @@
+#ifndef EVENT_BUS_H_
+#define EVENT_BUS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Of every EventBus, whatever its event type
+struct EventBusStats {
+    bool running = false;
+    size_t subscribers = 0;
+    uint64_t published = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;           // Published while stopped
+    uint64_t handler_failures = 0;  // Handlers that threw
+    uint64_t max_depth = 0;         // Most events queued at once
+    uint64_t sleeps = 0;            // Times the delivery thread went idle
+    uint64_t publisher_wakes = 0;   // Publishes that took the mutex to wake it
+    uint64_t latency_total_us = 0;  // From Publish() to the handlers
+    uint64_t latency_max_us = 0;
+    uint64_t handler_max_us = 0;    // Longest delivery of one event
+};
+
+// Errors and state changes of a component, handed to its subscribers on a
+// thread of the bus rather than run on the thread that raised them.
+//
+// Publish() never runs a handler and takes no lock of the bus: the event
+// goes on an intrusive multi-producer single-consumer queue with one atomic
+// exchange. Only a publish that finds the delivery thread asleep takes the
+// bus's mutex, to wake it. A component can publish while holding its own
+// locks, and readers of those locks never wait behind a subscriber.
+//
+// The delivery thread starts with the first Subscribe() and runs the
+// handlers one event at a time, in queue order. Handlers may publish,
+// subscribe and unsubscribe. Stop() delivers what is queued and ends the
+// thread; events published while it is stopped are dropped, as no one
+// would hear them.
+//
+// Free of platform types so the host build can test it. Thread safe.
+template <typename Event>
+class EventBus {
+public:
+    using Handler = std::function<void(const Event&)>;
+    using SubscriptionId = uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    using Stats = EventBusStats;
+
+    EventBus() : back_(&stub_), front_(&stub_), subscribers_(std::make_shared<Subscribers>()) {}
+
+    ~EventBus() {
+        Stop();
+        // Published after the thread drained the queue
+        while (Entry* entry = Pop()) {
+            delete entry;
+        }
+    }
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    SubscriptionId Subscribe(Handler handler) {
+        SubscriptionId id;
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
+            auto subscribers = std::make_shared<Subscribers>(*subscribers_);
+            id = ++next_id_;
+            subscribers->push_back(Subscriber{id, std::move(handler)});
+            subscribers_ = std::move(subscribers);
+        }
+        Start();
+        return id;
+    }
+
+    // Resume delivery after Stop(); Subscribe() starts it too
+    void Start() {
+        std::thread previous;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_ || InDeliveryThread()) {
+                return;
+            }
+            previous = std::move(thread_);
+        }
+        // A thread asked to stop from its own handler
+        if (previous.joinable()) {
+            previous.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        stopping_ = false;
+        loop_alive_ = true;
+        thread_ = std::thread(&EventBus::Loop, this);
+    }
+
+    // Once this returns the handler does not run again; called from a
+    // handler, the delivery in progress still completes
+    void Unsubscribe(SubscriptionId id) {
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
+            auto subscribers = std::make_shared<Subscribers>();
+            for (const Subscriber& subscriber : *subscribers_) {
+                if (subscriber.id != id) {
+                    subscribers->push_back(subscriber);
+                }
+            }
+            subscribers_ = std::move(subscribers);
+        }
+        if (!InDeliveryThread()) {
+            std::lock_guard<std::mutex> lock(delivery_mutex_);
+        }
+    }
+
+    void Publish(Event event) {
+        if (!running_.load()) {
+            dropped_++;
+            return;
+        }
+        auto* entry = new Entry(std::move(event));
+        published_++;
+        UpdateMax(max_depth_, static_cast<uint64_t>(pending_.fetch_add(1) + 1));
+        Push(entry);
+        // The first publish to find the thread asleep wakes it; the rest
+        // are counted in pending_ and seen once it is up
+        if (sleeping_.load() && sleeping_.exchange(false)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            publisher_wakes_++;
+            wake_cv_.notify_one();
+        }
+    }
+
+    // Wait until the events published so far reached the handlers; returns
+    // at once on the delivery thread
+    void Flush() {
+        if (InDeliveryThread()) {
+            return;
+        }
+        uint64_t target = published_.load();
+        flush_waiters_++;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            flushed_cv_.wait(lock, [this, target]() { return delivered_.load() >= target || !loop_alive_; });
+        }
+        flush_waiters_--;
+    }
+
+    // Deliver what is queued and end the delivery thread. From a handler it
+    // only asks the thread to end after that handler.
+    void Stop() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+            stopping_ = true;
+            wake_cv_.notify_all();
+            if (InDeliveryThread()) {
+                return;
+            }
+            thread = std::move(thread_);
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    bool InDeliveryThread() const { return delivery_thread_.load() == std::this_thread::get_id(); }
+
+    Stats GetStats() const {
+        Stats stats;
+        stats.running = running_.load();
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
+            stats.subscribers = subscribers_->size();
+        }
+        stats.published = published_.load();
+        stats.delivered = delivered_.load();
+        stats.dropped = dropped_.load();
+        stats.handler_failures = handler_failures_.load();
+        stats.max_depth = max_depth_.load();
+        stats.sleeps = sleeps_.load();
+        stats.publisher_wakes = publisher_wakes_.load();
+        stats.latency_total_us = latency_total_us_.load();
+        stats.latency_max_us = latency_max_us_.load();
+        stats.handler_max_us = handler_max_us_.load();
+        return stats;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+    };
+
+    struct Entry : Node {
+        explicit Entry(Event event) : event(std::move(event)), published(Clock::now()) {}
+        Event event;
+        Clock::time_point published;
+    };
+
+    struct Subscriber {
+        SubscriptionId id;
+        Handler handler;
+    };
+    using Subscribers = std::vector<Subscriber>;
+
+    static void UpdateMax(std::atomic<uint64_t>& target, uint64_t value) {
+        uint64_t current = target.load();
+        while (value > current && !target.compare_exchange_weak(current, value)) {
+        }
+    }
+
+    static uint64_t Microseconds(Clock::duration duration) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+
+    // Producers: one exchange, then link the old back to the new node
+    void Push(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* previous = back_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer only. Null when empty, or when a push is between its
+    // exchange and its link; pending_ tells the two apart.
+    Entry* Pop() {
+        Node* front = front_;
+        Node* next = front->next.load(std::memory_order_acquire);
+        if (front == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            front_ = next;
+            front = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            front_ = next;
+            return static_cast<Entry*>(front);
+        }
+        if (front != back_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        // `front` is the last node: park the stub behind it to take it out
+        Push(&stub_);
+        next = front->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            front_ = next;
+            return static_cast<Entry*>(front);
+        }
+        return nullptr;
+    }
+
+    void Loop() {
+        delivery_thread_ = std::this_thread::get_id();
+        for (;;) {
+            if (Entry* entry = Pop()) {
+                Deliver(entry);
+                continue;
+            }
+            if (pending_.load() > 0) {
+                // A publisher is linking its event in
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+            // Paired with Publish(): it counts then reads sleeping_, this
+            // sets sleeping_ then reads the count, so one sees the other
+            sleeping_ = true;
+            if (pending_.load() == 0) {
+                sleeps_++;
+                wake_cv_.wait(lock, [this]() { return pending_.load() > 0 || stopping_; });
+            }
+            sleeping_ = false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        loop_alive_ = false;
+        delivery_thread_ = std::thread::id();
+        flushed_cv_.notify_all();
+    }
+
+    void Deliver(Entry* entry) {
+        Clock::time_point started = Clock::now();
+        uint64_t latency = Microseconds(started - entry->published);
+        latency_total_us_ += latency;
+        UpdateMax(latency_max_us_, latency);
+        {
+            std::lock_guard<std::mutex> lock(delivery_mutex_);
+            std::shared_ptr<const Subscribers> subscribers;
+            {
+                std::lock_guard<std::mutex> subscribers_lock(subscribers_mutex_);
+                subscribers = subscribers_;
+            }
+            for (const Subscriber& subscriber : *subscribers) {
+                try {
+                    subscriber.handler(entry->event);
+                } catch (...) {
+                    handler_failures_++;
+                }
+            }
+        }
+        UpdateMax(handler_max_us_, Microseconds(Clock::now() - started));
+        delete entry;
+        pending_--;
+        delivered_++;
+        if (flush_waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flushed_cv_.notify_all();
+        }
+    }
+
+    // The queue: producers exchange back_, the delivery thread owns front_
+    Node stub_;
+    std::atomic<Node*> back_;
+    Node* front_;
+    std::atomic<int64_t> pending_{0};  // Counted before the push, uncounted after delivery
+    std::atomic<bool> sleeping_{false};  // Cleared by the publish that wakes the thread
+
+    mutable std::mutex mutex_;  // Guards the thread state; only wakes wait on it
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    bool stopping_ = false;
+    bool loop_alive_ = false;
+    std::atomic<std::thread::id> delivery_thread_{};
+    std::atomic<int> flush_waiters_{0};
+
+    mutable std::mutex subscribers_mutex_;  // Copy on write; held only to swap
+    std::shared_ptr<const Subscribers> subscribers_;
+    SubscriptionId next_id_ = 0;
+    std::mutex delivery_mutex_;  // Held by the delivery thread while handlers run
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> handler_failures_{0};
+    std::atomic<uint64_t> max_depth_{0};
+    std::atomic<uint64_t> sleeps_{0};
+    std::atomic<uint64_t> publisher_wakes_{0};
+    std::atomic<uint64_t> latency_total_us_{0};
+    std::atomic<uint64_t> latency_max_us_{0};
+    std::atomic<uint64_t> handler_max_us_{0};
+};
+
+#endif  // EVENT_BUS_H_
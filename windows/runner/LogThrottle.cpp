@@ -0,0 +1,247 @@
+#include "LogThrottle.h"
+#include <cstdio>
+
+namespace {
+
+constexpr int64_t kSweepIntervalMs = 1000;
+constexpr int64_t kRateSummaryQuietMs = 1000;
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+const char* const kSharedBucket = "*";
+
+bool IsAlnum(unsigned char c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+uint64_t FnvByte(uint64_t hash, unsigned char c) {
+    return (hash ^ c) * kFnvPrime;
+}
+
+}  // namespace
+
+LogThrottle::LogThrottle(const Config& config) : config_(config) {
+    if (config_.duplicate_pass == 0) {
+        config_.duplicate_pass = 1;
+    }
+}
+
+uint64_t LogThrottle::TemplateHash(int level, const std::string& module, const std::string& message) {
+    uint64_t hash = FnvByte(kFnvOffset, static_cast<unsigned char>(level));
+    for (char c : module) {
+        hash = FnvByte(hash, static_cast<unsigned char>(c));
+    }
+    hash = FnvByte(hash, 0);
+
+    size_t i = 0;
+    const size_t length = message.size();
+    while (i < length) {
+        unsigned char c = static_cast<unsigned char>(message[i]);
+        if (!IsAlnum(c)) {
+            hash = FnvByte(hash, c);
+            i++;
+            continue;
+        }
+        // Hash a word as-is unless it carries a digit (number, address, id)
+        size_t start = i;
+        bool has_digit = false;
+        while (i < length && IsAlnum(static_cast<unsigned char>(message[i]))) {
+            has_digit |= message[i] >= '0' && message[i] <= '9';
+            i++;
+        }
+        if (has_digit) {
+            hash = FnvByte(hash, '#');
+        } else {
+            for (size_t j = start; j < i; j++) {
+                hash = FnvByte(hash, static_cast<unsigned char>(message[j]));
+            }
+        }
+    }
+    return hash ? hash : 1;
+}
+
+std::string LogThrottle::FormatDuration(int64_t duration_ms) {
+    char text[32];
+    if (duration_ms < 0) {
+        duration_ms = 0;
+    }
+    if (duration_ms < 1000) {
+        std::snprintf(text, sizeof(text), "%lldms", static_cast<long long>(duration_ms));
+    } else if (duration_ms < 60000) {
+        std::snprintf(text, sizeof(text), "%.1fs", static_cast<double>(duration_ms) / 1000.0);
+    } else {
+        long long seconds = static_cast<long long>(duration_ms / 1000);
+        std::snprintf(text, sizeof(text), "%lldm%02llds", seconds / 60, seconds % 60);
+    }
+    return text;
+}
+
+void LogThrottle::SummarizeBurst(Burst& burst, const EmitFn& emit) {
+    if (burst.suppressed == 0) {
+        return;
+    }
+    std::string text = burst.sample + " (\xc3\x97" + std::to_string(burst.count) + " over " +
+                       FormatDuration(burst.last_ms - burst.first_ms) + ")";
+    stats_.summaries++;
+    if (emit) {
+        emit(burst.level, burst.module, text);
+    }
+    burst.suppressed = 0;
+}
+
+void LogThrottle::SummarizeBucket(const std::string& module, Bucket& bucket, const EmitFn& emit) {
+    if (bucket.dropped == 0) {
+        return;
+    }
+    std::string text = "rate limited: " + std::to_string(bucket.dropped) + " messages suppressed over " +
+                       FormatDuration(bucket.last_drop_ms - bucket.first_drop_ms);
+    stats_.summaries++;
+    if (emit) {
+        emit(kWarnLevel, module, text);
+    }
+    bucket.dropped = 0;
+}
+
+void LogThrottle::Sweep(int64_t now_ms, bool force, const EmitFn& emit) {
+    last_sweep_ms_ = now_ms;
+
+    for (auto it = bursts_.begin(); it != bursts_.end();) {
+        if (force || now_ms - it->second.last_ms > config_.burst_window_ms) {
+            SummarizeBurst(it->second, emit);
+            it = bursts_.erase(it);  // Burst over; forget the template
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto& [module, bucket] : buckets_) {
+        if (bucket.dropped && (force || now_ms - bucket.last_drop_ms >= kRateSummaryQuietMs)) {
+            SummarizeBucket(module, bucket, emit);
+        }
+    }
+}
+
+void LogThrottle::StartBurst(Burst& burst, int64_t now_ms, int level, const std::string& module,
+                             const std::string& message) {
+    burst.first_ms = now_ms;
+    burst.last_ms = now_ms;
+    burst.count = 1;
+    burst.suppressed = 0;
+    burst.level = level;
+    burst.module = module;
+    burst.sample = message.substr(0, kSampleLength - 1);
+}
+
+bool LogThrottle::Dedupe(int64_t now_ms, int level, const std::string& module, const std::string& message,
+                         const EmitFn& emit) {
+    uint64_t key = TemplateHash(level, module, message);
+    auto found = bursts_.find(key);
+
+    if (found == bursts_.end()) {
+        if (bursts_.size() >= kMaxTemplates) {
+            auto oldest = bursts_.begin();
+            for (auto it = bursts_.begin(); it != bursts_.end(); ++it) {
+                if (it->second.last_ms < oldest->second.last_ms) {
+                    oldest = it;
+                }
+            }
+            SummarizeBurst(oldest->second, emit);
+            bursts_.erase(oldest);
+            stats_.evictions++;
+        }
+        StartBurst(bursts_[key], now_ms, level, module, message);
+        return true;
+    }
+
+    Burst& burst = found->second;
+    if (now_ms - burst.last_ms > config_.burst_window_ms) {
+        SummarizeBurst(burst, emit);
+        StartBurst(burst, now_ms, level, module, message);
+        return true;
+    }
+
+    burst.count++;
+    burst.last_ms = now_ms;
+    if (burst.count <= config_.duplicate_pass) {
+        return true;
+    }
+
+    burst.suppressed++;
+    stats_.collapsed++;
+    stats_.suppressed_bytes += message.size();
+
+    if (now_ms - burst.first_ms >= config_.max_burst_ms) {
+        // Long-running flood: report what we have and keep collapsing
+        SummarizeBurst(burst, emit);
+        burst.first_ms = now_ms;
+        burst.count = config_.duplicate_pass;
+    }
+    return false;
+}
+
+LogThrottle::Bucket& LogThrottle::FindBucket(const std::string& module, int64_t now_ms) {
+    const std::string name = module.empty() ? "-" : module;
+    auto it = buckets_.find(name);
+    if (it == buckets_.end()) {
+        // The shared bucket takes every module that did not get its own
+        const std::string& key = buckets_.size() < kMaxModules - 1 ? name : std::string(kSharedBucket);
+        it = buckets_.find(key);
+        if (it == buckets_.end()) {
+            Bucket bucket;
+            bucket.tokens_milli = static_cast<int64_t>(config_.rate_burst) * 1000;
+            bucket.refilled_ms = now_ms;
+            it = buckets_.emplace(key, bucket).first;
+        }
+    }
+    return it->second;
+}
+
+bool LogThrottle::TakeToken(Bucket& bucket, int64_t now_ms) {
+    int64_t capacity = static_cast<int64_t>(config_.rate_burst) * 1000;
+    int64_t elapsed = now_ms - bucket.refilled_ms;
+    if (elapsed > 0) {
+        // rate_per_sec tokens per second is rate_per_sec milli-tokens per millisecond
+        bucket.tokens_milli += elapsed * static_cast<int64_t>(config_.rate_per_sec);
+        if (bucket.tokens_milli > capacity) {
+            bucket.tokens_milli = capacity;
+        }
+        bucket.refilled_ms = now_ms;
+    }
+    if (bucket.tokens_milli < 1000) {
+        return false;
+    }
+    bucket.tokens_milli -= 1000;
+    return true;
+}
+
+bool LogThrottle::Submit(int64_t now_ms, int level, const std::string& module, const std::string& message,
+                         const EmitFn& emit) {
+    stats_.submitted++;
+    if (now_ms - last_sweep_ms_ >= kSweepIntervalMs) {
+        Sweep(now_ms, false, emit);
+    }
+
+    if (!Dedupe(now_ms, level, module, message, emit)) {
+        return false;
+    }
+
+    if (config_.rate_per_sec > 0) {
+        Bucket& bucket = FindBucket(module, now_ms);
+        if (!TakeToken(bucket, now_ms) && level < config_.exempt_level) {
+            if (bucket.dropped == 0) {
+                bucket.first_drop_ms = now_ms;
+            }
+            bucket.dropped++;
+            bucket.last_drop_ms = now_ms;
+            stats_.rate_limited++;
+            stats_.suppressed_bytes += message.size();
+            return false;
+        }
+    }
+
+    stats_.passed++;
+    return true;
+}
+
+void LogThrottle::Flush(int64_t now_ms, bool force, const EmitFn& emit) {
+    Sweep(now_ms, force, emit);
+}
@@ -0,0 +1,102 @@
+#ifndef LOG_THROTTLE_H_
+#define LOG_THROTTLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Duplicate-burst collapsing plus per-module rate limits for runner logging.
+//
+// Messages are keyed by template: level, module and the text with every token
+// that contains a digit (ports, addresses, ids, counters) replaced by a
+// placeholder. The first occurrence of a template passes; repeats within the
+// burst window are counted and later reported once as "message (×N over T)".
+// Messages that survive deduplication draw from a token bucket per module.
+//
+// Mirrors android/app/src/main/cpp/sing_box_logthrottle.c; log_throttle_test
+// replays the C stage's scenarios here and compares the two on one stream.
+// Not thread safe; callers hold their own lock.
+class LogThrottle {
+public:
+    struct Config {
+        int64_t burst_window_ms = 5000;   // Repeats closer than this extend the burst
+        int64_t max_burst_ms = 60000;     // Emit an interim summary for longer bursts
+        uint32_t duplicate_pass = 1;      // Occurrences logged before collapsing starts
+        uint32_t rate_per_sec = 50;       // Per-module refill rate, 0 = no rate limit
+        uint32_t rate_burst = 200;        // Per-module bucket capacity
+        int exempt_level = 5;             // Levels at or above this are never rate limited
+    };
+
+    struct Stats {
+        uint64_t submitted = 0;
+        uint64_t passed = 0;
+        uint64_t collapsed = 0;
+        uint64_t rate_limited = 0;
+        uint64_t suppressed_bytes = 0;
+        uint64_t summaries = 0;
+        uint64_t evictions = 0;
+    };
+
+    using EmitFn = std::function<void(int level, const std::string& module, const std::string& message)>;
+
+    static constexpr size_t kMaxTemplates = 128;
+    static constexpr size_t kMaxModules = 32;
+    static constexpr size_t kSampleLength = 192;
+    static constexpr int kWarnLevel = 3;
+
+    LogThrottle() = default;
+    explicit LogThrottle(const Config& config);
+
+    // Returns true if the caller should log the message; summaries of expired
+    // bursts found along the way are delivered through emit first
+    bool Submit(int64_t now_ms, int level, const std::string& module, const std::string& message,
+                const EmitFn& emit);
+
+    // Summarise bursts and rate-limited modules that went quiet, or everything
+    // pending when force is set (shutdown, export)
+    void Flush(int64_t now_ms, bool force, const EmitFn& emit);
+
+    const Stats& GetStats() const { return stats_; }
+
+    static uint64_t TemplateHash(int level, const std::string& module, const std::string& message);
+    static std::string FormatDuration(int64_t duration_ms);
+
+private:
+    struct Burst {
+        int64_t first_ms = 0;
+        int64_t last_ms = 0;
+        uint32_t count = 0;
+        uint32_t suppressed = 0;
+        int level = 0;
+        std::string module;
+        std::string sample;
+    };
+
+    struct Bucket {
+        int64_t tokens_milli = 0;
+        int64_t refilled_ms = 0;
+        int64_t first_drop_ms = 0;
+        int64_t last_drop_ms = 0;
+        uint64_t dropped = 0;
+    };
+
+    bool Dedupe(int64_t now_ms, int level, const std::string& module, const std::string& message,
+                const EmitFn& emit);
+    Bucket& FindBucket(const std::string& module, int64_t now_ms);
+    bool TakeToken(Bucket& bucket, int64_t now_ms);
+    void SummarizeBurst(Burst& burst, const EmitFn& emit);
+    void SummarizeBucket(const std::string& module, Bucket& bucket, const EmitFn& emit);
+    void Sweep(int64_t now_ms, bool force, const EmitFn& emit);
+    static void StartBurst(Burst& burst, int64_t now_ms, int level, const std::string& module,
+                           const std::string& message);
+
+    Config config_;
+    Stats stats_;
+    int64_t last_sweep_ms_ = 0;
+    std::unordered_map<uint64_t, Burst> bursts_;
+    std::unordered_map<std::string, Bucket> buckets_;
+};
+
+#endif // LOG_THROTTLE_H_
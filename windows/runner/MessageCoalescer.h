@@ -0,0 +1,130 @@
+#ifndef MESSAGE_COALESCER_H_
+#define MESSAGE_COALESCER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Queue of native→Dart messages that producers on any thread post to and the
+// platform thread drains in batches.
+//
+// State-like messages (stats, status, network state) are posted with
+// PostLatest: a newer payload replaces the pending one in place, so a burst
+// costs one delivery. Messages that must all arrive (errors) go through
+// PostEvery and keep their order; past kMaxQueued of them further ones are
+// dropped and counted.
+//
+// The first post after a drain asks the owner to schedule the next drain,
+// no sooner than one frame after the previous one, so the platform thread
+// runs at most one batch per frame however many threads post.
+//
+// Free of platform types so the host build can test it; PlatformDispatcher
+// supplies the Win32 scheduling and the method channel.
+template <typename Payload>
+class MessageCoalescer {
+public:
+    struct Message {
+        std::string method;
+        Payload payload;
+    };
+
+    struct Stats {
+        uint64_t posted = 0;
+        uint64_t coalesced = 0;     // Replaced before they were delivered
+        uint64_t dropped = 0;       // PostEvery beyond kMaxQueued
+        uint64_t delivered = 0;
+        uint64_t batches = 0;
+        uint64_t schedules = 0;     // Drain requests made to the owner
+    };
+
+    // Asks for Drain() to run on the platform thread in delay_ms; called
+    // without the lock held, from whichever thread posted
+    using ScheduleFn = std::function<void(int64_t delay_ms)>;
+
+    static constexpr int64_t kDefaultFrameMs = 16;
+    static constexpr size_t kMaxQueued = 256;
+
+    explicit MessageCoalescer(ScheduleFn schedule, int64_t frame_ms = kDefaultFrameMs)
+        : schedule_(std::move(schedule)), frame_ms_(frame_ms) {}
+
+    // Replace any pending message of the same method
+    void PostLatest(int64_t now_ms, const std::string& method, Payload payload) {
+        Post(now_ms, method, std::move(payload), true);
+    }
+
+    // Queue the message behind everything already pending
+    void PostEvery(int64_t now_ms, const std::string& method, Payload payload) {
+        Post(now_ms, method, std::move(payload), false);
+    }
+
+    // Take the pending messages, in the order they were first posted
+    std::vector<Message> Drain(int64_t now_ms) {
+        std::vector<Message> batch;
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.swap(pending_);
+        latest_index_.clear();
+        queued_ = 0;
+        scheduled_ = false;
+        last_drain_ms_ = now_ms;
+        if (!batch.empty()) {
+            stats_.delivered += batch.size();
+            stats_.batches++;
+        }
+        return batch;
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    void Post(int64_t now_ms, const std::string& method, Payload payload, bool latest) {
+        int64_t delay_ms = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.posted++;
+            auto found = latest ? latest_index_.find(method) : latest_index_.end();
+            if (found != latest_index_.end()) {
+                pending_[found->second].payload = std::move(payload);
+                stats_.coalesced++;
+            } else if (!latest && queued_ >= kMaxQueued) {
+                stats_.dropped++;
+            } else {
+                if (latest) {
+                    latest_index_.emplace(method, pending_.size());
+                } else {
+                    queued_++;
+                }
+                pending_.push_back(Message{method, std::move(payload)});
+            }
+            if (!scheduled_) {
+                scheduled_ = true;
+                stats_.schedules++;
+                int64_t due_ms = last_drain_ms_ + frame_ms_;
+                delay_ms = due_ms > now_ms ? due_ms - now_ms : 0;
+            }
+        }
+        if (delay_ms >= 0 && schedule_) {
+            schedule_(delay_ms);
+        }
+    }
+
+    ScheduleFn schedule_;
+    int64_t frame_ms_;
+
+    mutable std::mutex mutex_;
+    std::vector<Message> pending_;
+    std::unordered_map<std::string, size_t> latest_index_;  // Method -> slot in pending_
+    size_t queued_ = 0;                                      // PostEvery messages pending
+    bool scheduled_ = false;
+    int64_t last_drain_ms_ = INT64_MIN / 2;
+    Stats stats_;
+};
+
+#endif // MESSAGE_COALESCER_H_
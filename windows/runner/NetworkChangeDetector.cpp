@@ -10,6 +10,9 @@
 
 #pragma comment(lib, "wininet.lib")
 
+// Executor key of the pending or running reconnection attempt
+static const char* const kReconnectKey = "reconnect";
+
 NetworkChangeDetector::NetworkChangeDetector(SingboxManager* singbox_manager)
     : singbox_manager_(singbox_manager),
       current_network_state_(NetworkState::Unknown),
@@ -24,10 +27,14 @@ NetworkChangeDetector::NetworkChangeDetector(SingboxManager* singbox_manager)
       max_retry_attempts_(DEFAULT_MAX_RETRY_ATTEMPTS),
       health_check_interval_ms_(DEFAULT_HEALTH_CHECK_INTERVAL_MS),
       winsock_initialized_(false),
-      network_change_event_(nullptr) {
+      network_change_event_(nullptr),
+      network_stop_event_(nullptr),
+      network_notify_pending_(false) {
     
-    // Initialize network change event
+    // Initialize network change event; the IP Helper signals it through the
+    // overlapped structure, the stop event is ours alone
     network_change_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    network_stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
     ZeroMemory(&network_change_overlapped_, sizeof(OVERLAPPED));
     network_change_overlapped_.hEvent = network_change_event_;
     
@@ -40,6 +47,9 @@ NetworkChangeDetector::~NetworkChangeDetector() {
     if (network_change_event_) {
         CloseHandle(network_change_event_);
     }
+    if (network_stop_event_) {
+        CloseHandle(network_stop_event_);
+    }
     
     CleanupWinsock();
 }
@@ -89,6 +99,7 @@ void NetworkChangeDetector::StopMonitoring() {
     }
     
     is_monitoring_.store(false);
+    CancelReconnection();
     
     // Stop monitoring threads
     StopNetworkMonitorThread();
@@ -111,6 +122,9 @@ void NetworkChangeDetector::StopMonitoring() {
     
     retry_attempts_.store(0);
     is_reconnecting_.store(false);
+    if (singbox_manager_) {
+        singbox_manager_->FlushThrottledLogs();
+    }
     
     std::cout << "NetworkChangeDetector: Monitoring stopped" << std::endl;
 }
@@ -170,6 +184,16 @@ void NetworkChangeDetector::ResetReconnectionAttempts() {
     std::cout << "NetworkChangeDetector: Reconnection attempts reset" << std::endl;
 }
 
+void NetworkChangeDetector::CancelReconnection() {
+    if (executor_) {
+        executor_->Cancel(kReconnectKey);
+    }
+}
+
+void NetworkChangeDetector::SetExecutor(TaskExecutor* executor) {
+    executor_ = executor;
+}
+
 void NetworkChangeDetector::SetReconnectionEnabled(bool enabled) {
     reconnection_enabled_.store(enabled);
     std::cout << "NetworkChangeDetector: Reconnection " << (enabled ? "enabled" : "disabled") << std::endl;
@@ -224,11 +248,14 @@ std::chrono::steady_clock::time_point NetworkChangeDetector::GetLastNetworkChang
 
 void NetworkChangeDetector::StartNetworkMonitorThread() {
     network_monitor_running_.store(true);
+    ResetEvent(network_stop_event_);
     network_monitor_thread_ = std::thread(&NetworkChangeDetector::NetworkMonitorLoop, this);
 }
 
 void NetworkChangeDetector::StopNetworkMonitorThread() {
     network_monitor_running_.store(false);
+    // Wakes the loop whether or not an address change is pending
+    SetEvent(network_stop_event_);
     
     if (network_monitor_thread_.joinable()) {
         network_monitor_thread_.join();
@@ -240,14 +267,18 @@ void NetworkChangeDetector::NetworkMonitorLoop() {
     
     while (network_monitor_running_.load()) {
         try {
-            // Check for network interface changes
-            DetectNetworkChanges();
-            
-            // Wait for network change event or timeout
-            DWORD wait_result = WaitForSingleObject(network_change_event_, NETWORK_MONITOR_INTERVAL_MS);
+            // Asleep until an address changes or StopNetworkMonitorThread
+            // signals; NotifyAddrChange reports every change, so there is
+            // nothing to poll in between
+            HANDLE handles[] = { network_stop_event_, network_change_event_ };
+            DWORD wait_result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (wait_result != WAIT_OBJECT_0 + 1) {
+                break;
+            }
+            network_notify_pending_ = false;
             
-            if (wait_result == WAIT_OBJECT_0) {
-                std::cout << "NetworkChangeDetector: Network change event received" << std::endl;
+            if (network_monitor_running_.load()) {
+                Log(SingboxManager::INFO_LOG_LEVEL, "Network change event received");
                 
                 // Update network interfaces and state
                 UpdateNetworkInterfaces();
@@ -263,8 +294,9 @@ void NetworkChangeDetector::NetworkMonitorLoop() {
             }
             
         } catch (const std::exception& e) {
-            std::cerr << "NetworkChangeDetector: Error in network monitor loop: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(NETWORK_MONITOR_INTERVAL_MS));
+            Log(SingboxManager::WARN_LOG_LEVEL, std::string("Error in network monitor loop: ") + e.what());
+            // Back off, still woken by StopNetworkMonitorThread
+            WaitForSingleObject(network_stop_event_, NETWORK_MONITOR_INTERVAL_MS);
         }
     }
     
@@ -273,11 +305,13 @@ void NetworkChangeDetector::NetworkMonitorLoop() {
 
 void NetworkChangeDetector::StartHealthMonitorThread() {
     health_monitor_running_.store(true);
+    health_gate_.Reset();
     health_monitor_thread_ = std::thread(&NetworkChangeDetector::HealthMonitorLoop, this);
 }
 
 void NetworkChangeDetector::StopHealthMonitorThread() {
     health_monitor_running_.store(false);
+    health_gate_.Stop();
     
     if (health_monitor_thread_.joinable()) {
         health_monitor_thread_.join();
@@ -292,11 +326,11 @@ void NetworkChangeDetector::HealthMonitorLoop() {
             CheckConnectionHealth();
             
             int interval = health_check_interval_ms_.load();
-            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+            health_gate_.Wait(std::chrono::milliseconds(interval));
             
         } catch (const std::exception& e) {
-            std::cerr << "NetworkChangeDetector: Error in health monitor loop: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(health_check_interval_ms_.load()));
+            Log(SingboxManager::WARN_LOG_LEVEL, std::string("Error in health monitor loop: ") + e.what());
+            health_gate_.Wait(std::chrono::milliseconds(health_check_interval_ms_.load()));
         }
     }
     
@@ -385,7 +419,7 @@ void NetworkChangeDetector::DetectNetworkChanges() {
     // Compare with previous state
     if (HasNetworkInterfaceChanged()) {
         last_network_change_ = std::chrono::steady_clock::now();
-        std::cout << "NetworkChangeDetector: Network interface change detected" << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Network interface change detected");
         
         UpdateNetworkInterfaces();
         UpdateNetworkState();
@@ -461,14 +495,14 @@ NetworkInfo NetworkChangeDetector::GetNetworkInterfaceInfo(DWORD interface_index
     return NetworkInfo{}; // Return empty info if not found
 }
 
-void NetworkChangeDetector::AttemptReconnection(const std::string& reason) {
-    if (is_reconnecting_.load()) {
+void NetworkChangeDetector::AttemptReconnection(const std::string& reason, const CancellationToken& token) {
+    if (is_reconnecting_.load() || token.IsCancelled()) {
         return;
     }
     
     int current_attempt = retry_attempts_.load() + 1;
     if (current_attempt > max_retry_attempts_.load()) {
-        std::cout << "NetworkChangeDetector: Maximum retry attempts reached" << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Maximum retry attempts reached");
         UpdateReconnectionStatus(ReconnectionStatus::Failed);
         return;
     }
@@ -477,17 +511,17 @@ void NetworkChangeDetector::AttemptReconnection(const std::string& reason) {
     retry_attempts_.store(current_attempt);
     UpdateReconnectionStatus(ReconnectionStatus::Attempting);
     
-    std::cout << "NetworkChangeDetector: Attempting reconnection #" << current_attempt 
-              << " (reason: " << reason << ")" << std::endl;
+    Log(SingboxManager::INFO_LOG_LEVEL, "Attempting reconnection #" + std::to_string(current_attempt) + " (reason: " + reason + ")");
     
     // Calculate backoff delay
     DWORD delay = CalculateBackoffDelay(current_attempt);
-    std::cout << "NetworkChangeDetector: Waiting " << delay << "ms before reconnection attempt" << std::endl;
+    Log(SingboxManager::INFO_LOG_LEVEL, "Waiting " + std::to_string(delay) + "ms before reconnection attempt");
     
-    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    // A connect or disconnect from the user cancels the wait
+    bool waited = token.WaitFor(std::chrono::milliseconds(delay));
     
     // Check if we still need to reconnect
-    if (!is_monitoring_.load() || singbox_manager_->IsRunning()) {
+    if (!waited || !is_monitoring_.load() || singbox_manager_->IsRunning()) {
         UpdateReconnectionStatus(ReconnectionStatus::Idle);
         is_reconnecting_.store(false);
         return;
@@ -499,41 +533,50 @@ void NetworkChangeDetector::AttemptReconnection(const std::string& reason) {
     RecordReconnectionAttempt(current_attempt, reason, success);
     
     if (success) {
-        std::cout << "NetworkChangeDetector: Reconnection successful after " << current_attempt << " attempts" << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Reconnection successful after " + std::to_string(current_attempt) + " attempts");
         retry_attempts_.store(0);
         UpdateReconnectionStatus(ReconnectionStatus::Success);
         UpdateConnectionHealth(ConnectionHealth::Good);
         
         // Reset to idle after a short delay
-        std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        token.WaitFor(std::chrono::milliseconds(2000));
         UpdateReconnectionStatus(ReconnectionStatus::Idle);
     } else {
-        std::cout << "NetworkChangeDetector: Reconnection attempt #" << current_attempt << " failed" << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Reconnection attempt #" + std::to_string(current_attempt) + " failed");
         
         if (current_attempt >= max_retry_attempts_.load()) {
-            std::cout << "NetworkChangeDetector: All reconnection attempts failed" << std::endl;
+            Log(SingboxManager::INFO_LOG_LEVEL, "All reconnection attempts failed");
             UpdateReconnectionStatus(ReconnectionStatus::Failed);
-        } else {
+        } else if (!token.IsCancelled()) {
             // Schedule next attempt
-            std::thread([this, reason]() {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-                AttemptReconnection(reason);
-            }).detach();
+            is_reconnecting_.store(false);
+            ScheduleReconnectionAttempt(reason, 1000);
+            return;
         }
     }
     
     is_reconnecting_.store(false);
 }
 
-void NetworkChangeDetector::ScheduleReconnectionAttempt(const std::string& reason) {
-    if (!reconnection_enabled_.load()) {
+void NetworkChangeDetector::ScheduleReconnectionAttempt(const std::string& reason, int delay_ms) {
+    if (!reconnection_enabled_.load() || !executor_) {
+        return;
+    }
+    // The health monitor keeps asking while the connection is down; one
+    // attempt at a time
+    if (is_reconnecting_.load()) {
         return;
     }
     
-    // Schedule reconnection in a separate thread to avoid blocking
-    std::thread([this, reason]() {
-        AttemptReconnection(reason);
-    }).detach();
+    // Queued behind any connect or disconnect in progress; a newer schedule
+    // replaces one still waiting
+    executor_->Submit(TaskExecutor::Lane::Serial, kReconnectKey,
+        [this, reason, delay_ms](const CancellationToken& token) {
+            if (delay_ms > 0 && !token.WaitFor(std::chrono::milliseconds(delay_ms))) {
+                return;
+            }
+            AttemptReconnection(reason, token);
+        });
 }
 
 DWORD NetworkChangeDetector::CalculateBackoffDelay(int attempt_number) {
@@ -629,16 +672,33 @@ void NetworkChangeDetector::NotifyReconnectionStatusChange(ReconnectionStatus ne
     }
 }
 
+void NetworkChangeDetector::Log(int level, const std::string& message) const {
+    if (singbox_manager_) {
+        singbox_manager_->LogThrottled(level, "NetworkChangeDetector", "NetworkChangeDetector: " + message);
+        return;
+    }
+    (level >= SingboxManager::WARN_LOG_LEVEL ? std::cerr : std::cout)
+        << "NetworkChangeDetector: " << message << std::endl;
+}
+
 bool NetworkChangeDetector::RegisterForNetworkNotifications() {
-    // Use NotifyAddrChange for network change notifications
-    DWORD result = NotifyAddrChange(&network_change_event_, &network_change_overlapped_);
+    // Use NotifyAddrChange for network change notifications. With an
+    // overlapped request the handle out-param is only a placeholder; the
+    // completion signals network_change_overlapped_.hEvent
+    HANDLE notify_handle = nullptr;
+    ZeroMemory(&network_change_overlapped_, sizeof(OVERLAPPED));
+    network_change_overlapped_.hEvent = network_change_event_;
+    DWORD result = NotifyAddrChange(&notify_handle, &network_change_overlapped_);
+    network_notify_pending_ = result == ERROR_IO_PENDING;
     return (result == ERROR_IO_PENDING || result == NO_ERROR);
 }
 
 void NetworkChangeDetector::UnregisterNetworkNotifications() {
-    // Cancel pending notifications
-    if (network_change_event_) {
-        SetEvent(network_change_event_);
+    // Cancel the pending request so the IP Helper stops referencing
+    // network_change_overlapped_
+    if (network_notify_pending_) {
+        CancelIPChangeNotify(&network_change_overlapped_);
+        network_notify_pending_ = false;
     }
 }
 
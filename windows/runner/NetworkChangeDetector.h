@@ -19,6 +19,9 @@
 #include <chrono>
 #include <queue>
 
+#include "TaskExecutor.h"
+#include "WakeGate.h"
+
 #pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
 
@@ -88,8 +91,13 @@ public:
     // Manual control
     void TriggerReconnection();
     void ResetReconnectionAttempts();
+    // Drop a scheduled attempt and cut short the backoff of a running one
+    void CancelReconnection();
 
     // Configuration
+    // Reconnection attempts run on the serial lane of `executor`, so they
+    // never overlap a connect or disconnect
+    void SetExecutor(TaskExecutor* executor);
     void SetReconnectionEnabled(bool enabled);
     void SetHealthCheckInterval(int interval_ms);
     void SetMaxRetryAttempts(int max_attempts);
@@ -102,6 +110,8 @@ public:
     // Statistics
     std::vector<ReconnectionAttempt> GetReconnectionHistory() const;
     int GetTotalReconnectionAttempts() const;
+    // Wakeups of the health monitor, which exists only while monitoring
+    WakeGate::Stats GetHealthWakeupStats() const { return health_gate_.GetStats(); }
     std::chrono::steady_clock::time_point GetLastNetworkChange() const;
 
 private:
@@ -128,8 +138,8 @@ private:
     NetworkInfo GetNetworkInterfaceInfo(DWORD interface_index);
     
     // Reconnection logic
-    void AttemptReconnection(const std::string& reason);
-    void ScheduleReconnectionAttempt(const std::string& reason);
+    void AttemptReconnection(const std::string& reason, const CancellationToken& token);
+    void ScheduleReconnectionAttempt(const std::string& reason, int delay_ms = 0);
     DWORD CalculateBackoffDelay(int attempt_number);
     void RecordReconnectionAttempt(int attempt_number, const std::string& reason, bool success);
     
@@ -141,6 +151,9 @@ private:
     void NotifyConnectionHealthChange(ConnectionHealth new_health);
     void NotifyReconnectionStatusChange(ReconnectionStatus new_status, int attempt_number);
     
+    // Retry and poll logging, throttled by the manager's LogThrottle
+    void Log(int level, const std::string& message) const;
+
     // Utility methods
     std::string NetworkStateToString(NetworkState state) const;
     std::string ConnectionHealthToString(ConnectionHealth health) const;
@@ -156,6 +169,7 @@ private:
     
     // Member variables
     SingboxManager* singbox_manager_;
+    TaskExecutor* executor_ = nullptr;
     std::string vpn_config_json_;
     
     // State
@@ -173,6 +187,7 @@ private:
     std::atomic<bool> health_monitor_running_;
     std::thread network_monitor_thread_;
     std::thread health_monitor_thread_;
+    WakeGate health_gate_{true};        // Stopped to end the health monitor at once
     
     // Reconnection state
     std::atomic<bool> reconnection_enabled_;
@@ -192,9 +207,12 @@ private:
     std::function<void(ConnectionHealth)> connection_health_callback_;
     std::function<void(ReconnectionStatus, int)> reconnection_callback_;
     
-    // Windows handles
+    // Windows handles; the overlapped request and its pending flag belong
+    // to the monitor thread while it runs
     HANDLE network_change_event_;
+    HANDLE network_stop_event_;
     OVERLAPPED network_change_overlapped_;
+    bool network_notify_pending_;
     
     // Constants
     static constexpr int DEFAULT_HEALTH_CHECK_INTERVAL_MS = 30000; // 30 seconds
@@ -0,0 +1,127 @@
+#include "PlatformDispatcher.h"
+
+#include <memory>
+#include <utility>
+
+PlatformDispatcher::PlatformDispatcher(flutter::PluginRegistrarWindows* registrar,
+                                       flutter::MethodChannel<flutter::EncodableValue>* channel)
+    : registrar_(registrar),
+      channel_(channel),
+      coalescer_([this](int64_t delay_ms) { Schedule(delay_ms); }) {
+    // Messages sent to the top-level window reach the delegate on the platform thread
+    if (registrar_->GetView()) {
+        window_ = GetAncestor(registrar_->GetView()->GetNativeWindow(), GA_ROOT);
+    }
+    window_proc_id_ = registrar_->RegisterTopLevelWindowProcDelegate(
+        [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+            return HandleWindowMessage(hwnd, message, wparam, lparam);
+        });
+}
+
+PlatformDispatcher::~PlatformDispatcher() {
+    closed_ = true;
+    registrar_->UnregisterTopLevelWindowProcDelegate(window_proc_id_);
+    if (window_) {
+        KillTimer(window_, kDrainTimerId);
+    }
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    tasks_.clear();
+}
+
+int64_t PlatformDispatcher::NowMs() {
+    return static_cast<int64_t>(GetTickCount64());
+}
+
+void PlatformDispatcher::PostLatest(const std::string& method, flutter::EncodableValue arguments) {
+    coalescer_.PostLatest(NowMs(), method, std::move(arguments));
+}
+
+void PlatformDispatcher::PostEvery(const std::string& method, flutter::EncodableValue arguments) {
+    coalescer_.PostEvery(NowMs(), method, std::move(arguments));
+}
+
+void PlatformDispatcher::Route(const std::string& method,
+                               std::function<void(flutter::EncodableValue)> handler) {
+    routes_[method] = std::move(handler);
+}
+
+void PlatformDispatcher::PostTask(std::function<void()> task) {
+    if (!window_) {
+        // No window to hop through (headless); nothing else runs a platform loop
+        task();
+        return;
+    }
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        if (closed_) {
+            return;
+        }
+        wake = tasks_.empty();
+        tasks_.push_back(std::move(task));
+    }
+    // One message per batch; RunTasks takes everything queued by then
+    if (wake) {
+        PostMessage(window_, kTaskMessage, 0, 0);
+    }
+}
+
+void PlatformDispatcher::Schedule(int64_t delay_ms) {
+    // Timers belong to the thread that owns the window, so a worker only posts
+    // the delay and the platform thread arms the timer
+    if (!window_ || closed_) {
+        return;
+    }
+    PostMessage(window_, kDrainMessage, static_cast<WPARAM>(delay_ms), 0);
+}
+
+std::optional<LRESULT> PlatformDispatcher::HandleWindowMessage(HWND hwnd, UINT message, WPARAM wparam,
+                                                               LPARAM /*lparam*/) {
+    if (message == kDrainMessage) {
+        if (wparam > 0) {
+            SetTimer(hwnd, kDrainTimerId, static_cast<UINT>(wparam), nullptr);
+        } else {
+            DrainNow();
+        }
+        return 0;
+    }
+    if (message == kTaskMessage) {
+        RunTasks();
+        return 0;
+    }
+    if (message == WM_TIMER && wparam == kDrainTimerId) {
+        KillTimer(hwnd, kDrainTimerId);
+        DrainNow();
+        return 0;
+    }
+    return std::nullopt;
+}
+
+void PlatformDispatcher::DrainNow() {
+    for (auto& message : coalescer_.Drain(NowMs())) {
+        if (closed_) {
+            break;
+        }
+        auto route = routes_.find(message.method);
+        if (route != routes_.end()) {
+            route->second(std::move(message.payload));
+        } else if (channel_) {
+            channel_->InvokeMethod(message.method,
+                                   std::make_unique<flutter::EncodableValue>(std::move(message.payload)));
+        }
+    }
+}
+
+void PlatformDispatcher::RunTasks() {
+    std::deque<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) {
+        if (closed_) {
+            break;
+        }
+        task();
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef PLATFORM_DISPATCHER_H_
+#define PLATFORM_DISPATCHER_H_
+
+#include <windows.h>
+
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <flutter/plugin_registrar_windows.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "MessageCoalescer.h"
+
+// Delivers native→Dart method channel messages on the platform thread.
+//
+// Background threads (connection monitor, StatsCollector, NetworkChangeDetector,
+// sing-box process monitor) post here instead of calling InvokeMethod, which
+// Flutter only allows on the platform thread. Posts are coalesced by
+// MessageCoalescer and drained from the top-level window procedure: a posted
+// window message wakes the platform thread, which starts a one-shot timer when
+// the previous batch went out less than a frame ago.
+class PlatformDispatcher {
+public:
+    using Coalescer = MessageCoalescer<flutter::EncodableValue>;
+
+    PlatformDispatcher(flutter::PluginRegistrarWindows* registrar,
+                       flutter::MethodChannel<flutter::EncodableValue>* channel);
+    ~PlatformDispatcher();
+
+    PlatformDispatcher(const PlatformDispatcher&) = delete;
+    PlatformDispatcher& operator=(const PlatformDispatcher&) = delete;
+
+    // Only the newest payload of each method is delivered (stats, status, state)
+    void PostLatest(const std::string& method, flutter::EncodableValue arguments);
+
+    // Every payload is delivered, in order (errors)
+    void PostEvery(const std::string& method, flutter::EncodableValue arguments);
+
+    // Hand messages posted under `method` to `handler` on the platform thread
+    // instead of the method channel (event channel sinks). Register before any
+    // thread posts.
+    void Route(const std::string& method, std::function<void(flutter::EncodableValue)> handler);
+
+    // Run `task` on the platform thread, in posting order and never coalesced
+    // or dropped while the dispatcher lives (method call replies from
+    // TaskExecutor workers). Tasks still queued at destruction are discarded.
+    void PostTask(std::function<void()> task);
+
+    Coalescer::Stats GetStats() const { return coalescer_.GetStats(); }
+
+private:
+    static constexpr UINT kDrainMessage = WM_APP + 0x51;
+    static constexpr UINT kTaskMessage = WM_APP + 0x52;
+    static constexpr UINT_PTR kDrainTimerId = 0x5344;  // "SD"
+
+    void Schedule(int64_t delay_ms);
+    std::optional<LRESULT> HandleWindowMessage(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+    void DrainNow();
+    void RunTasks();
+
+    static int64_t NowMs();
+
+    flutter::PluginRegistrarWindows* registrar_;
+    flutter::MethodChannel<flutter::EncodableValue>* channel_;
+    HWND window_ = nullptr;
+    int window_proc_id_ = -1;
+    std::atomic<bool> closed_{false};
+    std::unordered_map<std::string, std::function<void(flutter::EncodableValue)>> routes_;
+    Coalescer coalescer_;
+    std::mutex tasks_mutex_;
+    std::deque<std::function<void()>> tasks_;  // Guarded by tasks_mutex_
+};
+
+#endif // PLATFORM_DISPATCHER_H_
@@ -19,6 +19,7 @@ SingboxManager::SingboxManager()
     , is_running_(false)
     , stats_thread_running_(false)
     , monitor_thread_running_(false)
+    , monitor_stop_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr))
     , is_initialized_(false)
     , last_error_(SingboxError::None)
     , current_stats_{}
@@ -44,12 +45,17 @@ SingboxManager::SingboxManager()
 
 SingboxManager::~SingboxManager() {
     Cleanup();
+    if (monitor_stop_event_) {
+        CloseHandle(monitor_stop_event_);
+    }
 }
 
 bool SingboxManager::Initialize() {
     auto start_time = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now().time_since_epoch()).count();
     
+    // Cleanup() stopped delivery; a manager initialized again resumes it
+    events_.Start();
     if (is_initialized_) {
         return true;
     }
@@ -212,6 +218,7 @@ bool SingboxManager::Start(const std::string& config_json) {
         is_running_ = true;
         StartStatisticsThread();
         StartProcessMonitorThread();
+        PublishState(SingboxEvent::Kind::Started);
 
         std::cout << "Sing-box started successfully" << std::endl;
         return true;
@@ -246,6 +253,7 @@ bool SingboxManager::Stop() {
         }
 
         is_running_ = false;
+        PublishState(SingboxEvent::Kind::Stopped);
 
         if (stopped) {
             std::cout << "Sing-box stopped successfully" << std::endl;
@@ -274,9 +282,13 @@ void SingboxManager::Cleanup() {
         CloseHandle(process_handle_);
         process_handle_ = nullptr;
     }
+    JoinOutputReader();
 
     process_id_ = 0;
     is_initialized_ = false;
+
+    // What is queued reaches the subscribers before anything they use goes away
+    events_.Stop();
 }
 
 bool SingboxManager::IsRunning() const {
@@ -311,27 +323,56 @@ bool SingboxManager::StartSingboxProcess(const std::string& config_json) {
         // Build command line
         std::string command_line = "\"" + singbox_executable_path_ + "\" run -c \"" + config_file_path_ + "\"";
 
+        // Capture stdout/stderr so error lines can be categorized as they happen.
+        // Only the write end is inheritable; it is closed here once the child owns it.
+        SECURITY_ATTRIBUTES pipe_attributes = {};
+        pipe_attributes.nLength = sizeof(pipe_attributes);
+        pipe_attributes.bInheritHandle = TRUE;
+        HANDLE output_read = nullptr;
+        HANDLE output_write = nullptr;
+        if (!CreatePipe(&output_read, &output_write, &pipe_attributes, 0)) {
+            output_read = nullptr;
+            output_write = nullptr;
+            std::cerr << "Failed to create sing-box output pipe, continuing without capture" << std::endl;
+        } else {
+            SetHandleInformation(output_read, HANDLE_FLAG_INHERIT, 0);
+        }
+
         // Setup process creation
         STARTUPINFOA si = {};
         PROCESS_INFORMATION pi = {};
         si.cb = sizeof(si);
         si.dwFlags = STARTF_USESHOWWINDOW;
         si.wShowWindow = SW_HIDE; // Hide console window
+        if (output_write) {
+            si.dwFlags |= STARTF_USESTDHANDLES;
+            si.hStdInput = nullptr;
+            si.hStdOutput = output_write;
+            si.hStdError = output_write;
+        }
 
         // Create process
-        if (!CreateProcessA(
+        BOOL created = CreateProcessA(
             nullptr,
             const_cast<char*>(command_line.c_str()),
             nullptr,
             nullptr,
-            FALSE,
+            output_write ? TRUE : FALSE,
             CREATE_NO_WINDOW,
             nullptr,
             nullptr,
             &si,
-            &pi)) {
+            &pi);
+        DWORD system_error_code = created ? ERROR_SUCCESS : ::GetLastError();
+
+        if (output_write) {
+            CloseHandle(output_write);
+        }
+        if (!created) {
+            if (output_read) {
+                CloseHandle(output_read);
+            }
             
-            DWORD system_error_code = ::GetLastError();
             std::string error_msg = "Failed to create sing-box process. Error code: " + std::to_string(static_cast<unsigned long>(system_error_code));
             
             // Categorize the error
@@ -351,21 +392,23 @@ bool SingboxManager::StartSingboxProcess(const std::string& config_json) {
         process_id_ = pi.dwProcessId;
         CloseHandle(pi.hThread);
 
-        // Wait for the process to initialize with timeout
-        auto start_wait = std::chrono::steady_clock::now();
-        while (std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::steady_clock::now() - start_wait).count() < PROCESS_START_TIMEOUT_MS) {
-            
-            if (!IsSingboxProcessRunning()) {
-                SetError(SingboxError::ProcessCrashed, "Sing-box process exited during startup");
-                return false;
-            }
-            
-            Sleep(100); // Check every 100ms
+        if (output_read) {
+            JoinOutputReader(); // Reader of a previous, already exited process
+            output_thread_ = std::thread(&SingboxManager::OutputReaderLoop, this, output_read);
+        }
+
+        // Wait for the process to initialize with timeout; the handle is
+        // signaled the moment it exits, so there is nothing to poll
+        if (WaitForSingleObject(process_handle_, PROCESS_START_TIMEOUT_MS) == WAIT_OBJECT_0) {
+            // Drain the output first so the categorized cause is reported before the crash
+            JoinOutputReader();
+            SetError(SingboxError::ProcessCrashed, "Sing-box process exited during startup");
+            return false;
         }
 
         // Final check if process is still running
         if (!IsSingboxProcessRunning()) {
+            JoinOutputReader();
             SetError(SingboxError::ProcessCrashed, "Sing-box process failed to start properly");
             return false;
         }
@@ -402,6 +445,9 @@ bool SingboxManager::StopSingboxProcess() {
         process_handle_ = nullptr;
         process_id_ = 0;
 
+        // The pipe is closed now that the process is gone
+        JoinOutputReader();
+
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Exception stopping sing-box process: " << e.what() << std::endl;
@@ -525,10 +571,13 @@ void SingboxManager::StartStatisticsThread() {
     }
 
     stats_thread_running_ = true;
+    stats_gate_.Reset();
     stats_thread_ = std::thread([this]() {
         while (stats_thread_running_ && is_running_) {
             UpdateStatistics();
-            std::this_thread::sleep_for(std::chrono::milliseconds(STATS_UPDATE_INTERVAL_MS));
+            if (!stats_gate_.Wait(std::chrono::milliseconds(STATS_UPDATE_INTERVAL_MS))) {
+                break;
+            }
         }
     });
 }
@@ -536,6 +585,7 @@ void SingboxManager::StartStatisticsThread() {
 void SingboxManager::StopStatisticsThread() {
     if (stats_thread_running_) {
         stats_thread_running_ = false;
+        stats_gate_.Stop();
         if (stats_thread_.joinable()) {
             stats_thread_.join();
         }
@@ -572,25 +622,58 @@ std::string SingboxManager::GetLastErrorMessage() const {
     return last_error_message_;
 }
 
-void SingboxManager::SetProcessMonitorCallback(std::function<void(SingboxError, const std::string&)> callback) {
+void SingboxManager::SetProcessMonitorCallback(ErrorCallback callback) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
-    process_monitor_callback_ = callback;
+    if (process_monitor_subscription_ != 0) {
+        events_.Unsubscribe(process_monitor_subscription_);
+        process_monitor_subscription_ = 0;
+    }
+    if (callback) {
+        process_monitor_subscription_ = events_.Subscribe([callback](const SingboxEvent& event) {
+            if (event.kind == SingboxEvent::Kind::Error) {
+                callback(event.error, event.message, event.classification, event.from_output);
+            }
+        });
+    }
+}
+
+EventBus<SingboxEvent>::SubscriptionId SingboxManager::SubscribeEvents(EventHandler handler) {
+    return events_.Subscribe(std::move(handler));
+}
+
+void SingboxManager::UnsubscribeEvents(EventBus<SingboxEvent>::SubscriptionId id) {
+    events_.Unsubscribe(id);
 }
 
 void SingboxManager::SetError(SingboxError error, const std::string& message) {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    last_error_ = error;
-    last_error_message_ = message;
-    current_status_.last_error = error;
-    current_status_.error_message = message;
-    
-    // Notify callback if set
+    SetError(error, message, ErrorCategorizer::Default().Classify(message));
+}
+
+void SingboxManager::SetError(SingboxError error, const std::string& message,
+                              const ErrorClassification& classification, bool from_output) {
     {
-        std::lock_guard<std::mutex> callback_lock(callback_mutex_);
-        if (process_monitor_callback_) {
-            process_monitor_callback_(error, message);
-        }
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        last_error_ = error;
+        last_error_message_ = message;
+        current_status_.last_error = error;
+        current_status_.error_message = message;
     }
+
+    // The subscribers run on the bus's thread: GetStatus() and
+    // GetLastError() callers never wait on them, and they may call back in
+    SingboxEvent event;
+    event.kind = SingboxEvent::Kind::Error;
+    event.error = error;
+    event.message = message;
+    event.classification = classification;
+    event.from_output = from_output;
+    events_.Publish(std::move(event));
+}
+
+void SingboxManager::PublishState(SingboxEvent::Kind kind) {
+    SingboxEvent event;
+    event.kind = kind;
+    events_.Publish(std::move(event));
 }
 
 void SingboxManager::ClearError() {
@@ -677,14 +760,18 @@ bool SingboxManager::ValidateProtocolSupport(const std::string& config_json) con
 }
 
 void SingboxManager::MonitorProcess() {
-    while (monitor_thread_running_ && is_running_) {
-        if (!IsSingboxProcessRunning()) {
-            SetError(SingboxError::ProcessCrashed, "Sing-box process has crashed or exited unexpectedly");
-            is_running_ = false;
-            break;
-        }
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(PROCESS_MONITOR_INTERVAL_MS));
+    if (!process_handle_) {
+        return;
+    }
+    // Asleep until the process exits or StopProcessMonitorThread signals
+    HANDLE handles[] = {process_handle_, monitor_stop_event_};
+    DWORD wait_result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+    if (wait_result == WAIT_OBJECT_0 && monitor_thread_running_ && is_running_) {
+        SetError(SingboxError::ProcessCrashed, "Sing-box process has crashed or exited unexpectedly");
+        is_running_ = false;
+        PublishState(SingboxEvent::Kind::Stopped);
+        // The statistics thread ends now rather than after its interval
+        stats_gate_.Notify();
     }
 }
 
@@ -694,6 +781,7 @@ void SingboxManager::StartProcessMonitorThread() {
     }
     
     monitor_thread_running_ = true;
+    ResetEvent(monitor_stop_event_);
     monitor_thread_ = std::thread([this]() {
         MonitorProcess();
     });
@@ -702,6 +790,7 @@ void SingboxManager::StartProcessMonitorThread() {
 void SingboxManager::StopProcessMonitorThread() {
     if (monitor_thread_running_) {
         monitor_thread_running_ = false;
+        SetEvent(monitor_stop_event_);
         if (monitor_thread_.joinable()) {
             monitor_thread_.join();
         }
@@ -778,6 +867,141 @@ void SingboxManager::LogNativeOutput(const std::string& output, const std::strin
     }
 }
 
+namespace {
+
+SingboxError ErrorForCategory(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::Initialization:
+        case ErrorCategory::Tun:
+        case ErrorCategory::Library:
+            return SingboxError::InitializationFailed;
+        case ErrorCategory::Configuration:
+            return SingboxError::ConfigurationInvalid;
+        case ErrorCategory::Network:
+        case ErrorCategory::Timeout:
+        case ErrorCategory::Authentication:
+        case ErrorCategory::Protocol:
+            return SingboxError::NetworkError;
+        case ErrorCategory::Permission:
+            return SingboxError::PermissionDenied;
+        case ErrorCategory::Resource:
+            return SingboxError::ResourceExhausted;
+        case ErrorCategory::Crash:
+            return SingboxError::ProcessCrashed;
+        case ErrorCategory::Unknown:
+        default:
+            return SingboxError::UnknownError;
+    }
+}
+
+enum class LineLevel { Other, Error, Fatal };
+
+// sing-box prints "ERROR [id 3s] ...", "+0800 2024-05-01 12:00:00 ERROR ..." or
+// "FATAL[0000] ..." depending on the log settings; Go runtime panics carry no level
+LineLevel ErrorLineLevel(const std::string& line) {
+    size_t level_end = (std::min)(line.size(), static_cast<size_t>(48));
+    for (size_t i = 0; i + 5 <= level_end; ++i) {
+        if (line.compare(i, 5, "ERROR") == 0) {
+            return LineLevel::Error;
+        }
+        if (line.compare(i, 5, "FATAL") == 0) {
+            return LineLevel::Fatal;
+        }
+    }
+    if (line.compare(0, 6, "panic:") == 0 || line.compare(0, 12, "fatal error:") == 0) {
+        return LineLevel::Fatal;
+    }
+    return LineLevel::Other;
+}
+
+}  // namespace
+
+void SingboxManager::OutputReaderLoop(HANDLE read_pipe) {
+    char buffer[4096];
+    std::string pending;
+    DWORD bytes_read = 0;
+
+    // ReadFile fails with ERROR_BROKEN_PIPE once sing-box exits
+    while (ReadFile(read_pipe, buffer, sizeof(buffer), &bytes_read, nullptr) && bytes_read > 0) {
+        pending.append(buffer, bytes_read);
+        size_t start = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', start)) != std::string::npos) {
+            size_t end = newline;
+            if (end > start && pending[end - 1] == '\r') {
+                --end;
+            }
+            if (end > start) {
+                ProcessOutputLine(pending.substr(start, end - start));
+            }
+            start = newline + 1;
+        }
+        pending.erase(0, start);
+    }
+    if (!pending.empty()) {
+        ProcessOutputLine(pending);
+    }
+    CloseHandle(read_pipe);
+}
+
+void SingboxManager::ProcessOutputLine(const std::string& line) {
+    LogNativeOutput(line, "sing-box");
+    LineLevel level = ErrorLineLevel(line);
+    if (level == LineLevel::Other) {
+        return;
+    }
+
+    // One pass over the line decides category, severity and recoverability
+    ErrorClassification classification = ErrorCategorizer::Default().Classify(line);
+    if (!classification.IsMatched() && level == LineLevel::Error) {
+        // sing-box logs most per-connection failures at ERROR; one nothing recognises is one of those
+        classification.severity = ErrorSeverity::Warning;
+        classification.recoverable = true;
+    }
+    if (classification.severity <= ErrorSeverity::Warning) {
+        // Per-connection failures are expected on flaky networks; keep them for diagnostics only
+        LogDetailedError(std::string("sing-box ") + ErrorCategorizer::CategoryName(classification.category), line);
+        return;
+    }
+    // Reported, but the connection state follows the process, not its output
+    SetError(ErrorForCategory(classification.category), line, classification, true);
+}
+
+void SingboxManager::JoinOutputReader() {
+    if (output_thread_.joinable()) {
+        output_thread_.join();
+    }
+    // The process output is done; report bursts that are still being collapsed
+    FlushThrottledLogs();
+}
+
+void SingboxManager::FlushThrottledLogs() {
+    std::lock_guard<std::mutex> lock(logging_mutex_);
+    log_throttle_.Flush(SteadyNowMs(), true, [this](int level, const std::string&, const std::string& summary) {
+        WriteLogLocked(level, summary);
+    });
+}
+
+void SingboxManager::LogThrottled(int level, const std::string& module, const std::string& message) {
+    std::lock_guard<std::mutex> lock(logging_mutex_);
+    auto write = [this](int emitted_level, const std::string&, const std::string& summary) {
+        WriteLogLocked(emitted_level, summary);
+    };
+    if (log_throttle_.Submit(SteadyNowMs(), level, module, message, write)) {
+        WriteLogLocked(level, message);
+    }
+}
+
+void SingboxManager::WriteLogLocked(int level, const std::string& message) {
+    if (level >= ERROR_LOG_LEVEL) {
+        RecordErrorLocked(message);
+    } else if (level == WARN_LOG_LEVEL) {
+        std::cerr << message << std::endl;
+    } else {
+        std::cout << message << std::endl;
+    }
+}
+
 void SingboxManager::LogOperationTiming(const std::string& operation, long long start_time, bool success) {
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now().time_since_epoch()).count() - start_time;
@@ -805,10 +1029,21 @@ void SingboxManager::LogDetailedError(const std::string& operation, const std::s
         error_message += " | Config: " + config_info;
     }
     
-    std::cerr << error_message << std::endl;
-    
-    // Store in error history
+    // Repeats of the same error collapse into one summary instead of
+    // flooding stderr and evicting older entries from the error history
     std::lock_guard<std::mutex> lock(logging_mutex_);
+    auto record = [this](int level, const std::string&, const std::string& summary) {
+        WriteLogLocked(level, summary);
+    };
+    if (!log_throttle_.Submit(SteadyNowMs(), ERROR_LOG_LEVEL, operation, error_message, record)) {
+        return;
+    }
+    RecordErrorLocked(error_message);
+}
+
+void SingboxManager::RecordErrorLocked(const std::string& error_message) {
+    std::cerr << error_message << std::endl;
+
     auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
     
@@ -818,6 +1053,11 @@ void SingboxManager::LogDetailedError(const std::string& operation, const std::s
     }
 }
 
+int64_t SingboxManager::SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void SingboxManager::LogProcessLifecycle(const std::string& event, const std::string& message, 
                                        const std::map<std::string, std::string>& process_info) {
     std::string log_message = "Process lifecycle: " + event + " - " + message;
@@ -1204,6 +1444,10 @@ std::map<std::string, std::string> SingboxManager::GenerateDiagnosticReport() co
     // Add error history count
     std::lock_guard<std::mutex> lock(logging_mutex_);
     report["errorHistoryCount"] = std::to_string(error_history_.size());
+    const LogThrottle::Stats& throttle = log_throttle_.GetStats();
+    report["errorsCollapsed"] = std::to_string(throttle.collapsed);
+    report["errorsRateLimited"] = std::to_string(throttle.rate_limited);
+    report["errorSummaries"] = std::to_string(throttle.summaries);
     report["operationTimingsCount"] = std::to_string(operation_timings_.size());
     
     return report;
@@ -12,6 +12,11 @@
 #include <map>
 #include <chrono>
 
+#include "ErrorCategorizer.h"
+#include "EventBus.h"
+#include "LogThrottle.h"
+#include "WakeGate.h"
+
 struct NetworkStats {
     long long bytes_received;
     long long bytes_sent;
@@ -42,6 +47,16 @@ struct SingboxStatus {
     std::chrono::steady_clock::time_point start_time;
 };
 
+// What SingboxManager publishes: errors, and the process starting and stopping
+struct SingboxEvent {
+    enum class Kind { Error, Started, Stopped };
+    Kind kind = Kind::Error;
+    SingboxError error = SingboxError::None;
+    std::string message;
+    ErrorClassification classification;
+    bool from_output = false;   // An error line sing-box printed, not a process failure
+};
+
 class SingboxManager {
 public:
     SingboxManager();
@@ -57,6 +72,8 @@ public:
     bool IsRunning() const;
     SingboxStatus GetStatus() const;
     NetworkStats GetStatistics() const;
+    // Wakeups of the statistics thread, which exists only while running
+    WakeGate::Stats GetStatisticsWakeups() const { return stats_gate_.GetStats(); }
 
     // Configuration management
     bool ValidateConfiguration(const std::string& config_json) const;
@@ -66,8 +83,28 @@ public:
     SingboxError GetLastError() const;
     std::string GetLastErrorMessage() const;
 
-    // Process monitoring
-    void SetProcessMonitorCallback(std::function<void(SingboxError, const std::string&)> callback);
+    // Process monitoring; errors arrive with the categorizer's verdict for the message,
+    // and flagged when they only come from a line of sing-box output.
+    // Callbacks and subscribers run on the event bus's thread, never under the
+    // manager's locks, so they may call back into it.
+    using ErrorCallback =
+        std::function<void(SingboxError, const std::string&, const ErrorClassification&, bool from_output)>;
+    void SetProcessMonitorCallback(ErrorCallback callback);
+    using EventHandler = EventBus<SingboxEvent>::Handler;
+    EventBus<SingboxEvent>::SubscriptionId SubscribeEvents(EventHandler handler);
+    void UnsubscribeEvents(EventBus<SingboxEvent>::SubscriptionId id);
+    EventBus<SingboxEvent>::Stats GetEventStats() const { return events_.GetStats(); }
+
+    // Logging for the components around the manager (network detector,
+    // stats collector). Lines go through the same LogThrottle as the
+    // manager's own errors, so a retry loop on a flapping network collapses
+    // into summaries; ERROR_LOG_LEVEL lines also enter the error history.
+    static constexpr int INFO_LOG_LEVEL = 2;
+    static constexpr int WARN_LOG_LEVEL = 3;
+    static constexpr int ERROR_LOG_LEVEL = 4;
+    void LogThrottled(int level, const std::string& module, const std::string& message);
+    // Report bursts that are still being collapsed
+    void FlushThrottledLogs();
 
     // Enhanced logging and debugging methods
     static void SetDebugMode(bool enabled);
@@ -103,6 +140,11 @@ private:
     void StartProcessMonitorThread();
     void StopProcessMonitorThread();
 
+    // sing-box stdout/stderr capture
+    void OutputReaderLoop(HANDLE read_pipe);
+    void ProcessOutputLine(const std::string& line);
+    void JoinOutputReader();
+
     // Configuration file management
     std::string CreateConfigFile(const std::string& config_json);
     void CleanupConfigFile();
@@ -117,7 +159,10 @@ private:
 
     // Error handling
     void SetError(SingboxError error, const std::string& message);
+    void SetError(SingboxError error, const std::string& message, const ErrorClassification& classification,
+                  bool from_output = false);
     void ClearError();
+    void PublishState(SingboxEvent::Kind kind);
 
     // Member variables
     HANDLE process_handle_;
@@ -144,9 +189,13 @@ private:
     std::atomic<bool> monitor_thread_running_;
     std::thread stats_thread_;
     std::thread monitor_thread_;
+    std::thread output_thread_;
+    WakeGate stats_gate_{true};         // Stopped to end the statistics thread at once
+    HANDLE monitor_stop_event_;         // Manual reset; wakes the process monitor
     
-    // Callbacks
-    std::function<void(SingboxError, const std::string&)> process_monitor_callback_;
+    // Errors and state changes; published without blocking, delivered on the bus's thread
+    EventBus<SingboxEvent> events_;
+    EventBus<SingboxEvent>::SubscriptionId process_monitor_subscription_ = 0;  // Guarded by callback_mutex_
     mutable std::mutex callback_mutex_;
     
     // Initialization state
@@ -159,11 +208,15 @@ private:
     std::vector<std::string> error_history_;
     std::map<std::string, long long> operation_timings_;
     static constexpr size_t MAX_ERROR_HISTORY = 50;
+    LogThrottle log_throttle_;                  // Guarded by logging_mutex_
     
     // Private logging methods
     void LogOperationTiming(const std::string& operation, long long start_time, bool success = true);
     void LogDetailedError(const std::string& operation, const std::string& error, 
                          const std::string& native_error = "", const std::string& config_info = "");
+    void RecordErrorLocked(const std::string& error_message);
+    void WriteLogLocked(int level, const std::string& message);
+    static int64_t SteadyNowMs();
     void LogProcessLifecycle(const std::string& event, const std::string& message, 
                            const std::map<std::string, std::string>& process_info = {});
     void LogConfigurationValidation(const std::string& config_json, bool is_valid, 
@@ -173,7 +226,6 @@ private:
     static constexpr const char* SINGBOX_EXECUTABLE_NAME = "sing-box.exe";
     static constexpr const char* CONFIG_FILE_PREFIX = "singbox_config_";
     static constexpr int STATS_UPDATE_INTERVAL_MS = 1000;
-    static constexpr int PROCESS_MONITOR_INTERVAL_MS = 2000;
     static constexpr int PROCESS_START_TIMEOUT_MS = 10000;
 };
 
@@ -59,6 +59,7 @@ bool StatsCollector::Start(int interval_ms) {
     std::cout << "Starting statistics collection with interval: " << interval_ms << "ms" << std::endl;
     
     is_collecting_ = true;
+    collection_gate_.Reset();
     StartCollectionThread();
     
     return true;
@@ -73,7 +74,11 @@ void StatsCollector::Stop() {
     std::cout << "Stopping statistics collection" << std::endl;
     
     is_collecting_ = false;
+    collection_gate_.Stop();
     StopCollectionThread();
+    if (singbox_manager_) {
+        singbox_manager_->FlushThrottledLogs();
+    }
     
     // Clear cached data
     {
@@ -175,7 +180,13 @@ void StatsCollector::SetStatsCallback(std::function<void(const NetworkStats&)> c
 
 void StatsCollector::SetErrorCallback(std::function<void(const StatsCollectionErrorInfo&)> callback) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
-    error_callback_ = callback;
+    if (error_subscription_ != 0) {
+        error_events_.Unsubscribe(error_subscription_);
+        error_subscription_ = 0;
+    }
+    if (callback) {
+        error_subscription_ = error_events_.Subscribe(std::move(callback));
+    }
 }
 
 void StatsCollector::SetFlutterChannelCallback(std::function<void(const NetworkStats&)> flutter_callback) {
@@ -189,7 +200,7 @@ void StatsCollector::NotifyFlutterStatsUpdate(const NetworkStats& stats) {
         try {
             flutter_callback_(stats);
         } catch (const std::exception& e) {
-            std::cerr << "Error notifying Flutter about stats update: " << e.what() << std::endl;
+            Log(SingboxManager::WARN_LOG_LEVEL, std::string("Error notifying Flutter about stats update: ") + e.what());
         }
     }
 }
@@ -261,9 +272,13 @@ void StatsCollector::Cleanup() {
     {
         std::lock_guard<std::mutex> lock(callback_mutex_);
         stats_callback_ = nullptr;
-        error_callback_ = nullptr;
         flutter_callback_ = nullptr;
+        if (error_subscription_ != 0) {
+            error_events_.Unsubscribe(error_subscription_);
+            error_subscription_ = 0;
+        }
     }
+    error_events_.Stop();
     
     std::cout << "StatsCollector cleanup completed" << std::endl;
 }
@@ -282,13 +297,13 @@ void StatsCollector::CollectionThreadMain() {
                 HandleCollectionFailure(retry_count++);
             }
             
-            // Sleep for the specified interval
-            std::this_thread::sleep_for(std::chrono::milliseconds(collection_interval_ms_));
+            // Sleep for the specified interval, or until Stop()
+            collection_gate_.Wait(std::chrono::milliseconds(collection_interval_ms_));
             
         } catch (const std::exception& e) {
-            std::cerr << "Error in collection thread: " << e.what() << std::endl;
+            Log(SingboxManager::WARN_LOG_LEVEL, std::string("Error in collection thread: ") + e.what());
             HandleCollectionFailure(retry_count++);
-            std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS));
+            collection_gate_.Wait(std::chrono::milliseconds(RETRY_DELAY_MS));
         }
     }
     
@@ -309,7 +324,7 @@ bool StatsCollector::CollectStatsWithRetry() {
     for (int attempt = 0; attempt < MAX_RETRY_ATTEMPTS; ++attempt) {
         try {
             if (!singbox_manager_->IsRunning()) {
-                std::cout << "Sing-box not running, skipping stats collection" << std::endl;
+                Log(SingboxManager::INFO_LOG_LEVEL, "Sing-box not running, skipping stats collection");
                 return false;
             }
             
@@ -317,15 +332,16 @@ bool StatsCollector::CollectStatsWithRetry() {
             ProcessAndEmitStats(stats);
             
             if (attempt > 0) {
-                std::cout << "Successfully collected statistics on attempt " << (attempt + 1) << std::endl;
+                Log(SingboxManager::INFO_LOG_LEVEL, "Successfully collected statistics on attempt " + std::to_string(attempt + 1));
             }
             
             return true;
             
         } catch (const std::exception& e) {
-            std::cerr << "Failed to collect statistics on attempt " << (attempt + 1) << ": " << e.what() << std::endl;
-            if (attempt < MAX_RETRY_ATTEMPTS - 1) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS * (attempt + 1)));
+            Log(SingboxManager::WARN_LOG_LEVEL, "Failed to collect statistics on attempt " + std::to_string(attempt + 1) + ": " + e.what());
+            if (attempt < MAX_RETRY_ATTEMPTS - 1 &&
+                !collection_gate_.Wait(std::chrono::milliseconds(RETRY_DELAY_MS * (attempt + 1)))) {
+                return false;
             }
         }
     }
@@ -379,10 +395,10 @@ void StatsCollector::ProcessAndEmitStats(const NetworkStats& stats) {
         NotifyFlutterStatsUpdate(processed_stats);
         
         // Log statistics (verbose)
-        std::cout << "Emitted statistics: " << FormatStatsForLog(processed_stats) << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Emitted statistics: " + FormatStatsForLog(processed_stats));
         
     } catch (const std::exception& e) {
-        std::cerr << "Error processing statistics: " << e.what() << std::endl;
+        Log(SingboxManager::WARN_LOG_LEVEL, std::string("Error processing statistics: ") + e.what());
         SetError(StatsCollectionError::ProcessingError, "Processing failed: " + std::string(e.what()));
     }
 }
@@ -460,46 +476,42 @@ NetworkStats StatsCollector::CalculateSmoothedStats() const {
 
 void StatsCollector::HandleCollectionFailure(int retry_count) {
     if (retry_count >= MAX_RETRY_ATTEMPTS) {
-        std::cerr << "Max retry attempts reached, emitting error" << std::endl;
+        Log(SingboxManager::WARN_LOG_LEVEL, "Max retry attempts reached, emitting error");
         SetError(StatsCollectionError::MaxRetriesExceeded, "Max retry attempts exceeded", retry_count);
         // Wait longer before next attempt
-        std::this_thread::sleep_for(std::chrono::milliseconds(collection_interval_ms_));
+        collection_gate_.Wait(std::chrono::milliseconds(collection_interval_ms_));
     } else if (!singbox_manager_->IsRunning()) {
-        std::cout << "Sing-box not running, pausing collection" << std::endl;
+        Log(SingboxManager::INFO_LOG_LEVEL, "Sing-box not running, pausing collection");
         SetError(StatsCollectionError::SingboxNotRunning, "Sing-box is not running", retry_count);
         // Wait longer when not running
-        std::this_thread::sleep_for(std::chrono::milliseconds(collection_interval_ms_ * 2));
+        collection_gate_.Wait(std::chrono::milliseconds(collection_interval_ms_ * 2));
     } else {
-        std::cerr << "Collection failed, retry " << retry_count << std::endl;
+        Log(SingboxManager::WARN_LOG_LEVEL, "Collection failed, retry " + std::to_string(retry_count));
         SetError(StatsCollectionError::CollectionFailed, "Collection failed", retry_count);
     }
 }
 
 void StatsCollector::SetError(StatsCollectionError error, const std::string& message, int retry_count) {
-    std::lock_guard<std::mutex> lock(error_mutex_);
-    
-    last_error_ = error;
-    last_error_message_ = message;
-    
-    // Add to error history
     StatsCollectionErrorInfo error_info;
     error_info.error_type = error;
     error_info.message = message;
     error_info.timestamp = std::chrono::steady_clock::now();
     error_info.retry_count = retry_count;
-    
-    error_history_.push(error_info);
-    if (error_history_.size() > MAX_ERROR_HISTORY_SIZE) {
-        error_history_.pop();
-    }
-    
-    // Emit to callback
+
     {
-        std::lock_guard<std::mutex> callback_lock(callback_mutex_);
-        if (error_callback_) {
-            error_callback_(error_info);
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        last_error_ = error;
+        last_error_message_ = message;
+
+        // Add to error history
+        error_history_.push(error_info);
+        if (error_history_.size() > MAX_ERROR_HISTORY_SIZE) {
+            error_history_.pop();
         }
     }
+
+    // The subscriber runs on the bus's thread, outside error_mutex_
+    error_events_.Publish(std::move(error_info));
 }
 
 void StatsCollector::ClearError() {
@@ -508,6 +520,14 @@ void StatsCollector::ClearError() {
     last_error_message_.clear();
 }
 
+void StatsCollector::Log(int level, const std::string& message) const {
+    if (singbox_manager_) {
+        singbox_manager_->LogThrottled(level, "StatsCollector", message);
+        return;
+    }
+    (level >= SingboxManager::WARN_LOG_LEVEL ? std::cerr : std::cout) << message << std::endl;
+}
+
 std::string StatsCollector::FormatStatsForLog(const NetworkStats& stats) const {
     std::ostringstream oss;
     oss << "NetworkStats(↓" << FormatBytes(stats.bytes_received) 
@@ -12,7 +12,9 @@
 #include <chrono>
 #include <queue>
 #include <map>
+#include "EventBus.h"
 #include "SingboxManager.h"
+#include "WakeGate.h"
 
 enum class StatsCollectionError {
     None,
@@ -40,6 +42,8 @@ public:
     bool Start(int interval_ms = 1000);
     void Stop();
     bool IsCollecting() const;
+    // Wakeups of the collection thread, which exists only while collecting
+    WakeGate::Stats GetWakeupStats() const { return collection_gate_.GetStats(); }
 
     // Configuration
     void UpdateInterval(int interval_ms);
@@ -57,7 +61,9 @@ public:
 
     // Callbacks for real-time streaming
     void SetStatsCallback(std::function<void(const NetworkStats&)> callback);
+    // Runs on the error bus's thread, not under the collector's locks
     void SetErrorCallback(std::function<void(const StatsCollectionErrorInfo&)> callback);
+    EventBus<StatsCollectionErrorInfo>::Stats GetErrorEventStats() const { return error_events_.GetStats(); }
     
     // Flutter platform channel integration
     void SetFlutterChannelCallback(std::function<void(const NetworkStats&)> flutter_callback);
@@ -91,6 +97,9 @@ private:
     void SetError(StatsCollectionError error, const std::string& message, int retry_count = 0);
     void ClearError();
 
+    // Per-tick and retry logging, throttled by the manager's LogThrottle
+    void Log(int level, const std::string& message) const;
+
     // Utility methods
     std::string FormatStatsForLog(const NetworkStats& stats) const;
     std::string FormatBytes(long long bytes) const;
@@ -103,6 +112,7 @@ private:
     std::atomic<bool> is_collecting_;
     std::atomic<int> collection_interval_ms_;
     std::thread collection_thread_;
+    WakeGate collection_gate_{true};    // Every wait of the collection thread; Stop() ends them
     
     // Statistics storage
     mutable std::mutex stats_mutex_;
@@ -120,7 +130,8 @@ private:
     // Callbacks
     mutable std::mutex callback_mutex_;
     std::function<void(const NetworkStats&)> stats_callback_;
-    std::function<void(const StatsCollectionErrorInfo&)> error_callback_;
+    EventBus<StatsCollectionErrorInfo> error_events_;
+    EventBus<StatsCollectionErrorInfo>::SubscriptionId error_subscription_ = 0;  // Guarded by callback_mutex_
     std::function<void(const NetworkStats&)> flutter_callback_;
     
     // Collection parameters
@@ -0,0 +1,181 @@
+#ifndef STATUS_SNAPSHOT_H_
+#define STATUS_SNAPSHOT_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 64-bit FNV-1a over the inputs of a status section. Strings are length
+// prefixed so ("ab", "c") and ("a", "bc") differ.
+class StatusFingerprint {
+public:
+    StatusFingerprint& AddBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash_ = (hash_ ^ bytes[i]) * 0x100000001b3ull;
+        }
+        return *this;
+    }
+
+    StatusFingerprint& Add(const std::string& value) {
+        Add(static_cast<uint64_t>(value.size()));
+        return AddBytes(value.data(), value.size());
+    }
+
+    StatusFingerprint& Add(const char* value) {
+        return Add(std::string(value ? value : ""));
+    }
+
+    template <typename T>
+    StatusFingerprint& Add(T value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "fingerprint numbers, enums and strings");
+        return AddBytes(&value, sizeof(value));
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+// The sections of GetDetailedStatus (sing-box details, network, stats,
+// executor), each kept pre-encoded with a version.
+//
+// Every call fingerprints the inputs of each section, which costs far less
+// than building its nested map and encoding it; only a section whose
+// fingerprint changed is rebuilt, encoded once and given a new version.
+// The caller sends the versions it holds and receives only the sections
+// that moved past them, as the cached bytes.
+//
+// Versions come from one counter for all sections and start at 1, so 0
+// (or a missing entry) means "nothing cached". A section not refreshed
+// during a pass is dropped, as the old status left out what was absent.
+//
+// Free of platform types so the host build can test it. Not thread safe;
+// the plugins call it from the platform thread only.
+class StatusSnapshot {
+public:
+    using Bytes = std::vector<uint8_t>;
+    using EncodeFn = std::function<Bytes()>;
+    using Versions = std::map<std::string, uint64_t>;
+
+    struct Section {
+        uint64_t version = 0;
+        uint64_t fingerprint = 0;
+        std::shared_ptr<const Bytes> encoded;
+        uint64_t pass = 0;               // The last pass that refreshed it
+    };
+
+    struct Stats {
+        uint64_t passes = 0;
+        uint64_t full_passes = 0;        // Without known versions
+        uint64_t refreshes = 0;          // Sections checked
+        uint64_t encodes = 0;            // Of those, rebuilt and encoded
+        uint64_t sections_sent = 0;
+        uint64_t sections_skipped = 0;   // The caller had them already
+        uint64_t bytes_encoded = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_skipped = 0;
+        uint64_t last_pass_bytes = 0;    // Section bytes sent by the latest pass
+        uint64_t encode_total_us = 0;
+        uint64_t pass_total_us = 0;      // BeginPass to EndPass: fingerprints, encodes, diff
+        uint64_t pass_max_us = 0;
+        uint64_t last_pass_us = 0;
+    };
+
+    void BeginPass() {
+        pass_start_ = Clock::now();
+        pass_++;
+    }
+
+    // Bring section `name` up to date with its inputs
+    // @return The section's version
+    uint64_t Refresh(const std::string& name, uint64_t fingerprint, const EncodeFn& encode) {
+        stats_.refreshes++;
+        Section& section = sections_[name];
+        section.pass = pass_;
+        if (section.encoded && section.fingerprint == fingerprint) {
+            return section.version;
+        }
+        auto begin = Clock::now();
+        section.encoded = std::make_shared<const Bytes>(encode());
+        stats_.encode_total_us += ElapsedUs(begin);
+        stats_.encodes++;
+        stats_.bytes_encoded += section.encoded->size();
+        section.fingerprint = fingerprint;
+        section.version = ++last_version_;
+        return section.version;
+    }
+
+    // Finish the pass: the sections newer than `known`, or all of them
+    // when `known` is null
+    std::vector<std::pair<std::string, Section>> EndPass(const Versions* known) {
+        std::vector<std::pair<std::string, Section>> changed;
+        uint64_t bytes = 0;
+        for (auto it = sections_.begin(); it != sections_.end();) {
+            if (it->second.pass != pass_) {
+                it = sections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (const auto& entry : sections_) {
+            const Section& section = entry.second;
+            size_t size = section.encoded ? section.encoded->size() : 0;
+            auto held = known ? known->find(entry.first) : Versions::const_iterator();
+            if (known && held != known->end() && held->second == section.version) {
+                stats_.sections_skipped++;
+                stats_.bytes_skipped += size;
+                continue;
+            }
+            stats_.sections_sent++;
+            bytes += size;
+            changed.emplace_back(entry.first, section);
+        }
+        uint64_t elapsed = ElapsedUs(pass_start_);
+        stats_.passes++;
+        stats_.full_passes += known ? 0 : 1;
+        stats_.bytes_sent += bytes;
+        stats_.last_pass_bytes = bytes;
+        stats_.pass_total_us += elapsed;
+        stats_.last_pass_us = elapsed;
+        stats_.pass_max_us = elapsed > stats_.pass_max_us ? elapsed : stats_.pass_max_us;
+        return changed;
+    }
+
+    // Current version of every section
+    Versions GetVersions() const {
+        Versions versions;
+        for (const auto& entry : sections_) {
+            versions[entry.first] = entry.second.version;
+        }
+        return versions;
+    }
+
+    Stats GetStats() const { return stats_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t ElapsedUs(Clock::time_point since) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count());
+    }
+
+    std::map<std::string, Section> sections_;
+    uint64_t last_version_ = 0;
+    uint64_t pass_ = 0;
+    Clock::time_point pass_start_ = Clock::now();
+    Stats stats_;
+};
+
+#endif  // STATUS_SNAPSHOT_H_
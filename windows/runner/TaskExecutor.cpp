@@ -0,0 +1,211 @@
+#include "TaskExecutor.h"
+
+#include <algorithm>
+#include <utility>
+
+bool CancellationToken::IsCancelled() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->cancelled;
+}
+
+bool CancellationToken::WaitFor(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->cv.wait_for(lock, timeout, [this]() { return state_->cancelled; });
+    return !state_->cancelled;
+}
+
+void CancellationToken::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->cancelled = true;
+    }
+    state_->cv.notify_all();
+}
+
+TaskExecutor::TaskExecutor(Options options) {
+    serial_.capacity = options.serial_capacity;
+    parallel_.capacity = options.parallel_capacity;
+    serial_.stats.workers = 1;
+    parallel_.stats.workers = options.parallel_workers == 0 ? 1 : options.parallel_workers;
+    serial_.workers.emplace_back([this]() { WorkerLoop(serial_); });
+    for (size_t i = 0; i < parallel_.stats.workers; i++) {
+        parallel_.workers.emplace_back([this]() { WorkerLoop(parallel_); });
+    }
+}
+
+TaskExecutor::~TaskExecutor() {
+    Shutdown();
+}
+
+const char* TaskExecutor::ReasonName(CancelReason reason) {
+    switch (reason) {
+        case CancelReason::Superseded: return "superseded";
+        case CancelReason::Cancelled: return "cancelled";
+        case CancelReason::Rejected: return "rejected";
+        case CancelReason::Shutdown: return "shutdown";
+    }
+    return "unknown";
+}
+
+bool TaskExecutor::Submit(Lane lane_id, const std::string& key, TaskFn task, CancelFn cancelled) {
+    Dropped dropped;
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LaneState& lane = StateOf(lane_id);
+        lane.stats.submitted++;
+        if (!key.empty()) {
+            DropQueuedLocked(serial_, key, CancelReason::Superseded, &dropped);
+            DropQueuedLocked(parallel_, key, CancelReason::Superseded, &dropped);
+            for (LaneState* state : {&serial_, &parallel_}) {
+                for (auto& running : state->running) {
+                    if (running.key == key) {
+                        running.token.Cancel();
+                    }
+                }
+            }
+        }
+        if (stopping_) {
+            dropped.emplace_back(std::move(cancelled), CancelReason::Shutdown);
+        } else if (lane.queue.size() >= lane.capacity) {
+            lane.stats.rejected++;
+            dropped.emplace_back(std::move(cancelled), CancelReason::Rejected);
+        } else {
+            lane.queue.push_back(Item{key, std::move(task), std::move(cancelled), CancellationToken(), Clock::now()});
+            lane.stats.max_queued = (std::max)(lane.stats.max_queued, lane.queue.size());
+            lane.wake.notify_one();
+            accepted = true;
+        }
+    }
+    NotifyDropped(dropped);
+    return accepted;
+}
+
+size_t TaskExecutor::Cancel(const std::string& key) {
+    Dropped dropped;
+    size_t affected = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        affected += DropQueuedLocked(serial_, key, CancelReason::Cancelled, &dropped);
+        affected += DropQueuedLocked(parallel_, key, CancelReason::Cancelled, &dropped);
+        for (LaneState* lane : {&serial_, &parallel_}) {
+            for (auto& running : lane->running) {
+                if (running.key == key) {
+                    running.token.Cancel();
+                    affected++;
+                }
+            }
+        }
+    }
+    NotifyDropped(dropped);
+    return affected;
+}
+
+void TaskExecutor::Shutdown() {
+    Dropped dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        for (LaneState* lane : {&serial_, &parallel_}) {
+            for (auto& item : lane->queue) {
+                dropped.emplace_back(std::move(item.cancelled), CancelReason::Shutdown);
+            }
+            lane->queue.clear();
+            for (auto& running : lane->running) {
+                running.token.Cancel();
+            }
+            lane->wake.notify_all();
+        }
+    }
+    NotifyDropped(dropped);
+    for (LaneState* lane : {&serial_, &parallel_}) {
+        for (auto& worker : lane->workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+}
+
+TaskExecutor::LaneStats TaskExecutor::GetStats(Lane lane_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const LaneState& lane = StateOf(lane_id);
+    LaneStats stats = lane.stats;
+    stats.queued = lane.queue.size();
+    stats.running = lane.running.size();
+    return stats;
+}
+
+size_t TaskExecutor::DropQueuedLocked(LaneState& lane, const std::string& key, CancelReason reason,
+                                      Dropped* dropped) {
+    size_t count = 0;
+    for (auto it = lane.queue.begin(); it != lane.queue.end();) {
+        if (it->key != key) {
+            ++it;
+            continue;
+        }
+        if (reason == CancelReason::Superseded) {
+            lane.stats.superseded++;
+        } else {
+            lane.stats.cancelled++;
+        }
+        dropped->emplace_back(std::move(it->cancelled), reason);
+        it = lane.queue.erase(it);
+        count++;
+    }
+    return count;
+}
+
+void TaskExecutor::NotifyDropped(Dropped& dropped) {
+    for (auto& entry : dropped) {
+        if (entry.first) {
+            entry.first(entry.second);
+        }
+    }
+}
+
+void TaskExecutor::WorkerLoop(LaneState& lane) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        lane.wake.wait(lock, [this, &lane]() { return stopping_ || !lane.queue.empty(); });
+        if (lane.queue.empty()) {
+            return;  // Stopping
+        }
+        Item item = std::move(lane.queue.front());
+        lane.queue.pop_front();
+        auto started = Clock::now();
+        uint64_t waited = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(started - item.queued_at).count());
+        lane.stats.wait_total_us += waited;
+        lane.stats.wait_max_us = (std::max)(lane.stats.wait_max_us, waited);
+        uint64_t id = next_id_++;
+        lane.running.push_back(Running{id, item.key, item.token});
+        lock.unlock();
+
+        bool failed = false;
+        try {
+            item.task(item.token);
+        } catch (...) {
+            failed = true;
+        }
+
+        // Release captured state (method results, configs) before taking the lock
+        item.task = nullptr;
+        item.cancelled = nullptr;
+        uint64_t ran = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count());
+        lock.lock();
+        lane.running.erase(std::find_if(lane.running.begin(), lane.running.end(),
+                                        [id](const Running& running) { return running.id == id; }));
+        lane.stats.run_total_us += ran;
+        lane.stats.run_max_us = (std::max)(lane.stats.run_max_us, ran);
+        if (failed) {
+            lane.stats.failed++;
+        } else {
+            lane.stats.completed++;
+        }
+    }
+}
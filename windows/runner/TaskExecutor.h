@@ -0,0 +1,155 @@
+#ifndef TASK_EXECUTOR_H_
+#define TASK_EXECUTOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cancellation flag shared between a task and its executor. Copies refer to
+// the same flag.
+class CancellationToken {
+public:
+    CancellationToken() : state_(std::make_shared<State>()) {}
+
+    bool IsCancelled() const;
+
+    // Sleep up to `timeout`, waking early on cancellation; false if cancelled
+    bool WaitFor(std::chrono::milliseconds timeout) const;
+
+    void Cancel();
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool cancelled = false;
+    };
+    std::shared_ptr<State> state_;
+};
+
+// Bounded executor for the plugin's slow operations, replacing a detached
+// thread per call.
+//
+// The serial lane has one worker and runs lifecycle operations (connect,
+// disconnect, configuration updates, reconnection) strictly in submission
+// order, so rapid taps queue up instead of racing. The parallel lane runs
+// probes and I/O on a few workers. Both lanes have a fixed set of threads and
+// a bounded queue; a submission beyond it is rejected.
+//
+// A task submitted under a key supersedes the queued tasks of that key: they
+// are dropped without running and their cancel callback fires, so every
+// method call still gets a reply. A running task of the key has its token
+// cancelled and sees it at its next check or wait.
+//
+// Free of platform types so the host build can test it.
+class TaskExecutor {
+public:
+    enum class Lane { Serial, Parallel };
+
+    enum class CancelReason {
+        Superseded,     // A newer task of the same key was submitted
+        Cancelled,      // Cancel() for its key
+        Rejected,       // The lane's queue was full
+        Shutdown        // The executor stopped before the task ran
+    };
+
+    using TaskFn = std::function<void(const CancellationToken& token)>;
+    // Called instead of the task when it will not run; may run on the
+    // submitting thread, never under the executor's lock
+    using CancelFn = std::function<void(CancelReason reason)>;
+
+    struct Options {
+        size_t parallel_workers = 2;
+        size_t serial_capacity = 16;
+        size_t parallel_capacity = 64;
+    };
+
+    struct LaneStats {
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t failed = 0;        // Threw out of the task
+        uint64_t superseded = 0;
+        uint64_t cancelled = 0;
+        uint64_t rejected = 0;
+        size_t queued = 0;
+        size_t max_queued = 0;
+        size_t running = 0;
+        size_t workers = 0;
+        uint64_t wait_total_us = 0; // Time from submission to start
+        uint64_t wait_max_us = 0;
+        uint64_t run_total_us = 0;
+        uint64_t run_max_us = 0;
+    };
+
+    explicit TaskExecutor(Options options);
+    TaskExecutor() : TaskExecutor(Options()) {}
+    ~TaskExecutor();
+
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    // Queue `task` on `lane`; an empty key supersedes nothing
+    // @return false if rejected, after `cancelled` has been called
+    bool Submit(Lane lane, const std::string& key, TaskFn task, CancelFn cancelled = nullptr);
+
+    // Drop the queued tasks of `key` and cancel the running ones
+    // @return How many tasks were affected
+    size_t Cancel(const std::string& key);
+
+    // Stop accepting work, drop what is queued and wait for running tasks
+    void Shutdown();
+
+    LaneStats GetStats(Lane lane) const;
+
+    static const char* ReasonName(CancelReason reason);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Item {
+        std::string key;
+        TaskFn task;
+        CancelFn cancelled;
+        CancellationToken token;
+        Clock::time_point queued_at;
+    };
+
+    struct Running {
+        uint64_t id;
+        std::string key;
+        CancellationToken token;
+    };
+
+    struct LaneState {
+        std::deque<Item> queue;
+        std::vector<Running> running;
+        std::vector<std::thread> workers;
+        size_t capacity = 0;
+        LaneStats stats;
+        std::condition_variable wake;
+    };
+
+    using Dropped = std::vector<std::pair<CancelFn, CancelReason>>;
+
+    LaneState& StateOf(Lane lane) { return lane == Lane::Serial ? serial_ : parallel_; }
+    const LaneState& StateOf(Lane lane) const { return lane == Lane::Serial ? serial_ : parallel_; }
+    size_t DropQueuedLocked(LaneState& lane, const std::string& key, CancelReason reason, Dropped* dropped);
+    void WorkerLoop(LaneState& lane);
+    static void NotifyDropped(Dropped& dropped);
+
+    mutable std::mutex mutex_;
+    LaneState serial_;
+    LaneState parallel_;
+    uint64_t next_id_ = 1;
+    bool stopping_ = false;
+};
+
+#endif // TASK_EXECUTOR_H_
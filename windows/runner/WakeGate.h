@@ -0,0 +1,161 @@
+#ifndef WAKE_GATE_H_
+#define WAKE_GATE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// The wait of a background loop, so that the loop costs nothing while it
+// has no work.
+//
+// While the gate is active Wait() returns every `interval`, or earlier on
+// Notify(). While it is inactive Wait() parks on a condition variable with
+// no timeout: the thread stays asleep until SetActive(true), Notify() or
+// Stop() wakes it. Deactivating wakes a timed wait so the loop parks at
+// once instead of running one more round. After Stop() every Wait()
+// returns false; Reset() readies the gate for a new loop.
+//
+// Every return from the underlying wait counts as a wakeup. One that finds
+// the gate inactive with nothing changed (a spurious wakeup) is an idle
+// wakeup; a parked loop should have none.
+//
+// Free of platform types so the host build can test it. Thread safe.
+class WakeGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        bool active = false;
+        bool parked = false;            // A loop is waiting with no timeout
+        uint64_t wakeups = 0;
+        uint64_t idle_wakeups = 0;
+        uint64_t parks = 0;
+        uint64_t wakeups_last_minute = 0;
+        uint64_t idle_wakeups_last_minute = 0;
+    };
+
+    explicit WakeGate(bool active = false) : active_(active) {}
+
+    WakeGate(const WakeGate&) = delete;
+    WakeGate& operator=(const WakeGate&) = delete;
+
+    void SetActive(bool active) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_ == active) {
+            return;
+        }
+        active_ = active;
+        generation_++;
+        cv_.notify_all();
+    }
+
+    // Wake the loop for one round now, without changing its state
+    void Notify() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notified_ = true;
+        generation_++;
+        cv_.notify_all();
+    }
+
+    void Stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        generation_++;
+        cv_.notify_all();
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = false;
+        notified_ = false;
+    }
+
+    // Wait for the next round of the loop
+    // @return false once the gate is stopped
+    template <typename Rep, typename Period>
+    bool Wait(std::chrono::duration<Rep, Period> interval) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(interval);
+        while (!stopped_) {
+            if (notified_) {
+                notified_ = false;
+                return true;
+            }
+            uint64_t generation = generation_;
+            if (!active_) {
+                parked_ = true;
+                parks_++;
+                cv_.wait(lock);
+                parked_ = false;
+                RecordWakeup(!active_ && !stopped_ && generation == generation_);
+                if (active_) {
+                    // Woken by activation: run a round now
+                    return !stopped_;
+                }
+                continue;
+            }
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                RecordWakeup(false);
+                return !stopped_;
+            }
+            RecordWakeup(false);
+        }
+        return false;
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats;
+        stats.active = active_;
+        stats.parked = parked_;
+        stats.wakeups = wakeups_;
+        stats.idle_wakeups = idle_wakeups_;
+        stats.parks = parks_;
+        auto since = Clock::now() - std::chrono::minutes(1);
+        for (const Wakeup& wakeup : recent_) {
+            if (wakeup.at >= since) {
+                stats.wakeups_last_minute++;
+                stats.idle_wakeups_last_minute += wakeup.idle ? 1 : 0;
+            }
+        }
+        return stats;
+    }
+
+private:
+    struct Wakeup {
+        Clock::time_point at;
+        bool idle;
+    };
+
+    // Enough for one wakeup a second with room to spare; a busier loop
+    // under-reports its per-minute rate rather than growing
+    static constexpr size_t kMaxRecent = 256;
+
+    void RecordWakeup(bool idle) {
+        wakeups_++;
+        idle_wakeups_ += idle ? 1 : 0;
+        auto now = Clock::now();
+        while (!recent_.empty() &&
+               (recent_.size() >= kMaxRecent || recent_.front().at < now - std::chrono::minutes(1))) {
+            recent_.pop_front();
+        }
+        recent_.push_back(Wakeup{now, idle});
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool active_;
+    bool stopped_ = false;
+    bool notified_ = false;
+    bool parked_ = false;
+    uint64_t generation_ = 0;
+    uint64_t wakeups_ = 0;
+    uint64_t idle_wakeups_ = 0;
+    uint64_t parks_ = 0;
+    std::deque<Wakeup> recent_;
+};
+
+#endif  // WAKE_GATE_H_
@@ -13,10 +13,16 @@
 #include "SingboxManager.h"
 #include "StatsCollector.h"
 #include "NetworkChangeDetector.h"
+#include "PlatformDispatcher.h"
+#include "CreditFlow.h"
+#include "TaskExecutor.h"
+#include "StatusSnapshot.h"
+#include "WakeGate.h"
 #include <flutter/method_channel.h>
 #include <flutter/event_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
+#include <flutter/standard_message_codec.h>
 #include <memory>
 #include <string>
 #include <map>
@@ -32,11 +38,51 @@
 
 namespace {
 
+// Stands in for a method call's result on TaskExecutor workers: Flutter only
+// accepts replies on the platform thread, so each one hops there through the
+// dispatcher and completes the engine's result from there
+class PlatformThreadResult : public flutter::MethodResult<flutter::EncodableValue> {
+ public:
+  using ResultPtr = std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  PlatformThreadResult(PlatformDispatcher* dispatcher, ResultPtr result)
+      : dispatcher_(dispatcher), result_(std::make_shared<ResultPtr>(std::move(result))) {}
+
+ protected:
+  void SuccessInternal(const flutter::EncodableValue* value) override {
+    auto copy = value ? std::make_shared<flutter::EncodableValue>(*value) : nullptr;
+    dispatcher_->PostTask([result = result_, copy]() {
+      if (copy) {
+        (*result)->Success(*copy);
+      } else {
+        (*result)->Success();
+      }
+    });
+  }
+
+  void ErrorInternal(const std::string& code, const std::string& message,
+                     const flutter::EncodableValue* details) override {
+    auto copy = details ? std::make_shared<flutter::EncodableValue>(*details) : nullptr;
+    dispatcher_->PostTask([result = result_, code, message, copy]() {
+      (*result)->Error(code, message, copy.get());
+    });
+  }
+
+  void NotImplementedInternal() override {
+    dispatcher_->PostTask([result = result_]() { (*result)->NotImplemented(); });
+  }
+
+ private:
+  PlatformDispatcher* dispatcher_;
+  // Shared so the posted task can be copied into std::function
+  std::shared_ptr<ResultPtr> result_;
+};
+
 class VpnPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
 
-  VpnPlugin();
+  explicit VpnPlugin(flutter::PluginRegistrarWindows* registrar);
   virtual ~VpnPlugin();
 
  private:
@@ -54,7 +100,10 @@ class VpnPlugin : public flutter::Plugin {
   void GetRealTimeStats(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
   void StartStatsStream(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
   void StopStatsStream(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
-  void GetDetailedStatus(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void AckStats(const flutter::EncodableValue* arguments,
+                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void GetDetailedStatus(const flutter::EncodableValue* arguments,
+                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
   void HasVpnPermission(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
   void RequestVpnPermission(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
@@ -86,6 +135,9 @@ class VpnPlugin : public flutter::Plugin {
   bool StartVpnConnection(const flutter::EncodableMap& config);
   bool StopVpnConnection();
   void UpdateConnectionStatus();
+  // Sets is_connected_ and is_connecting_; the monitor runs only while
+  // either is set and is parked otherwise
+  void SetConnectionState(bool connected, bool connecting);
   void MonitorConnection();
   
   // Singbox integration
@@ -93,7 +145,9 @@ class VpnPlugin : public flutter::Plugin {
   void CleanupSingbox();
   bool StartSingboxCore(const std::string& config_json);
   bool StopSingboxCore();
-  void HandleSingboxError(SingboxError error, const std::string& message);
+  void HandleSingboxError(SingboxError error, const std::string& message,
+                          const ErrorClassification& classification = ErrorClassification(),
+                          bool from_output = false);
   
   // System tray integration
   void InitializeSystemTray();
@@ -121,16 +175,55 @@ class VpnPlugin : public flutter::Plugin {
   std::string TranslateErrorMessage(SingboxError error);
   std::string GetErrorSeverity(SingboxError error);
   bool IsErrorRecoverable(SingboxError error);
-  
+  std::string GetNativeErrorCode(SingboxError error);
+  
+  // Slow operations run on executor_ instead of a thread per call. Lifecycle
+  // operations share the serial lane under kLifecycleKey, so the newest tap
+  // supersedes the ones still queued; `operation` names the call in replies
+  // to superseded or rejected requests.
+  using MethodResultPtr = std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+  static constexpr const char* kLifecycleKey = "lifecycle";
+  void RunOnExecutor(TaskExecutor::Lane lane, const std::string& key, const std::string& operation,
+                     MethodResultPtr result,
+                     std::function<void(const CancellationToken&, MethodResultPtr)> task);
+  flutter::EncodableMap CreateExecutorStatsMap();
+  std::unique_ptr<TaskExecutor> executor_;
+
+  // Sections of getDetailedStatus, re-encoded only when their inputs change;
+  // guarded by status_mutex_
+  void RefreshStatusSections();
+  std::vector<uint8_t> EncodeStatusSection(const flutter::EncodableMap& section);
+  flutter::EncodableMap CreateStatusSnapshotMap();
+  StatusSnapshot status_snapshot_;
+
   // Real-time statistics streaming
   std::atomic<bool> stats_streaming_active_{false};
 
+  // "vpn_stats" event channel, flow-controlled by credits the listener returns
+  // through ackStats. The sink and the flow are only touched on the platform thread.
+  using StatsFlow = CreditFlow<flutter::EncodableValue>;
+  static constexpr const char* kStatsSampleRoute = "@statsSample";
+  void OnStatsListen(const flutter::EncodableValue* arguments,
+                     std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events);
+  void OnStatsCancel();
+  void EmitStatsEvent(const flutter::EncodableValue& sample, uint64_t skipped);
+  flutter::EncodableMap CreateStatsStreamMap();
+  std::atomic<bool> stats_listener_active_{false};
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> stats_sink_;
+  StatsFlow stats_flow_{[this](const flutter::EncodableValue& sample, uint64_t skipped) {
+    EmitStatsEvent(sample, skipped);
+  }};
+  uint64_t stats_event_seq_{0};
+
   // Member variables
   std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
   std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> status_channel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> stats_channel_;
+  // Every message to Dart from a background thread goes through here
+  std::unique_ptr<PlatformDispatcher> dispatcher_;
   std::atomic<bool> is_connected_{false};
   std::atomic<bool> is_connecting_{false};
-  std::atomic<bool> monitoring_active_{false};
+  WakeGate monitor_gate_;
   std::thread monitor_thread_;
   std::mutex status_mutex_;
   
@@ -166,32 +259,50 @@ class VpnPlugin : public flutter::Plugin {
 static VpnPlugin* g_plugin_instance = nullptr;
 
 void VpnPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
-  auto channel =
-      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
-          registrar->messenger(), "vpn_control",
-          &flutter::StandardMethodCodec::GetInstance());
-
-  // Create status event channel
-  auto status_channel =
-      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
-          registrar->messenger(), "vpn_status",
-          &flutter::StandardMethodCodec::GetInstance());
-
-  auto plugin = std::make_unique<VpnPlugin>();
+  auto plugin = std::make_unique<VpnPlugin>(registrar);
   
-  channel->SetMethodCallHandler(
+  plugin->channel_->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto& call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
 
-  plugin->channel_ = std::move(channel);
-  plugin->status_channel_ = std::move(status_channel);
   g_plugin_instance = plugin.get();
   
   registrar->AddPlugin(std::move(plugin));
 }
 
-VpnPlugin::VpnPlugin() {
+VpnPlugin::VpnPlugin(flutter::PluginRegistrarWindows* registrar) {
+  executor_ = std::make_unique<TaskExecutor>();
+  // Channels and the dispatcher exist before any thread below can post
+  channel_ = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      registrar->messenger(), "vpn_control",
+      &flutter::StandardMethodCodec::GetInstance());
+  status_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      registrar->messenger(), "vpn_status",
+      &flutter::StandardMethodCodec::GetInstance());
+  stats_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      registrar->messenger(), "vpn_stats",
+      &flutter::StandardMethodCodec::GetInstance());
+  dispatcher_ = std::make_unique<PlatformDispatcher>(registrar, channel_.get());
+  dispatcher_->Route(kStatsSampleRoute, [this](flutter::EncodableValue sample) {
+    if (stats_sink_) {
+      stats_flow_.Offer(std::move(sample));
+    }
+  });
+  stats_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            OnStatsListen(arguments, std::move(events));
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* /*arguments*/)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            OnStatsCancel();
+            return nullptr;
+          }));
+  
   // Initialize SingboxManager
   singbox_manager_ = std::make_unique<SingboxManager>();
   InitializeSingbox();
@@ -204,7 +315,7 @@ VpnPlugin::VpnPlugin() {
     
     // Set up Flutter callback for statistics updates
     stats_collector_->SetFlutterChannelCallback([this](const NetworkStats& stats) {
-      if (channel_) {
+      if (dispatcher_) {
         // Convert NetworkStats to Flutter-compatible map
         flutter::EncodableMap stats_map;
         stats_map[flutter::EncodableValue("bytesReceived")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes_received));
@@ -217,8 +328,7 @@ VpnPlugin::VpnPlugin() {
         stats_map[flutter::EncodableValue("timestamp")] = flutter::EncodableValue(static_cast<int64_t>(stats.timestamp));
         
         // Notify Flutter about statistics update
-        channel_->InvokeMethod("onStatsUpdate", 
-                              std::make_unique<flutter::EncodableValue>(stats_map));
+        dispatcher_->PostLatest("onStatsUpdate", flutter::EncodableValue(stats_map));
       }
     });
   }
@@ -226,10 +336,11 @@ VpnPlugin::VpnPlugin() {
   // Initialize NetworkChangeDetector
   if (singbox_manager_) {
     network_change_detector_ = std::make_unique<NetworkChangeDetector>(singbox_manager_.get());
+    network_change_detector_->SetExecutor(executor_.get());
     
     // Set up callbacks for network state changes
     network_change_detector_->SetNetworkStateCallback([this](NetworkState state) {
-      if (channel_) {
+      if (dispatcher_) {
         std::string state_str;
         switch (state) {
           case NetworkState::Disconnected: state_str = "disconnected"; break;
@@ -243,13 +354,12 @@ VpnPlugin::VpnPlugin() {
         flutter::EncodableMap network_state_map;
         network_state_map[flutter::EncodableValue("networkState")] = flutter::EncodableValue(state_str);
         
-        channel_->InvokeMethod("onNetworkStateChanged", 
-                              std::make_unique<flutter::EncodableValue>(network_state_map));
+        dispatcher_->PostLatest("onNetworkStateChanged", flutter::EncodableValue(network_state_map));
       }
     });
     
     network_change_detector_->SetConnectionHealthCallback([this](ConnectionHealth health) {
-      if (channel_) {
+      if (dispatcher_) {
         std::string health_str;
         switch (health) {
           case ConnectionHealth::Good: health_str = "good"; break;
@@ -261,13 +371,12 @@ VpnPlugin::VpnPlugin() {
         flutter::EncodableMap health_map;
         health_map[flutter::EncodableValue("connectionHealth")] = flutter::EncodableValue(health_str);
         
-        channel_->InvokeMethod("onConnectionHealthChanged", 
-                              std::make_unique<flutter::EncodableValue>(health_map));
+        dispatcher_->PostLatest("onConnectionHealthChanged", flutter::EncodableValue(health_map));
       }
     });
     
     network_change_detector_->SetReconnectionCallback([this](ReconnectionStatus status, int attempt_number) {
-      if (channel_) {
+      if (dispatcher_) {
         std::string status_str;
         switch (status) {
           case ReconnectionStatus::Idle: status_str = "idle"; break;
@@ -281,21 +390,21 @@ VpnPlugin::VpnPlugin() {
         reconnection_map[flutter::EncodableValue("reconnectionStatus")] = flutter::EncodableValue(status_str);
         reconnection_map[flutter::EncodableValue("attemptNumber")] = flutter::EncodableValue(attempt_number);
         
-        channel_->InvokeMethod("onReconnectionStatusChanged", 
-                              std::make_unique<flutter::EncodableValue>(reconnection_map));
+        dispatcher_->PostLatest("onReconnectionStatusChanged", flutter::EncodableValue(reconnection_map));
       }
     });
   }
   
   InitializeSystemTray();
   
-  // Start monitoring thread
-  monitoring_active_ = true;
+  // Start monitoring thread, parked until a connection starts
   monitor_thread_ = std::thread(&VpnPlugin::MonitorConnection, this);
 }
 
 VpnPlugin::~VpnPlugin() {
-  monitoring_active_ = false;
+  // Queued calls are answered, running ones finish before anything they use goes away
+  executor_->Shutdown();
+  monitor_gate_.Stop();
   if (monitor_thread_.joinable()) {
     monitor_thread_.join();
   }
@@ -349,8 +458,12 @@ void VpnPlugin::HandleMethodCall(
       StartStatsStream(std::move(result));
     } else if (method == "stopStatsStream") {
       StopStatsStream(std::move(result));
+    } else if (method == "ackStats") {
+      AckStats(method_call.arguments(), std::move(result));
+    } else if (method == "getStatsStreamInfo") {
+      result->Success(flutter::EncodableValue(CreateStatsStreamMap()));
     } else if (method == "getDetailedStatus") {
-      GetDetailedStatus(std::move(result));
+      GetDetailedStatus(method_call.arguments(), std::move(result));
     } else if (method == "hasVpnPermission") {
       HasVpnPermission(std::move(result));
     } else if (method == "requestVpnPermission") {
@@ -358,7 +471,10 @@ void VpnPlugin::HandleMethodCall(
     } else if (method == "validateConfiguration") {
       const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
       if (arguments) {
-        ValidateConfiguration(*arguments, std::move(result));
+        RunOnExecutor(TaskExecutor::Lane::Parallel, "", "validateConfiguration", std::move(result),
+                      [this, config = *arguments](const CancellationToken&, MethodResultPtr result) {
+                        ValidateConfiguration(config, std::move(result));
+                      });
       } else {
         result->Error("INVALID_ARGUMENTS", "Configuration map required",
                      flutter::EncodableValue(TranslateErrorCode(SingboxError::ConfigurationInvalid)));
@@ -392,7 +508,16 @@ void VpnPlugin::HandleMethodCall(
     } else if (method == "updateConfiguration") {
       const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
       if (arguments) {
-        UpdateConfiguration(*arguments, std::move(result));
+        // Only the newest update of a configuration matters
+        auto id_it = arguments->find(flutter::EncodableValue("id"));
+        std::string key = "config:";
+        if (id_it != arguments->end() && std::holds_alternative<std::string>(id_it->second)) {
+          key += std::get<std::string>(id_it->second);
+        }
+        RunOnExecutor(TaskExecutor::Lane::Serial, key, "updateConfiguration", std::move(result),
+                      [this, config = *arguments](const CancellationToken&, MethodResultPtr result) {
+                        UpdateConfiguration(config, std::move(result));
+                      });
       } else {
         result->Error("INVALID_ARGUMENTS", "Configuration map required",
                      flutter::EncodableValue(TranslateErrorCode(SingboxError::ConfigurationInvalid)));
@@ -400,7 +525,10 @@ void VpnPlugin::HandleMethodCall(
     } else if (method == "deleteAllConfigurations") {
       DeleteAllConfigurations(std::move(result));
     } else if (method == "isSecureStorageAvailable") {
-      IsSecureStorageAvailable(std::move(result));
+      RunOnExecutor(TaskExecutor::Lane::Parallel, "", "isSecureStorageAvailable", std::move(result),
+                    [this](const CancellationToken&, MethodResultPtr result) {
+                      IsSecureStorageAvailable(std::move(result));
+                    });
     } else if (method == "getStorageInfo") {
       GetStorageInfo(std::move(result));
     } else if (method == "saveSecureData") {
@@ -455,16 +583,27 @@ void VpnPlugin::Connect(const flutter::EncodableMap& config,
     }
   }
 
-  is_connecting_ = true;
-  last_error_.clear();
-
-  // Start connection in background thread
-  std::thread([this, config, result = std::move(result)]() mutable {
+  // Connecting now wins over a pending automatic reconnection
+  if (network_change_detector_) {
+    network_change_detector_->CancelReconnection();
+  }
+  RunOnExecutor(TaskExecutor::Lane::Serial, kLifecycleKey, "connect", std::move(result),
+                [this, config](const CancellationToken& token, MethodResultPtr result) {
+    if (token.IsCancelled()) {
+      result->Error("SUPERSEDED", "connect request superseded");
+      return;
+    }
+    // An earlier connect may have completed while this one was queued
+    if (is_connected_) {
+      result->Error("ALREADY_CONNECTED", "VPN is already connected or connecting");
+      return;
+    }
+    SetConnectionState(false, true);
+    last_error_.clear();
     bool success = StartVpnConnection(config);
     
     if (success) {
-      is_connected_ = true;
-      is_connecting_ = false;
+      SetConnectionState(true, false);
       connection_start_time_ = std::chrono::steady_clock::now();
       
       // Extract server info
@@ -475,29 +614,84 @@ void VpnPlugin::Connect(const flutter::EncodableMap& config,
       
       result->Success(flutter::EncodableValue(true));
     } else {
-      is_connecting_ = false;
+      SetConnectionState(false, false);
       result->Error("CONNECTION_FAILED", last_error_.empty() ? "Failed to establish VPN connection" : last_error_);
     }
-  }).detach();
+  });
 }
 
 void VpnPlugin::Disconnect(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  if (!is_connected_ && !is_connecting_) {
-    result->Success(flutter::EncodableValue(true));
-    return;
+  if (network_change_detector_) {
+    network_change_detector_->CancelReconnection();
   }
+  // Queued behind a connect in progress rather than racing it
+  RunOnExecutor(TaskExecutor::Lane::Serial, kLifecycleKey, "disconnect", std::move(result),
+                [this](const CancellationToken&, MethodResultPtr result) {
+    if (!is_connected_ && !is_connecting_) {
+      result->Success(flutter::EncodableValue(true));
+      return;
+    }
 
-  bool success = StopVpnConnection();
-  
-  if (success) {
-    is_connected_ = false;
-    is_connecting_ = false;
-    current_server_.clear();
-    last_error_.clear();
-    result->Success(flutter::EncodableValue(true));
-  } else {
-    result->Error("DISCONNECTION_FAILED", "Failed to disconnect VPN");
-  }
+    bool success = StopVpnConnection();
+    
+    if (success) {
+      SetConnectionState(false, false);
+      current_server_.clear();
+      last_error_.clear();
+      result->Success(flutter::EncodableValue(true));
+    } else {
+      result->Error("DISCONNECTION_FAILED", "Failed to disconnect VPN");
+    }
+  });
+}
+
+void VpnPlugin::RunOnExecutor(TaskExecutor::Lane lane, const std::string& key, const std::string& operation,
+                              MethodResultPtr result,
+                              std::function<void(const CancellationToken&, MethodResultPtr)> task) {
+  // Exactly one of the task and the cancel callback runs and takes the
+  // result; both run on workers, so the reply is sent from the platform thread
+  auto holder = std::make_shared<MethodResultPtr>(
+      std::make_unique<PlatformThreadResult>(dispatcher_.get(), std::move(result)));
+  executor_->Submit(lane, key,
+      [holder, task = std::move(task)](const CancellationToken& token) {
+        task(token, std::move(*holder));
+      },
+      [holder, operation](TaskExecutor::CancelReason reason) {
+        const char* code = "CANCELLED";
+        switch (reason) {
+          case TaskExecutor::CancelReason::Superseded: code = "SUPERSEDED"; break;
+          case TaskExecutor::CancelReason::Rejected: code = "BUSY"; break;
+          case TaskExecutor::CancelReason::Shutdown: code = "SHUTTING_DOWN"; break;
+          default: break;
+        }
+        (*holder)->Error(code, operation + " request " + TaskExecutor::ReasonName(reason));
+      });
+}
+
+flutter::EncodableMap VpnPlugin::CreateExecutorStatsMap() {
+  flutter::EncodableMap executor;
+  for (auto lane : {TaskExecutor::Lane::Serial, TaskExecutor::Lane::Parallel}) {
+    TaskExecutor::LaneStats stats = executor_->GetStats(lane);
+    flutter::EncodableMap lane_map;
+    lane_map[flutter::EncodableValue("workers")] = flutter::EncodableValue(static_cast<int64_t>(stats.workers));
+    lane_map[flutter::EncodableValue("queued")] = flutter::EncodableValue(static_cast<int64_t>(stats.queued));
+    lane_map[flutter::EncodableValue("maxQueued")] = flutter::EncodableValue(static_cast<int64_t>(stats.max_queued));
+    lane_map[flutter::EncodableValue("running")] = flutter::EncodableValue(static_cast<int64_t>(stats.running));
+    lane_map[flutter::EncodableValue("submitted")] = flutter::EncodableValue(static_cast<int64_t>(stats.submitted));
+    lane_map[flutter::EncodableValue("completed")] = flutter::EncodableValue(static_cast<int64_t>(stats.completed));
+    lane_map[flutter::EncodableValue("failed")] = flutter::EncodableValue(static_cast<int64_t>(stats.failed));
+    lane_map[flutter::EncodableValue("superseded")] = flutter::EncodableValue(static_cast<int64_t>(stats.superseded));
+    lane_map[flutter::EncodableValue("cancelled")] = flutter::EncodableValue(static_cast<int64_t>(stats.cancelled));
+    lane_map[flutter::EncodableValue("rejected")] = flutter::EncodableValue(static_cast<int64_t>(stats.rejected));
+    uint64_t started = stats.completed + stats.failed + stats.running;
+    lane_map[flutter::EncodableValue("queueWaitAvgMs")] = flutter::EncodableValue(
+        started ? static_cast<double>(stats.wait_total_us) / 1000.0 / static_cast<double>(started) : 0.0);
+    lane_map[flutter::EncodableValue("queueWaitMaxMs")] = flutter::EncodableValue(static_cast<double>(stats.wait_max_us) / 1000.0);
+    lane_map[flutter::EncodableValue("runMaxMs")] = flutter::EncodableValue(static_cast<double>(stats.run_max_us) / 1000.0);
+    executor[flutter::EncodableValue(lane == TaskExecutor::Lane::Serial ? "serial" : "parallel")] =
+        flutter::EncodableValue(lane_map);
+  }
+  return executor;
 }
 
 void VpnPlugin::GetStatus(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
@@ -642,57 +836,143 @@ void VpnPlugin::StopStatsStream(std::unique_ptr<flutter::MethodResult<flutter::E
   }
 }
 
-void VpnPlugin::GetDetailedStatus(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  std::lock_guard<std::mutex> lock(status_mutex_);
-  
-  try {
-    flutter::EncodableMap detailed_status = CreateStatusMap();
-    
-    // Add sing-box specific detailed information
-    if (singbox_manager_) {
-      SingboxStatus singbox_status = singbox_manager_->GetStatus();
-      
+void VpnPlugin::OnStatsListen(const flutter::EncodableValue* arguments,
+                              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events) {
+  uint32_t window = StatsFlow::kDefaultWindow;
+  StatsFlow::Policy policy = StatsFlow::Policy::Coalesce;
+  const auto* options = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (options) {
+    auto it = options->find(flutter::EncodableValue("window"));
+    if (it != options->end() && std::holds_alternative<int32_t>(it->second)) {
+      window = static_cast<uint32_t>((std::max)(1, std::get<int32_t>(it->second)));
+    }
+    it = options->find(flutter::EncodableValue("policy"));
+    if (it != options->end() && std::holds_alternative<std::string>(it->second) &&
+        std::get<std::string>(it->second) == "drop") {
+      policy = StatsFlow::Policy::Drop;
+    }
+  }
+  stats_flow_.Reset(window, policy);
+  stats_sink_ = std::move(events);
+  stats_listener_active_ = true;
+}
+
+void VpnPlugin::OnStatsCancel() {
+  stats_listener_active_ = false;
+  stats_sink_.reset();
+}
+
+void VpnPlugin::EmitStatsEvent(const flutter::EncodableValue& sample, uint64_t skipped) {
+  if (!stats_sink_) {
+    return;
+  }
+  flutter::EncodableMap event;
+  if (const auto* stats = std::get_if<flutter::EncodableMap>(&sample)) {
+    event = *stats;
+  }
+  event[flutter::EncodableValue("seq")] = flutter::EncodableValue(static_cast<int64_t>(++stats_event_seq_));
+  event[flutter::EncodableValue("skipped")] = flutter::EncodableValue(static_cast<int64_t>(skipped));
+  stats_sink_->Success(flutter::EncodableValue(event));
+}
+
+void VpnPlugin::AckStats(const flutter::EncodableValue* arguments,
+                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  int32_t count = 1;
+  const auto* options = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (options) {
+    auto it = options->find(flutter::EncodableValue("count"));
+    if (it != options->end() && std::holds_alternative<int32_t>(it->second)) {
+      count = std::get<int32_t>(it->second);
+    }
+  }
+  if (count > 0) {
+    stats_flow_.Ack(static_cast<uint32_t>(count));
+  }
+  result->Success(flutter::EncodableValue(static_cast<int64_t>(stats_flow_.GetStats().credits)));
+}
+
+flutter::EncodableMap VpnPlugin::CreateStatsStreamMap() {
+  StatsFlow::Stats flow = stats_flow_.GetStats();
+  flutter::EncodableMap info;
+  info[flutter::EncodableValue("listening")] = flutter::EncodableValue(stats_listener_active_.load());
+  info[flutter::EncodableValue("policy")] = flutter::EncodableValue(
+      std::string(stats_flow_.policy() == StatsFlow::Policy::Drop ? "drop" : "coalesce"));
+  info[flutter::EncodableValue("window")] = flutter::EncodableValue(static_cast<int64_t>(flow.window));
+  info[flutter::EncodableValue("credits")] = flutter::EncodableValue(static_cast<int64_t>(flow.credits));
+  // Sent and unacknowledged plus the sample held back for a credit
+  info[flutter::EncodableValue("queueDepth")] =
+      flutter::EncodableValue(static_cast<int64_t>(flow.in_flight + (flow.held ? 1 : 0)));
+  info[flutter::EncodableValue("offered")] = flutter::EncodableValue(static_cast<int64_t>(flow.offered));
+  info[flutter::EncodableValue("sent")] = flutter::EncodableValue(static_cast<int64_t>(flow.sent));
+  info[flutter::EncodableValue("acked")] = flutter::EncodableValue(static_cast<int64_t>(flow.acked));
+  info[flutter::EncodableValue("coalesced")] = flutter::EncodableValue(static_cast<int64_t>(flow.coalesced));
+  info[flutter::EncodableValue("dropped")] = flutter::EncodableValue(static_cast<int64_t>(flow.dropped));
+  return info;
+}
+
+std::vector<uint8_t> VpnPlugin::EncodeStatusSection(const flutter::EncodableMap& section) {
+  auto encoded = flutter::StandardMessageCodec::GetInstance().EncodeMessage(flutter::EncodableValue(section));
+  return encoded ? std::move(*encoded) : std::vector<uint8_t>();
+}
+
+void VpnPlugin::RefreshStatusSections() {
+  if (singbox_manager_) {
+    SingboxStatus singbox_status = singbox_manager_->GetStatus();
+    auto error_history = singbox_manager_->GetErrorHistory();
+    auto timings = singbox_manager_->GetOperationTimings();
+    StatusFingerprint fingerprint;
+    fingerprint.Add(singbox_status.is_running).Add(singbox_status.last_error).Add(singbox_status.error_message);
+    for (const auto& error : error_history) {
+      fingerprint.Add(error);
+    }
+    for (const auto& pair : timings) {
+      fingerprint.Add(pair.first).Add(pair.second);
+    }
+    status_snapshot_.Refresh("singboxDetails", fingerprint.value(), [&]() {
       flutter::EncodableMap singbox_details;
       singbox_details[flutter::EncodableValue("isRunning")] = flutter::EncodableValue(singbox_status.is_running);
       singbox_details[flutter::EncodableValue("lastError")] = flutter::EncodableValue(static_cast<int>(singbox_status.last_error));
       singbox_details[flutter::EncodableValue("lastErrorMessage")] = flutter::EncodableValue(singbox_status.error_message);
       singbox_details[flutter::EncodableValue("translatedErrorCode")] = flutter::EncodableValue(TranslateErrorCode(singbox_status.last_error));
       singbox_details[flutter::EncodableValue("translatedErrorMessage")] = flutter::EncodableValue(TranslateErrorMessage(singbox_status.last_error));
-      
-      // Add error history if available
-      auto error_history = singbox_manager_->GetErrorHistory();
+
       flutter::EncodableList error_list;
       for (const auto& error : error_history) {
         error_list.push_back(flutter::EncodableValue(error));
       }
       singbox_details[flutter::EncodableValue("errorHistory")] = flutter::EncodableValue(error_list);
-      
-      // Add operation timings for performance monitoring
-      auto timings = singbox_manager_->GetOperationTimings();
+
+      // Operation timings for performance monitoring
       flutter::EncodableMap timings_map;
       for (const auto& pair : timings) {
         timings_map[flutter::EncodableValue(pair.first)] = flutter::EncodableValue(static_cast<int64_t>(pair.second));
       }
       singbox_details[flutter::EncodableValue("operationTimings")] = flutter::EncodableValue(timings_map);
-      
-      detailed_status[flutter::EncodableValue("singboxDetails")] = flutter::EncodableValue(singbox_details);
+      return EncodeStatusSection(singbox_details);
+    });
+  }
+
+  if (network_change_detector_ && network_change_detector_->IsMonitoring()) {
+    NetworkState network_state = network_change_detector_->GetNetworkState();
+    ConnectionHealth connection_health = network_change_detector_->GetConnectionHealth();
+    ReconnectionStatus reconnection_status = network_change_detector_->GetReconnectionStatus();
+    int attempts = network_change_detector_->GetTotalReconnectionAttempts();
+    auto network_interfaces = network_change_detector_->GetNetworkInterfaces();
+    StatusFingerprint fingerprint;
+    fingerprint.Add(network_state).Add(connection_health).Add(reconnection_status).Add(attempts);
+    for (const auto& interface : network_interfaces) {
+      fingerprint.Add(interface.adapter_name).Add(interface.adapter_description)
+          .Add(interface.is_connected).Add(interface.has_internet).Add(interface.is_wifi)
+          .Add(interface.is_ethernet).Add(interface.ip_address).Add(interface.gateway)
+          .Add(interface.link_speed);
     }
-    
-    // Add network change detector information
-    if (network_change_detector_ && network_change_detector_->IsMonitoring()) {
+    status_snapshot_.Refresh("networkDetails", fingerprint.value(), [&]() {
       flutter::EncodableMap network_details;
-      
-      NetworkState network_state = network_change_detector_->GetNetworkState();
-      ConnectionHealth connection_health = network_change_detector_->GetConnectionHealth();
-      ReconnectionStatus reconnection_status = network_change_detector_->GetReconnectionStatus();
-      
       network_details[flutter::EncodableValue("networkState")] = flutter::EncodableValue(static_cast<int>(network_state));
       network_details[flutter::EncodableValue("connectionHealth")] = flutter::EncodableValue(static_cast<int>(connection_health));
       network_details[flutter::EncodableValue("reconnectionStatus")] = flutter::EncodableValue(static_cast<int>(reconnection_status));
-      network_details[flutter::EncodableValue("totalReconnectionAttempts")] = flutter::EncodableValue(network_change_detector_->GetTotalReconnectionAttempts());
-      
-      // Add network interfaces information
-      auto network_interfaces = network_change_detector_->GetNetworkInterfaces();
+      network_details[flutter::EncodableValue("totalReconnectionAttempts")] = flutter::EncodableValue(attempts);
+
       flutter::EncodableList interfaces_list;
       for (const auto& interface : network_interfaces) {
         flutter::EncodableMap interface_map;
@@ -708,26 +988,212 @@ void VpnPlugin::GetDetailedStatus(std::unique_ptr<flutter::MethodResult<flutter:
         interfaces_list.push_back(flutter::EncodableValue(interface_map));
       }
       network_details[flutter::EncodableValue("networkInterfaces")] = flutter::EncodableValue(interfaces_list);
-      
-      detailed_status[flutter::EncodableValue("networkDetails")] = flutter::EncodableValue(network_details);
-    }
-    
-    // Add statistics collector information
-    if (stats_collector_) {
+      return EncodeStatusSection(network_details);
+    });
+  }
+
+  if (stats_collector_) {
+    bool collecting = stats_collector_->IsCollecting();
+    int interval = stats_collector_->GetInterval();
+    bool streaming = stats_streaming_active_.load();
+    StatsFlow::Stats flow = stats_flow_.GetStats();
+    StatsCollectionError stats_error = stats_collector_->GetLastError();
+    std::string stats_error_message =
+        stats_error != StatsCollectionError::None ? stats_collector_->GetLastErrorMessage() : std::string();
+    StatusFingerprint fingerprint;
+    fingerprint.Add(collecting).Add(interval).Add(streaming).Add(stats_listener_active_.load())
+        .Add(stats_flow_.policy()).Add(flow.window).Add(flow.credits).Add(flow.in_flight).Add(flow.held)
+        .Add(flow.offered).Add(flow.sent).Add(flow.acked).Add(flow.coalesced).Add(flow.dropped)
+        .Add(stats_error).Add(stats_error_message);
+    status_snapshot_.Refresh("statsDetails", fingerprint.value(), [&]() {
       flutter::EncodableMap stats_details;
-      stats_details[flutter::EncodableValue("isCollecting")] = flutter::EncodableValue(stats_collector_->IsCollecting());
-      stats_details[flutter::EncodableValue("interval")] = flutter::EncodableValue(stats_collector_->GetInterval());
-      stats_details[flutter::EncodableValue("streamingActive")] = flutter::EncodableValue(stats_streaming_active_.load());
-      
-      // Add error information from stats collector
-      auto stats_error = stats_collector_->GetLastError();
+      stats_details[flutter::EncodableValue("isCollecting")] = flutter::EncodableValue(collecting);
+      stats_details[flutter::EncodableValue("interval")] = flutter::EncodableValue(interval);
+      stats_details[flutter::EncodableValue("streamingActive")] = flutter::EncodableValue(streaming);
+      stats_details[flutter::EncodableValue("stream")] = flutter::EncodableValue(CreateStatsStreamMap());
       if (stats_error != StatsCollectionError::None) {
         stats_details[flutter::EncodableValue("lastError")] = flutter::EncodableValue(static_cast<int>(stats_error));
-        stats_details[flutter::EncodableValue("lastErrorMessage")] = flutter::EncodableValue(stats_collector_->GetLastErrorMessage());
+        stats_details[flutter::EncodableValue("lastErrorMessage")] = flutter::EncodableValue(stats_error_message);
+      }
+      return EncodeStatusSection(stats_details);
+    });
+  }
+
+  StatusFingerprint fingerprint;
+  for (auto lane : {TaskExecutor::Lane::Serial, TaskExecutor::Lane::Parallel}) {
+    TaskExecutor::LaneStats stats = executor_->GetStats(lane);
+    fingerprint.Add(stats.workers).Add(stats.queued).Add(stats.max_queued).Add(stats.running)
+        .Add(stats.submitted).Add(stats.completed).Add(stats.failed).Add(stats.superseded)
+        .Add(stats.cancelled).Add(stats.rejected);
+  }
+  status_snapshot_.Refresh("executor", fingerprint.value(), [&]() {
+    return EncodeStatusSection(CreateExecutorStatsMap());
+  });
+
+  // Background loops; while disconnected only parked threads remain
+  std::vector<std::pair<const char*, WakeGate::Stats>> loops;
+  loops.emplace_back("connectionMonitor", monitor_gate_.GetStats());
+  if (singbox_manager_) {
+    loops.emplace_back("singboxStats", singbox_manager_->GetStatisticsWakeups());
+  }
+  if (stats_collector_) {
+    loops.emplace_back("statsCollector", stats_collector_->GetWakeupStats());
+  }
+  if (network_change_detector_) {
+    loops.emplace_back("networkHealth", network_change_detector_->GetHealthWakeupStats());
+  }
+  StatusFingerprint wakeup_fingerprint;
+  for (const auto& loop : loops) {
+    const WakeGate::Stats& stats = loop.second;
+    wakeup_fingerprint.Add(loop.first).Add(stats.active).Add(stats.parked).Add(stats.wakeups)
+        .Add(stats.idle_wakeups).Add(stats.parks).Add(stats.wakeups_last_minute)
+        .Add(stats.idle_wakeups_last_minute);
+  }
+  status_snapshot_.Refresh("wakeups", wakeup_fingerprint.value(), [&]() {
+    flutter::EncodableMap wakeups;
+    flutter::EncodableMap loop_maps;
+    int64_t per_minute = 0;
+    int64_t idle_per_minute = 0;
+    for (const auto& loop : loops) {
+      const WakeGate::Stats& stats = loop.second;
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("active")] = flutter::EncodableValue(stats.active);
+      map[flutter::EncodableValue("parked")] = flutter::EncodableValue(stats.parked);
+      map[flutter::EncodableValue("wakeups")] = flutter::EncodableValue(static_cast<int64_t>(stats.wakeups));
+      map[flutter::EncodableValue("idleWakeups")] = flutter::EncodableValue(static_cast<int64_t>(stats.idle_wakeups));
+      map[flutter::EncodableValue("parks")] = flutter::EncodableValue(static_cast<int64_t>(stats.parks));
+      map[flutter::EncodableValue("wakeupsPerMinute")] =
+          flutter::EncodableValue(static_cast<int64_t>(stats.wakeups_last_minute));
+      map[flutter::EncodableValue("idleWakeupsPerMinute")] =
+          flutter::EncodableValue(static_cast<int64_t>(stats.idle_wakeups_last_minute));
+      loop_maps[flutter::EncodableValue(loop.first)] = flutter::EncodableValue(map);
+      per_minute += static_cast<int64_t>(stats.wakeups_last_minute);
+      idle_per_minute += static_cast<int64_t>(stats.idle_wakeups_last_minute);
+    }
+    wakeups[flutter::EncodableValue("wakeupsPerMinute")] = flutter::EncodableValue(per_minute);
+    wakeups[flutter::EncodableValue("idleWakeupsPerMinute")] = flutter::EncodableValue(idle_per_minute);
+    wakeups[flutter::EncodableValue("loops")] = flutter::EncodableValue(loop_maps);
+    return EncodeStatusSection(wakeups);
+  });
+
+  // Error and state buses; handlers run on their threads, not the publishers'
+  std::vector<std::pair<const char*, EventBusStats>> buses;
+  if (singbox_manager_) {
+    buses.emplace_back("singbox", singbox_manager_->GetEventStats());
+  }
+  if (stats_collector_) {
+    buses.emplace_back("statsCollector", stats_collector_->GetErrorEventStats());
+  }
+  StatusFingerprint event_fingerprint;
+  for (const auto& bus : buses) {
+    const EventBusStats& stats = bus.second;
+    event_fingerprint.Add(bus.first).Add(stats.running).Add(stats.subscribers).Add(stats.published)
+        .Add(stats.delivered).Add(stats.dropped).Add(stats.handler_failures).Add(stats.max_depth)
+        .Add(stats.latency_max_us).Add(stats.handler_max_us);
+  }
+  status_snapshot_.Refresh("events", event_fingerprint.value(), [&]() {
+    flutter::EncodableMap events;
+    for (const auto& bus : buses) {
+      const EventBusStats& stats = bus.second;
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("running")] = flutter::EncodableValue(stats.running);
+      map[flutter::EncodableValue("subscribers")] = flutter::EncodableValue(static_cast<int64_t>(stats.subscribers));
+      map[flutter::EncodableValue("published")] = flutter::EncodableValue(static_cast<int64_t>(stats.published));
+      map[flutter::EncodableValue("delivered")] = flutter::EncodableValue(static_cast<int64_t>(stats.delivered));
+      map[flutter::EncodableValue("dropped")] = flutter::EncodableValue(static_cast<int64_t>(stats.dropped));
+      map[flutter::EncodableValue("handlerFailures")] =
+          flutter::EncodableValue(static_cast<int64_t>(stats.handler_failures));
+      map[flutter::EncodableValue("maxDepth")] = flutter::EncodableValue(static_cast<int64_t>(stats.max_depth));
+      map[flutter::EncodableValue("latencyAvgMs")] = flutter::EncodableValue(
+          stats.delivered ? static_cast<double>(stats.latency_total_us) / 1000.0 / static_cast<double>(stats.delivered)
+                          : 0.0);
+      map[flutter::EncodableValue("latencyMaxMs")] =
+          flutter::EncodableValue(static_cast<double>(stats.latency_max_us) / 1000.0);
+      map[flutter::EncodableValue("handlerMaxMs")] =
+          flutter::EncodableValue(static_cast<double>(stats.handler_max_us) / 1000.0);
+      events[flutter::EncodableValue(bus.first)] = flutter::EncodableValue(map);
+    }
+    return EncodeStatusSection(events);
+  });
+}
+
+flutter::EncodableMap VpnPlugin::CreateStatusSnapshotMap() {
+  StatusSnapshot::Stats stats = status_snapshot_.GetStats();
+  flutter::EncodableMap snapshot;
+  snapshot[flutter::EncodableValue("passes")] = flutter::EncodableValue(static_cast<int64_t>(stats.passes));
+  snapshot[flutter::EncodableValue("fullPasses")] = flutter::EncodableValue(static_cast<int64_t>(stats.full_passes));
+  snapshot[flutter::EncodableValue("encodes")] = flutter::EncodableValue(static_cast<int64_t>(stats.encodes));
+  snapshot[flutter::EncodableValue("reused")] =
+      flutter::EncodableValue(static_cast<int64_t>(stats.refreshes - stats.encodes));
+  snapshot[flutter::EncodableValue("sectionsSent")] = flutter::EncodableValue(static_cast<int64_t>(stats.sections_sent));
+  snapshot[flutter::EncodableValue("sectionsSkipped")] = flutter::EncodableValue(static_cast<int64_t>(stats.sections_skipped));
+  snapshot[flutter::EncodableValue("bytesEncoded")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes_encoded));
+  snapshot[flutter::EncodableValue("bytesSent")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes_sent));
+  snapshot[flutter::EncodableValue("bytesSkipped")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes_skipped));
+  snapshot[flutter::EncodableValue("lastPassBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.last_pass_bytes));
+  snapshot[flutter::EncodableValue("lastPassUs")] = flutter::EncodableValue(static_cast<int64_t>(stats.last_pass_us));
+  snapshot[flutter::EncodableValue("maxPassUs")] = flutter::EncodableValue(static_cast<int64_t>(stats.pass_max_us));
+  snapshot[flutter::EncodableValue("avgPassUs")] = flutter::EncodableValue(
+      stats.passes ? static_cast<double>(stats.pass_total_us) / static_cast<double>(stats.passes) : 0.0);
+  snapshot[flutter::EncodableValue("encodeTotalUs")] = flutter::EncodableValue(static_cast<int64_t>(stats.encode_total_us));
+  return snapshot;
+}
+
+void VpnPlugin::GetDetailedStatus(const flutter::EncodableValue* arguments,
+                                  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  std::lock_guard<std::mutex> lock(status_mutex_);
+  
+  try {
+    // With {"versions": {section: version}} only the sections that changed
+    // since are sent, as standard-codec bytes; without, everything decoded
+    StatusSnapshot::Versions known;
+    bool incremental = false;
+    const auto* options = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    if (options) {
+      auto it = options->find(flutter::EncodableValue("versions"));
+      if (it != options->end()) {
+        if (const auto* versions = std::get_if<flutter::EncodableMap>(&it->second)) {
+          incremental = true;
+          for (const auto& pair : *versions) {
+            const auto* name = std::get_if<std::string>(&pair.first);
+            if (!name) {
+              continue;
+            }
+            if (const auto* version = std::get_if<int32_t>(&pair.second)) {
+              known[*name] = static_cast<uint64_t>(*version);
+            } else if (const auto* version64 = std::get_if<int64_t>(&pair.second)) {
+              known[*name] = static_cast<uint64_t>(*version64);
+            }
+          }
+        }
       }
-      
-      detailed_status[flutter::EncodableValue("statsDetails")] = flutter::EncodableValue(stats_details);
     }
+
+    status_snapshot_.BeginPass();
+    flutter::EncodableMap detailed_status = CreateStatusMap();
+    RefreshStatusSections();
+    auto changed = status_snapshot_.EndPass(incremental ? &known : nullptr);
+
+    if (incremental) {
+      flutter::EncodableMap sections;
+      for (const auto& entry : changed) {
+        sections[flutter::EncodableValue(entry.first)] = flutter::EncodableValue(*entry.second.encoded);
+      }
+      flutter::EncodableMap versions;
+      for (const auto& pair : status_snapshot_.GetVersions()) {
+        versions[flutter::EncodableValue(pair.first)] = flutter::EncodableValue(static_cast<int64_t>(pair.second));
+      }
+      detailed_status[flutter::EncodableValue("sections")] = flutter::EncodableValue(sections);
+      detailed_status[flutter::EncodableValue("sectionVersions")] = flutter::EncodableValue(versions);
+    } else {
+      for (const auto& entry : changed) {
+        auto section = flutter::StandardMessageCodec::GetInstance().DecodeMessage(*entry.second.encoded);
+        if (section) {
+          detailed_status[flutter::EncodableValue(entry.first)] = std::move(*section);
+        }
+      }
+    }
+    detailed_status[flutter::EncodableValue("snapshot")] = flutter::EncodableValue(CreateStatusSnapshotMap());
     
     result->Success(flutter::EncodableValue(detailed_status));
   } catch (const std::exception& e) {
@@ -1186,13 +1652,11 @@ void VpnPlugin::UpdateConnectionStatus() {
   // Update connection state based on sing-box status
   if (is_connected_ && !singbox_running) {
     // Sing-box stopped unexpectedly
-    is_connected_ = false;
-    is_connecting_ = false;
+    SetConnectionState(false, false);
     last_error_ = "Sing-box process stopped unexpectedly";
   } else if (is_connecting_ && singbox_running) {
     // Connection established successfully
-    is_connected_ = true;
-    is_connecting_ = false;
+    SetConnectionState(true, false);
     last_error_.clear();
   }
   
@@ -1202,39 +1666,44 @@ void VpnPlugin::UpdateConnectionStatus() {
   }
 }
 
+void VpnPlugin::SetConnectionState(bool connected, bool connecting) {
+  is_connected_ = connected;
+  is_connecting_ = connecting;
+  monitor_gate_.SetActive(connected || connecting);
+}
+
 void VpnPlugin::MonitorConnection() {
   auto last_status_update = std::chrono::steady_clock::now();
-  auto last_stats_update = std::chrono::steady_clock::now();
   
-  while (monitoring_active_) {
+  // Parked while disconnected: a connection starting wakes it, and a
+  // disconnect parks it again before the next round
+  while (monitor_gate_.Wait(std::chrono::milliseconds(1000))) {
     auto now = std::chrono::steady_clock::now();
     
-    if (is_connected_ || is_connecting_) {
-      // Update network statistics more frequently when connected
-      if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_stats_update).count() >= 1000) {
-        UpdateNetworkStats();
-        last_stats_update = now;
-        
-        // Send real-time statistics to Flutter if streaming is active
-        if (stats_streaming_active_ && channel_) {
-          flutter::EncodableMap current_stats = GetCurrentNetworkStats();
-          channel_->InvokeMethod("onStatsUpdate", 
-                                std::make_unique<flutter::EncodableValue>(current_stats));
-        }
+    UpdateNetworkStats();
+    
+    // Send real-time statistics to Flutter if streaming is active; the
+    // event channel listener gets them only as fast as it acknowledges
+    if ((stats_streaming_active_ || stats_listener_active_) && dispatcher_) {
+      flutter::EncodableMap current_stats = GetCurrentNetworkStats();
+      if (stats_listener_active_) {
+        dispatcher_->PostLatest(kStatsSampleRoute, flutter::EncodableValue(current_stats));
+      }
+      if (stats_streaming_active_) {
+        dispatcher_->PostLatest("onStatsUpdate", flutter::EncodableValue(current_stats));
       }
+    }
+    
+    // Update connection status less frequently
+    if (std::chrono::duration_cast<std::chrono::seconds>(now - last_status_update).count() >= 5) {
+      UpdateConnectionStatus();
+      last_status_update = now;
       
-      // Update connection status less frequently
-      if (std::chrono::duration_cast<std::chrono::seconds>(now - last_status_update).count() >= 5) {
-        UpdateConnectionStatus();
-        last_status_update = now;
-        
-        // Send status updates to Flutter
-        if (channel_) {
-          std::lock_guard<std::mutex> lock(status_mutex_);
-          flutter::EncodableMap status_map = CreateStatusMap();
-          channel_->InvokeMethod("onStatusUpdate", 
-                                std::make_unique<flutter::EncodableValue>(status_map));
-        }
+      // Send status updates to Flutter
+      if (dispatcher_) {
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        flutter::EncodableMap status_map = CreateStatusMap();
+        dispatcher_->PostLatest("onStatusUpdate", flutter::EncodableValue(status_map));
       }
     }
     
@@ -1245,8 +1714,6 @@ void VpnPlugin::MonitorConnection() {
         HandleSingboxError(SingboxError::ProcessCrashed, "Sing-box process stopped unexpectedly");
       }
     }
-    
-    std::this_thread::sleep_for(std::chrono::milliseconds(500)); // More frequent monitoring
   }
 }
 
@@ -1254,8 +1721,18 @@ void VpnPlugin::MonitorConnection() {
 bool VpnPlugin::InitializeSingbox() {
   if (singbox_manager_) {
     // Set up process monitor callback for error handling
-    singbox_manager_->SetProcessMonitorCallback([this](SingboxError error, const std::string& message) {
-      HandleSingboxError(error, message);
+    // Both run on the manager's event bus, after it let go of its locks
+    singbox_manager_->SetProcessMonitorCallback([this](SingboxError error, const std::string& message,
+                                                       const ErrorClassification& classification,
+                                                       bool from_output) {
+      HandleSingboxError(error, message, classification, from_output);
+    });
+    // Starts and stops reach Dart now rather than with the monitor's next status round
+    singbox_manager_->SubscribeEvents([this](const SingboxEvent& event) {
+      if (event.kind != SingboxEvent::Kind::Error && dispatcher_) {
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        dispatcher_->PostLatest("onStatusUpdate", flutter::EncodableValue(CreateStatusMap()));
+      }
     });
     
     bool initialized = singbox_manager_->Initialize();
@@ -1327,24 +1804,28 @@ bool VpnPlugin::StopSingboxCore() {
   return stopped;
 }
 
-void VpnPlugin::HandleSingboxError(SingboxError error, const std::string& message) {
+void VpnPlugin::HandleSingboxError(SingboxError error, const std::string& message,
+                                   const ErrorClassification& classification, bool from_output) {
   // Handle sing-box process errors and update connection state
   std::lock_guard<std::mutex> lock(status_mutex_);
   
-  // Update connection state based on error severity
-  switch (error) {
-    case SingboxError::ProcessCrashed:
-    case SingboxError::ProcessStartFailed:
-    case SingboxError::PermissionDenied:
-      is_connected_ = false;
-      is_connecting_ = false;
-      break;
-    case SingboxError::NetworkError:
-    case SingboxError::ResourceExhausted:
-      // These might be temporary, don't change connection state immediately
-      break;
-    default:
-      break;
+  // Update connection state based on error severity. A line of sing-box
+  // output never does: the tunnel may well still be up, and the monitor
+  // notices when the process itself goes away
+  if (!from_output) {
+    switch (error) {
+      case SingboxError::ProcessCrashed:
+      case SingboxError::ProcessStartFailed:
+      case SingboxError::PermissionDenied:
+        SetConnectionState(false, false);
+        break;
+      case SingboxError::NetworkError:
+      case SingboxError::ResourceExhausted:
+        // These might be temporary, don't change connection state immediately
+        break;
+      default:
+        break;
+    }
   }
   
   // Set detailed error message
@@ -1354,7 +1835,7 @@ void VpnPlugin::HandleSingboxError(SingboxError error, const std::string& messag
   }
   
   // Notify Flutter about the error with enhanced information
-  if (channel_) {
+  if (dispatcher_) {
     flutter::EncodableMap error_map;
     error_map[flutter::EncodableValue("error")] = flutter::EncodableValue(last_error_);
     error_map[flutter::EncodableValue("errorCode")] = flutter::EncodableValue(static_cast<int>(error));
@@ -1364,22 +1845,37 @@ void VpnPlugin::HandleSingboxError(SingboxError error, const std::string& messag
     error_map[flutter::EncodableValue("timestamp")] = flutter::EncodableValue(
         std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count());
-    error_map[flutter::EncodableValue("severity")] = flutter::EncodableValue(GetErrorSeverity(error));
-    error_map[flutter::EncodableValue("isRecoverable")] = flutter::EncodableValue(IsErrorRecoverable(error));
+    
+    // Prefer the categorizer's verdict for the native message; it lets the Dart side
+    // map the error by code instead of re-scanning the text
+    if (classification.IsMatched()) {
+      error_map[flutter::EncodableValue("category")] = flutter::EncodableValue(
+          ErrorCategorizer::CategoryName(classification.category));
+      error_map[flutter::EncodableValue("nativeCode")] = flutter::EncodableValue(
+          ErrorCategorizer::CategoryCode(classification.category));
+      error_map[flutter::EncodableValue("severity")] = flutter::EncodableValue(
+          ErrorCategorizer::SeverityName(classification.severity));
+      error_map[flutter::EncodableValue("isRecoverable")] = flutter::EncodableValue(classification.recoverable);
+      error_map[flutter::EncodableValue("matchedSignature")] = flutter::EncodableValue(
+          ErrorCategorizer::Default().Pattern(classification.signature));
+    } else {
+      error_map[flutter::EncodableValue("category")] = flutter::EncodableValue("unknown");
+      error_map[flutter::EncodableValue("nativeCode")] = flutter::EncodableValue(GetNativeErrorCode(error));
+      error_map[flutter::EncodableValue("severity")] = flutter::EncodableValue(GetErrorSeverity(error));
+      error_map[flutter::EncodableValue("isRecoverable")] = flutter::EncodableValue(IsErrorRecoverable(error));
+    }
     
     // Add connection state information
     error_map[flutter::EncodableValue("connectionState")] = flutter::EncodableValue(
         is_connected_ ? "connected" : (is_connecting_ ? "connecting" : "disconnected"));
     
-    channel_->InvokeMethod("onError", 
-                          std::make_unique<flutter::EncodableValue>(error_map));
+    dispatcher_->PostEvery("onError", flutter::EncodableValue(error_map));
   }
   
   // Also send real-time status update
-  if (channel_) {
+  if (dispatcher_) {
     flutter::EncodableMap status_update = CreateStatusMap();
-    channel_->InvokeMethod("onStatusUpdate", 
-                          std::make_unique<flutter::EncodableValue>(status_update));
+    dispatcher_->PostLatest("onStatusUpdate", flutter::EncodableValue(status_update));
   }
 }
 
@@ -1782,6 +2278,29 @@ std::string VpnPlugin::GetErrorSeverity(SingboxError error) {
   }
 }
 
+// Native error codes understood by SingboxErrorFactory.fromNativeError
+std::string VpnPlugin::GetNativeErrorCode(SingboxError error) {
+  switch (error) {
+    case SingboxError::InitializationFailed:
+    case SingboxError::ProcessStartFailed:
+      return "INIT_FAILED";
+    case SingboxError::ConfigurationInvalid:
+      return "CONFIG_INVALID";
+    case SingboxError::ProcessCrashed:
+      return "PROCESS_CRASHED";
+    case SingboxError::NetworkError:
+      return "CONNECTION_FAILED";
+    case SingboxError::PermissionDenied:
+      return "PERMISSION_DENIED";
+    case SingboxError::ResourceExhausted:
+      return "RESOURCE_EXHAUSTED";
+    case SingboxError::None:
+    case SingboxError::UnknownError:
+    default:
+      return "UNKNOWN";
+  }
+}
+
 bool VpnPlugin::IsErrorRecoverable(SingboxError error) {
   switch (error) {
     case SingboxError::None: